@@ -1997,26 +1997,34 @@ dcc_get_ack (uint_fast16_t addr)
     send_packet (0xFFFF, addr, buf, 1);
 }
 
+#define DCC_SWITCH_PULSE_DEFAULT    200                 // msec a switch is active, if no pulse given
+#define DCC_MAX_ACTIVE_SWITCHES     16                  // switches active at the same time, see SWITCH_POWER of FM22
+
 typedef struct
 {
-    uint32_t    millis;
+    uint32_t    millis;                                 // time of reset, 0: slot unused
     uint16_t    addr;
     uint8_t     nswitch;
 } DCC_SWITCH_RESET;
 
-static DCC_SWITCH_RESET     dcc_switch_reset;
+static DCC_SWITCH_RESET     dcc_switch_resets[DCC_MAX_ACTIVE_SWITCHES];
 
 /*------------------------------------------------------------------------------------------------------------------------
- * dcc_reset_last_active_switch () - reset last active switch
+ * dcc_reset_active_switches () - reset active switches whose pulse has elapsed
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-dcc_reset_last_active_switch (void)
+dcc_reset_active_switches (void)
 {
-    if (dcc_switch_reset.millis != 0 && millis >= dcc_switch_reset.millis)
+    uint_fast8_t    idx;
+
+    for (idx = 0; idx < DCC_MAX_ACTIVE_SWITCHES; idx++)
     {
-        dcc_base_switch_reset (dcc_switch_reset.addr, dcc_switch_reset.nswitch);
-        dcc_switch_reset.millis = 0;
+        if (dcc_switch_resets[idx].millis != 0 && millis >= dcc_switch_resets[idx].millis)
+        {
+            dcc_base_switch_reset (dcc_switch_resets[idx].addr, dcc_switch_resets[idx].nswitch);
+            dcc_switch_resets[idx].millis = 0;
+        }
     }
 }
 
@@ -2034,13 +2042,19 @@ dcc_reset_last_active_switch (void)
  *        A7  A6  -  A5   A4  A3  A2        /A10 /A9  /A8  -    A1  A0   
  *
  * here: D = 1
+ *
+ * The switch is reset after pulse msec, 0: DCC_SWITCH_PULSE_DEFAULT. Up to DCC_MAX_ACTIVE_SWITCHES switches may be
+ * active at the same time. If a switch with the same address is still active, it is reset first. If all slots are
+ * in use, the switch which would be reset next is reset now.
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-dcc_base_switch_set (uint_fast16_t addr, uint_fast8_t nswitch)
+dcc_base_switch_set (uint_fast16_t addr, uint_fast8_t nswitch, uint_fast16_t pulse)
 {
     uint_fast16_t swaddr;
     uint_fast16_t swstate;
+    uint_fast8_t  idx;
+    uint_fast8_t  slot = 0xFF;
 
     if (nswitch == DCC_SWITCH_STATE_BRANCH2)    // BRANCH-2 for 3way switch
     {                                           // use following address
@@ -2053,10 +2067,39 @@ dcc_base_switch_set (uint_fast16_t addr, uint_fast8_t nswitch)
         swstate = nswitch;
     }
 
-    if (dcc_switch_reset.millis)                // should never be, but be sure...
+    for (idx = 0; idx < DCC_MAX_ACTIVE_SWITCHES; idx++)
+    {
+        if (dcc_switch_resets[idx].millis != 0 && dcc_switch_resets[idx].addr == addr)
+        {                                       // same switch still active, reset it first
+            dcc_base_switch_reset (dcc_switch_resets[idx].addr, dcc_switch_resets[idx].nswitch);
+            dcc_switch_resets[idx].millis = 0;
+        }
+
+        if (dcc_switch_resets[idx].millis == 0 && slot == 0xFF)
+        {
+            slot = idx;
+        }
+    }
+
+    if (slot == 0xFF)                           // all slots in use: reset switch which is due next
+    {
+        slot = 0;
+
+        for (idx = 1; idx < DCC_MAX_ACTIVE_SWITCHES; idx++)
+        {
+            if (dcc_switch_resets[idx].millis < dcc_switch_resets[slot].millis)
+            {
+                slot = idx;
+            }
+        }
+
+        dcc_base_switch_reset (dcc_switch_resets[slot].addr, dcc_switch_resets[slot].nswitch);
+        dcc_switch_resets[slot].millis = 0;
+    }
+
+    if (pulse == 0)
     {
-        dcc_base_switch_reset (dcc_switch_reset.addr, dcc_switch_reset.nswitch);
-        dcc_switch_reset.millis = 0;
+        pulse = DCC_SWITCH_PULSE_DEFAULT;
     }
 
     while (dcc_buflen != 0)
@@ -2071,9 +2114,9 @@ dcc_base_switch_set (uint_fast16_t addr, uint_fast8_t nswitch)
     dcc_buflen      = 0x80 | 0x03;                                                                          // at least set dcc_buflen
     listener_set_stop ();
 
-    dcc_switch_reset.millis     = millis + 200;
-    dcc_switch_reset.addr       = addr;
-    dcc_switch_reset.nswitch    = nswitch;
+    dcc_switch_resets[slot].millis  = millis + pulse;
+    dcc_switch_resets[slot].addr    = addr;
+    dcc_switch_resets[slot].nswitch = nswitch;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -78,8 +78,8 @@ extern uint_fast8_t     dcc_xpom_read_cv (uint8_t * valuep, uint_fast8_t n, uint
 extern void             dcc_xpom_write_cv (uint_fast16_t addr, uint_fast8_t cv31, uint_fast8_t cv32, uint_fast8_t cv, uint8_t * ptr, uint_fast8_t len);
 extern void             dcc_track_search (void);
 extern void             dcc_get_ack (uint_fast16_t addr);
-extern void             dcc_reset_last_active_switch (void);
-extern void             dcc_base_switch_set (uint_fast16_t addr, uint_fast8_t nswitch);
+extern void             dcc_reset_active_switches (void);
+extern void             dcc_base_switch_set (uint_fast16_t addr, uint_fast8_t nswitch, uint_fast16_t pulse);
 extern void             dcc_base_switch_reset (uint_fast16_t addr, uint_fast8_t nswitch);
 extern void             dcc_ext_accessory_set (uint_fast16_t addr, uint_fast8_t value);
 extern void             dcc_booster_on (void);
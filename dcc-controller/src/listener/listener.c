@@ -352,20 +352,28 @@ listener_send_msg_pgm_cv (uint_fast16_t cv, uint_fast8_t cv_value)
 }
 
 /*-------------------------------------------------------------------------------------------------------------------------------------------
- * send_msg_rc2 () - send ADC message
+ * listener_send_msg_rc2_rate () - send RC2 rate, latency of last RC2 answer and max. gap between commands of loco
+ *
+ * latency and gap are 0xFFFF if unknown. The gap is reset after sending, so it is the max. gap since the last message.
  *-------------------------------------------------------------------------------------------------------------------------------------------
  */
 void
 listener_send_msg_rc2_rate (uint_fast16_t loco_idx, uint_fast8_t rc2_rate)
 {
-    uint8_t         buf[4];
+    uint8_t         buf[8];
+    uint32_t        latency = rc_detector_get_rc2_millis_diff (loco_idx);  // RC_DETECTOR_MILLIS_UNKNOWN (0xFFFF) if unknown
+    uint_fast16_t   gap     = rc_detector_get_max_gap (loco_idx);
 
     buf[0] = MSG_LOCO_RC2_RATE;
     buf[1] = loco_idx >> 8;
     buf[2] = loco_idx & 0xFF;
     buf[3] = rc2_rate;
+    buf[4] = latency >> 8;
+    buf[5] = latency & 0xFF;
+    buf[6] = gap >> 8;
+    buf[7] = gap & 0xFF;
 
-    send_msg (buf, 4);
+    send_msg (buf, 8);
 }
 
 /*-------------------------------------------------------------------------------------------------------------------------------------------
@@ -980,7 +988,14 @@ cmd_base_switch_set (uint8_t * bufp, uint_fast8_t len)
     {
         uint_fast16_t   addr    = GET16(bufp, 1);
         uint_fast8_t    nswitch = GET8(bufp, 3);
-        dcc_base_switch_set (addr, nswitch);
+        dcc_base_switch_set (addr, nswitch, 0);
+    }
+    else if (len == 6)
+    {
+        uint_fast16_t   addr    = GET16(bufp, 1);
+        uint_fast8_t    nswitch = GET8(bufp, 3);
+        uint_fast16_t   pulse   = GET16(bufp, 4);
+        dcc_base_switch_set (addr, nswitch, pulse);
     }
 }
 
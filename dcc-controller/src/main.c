@@ -162,7 +162,7 @@ main ()
     while (1)
     {
         current_millis = millis;
-        dcc_reset_last_active_switch ();
+        dcc_reset_active_switches ();
         listener_send_continue ();
 
         rcl_msg = listener_read_rcl ();
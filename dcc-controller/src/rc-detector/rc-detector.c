@@ -150,6 +150,7 @@ typedef struct
     volatile uint8_t            cmd_cnt[2];                             // counters, how many commands have been sent
     volatile uint8_t            rc2_cnt[2];                             // counters, how many RC2 anwers arrived
     volatile uint8_t            active_slotidx;
+    volatile uint16_t           max_gap;                                // max. msec between two commands, see rc_detector_get_max_gap()
 } RC2INFO;
 
 static RC2INFO                  rc2info[MAX_RC2_INFOS];
@@ -203,6 +204,21 @@ inc_cmd_counter (uint_fast16_t idx)
             rc_detector_n_rc2infos = idx + 1;
         }
 
+        if (rc2info[idx].cmd_millis)
+        {
+            uint32_t    gap = millis - rc2info[idx].cmd_millis;
+
+            if (gap > 0xFFFE)
+            {
+                gap = 0xFFFE;
+            }
+
+            if (rc2info[idx].max_gap < gap)
+            {
+                rc2info[idx].max_gap = gap;
+            }
+        }
+
         rc2info[idx].cmd_millis = millis;                       // yes, update timestamp
 
         active_slotidx = rc2info[idx].active_slotidx;
@@ -242,20 +258,25 @@ rc_detector_get_rc2_millis (uint_fast16_t idx)
     return rtc;
 }
 
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * rc_detector_get_rc2_millis_diff () - get msec between last command and its RC2 answer
+ *
+ * Returns RC_DETECTOR_MILLIS_UNKNOWN if idx has no RC2 info, the last command has not been answered yet or the answer
+ * took longer than 0xFFFE msec. 0 is a valid answer time and must not be used for "unknown".
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
 uint32_t
 rc_detector_get_rc2_millis_diff (uint_fast16_t idx)
 {
-    uint32_t    rtc = 0;
+    uint32_t    rtc = RC_DETECTOR_MILLIS_UNKNOWN;
 
-    if (idx < rc_detector_n_rc2infos)
+    if (idx < rc_detector_n_rc2infos && rc2info[idx].rc2_millis)
     {
-        if (rc2info[idx].rc2_millis)
-        {
-            rtc = rc2info[idx].rc2_millis - rc2info[idx].cmd_millis;
-        }
-        else
+        rtc = rc2info[idx].rc2_millis - rc2info[idx].cmd_millis;
+
+        if (rtc > RC_DETECTOR_MILLIS_UNKNOWN)
         {
-            rtc = 999999;
+            rtc = RC_DETECTOR_MILLIS_UNKNOWN;
         }
     }
 
@@ -292,6 +313,24 @@ rc_detector_get_rc2_rate (uint_fast16_t loco_idx)
     return rtc;
 }
 
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * rc_detector_get_max_gap () - get max. msec between two commands to loco since last call, 0xFFFF if unknown
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+rc_detector_get_max_gap (uint_fast16_t idx)
+{
+    uint_fast16_t   rtc = 0xFFFF;
+
+    if (idx < rc_detector_n_rc2infos)
+    {
+        rtc = rc2info[idx].max_gap;
+        rc2info[idx].max_gap = 0;
+    }
+
+    return rtc;
+}
+
 void
 rc_detector_reset_rc2_millis (void)
 {
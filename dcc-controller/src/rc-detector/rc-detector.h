@@ -27,6 +27,7 @@
 
 #define RC_DETECTOR_ADDRESS_INVALID 0xFFFF
 #define RC_DETECTOR_DYN_INVALID     0xFF
+#define RC_DETECTOR_MILLIS_UNKNOWN  0xFFFF                                  // see rc_detector_get_rc2_millis_diff()
 
 #define MAX_XPOM_SEQUENCES          4
 #define MAX_XPOM_CV_VALUES          4
@@ -51,6 +52,7 @@ extern uint32_t                     rc_detector_get_rc2_millis (uint_fast16_t id
 extern uint32_t                     rc_detector_get_rc2_millis_diff (uint_fast16_t idx);
 extern void                         rc_detector_reset_rc2_millis (void);
 extern uint_fast8_t                 rc_detector_get_rc2_rate (uint_fast16_t idx);
+extern uint_fast16_t                rc_detector_get_max_gap (uint_fast16_t idx);
 
 extern void                         rc_detector_reset_rc2_data (void);
 extern void                         rc_detector_reset_rc_data (void);
@@ -32,12 +32,14 @@
 #include "addon.h"
 #include "rcl.h"
 #include "s88.h"
+#include "automation.h"
 
 #define MAX_PACKET_SEQUENCES    10
 
 std::vector<AddOn>      AddOns::addons;                                         // addons
 bool                    AddOns::data_changed = false;                           // flag
 uint_fast16_t           AddOns::n_addons = 0;                                   // number of addons
+DisplayOrder            AddOns::order;                                          // display order, private
 
 /*------------------------------------------------------------------------------------------------------------------------
  * sendfunction() - send function
@@ -50,7 +52,7 @@ AddOn::sendfunction (uint_fast8_t range)
     uint32_t    functions       = this->functions;
 
     DCC::loco_function (0xFFFF, addr, functions, range);
-    Debug::printf (DEBUG_LEVEL_VERBOSE, "AddOn::sendfunction: addon_idx=%d range %d\n", this->id, range);
+    DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "AddOn::sendfunction: addon_idx=%d range %d\n", this->id, range);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -79,7 +81,7 @@ AddOn::sendcmd (uint_fast8_t packet_no)
             case 1:
             {
                 AddOn::sendfunction (DCC_F00_F04_RANGE);
-                Debug::printf (DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F00_F04_RANGE)\n", this->id);
+                DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F00_F04_RANGE)\n", this->id);
                 break;
             }
             case 3:
@@ -87,7 +89,7 @@ AddOn::sendcmd (uint_fast8_t packet_no)
                 if (this->addonfunction.max >= 5)
                 {
                     AddOn::sendfunction (DCC_F05_F08_RANGE);
-                    Debug::printf (DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F05_F08_RANGE)\n", this->id);
+                    DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F05_F08_RANGE)\n", this->id);
                 }
                 break;
             }
@@ -96,7 +98,7 @@ AddOn::sendcmd (uint_fast8_t packet_no)
                 if (this->addonfunction.max >= 9)
                 {
                     AddOn::sendfunction (DCC_F09_F12_RANGE);
-                    Debug::printf (DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F09_F12_RANGE)\n", this->id);
+                    DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F09_F12_RANGE)\n", this->id);
                 }
                 break;
             }
@@ -105,7 +107,7 @@ AddOn::sendcmd (uint_fast8_t packet_no)
                 if (this->addonfunction.max >= 13)
                 {
                     AddOn::sendfunction (DCC_F13_F20_RANGE);
-                    Debug::printf (DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F13_F20_RANGE)\n", this->id);
+                    DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F13_F20_RANGE)\n", this->id);
                 }
                 break;
             }
@@ -114,7 +116,7 @@ AddOn::sendcmd (uint_fast8_t packet_no)
                 if (this->addonfunction.max >= 21)
                 {
                     AddOn::sendfunction (DCC_F21_F28_RANGE);
-                    Debug::printf (DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F21_F28_RANGE)\n", this->id);
+                    DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F21_F28_RANGE)\n", this->id);
                 }
                 break;
             }
@@ -131,7 +133,7 @@ AddOn::sendcmd (uint_fast8_t packet_no)
             uint_fast8_t    speed   = Locos::locos[loco_idx].get_speed ();      // use speed and dir of loco!
 
             DCC::loco (0xFFFF, addr, fwd, speed, 0, 0);
-            Debug::printf (DEBUG_LEVEL_VERBOSE, "AddOn::sendcmd: addon_idx=%d loco_idx=%d addr=%d, fwd=%d, speed=%d\n", this->id, loco_idx, addr, fwd, speed);
+            DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "AddOn::sendcmd: addon_idx=%d loco_idx=%d addr=%d, fwd=%d, speed=%d\n", this->id, (uint16_t) loco_idx, (uint16_t) addr, fwd, speed);
         }
     }
 }
@@ -532,6 +534,16 @@ AddOn::get_functions ()
     return this->functions;
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ *  restore_state () - restore functions without sending, see Journal::init ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+AddOn::restore_state (uint32_t functions)
+{
+    this->functions = functions;
+}
+
 void
 AddOn::sched ()
 {
@@ -562,7 +574,9 @@ AddOns::add (const AddOn& addon)
     {
         addons.push_back(addon);
         AddOns::addons[n_addons].set_id(n_addons);
+        AddOns::order.add ();
         AddOns::n_addons++;
+        Automation::invalidate ();
         return addons.size() - 1;
     }
     return 0xFFFF;
@@ -579,96 +593,68 @@ AddOns::get_n_addons (void)
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  set_new_id () - set new id
+ *  clear () - remove all addons, see FileIO::reload_ini_files ()
  *------------------------------------------------------------------------------------------------------------------------
  */
-uint_fast16_t
-AddOns::set_new_id (uint_fast16_t addon_idx, uint_fast16_t new_addon_idx)
+void
+AddOns::clear (void)
 {
-    uint_fast16_t   rtc = 0xFFFF;
-
-    if (addon_idx < AddOns::n_addons && new_addon_idx < AddOns::n_addons)
-    {
-        if (addon_idx != new_addon_idx)
-        {
-            AddOn           tmpaddon;
-            uint_fast16_t   lidx;
-
-            uint16_t *      map_new_addon_idx = (uint16_t *) calloc (AddOns::n_addons, sizeof (uint16_t));
-
-            for (lidx = 0; lidx < AddOns::n_addons; lidx++)
-            {
-                map_new_addon_idx[lidx] = lidx;
-            }
-
-            tmpaddon = AddOns::addons[addon_idx];
-
-            if (new_addon_idx < addon_idx)
-            {
-                // step 1: shift addon
-                for (lidx = addon_idx; lidx > new_addon_idx; lidx--)
-                {
-                    AddOns::addons[lidx] = AddOns::addons[lidx - 1];
-                    map_new_addon_idx[lidx - 1] = lidx;
-                }
-            }
-            else // if (new_addon_idx > addon_idx)
-            {
-                // step 1: shift addon
-                for (lidx = addon_idx; lidx < new_addon_idx; lidx++)
-                {
-                    AddOns::addons[lidx] = AddOns::addons[lidx + 1];
-                    map_new_addon_idx[lidx + 1] = lidx;
-                }
-            }
-
-            AddOns::addons[lidx] = tmpaddon;
-            map_new_addon_idx[addon_idx] = lidx;
+    AddOns::addons.clear ();
+    AddOns::order.clear ();
+    AddOns::n_addons = 0;
+    Automation::invalidate ();
+}
 
-            for (lidx = 0; lidx < AddOns::n_addons; lidx++)
-            {
-                Debug::printf (DEBUG_LEVEL_VERBOSE, "%2d -> %2d\n", lidx, map_new_addon_idx[lidx]);
-            }
+/*------------------------------------------------------------------------------------------------------------------------
+ *  get_position () - get position of addon in display order
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+AddOns::get_position (uint_fast16_t addon_idx)
+{
+    return AddOns::order.get_position (addon_idx);
+}
 
-            // step 2: correct loco_idx in LOCO, RAILROAD, RCL, S88
-            Locos::set_new_addon_ids (map_new_addon_idx, AddOns::n_addons);
-            // Railroad::set_new_addon_ids (map_new_addon_idx, AddOns::n_addons);    // not necessary
-            RCL::set_new_addon_ids (map_new_addon_idx, AddOns::n_addons);
-            S88::set_new_addon_ids (map_new_addon_idx, AddOns::n_addons);
+/*------------------------------------------------------------------------------------------------------------------------
+ *  get_addon_idx () - get addon at position in display order
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+AddOns::get_addon_idx (uint_fast16_t position)
+{
+    return AddOns::order.get_idx (position);
+}
 
-            free (map_new_addon_idx);
-            AddOns::data_changed = true;
-            rtc = new_addon_idx;
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_position () - move addon to new position in display order. The addon keeps its index, so no references in
+ *  locos, contacts, tracks and events have to be corrected.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+AddOns::set_position (uint_fast16_t addon_idx, uint_fast16_t new_position)
+{
+    if (AddOns::order.get_position (addon_idx) == new_position)
+    {
+        return addon_idx;
+    }
 
-            AddOns::renumber ();
-        }
-        else
-        {
-            rtc = addon_idx;
-        }
+    if (AddOns::order.set_position (addon_idx, new_position))
+    {
+        AddOns::data_changed = true;
+        return addon_idx;
     }
 
-    return rtc;
+    return 0xFFFF;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  AddOns::set_new_loco_ids ()
+ *  set_order () - set display order after reading ini file, positions[addon_idx] may contain gaps or duplicates
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-AddOns::set_new_loco_ids (uint16_t * map_new_loco_idx, uint16_t n_locos)
+AddOns::set_order (std::vector<uint16_t>& new_positions)
 {
-    uint_fast16_t     addon_idx;
-
-    for (addon_idx = 0; addon_idx < AddOns::n_addons; addon_idx++)
-    {
-        uint_fast16_t   loco_idx = AddOns::addons[addon_idx].get_loco(); 
-
-        if (loco_idx < n_locos)
-        {
-            AddOns::addons[addon_idx].set_loco(map_new_loco_idx[loco_idx]);
-        }
-    }
+    AddOns::order.set_order (new_positions);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -719,17 +705,3 @@ AddOns::schedule (void)
     return rtc;
 }
 
-/*------------------------------------------------------------------------------------------------------------------------
- *  renumber () - renumber ids
- *------------------------------------------------------------------------------------------------------------------------
- */
-void
-AddOns::renumber ()
-{
-    uint_fast16_t addon_idx;
-
-    for (addon_idx = 0; addon_idx < AddOns::n_addons; addon_idx++)
-    {
-        AddOns::addons[addon_idx].set_id (addon_idx);
-    }
-}
@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include "order.h"
 
 #define MAX_ADDONS      1024
 
@@ -70,6 +71,7 @@ class AddOn
         uint_fast8_t                    get_function (uint_fast8_t f);
         void                            reset_functions ();
         uint32_t                        get_functions ();
+        void                            restore_state (uint32_t functions);
 
     private:
         uint16_t                        id;
@@ -94,12 +96,15 @@ class AddOns
         static bool                     data_changed;
         static uint_fast16_t            add (const AddOn& addon);
         static uint_fast16_t            get_n_addons (void);
-        static uint_fast16_t            set_new_id (uint_fast16_t addon_idx, uint_fast16_t new_addon_idx);
-        static void                     set_new_loco_ids (uint16_t * map_new_loco_idx, uint16_t n_locos);
+        static void                     clear (void);
+        static uint_fast16_t            get_position (uint_fast16_t addon_idx);
+        static uint_fast16_t            get_addon_idx (uint_fast16_t position);
+        static uint_fast16_t            set_position (uint_fast16_t addon_idx, uint_fast16_t new_position);
+        static void                     set_order (std::vector<uint16_t>& new_positions);
         static bool                     schedule (void);
     private:
         static uint_fast16_t            n_addons;                                   // number of addons
-        static void                     renumber();
+        static DisplayOrder             order;                                      // display order, see set_position ()
 };
 
 #endif
@@ -0,0 +1,876 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * automation.cc - compiled S88, RCL and macro actions
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "automation.h"
+#include "event.h"
+#include "loco.h"
+#include "addon.h"
+#include "led.h"
+#include "switch.h"
+#include "sig.h"
+#include "railroad.h"
+#include "topology.h"
+#include "s88.h"
+#include "rcl.h"
+#include "debug.h"
+
+bool                            Automation::valid = false;                          // flag: programs are up to date
+std::vector<AUTOMATION_INSN>    Automation::insns;                                  // instructions of all programs
+std::vector<AUTOMATION_PROGRAM> Automation::contact_programs;                       // 2 * coidx + in
+std::vector<AUTOMATION_PROGRAM> Automation::track_programs;                         // 2 * trackidx + in
+std::vector<AUTOMATION_PROGRAM> Automation::macro_programs;                         // MAX_LOCO_MACROS_PER_LOCO * loco_idx + macroidx
+AUTOMATION_STATS                Automation::stats;                                  // statistics
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * The actions of all S88 contacts, RCL tracks and loco macros are compiled into one array of instructions. Parameters
+ * are checked once against the number of configured objects, invalid actions are dropped. Every program is a slice
+ * of this array. The programs are rebuilt on the first trigger after a change of the configuration.
+ *
+ * Locos which depend on the trigger (loco linked to the railroad of a contact, loco detected by RCL, loco of a macro)
+ * and the last loco detected on a RCL track are resolved at run time.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+
+// S88 action -> RCL action with the same parameters
+static const uint8_t s88_to_rcl_action[S88_ACTIONS] =
+{
+    RCL_ACTION_NONE,                                                                // S88_ACTION_NONE
+    RCL_ACTION_SET_LOCO_SPEED,                                                      // S88_ACTION_SET_LOCO_SPEED
+    RCL_ACTION_SET_LOCO_MIN_SPEED,                                                  // S88_ACTION_SET_LOCO_MIN_SPEED
+    RCL_ACTION_SET_LOCO_MAX_SPEED,                                                  // S88_ACTION_SET_LOCO_MAX_SPEED
+    RCL_ACTION_SET_LOCO_FORWARD_DIRECTION,                                          // S88_ACTION_SET_LOCO_FORWARD_DIRECTION
+    RCL_ACTION_SET_LOCO_ALL_FUNCTIONS_OFF,                                          // S88_ACTION_SET_LOCO_ALL_FUNCTIONS_OFF
+    RCL_ACTION_SET_LOCO_FUNCTION_OFF,                                               // S88_ACTION_SET_LOCO_FUNCTION_OFF
+    RCL_ACTION_SET_LOCO_FUNCTION_ON,                                                // S88_ACTION_SET_LOCO_FUNCTION_ON
+    RCL_ACTION_EXECUTE_LOCO_MACRO,                                                  // S88_ACTION_EXECUTE_LOCO_MACRO
+    RCL_ACTION_SET_ADDON_ALL_FUNCTIONS_OFF,                                         // S88_ACTION_SET_ADDON_ALL_FUNCTIONS_OFF
+    RCL_ACTION_SET_ADDON_FUNCTION_OFF,                                              // S88_ACTION_SET_ADDON_FUNCTION_OFF
+    RCL_ACTION_SET_ADDON_FUNCTION_ON,                                               // S88_ACTION_SET_ADDON_FUNCTION_ON
+    RCL_ACTION_SET_RAILROAD,                                                        // S88_ACTION_SET_RAILROAD
+    RCL_ACTION_SET_FREE_RAILROAD,                                                   // S88_ACTION_SET_FREE_RAILROAD
+    RCL_ACTION_SET_LOCO_DESTINATION,                                                // S88_ACTION_SET_LOCO_DESTINATION
+    RCL_ACTION_SET_LED,                                                             // S88_ACTION_SET_LED
+    RCL_ACTION_SET_SWITCH,                                                          // S88_ACTION_SET_SWITCH
+    RCL_ACTION_SET_SIGNAL                                                           // S88_ACTION_SET_SIGNAL
+};
+
+// loco macro action -> RCL action, parameters are shifted by one to insert the loco or add-on
+static const uint8_t loco_to_rcl_action[LOCO_ACTIONS] =
+{
+    RCL_ACTION_NONE,                                                                // LOCO_ACTION_NONE
+    RCL_ACTION_SET_LOCO_SPEED,                                                      // LOCO_ACTION_SET_LOCO_SPEED
+    RCL_ACTION_SET_LOCO_MIN_SPEED,                                                  // LOCO_ACTION_SET_LOCO_MIN_SPEED
+    RCL_ACTION_SET_LOCO_MAX_SPEED,                                                  // LOCO_ACTION_SET_LOCO_MAX_SPEED
+    RCL_ACTION_SET_LOCO_FORWARD_DIRECTION,                                          // LOCO_ACTION_SET_LOCO_FORWARD_DIRECTION
+    RCL_ACTION_SET_LOCO_ALL_FUNCTIONS_OFF,                                          // LOCO_ACTION_SET_LOCO_ALL_FUNCTIONS_OFF
+    RCL_ACTION_SET_LOCO_FUNCTION_OFF,                                               // LOCO_ACTION_SET_LOCO_FUNCTION_OFF
+    RCL_ACTION_SET_LOCO_FUNCTION_ON,                                                // LOCO_ACTION_SET_LOCO_FUNCTION_ON
+    RCL_ACTION_SET_ADDON_ALL_FUNCTIONS_OFF,                                         // LOCO_ACTION_SET_ADDON_ALL_FUNCTIONS_OFF
+    RCL_ACTION_SET_ADDON_FUNCTION_OFF,                                              // LOCO_ACTION_SET_ADDON_FUNCTION_OFF
+    RCL_ACTION_SET_ADDON_FUNCTION_ON                                                // LOCO_ACTION_SET_ADDON_FUNCTION_ON
+};
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * invalidate () - programs must be rebuilt
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Automation::invalidate (void)
+{
+    Automation::valid = false;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * set_loco_ref () - set loco reference of instruction, return false if loco is invalid
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+Automation::set_loco_ref (AUTOMATION_INSN * insn, uint_fast16_t loco_idx)
+{
+    bool    rtc = true;
+
+    if (loco_idx == 0xFFFF)
+    {
+        insn->ref   = AUTOMATION_REF_CONTEXT;
+        insn->idx   = 0xFFFF;
+    }
+    else if (loco_idx >= S88_RCL_DETECTED_OFFSET)
+    {
+        insn->ref   = AUTOMATION_REF_RCL_TRACK;
+        insn->idx   = loco_idx - S88_RCL_DETECTED_OFFSET;
+        rtc         = (insn->idx < RCL::get_n_tracks ());
+    }
+    else
+    {
+        insn->ref   = AUTOMATION_REF_FIXED;
+        insn->idx   = loco_idx;
+        rtc         = (loco_idx < Locos::get_n_locos ());
+    }
+
+    return rtc;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * add_insn () - validate instruction and append it to program
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Automation::add_insn (AUTOMATION_PROGRAM * p, AUTOMATION_INSN * insn, const char * source)
+{
+    uint_fast16_t   n       = 0xFFFF;                                                   // number of objects for idx
+    bool            ok      = true;
+
+    switch (insn->op)
+    {
+        case AUTOMATION_OP_LOCO_FUNCTION:
+        {
+            ok = (insn->a == 0xFF || insn->a < MAX_LOCO_FUNCTIONS);
+            break;
+        }
+        case AUTOMATION_OP_LOCO_MACRO:
+        {
+            ok = (insn->a < MAX_LOCO_MACROS_PER_LOCO);
+            break;
+        }
+        case AUTOMATION_OP_LOCO_DESTINATION:
+        {
+            ok = (insn->a == 0xFF || insn->a < RailroadGroups::get_n_railroad_groups ());
+            break;
+        }
+        case AUTOMATION_OP_ADDON_FUNCTION:
+        {
+            n   = AddOns::get_n_addons ();
+            ok  = (insn->a == 0xFF || insn->a < MAX_LOCO_FUNCTIONS);
+            break;
+        }
+        case AUTOMATION_OP_LED:
+        {
+            n   = Leds::get_n_led_groups ();
+            break;
+        }
+        case AUTOMATION_OP_SWITCH:
+        {
+            n   = Switches::get_n_switches ();
+            break;
+        }
+        case AUTOMATION_OP_SIGNAL:
+        {
+            n   = Signals::get_n_signals ();
+            break;
+        }
+        case AUTOMATION_OP_SET_RAILROAD:
+        {
+            n   = RailroadGroups::get_n_railroad_groups ();
+            ok  = (insn->idx < n && insn->a < RailroadGroups::railroad_groups[insn->idx].get_n_railroads ());
+            break;
+        }
+        case AUTOMATION_OP_SET_FREE_RAILROAD:
+        case AUTOMATION_OP_SET_LINKED_RAILROAD:
+        {
+            n   = RailroadGroups::get_n_railroad_groups ();
+            break;
+        }
+        case AUTOMATION_OP_WAIT_S88:
+        {
+            ok  = (insn->a < S88::get_n_contacts ());
+            break;
+        }
+    }
+
+    if (n != 0xFFFF && insn->idx == 0xFFFF)
+    {
+        return;                                                                         // no object selected: nothing to do
+    }
+
+    if (! ok || (n != 0xFFFF && insn->idx >= n))
+    {
+        Debug::printf (DEBUG_LEVEL_NORMAL, "Automation: %s: invalid parameters for op %u, action dropped\n", source, insn->op);
+        Automation::stats.n_dropped++;
+        return;
+    }
+
+    if (insn->condition != RCL_CONDITION_ALWAYS)
+    {
+        p->has_conditions = true;
+    }
+
+    Automation::insns.push_back (*insn);
+    p->n_insns++;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * compile_action () - compile RCL action or S88 action mapped to RCL action
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Automation::compile_action (AUTOMATION_PROGRAM * p, AUTOMATION_INSN * insn, uint_fast8_t action, uint16_t * param, const char * source)
+{
+    bool    loco_ok = true;
+
+    insn->ref       = AUTOMATION_REF_FIXED;
+    insn->start     = 0;
+    insn->a         = 0;
+    insn->b         = 0;
+    insn->c         = 0;
+
+    switch (action)
+    {
+        case RCL_ACTION_SET_LOCO_SPEED:                                                 // parameters: START, LOCO, SPEED, TENTHS
+        case RCL_ACTION_SET_LOCO_MIN_SPEED:
+        case RCL_ACTION_SET_LOCO_MAX_SPEED:
+        {
+            insn->op        = AUTOMATION_OP_LOCO_SPEED;
+            insn->start     = param[0];
+            loco_ok         = Automation::set_loco_ref (insn, param[1]);
+            insn->a         = (action == RCL_ACTION_SET_LOCO_SPEED)     ? EVENT_SET_LOCO_SPEED :
+                              (action == RCL_ACTION_SET_LOCO_MIN_SPEED) ? EVENT_SET_LOCO_MIN_SPEED : EVENT_SET_LOCO_MAX_SPEED;
+            insn->b         = param[2];
+            insn->c         = param[3];
+            break;
+        }
+
+        case RCL_ACTION_SET_LOCO_FORWARD_DIRECTION:                                     // parameters: START, LOCO, FWD
+        {
+            insn->op        = AUTOMATION_OP_LOCO_DIR;
+            insn->start     = param[0];
+            loco_ok         = Automation::set_loco_ref (insn, param[1]);
+            insn->a         = param[2];
+            break;
+        }
+
+        case RCL_ACTION_SET_LOCO_ALL_FUNCTIONS_OFF:                                     // parameters: START, LOCO
+        case RCL_ACTION_SET_LOCO_FUNCTION_OFF:                                          // parameters: START, LOCO, FUNC_IDX
+        case RCL_ACTION_SET_LOCO_FUNCTION_ON:                                           // parameters: START, LOCO, FUNC_IDX
+        {
+            insn->op        = AUTOMATION_OP_LOCO_FUNCTION;
+            insn->start     = param[0];
+            loco_ok         = Automation::set_loco_ref (insn, param[1]);
+            insn->a         = (action == RCL_ACTION_SET_LOCO_ALL_FUNCTIONS_OFF) ? 0xFF : param[2];
+            insn->b         = (action == RCL_ACTION_SET_LOCO_FUNCTION_ON);
+            break;
+        }
+
+        case RCL_ACTION_EXECUTE_LOCO_MACRO:                                             // parameters: START, LOCO, MACRO_IDX
+        {
+            insn->op        = AUTOMATION_OP_LOCO_MACRO;
+            insn->start     = param[0];
+            loco_ok         = Automation::set_loco_ref (insn, param[1]);
+            insn->a         = param[2];
+            break;
+        }
+
+        case RCL_ACTION_SET_ADDON_ALL_FUNCTIONS_OFF:                                    // parameters: START, ADDON
+        case RCL_ACTION_SET_ADDON_FUNCTION_OFF:                                         // parameters: START, ADDON, FUNC_IDX
+        case RCL_ACTION_SET_ADDON_FUNCTION_ON:                                          // parameters: START, ADDON, FUNC_IDX
+        {
+            insn->op        = AUTOMATION_OP_ADDON_FUNCTION;
+            insn->start     = param[0];
+            insn->idx       = param[1];
+            insn->a         = (action == RCL_ACTION_SET_ADDON_ALL_FUNCTIONS_OFF) ? 0xFF : param[2];
+            insn->b         = (action == RCL_ACTION_SET_ADDON_FUNCTION_ON);
+            break;
+        }
+
+        case RCL_ACTION_SET_RAILROAD:                                                   // parameters: RRG_IDX, RR_IDX
+        {
+            insn->op        = AUTOMATION_OP_SET_RAILROAD;
+            insn->idx       = param[0];
+            insn->a         = param[1];
+            break;
+        }
+
+        case RCL_ACTION_SET_FREE_RAILROAD:                                              // parameters: RRG_IDX
+        {
+            insn->op        = AUTOMATION_OP_SET_FREE_RAILROAD;
+            insn->idx       = param[0];
+            break;
+        }
+
+        case RCL_ACTION_SET_LINKED_RAILROAD:                                            // parameters: RRG_IDX
+        {
+            insn->op        = AUTOMATION_OP_SET_LINKED_RAILROAD;
+            insn->idx       = param[0];
+            break;
+        }
+
+        case RCL_ACTION_WAIT_FOR_FREE_S88_CONTACT:                                      // parameters: START, LOCO, COIDX, TENTHS
+        {
+            insn->op        = AUTOMATION_OP_WAIT_S88;
+            insn->start     = param[0];
+            loco_ok         = Automation::set_loco_ref (insn, param[1]);
+            insn->a         = param[2];
+            insn->b         = param[3];
+            break;
+        }
+
+        case RCL_ACTION_SET_LOCO_DESTINATION:                                           // parameters: LOCO_IDX, RRG_IDX
+        {
+            insn->op        = AUTOMATION_OP_LOCO_DESTINATION;
+            loco_ok         = Automation::set_loco_ref (insn, param[0]);
+            insn->a         = param[1];
+            break;
+        }
+
+        case RCL_ACTION_SET_LED:                                                        // parameters: START, LG_IDX, LED_MASK, LED_ON
+        {
+            insn->op        = AUTOMATION_OP_LED;
+            insn->start     = param[0];
+            insn->idx       = param[1];
+            insn->a         = param[2];
+            insn->b         = param[3];
+            break;
+        }
+
+        case RCL_ACTION_SET_SWITCH:                                                     // parameters: START, SW_IDX, SW_STATE
+        {
+            insn->op        = AUTOMATION_OP_SWITCH;
+            insn->start     = param[0];
+            insn->idx       = param[1];
+            insn->a         = param[2];
+            break;
+        }
+
+        case RCL_ACTION_SET_SIGNAL:                                                     // parameters: START, SIG_IDX, SIG_STATE
+        {
+            insn->op        = AUTOMATION_OP_SIGNAL;
+            insn->start     = param[0];
+            insn->idx       = param[1];
+            insn->a         = param[2];
+            break;
+        }
+
+        default:
+        {
+            return;
+        }
+    }
+
+    if (loco_ok)
+    {
+        Automation::add_insn (p, insn, source);
+    }
+    else
+    {
+        Debug::printf (DEBUG_LEVEL_NORMAL, "Automation: %s: invalid loco for op %u, action dropped\n", source, insn->op);
+        Automation::stats.n_dropped++;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * build () - compile actions of all contacts, tracks and macros
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Automation::build (void)
+{
+    uint_fast16_t       n_contacts  = S88::get_n_contacts ();
+    uint_fast8_t        n_tracks    = RCL::get_n_tracks ();
+    uint_fast16_t       n_locos     = Locos::get_n_locos ();
+    AUTOMATION_INSN     insn;
+    AUTOMATION_PROGRAM *p;
+    uint_fast16_t       coidx;
+    uint_fast8_t        trackidx;
+    uint_fast16_t       loco_idx;
+    uint_fast8_t        macroidx;
+    uint_fast8_t        in;
+    uint_fast8_t        idx;
+
+    Automation::insns.clear ();
+    Automation::stats.n_dropped = 0;
+
+    Automation::contact_programs.resize (2 * n_contacts);
+
+    for (coidx = 0; coidx < n_contacts; coidx++)
+    {
+        S88_Contact *   co = &S88::contacts[coidx];
+
+        for (in = 0; in < 2; in++)
+        {
+            uint_fast8_t        n_actions   = in ? co->n_contact_actions_in : co->n_contact_actions_out;
+            CONTACT_ACTION *    cap         = in ? co->contact_actions_in : co->contact_actions_out;
+
+            p                   = &Automation::contact_programs[2 * coidx + in];
+            p->first            = Automation::insns.size ();
+            p->n_insns          = 0;
+            p->has_conditions   = false;
+
+            for (idx = 0; idx < n_actions; idx++)
+            {
+                if (cap[idx].action < S88_ACTIONS)
+                {
+                    insn.condition              = RCL_CONDITION_ALWAYS;
+                    insn.condition_destination  = 0xFF;
+                    Automation::compile_action (p, &insn, s88_to_rcl_action[cap[idx].action], cap[idx].parameters, "S88 contact");
+                }
+            }
+        }
+    }
+
+    Automation::track_programs.resize (2 * n_tracks);
+
+    for (trackidx = 0; trackidx < n_tracks; trackidx++)
+    {
+        RCL_Track *     tr = &RCL::tracks[trackidx];
+
+        for (in = 0; in < 2; in++)
+        {
+            uint_fast8_t        n_actions   = in ? tr->n_track_actions_in : tr->n_track_actions_out;
+            RCL_TRACK_ACTION *  trap        = in ? tr->track_actions_in : tr->track_actions_out;
+
+            p                   = &Automation::track_programs[2 * trackidx + in];
+            p->first            = Automation::insns.size ();
+            p->n_insns          = 0;
+            p->has_conditions   = false;
+
+            for (idx = 0; idx < n_actions; idx++)
+            {
+                if (trap[idx].condition != RCL_CONDITION_NEVER)
+                {
+                    insn.condition              = trap[idx].condition;
+                    insn.condition_destination  = trap[idx].condition_destination;
+                    Automation::compile_action (p, &insn, trap[idx].action, trap[idx].parameters, "RCL track");
+                }
+            }
+        }
+    }
+
+    Automation::macro_programs.resize (MAX_LOCO_MACROS_PER_LOCO * n_locos);
+
+    for (loco_idx = 0; loco_idx < n_locos; loco_idx++)
+    {
+        Loco *          lo          = &Locos::locos[loco_idx];
+        uint_fast16_t   addon_idx   = lo->get_addon ();
+
+        for (macroidx = 0; macroidx < MAX_LOCO_MACROS_PER_LOCO; macroidx++)
+        {
+            uint_fast8_t    n_actions = lo->get_n_macro_actions (macroidx);
+
+            p                   = &Automation::macro_programs[MAX_LOCO_MACROS_PER_LOCO * loco_idx + macroidx];
+            p->first            = Automation::insns.size ();
+            p->n_insns          = 0;
+            p->has_conditions   = false;
+
+            for (idx = 0; idx < n_actions; idx++)
+            {
+                LOCOACTION      la;
+                uint16_t        param[RCL_MAX_ACTION_PARAMETERS];
+                uint_fast8_t    action;
+
+                memset (&la, 0, sizeof (la));
+                lo->get_macro_action (macroidx, idx, &la);
+                action = (la.action < LOCO_ACTIONS) ? loco_to_rcl_action[la.action] : RCL_ACTION_NONE;
+
+                if (action >= RCL_ACTION_SET_ADDON_ALL_FUNCTIONS_OFF)
+                {
+                    param[1] = addon_idx;                                               // add-on of loco
+                }
+                else
+                {
+                    param[1] = 0xFFFF;                                                  // context loco
+                }
+
+                param[0] = la.parameters[0];                                            // START
+
+                memcpy (param + 2, la.parameters + 1, (RCL_MAX_ACTION_PARAMETERS - 2) * sizeof (uint16_t));
+
+                insn.condition              = RCL_CONDITION_ALWAYS;
+                insn.condition_destination  = 0xFF;
+                Automation::compile_action (p, &insn, action, param, "loco macro");
+            }
+        }
+    }
+
+    Automation::stats.n_builds++;
+    Automation::stats.n_programs    = Automation::contact_programs.size () + Automation::track_programs.size () + Automation::macro_programs.size ();
+    Automation::stats.n_insns       = Automation::insns.size ();
+    Automation::valid               = true;
+
+    Debug::printf (DEBUG_LEVEL_VERBOSE, "Automation: %u programs, %u instructions, %u actions dropped\n",
+                   Automation::stats.n_programs, Automation::stats.n_insns, Automation::stats.n_dropped);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * set_loco_speed () - set speed, min speed or max speed of loco
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Automation::set_loco_speed (uint_fast16_t loco_idx, uint_fast8_t speed_type, uint_fast8_t speed, uint_fast16_t tenths)
+{
+    uint_fast8_t current_speed = Locos::locos[loco_idx].get_speed ();
+
+    if (speed_type == EVENT_SET_LOCO_SPEED ||
+        (speed_type == EVENT_SET_LOCO_MIN_SPEED && current_speed < speed) ||
+        (speed_type == EVENT_SET_LOCO_MAX_SPEED && current_speed > speed))
+    {
+        Locos::locos[loco_idx].set_speed (speed, tenths);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * set_free_railroad () - set free railroad with best route to destination of loco, stop route loco if none is possible
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Automation::set_free_railroad (uint_fast8_t rrgidx, uint_fast16_t route_loco_idx, uint_fast16_t destination_loco_idx)
+{
+    RailroadGroup * rrg = &RailroadGroups::railroad_groups[rrgidx];
+    uint8_t         rridx_list[MAX_RAILROADS_PER_RAILROAD_GROUP];
+    uint_fast8_t    n_free;
+    uint_fast8_t    fidx;
+
+    n_free = Topology::get_free_railroads (rrgidx, destination_loco_idx, rridx_list);
+
+    for (fidx = 0; fidx < n_free; fidx++)
+    {
+        if (rrg->set_active_railroad (rridx_list[fidx], route_loco_idx))
+        {
+            Debug::printf (DEBUG_LEVEL_VERBOSE, "Info: free railroad found: rridx=%u\n", rridx_list[fidx]);
+            return;
+        }
+    }
+
+    Debug::printf (DEBUG_LEVEL_VERBOSE, "Error: Automation::set_free_railroad: cannot find free railroad\n");
+
+    if (route_loco_idx != 0xFFFF)
+    {
+        Locos::locos[route_loco_idx].set_speed (0);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * execute () - execute program
+ *
+ * context_loco_idx:        loco for actions without loco: loco linked to railroad of contact, detected or macro loco
+ * route_loco_idx:          loco which requests railroads and is stopped if a railroad is refused
+ * destination_loco_idx:    loco whose destination is used for conditions and free railroads
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Automation::execute (const AUTOMATION_PROGRAM * p, uint_fast16_t context_loco_idx, uint_fast16_t route_loco_idx, uint_fast16_t destination_loco_idx)
+{
+    uint_fast8_t    destination = 0xFF;
+    uint32_t        idx;
+    uint32_t        end         = p->first + p->n_insns;
+
+    if (p->has_conditions && destination_loco_idx != 0xFFFF)
+    {
+        destination = Locos::locos[destination_loco_idx].get_destination ();
+    }
+
+    for (idx = p->first; idx < end; idx++)
+    {
+        const AUTOMATION_INSN * ip  = &Automation::insns[idx];
+        uint_fast16_t           oidx;
+
+        if ((ip->condition == RCL_CONDITION_IF_DESTINATION && ip->condition_destination != destination) ||
+            (ip->condition == RCL_CONDITION_IF_NOT_DESTINATION && ip->condition_destination == destination))
+        {
+            continue;
+        }
+
+        switch (ip->ref)
+        {
+            case AUTOMATION_REF_CONTEXT:    oidx = context_loco_idx;                        break;
+            case AUTOMATION_REF_RCL_TRACK:  oidx = RCL::tracks[ip->idx].last_loco_idx;      break;
+            default:                        oidx = ip->idx;                                 break;
+        }
+
+        if (oidx == 0xFFFF)
+        {
+            continue;
+        }
+
+        Automation::stats.n_executed++;
+
+        if (ip->start != 0 && ip->op != AUTOMATION_OP_WAIT_S88)
+        {
+            Automation::stats.n_deferred++;
+        }
+
+        switch (ip->op)
+        {
+            case AUTOMATION_OP_LOCO_SPEED:
+            {
+                if (ip->start == 0)
+                {
+                    Automation::set_loco_speed (oidx, ip->a, ip->b, ip->c);
+                }
+                else
+                {
+                    Event::add_event_loco_speed (ip->start, oidx, ip->a, ip->b, ip->c);
+                }
+                break;
+            }
+
+            case AUTOMATION_OP_LOCO_DIR:
+            {
+                if (ip->start == 0)
+                {
+                    Locos::locos[oidx].set_fwd (ip->a);
+                }
+                else
+                {
+                    Event::add_event_loco_dir (ip->start, oidx, ip->a);
+                }
+                break;
+            }
+
+            case AUTOMATION_OP_LOCO_FUNCTION:
+            {
+                if (ip->start != 0)
+                {
+                    Event::add_event_loco_function (ip->start, oidx, ip->a, ip->b);
+                }
+                else if (ip->a == 0xFF)
+                {
+                    Locos::locos[oidx].reset_functions ();
+                }
+                else
+                {
+                    Locos::locos[oidx].set_function (ip->a, ip->b);
+                }
+                break;
+            }
+
+            case AUTOMATION_OP_LOCO_MACRO:
+            {
+                if (ip->start == 0)
+                {
+                    Automation::execute_macro (oidx, ip->a);
+                }
+                else
+                {
+                    Event::add_event_execute_loco_macro (ip->start, oidx, ip->a);
+                }
+                break;
+            }
+
+            case AUTOMATION_OP_LOCO_DESTINATION:
+            {
+                Locos::locos[oidx].set_destination (ip->a);
+                break;
+            }
+
+            case AUTOMATION_OP_ADDON_FUNCTION:
+            {
+                if (ip->start != 0)
+                {
+                    Event::add_event_addon_function (ip->start, oidx, ip->a, ip->b);
+                }
+                else if (ip->a == 0xFF)
+                {
+                    AddOns::addons[oidx].reset_functions ();
+                }
+                else
+                {
+                    AddOns::addons[oidx].set_function (ip->a, ip->b);
+                }
+                break;
+            }
+
+            case AUTOMATION_OP_LED:
+            {
+                if (ip->start == 0)
+                {
+                    Leds::led_groups[oidx].set_state (ip->a, ip->b);
+                }
+                else
+                {
+                    Event::add_event_led_set_state (ip->start, oidx, ip->a, ip->b);
+                }
+                break;
+            }
+
+            case AUTOMATION_OP_SWITCH:
+            {
+                if (ip->start == 0)
+                {
+                    Switches::switches[oidx].set_state (ip->a);
+                }
+                else
+                {
+                    Event::add_event_switch_set_state (ip->start, oidx, ip->a);
+                }
+                break;
+            }
+
+            case AUTOMATION_OP_SIGNAL:
+            {
+                if (ip->start == 0)
+                {
+                    Signals::signals[oidx].set_state (ip->a);
+                }
+                else
+                {
+                    Event::add_event_signal_set_state (ip->start, oidx, ip->a);
+                }
+                break;
+            }
+
+            case AUTOMATION_OP_SET_RAILROAD:
+            {
+                if (! RailroadGroups::railroad_groups[oidx].set_active_railroad (ip->a, route_loco_idx) && route_loco_idx != 0xFFFF)
+                {
+                    Locos::locos[route_loco_idx].set_speed (0);
+                }
+                break;
+            }
+
+            case AUTOMATION_OP_SET_FREE_RAILROAD:
+            {
+                Automation::set_free_railroad (oidx, route_loco_idx, destination_loco_idx);
+                break;
+            }
+
+            case AUTOMATION_OP_SET_LINKED_RAILROAD:
+            {
+                RailroadGroup * rrg     = &RailroadGroups::railroad_groups[oidx];
+                uint_fast8_t    rridx   = rrg->get_link_railroad (route_loco_idx);
+
+                if (rridx != 0xFF)
+                {
+                    if (! rrg->set_active_railroad (rridx, route_loco_idx) && route_loco_idx != 0xFFFF)
+                    {
+                        Locos::locos[route_loco_idx].set_speed (0);
+                    }
+                }
+                else
+                {
+                    Debug::printf (DEBUG_LEVEL_VERBOSE, "Warning: Automation::execute: cannot find linked railroad, searching for free railroad\n");
+                    Automation::set_free_railroad (oidx, route_loco_idx, destination_loco_idx);
+                }
+                break;
+            }
+
+            case AUTOMATION_OP_WAIT_S88:
+            {
+                if (S88::get_state_bit (ip->a) == S88_STATE_OCCUPIED)
+                {
+                    uint_fast8_t    current_speed = Locos::locos[oidx].get_speed ();
+
+                    if (ip->start == 0)
+                    {
+                        Locos::locos[oidx].set_speed (0, ip->b);
+                    }
+                    else
+                    {
+                        Event::add_event_loco_speed (ip->start, oidx, EVENT_SET_LOCO_SPEED, 0, ip->b);
+                    }
+
+                    Event::add_event_wait_s88 (ip->start, ip->a, oidx, current_speed, ip->b);
+                    Automation::stats.n_deferred++;
+                }
+                break;
+            }
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * execute_contact_actions () - execute actions of S88 contact
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Automation::execute_contact_actions (uint_fast16_t coidx, bool in)
+{
+    if (! Automation::valid)
+    {
+        Automation::build ();
+    }
+
+    if (2 * coidx + in < Automation::contact_programs.size ())
+    {
+        const AUTOMATION_PROGRAM *  p                   = &Automation::contact_programs[2 * coidx + in];
+        S88_Contact *               co                  = &S88::contacts[coidx];
+        uint_fast16_t               linked_loco_idx     = 0xFFFF;
+        uint_fast16_t               located_loco_idx    = 0xFFFF;
+        uint_fast16_t               route_loco_idx;
+
+        if (p->n_insns == 0)
+        {
+            return;
+        }
+
+        if (co->rrgidx < RailroadGroups::get_n_railroad_groups () && co->rridx < RailroadGroups::railroad_groups[co->rrgidx].get_n_railroads ())
+        {
+            Railroad * rr = &RailroadGroups::railroad_groups[co->rrgidx].railroads[co->rridx];
+
+            linked_loco_idx = rr->get_link_loco ();
+
+            if (in)
+            {
+                located_loco_idx = rr->get_located_loco ();                            // loco which arrived on linked railroad
+            }
+        }
+
+        route_loco_idx = (located_loco_idx != 0xFFFF) ? located_loco_idx : linked_loco_idx;   // routes are locked for this loco
+        Automation::execute (p, linked_loco_idx, route_loco_idx, located_loco_idx);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * execute_track_actions () - execute actions of RCL track
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Automation::execute_track_actions (uint_fast8_t trackidx, bool in, uint_fast16_t detected_loco_idx)
+{
+    uint_fast16_t   pidx = 2 * trackidx + in;
+
+    if (! Automation::valid)
+    {
+        Automation::build ();
+    }
+
+    if (pidx < Automation::track_programs.size ())
+    {
+        Automation::execute (&Automation::track_programs[pidx], detected_loco_idx, detected_loco_idx, detected_loco_idx);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * execute_macro () - execute loco macro
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Automation::execute_macro (uint_fast16_t loco_idx, uint_fast8_t macroidx)
+{
+    if (! Automation::valid)
+    {
+        Automation::build ();
+    }
+
+    if (macroidx < MAX_LOCO_MACROS_PER_LOCO && MAX_LOCO_MACROS_PER_LOCO * loco_idx + macroidx < Automation::macro_programs.size ())
+    {
+        Automation::execute (&Automation::macro_programs[MAX_LOCO_MACROS_PER_LOCO * loco_idx + macroidx], loco_idx, 0xFFFF, 0xFFFF);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_stats () - get statistics
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Automation::get_stats (AUTOMATION_STATS * statsp)
+{
+    *statsp = Automation::stats;
+}
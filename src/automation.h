@@ -0,0 +1,100 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * automation.h - compiled S88, RCL and macro actions
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef AUTOMATION_H
+#define AUTOMATION_H
+
+#include <stdint.h>
+#include <vector>
+
+#define AUTOMATION_OP_LOCO_SPEED                    0                           // idx: loco, a: EVENT_SET_LOCO_xxx, b: speed, c: tenths
+#define AUTOMATION_OP_LOCO_DIR                      1                           // idx: loco, a: fwd
+#define AUTOMATION_OP_LOCO_FUNCTION                 2                           // idx: loco, a: f (0xFF: all), b: on
+#define AUTOMATION_OP_LOCO_MACRO                    3                           // idx: loco, a: macroidx
+#define AUTOMATION_OP_LOCO_DESTINATION              4                           // idx: loco, a: rrgidx
+#define AUTOMATION_OP_ADDON_FUNCTION                5                           // idx: addon, a: f (0xFF: all), b: on
+#define AUTOMATION_OP_LED                           6                           // idx: led group, a: mask, b: on
+#define AUTOMATION_OP_SWITCH                        7                           // idx: switch, a: state
+#define AUTOMATION_OP_SIGNAL                        8                           // idx: signal, a: state
+#define AUTOMATION_OP_SET_RAILROAD                  9                           // idx: rrgidx, a: rridx
+#define AUTOMATION_OP_SET_FREE_RAILROAD             10                          // idx: rrgidx
+#define AUTOMATION_OP_SET_LINKED_RAILROAD           11                          // idx: rrgidx
+#define AUTOMATION_OP_WAIT_S88                      12                          // idx: loco, a: coidx, b: tenths
+
+#define AUTOMATION_REF_FIXED                        0                           // idx is an object index
+#define AUTOMATION_REF_CONTEXT                      1                           // loco of trigger: linked, detected or macro loco
+#define AUTOMATION_REF_RCL_TRACK                    2                           // idx is a RCL track, use last detected loco
+
+typedef struct
+{
+    uint8_t             op;                                                     // AUTOMATION_OP_xxx
+    uint8_t             ref;                                                    // AUTOMATION_REF_xxx, resolution of loco idx
+    uint8_t             condition;                                              // RCL_CONDITION_xxx
+    uint8_t             condition_destination;                                  // rrgidx for condition
+    uint16_t            idx;                                                    // object index, see above
+    uint16_t            start;                                                  // delay in tenths, 0: immediately
+    uint16_t            a;
+    uint16_t            b;
+    uint16_t            c;
+} AUTOMATION_INSN;
+
+typedef struct
+{
+    uint32_t            first;                                                  // index of first instruction
+    uint16_t            n_insns;                                                // number of instructions
+    bool                has_conditions;                                         // flag: destination of loco is needed
+} AUTOMATION_PROGRAM;
+
+typedef struct
+{
+    uint32_t            n_builds;                                               // number of compilations
+    uint32_t            n_programs;                                             // number of programs
+    uint32_t            n_insns;                                                // number of instructions
+    uint32_t            n_dropped;                                              // actions dropped by validation
+    uint32_t            n_executed;                                             // executed instructions
+    uint32_t            n_deferred;                                             // instructions passed to event queue
+} AUTOMATION_STATS;
+
+class Automation
+{
+    public:
+        static void                     invalidate (void);
+        static void                     execute_contact_actions (uint_fast16_t coidx, bool in);
+        static void                     execute_track_actions (uint_fast8_t trackidx, bool in, uint_fast16_t detected_loco_idx);
+        static void                     execute_macro (uint_fast16_t loco_idx, uint_fast8_t macroidx);
+        static void                     set_loco_speed (uint_fast16_t loco_idx, uint_fast8_t speed_type, uint_fast8_t speed, uint_fast16_t tenths);
+        static void                     get_stats (AUTOMATION_STATS * statsp);
+
+    private:
+        static bool                     valid;                                  // flag: programs are up to date
+        static std::vector<AUTOMATION_INSN>     insns;                          // instructions of all programs
+        static std::vector<AUTOMATION_PROGRAM>  contact_programs;               // 2 * coidx + in
+        static std::vector<AUTOMATION_PROGRAM>  track_programs;                 // 2 * trackidx + in
+        static std::vector<AUTOMATION_PROGRAM>  macro_programs;                 // MAX_LOCO_MACROS_PER_LOCO * loco_idx + macroidx
+        static AUTOMATION_STATS         stats;                                  // statistics
+
+        static void                     build (void);
+        static void                     add_insn (AUTOMATION_PROGRAM * p, AUTOMATION_INSN * insn, const char * source);
+        static bool                     set_loco_ref (AUTOMATION_INSN * insn, uint_fast16_t loco_idx);
+        static void                     compile_action (AUTOMATION_PROGRAM * p, AUTOMATION_INSN * insn, uint_fast8_t action, uint16_t * param, const char * source);
+        static void                     set_free_railroad (uint_fast8_t rrgidx, uint_fast16_t route_loco_idx, uint_fast16_t destination_loco_idx);
+        static void                     execute (const AUTOMATION_PROGRAM * p, uint_fast16_t context_loco_idx, uint_fast16_t route_loco_idx, uint_fast16_t destination_loco_idx);
+};
+
+#endif
@@ -0,0 +1,848 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * bench.cc - benchmarks of time critical code paths, build with "make bench"
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ *
+ * usage: fm22-bench [name ...]
+ *
+ * Without arguments all benchmarks are run. No STM32 is needed: the serial device is not opened, so all DCC
+ * commands are dropped. Run it in an empty directory, some benchmarks write ini files. Entries starting with "check:"
+ * verify behaviour instead of measuring time, fm22-bench exits with 1 if one of them fails.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <string>
+
+#include "loco.h"
+#include "locostats.h"
+#include "railroad.h"
+#include "switch.h"
+#include "interlock.h"
+#include "automation.h"
+#include "s88.h"
+#include "fileio.h"
+#include "dcc.h"
+#include "metrics.h"
+#include "millis.h"
+#include "http.h"
+#include "debug.h"
+
+#define BENCH_N_LOCOS           1024                                            // max. number of locos
+#define BENCH_HTTP_REQUESTS     200                                             // requests per HTTP benchmark
+#define BENCH_HTTP_PORT         9999
+#define BENCH_LOCO_PASSES       200                                             // scheduler passes over all locos
+#define BENCH_INI_WRITES        50                                              // writes of loco.ini and snapshot
+#define BENCH_S88_PASSES        100000                                          // passes of S88::schedule ()
+#define BENCH_S88_CHANGES       10                                              // changed contacts per pass: 1% of 1024
+#define BENCH_IL_GROUPS         32                                              // railroad groups of interlocking benchmark
+#define BENCH_IL_RAILROADS      8                                               // railroads per group
+#define BENCH_IL_SWITCHES       128                                             // switches shared by the railroads
+#define BENCH_IL_SUB_SWITCHES   4                                               // switches per railroad
+#define BENCH_IL_REQUESTS       1000000                                         // route requests
+#define BENCH_AUTO_TRIGGERS     50                                              // occupied edges of automation benchmark
+#define BENCH_AUTO_LOCOS        S88_MAX_ACTIONS_PER_CONTACT                     // one macro call per contact action
+
+typedef struct
+{
+    const char *        name;
+    const char *        description;
+    void                (*func) (void);
+} BENCH;
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * bench_usec () - monotonic time in microseconds
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static uint64_t
+bench_usec (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000U + (uint64_t) (ts.tv_nsec / 1000);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * bench_report () - print result of a benchmark
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+bench_report (const char * name, uint32_t n, uint64_t usec)
+{
+    printf ("%-32s %9u runs %12.3f usec/run %12.0f runs/sec\n", name, n, (double) usec / n, usec ? 1e6 * n / usec : 0.0);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * bench_check () - print result of a functional check, main () returns 1 if a check failed
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static uint_fast16_t    bench_n_failed;
+
+static void
+bench_check (const char * name, bool ok)
+{
+    printf ("%-32s %s\n", name, ok ? "ok" : "FAILED");
+
+    if (! ok)
+    {
+        bench_n_failed++;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * bench_setup_contact () - add contact linked to railroad, reuse the last contacts if all are used by benchmark s88
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static uint_fast16_t
+bench_setup_contact (uint_fast8_t rrgidx, uint_fast8_t rridx)
+{
+    static uint_fast16_t    n_reused;
+    uint_fast16_t           coidx = S88::add ({});
+
+    if (coidx == 0xFFFF)
+    {
+        coidx = S88_MAX_CONTACTS - 1 - n_reused++;
+
+        while (S88::contacts[coidx].get_n_contact_actions (true) > 0)
+        {
+            S88::contacts[coidx].delete_contact_action (true, 0);
+        }
+
+        while (S88::contacts[coidx].get_n_contact_actions (false) > 0)
+        {
+            S88::contacts[coidx].delete_contact_action (false, 0);
+        }
+    }
+
+    S88::contacts[coidx].set_link_railroad (rrgidx, rridx);
+    S88::set_newstate_bit (coidx, S88_STATE_FREE);
+    S88::set_state_bit (coidx, S88_STATE_FREE);
+    return coidx;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * bench_setup_locos () - add active locos up to n_locos
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+bench_setup_locos (uint_fast16_t n_locos)
+{
+    while (Locos::get_n_locos () < n_locos)
+    {
+        uint_fast16_t   loco_idx = Locos::add ({});
+
+        Locos::locos[loco_idx].set_name ((std::string) "Lok " + std::to_string (loco_idx));
+        Locos::locos[loco_idx].set_addr (loco_idx + 1);
+        Locos::locos[loco_idx].set_speed_steps (128);
+        Locos::locos[loco_idx].activate ();
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * HTTP benchmark: a client thread sends requests through the loopback interface, the main thread runs HTTP::server()
+ * like the main loop. This measures dispatch, rendering and sending of the response.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+    const char *        url;
+    uint32_t            n_requests;
+    uint64_t            n_bytes;                                                // bytes received by client
+    volatile bool       done;
+} BENCH_HTTP_CLIENT;
+
+static void *
+bench_http_client (void * arg)
+{
+    BENCH_HTTP_CLIENT * cp = (BENCH_HTTP_CLIENT *) arg;
+    std::string         request = (std::string) "GET " + cp->url + " HTTP/1.1\r\nHost: localhost\r\nAccept-Encoding: gzip\r\n\r\n";
+    struct sockaddr_in  addr;
+    char                buf[16384];
+    uint32_t            idx;
+
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family         = AF_INET;
+    addr.sin_port           = htons (BENCH_HTTP_PORT);
+    addr.sin_addr.s_addr    = htonl (INADDR_LOOPBACK);
+
+    for (idx = 0; idx < cp->n_requests; idx++)
+    {
+        int     fd = socket (AF_INET, SOCK_STREAM, 0);
+        ssize_t n;
+
+        if (fd < 0 || connect (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0)
+        {
+            perror ("bench_http_client");
+            break;
+        }
+
+        (void) write (fd, request.c_str(), request.length());
+
+        while ((n = read (fd, buf, sizeof (buf))) > 0)
+        {
+            cp->n_bytes += n;
+        }
+
+        close (fd);
+    }
+
+    cp->done = true;
+    return (void *) NULL;
+}
+
+static void
+bench_http_url (const char * name, const char * url)
+{
+    BENCH_HTTP_CLIENT   client;
+    pthread_t           thread;
+    uint64_t            start;
+    uint64_t            usec;
+
+    client.url          = url;
+    client.n_requests   = BENCH_HTTP_REQUESTS;
+    client.n_bytes      = 0;
+    client.done         = false;
+
+    start = bench_usec ();
+
+    if (pthread_create (&thread, (pthread_attr_t *) NULL, bench_http_client, &client) != 0)
+    {
+        perror ("pthread_create");
+        return;
+    }
+
+    while (! client.done)
+    {
+        (void) HTTP::server (false);
+    }
+
+    usec = bench_usec () - start;
+    pthread_join (thread, (void **) NULL);
+
+    bench_report (name, client.n_requests, usec);
+    printf ("%-32s %9llu bytes/response (gzip)\n", "", (unsigned long long) (client.n_bytes / client.n_requests));
+}
+
+static void
+bench_http (void)
+{
+    static bool     initialized;
+
+    if (! initialized)
+    {
+        HTTP::init ();
+        initialized = true;
+    }
+
+    bench_setup_locos (BENCH_N_LOCOS);
+    bench_http_url ("http: loco list, 1024 locos", "/loco");
+    bench_http_url ("http: action locos, cached", "/action?action=locos");
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * loco scheduling: full passes of Locos::schedule () over all locos like the inner main loop, half of the locos are
+ * driving, so the refresh packets of speed and functions are built. bench_schedule_pass () acknowledges each command like
+ * the STM32 with message "continue", otherwise DCC::send_cmd () waits 100 msec.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+bench_schedule_pass (void)
+{
+    bool    rtc;
+
+    do
+    {
+        rtc = Locos::schedule ();
+        DCC::channel_stopped = 0;
+    } while (! rtc);
+}
+
+static void
+bench_locos (void)
+{
+    uint_fast16_t   loco_idx;
+    uint32_t        pass;
+    uint64_t        start;
+    uint64_t        usec;
+
+    bench_setup_locos (BENCH_N_LOCOS);
+
+    for (loco_idx = 0; loco_idx < BENCH_N_LOCOS; loco_idx += 2)
+    {
+        Locos::locos[loco_idx].set_speed_fwd (40, 1);
+        DCC::channel_stopped = 0;
+        Locos::locos[loco_idx].set_function (0, true);
+        DCC::channel_stopped = 0;
+    }
+
+    bench_schedule_pass ();                                                     // start with first loco
+
+    start = bench_usec ();
+
+    for (pass = 0; pass < BENCH_LOCO_PASSES; pass++)
+    {
+        bench_schedule_pass ();
+    }
+
+    usec = bench_usec () - start;
+    bench_report ("locos: schedule pass, 1024 locos", BENCH_LOCO_PASSES, usec);
+    bench_report ("locos: schedule per loco", BENCH_LOCO_PASSES * BENCH_N_LOCOS, usec);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * ini write path: after a change of a loco, FileIO::write_all_ini_files () renders loco.ini and the snapshot. Without
+ * FileIO::init () there is no background writer, so this includes the atomic writes to disk.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+bench_ini (void)
+{
+    uint32_t        idx;
+    uint64_t        start;
+
+    bench_setup_locos (BENCH_N_LOCOS);
+
+    start = bench_usec ();
+
+    for (idx = 0; idx < BENCH_INI_WRITES; idx++)
+    {
+        Locos::data_changed = true;
+        (void) FileIO::write_all_ini_files ();
+    }
+
+    bench_report ("ini: write loco.ini and snapshot", BENCH_INI_WRITES, bench_usec () - start);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * S88 edge scan: S88::schedule () with 1024 contacts, once without changes and once with 1% of the contacts toggled
+ * per pass like a busy layout. All contacts are linked to one railroad, so occupied and free edges run the full path
+ * without contact actions.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+bench_s88_pass (uint_fast16_t n_changes, uint32_t * seedp)
+{
+    uint_fast16_t   idx;
+
+    for (idx = 0; idx < n_changes; idx++)
+    {
+        uint_fast16_t   coidx;
+
+        *seedp  = *seedp * 1103515245U + 12345U;
+        coidx   = (*seedp >> 16) % S88_MAX_CONTACTS;
+        S88::set_newstate_bit (coidx, ! S88::get_newstate_bit (coidx));
+    }
+
+    S88::schedule ();
+}
+
+static void
+bench_s88 (void)
+{
+    uint32_t        seed = 1;
+    uint32_t        pass;
+    uint64_t        start;
+
+    if (RailroadGroups::get_n_railroad_groups () == 0)
+    {
+        uint_fast8_t    rrgidx = RailroadGroups::add ({});
+
+        (void) RailroadGroups::railroad_groups[rrgidx].add ({});
+    }
+
+    while (S88::get_n_contacts () < S88_MAX_CONTACTS)
+    {
+        uint_fast16_t   coidx = S88::add ({});
+
+        S88::contacts[coidx].set_link_railroad (0, 0);
+    }
+
+    DCC::booster_is_on = true;
+
+    start = bench_usec ();
+
+    for (pass = 0; pass < BENCH_S88_PASSES; pass++)
+    {
+        bench_s88_pass (0, &seed);
+    }
+
+    bench_report ("s88: scan, no changes", BENCH_S88_PASSES, bench_usec () - start);
+
+    start = bench_usec ();
+
+    for (pass = 0; pass < BENCH_S88_PASSES; pass++)
+    {
+        bench_s88_pass (BENCH_S88_CHANGES, &seed);
+    }
+
+    bench_report ("s88: scan, 1% changes", BENCH_S88_PASSES, bench_usec () - start);
+    DCC::booster_is_on = false;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * interlocking: 32 railroad groups with 8 railroads each, every railroad sets 4 of 128 switches, so many railroads
+ * conflict. Every 4th group has a route locked by a train. Measured are the conflict matrix build, route requests
+ * (conflict matrix lookups) and the activation of granted routes including the drop of unlocked conflicting routes.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+bench_interlock (void)
+{
+    uint_fast8_t    base_rrgidx;
+    uint_fast8_t    rrgidx;
+    uint_fast8_t    rridx;
+    uint_fast8_t    subidx;
+    uint_fast16_t   base_swidx;
+    uint_fast16_t   coidx = 0;
+    uint32_t        seed = 1;
+    uint32_t        idx;
+    uint32_t        n_granted = 0;
+    uint64_t        start;
+
+    base_swidx = Switches::get_n_switches ();
+
+    for (idx = 0; idx < BENCH_IL_SWITCHES; idx++)
+    {
+        uint_fast16_t   swidx = Switches::add ({});
+
+        Switches::switches[swidx].set_addr (swidx + 1);
+    }
+
+    base_rrgidx = RailroadGroups::get_n_railroad_groups ();
+
+    for (idx = 0; idx < BENCH_IL_GROUPS; idx++)
+    {
+        rrgidx = RailroadGroups::add ({});
+
+        for (rridx = 0; rridx < BENCH_IL_RAILROADS; rridx++)
+        {
+            Railroad *  rr = &RailroadGroups::railroad_groups[rrgidx].railroads[RailroadGroups::railroad_groups[rrgidx].add ({})];
+
+            for (subidx = 0; subidx < BENCH_IL_SUB_SWITCHES; subidx++)
+            {
+                uint_fast8_t    sub = rr->add_switch ();
+
+                seed = seed * 1103515245U + 12345U;
+                rr->set_switch_idx (sub, base_swidx + (seed >> 16) % BENCH_IL_SWITCHES);
+                rr->set_switch_state (sub, (seed >> 8) & 0x01);
+            }
+
+            if (coidx == S88::get_n_contacts ())                                // a route is only locked with a contact
+            {
+                (void) S88::add ({});
+            }
+
+            S88::contacts[coidx].set_link_railroad (rrgidx, rridx);
+            S88::set_newstate_bit (coidx, S88_STATE_FREE);                      // may be occupied by benchmark s88
+            S88::set_state_bit (coidx, S88_STATE_FREE);
+            coidx++;
+        }
+    }
+
+    start = bench_usec ();
+
+    for (idx = 0; idx < 100; idx++)
+    {
+        Interlocking::invalidate ();
+        (void) Interlocking::is_locked (0, 0);                                  // builds the conflict matrix
+    }
+
+    bench_report ("interlock: build, 256 routes", 100, bench_usec () - start);
+
+    for (idx = 0; idx < BENCH_IL_GROUPS; idx += 4)
+    {
+        (void) RailroadGroups::railroad_groups[base_rrgidx + idx].set_active_railroad (0, 0);
+    }
+
+    start = bench_usec ();
+
+    for (idx = 0; idx < BENCH_IL_REQUESTS; idx++)
+    {
+        seed = seed * 1103515245U + 12345U;
+        rrgidx = base_rrgidx + (seed >> 16) % BENCH_IL_GROUPS;
+        rridx = (seed >> 8) % BENCH_IL_RAILROADS;
+
+        if (Interlocking::request (rrgidx, rridx, 0xFFFF) == INTERLOCKING_GRANTED)
+        {
+            n_granted++;
+        }
+    }
+
+    bench_report ("interlock: route request", BENCH_IL_REQUESTS, bench_usec () - start);
+    printf ("%-32s %9u granted\n", "", n_granted);
+
+    start = bench_usec ();
+
+    for (idx = 0; idx < BENCH_IL_REQUESTS / 100; idx++)
+    {
+        seed = seed * 1103515245U + 12345U;
+        rrgidx = base_rrgidx + (seed >> 16) % BENCH_IL_GROUPS;
+        rridx = (seed >> 8) % BENCH_IL_RAILROADS;
+
+        (void) RailroadGroups::railroad_groups[rrgidx].set_active_railroad (rridx);
+    }
+
+    bench_report ("interlock: set route", BENCH_IL_REQUESTS / 100, bench_usec () - start);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * S88 routes: two contacts each set one of two railroads which need a switch in different states. The first contact
+ * is passed by a loco, so its route is locked until the loco arrives at the contact of the target railroad. The route
+ * of the second contact must be refused, also if its loco is unknown. A railroad occupied by a train without known
+ * loco must be refused for manual route setting.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+bench_interlock_s88 (void)
+{
+    CONTACT_ACTION  ca;
+    uint_fast16_t   swidx;
+    uint_fast8_t    rrgidx[4];
+    uint_fast16_t   coidx[4];
+    uint_fast8_t    sub;
+    uint_fast8_t    idx;
+
+    bench_setup_locos (1);
+
+    swidx = Switches::add ({});
+    Switches::switches[swidx].set_addr (swidx + 1);
+
+    for (idx = 0; idx < 4; idx++)                                               // 0, 1: targets, 2, 3: routes set by contact
+    {
+        rrgidx[idx] = RailroadGroups::add ({});
+        (void) RailroadGroups::railroad_groups[rrgidx[idx]].add ({});
+        coidx[idx] = bench_setup_contact (rrgidx[idx], 0);
+    }
+
+    for (idx = 0; idx < 2; idx++)
+    {
+        Railroad *  rr = &RailroadGroups::railroad_groups[rrgidx[idx]].railroads[0];
+
+        sub = rr->add_switch ();
+        rr->set_switch_idx (sub, swidx);
+        rr->set_switch_state (sub, idx == 0 ? DCC_SWITCH_STATE_STRAIGHT : DCC_SWITCH_STATE_BRANCH);
+
+        ca.action           = S88_ACTION_SET_RAILROAD;
+        ca.n_parameters     = 2;
+        ca.parameters[0]    = rrgidx[idx];                                      // RRG_IDX
+        ca.parameters[1]    = 0;                                                // RR_IDX
+        (void) S88::contacts[coidx[idx + 2]].set_contact_action (true, S88::contacts[coidx[idx + 2]].add_contact_action (true), &ca);
+    }
+
+    RailroadGroups::railroad_groups[rrgidx[2]].railroads[0].set_link_loco (0);
+
+    DCC::booster_is_on      = true;
+    DCC::booster_is_on_time = Millis::elapsed () - 4000;                        // no contact actions 3 sec after booster on
+
+    S88::set_newstate_bit (coidx[2], S88_STATE_OCCUPIED);                       // loco 0 passes first contact
+    S88::schedule ();
+    DCC::channel_stopped = 0;
+
+    bench_check ("interlock-s88: first route set", RailroadGroups::railroad_groups[rrgidx[0]].get_active_railroad () == 0 &&
+                 Interlocking::is_locked (rrgidx[0], 0));
+
+    S88::set_newstate_bit (coidx[3], S88_STATE_OCCUPIED);                       // unknown train passes second contact
+    S88::schedule ();
+    DCC::channel_stopped = 0;
+
+    bench_check ("interlock-s88: conflict refused", RailroadGroups::railroad_groups[rrgidx[1]].get_active_railroad () == 0xFF &&
+                 RailroadGroups::railroad_groups[rrgidx[0]].get_active_railroad () == 0 &&
+                 Switches::switches[swidx].get_state () == DCC_SWITCH_STATE_STRAIGHT);
+
+    S88::set_newstate_bit (coidx[0], S88_STATE_OCCUPIED);                       // loco 0 arrives at first target
+    S88::schedule ();
+
+    bench_check ("interlock-s88: lock released", ! Interlocking::is_locked (rrgidx[0], 0));
+
+    S88::set_newstate_bit (coidx[1], S88_STATE_OCCUPIED);                       // train without known loco on second target
+    S88::schedule ();
+    DCC::channel_stopped = 0;
+
+    bench_check ("interlock-s88: occupied refused", Interlocking::request (rrgidx[1], 0, 0xFFFF) == INTERLOCKING_REFUSED_OCCUPIED);
+
+    DCC::booster_is_on = false;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * loco statistics: a full window of refresh intervals, 126 of 100 msec, one of 150 msec and one of 1000 msec. The
+ * outlier of 1000 msec is the window maximum but must not determine p99, which is interpolated between 100 and 150.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+bench_locostats (void)
+{
+    LOCOSTATS_REFRESH   refresh;
+    uint32_t            millis = 1000;
+    uint_fast8_t        idx;
+
+    LocoStats::reset (0);
+    LocoStats::packet_sent (0, LOCOSTATS_GROUP_SPEED, millis);
+
+    for (idx = 0; idx < LOCOSTATS_WINDOW; idx++)
+    {
+        if (idx == 40)
+        {
+            millis += 1000;
+        }
+        else if (idx == 80)
+        {
+            millis += 150;
+        }
+        else
+        {
+            millis += 100;
+        }
+
+        LocoStats::packet_sent (0, LOCOSTATS_GROUP_SPEED, millis);
+    }
+
+    LocoStats::get_refresh (0, LOCOSTATS_GROUP_SPEED, &refresh);
+
+    bench_check ("locostats: p50", refresh.p50 == 100);
+    bench_check ("locostats: p99 below max", refresh.p99 == 136 && refresh.window_max == 1000 && refresh.worst_gap == 1000);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * automation: one contact with 8 in-actions, each executing a loco macro with 16 function actions. An occupied edge
+ * runs 136 instructions and sends 128 DCC commands. Measured is the time from the edge in S88::schedule () to the
+ * last DCC command.
+ *
+ * Every command waits in DCC::send_cmd () for the "continue" of the STM32. A second thread acknowledges it like the
+ * STM32, the waiting time is taken from histogram METRICS_HIST_DCC_STOP_WAIT and subtracted. So the result is the
+ * time spent in FM22 without the DCC transmission, also on a single core.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static volatile bool    bench_auto_running;
+
+static uint32_t
+bench_auto_commands (void)
+{
+    uint32_t        n = 0;
+    uint_fast16_t   cmd;
+
+    for (cmd = 0; cmd < METRICS_DCC_COMMANDS; cmd++)
+    {
+        n += Metrics::get_dcc_commands (cmd);
+    }
+
+    return n;
+}
+
+static void *
+bench_auto_ack (void *)
+{
+    while (bench_auto_running)
+    {
+        if (__atomic_load_n (&DCC::channel_stopped, __ATOMIC_ACQUIRE))
+        {
+            __atomic_store_n (&DCC::channel_stopped, 0, __ATOMIC_RELEASE);
+        }
+
+        sched_yield ();
+    }
+
+    return NULL;
+}
+
+static void
+bench_automation (void)
+{
+    METRICS_HISTOGRAM_VALUES    wait_before;
+    METRICS_HISTOGRAM_VALUES    wait_after;
+    AUTOMATION_STATS            stats_before;
+    AUTOMATION_STATS            stats_after;
+    pthread_t                   thread;
+    CONTACT_ACTION              ca;
+    LOCOACTION                  la;
+    uint_fast16_t               coidx;
+    uint_fast16_t               loco_idx;
+    uint_fast8_t                aidx;
+    uint32_t                    idx;
+    uint32_t                    n_commands;
+    uint64_t                    usec;
+
+    bench_setup_locos (BENCH_AUTO_LOCOS);
+
+    for (loco_idx = 0; loco_idx < BENCH_AUTO_LOCOS; loco_idx++)
+    {
+        while (Locos::locos[loco_idx].get_n_macro_actions (0) < LOCO_MAX_ACTIONS_PER_MACRO)
+        {
+            aidx = Locos::locos[loco_idx].add_macro_action (0);
+
+            la.action           = (aidx & 0x01) ? LOCO_ACTION_SET_LOCO_FUNCTION_OFF : LOCO_ACTION_SET_LOCO_FUNCTION_ON;
+            la.n_parameters     = 2;
+            la.parameters[0]    = 0;                                            // START
+            la.parameters[1]    = aidx / 2;                                     // FUNC_IDX
+            (void) Locos::locos[loco_idx].set_macro_action (0, aidx, &la);
+        }
+    }
+
+    if (RailroadGroups::get_n_railroad_groups () == 0)
+    {
+        uint_fast8_t    rrgidx = RailroadGroups::add ({});
+
+        (void) RailroadGroups::railroad_groups[rrgidx].add ({});
+    }
+
+    if (S88::get_n_contacts () == 0)
+    {
+        (void) S88::add ({});
+    }
+
+    coidx = 0;
+    S88::contacts[coidx].set_link_railroad (0, 0);                              // may be linked by benchmark interlock
+
+    while (S88::contacts[coidx].get_n_contact_actions (true) > 0)
+    {
+        S88::contacts[coidx].delete_contact_action (true, 0);
+    }
+
+    for (loco_idx = 0; loco_idx < BENCH_AUTO_LOCOS; loco_idx++)
+    {
+        aidx = S88::contacts[coidx].add_contact_action (true);
+
+        ca.action           = S88_ACTION_EXECUTE_LOCO_MACRO;
+        ca.n_parameters     = 3;
+        ca.parameters[0]    = 0;                                                // START
+        ca.parameters[1]    = loco_idx;                                         // LOCO_IDX
+        ca.parameters[2]    = 0;                                                // MACRO_IDX
+        (void) S88::contacts[coidx].set_contact_action (true, aidx, &ca);
+    }
+
+    S88::set_newstate_bit (coidx, S88_STATE_FREE);                              // may be occupied by benchmark s88
+    S88::set_state_bit (coidx, S88_STATE_FREE);
+
+    DCC::booster_is_on      = true;
+    DCC::booster_is_on_time = Millis::elapsed () - 4000;                        // no contact actions 3 sec after booster on
+    DCC::channel_stopped    = 0;
+
+    bench_auto_running = true;
+    pthread_create (&thread, NULL, bench_auto_ack, NULL);
+
+    Automation::execute_contact_actions (coidx, true);                          // builds the programs
+
+    Automation::get_stats (&stats_before);
+    Metrics::get_histogram (METRICS_HIST_DCC_STOP_WAIT, &wait_before);
+    n_commands  = bench_auto_commands ();
+    usec        = 0;
+
+    for (idx = 0; idx < BENCH_AUTO_TRIGGERS; idx++)
+    {
+        uint64_t    start = bench_usec ();
+
+        S88::set_newstate_bit (coidx, S88_STATE_OCCUPIED);
+        S88::schedule ();
+        usec += bench_usec () - start;
+
+        S88::set_newstate_bit (coidx, S88_STATE_FREE);
+        S88::schedule ();
+    }
+
+    Metrics::get_histogram (METRICS_HIST_DCC_STOP_WAIT, &wait_after);
+    Automation::get_stats (&stats_after);
+    n_commands = bench_auto_commands () - n_commands;
+
+    bench_auto_running = false;
+    pthread_join (thread, NULL);
+    DCC::booster_is_on      = false;
+    DCC::channel_stopped    = 0;
+
+    usec -= wait_after.sum - wait_before.sum;                                   // free edges send nothing
+
+    bench_report ("automation: trigger -> last cmd", BENCH_AUTO_TRIGGERS, usec);
+    printf ("%-32s %9u instructions, %u commands per trigger, %.3f usec/instruction\n", "",
+            (stats_after.n_executed - stats_before.n_executed) / BENCH_AUTO_TRIGGERS, n_commands / BENCH_AUTO_TRIGGERS,
+            (double) usec / (stats_after.n_executed - stats_before.n_executed));
+}
+
+static const BENCH benches[] =
+{
+    { "http",           "render and send loco list for 1024 locos, poll action",               bench_http          },
+    { "locos",          "scheduler passes over 1024 locos",                                    bench_locos         },
+    { "ini",            "render and write loco.ini and snapshot with 1024 locos",              bench_ini           },
+    { "s88",            "edge scan over 1024 contacts, 0% and 1% changes per pass",            bench_s88           },
+    { "interlock",      "conflict matrix build, route requests and activation, 256 routes",    bench_interlock     },
+    { "interlock-s88",  "check: conflicting routes set by S88 contacts are refused",           bench_interlock_s88 },
+    { "locostats",      "check: p50 and p99 of refresh intervals with a known distribution",   bench_locostats     },
+    { "automation",     "trigger to command latency, 8 macros with 16 actions per contact",    bench_automation    },
+};
+
+#define N_BENCHES   (sizeof (benches) / sizeof (benches[0]))
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * main () - run benchmarks given as arguments, all if none
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+int
+main (int argc, char ** argv)
+{
+    uint_fast8_t    idx;
+    int             argi;
+
+    Debug::set_level (DEBUG_LEVEL_NONE);
+
+    for (argi = 1; argi < argc; argi++)
+    {
+        for (idx = 0; idx < N_BENCHES; idx++)
+        {
+            if (! strcmp (argv[argi], benches[idx].name))
+            {
+                break;
+            }
+        }
+
+        if (idx == N_BENCHES)
+        {
+            fprintf (stderr, "usage: %s [name ...]\n", argv[0]);
+
+            for (idx = 0; idx < N_BENCHES; idx++)
+            {
+                fprintf (stderr, "  %-14s %s\n", benches[idx].name, benches[idx].description);
+            }
+
+            return 1;
+        }
+    }
+
+    for (idx = 0; idx < N_BENCHES; idx++)
+    {
+        for (argi = 1; argi < argc; argi++)
+        {
+            if (! strcmp (argv[argi], benches[idx].name))
+            {
+                break;
+            }
+        }
+
+        if (argc == 1 || argi < argc)
+        {
+            (*benches[idx].func) ();
+        }
+    }
+
+    return bench_n_failed ? 1 : 0;
+}
@@ -29,6 +29,7 @@
 #include "millis.h"
 #include "debug.h"
 #include "msg.h"
+#include "metrics.h"
 
 #define CMD_FRAME_START                 0xFF            // Start of Text
 #define CMD_FRAME_END                   0xFE            // End of Text
@@ -101,6 +102,7 @@ DCC::send_cmd (uint8_t * buf, uint_fast8_t len, bool set_flag_stopped)
 
     if (DCC::channel_stopped)
     {
+        uint32_t    start = Metrics::micros ();
         uint32_t    idx;
 
         for (idx = 0; idx < 100 && DCC::channel_stopped; idx++)             // wait 100 msec for message "continue"
@@ -109,13 +111,18 @@ DCC::send_cmd (uint8_t * buf, uint_fast8_t len, bool set_flag_stopped)
             MSG::read_msg ();
         } 
 
-        if (idx == 500)
+        Metrics::observe (METRICS_HIST_DCC_STOP_WAIT, Metrics::micros () - start);
+
+        if (DCC::channel_stopped)
         {
             Debug::printf (DEBUG_LEVEL_NORMAL, "dcc channel stop timeout, let's continue\n");
+            Metrics::count (METRICS_COUNTER_DCC_STOP_TIMEOUTS);
             DCC::channel_stopped = 0;
         }
     }
 
+    Metrics::dcc_command (buf[0]);
+
     Serial::send (CMD_FRAME_START);
     Serial::send (len);
 
@@ -140,6 +147,50 @@ DCC::send_cmd (uint8_t * buf, uint_fast8_t len, bool set_flag_stopped)
     }
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_cmd_name () - get name of command, returns NULL if unknown
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+const char *
+DCC::get_cmd_name (uint_fast8_t cmd)
+{
+    switch (cmd)
+    {
+        case CMD_BOOSTER_ON:                return "booster_on";
+        case CMD_BOOSTER_OFF:               return "booster_off";
+        case CMD_SET_MODE:                  return "set_mode";
+        case CMD_SET_SHORTCUT:              return "set_shortcut";
+        case CMD_PGM_READ_CV:               return "pgm_read_cv";
+        case CMD_PGM_WRITE_CV:              return "pgm_write_cv";
+        case CMD_PGM_WRITE_CV_BIT:          return "pgm_write_cv_bit";
+        case CMD_PGM_WRITE_ADDRESS:         return "pgm_write_address";
+        case CMD_POM_READ_CV:               return "pom_read_cv";
+        case CMD_XPOM_READ_CV:              return "xpom_read_cv";
+        case CMD_POM_WRITE_CV:              return "pom_write_cv";
+        case CMD_POM_WRITE_CV_BIT:          return "pom_write_cv_bit";
+        case CMD_POM_WRITE_ADDRESS:         return "pom_write_address";
+        case CMD_LOCO_28:                   return "loco_28";
+        case CMD_LOCO_FUNCTION_F00_F04:     return "loco_function_f00_f04";
+        case CMD_LOCO_FUNCTION_F05_F08:     return "loco_function_f05_f08";
+        case CMD_LOCO_FUNCTION_F09_F12:     return "loco_function_f09_f12";
+        case CMD_LOCO_FUNCTION_F13_F20:     return "loco_function_f13_f20";
+        case CMD_LOCO_FUNCTION_F21_F28:     return "loco_function_f21_f28";
+        case CMD_LOCO:                      return "loco";
+        case CMD_LOCO_RC2_RATE:             return "loco_rc2_rate";
+        case CMD_RESET:                     return "reset";
+        case CMD_STOP:                      return "stop";
+        case CMD_ESTOP:                     return "estop";
+        case CMD_RESET_DECODER:             return "reset_decoder";
+        case CMD_HARD_RESET_DECODER:        return "hard_reset_decoder";
+        case CMD_GET_ACK:                   return "get_ack";
+        case CMD_BASE_SWITCH_SET:           return "base_switch_set";
+        case CMD_BASE_SWITCH_RESET:         return "base_switch_reset";
+        case CMD_EXT_ACCESSORY_SET:         return "ext_accessory_set";
+        case CMD_S88_SET_N_CONTACTS:        return "s88_set_n_contacts";
+        default:                            return (const char *) NULL;
+    }
+}
+
 /*------------------------------------------------------------------------------------------------------------------------
  * booster_off () - switch booster off
  *------------------------------------------------------------------------------------------------------------------------
@@ -214,6 +265,9 @@ DCC::pgm_read_cv (uint_fast8_t * cv_valuep, uint_fast16_t cv)
     buf[1] = cv >> 8;
     buf[2] = cv & 0xFF;
 
+    uint32_t        start = Metrics::micros ();
+    uint_fast8_t    rtc = 0;
+
     send_cmd (buf, 3, true);
 
     pgm_cv.valid = 0;
@@ -229,13 +283,22 @@ DCC::pgm_read_cv (uint_fast8_t * cv_valuep, uint_fast16_t cv)
             if (pgm_cv.cv == cv)
             {
                 *cv_valuep = pgm_cv.cv_value;
-                return 1;
+                rtc = 1;
+                break;
             }
         }
         usleep (1000);  // sleep one millisecond        
     }
 
-    return 0;
+    Metrics::observe (METRICS_HIST_PGM_READ, Metrics::micros () - start);
+    Metrics::count (METRICS_COUNTER_PGM_READS);
+
+    if (! rtc)
+    {
+        Metrics::count (METRICS_COUNTER_PGM_FAILURES);
+    }
+
+    return rtc;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -649,10 +712,37 @@ DCC::base_switch_set (uint_fast16_t addr, uint_fast8_t nswitch)
     send_cmd (buf, 4, true);
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ * base_switch_set () - activate rail switch for pulse msec, 0: default of DCC controller
+ *
+ * Without pulse the short command is sent, which older DCC controllers understand, too.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+DCC::base_switch_set (uint_fast16_t addr, uint_fast8_t nswitch, uint_fast16_t pulse)
+{
+    uint8_t         buf[6];
+
+    if (pulse == 0)
+    {
+        DCC::base_switch_set (addr, nswitch);
+        return;
+    }
+
+    buf[0] = CMD_BASE_SWITCH_SET;
+    buf[1] = addr >> 8;
+    buf[2] = addr & 0xFF;
+    buf[3] = nswitch;
+    buf[4] = pulse >> 8;
+    buf[5] = pulse & 0xFF;
+
+    send_cmd (buf, 6, true);
+}
+
 /*------------------------------------------------------------------------------------------------------------------------
  * base_switch_reset () - deactivate rail switch (base accessory decoder)
  *
- * This function is not used. The DCC controller currently deactivates the switch after a short time.
+ * This function is not used. The DCC controller deactivates the switch after its pulse.
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
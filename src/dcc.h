@@ -112,10 +112,12 @@ class DCC
         static void             pom_write_cv_bit (uint_fast16_t addr, uint16_t cv, uint_fast8_t bitpos, uint_fast8_t value);
         static void             get_ack (uint_fast16_t addr);
         static void             base_switch_set (uint_fast16_t addr, uint_fast8_t nswitch);
+        static void             base_switch_set (uint_fast16_t addr, uint_fast8_t nswitch, uint_fast16_t pulse);
         static void             base_switch_reset (uint_fast16_t addr, uint_fast8_t nswitch);
         static void             ext_accessory_set (uint_fast16_t addr, uint_fast8_t value);
         static void             set_shortcut_value (uint_fast16_t shortcut_value);
         static void             set_s88_n_contacts (uint_fast16_t n_s88_contacts);
+        static const char *     get_cmd_name (uint_fast8_t cmd);
         static void             init (void);
 
     private:
@@ -20,10 +20,221 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdint.h>
+#include <string.h>
+#include <strings.h>
 #include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
 #include "debug.h"
 
-uint_fast8_t    Debug::debug_level  = 0;
+uint8_t                 Debug::levels[DEBUG_SUBSYSTEMS];                            // level per subsystem, see DEBUG_TRACE ()
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * Trace messages are recorded as binary records in a ring buffer: timestamp, format string and integer arguments.
+ * Producers reserve a slot by incrementing trace_head, so recording needs no lock and no system call except for
+ * the timestamp. A background thread formats the records and writes them to stdout. If the ring buffer is full,
+ * the record is dropped and counted, the caller never waits.
+ *
+ * The sequence number of a slot tells its state relative to base = pos & ~(DEBUG_TRACE_SLOTS - 1):
+ * base: free for writing, base + 1: written, base + DEBUG_TRACE_SLOTS: read, free for the next round.
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static DEBUG_TRACE_RECORD       trace_ring[DEBUG_TRACE_SLOTS];
+static std::atomic<uint32_t>    trace_head (0);                                     // next slot to write
+static uint32_t                 trace_tail = 0;                                     // next slot to format, only used by reader
+static std::atomic<uint32_t>    trace_n_records (0);
+static std::atomic<uint32_t>    trace_n_dropped (0);
+static pthread_t                trace_thread;
+static bool                     trace_thread_active = false;
+static std::atomic<bool>        trace_stop (false);
+
+static const char *             subsystem_names[DEBUG_SUBSYSTEMS] =
+{
+    "general", "dcc", "msg", "s88", "rcl"
+};
+
+#define TRACE_IDLE_USEC         20000                                               // reader sleeps 20 msec if ring buffer is empty
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * record () - record trace message in ring buffer
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Debug::record (uint_fast8_t subsystem, const char * fmt, uint_fast8_t n_args, const uint32_t * args)
+{
+    DEBUG_TRACE_RECORD *    rp;
+    struct timeval          tv;
+    uint32_t                pos = trace_head.load (std::memory_order_relaxed);
+
+    while (1)
+    {
+        int32_t dif;
+
+        rp  = &trace_ring[pos & (DEBUG_TRACE_SLOTS - 1)];
+        dif = (int32_t) (rp->seq.load (std::memory_order_acquire) - (pos & ~(DEBUG_TRACE_SLOTS - 1)));
+
+        if (dif == 0)
+        {
+            if (trace_head.compare_exchange_weak (pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (dif < 0)                                                           // ring buffer full
+        {
+            trace_n_dropped.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            pos = trace_head.load (std::memory_order_relaxed);
+        }
+    }
+
+    gettimeofday (&tv, NULL);
+    rp->sec         = tv.tv_sec;
+    rp->usec        = tv.tv_usec;
+    rp->subsystem   = subsystem;
+    rp->n_args      = n_args;
+    rp->fmt         = fmt;
+    memcpy (rp->args, args, DEBUG_TRACE_MAX_ARGS * sizeof (uint32_t));
+    rp->seq.store ((pos & ~(DEBUG_TRACE_SLOTS - 1)) + 1, std::memory_order_release);
+
+    trace_n_records.fetch_add (1, std::memory_order_relaxed);
+
+    if (! trace_thread_active)                                                      // no reader: format synchronously
+    {
+        while (Debug::format_next ())
+        {
+            ;
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * format_next () - format and print next record, return false if ring buffer is empty
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+Debug::format_next (void)
+{
+    DEBUG_TRACE_RECORD *    rp      = &trace_ring[trace_tail & (DEBUG_TRACE_SLOTS - 1)];
+    uint32_t                base    = trace_tail & ~(DEBUG_TRACE_SLOTS - 1);
+    time_t                  sec;
+    struct tm               tm;
+    uint32_t *              a;
+
+    if (rp->seq.load (std::memory_order_acquire) != base + 1)
+    {
+        return false;
+    }
+
+    sec = rp->sec;
+    localtime_r (&sec, &tm);
+    a = rp->args;
+
+    ::printf ("%04d-%02d-%02d %02d:%02d:%02d.%03u: ", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+              (unsigned int) (rp->usec / 1000));
+#pragma GCC diagnostic push                                                          // fmt was checked at the call site, see DEBUG_TRACE
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+    ::printf (rp->fmt, a[0], a[1], a[2], a[3], a[4], a[5]);                         // surplus arguments are ignored
+#pragma GCC diagnostic pop
+
+    rp->seq.store (base + DEBUG_TRACE_SLOTS, std::memory_order_release);
+    trace_tail++;
+    return true;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * reader () - background thread, formats trace records
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void *
+Debug::reader (void *)
+{
+    while (1)
+    {
+        bool    formatted = false;
+
+        while (Debug::format_next ())
+        {
+            formatted = true;
+        }
+
+        if (formatted)
+        {
+            fflush (stdout);
+        }
+        else if (trace_stop.load ())
+        {
+            break;
+        }
+        else
+        {
+            usleep (TRACE_IDLE_USEC);
+        }
+    }
+
+    return NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * init () - initialize ring buffer and start background thread
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Debug::init (void)
+{
+    if (trace_thread_active)
+    {
+        return;
+    }
+
+    while (Debug::format_next ())                                                   // flush records of synchronous mode
+    {
+        ;
+    }
+
+    if (pthread_create (&trace_thread, NULL, Debug::reader, NULL) == 0)
+    {
+        trace_thread_active = true;
+    }
+    else
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "Debug: cannot start trace thread, tracing synchronously\n");
+    }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * deinit () - print pending records and stop background thread
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Debug::deinit (void)
+{
+    if (trace_thread_active)
+    {
+        trace_stop.store (true);
+        pthread_join (trace_thread, NULL);
+        trace_thread_active = false;
+        trace_stop.store (false);
+    }
+
+    fflush (stdout);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * get_trace_stats () - get statistics of trace
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Debug::get_trace_stats (DEBUG_TRACE_STATS * statsp)
+{
+    statsp->n_records   = trace_n_records.load (std::memory_order_relaxed);
+    statsp->n_dropped   = trace_n_dropped.load (std::memory_order_relaxed);
+}
 
 /*-------------------------------------------------------------------------------------------------------------------------------------------
  * set_level () - set debug level
@@ -32,7 +243,33 @@ uint_fast8_t    Debug::debug_level  = 0;
 void
 Debug::set_level (uint_fast8_t level)
 {
-    Debug::debug_level = level;
+    uint_fast8_t    idx;
+
+    for (idx = 0; idx < DEBUG_SUBSYSTEMS; idx++)
+    {
+        Debug::levels[idx] = level;
+    }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * set_level () - set debug level of subsystem, return false if subsystem is unknown
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+Debug::set_level (const char * subsystem_name, uint_fast8_t level)
+{
+    uint_fast8_t    idx;
+
+    for (idx = 0; idx < DEBUG_SUBSYSTEMS; idx++)
+    {
+        if (! strcasecmp (subsystem_name, subsystem_names[idx]))
+        {
+            Debug::levels[idx] = level;
+            return true;
+        }
+    }
+
+    return false;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------------------------------
@@ -42,7 +279,7 @@ Debug::set_level (uint_fast8_t level)
 void
 Debug::puts (uint_fast8_t level, const char * s)
 {
-    if (debug_level >= level)
+    if (Debug::levels[DEBUG_SUBSYSTEM_GENERAL] >= level)
     {
         time_t  now = time ((time_t *) NULL);
         struct  tm * tmp = localtime (&now);
@@ -61,7 +298,7 @@ Debug::printf (uint_fast8_t level, const char * fmt, ...)
 {
     int len = 0;
 
-    if (debug_level >= level)
+    if (Debug::levels[DEBUG_SUBSYSTEM_GENERAL] >= level)
     {
         time_t  now = time ((time_t *) NULL);
         struct  tm * tmp = localtime (&now);
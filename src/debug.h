@@ -20,19 +20,85 @@
 #ifndef DEBUG_H
 #define DEBUG_H
 #include <stdint.h>
+#include <atomic>
+#include <type_traits>
 
 #define DEBUG_LEVEL_NONE    0
 #define DEBUG_LEVEL_NORMAL  1
 #define DEBUG_LEVEL_VERBOSE 2
 
+#define DEBUG_SUBSYSTEM_GENERAL     0                                           // Debug::printf ()
+#define DEBUG_SUBSYSTEM_DCC         1                                           // loco and addon packets
+#define DEBUG_SUBSYSTEM_MSG         2                                           // messages from STM32
+#define DEBUG_SUBSYSTEM_S88         3                                           // S88 contacts
+#define DEBUG_SUBSYSTEM_RCL         4                                           // RailCom locations
+#define DEBUG_SUBSYSTEMS            5                                           // number of subsystems
+
+#define DEBUG_TRACE_SLOTS           4096                                        // size of ring buffer, must be a power of 2
+#define DEBUG_TRACE_MAX_ARGS        6                                           // max number of integer arguments
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * DEBUG_TRACE () - record a trace message. The arguments are only evaluated if the level of the subsystem is active.
+ * Only integer arguments are allowed, fmt must be a string literal: it is stored as pointer and formatted later.
+ * Debug::trace_check () is never executed, it lets the compiler check fmt against the arguments at the call site.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#define DEBUG_TRACE(subsystem, level, fmt, ...)                                 \
+    do                                                                          \
+    {                                                                           \
+        if (0)                                                                  \
+        {                                                                       \
+            Debug::trace_check (fmt, ##__VA_ARGS__);                            \
+        }                                                                       \
+        if (Debug::levels[subsystem] >= (level))                                \
+        {                                                                       \
+            Debug::trace (subsystem, fmt, ##__VA_ARGS__);                       \
+        }                                                                       \
+    } while (0)
+
+typedef struct
+{
+    std::atomic<uint32_t>   seq;                                                // sequence number of slot
+    uint32_t                sec;                                                // timestamp
+    uint32_t                usec;
+    uint8_t                 subsystem;
+    uint8_t                 n_args;
+    const char *            fmt;                                                // format string, identifies call site
+    uint32_t                args[DEBUG_TRACE_MAX_ARGS];
+} DEBUG_TRACE_RECORD;
+
+typedef struct
+{
+    uint32_t                n_records;                                          // number of recorded trace messages
+    uint32_t                n_dropped;                                          // dropped because ring buffer was full
+} DEBUG_TRACE_STATS;
+
 class Debug
 {
     public:
+        static uint8_t      levels[DEBUG_SUBSYSTEMS];
+
+        static void         init (void);
+        static void         deinit (void);
         static void         set_level (uint_fast8_t level);
+        static bool         set_level (const char * subsystem_name, uint_fast8_t level);
         static void         puts (uint_fast8_t level, const char * s);
         static int          printf (uint_fast8_t level, const char * fmt, ...);
+        static void         get_trace_stats (DEBUG_TRACE_STATS * statsp);
+        static void         trace_check (const char *, ...) __attribute__ ((format (printf, 1, 2))) {}
+
+        template <typename... Args>
+        static void         trace (uint_fast8_t subsystem, const char * fmt, Args... args)
+                            {
+                                static_assert (sizeof... (args) <= DEBUG_TRACE_MAX_ARGS, "DEBUG_TRACE: too many arguments");
+                                static_assert ((std::is_integral<Args>::value && ...), "DEBUG_TRACE: only integer arguments allowed");
+                                uint32_t a[DEBUG_TRACE_MAX_ARGS] = { (uint32_t) args... };
+                                Debug::record (subsystem, fmt, sizeof... (args), a);
+                            }
     private:
-        static uint_fast8_t debug_level;
+        static void         record (uint_fast8_t subsystem, const char * fmt, uint_fast8_t n_args, const uint32_t * args);
+        static bool         format_next (void);
+        static void *       reader (void *);
 };
 
 #endif
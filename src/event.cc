@@ -18,6 +18,7 @@
  *------------------------------------------------------------------------------------------------------------------------
  */
 #include <stdint.h>
+#include <algorithm>
 
 #include "millis.h"
 #include "event.h"
@@ -27,345 +28,344 @@
 #include "switch.h"
 #include "sig.h"
 #include "s88.h"
+#include "automation.h"
+#include "fm22.h"
 #include "debug.h"
 
-EVENTS                  Event::event_buffer[EVENT_LEN];                             // event ringbuffer
-uint_fast16_t           Event::event_size      = 0;                                 // current event size
+std::vector<EVENTS>     Event::slots;                                               // events, millis == 0: free slot
+std::vector<uint64_t>   Event::slot_keys;                                           // key of event in slot
+std::vector<uint32_t>   Event::slot_heap_pos;                                       // position of slot in heap
+std::vector<uint32_t>   Event::free_slots;                                          // free slots
+std::vector<uint32_t>   Event::heap;                                                // pending events, min-heap on millis
+std::unordered_multimap<uint64_t, uint32_t> Event::index;                           // key -> slot
+EVENT_STATS             Event::stats;                                               // statistics
 
-uint_fast16_t
-Event::get_free_slot_loco_function (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t f, bool b)
+/*------------------------------------------------------------------------------------------------------------------------
+ * Pending events are kept in slots which are allocated on demand up to EVENT_MAX_LEN. A min-heap of slot indexes sorted
+ * by due time lets schedule() look only at events which are due. Identical events (same type, same tenths, same
+ * parameters) are found by a hash index: adding such an event again only restarts its delay.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_payload () - get parameters of event as one number, all parameters identify an event
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint64_t
+Event::get_payload (EVENTS * ep)
 {
-    uint_fast16_t   idx;
-    uint_fast16_t   empty_idx   = 0xFFFF;
-    uint_fast16_t   len         = Event::event_size;
-    uint_fast16_t   rtc         = 0xFFFF;
+    uint64_t    payload = 0;
 
-    for (idx = 0; len > 0 && idx < EVENT_LEN; idx++)
+    switch (ep->type)
     {
-        if (Event::event_buffer[idx].millis == 0)
+        case EVENT_TYPE_LOCO_FUNCTION:
         {
-            if (empty_idx == 0xFFFF)
-            {
-                empty_idx = idx;
-            }
+            payload = ep->loco_func.loco_idx | ((uint64_t) ep->loco_func.f << 16) | ((uint64_t) ep->loco_func.b << 24);
+            break;
         }
-        else
-        {
-            if (Event::event_buffer[idx].tenths == tenths && Event::event_buffer[idx].type == EVENT_TYPE_LOCO_FUNCTION)                                  // find double entry...
-            {
-                if (Event::event_buffer[idx].loco_func.loco_idx == loco_idx &&
-                    Event::event_buffer[idx].loco_func.f == f &&
-                    Event::event_buffer[idx].loco_func.b == b)
-                {
-                    rtc = idx;
-                    break;
-                }
-            }
 
-            len--;
+        case EVENT_TYPE_LOCO_SPEED:
+        {
+            payload = ep->loco_speed.loco_idx | ((uint64_t) ep->loco_speed.type << 16) | ((uint64_t) ep->loco_speed.sp << 24) | ((uint64_t) ep->loco_speed.ramp << 32);
+            break;
         }
-    }
 
-    if (rtc == 0xFFFF)
-    {
-        if (empty_idx != 0xFFFF)
+        case EVENT_TYPE_LOCO_DIR:
         {
-            rtc = empty_idx;
+            payload = ep->loco_dir.loco_idx | ((uint64_t) ep->loco_dir.fwd << 16);
+            break;
         }
-        else if (idx < EVENT_LEN)
+
+        case EVENT_TYPE_ADDON_FUNCTION:
         {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                rtc = idx;
-            }
-            else
-            {
-                Debug::printf (DEBUG_LEVEL_NONE, "Internal error in get_free_slot_loco_function(), idx=%u\n", (unsigned int) idx);
-            }
+            payload = ep->addon_func.addon_idx | ((uint64_t) ep->addon_func.f << 16) | ((uint64_t) ep->addon_func.b << 24);
+            break;
         }
-    }
-
-    return rtc;
-}
-
-uint_fast16_t
-Event::get_free_slot_loco_speed (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t speed_type, uint_fast8_t speed, uint_fast16_t ramp)
-{
-    uint_fast16_t   idx;
-    uint_fast16_t   empty_idx   = 0xFFFF;
-    uint_fast16_t   len         = Event::event_size;
-    uint_fast16_t   rtc         = 0xFFFF;
 
-    for (idx = 0; len > 0 && idx < EVENT_LEN; idx++)
-    {
-        if (Event::event_buffer[idx].millis == 0)
+        case EVENT_TYPE_WAIT_S88:
         {
-            if (empty_idx == 0xFFFF)
-            {
-                empty_idx = idx;
-            }
+            payload = ep->wait_s88.loco_idx | ((uint64_t) ep->wait_s88.sp << 16) | ((uint64_t) ep->wait_s88.ramp << 24) | ((uint64_t) ep->wait_s88.coidx << 40);
+            break;
         }
-        else
+
+        case EVENT_TYPE_EXECUTE_LOCO_MACRO:
         {
-            if (Event::event_buffer[idx].tenths == tenths && Event::event_buffer[idx].type == EVENT_TYPE_LOCO_SPEED)                                 // find double entry...
-            {
-                if (Event::event_buffer[idx].loco_speed.loco_idx == loco_idx &&
-                    Event::event_buffer[idx].loco_speed.type == speed_type &&
-                    Event::event_buffer[idx].loco_speed.sp == speed &&
-                    Event::event_buffer[idx].loco_speed.ramp == ramp)
-                {
-                    rtc = idx;
-                    break;
-                }
-            }
+            payload = ep->loco_macro.loco_idx | ((uint64_t) ep->loco_macro.m << 16);
+            break;
+        }
 
-            len--;
+        case EVENT_TYPE_LED_SET_STATE:
+        {
+            payload = ep->led_state.led_group_idx | ((uint64_t) ep->led_state.ledmask << 16) | ((uint64_t) ep->led_state.ledon << 24);
+            break;
         }
-    }
 
-    if (rtc == 0xFFFF)
-    {
-        if (empty_idx != 0xFFFF)
+        case EVENT_TYPE_SWITCH_SET_STATE:
         {
-            rtc = empty_idx;
+            payload = ep->switch_state.swidx | ((uint64_t) ep->switch_state.swstate << 16);
+            break;
         }
-        else if (idx < EVENT_LEN)
+
+        case EVENT_TYPE_SIGNAL_SET_STATE:
         {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                rtc = idx;
-            }
-            else
-            {
-                Debug::printf (DEBUG_LEVEL_NONE, "Internal error in get_free_slot_loco_speed(), idx=%u\n", (unsigned int) idx);
-            }
+            payload = ep->signal_state.sigidx | ((uint64_t) ep->signal_state.sigstate << 16);
+            break;
         }
     }
 
-    return rtc;
+    return payload;
 }
 
-uint_fast16_t
-Event::get_free_slot_loco_dir (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t fwd)
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_key () - get hash key of event
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint64_t
+Event::get_key (EVENTS * ep)
 {
-    uint_fast16_t   idx;
-    uint_fast16_t   empty_idx   = 0xFFFF;
-    uint_fast16_t   len         = Event::event_size;
-    uint_fast16_t   rtc         = 0xFFFF;
+    return Event::get_payload (ep) ^ ((uint64_t) ep->type << 56) ^ ((uint64_t) ep->tenths * 0x9E3779B97F4A7C15ULL);
+}
 
-    for (idx = 0; len > 0 && idx < EVENT_LEN; idx++)
-    {
-        if (Event::event_buffer[idx].millis == 0)
-        {
-            if (empty_idx == 0xFFFF)
-            {
-                empty_idx = idx;
-            }
-        }
-        else
-        {
-            if (Event::event_buffer[idx].tenths == tenths && Event::event_buffer[idx].type == EVENT_TYPE_LOCO_DIR)                                   // find double entry...
-            {
-                if (Event::event_buffer[idx].loco_dir.loco_idx == loco_idx &&
-                    Event::event_buffer[idx].loco_dir.fwd == fwd)
-                {
-                    rtc = idx;
-                    break;
-                }
-            }
+/*------------------------------------------------------------------------------------------------------------------------
+ * is_same () - check if event in slot is identical to event, ignoring the due time
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+Event::is_same (uint32_t slot, EVENTS * ep)
+{
+    EVENTS *    sp = &Event::slots[slot];
 
-            len--;
-        }
-    }
+    return sp->type == ep->type && sp->tenths == ep->tenths && Event::get_payload (sp) == Event::get_payload (ep);
+}
 
-    if (rtc == 0xFFFF)
+/*------------------------------------------------------------------------------------------------------------------------
+ * heap_up () - move heap entry up until its parent is due earlier
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::heap_up (uint32_t pos)
+{
+    uint32_t    slot    = Event::heap[pos];
+    uint32_t    millis  = Event::slots[slot].millis;
+
+    while (pos > 0)
     {
-        if (empty_idx != 0xFFFF)
-        {
-            rtc = empty_idx;
-        }
-        else if (idx < EVENT_LEN)
+        uint32_t    parent = (pos - 1) / 2;
+
+        if (Event::slots[Event::heap[parent]].millis <= millis)
         {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                rtc = idx;
-            }
-            else
-            {
-                Debug::printf (DEBUG_LEVEL_NONE, "Internal error in get_free_slot_loco_dir(), idx=%u\n", (unsigned int) idx);
-            }
+            break;
         }
+
+        Event::heap[pos] = Event::heap[parent];
+        Event::slot_heap_pos[Event::heap[pos]] = pos;
+        pos = parent;
     }
 
-    return rtc;
+    Event::heap[pos] = slot;
+    Event::slot_heap_pos[slot] = pos;
 }
 
-uint_fast16_t
-Event::get_free_slot_addon_function (uint16_t tenths, uint_fast16_t addon_idx, uint_fast8_t f, bool b)
+/*------------------------------------------------------------------------------------------------------------------------
+ * heap_down () - move heap entry down until its children are due later
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::heap_down (uint32_t pos)
 {
-    uint_fast16_t   idx;
-    uint_fast16_t   empty_idx   = 0xFFFF;
-    uint_fast16_t   len         = Event::event_size;
-    uint_fast16_t   rtc         = 0xFFFF;
+    uint32_t    size    = Event::heap.size ();
+    uint32_t    slot    = Event::heap[pos];
+    uint32_t    millis  = Event::slots[slot].millis;
 
-    for (idx = 0; len > 0 && idx < EVENT_LEN; idx++)
+    while (1)
     {
-        if (Event::event_buffer[idx].millis == 0)
-        {
-            if (empty_idx == 0xFFFF)
-            {
-                empty_idx = idx;
-            }
-        }
-        else
-        {
-            if (Event::event_buffer[idx].tenths == tenths && Event::event_buffer[idx].type == EVENT_TYPE_ADDON_FUNCTION)                                  // find double entry...
-            {
-                if (Event::event_buffer[idx].addon_func.addon_idx == addon_idx &&
-                    Event::event_buffer[idx].addon_func.f == f &&
-                    Event::event_buffer[idx].addon_func.b == b)
-                {
-                    rtc = idx;
-                    break;
-                }
-            }
+        uint32_t    child = 2 * pos + 1;
 
-            len--;
+        if (child >= size)
+        {
+            break;
         }
-    }
 
-    if (rtc == 0xFFFF)
-    {
-        if (empty_idx != 0xFFFF)
+        if (child + 1 < size && Event::slots[Event::heap[child + 1]].millis < Event::slots[Event::heap[child]].millis)
         {
-            rtc = empty_idx;
+            child++;
         }
-        else if (idx < EVENT_LEN)
+
+        if (millis <= Event::slots[Event::heap[child]].millis)
         {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                rtc = idx;
-            }
-            else
-            {
-                Debug::printf (DEBUG_LEVEL_NONE, "Internal error in get_free_slot_addon_function(), idx=%u\n", (unsigned int) idx);
-            }
+            break;
         }
+
+        Event::heap[pos] = Event::heap[child];
+        Event::slot_heap_pos[Event::heap[pos]] = pos;
+        pos = child;
     }
 
-    return rtc;
+    Event::heap[pos] = slot;
+    Event::slot_heap_pos[slot] = pos;
 }
 
-uint_fast16_t
-Event::get_free_slot_wait_s88 (uint16_t tenths, uint_fast16_t coidx, uint_fast16_t loco_idx, uint_fast8_t speed, uint_fast16_t ramp)
+/*------------------------------------------------------------------------------------------------------------------------
+ * heap_push () - insert slot into heap
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::heap_push (uint32_t slot)
+{
+    Event::heap.push_back (slot);
+    Event::heap_up (Event::heap.size () - 1);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * insert () - insert event due at ep->millis or change due time of identical pending event
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::insert (EVENTS * ep)
 {
-    uint_fast16_t   idx;
-    uint_fast16_t   empty_idx   = 0xFFFF;
-    uint_fast16_t   len         = Event::event_size;
-    uint_fast16_t   rtc         = 0xFFFF;
+    uint64_t    key = Event::get_key (ep);
+    uint32_t    slot;
+    auto        range = Event::index.equal_range (key);
+
+    if (ep->millis == 0)                                                            // 0 marks a free slot
+    {
+        ep->millis = 1;
+    }
 
-    for (idx = 0; len > 0 && idx < EVENT_LEN; idx++)
+    for (auto it = range.first; it != range.second; it++)
     {
-        if (Event::event_buffer[idx].millis == 0)
+        slot = it->second;
+
+        if (Event::is_same (slot, ep))                                              // find double entry...
         {
-            if (empty_idx == 0xFFFF)
+            uint32_t    old_millis  = Event::slots[slot].millis;
+
+            Event::slots[slot].millis = ep->millis;
+
+            if (ep->millis < old_millis)
             {
-                empty_idx = idx;
+                Event::heap_up (Event::slot_heap_pos[slot]);
             }
-        }
-        else
-        {
-            if (Event::event_buffer[idx].tenths == tenths && Event::event_buffer[idx].type == EVENT_TYPE_WAIT_S88)                              // find double entry...
+            else
             {
-                if (Event::event_buffer[idx].wait_s88.loco_idx == loco_idx &&
-                    Event::event_buffer[idx].wait_s88.sp == speed &&
-                    Event::event_buffer[idx].wait_s88.ramp == ramp &&
-                    Event::event_buffer[idx].wait_s88.coidx == coidx)
-                {
-                    rtc = idx;
-                    break;
-                }
+                Event::heap_down (Event::slot_heap_pos[slot]);
             }
 
-            len--;
+            Event::stats.n_merged++;
+            return;
         }
     }
 
-    if (rtc == 0xFFFF)
+    if (Event::free_slots.size () > 0)
     {
-        if (empty_idx != 0xFFFF)
-        {
-            rtc = empty_idx;
-        }
-        else if (idx < EVENT_LEN)
+        slot = Event::free_slots.back ();
+        Event::free_slots.pop_back ();
+    }
+    else if (Event::slots.size () < EVENT_MAX_LEN)
+    {
+        slot = Event::slots.size ();
+        Event::slots.push_back ({});
+        Event::slot_keys.push_back (0);
+        Event::slot_heap_pos.push_back (0);
+    }
+    else
+    {
+        if (Event::stats.n_dropped == 0)
         {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                rtc = idx;
-            }
-            else
-            {
-                Debug::printf (DEBUG_LEVEL_NONE, "Internal error in get_free_slot_wait_s88(), idx=%u\n", (unsigned int) idx);
-            }
+            Debug::printf (DEBUG_LEVEL_NONE, "Event::add: too many pending events, event type %u dropped\n", ep->type);
         }
+
+        Event::stats.n_dropped++;
+        return;
     }
 
-    return rtc;
+    Event::slots[slot]      = *ep;
+    Event::slot_keys[slot]  = key;
+    Event::index.insert ({ key, slot });
+    Event::heap_push (slot);
+
+    Event::stats.n_queued++;
+
+    if (Event::stats.max_pending < Event::heap.size ())
+    {
+        Event::stats.max_pending = Event::heap.size ();
+    }
 }
 
-uint_fast16_t
-Event::get_free_slot_execute_loco_macro (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t macroidx)
+/*------------------------------------------------------------------------------------------------------------------------
+ * add () - add event due in tenths of a second
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::add (EVENTS * ep, uint16_t tenths)
 {
-    uint_fast16_t   idx;
-    uint_fast16_t   empty_idx   = 0xFFFF;
-    uint_fast16_t   len         = Event::event_size;
-    uint_fast16_t   rtc         = 0xFFFF;
+    ep->tenths = tenths;
+    ep->millis = Millis::elapsed () + 100 * tenths;
+    Event::insert (ep);
+}
 
-    for (idx = 0; len > 0 && idx < EVENT_LEN; idx++)
+/*------------------------------------------------------------------------------------------------------------------------
+ * remove () - remove pending event
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::remove (uint32_t slot)
+{
+    uint32_t    pos     = Event::slot_heap_pos[slot];
+    uint32_t    last    = Event::heap.back ();
+    auto        range   = Event::index.equal_range (Event::slot_keys[slot]);
+
+    for (auto it = range.first; it != range.second; it++)
     {
-        if (Event::event_buffer[idx].millis == 0)
+        if (it->second == slot)
         {
-            if (empty_idx == 0xFFFF)
-            {
-                empty_idx = idx;
-            }
+            Event::index.erase (it);
+            break;
         }
-        else
-        {
-            if (Event::event_buffer[idx].tenths == tenths && Event::event_buffer[idx].type == EVENT_TYPE_EXECUTE_LOCO_MACRO)        // find double entry...
-            {
-                if (Event::event_buffer[idx].loco_macro.loco_idx == loco_idx &&
-                    Event::event_buffer[idx].loco_macro.m == macroidx)
-                {
-                    rtc = idx;
-                    break;
-                }
-            }
+    }
 
-            len--;
-        }
+    Event::heap.pop_back ();
+
+    if (last != slot)
+    {
+        Event::heap[pos] = last;
+        Event::slot_heap_pos[last] = pos;
+        Event::heap_up (pos);
+        Event::heap_down (Event::slot_heap_pos[last]);
     }
 
-    if (rtc == 0xFFFF)
+    Event::slots[slot].millis = 0;
+    Event::free_slots.push_back (slot);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * rebuild () - rebuild heap, index and free slots after events have been changed or deleted (millis = 0)
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::rebuild (void)
+{
+    uint32_t    slot;
+
+    Event::heap.clear ();
+    Event::index.clear ();
+    Event::free_slots.clear ();
+
+    for (slot = Event::slots.size (); slot > 0; slot--)                             // lowest free slot is used first
     {
-        if (empty_idx != 0xFFFF)
+        EVENTS *    ep = &Event::slots[slot - 1];
+
+        if (ep->millis != 0)
         {
-            rtc = empty_idx;
+            Event::slot_keys[slot - 1] = Event::get_key (ep);
+            Event::index.insert ({ Event::slot_keys[slot - 1], slot - 1 });
+            Event::heap_push (slot - 1);
         }
-        else if (idx < EVENT_LEN)
+        else
         {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                rtc = idx;
-            }
-            else
-            {
-                Debug::printf (DEBUG_LEVEL_NONE, "Internal error in get_free_slot_loco_macro(), idx=%u\n", (unsigned int) idx);
-            }
+            Event::free_slots.push_back (slot - 1);
         }
     }
-
-    return rtc;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -375,27 +375,13 @@ Event::get_free_slot_execute_loco_macro (uint16_t tenths, uint_fast16_t loco_idx
 void
 Event::add_event_loco_function (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t f, bool b)
 {
-    uint_fast16_t idx;
-
-    if (Event::event_size < EVENT_LEN)                                              // buffer full?
-    {                                                                               // no
-        idx = Event::get_free_slot_loco_function (tenths, loco_idx, f, b);
+    EVENTS  ev = {};
 
-        if (idx < EVENT_LEN)
-        {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                Event::event_size++;
-            }
-
-            Event::event_buffer[idx].millis         = Millis::elapsed () + 100 * tenths;
-            Event::event_buffer[idx].tenths         = tenths;
-            Event::event_buffer[idx].type           = EVENT_TYPE_LOCO_FUNCTION;
-            Event::event_buffer[idx].loco_func.loco_idx  = loco_idx;
-            Event::event_buffer[idx].loco_func.f         = f;
-            Event::event_buffer[idx].loco_func.b         = b;
-        }
-    }
+    ev.type                 = EVENT_TYPE_LOCO_FUNCTION;
+    ev.loco_func.loco_idx   = loco_idx;
+    ev.loco_func.f          = f;
+    ev.loco_func.b          = b;
+    Event::add (&ev, tenths);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -405,28 +391,29 @@ Event::add_event_loco_function (uint16_t tenths, uint_fast16_t loco_idx, uint_fa
 void
 Event::add_event_loco_speed (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t speed_type, uint_fast8_t speed, uint_fast16_t ramp)
 {
-    uint_fast16_t idx;
-
-    if (Event::event_size < EVENT_LEN)                                              // buffer full?
-    {                                                                               // no
-        idx = Event::get_free_slot_loco_speed (tenths, loco_idx, speed_type, speed, ramp);
+    EVENTS  ev = {};
+
+    ev.type                 = EVENT_TYPE_LOCO_SPEED;
+    ev.loco_speed.loco_idx  = loco_idx;
+    ev.loco_speed.type      = speed_type;
+    ev.loco_speed.sp        = speed;
+    ev.loco_speed.ramp      = ramp;
+    Event::add (&ev, tenths);
+}
 
-        if (idx < EVENT_LEN)
-        {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                Event::event_size++;
-            }
+/*------------------------------------------------------------------------------------------------------------------------
+ * add_event_loco_dir () - add direction event
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::add_event_loco_dir (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t fwd)
+{
+    EVENTS  ev = {};
 
-            Event::event_buffer[idx].millis         = Millis::elapsed () + 100 * tenths;
-            Event::event_buffer[idx].tenths         = tenths;
-            Event::event_buffer[idx].type           = EVENT_TYPE_LOCO_SPEED;
-            Event::event_buffer[idx].loco_speed.loco_idx = loco_idx;
-            Event::event_buffer[idx].loco_speed.type     = speed_type;
-            Event::event_buffer[idx].loco_speed.sp       = speed;
-            Event::event_buffer[idx].loco_speed.ramp     = ramp;
-        }
-    }
+    ev.type                 = EVENT_TYPE_LOCO_DIR;
+    ev.loco_dir.loco_idx    = loco_idx;
+    ev.loco_dir.fwd         = fwd;
+    Event::add (&ev, tenths);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -436,27 +423,13 @@ Event::add_event_loco_speed (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8
 void
 Event::add_event_addon_function (uint16_t tenths, uint_fast16_t addon_idx, uint_fast8_t f, bool b)
 {
-    uint_fast16_t idx;
-
-    if (Event::event_size < EVENT_LEN)                                              // buffer full?
-    {                                                                               // no
-        idx = Event::get_free_slot_addon_function (tenths, addon_idx, f, b);
-
-        if (idx < EVENT_LEN)
-        {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                Event::event_size++;
-            }
+    EVENTS  ev = {};
 
-            Event::event_buffer[idx].millis                 = Millis::elapsed () + 100 * tenths;
-            Event::event_buffer[idx].tenths                 = tenths;
-            Event::event_buffer[idx].type                   = EVENT_TYPE_ADDON_FUNCTION;
-            Event::event_buffer[idx].addon_func.addon_idx   = addon_idx;
-            Event::event_buffer[idx].addon_func.f           = f;
-            Event::event_buffer[idx].addon_func.b           = b;
-        }
-    }
+    ev.type                 = EVENT_TYPE_ADDON_FUNCTION;
+    ev.addon_func.addon_idx = addon_idx;
+    ev.addon_func.f         = f;
+    ev.addon_func.b         = b;
+    Event::add (&ev, tenths);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -466,576 +439,560 @@ Event::add_event_addon_function (uint16_t tenths, uint_fast16_t addon_idx, uint_
 void
 Event::add_event_wait_s88 (uint16_t tenths, uint_fast16_t coidx, uint_fast16_t loco_idx, uint_fast8_t speed, uint_fast16_t ramp)
 {
-    uint_fast16_t idx;
-
-    if (Event::event_size < EVENT_LEN)                                              // buffer full?
-    {                                                                               // no
-        idx = Event::get_free_slot_wait_s88 (tenths, coidx, loco_idx, speed, ramp);
+    EVENTS  ev = {};
+
+    ev.type                 = EVENT_TYPE_WAIT_S88;
+    ev.wait_s88.loco_idx    = loco_idx;
+    ev.wait_s88.sp          = speed;
+    ev.wait_s88.ramp        = ramp;
+    ev.wait_s88.coidx       = coidx;
+    Event::add (&ev, tenths);
+}
 
-        if (idx < EVENT_LEN)
-        {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                Event::event_size++;
-            }
+/*------------------------------------------------------------------------------------------------------------------------
+ * add_event_execute_loco_macro () - add macro event
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::add_event_execute_loco_macro (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t macroidx)
+{
+    EVENTS  ev = {};
 
-            Event::event_buffer[idx].millis             = Millis::elapsed () + 100 * tenths;
-            Event::event_buffer[idx].tenths             = tenths;
-            Event::event_buffer[idx].type               = EVENT_TYPE_WAIT_S88;
-            Event::event_buffer[idx].wait_s88.loco_idx  = loco_idx;
-            Event::event_buffer[idx].wait_s88.sp        = speed;
-            Event::event_buffer[idx].wait_s88.ramp      = ramp;
-            Event::event_buffer[idx].wait_s88.coidx     = coidx;
-        }
-    }
+    ev.type                 = EVENT_TYPE_EXECUTE_LOCO_MACRO;
+    ev.loco_macro.loco_idx  = loco_idx;
+    ev.loco_macro.m         = macroidx;
+    Event::add (&ev, tenths);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- * delete_event_wait_s88 () - delete wait event
+ * add_event_led_set_state () - add led event
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-Event::delete_event_wait_s88 (uint_fast16_t loco_idx)
+Event::add_event_led_set_state (uint16_t tenths, uint_fast16_t led_group_idx, uint_fast8_t ledmask, uint_fast8_t ledon)
 {
-    uint_fast16_t   idx;
-    uint_fast16_t   len = Event::event_size;
-
-    for (idx = 0; len > 0 && idx < EVENT_LEN; idx++)
-    {
-        if (Event::event_buffer[idx].millis != 0 &&
-            Event::event_buffer[idx].type == EVENT_TYPE_WAIT_S88 &&
-            Event::event_buffer[idx].wait_s88.loco_idx == loco_idx)
-        {
-            Event::event_buffer[idx].millis = 0;
-            Event::event_size--;
-            Locos::locos[loco_idx].reset_flag_halt ();
-            break;
-        }
+    EVENTS  ev = {};
 
-        len--;
-    }
+    ev.type                     = EVENT_TYPE_LED_SET_STATE;
+    ev.led_state.led_group_idx  = led_group_idx;
+    ev.led_state.ledmask        = ledmask;
+    ev.led_state.ledon          = ledon;
+    Event::add (&ev, tenths);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- * add_event_loco_dir () - add direction event
+ * add_event_switch_set_state () - add switch event
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-Event::add_event_loco_dir (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t fwd)
+Event::add_event_switch_set_state (uint16_t tenths, uint_fast16_t swidx, uint_fast8_t swstate)
 {
-    uint_fast16_t idx;
+    EVENTS  ev = {};
 
-    if (Event::event_size < EVENT_LEN)                                              // buffer full?
-    {                                                                               // no
-        idx = Event::get_free_slot_loco_dir (tenths, loco_idx, fwd);
+    ev.type                     = EVENT_TYPE_SWITCH_SET_STATE;
+    ev.switch_state.swidx       = swidx;
+    ev.switch_state.swstate     = swstate;
+    Event::add (&ev, tenths);
+}
 
-        if (idx < EVENT_LEN)
-        {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                Event::event_size++;
-            }
+/*------------------------------------------------------------------------------------------------------------------------
+ * add_event_signal_set_state () - add signal event
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::add_event_signal_set_state (uint16_t tenths, uint_fast16_t sigidx, uint_fast8_t sigstate)
+{
+    EVENTS  ev = {};
 
-            Event::event_buffer[idx].millis             = Millis::elapsed () + 100 * tenths;
-            Event::event_buffer[idx].tenths             = tenths;
-            Event::event_buffer[idx].type               = EVENT_TYPE_LOCO_DIR;
-            Event::event_buffer[idx].loco_dir.loco_idx  = loco_idx;
-            Event::event_buffer[idx].loco_dir.fwd       = fwd;
-        }
-    }
+    ev.type                     = EVENT_TYPE_SIGNAL_SET_STATE;
+    ev.signal_state.sigidx      = sigidx;
+    ev.signal_state.sigstate    = sigstate;
+    Event::add (&ev, tenths);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- * add_event_loco_macro () - add macro event
+ * delete_event_wait_s88 () - delete wait event
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-Event::add_event_execute_loco_macro (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t macroidx)
+Event::delete_event_wait_s88 (uint_fast16_t loco_idx)
 {
-    uint_fast16_t idx;
+    uint32_t    pos;
 
-    if (Event::event_size < EVENT_LEN)                                              // buffer full?
-    {                                                                               // no
-        idx = Event::get_free_slot_execute_loco_macro (tenths, loco_idx, macroidx);
+    for (pos = 0; pos < Event::heap.size (); pos++)
+    {
+        uint32_t    slot = Event::heap[pos];
 
-        if (idx < EVENT_LEN)
+        if (Event::slots[slot].type == EVENT_TYPE_WAIT_S88 && Event::slots[slot].wait_s88.loco_idx == loco_idx)
         {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                Event::event_size++;
-            }
-
-            Event::event_buffer[idx].millis                 = Millis::elapsed () + 100 * tenths;
-            Event::event_buffer[idx].tenths                 = tenths;
-            Event::event_buffer[idx].type                   = EVENT_TYPE_EXECUTE_LOCO_MACRO;
-            Event::event_buffer[idx].loco_macro.loco_idx    = loco_idx;
-            Event::event_buffer[idx].loco_macro.m           = macroidx;
+            Event::remove (slot);
+            Locos::locos[loco_idx].reset_flag_halt ();
+            break;
         }
     }
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ * save_events () - copy pending events in order of due time, millis are stored relative to now, see Journal::deinit ()
+ *
+ * If there are more than max_events, the events due last are dropped and logged.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
 uint_fast16_t
-Event::get_free_slot_switch_set_state (uint16_t tenths, uint_fast16_t swidx, uint_fast8_t swstate)
+Event::save_events (EVENTS * events, uint_fast16_t max_events)
 {
-    uint_fast16_t   idx;
-    uint_fast16_t   empty_idx   = 0xFFFF;
-    uint_fast16_t   len         = Event::event_size;
-    uint_fast16_t   rtc         = 0xFFFF;
+    uint32_t                current_millis  = Millis::elapsed ();
+    std::vector<uint32_t>   sorted          = Event::heap;
+    uint_fast16_t           n_events        = 0;
+    uint32_t                pos;
+
+    std::sort (sorted.begin (), sorted.end (), [](uint32_t a, uint32_t b) { return Event::slots[a].millis < Event::slots[b].millis; });
 
-    for (idx = 0; len > 0 && idx < EVENT_LEN; idx++)
+    for (pos = 0; pos < sorted.size () && n_events < max_events; pos++)
     {
-        if (Event::event_buffer[idx].millis == 0)
+        EVENTS *    ep = &Event::slots[sorted[pos]];
+
+        events[n_events] = *ep;
+
+        if (ep->millis > current_millis)
         {
-            if (empty_idx == 0xFFFF)
-            {
-                empty_idx = idx;
-            }
+            events[n_events].millis = ep->millis - current_millis;
         }
         else
         {
-            if (Event::event_buffer[idx].tenths == tenths && Event::event_buffer[idx].type == EVENT_TYPE_SWITCH_SET_STATE)        // find double entry...
-            {
-                if (Event::event_buffer[idx].switch_state.swidx == swidx &&
-                    Event::event_buffer[idx].switch_state.swstate == swstate)
-                {
-                    rtc = idx;
-                    break;
-                }
-            }
-
-            len--;
+            events[n_events].millis = 1;                                            // overdue, execute immediately
         }
+
+        n_events++;
     }
 
-    if (rtc == 0xFFFF)
+    if (n_events < sorted.size ())
     {
-        if (empty_idx != 0xFFFF)
-        {
-            rtc = empty_idx;
-        }
-        else if (idx < EVENT_LEN)
-        {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                rtc = idx;
-            }
-            else
-            {
-                Debug::printf (DEBUG_LEVEL_NONE, "Internal error in get_free_slot_illu_macro(), idx=%u\n", (unsigned int) idx);
-            }
-        }
+        Debug::printf (DEBUG_LEVEL_NONE, "Event::save_events: %u of %u pending events dropped\n",
+                       (unsigned int) (sorted.size () - n_events), (unsigned int) sorted.size ());
     }
 
-    return rtc;
+    return n_events;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- * add_event_switch_set_state () - add switch event
+ * restore_events () - restore events saved by save_events (), see Journal::init ()
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-Event::add_event_switch_set_state (uint16_t tenths, uint_fast16_t swidx, uint_fast8_t swstate)
+Event::restore_events (EVENTS * events, uint_fast16_t n_events)
 {
-    uint_fast16_t idx;
+    uint32_t        current_millis  = Millis::elapsed ();
+    uint_fast16_t   eidx;
 
-    if (Event::event_size < EVENT_LEN)                                              // buffer full?
-    {                                                                               // no
-        idx = Event::get_free_slot_switch_set_state (tenths, swidx, swstate);
+    for (eidx = 0; eidx < n_events; eidx++)
+    {
+        EVENTS  ev = events[eidx];
 
-        if (idx < EVENT_LEN)
-        {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                Event::event_size++;
-            }
+        ev.millis = current_millis + events[eidx].millis;
+        Event::insert (&ev);
+    }
+}
 
-            Event::event_buffer[idx].millis                 = Millis::elapsed () + 100 * tenths;
-            Event::event_buffer[idx].tenths                 = tenths;
-            Event::event_buffer[idx].type                   = EVENT_TYPE_SWITCH_SET_STATE;
-            Event::event_buffer[idx].switch_state.swidx     = swidx;
-            Event::event_buffer[idx].switch_state.swstate   = swstate;
+/*------------------------------------------------------------------------------------------------------------------------
+ * set_new_id () - correct index of an event, delete event if object has been removed, see rebuild ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::set_new_id (uint32_t slot, uint16_t * idxp, uint16_t * map_new_idx, uint_fast16_t n)
+{
+    if (*idxp < n)
+    {
+        if (map_new_idx[*idxp] == 0xFFFF)
+        {
+            Event::slots[slot].millis = 0;
+        }
+        else
+        {
+            *idxp = map_new_idx[*idxp];
         }
     }
 }
 
-uint_fast16_t
-Event::get_free_slot_signal_set_state (uint16_t tenths, uint_fast16_t sigidx, uint_fast8_t sigstate)
+/*------------------------------------------------------------------------------------------------------------------------
+ * set_new_loco_ids () - correct loco indexes of pending events, see FileIO::reload_ini_files ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::set_new_loco_ids (uint16_t * map_new_loco_idx, uint_fast16_t n_locos)
 {
-    uint_fast16_t   idx;
-    uint_fast16_t   empty_idx   = 0xFFFF;
-    uint_fast16_t   len         = Event::event_size;
-    uint_fast16_t   rtc         = 0xFFFF;
+    uint32_t    pos;
 
-    for (idx = 0; len > 0 && idx < EVENT_LEN; idx++)
+    for (pos = 0; pos < Event::heap.size (); pos++)
     {
-        if (Event::event_buffer[idx].millis == 0)
+        uint32_t    slot    = Event::heap[pos];
+        EVENTS *    ep      = &Event::slots[slot];
+
+        switch (ep->type)
         {
-            if (empty_idx == 0xFFFF)
+            case EVENT_TYPE_LOCO_FUNCTION:
             {
-                empty_idx = idx;
+                Event::set_new_id (slot, &(ep->loco_func.loco_idx), map_new_loco_idx, n_locos);
+                break;
             }
-        }
-        else
-        {
-            if (Event::event_buffer[idx].tenths == tenths && Event::event_buffer[idx].type == EVENT_TYPE_SIGNAL_SET_STATE)        // find double entry...
+
+            case EVENT_TYPE_LOCO_SPEED:
             {
-                if (Event::event_buffer[idx].signal_state.sigidx == sigidx &&
-                    Event::event_buffer[idx].signal_state.sigstate == sigstate)
-                {
-                    rtc = idx;
-                    break;
-                }
+                Event::set_new_id (slot, &(ep->loco_speed.loco_idx), map_new_loco_idx, n_locos);
+                break;
             }
 
-            len--;
-        }
-    }
+            case EVENT_TYPE_LOCO_DIR:
+            {
+                Event::set_new_id (slot, &(ep->loco_dir.loco_idx), map_new_loco_idx, n_locos);
+                break;
+            }
 
-    if (rtc == 0xFFFF)
-    {
-        if (empty_idx != 0xFFFF)
-        {
-            rtc = empty_idx;
-        }
-        else if (idx < EVENT_LEN)
-        {
-            if (Event::event_buffer[idx].millis == 0)
+            case EVENT_TYPE_WAIT_S88:
             {
-                rtc = idx;
+                Event::set_new_id (slot, &(ep->wait_s88.loco_idx), map_new_loco_idx, n_locos);
+                break;
             }
-            else
+
+            case EVENT_TYPE_EXECUTE_LOCO_MACRO:
             {
-                Debug::printf (DEBUG_LEVEL_NONE, "Internal error in get_free_slot_signal_set_state(), idx=%u\n", (unsigned int) idx);
+                Event::set_new_id (slot, &(ep->loco_macro.loco_idx), map_new_loco_idx, n_locos);
+                break;
             }
         }
     }
 
-    return rtc;
+    Event::rebuild ();
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- * add_event_signal_set_state () - add signal event
+ * set_new_addon_ids () - correct addon indexes of pending events, see FileIO::reload_ini_files ()
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-Event::add_event_signal_set_state (uint16_t tenths, uint_fast16_t sigidx, uint_fast8_t sigstate)
+Event::set_new_addon_ids (uint16_t * map_new_addon_idx, uint_fast16_t n_addons)
 {
-    uint_fast16_t idx;
+    uint32_t    pos;
 
-    if (Event::event_size < EVENT_LEN)                                              // buffer full?
-    {                                                                               // no
-        idx = Event::get_free_slot_signal_set_state (tenths, sigidx, sigstate);
+    for (pos = 0; pos < Event::heap.size (); pos++)
+    {
+        EVENTS *    ep = &Event::slots[Event::heap[pos]];
 
-        if (idx < EVENT_LEN)
+        if (ep->type == EVENT_TYPE_ADDON_FUNCTION)
         {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                Event::event_size++;
-            }
-
-            Event::event_buffer[idx].millis                 = Millis::elapsed () + 100 * tenths;
-            Event::event_buffer[idx].tenths                 = tenths;
-            Event::event_buffer[idx].type                   = EVENT_TYPE_SIGNAL_SET_STATE;
-            Event::event_buffer[idx].signal_state.sigidx    = sigidx;
-            Event::event_buffer[idx].signal_state.sigstate  = sigstate;
+            Event::set_new_id (Event::heap[pos], &(ep->addon_func.addon_idx), map_new_addon_idx, n_addons);
         }
     }
+
+    Event::rebuild ();
 }
 
-uint_fast16_t
-Event::get_free_slot_led_set_state (uint16_t tenths, uint_fast16_t led_group_idx, uint_fast8_t ledmask, uint_fast8_t ledon)
+/*------------------------------------------------------------------------------------------------------------------------
+ * set_new_switch_ids () - correct switch indexes of pending events, see FileIO::reload_ini_files ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::set_new_switch_ids (uint16_t * map_new_switch_idx, uint_fast16_t n_switches)
 {
-    uint_fast16_t   idx;
-    uint_fast16_t   empty_idx   = 0xFFFF;
-    uint_fast16_t   len         = Event::event_size;
-    uint_fast16_t   rtc         = 0xFFFF;
+    uint32_t    pos;
 
-    for (idx = 0; len > 0 && idx < EVENT_LEN; idx++)
+    for (pos = 0; pos < Event::heap.size (); pos++)
     {
-        if (Event::event_buffer[idx].millis == 0)
-        {
-            if (empty_idx == 0xFFFF)
-            {
-                empty_idx = idx;
-            }
-        }
-        else
-        {
-            if (Event::event_buffer[idx].tenths == tenths && Event::event_buffer[idx].type == EVENT_TYPE_LED_SET_STATE)        // find double entry...
-            {
-                if (Event::event_buffer[idx].led_state.led_group_idx == led_group_idx &&
-                    Event::event_buffer[idx].led_state.ledmask == ledmask &&
-                    Event::event_buffer[idx].led_state.ledon == ledon)
-                {
-                    rtc = idx;
-                    break;
-                }
-            }
+        EVENTS *    ep = &Event::slots[Event::heap[pos]];
 
-            len--;
+        if (ep->type == EVENT_TYPE_SWITCH_SET_STATE)
+        {
+            Event::set_new_id (Event::heap[pos], &(ep->switch_state.swidx), map_new_switch_idx, n_switches);
         }
     }
 
-    if (rtc == 0xFFFF)
+    Event::rebuild ();
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * set_new_signal_ids () - correct signal indexes of pending events, see FileIO::reload_ini_files ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::set_new_signal_ids (uint16_t * map_new_signal_idx, uint_fast16_t n_signals)
+{
+    uint32_t    pos;
+
+    for (pos = 0; pos < Event::heap.size (); pos++)
     {
-        if (empty_idx != 0xFFFF)
+        EVENTS *    ep = &Event::slots[Event::heap[pos]];
+
+        if (ep->type == EVENT_TYPE_SIGNAL_SET_STATE)
         {
-            rtc = empty_idx;
-        }
-        else if (idx < EVENT_LEN)
-        {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                rtc = idx;
-            }
-            else
-            {
-                Debug::printf (DEBUG_LEVEL_NONE, "Internal error in get_free_slot_led_set_state, idx=%u\n", (unsigned int) idx);
-            }
+            Event::set_new_id (Event::heap[pos], &(ep->signal_state.sigidx), map_new_signal_idx, n_signals);
         }
     }
 
-    return rtc;
+    Event::rebuild ();
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- * add_event_led_set_state () - add led event
+ * set_new_led_group_ids () - correct led group indexes of pending events, see FileIO::reload_ini_files ()
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-Event::add_event_led_set_state (uint16_t tenths, uint_fast16_t led_group_idx, uint_fast8_t ledmask, uint_fast8_t ledon)
+Event::set_new_led_group_ids (uint16_t * map_new_led_group_idx, uint_fast16_t n_led_groups)
 {
-    uint_fast16_t idx;
+    uint32_t    pos;
 
-    if (Event::event_size < EVENT_LEN)                                              // buffer full?
-    {                                                                               // no
-        idx = Event::get_free_slot_led_set_state (tenths, led_group_idx, ledmask, ledon);
+    for (pos = 0; pos < Event::heap.size (); pos++)
+    {
+        EVENTS *    ep = &Event::slots[Event::heap[pos]];
 
-        if (idx < EVENT_LEN)
+        if (ep->type == EVENT_TYPE_LED_SET_STATE)
         {
-            if (Event::event_buffer[idx].millis == 0)
-            {
-                Event::event_size++;
-            }
-
-            Event::event_buffer[idx].millis                     = Millis::elapsed () + 100 * tenths;
-            Event::event_buffer[idx].tenths                     = tenths;
-            Event::event_buffer[idx].type                       = EVENT_TYPE_LED_SET_STATE;
-            Event::event_buffer[idx].led_state.led_group_idx    = led_group_idx;
-            Event::event_buffer[idx].led_state.ledmask          = ledmask;
-            Event::event_buffer[idx].led_state.ledon            = ledon;
+            Event::set_new_id (Event::heap[pos], &(ep->led_state.led_group_idx), map_new_led_group_idx, n_led_groups);
         }
     }
+
+    Event::rebuild ();
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_stats () - get statistics
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Event::get_stats (EVENT_STATS * statsp)
+{
+    *statsp             = Event::stats;
+    statsp->n_pending   = Event::heap.size ();
+    statsp->capacity    = Event::slots.size ();
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * loco_state () - client-visible state of a loco: functions, speed, target speed, direction and flags
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static uint64_t
+loco_state (uint_fast16_t loco_idx)
+{
+    return ((uint64_t) Locos::runtime.functions[loco_idx] << 32) |
+           ((uint64_t) Locos::runtime.speed[loco_idx] << 24) |
+           ((uint64_t) Locos::runtime.target_speed[loco_idx] << 16) |
+           ((uint64_t) Locos::runtime.fwd[loco_idx] << 8) |
+           (uint64_t) (Locos::runtime.flags[loco_idx] & 0xFF);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
  * schedule_events() - schedule events
+ *
+ * The state version is only incremented if an event changed client-visible state, e.g. a WAIT_S88 event polling
+ * an occupied contact every 100 msec does not invalidate the caches.
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
 Event::schedule (void)
 {
-    uint_fast16_t   idx;
-    uint_fast16_t   len = Event::event_size;
+    uint_fast16_t   len = Event::heap.size ();                                      // don't execute events added in this call
     uint32_t        current_millis = Millis::elapsed ();
 
-    for (idx = 0; len > 0 && idx < EVENT_LEN; idx++)
+    while (len > 0 && Event::heap.size () > 0)
     {
-        if (Event::event_buffer[idx].millis > 0)
+        uint32_t    slot = Event::heap[0];
+
+        if (Event::slots[slot].millis > current_millis)
         {
-            if (Event::event_buffer[idx].millis <= current_millis)
+            break;
+        }
+
+        EVENTS      ev = Event::slots[slot];                                        // copy, event actions may add new events
+        EVENTS *    ep = &ev;
+        bool        changed = false;
+
+        Event::remove (slot);
+
+        switch (ep->type)
+        {
+            case EVENT_TYPE_LOCO_FUNCTION:
             {
-                bool    do_delete_event = true;
+                uint_fast16_t   loco_idx    = ep->loco_func.loco_idx;
+                uint64_t        old_state   = loco_state (loco_idx);
 
-                switch (Event::event_buffer[idx].type)
+                if (ep->loco_func.f == 0xFF)
                 {
-                    case EVENT_TYPE_LOCO_FUNCTION:
-                    {
-                        uint_fast16_t loco_idx = Event::event_buffer[idx].loco_func.loco_idx;
-
-                        if (Event::event_buffer[idx].loco_func.f == 0xFF)
-                        {
-                            Locos::locos[loco_idx].reset_functions ();
-                        }
-                        else
-                        {
-                            Locos::locos[loco_idx].set_function (Event::event_buffer[idx].loco_func.f, Event::event_buffer[idx].loco_func.b);
-                        }
-                        break;
-                    }
+                    Locos::locos[loco_idx].reset_functions ();
+                }
+                else
+                {
+                    Locos::locos[loco_idx].set_function (ep->loco_func.f, ep->loco_func.b);
+                }
 
-                    case EVENT_TYPE_LOCO_SPEED:
-                    {
-                        uint_fast16_t   loco_idx    = Event::event_buffer[idx].loco_speed.loco_idx;
-                        uint_fast8_t    type        = Event::event_buffer[idx].loco_speed.type;
-                        uint_fast8_t    speed       = Event::event_buffer[idx].loco_speed.sp;
-                        uint_fast16_t   tenths      = Event::event_buffer[idx].loco_speed.ramp;
-
-                        if (loco_idx != 0xFFFF)
-                        {
-                            switch (type)
-                            {
-                                case EVENT_SET_LOCO_SPEED:
-                                {
-                                    Locos::locos[loco_idx].set_speed (speed, tenths);
-                                    break;
-                                }
-                                case EVENT_SET_LOCO_MIN_SPEED:
-                                {
-                                    uint_fast8_t current_speed = Locos::locos[loco_idx].get_speed ();
-
-                                    if (current_speed < speed)
-                                    {
-                                        Locos::locos[loco_idx].set_speed (speed, tenths);
-                                    }
-                                    break;
-                                }
-                                case EVENT_SET_LOCO_MAX_SPEED:
-                                {
-                                    uint_fast8_t current_speed = Locos::locos[loco_idx].get_speed ();
-
-                                    if (current_speed > speed)
-                                    {
-                                        Locos::locos[loco_idx].set_speed (speed, tenths);
-                                    }
-                                    break;
-                                }
-                            }
-                        }
-
-                        break;
-                    }
+                changed = (loco_state (loco_idx) != old_state);
+                break;
+            }
 
-                    case EVENT_TYPE_LOCO_DIR:
-                    {
-                        uint_fast16_t   loco_idx    = Event::event_buffer[idx].loco_dir.loco_idx;
-                        uint_fast8_t    fwd         = Event::event_buffer[idx].loco_dir.fwd;
+            case EVENT_TYPE_LOCO_SPEED:
+            {
+                uint_fast16_t   loco_idx    = ep->loco_speed.loco_idx;
+                uint_fast8_t    type        = ep->loco_speed.type;
+                uint_fast8_t    speed       = ep->loco_speed.sp;
+                uint_fast16_t   tenths      = ep->loco_speed.ramp;
 
-                        if (loco_idx != 0xFFFF)
-                        {
-                            Locos::locos[loco_idx].set_fwd (fwd);
-                        }
+                if (loco_idx != 0xFFFF)
+                {
+                    uint64_t    old_state = loco_state (loco_idx);
 
-                        break;
-                    }
+                    Automation::set_loco_speed (loco_idx, type, speed, tenths);
+                    changed = (loco_state (loco_idx) != old_state);
+                }
 
-                    case EVENT_TYPE_ADDON_FUNCTION:
-                    {
-                        uint_fast16_t addon_idx = Event::event_buffer[idx].addon_func.addon_idx;
-
-                        if (Event::event_buffer[idx].addon_func.f == 0xFF)
-                        {
-                            AddOns::addons[addon_idx].reset_functions ();
-                        }
-                        else
-                        {
-                            AddOns::addons[addon_idx].set_function (Event::event_buffer[idx].addon_func.f, Event::event_buffer[idx].addon_func.b);
-                        }
-                        break;
-                    }
+                break;
+            }
 
-                    case EVENT_TYPE_WAIT_S88:
-                    {
-                        uint_fast16_t   loco_idx    = Event::event_buffer[idx].wait_s88.loco_idx;
-                        uint_fast8_t    speed       = Event::event_buffer[idx].wait_s88.sp;
-                        uint_fast16_t   tenths      = Event::event_buffer[idx].wait_s88.ramp;
-                        uint_fast16_t   coidx       = Event::event_buffer[idx].wait_s88.coidx;
-
-                        if (loco_idx != 0xFFFF)
-                        {
-                            if (S88::get_state_bit (coidx) == S88_STATE_OCCUPIED)
-                            {
-                                Locos::locos[loco_idx].set_flag_halt ();
-                                Event::event_buffer[idx].millis = current_millis + 100;                         // wait 100msec for next check
-                                do_delete_event = false;
-                            }
-                            else
-                            {
-                                Locos::locos[loco_idx].reset_flag_halt ();
-                                Locos::locos[loco_idx].set_speed (speed, tenths);
-                            }
-                        }
-                        break;
-                    }
+            case EVENT_TYPE_LOCO_DIR:
+            {
+                uint_fast16_t   loco_idx    = ep->loco_dir.loco_idx;
+                uint_fast8_t    fwd         = ep->loco_dir.fwd;
 
-                    case EVENT_TYPE_EXECUTE_LOCO_MACRO:
-                    {
-                        uint_fast16_t   loco_idx    = Event::event_buffer[idx].loco_macro.loco_idx;
-                        uint_fast8_t    macroidx    = Event::event_buffer[idx].loco_macro.m;
+                if (loco_idx != 0xFFFF)
+                {
+                    uint64_t    old_state = loco_state (loco_idx);
 
-                        if (loco_idx != 0xFFFF)
-                        {
-                            Locos::locos[loco_idx].execute_macro (macroidx);
-                        }
+                    Locos::locos[loco_idx].set_fwd (fwd);
+                    changed = (loco_state (loco_idx) != old_state);
+                }
 
-                        break;
-                    }
+                break;
+            }
 
-                    case EVENT_TYPE_FREE1:
-                    {
-                        break;
-                    }
+            case EVENT_TYPE_ADDON_FUNCTION:
+            {
+                uint_fast16_t   addon_idx       = ep->addon_func.addon_idx;
+                uint32_t        old_functions   = AddOns::addons[addon_idx].get_functions ();
+
+                if (ep->addon_func.f == 0xFF)
+                {
+                    AddOns::addons[addon_idx].reset_functions ();
+                }
+                else
+                {
+                    AddOns::addons[addon_idx].set_function (ep->addon_func.f, ep->addon_func.b);
+                }
 
-                    case EVENT_TYPE_FREE2:
+                changed = (AddOns::addons[addon_idx].get_functions () != old_functions);
+                break;
+            }
+
+            case EVENT_TYPE_WAIT_S88:
+            {
+                uint_fast16_t   loco_idx    = ep->wait_s88.loco_idx;
+                uint_fast8_t    speed       = ep->wait_s88.sp;
+                uint_fast16_t   tenths      = ep->wait_s88.ramp;
+                uint_fast16_t   coidx       = ep->wait_s88.coidx;
+
+                if (loco_idx != 0xFFFF)
+                {
+                    uint64_t    old_state = loco_state (loco_idx);
+
+                    if (S88::get_state_bit (coidx) == S88_STATE_OCCUPIED)
                     {
-                        break;
+                        Locos::locos[loco_idx].set_flag_halt ();
+                        ep->millis = current_millis + 100;                          // wait 100msec for next check
+                        Event::insert (ep);
                     }
-
-                    case EVENT_TYPE_FREE3:
+                    else
                     {
-                        break;
+                        Locos::locos[loco_idx].reset_flag_halt ();
+                        Locos::locos[loco_idx].set_speed (speed, tenths);
                     }
 
-                    case EVENT_TYPE_LED_SET_STATE:
-                    {
-                        uint_fast16_t   led_group_idx   = Event::event_buffer[idx].led_state.led_group_idx;
-                        uint_fast8_t    ledmask         = Event::event_buffer[idx].led_state.ledmask;
-                        uint_fast8_t    ledon           = Event::event_buffer[idx].led_state.ledon;
+                    changed = (loco_state (loco_idx) != old_state);
+                }
+                break;
+            }
 
-                        if (led_group_idx != 0xFFFF)
-                        {
-                            Leds::led_groups[led_group_idx].set_state (ledmask, ledon);
-                        }
+            case EVENT_TYPE_EXECUTE_LOCO_MACRO:
+            {
+                uint_fast16_t   loco_idx    = ep->loco_macro.loco_idx;
+                uint_fast8_t    macroidx    = ep->loco_macro.m;
 
-                        break;
-                    }
+                if (loco_idx != 0xFFFF)
+                {
+                    Locos::locos[loco_idx].execute_macro (macroidx);
+                    changed = true;                                                 // macro may change anything
+                }
 
-                    case EVENT_TYPE_SWITCH_SET_STATE:
-                    {
-                        uint_fast16_t   swidx       = Event::event_buffer[idx].switch_state.swidx;
-                        uint_fast8_t    swstate     = Event::event_buffer[idx].switch_state.swstate;
+                break;
+            }
 
-                        if (swidx != 0xFFFF)
-                        {
-                            Switches::switches[swidx].set_state (swstate);
-                        }
+            case EVENT_TYPE_FREE1:
+            {
+                break;
+            }
 
-                        break;
-                    }
+            case EVENT_TYPE_FREE2:
+            {
+                break;
+            }
 
-                    case EVENT_TYPE_SIGNAL_SET_STATE:
-                    {
-                        uint_fast16_t   sigidx      = Event::event_buffer[idx].signal_state.sigidx;
-                        uint_fast8_t    sigstate    = Event::event_buffer[idx].signal_state.sigstate;
+            case EVENT_TYPE_FREE3:
+            {
+                break;
+            }
 
-                        if (sigidx != 0xFFFF)
-                        {
-                            Signals::signals[sigidx].set_state (sigstate);
-                        }
+            case EVENT_TYPE_LED_SET_STATE:
+            {
+                uint_fast16_t   led_group_idx   = ep->led_state.led_group_idx;
+                uint_fast8_t    ledmask         = ep->led_state.ledmask;
+                uint_fast8_t    ledon           = ep->led_state.ledon;
 
-                        break;
-                    }
+                if (led_group_idx != 0xFFFF)
+                {
+                    uint_fast8_t    old_state = Leds::led_groups[led_group_idx].get_state ();
+
+                    Leds::led_groups[led_group_idx].set_state (ledmask, ledon);
+                    changed = (Leds::led_groups[led_group_idx].get_state () != old_state);
+                }
+
+                break;
+            }
 
+            case EVENT_TYPE_SWITCH_SET_STATE:
+            {
+                uint_fast16_t   swidx       = ep->switch_state.swidx;
+                uint_fast8_t    swstate     = ep->switch_state.swstate;
+
+                if (swidx != 0xFFFF)
+                {
+                    uint_fast8_t    old_state = Switches::switches[swidx].get_state ();
+
+                    Switches::switches[swidx].set_state (swstate);
+                    changed = (Switches::switches[swidx].get_state () != old_state);
                 }
 
-                if (do_delete_event)
+                break;
+            }
+
+            case EVENT_TYPE_SIGNAL_SET_STATE:
+            {
+                uint_fast16_t   sigidx      = ep->signal_state.sigidx;
+                uint_fast8_t    sigstate    = ep->signal_state.sigstate;
+
+                if (sigidx != 0xFFFF)
                 {
-                    Event::event_buffer[idx].millis = 0;
-                    Event::event_size--;
+                    uint_fast8_t    old_state = Signals::signals[sigidx].get_state ();
+
+                    Signals::signals[sigidx].set_state (sigstate);
+                    changed = (Signals::signals[sigidx].get_state () != old_state);
                 }
+
+                break;
             }
 
-            len--;
         }
+
+        if (changed)
+        {
+            FM22::state_changed ();
+        }
+
+        Event::stats.n_fired++;
+        len--;
     }
 }
@@ -17,7 +17,15 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  *------------------------------------------------------------------------------------------------------------------------
  */
-#define EVENT_LEN                       256
+#ifndef EVENT_H
+#define EVENT_H
+
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+
+#define EVENT_LEN                       256                                     // initial capacity
+#define EVENT_MAX_LEN                   16384                                   // max. number of pending events
 
 #define EVENT_TYPE_LOCO_FUNCTION        1
 #define EVENT_TYPE_LOCO_SPEED           2
@@ -98,6 +106,17 @@ typedef struct
     };
 } EVENTS;
 
+typedef struct
+{
+    uint32_t            n_queued;                                               // number of queued events
+    uint32_t            n_merged;                                               // number of events which replaced a pending identical event
+    uint32_t            n_fired;                                                // number of executed events
+    uint32_t            n_dropped;                                              // number of events dropped, EVENT_MAX_LEN reached
+    uint32_t            n_pending;                                              // number of pending events
+    uint32_t            max_pending;                                            // max. number of pending events
+    uint32_t            capacity;                                               // number of allocated slots
+} EVENT_STATS;
+
 class Event
 {
     public:
@@ -113,17 +132,34 @@ class Event
         static void                     add_event_signal_set_state (uint16_t tenths, uint_fast16_t sigidx, uint_fast8_t sigstate);
 
         static void                     delete_event_wait_s88 (uint_fast16_t loco_idx);
+        static uint_fast16_t            save_events (EVENTS * events, uint_fast16_t max_events);
+        static void                     restore_events (EVENTS * events, uint_fast16_t n_events);
+        static void                     set_new_loco_ids (uint16_t * map_new_loco_idx, uint_fast16_t n_locos);
+        static void                     set_new_addon_ids (uint16_t * map_new_addon_idx, uint_fast16_t n_addons);
+        static void                     set_new_switch_ids (uint16_t * map_new_switch_idx, uint_fast16_t n_switches);
+        static void                     set_new_signal_ids (uint16_t * map_new_signal_idx, uint_fast16_t n_signals);
+        static void                     set_new_led_group_ids (uint16_t * map_new_led_group_idx, uint_fast16_t n_led_groups);
         static void                     schedule (void);
+        static void                     get_stats (EVENT_STATS * statsp);
     private:
-        static uint_fast16_t            get_free_slot_loco_function (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t f, bool b);
-        static uint_fast16_t            get_free_slot_loco_speed (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t speed_type, uint_fast8_t speed, uint_fast16_t ramp);
-        static uint_fast16_t            get_free_slot_loco_dir (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t fwd);
-        static uint_fast16_t            get_free_slot_addon_function (uint16_t tenths, uint_fast16_t addon_idx, uint_fast8_t f, bool b);
-        static uint_fast16_t            get_free_slot_wait_s88 (uint16_t tenths, uint_fast16_t coidx, uint_fast16_t loco_idx, uint_fast8_t speed, uint_fast16_t ramp);
-        static uint_fast16_t            get_free_slot_execute_loco_macro (uint16_t tenths, uint_fast16_t loco_idx, uint_fast8_t macroidx);
-        static uint_fast16_t            get_free_slot_led_set_state (uint16_t tenths, uint_fast16_t led_group_idx, uint_fast8_t ledmask, uint_fast8_t ledon);
-        static uint_fast16_t            get_free_slot_switch_set_state (uint16_t tenths, uint_fast16_t swidx, uint_fast8_t swstate);
-        static uint_fast16_t            get_free_slot_signal_set_state (uint16_t tenths, uint_fast16_t sigidx, uint_fast8_t sigstate);
-        static EVENTS                   event_buffer[EVENT_LEN];
-        static uint_fast16_t            event_size;
+        static void                     insert (EVENTS * ep);
+        static void                     add (EVENTS * ep, uint16_t tenths);
+        static uint64_t                 get_payload (EVENTS * ep);
+        static uint64_t                 get_key (EVENTS * ep);
+        static bool                     is_same (uint32_t slot, EVENTS * ep);
+        static void                     remove (uint32_t slot);
+        static void                     rebuild (void);
+        static void                     heap_push (uint32_t slot);
+        static void                     heap_up (uint32_t pos);
+        static void                     heap_down (uint32_t pos);
+        static void                     set_new_id (uint32_t slot, uint16_t * idxp, uint16_t * map_new_idx, uint_fast16_t n);
+        static std::vector<EVENTS>      slots;                                  // events, millis == 0: free slot
+        static std::vector<uint64_t>    slot_keys;                              // key of event in slot, see get_key()
+        static std::vector<uint32_t>    slot_heap_pos;                          // position of slot in heap
+        static std::vector<uint32_t>    free_slots;
+        static std::vector<uint32_t>    heap;                                   // slots of pending events, min-heap on millis
+        static std::unordered_multimap<uint64_t, uint32_t>  index;              // key -> slot, finds identical pending events
+        static EVENT_STATS              stats;
 };
+
+#endif
@@ -21,7 +21,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <zlib.h>
 #include <string>
+#include <vector>
 #include "dcc.h"
 #include "fm22.h"
 #include "func.h"
@@ -33,7 +41,11 @@
 #include "railroad.h"
 #include "s88.h"
 #include "rcl.h"
+#include "msg.h"
+#include "event.h"
+#include "udp.h"
 #include "base.h"
+#include "millis.h"
 #include "debug.h"
 #include "fileio.h"
 
@@ -85,6 +97,14 @@ FileIO::read_fm22_ini (void)
                         {
                             FM22::set_shortcut_value (atoi(p));
                         }
+                        else if (! strcmp (buf, "COMPRESSION"))
+                        {
+                            FM22::set_compression_level (atoi(p));
+                        }
+                        else if (! strcmp (buf, "SWITCH_POWER"))
+                        {
+                            FM22::set_switch_power (atoi(p));
+                        }
                     }
                 }
             }
@@ -112,24 +132,27 @@ FileIO::write_fm22_ini (void)
     FILE *          fp;
     const char *    fname = "fm22.ini";
     const char *    fname_bak = "fm22.bak";
+    char *          buf;
+    size_t          len;
     bool            rtc = false;
 
-    unlink (fname_bak);
-    rename (fname, fname_bak);
-
-    fp = fopen (fname, "w");
+    fp = open_memstream (&buf, &len);                                      // file is written by background thread
 
     if (fp)
     {
-        uint32_t    shortcut_value = FM22::get_shortcut_value ();
+        uint32_t    shortcut_value      = FM22::get_shortcut_value ();
+        uint32_t    compression_level   = FM22::get_compression_level ();
+        uint32_t    switch_power        = FM22::get_switch_power ();
 
         fprintf (fp, "[FM22]\r\n");
         fprintf (fp, "SHORTCUT=%u\r\n", shortcut_value);
+        fprintf (fp, "COMPRESSION=%u\r\n", compression_level);
+        fprintf (fp, "SWITCH_POWER=%u\r\n", switch_power);
 
         FM22::data_changed = false;
 
-        rtc = true;
         fclose (fp);
+        rtc = queue_write (fname, fname_bak, buf, len);
     }
     else
     {
@@ -153,6 +176,8 @@ FileIO::read_loco_ini (void)
     int             addon_idx = -1;
     bool            in_loco_section = false;
     bool            in_addon_section = false;
+    std::vector<uint16_t>   positions;                                  // display order
+    std::vector<uint16_t>   addon_positions;                            // display order
 
     fp = fopen (fname, "r");
 
@@ -173,6 +198,7 @@ FileIO::read_loco_ini (void)
                 }
 
                 Locos::locos[loco_idx].activate ();
+                positions.push_back (loco_idx);
                 in_loco_section = true;
                 in_addon_section = false;
             }
@@ -183,9 +209,11 @@ FileIO::read_loco_ini (void)
                 if (addon_idx == 0xFFFF)
                 {
                     Debug::printf (DEBUG_LEVEL_NONE, "%s: error: maximum number of addons reached.\n", fname);
+                    break;
                 }
 
                 AddOns::addons[addon_idx].activate ();
+                addon_positions.push_back (addon_idx);
                 in_loco_section = false;
                 in_addon_section = true;
             }
@@ -222,6 +250,10 @@ FileIO::read_loco_ini (void)
                         {
                             Locos::locos[loco_idx].set_speed_steps (atoi(p));
                         }
+                        else if (! strcmp (buf, "POSITION"))
+                        {
+                            positions[loco_idx] = atoi(p);
+                        }
                         else if (*buf == 'F' && *(buf + 1) >= '0' && *(buf + 1) <= '9')
                         {
                             uint_fast8_t    sound = 0;
@@ -327,6 +359,10 @@ FileIO::read_loco_ini (void)
                         {
                             AddOns::addons[addon_idx].set_addr (atoi(p));
                         }
+                        else if (! strcmp (buf, "POSITION"))
+                        {
+                            addon_positions[addon_idx] = atoi(p);
+                        }
                         else if (*buf == 'F' && *(buf + 1) >= '0' && *(buf + 1) <= '9')
                         {
                             uint_fast8_t    sound = 0;
@@ -389,6 +425,8 @@ FileIO::read_loco_ini (void)
         }
 
         fclose (fp);
+        Locos::set_order (positions);
+        AddOns::set_order (addon_positions);
     }
     else
     {
@@ -473,6 +511,8 @@ FileIO::write_loco_ini (void)
     FILE *          fp;
     const char *    fname = "loco.ini";
     const char *    fname_bak = "loco.bak";
+    char *          buf;
+    size_t          len;
     uint_fast16_t   loco_idx;
     uint_fast16_t   addon_idx;
     uint_fast16_t   n_locos;
@@ -485,10 +525,7 @@ FileIO::write_loco_ini (void)
     LOCOACTION      la;
     bool            rtc = false;
 
-    unlink (fname_bak);
-    rename (fname, fname_bak);
-
-    fp = fopen (fname, "w");
+    fp = open_memstream (&buf, &len);                                      // file is written by background thread
 
     if (fp)
     {
@@ -502,6 +539,11 @@ FileIO::write_loco_ini (void)
             fprintf (fp, "ADDR=%u\r\n", (unsigned int) Locos::locos[loco_idx].get_addr ());
             fprintf (fp, "STEPS=%u\r\n", Locos::locos[loco_idx].get_speed_steps ());
 
+            if (Locos::get_position (loco_idx) != loco_idx)
+            {
+                fprintf (fp, "POSITION=%u\r\n", (unsigned int) Locos::get_position (loco_idx));
+            }
+
             for (fidx = 0; fidx < MAX_LOCO_FUNCTIONS; fidx++)
             {
                 uint16_t        function_name_idx   = Locos::locos[loco_idx].get_function_name_idx (fidx);
@@ -560,6 +602,11 @@ FileIO::write_loco_ini (void)
             fprintf (fp, "ACTIVE=%d\r\n", AddOns::addons[addon_idx].is_active() ? 1 : 0);
             fprintf (fp, "ADDR=%u\r\n", (unsigned int) AddOns::addons[addon_idx].get_addr ());
 
+            if (AddOns::get_position (addon_idx) != addon_idx)
+            {
+                fprintf (fp, "POSITION=%u\r\n", (unsigned int) AddOns::get_position (addon_idx));
+            }
+
             for (fidx = 0; fidx < MAX_LOCO_FUNCTIONS; fidx++)
             {
                 uint16_t        function_name_idx   = AddOns::addons[addon_idx].get_function_name_idx (fidx);
@@ -608,8 +655,8 @@ FileIO::write_loco_ini (void)
         Locos::data_changed = false;
         AddOns::data_changed = false;
 
-        rtc = true;
         fclose (fp);
+        rtc = queue_write (fname, fname_bak, buf, len);
     }
     else
     {
@@ -668,6 +715,9 @@ FileIO::read_switch_ini (void)
     int             subidx = -1;
     uint_fast8_t    section = 0;
     bool            rtc = false;
+    std::vector<uint16_t>   switch_positions;                           // display order
+    std::vector<uint16_t>   railroad_group_positions;                   // display order
+    std::vector<std::vector<uint16_t>>  railroad_positions;             // display order of railroads per group
 
     fp = fopen (fname, "r");
 
@@ -686,6 +736,7 @@ FileIO::read_switch_ini (void)
                 }
 
                 Switches::switches[swidx].set_state (DCC_SWITCH_STATE_UNDEFINED);
+                switch_positions.push_back (swidx);
                 section = SWITCH_SECTION;
             }
             else if (! strcmp (buf, "[RAILROAD_GROUP]"))
@@ -695,6 +746,8 @@ FileIO::read_switch_ini (void)
                     break;
                 }
 
+                railroad_group_positions.push_back (rrgidx);
+                railroad_positions.push_back ({});
                 section = RAILROAD_GROUP_SECTION;
             }
             else if (! strcmp (buf, "[RAILROAD]"))
@@ -705,6 +758,7 @@ FileIO::read_switch_ini (void)
                     break;
                 }
 
+                railroad_positions[rrgidx].push_back (rridx);
                 section = RAILROAD_SECTION;
             }
             else if (! strcmp (buf, "[RAILROAD_SWITCH]"))
@@ -734,6 +788,14 @@ FileIO::read_switch_ini (void)
                     {
                         Switches::switches[swidx].set_flags (atoi(buf + 6));
                     }
+                    else if (! strncmp (buf, "PULSE=", 6))
+                    {
+                        Switches::switches[swidx].set_pulse (atoi(buf + 6));
+                    }
+                    else if (! strncmp (buf, "POSITION=", 9))
+                    {
+                        switch_positions[swidx] = atoi(buf + 9);
+                    }
                 }
                 break;
 
@@ -743,6 +805,10 @@ FileIO::read_switch_ini (void)
                     {
                         RailroadGroups::railroad_groups[rrgidx].set_name (buf + 5);
                     }
+                    else if (! strncmp (buf, "POSITION=", 9))
+                    {
+                        railroad_group_positions[rrgidx] = atoi(buf + 9);
+                    }
                 }
                 break;
 
@@ -758,6 +824,10 @@ FileIO::read_switch_ini (void)
 
                         RailroadGroups::railroad_groups[rrgidx].railroads[rridx].set_link_loco (loco_idx);
                     }
+                    else if (! strncmp (buf, "POSITION=", 9))
+                    {
+                        railroad_positions[rrgidx][rridx] = atoi(buf + 9);
+                    }
                 }
                 break;
 
@@ -776,6 +846,14 @@ FileIO::read_switch_ini (void)
             }
         }
 
+        Switches::set_order (switch_positions);
+        RailroadGroups::set_order (railroad_group_positions);
+
+        for (rrgidx = 0; rrgidx < (int) railroad_positions.size (); rrgidx++)
+        {
+            RailroadGroups::railroad_groups[rrgidx].set_order (railroad_positions[rrgidx]);
+        }
+
         Switches::data_changed = false;
         RailroadGroups::data_changed = false;
         rtc = true;
@@ -794,6 +872,8 @@ FileIO::write_switch_ini (void)
 {
     const char *    fname = "switch.ini";
     const char *    fname_bak = "switch.bak";
+    char *          buf;
+    size_t          len;
     FILE *          fp;
     uint_fast16_t   n_switches;
     uint_fast16_t   swidx;
@@ -804,10 +884,7 @@ FileIO::write_switch_ini (void)
     uint_fast8_t    subidx;
     bool            rtc = false;
 
-    unlink (fname_bak);
-    rename (fname, fname_bak);
-
-    fp = fopen (fname, "w");
+    fp = open_memstream (&buf, &len);                                      // file is written by background thread
 
     if (fp)
     {
@@ -819,6 +896,16 @@ FileIO::write_switch_ini (void)
             fprintf (fp, "NAME=%s\r\n", Switches::switches[swidx].get_name().c_str());
             fprintf (fp, "ADDR=%u\r\n", (unsigned int) Switches::switches[swidx].get_addr());
             fprintf (fp, "FLAGS=%u\r\n", Switches::switches[swidx].get_flags());
+
+            if (Switches::switches[swidx].get_pulse() != 0)
+            {
+                fprintf (fp, "PULSE=%u\r\n", (unsigned int) Switches::switches[swidx].get_pulse());
+            }
+
+            if (Switches::get_position (swidx) != swidx)
+            {
+                fprintf (fp, "POSITION=%u\r\n", (unsigned int) Switches::get_position (swidx));
+            }
         }
 
         n_railroad_groups = RailroadGroups::get_n_railroad_groups ();
@@ -828,6 +915,11 @@ FileIO::write_switch_ini (void)
             fprintf (fp, "[RAILROAD_GROUP]\r\n");
             fprintf (fp, "NAME=%s\r\n", RailroadGroups::railroad_groups[rrgidx].get_name().c_str());
 
+            if (RailroadGroups::get_position (rrgidx) != rrgidx)
+            {
+                fprintf (fp, "POSITION=%u\r\n", (unsigned int) RailroadGroups::get_position (rrgidx));
+            }
+
             n_railroads = RailroadGroups::railroad_groups[rrgidx].get_n_railroads();
 
             for (rridx = 0; rridx < n_railroads; rridx++)
@@ -838,6 +930,11 @@ FileIO::write_switch_ini (void)
                 fprintf (fp, "NAME=%s\r\n", RailroadGroups::railroad_groups[rrgidx].railroads[rridx].get_name().c_str());
                 fprintf (fp, "LOCO=%u\r\n", (unsigned int) loco_idx);
 
+                if (RailroadGroups::railroad_groups[rrgidx].get_position (rridx) != rridx)
+                {
+                    fprintf (fp, "POSITION=%u\r\n", (unsigned int) RailroadGroups::railroad_groups[rrgidx].get_position (rridx));
+                }
+
                 n_switches = RailroadGroups::railroad_groups[rrgidx].railroads[rridx].get_n_switches();
 
                 for (subidx = 0; subidx < n_switches; subidx++)
@@ -851,8 +948,8 @@ FileIO::write_switch_ini (void)
 
         Switches::data_changed = false;
         RailroadGroups::data_changed = false;
-        rtc = true;
         fclose (fp);
+        rtc = queue_write (fname, fname_bak, buf, len);
     }
 
     return rtc;
@@ -867,6 +964,7 @@ FileIO::read_signal_ini (void)
     int             sigidx = -1;
     uint_fast8_t    section = 0;
     bool            rtc = false;
+    std::vector<uint16_t>   positions;                                  // display order
 
     fp = fopen (fname, "r");
 
@@ -885,6 +983,7 @@ FileIO::read_signal_ini (void)
                 }
 
                 Signals::signals[sigidx].set_state (DCC_SWITCH_STATE_UNDEFINED);
+                positions.push_back (sigidx);
                 section = SIGNAL_SECTION;
             }
 
@@ -900,11 +999,16 @@ FileIO::read_signal_ini (void)
                     {
                         Signals::signals[sigidx].set_addr (atoi(buf + 5));
                     }
+                    else if (! strncmp (buf, "POSITION=", 9))
+                    {
+                        positions[sigidx] = atoi(buf + 9);
+                    }
                 }
                 break;
             }
         }
 
+        Signals::set_order (positions);
         Signals::data_changed = false;
         rtc = true;
         fclose (fp);
@@ -922,15 +1026,14 @@ FileIO::write_signal_ini (void)
 {
     const char *    fname = "signal.ini";
     const char *    fname_bak = "signal.bak";
+    char *          buf;
+    size_t          len;
     FILE *          fp;
     uint_fast16_t   n_signals;
     uint_fast16_t   sigidx;
     bool            rtc = false;
 
-    unlink (fname_bak);
-    rename (fname, fname_bak);
-
-    fp = fopen (fname, "w");
+    fp = open_memstream (&buf, &len);                                      // file is written by background thread
 
     if (fp)
     {
@@ -941,11 +1044,16 @@ FileIO::write_signal_ini (void)
             fprintf (fp, "[SIGNAL]\r\n");
             fprintf (fp, "NAME=%s\r\n", Signals::signals[sigidx].get_name().c_str());
             fprintf (fp, "ADDR=%u\r\n", (unsigned int) Signals::signals[sigidx].get_addr());
+
+            if (Signals::get_position (sigidx) != sigidx)
+            {
+                fprintf (fp, "POSITION=%u\r\n", (unsigned int) Signals::get_position (sigidx));
+            }
         }
 
         Signals::data_changed = false;
-        rtc = true;
         fclose (fp);
+        rtc = queue_write (fname, fname_bak, buf, len);
     }
 
     return rtc;
@@ -960,6 +1068,7 @@ FileIO::read_led_ini (void)
     int             sigidx = -1;
     uint_fast8_t    section = 0;
     bool            rtc = false;
+    std::vector<uint16_t>   positions;                                  // display order
 
     fp = fopen (fname, "r");
 
@@ -978,6 +1087,7 @@ FileIO::read_led_ini (void)
                 }
 
                 Leds::led_groups[sigidx].set_state (0x00);
+                positions.push_back (sigidx);
                 section = LED_SECTION;
             }
 
@@ -993,11 +1103,16 @@ FileIO::read_led_ini (void)
                     {
                         Leds::led_groups[sigidx].set_addr (atoi(buf + 5));
                     }
+                    else if (! strncmp (buf, "POSITION=", 9))
+                    {
+                        positions[sigidx] = atoi(buf + 9);
+                    }
                 }
                 break;
             }
         }
 
+        Leds::set_order (positions);
         Leds::data_changed = false;
         rtc = true;
         fclose (fp);
@@ -1015,15 +1130,14 @@ FileIO::write_led_ini (void)
 {
     const char *    fname = "led.ini";
     const char *    fname_bak = "led.bak";
+    char *          buf;
+    size_t          len;
     FILE *          fp;
     uint_fast16_t   n_led_groups;
     uint_fast16_t   sigidx;
     bool            rtc = false;
 
-    unlink (fname_bak);
-    rename (fname, fname_bak);
-
-    fp = fopen (fname, "w");
+    fp = open_memstream (&buf, &len);                                      // file is written by background thread
 
     if (fp)
     {
@@ -1034,11 +1148,16 @@ FileIO::write_led_ini (void)
             fprintf (fp, "[LED]\r\n");
             fprintf (fp, "NAME=%s\r\n", Leds::led_groups[sigidx].get_name().c_str());
             fprintf (fp, "ADDR=%u\r\n", (unsigned int) Leds::led_groups[sigidx].get_addr());
+
+            if (Leds::get_position (sigidx) != sigidx)
+            {
+                fprintf (fp, "POSITION=%u\r\n", (unsigned int) Leds::get_position (sigidx));
+            }
         }
 
         Leds::data_changed = false;
-        rtc = true;
         fclose (fp);
+        rtc = queue_write (fname, fname_bak, buf, len);
     }
 
     return rtc;
@@ -1053,6 +1172,7 @@ FileIO::read_s88_ini (void)
     uint_fast16_t   coidx = 0xFFFF;
     uint_fast8_t    section = 0;
     bool            rtc = false;
+    std::vector<uint16_t>   positions;                                  // display order
 
     fp = fopen (fname, "r");
 
@@ -1070,6 +1190,7 @@ FileIO::read_s88_ini (void)
                     break;
                 }
 
+                positions.push_back (coidx);
                 section = CONTACT_SECTION;
             }
 
@@ -1090,6 +1211,10 @@ FileIO::read_s88_ini (void)
                         rridx       = htoi (buf + 11, 2);
                         S88::contacts[coidx].set_link_railroad (rrgidx, rridx);
                     }
+                    else if (! strncmp (buf, "POSITION=", 9))
+                    {
+                        positions[coidx] = atoi (buf + 9);
+                    }
                     else if (! strncmp (buf, "ACTION_IN=", 10))
                     {
                         CONTACT_ACTION  ca;
@@ -1186,6 +1311,7 @@ FileIO::read_s88_ini (void)
         }
 
         fclose (fp);
+        S88::set_order (positions);
         S88::data_changed = false;
         rtc = true;
     }
@@ -1202,6 +1328,8 @@ FileIO::write_s88_ini (void)
 {
     const char *    fname = "s88.ini";
     const char *    fname_bak = "s88.bak";
+    char *          buf;
+    size_t          len;
     FILE *          fp;
     uint_fast16_t   n_contacts;
     uint_fast8_t    n_contact_actions_in;
@@ -1213,10 +1341,7 @@ FileIO::write_s88_ini (void)
     CONTACT_ACTION  ca;
     bool            rtc = false;
 
-    unlink (fname_bak);
-    rename (fname, fname_bak);
-
-    fp = fopen (fname, "w");
+    fp = open_memstream (&buf, &len);                                      // file is written by background thread
 
     if (fp)
     {
@@ -1230,6 +1355,11 @@ FileIO::write_s88_ini (void)
             rrg_rr_idx = S88::contacts[coidx].get_link_railroad();
             fprintf (fp, "RAILROAD=%04X\r\n", (unsigned int) rrg_rr_idx);
 
+            if (S88::get_position (coidx) != coidx)
+            {
+                fprintf (fp, "POSITION=%u\r\n", (unsigned int) S88::get_position (coidx));
+            }
+
             n_contact_actions_in = S88::contacts[coidx].get_n_contact_actions (true);
 
             for (caidx = 0; caidx < n_contact_actions_in; caidx++)
@@ -1263,9 +1393,9 @@ FileIO::write_s88_ini (void)
             }
         }
 
-        rtc = true;
         S88::data_changed = false;
         fclose (fp);
+        rtc = queue_write (fname, fname_bak, buf, len);
     }
 
     return rtc;
@@ -1280,6 +1410,7 @@ FileIO::read_rcl_ini (void)
     uint_fast8_t    trackidx = 0xFF;
     uint_fast8_t    section = 0;
     bool            rtc = false;
+    std::vector<uint16_t>   positions;                                  // display order
 
     fp = fopen (fname, "r");
 
@@ -1297,6 +1428,7 @@ FileIO::read_rcl_ini (void)
                     break;
                 }
 
+                positions.push_back (trackidx);
                 section = RCLTRACK_SECTION;
             }
 
@@ -1315,6 +1447,10 @@ FileIO::read_rcl_ini (void)
                             RCL::tracks[trackidx].set_flags (RCL_TRACK_FLAG_BLOCK_PROTECTION);
                         }
                     }
+                    else if (! strncmp (buf, "POSITION=", 9))
+                    {
+                        positions[trackidx] = atoi(buf + 9);
+                    }
                     else if (! strncmp (buf, "ACTION_IN=", 10))
                     {
                         RCL_TRACK_ACTION    track_action;
@@ -1447,6 +1583,7 @@ FileIO::read_rcl_ini (void)
         }
 
         fclose (fp);
+        RCL::set_order (positions);
         RCL::data_changed = false;
         rtc = true;
     }
@@ -1463,16 +1600,15 @@ FileIO::write_rcl_ini (void)
 {
     const char *        fname = "rcl.ini";
     const char *        fname_bak = "rcl.bak";
+    char *              buf;
+    size_t              len;
     FILE *              fp;
     uint_fast8_t        trackidx;
     uint_fast8_t        paidx;
     RCL_TRACK_ACTION    track_action;
     bool                rtc = false;
 
-    unlink (fname_bak);
-    rename (fname, fname_bak);
-
-    fp = fopen (fname, "w");
+    fp = open_memstream (&buf, &len);                                      // file is written by background thread
 
     if (fp)
     {
@@ -1494,6 +1630,11 @@ FileIO::write_rcl_ini (void)
                 fprintf (fp, "FLAGS=BLOCK_PROTECTION\r\n");
             }
 
+            if (RCL::get_position (trackidx) != trackidx)
+            {
+                fprintf (fp, "POSITION=%u\r\n", (unsigned int) RCL::get_position (trackidx));
+            }
+
             n_track_actions = RCL::tracks[trackidx].get_n_track_actions (true);
 
             for (track_action_idx = 0; track_action_idx < n_track_actions; track_action_idx++)
@@ -1528,9 +1669,9 @@ FileIO::write_rcl_ini (void)
             }
         }
 
-        rtc = true;
         RCL::data_changed = false;
         fclose (fp);
+        rtc = queue_write (fname, fname_bak, buf, len);
     }
 
     return rtc;
@@ -1539,6 +1680,11 @@ FileIO::write_rcl_ini (void)
 void
 FileIO::read_all_ini_files (void)
 {
+    if (FileIO::read_snapshot ())
+    {
+        return;
+    }
+
     (void) FileIO::read_fm22_ini ();
     (void) FileIO::read_func_ini ();
     (void) FileIO::read_loco_ini ();
@@ -1547,11 +1693,14 @@ FileIO::read_all_ini_files (void)
     (void) FileIO::read_led_ini ();
     (void) FileIO::read_s88_ini ();
     (void) FileIO::read_rcl_ini ();
+
+    (void) FileIO::write_snapshot ();                                   // next start reads the snapshot
 }
 
 bool
 FileIO::write_all_ini_files (void)
 {
+    bool changed = FileIO::data_changed ();
     bool rtc = true;
 
     if (rtc && (FM22::data_changed))
@@ -1589,5 +1738,1838 @@ FileIO::write_all_ini_files (void)
         rtc = write_rcl_ini ();
     }
 
+    if (rtc && changed)
+    {
+        rtc = write_snapshot ();
+    }
+
     return rtc;
 }
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * background writer:
+ *
+ * The write_xxx_ini() functions only create a snapshot of the ini file in memory. The snapshot is queued and written by a
+ * background thread, so the control loop doesn't wait for the SD card. A newer snapshot of the same file replaces an older
+ * one which has not been written yet. The writer writes into a temporary file, syncs it, rotates the backups and renames
+ * the temporary file, so a power cut never leaves a truncated ini file. A failed write is retried after FILEIO_RETRY_DELAY.
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+    const char *        fname;
+    const char *        fname_bak;                                      // NULL: no backup
+    char *              buf;                                            // snapshot, NULL: nothing to write
+    size_t              len;
+    time_t              retry_time;                                     // 0: write as soon as possible
+    bool                is_snapshot;                                    // binary snapshot: write after all ini files
+} FILEIO_JOB;
+
+static FILEIO_JOB       jobs[FILEIO_MAX_JOBS];
+static FILEIO_STATS     stats;
+static pthread_mutex_t  fileio_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   fileio_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t        fileio_thread;
+static bool             fileio_thread_active = false;
+static bool             fileio_stop = false;
+static bool             fileio_writing = false;                         // writer thread is writing a file
+static FILEIO_SNAP_STAMP    ini_stamps[FILEIO_SNAP_N_FILES];            // ini files as read or last written by us
+
+static void             reload_check (bool local_changes);
+
+static const char *     snap_ini_files[FILEIO_SNAP_N_FILES] =
+{
+    "fm22.ini", "func.ini", "loco.ini", "switch.ini", "signal.ini", "led.ini", "s88.ini", "rcl.ini"
+};
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * snap_get_stamps () - get size and modification time of all ini files
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+snap_get_stamps (FILEIO_SNAP_STAMP * stamps)
+{
+    struct stat     st;
+    uint_fast8_t    idx;
+
+    for (idx = 0; idx < FILEIO_SNAP_N_FILES; idx++)
+    {
+        if (stat (snap_ini_files[idx], &st) == 0)
+        {
+            stamps[idx].size        = st.st_size;
+            stamps[idx].mtime_sec   = st.st_mtim.tv_sec;
+            stamps[idx].mtime_nsec  = st.st_mtim.tv_nsec;
+        }
+        else
+        {
+            stamps[idx].size        = -1;
+            stamps[idx].mtime_sec   = 0;
+            stamps[idx].mtime_nsec  = 0;
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * rotate_backups () - xxx.bak -> xxx.bak.1 -> xxx.bak.2 ..., then hard link current file to xxx.bak
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+rotate_backups (const char * fname, const char * fname_bak)
+{
+    char            from[64];
+    char            to[64];
+    uint_fast8_t    idx;
+
+    if (FILEIO_N_BACKUPS == 0 || ! fname_bak)
+    {
+        return;
+    }
+
+    for (idx = FILEIO_N_BACKUPS - 1; idx > 0; idx--)
+    {
+        if (idx == 1)
+        {
+            snprintf (from, sizeof (from), "%s", fname_bak);
+        }
+        else
+        {
+            snprintf (from, sizeof (from), "%s.%u", fname_bak, idx - 1);
+        }
+
+        snprintf (to, sizeof (to), "%s.%u", fname_bak, idx);
+        (void) rename (from, to);
+    }
+
+    unlink (fname_bak);
+
+    if (link (fname, fname_bak) < 0 && errno != ENOENT)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "FileIO: cannot create backup %s: %s\n", fname_bak, strerror (errno));
+    }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * write_file () - write file atomically: write temporary file, sync, rotate backups, rename
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+write_file (const char * fname, const char * fname_bak, const char * buf, size_t len)
+{
+    char            tmpname[64];
+    size_t          pos = 0;
+    int             fd;
+    int             dirfd;
+
+    snprintf (tmpname, sizeof (tmpname), "%s.tmp", fname);
+
+    fd = open (tmpname, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "FileIO: cannot open %s: %s\n", tmpname, strerror (errno));
+        return false;
+    }
+
+    while (pos < len)
+    {
+        ssize_t n = write (fd, buf + pos, len - pos);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            Debug::printf (DEBUG_LEVEL_NONE, "FileIO: cannot write %s: %s\n", tmpname, strerror (errno));
+            close (fd);
+            unlink (tmpname);
+            return false;
+        }
+
+        pos += n;
+    }
+
+    if (fsync (fd) < 0 || close (fd) < 0)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "FileIO: cannot sync %s: %s\n", tmpname, strerror (errno));
+        unlink (tmpname);
+        return false;
+    }
+
+    rotate_backups (fname, fname_bak);
+
+    if (rename (tmpname, fname) < 0)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "FileIO: cannot rename %s to %s: %s\n", tmpname, fname, strerror (errno));
+        unlink (tmpname);
+        return false;
+    }
+
+    dirfd = open (".", O_RDONLY | O_DIRECTORY);                         // make rename persistent
+
+    if (dirfd >= 0)
+    {
+        (void) fsync (dirfd);
+        close (dirfd);
+    }
+
+    return true;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * write_job () - write ini file or binary snapshot. The binary snapshot gets the stamps of the ini files just before it is written.
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+write_job (const char * fname, const char * fname_bak, char * buf, size_t len, bool is_snapshot)
+{
+    if (is_snapshot)
+    {
+        FILEIO_SNAP_HEADER *    hp = (FILEIO_SNAP_HEADER *) buf;
+
+        snap_get_stamps (hp->stamps);
+        hp->crc = crc32 (0L, (Bytef *) buf + sizeof (FILEIO_SNAP_HEADER), len - sizeof (FILEIO_SNAP_HEADER));
+    }
+
+    return write_file (fname, fname_bak, buf, len);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * writer () - background thread, writes queued snapshots
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void *
+writer (void *)
+{
+    pthread_mutex_lock (&fileio_mutex);
+
+    while (1)
+    {
+        FILEIO_JOB *    jp = (FILEIO_JOB *) NULL;
+        FILEIO_JOB *    snapshot_jp = (FILEIO_JOB *) NULL;
+        time_t          now = time ((time_t *) NULL);
+        time_t          next_retry = 0;
+        bool            ini_pending = false;
+        uint_fast8_t    idx;
+
+        for (idx = 0; idx < FILEIO_MAX_JOBS; idx++)
+        {
+            if (jobs[idx].buf)
+            {
+                if (jobs[idx].is_snapshot)
+                {
+                    snapshot_jp = jobs + idx;
+                    continue;
+                }
+
+                ini_pending = true;
+
+                if (jobs[idx].retry_time <= now)
+                {
+                    jp = jobs + idx;
+                    break;
+                }
+                else if (! next_retry || jobs[idx].retry_time < next_retry)
+                {
+                    next_retry = jobs[idx].retry_time;
+                }
+            }
+        }
+
+        if (! ini_pending && snapshot_jp)                               // snapshot must match the written ini files
+        {
+            if (snapshot_jp->retry_time <= now)
+            {
+                jp = snapshot_jp;
+            }
+            else
+            {
+                next_retry = snapshot_jp->retry_time;
+            }
+        }
+
+        if (jp)
+        {
+            char *          buf = jp->buf;
+            size_t          len = jp->len;
+            struct timeval  start;
+            struct timeval  end;
+            uint32_t        duration;
+            bool            rtc;
+
+            jp->buf = (char *) NULL;
+            fileio_writing = true;
+            pthread_mutex_unlock (&fileio_mutex);
+
+            gettimeofday (&start, NULL);
+            rtc = write_job (jp->fname, jp->fname_bak, buf, len, jp->is_snapshot);
+            gettimeofday (&end, NULL);
+            duration = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_usec - start.tv_usec);
+
+            pthread_mutex_lock (&fileio_mutex);
+
+            fileio_writing          = false;
+            stats.last_duration     = duration;
+            stats.total_duration   += duration;
+
+            if (stats.max_duration < duration)
+            {
+                stats.max_duration = duration;
+            }
+
+            if (rtc)
+            {
+                if (jp->is_snapshot)
+                {
+                    memcpy (ini_stamps, ((FILEIO_SNAP_HEADER *) buf)->stamps, sizeof (ini_stamps));
+                }
+
+                stats.n_written++;
+                stats.bytes_written += len;
+                free (buf);
+            }
+            else
+            {
+                stats.n_failed++;
+
+                if (jp->buf)                                            // newer snapshot queued meanwhile
+                {
+                    free (buf);
+                }
+                else
+                {
+                    jp->buf         = buf;
+                    jp->len         = len;
+                    jp->retry_time  = time ((time_t *) NULL) + FILEIO_RETRY_DELAY;
+                }
+            }
+        }
+        else if (fileio_stop)
+        {
+            break;
+        }
+        else if (next_retry)
+        {
+            struct timespec ts;
+
+            ts.tv_sec   = next_retry;
+            ts.tv_nsec  = 0;
+            pthread_cond_timedwait (&fileio_cond, &fileio_mutex, &ts);
+        }
+        else
+        {
+            pthread_cond_wait (&fileio_cond, &fileio_mutex);
+        }
+    }
+
+    pthread_mutex_unlock (&fileio_mutex);
+    return NULL;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * queue_job () - queue snapshot of file, takes ownership of buf
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+queue_job (const char * fname, const char * fname_bak, char * buf, size_t len, bool is_snapshot)
+{
+    FILEIO_JOB *    jp = (FILEIO_JOB *) NULL;
+    uint_fast8_t    idx;
+
+    if (! fileio_thread_active)                                         // no background thread: write synchronously
+    {
+        bool rtc = write_job (fname, fname_bak, buf, len, is_snapshot);
+
+        if (rtc && is_snapshot)
+        {
+            memcpy (ini_stamps, ((FILEIO_SNAP_HEADER *) buf)->stamps, sizeof (ini_stamps));
+        }
+
+        free (buf);
+        return rtc;
+    }
+
+    pthread_mutex_lock (&fileio_mutex);
+
+    for (idx = 0; idx < FILEIO_MAX_JOBS; idx++)
+    {
+        if (jobs[idx].fname == fname || ! jobs[idx].fname)
+        {
+            jp = jobs + idx;
+            break;
+        }
+    }
+
+    if (jp)
+    {
+        if (jp->buf)
+        {
+            free (jp->buf);
+            stats.n_coalesced++;
+        }
+
+        jp->fname       = fname;
+        jp->fname_bak   = fname_bak;
+        jp->buf         = buf;
+        jp->len         = len;
+        jp->retry_time  = 0;
+        jp->is_snapshot = is_snapshot;
+        stats.n_queued++;
+        pthread_cond_signal (&fileio_cond);
+    }
+
+    pthread_mutex_unlock (&fileio_mutex);
+
+    if (! jp)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "FileIO: too many files, cannot write %s\n", fname);
+        free (buf);
+        return false;
+    }
+
+    return true;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * FileIO::queue_write () - queue snapshot of ini file, takes ownership of buf
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+FileIO::queue_write (const char * fname, const char * fname_bak, char * buf, size_t len)
+{
+    return queue_job (fname, fname_bak, buf, len, false);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * FileIO::init () - start background writer
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+FileIO::init (void)
+{
+    snap_get_stamps (ini_stamps);
+
+    if (pthread_create (&fileio_thread, NULL, writer, NULL) == 0)
+    {
+        fileio_thread_active = true;
+    }
+    else
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "FileIO: cannot start writer thread, writing synchronously\n");
+    }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * FileIO::deinit () - write pending changes and stop background writer
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+FileIO::deinit (void)
+{
+    uint_fast8_t    idx;
+
+    if (FileIO::data_changed ())
+    {
+        (void) FileIO::write_all_ini_files ();
+    }
+
+    if (fileio_thread_active)
+    {
+        pthread_mutex_lock (&fileio_mutex);
+
+        for (idx = 0; idx < FILEIO_MAX_JOBS; idx++)                     // last try for failed files
+        {
+            jobs[idx].retry_time = 0;
+        }
+
+        fileio_stop = true;
+        pthread_cond_signal (&fileio_cond);
+        pthread_mutex_unlock (&fileio_mutex);
+
+        pthread_join (fileio_thread, NULL);
+        fileio_thread_active = false;
+    }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * FileIO::data_changed () - check if any ini file has to be written
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+FileIO::data_changed (void)
+{
+    return FM22::data_changed || Locos::data_changed || AddOns::data_changed || Switches::data_changed || RailroadGroups::data_changed ||
+           Signals::data_changed || Leds::data_changed || S88::data_changed || RCL::data_changed;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * FileIO::schedule () - autosave: batch all changes within FILEIO_AUTOSAVE_DELAY after first change, then queue them.
+ * Reload ini files which were changed by someone else, see reload_check ()
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+FileIO::schedule (void)
+{
+    static unsigned long    first_change_millis;
+    static bool             changed = false;
+
+    if (FILEIO_AUTOSAVE_DELAY > 0 && FileIO::data_changed ())
+    {
+        unsigned long   now = Millis::elapsed ();
+
+        if (! changed)
+        {
+            first_change_millis = now;
+            changed = true;
+        }
+        else if (now - first_change_millis >= FILEIO_AUTOSAVE_DELAY)
+        {
+            (void) FileIO::write_all_ini_files ();
+            changed = false;
+        }
+    }
+    else
+    {
+        changed = false;
+    }
+
+    reload_check (FileIO::data_changed ());
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * FileIO::get_stats () - get statistics of background writer
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+FileIO::get_stats (FILEIO_STATS * statsp)
+{
+    uint_fast8_t    idx;
+
+    pthread_mutex_lock (&fileio_mutex);
+
+    *statsp = stats;
+    statsp->n_pending = 0;
+
+    for (idx = 0; idx < FILEIO_MAX_JOBS; idx++)
+    {
+        if (jobs[idx].buf)
+        {
+            statsp->n_pending++;
+        }
+    }
+
+    pthread_mutex_unlock (&fileio_mutex);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * binary snapshot:
+ *
+ * Reading the ini files needs a lot of string compares and searches of function names. The snapshot contains the same data
+ * as fixed size records and a string table. It is written after the ini files and mapped into memory at startup. It is only
+ * used if size and modification time of all ini files match the stamps in its header, otherwise the ini files are read.
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static std::vector<FILEIO_SNAP_RECORD>  snap_records;
+static std::string                      snap_strings;
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * snap_add () - add record, name can be NULL. Values have to be filled in by the caller.
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static FILEIO_SNAP_RECORD *
+snap_add (uint_fast8_t type, const char * name)
+{
+    FILEIO_SNAP_RECORD  rec;
+
+    memset (&rec, 0, sizeof (rec));
+    rec.type = type;
+
+    if (name)
+    {
+        rec.name = snap_strings.length ();
+        snap_strings.append (name);
+        snap_strings.push_back ('\0');
+    }
+    else
+    {
+        rec.name = FILEIO_SNAP_NO_NAME;
+    }
+
+    snap_records.push_back (rec);
+    return &snap_records.back ();
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * snap_add_action () - add record with action and its parameters
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+snap_add_action (uint_fast8_t type, const uint16_t * values, uint_fast8_t n_values, const uint16_t * parameters, uint_fast8_t n_parameters)
+{
+    FILEIO_SNAP_RECORD *    rp = snap_add (type, (const char *) NULL);
+    uint_fast8_t            idx;
+
+    for (idx = 0; idx < n_values; idx++)
+    {
+        rp->values[rp->n_values++] = values[idx];
+    }
+
+    for (idx = 0; idx < n_parameters && rp->n_values < FILEIO_SNAP_MAX_VALUES; idx++)
+    {
+        rp->values[rp->n_values++] = parameters[idx];
+    }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * FileIO::write_snapshot () - create binary snapshot of all data, written by background thread after all ini files
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+FileIO::write_snapshot (void)
+{
+    FILEIO_SNAP_RECORD *    rp;
+    FILEIO_SNAP_HEADER      header;
+    uint_fast16_t           n_functions     = Functions::get_n_entries ();
+    uint_fast16_t           n_locos         = Locos::get_n_locos ();
+    uint_fast16_t           n_addons        = AddOns::get_n_addons ();
+    uint_fast16_t           n_switches      = Switches::get_n_switches ();
+    uint_fast8_t            n_rrgs          = RailroadGroups::get_n_railroad_groups ();
+    uint_fast16_t           n_signals       = Signals::get_n_signals ();
+    uint_fast16_t           n_leds          = Leds::get_n_led_groups ();
+    uint_fast16_t           n_contacts      = S88::get_n_contacts ();
+    uint_fast8_t            n_tracks        = RCL::get_n_tracks ();
+    uint_fast16_t           idx;
+    uint_fast8_t            fidx;
+    uint_fast8_t            midx;
+    uint_fast8_t            aidx;
+    uint_fast8_t            n_actions;
+    uint_fast8_t            rrgidx;
+    uint_fast8_t            rridx;
+    uint_fast8_t            subidx;
+    uint_fast8_t            dir;
+    bool                    in;
+    size_t                  records_size;
+    size_t                  len;
+    char *                  buf;
+
+    snap_records.clear ();
+    snap_strings.clear ();
+
+    rp = snap_add (FILEIO_SNAP_FM22, (const char *) NULL);
+    rp->values[0] = FM22::get_shortcut_value ();
+    rp->values[1] = FM22::get_compression_level ();
+    rp->values[2] = FM22::get_switch_power ();
+    rp->n_values  = 3;
+
+    for (idx = 0; idx < n_functions; idx++)
+    {
+        (void) snap_add (FILEIO_SNAP_FUNCTION, Functions::get (idx).c_str());
+    }
+
+    for (idx = 0; idx < n_locos; idx++)
+    {
+        Loco *          lp = &Locos::locos[idx];
+        LOCOACTION      la;
+
+        rp = snap_add (FILEIO_SNAP_LOCO, lp->get_name().c_str());
+        rp->values[0] = lp->is_active () ? 1 : 0;
+        rp->values[1] = lp->get_addr ();
+        rp->values[2] = lp->get_speed_steps ();
+        rp->values[3] = Locos::get_position (idx);
+        rp->n_values  = 4;
+
+        for (fidx = 0; fidx < MAX_LOCO_FUNCTIONS; fidx++)
+        {
+            uint_fast16_t   function_name_idx = lp->get_function_name_idx (fidx);
+
+            if (function_name_idx < MAX_FUNCTION_NAMES && lp->get_function_name (fidx).length() > 0)
+            {
+                rp = snap_add (FILEIO_SNAP_LOCO_FUNCTION, (const char *) NULL);
+                rp->values[0] = fidx;
+                rp->values[1] = function_name_idx;
+                rp->values[2] = lp->get_function_pulse (fidx);
+                rp->values[3] = lp->get_function_sound (fidx);
+                rp->n_values  = 4;
+            }
+        }
+
+        for (midx = 0; midx < MAX_LOCO_MACROS_PER_LOCO; midx++)
+        {
+            n_actions = lp->get_n_macro_actions (midx);
+
+            for (aidx = 0; aidx < n_actions; aidx++)
+            {
+                if (lp->get_macro_action (midx, aidx, &la))
+                {
+                    uint16_t values[3] = { midx, la.action, la.n_parameters };
+                    snap_add_action (FILEIO_SNAP_LOCO_MACRO, values, 3, la.parameters, la.n_parameters);
+                }
+            }
+        }
+    }
+
+    for (idx = 0; idx < n_addons; idx++)
+    {
+        AddOn *         ap = &AddOns::addons[idx];
+        uint_fast16_t   addon_loco_idx = ap->get_loco ();
+
+        rp = snap_add (FILEIO_SNAP_ADDON, ap->get_name().c_str());
+        rp->values[0] = ap->is_active () ? 1 : 0;
+        rp->values[1] = ap->get_addr ();
+        rp->values[2] = AddOns::get_position (idx);
+        rp->n_values  = 3;
+
+        for (fidx = 0; fidx < MAX_LOCO_FUNCTIONS; fidx++)
+        {
+            uint_fast16_t   function_name_idx = ap->get_function_name_idx (fidx);
+
+            if (function_name_idx < MAX_FUNCTION_NAMES && ap->get_function_name (fidx).length() > 0)
+            {
+                rp = snap_add (FILEIO_SNAP_ADDON_FUNCTION, (const char *) NULL);
+                rp->values[0] = fidx;
+                rp->values[1] = function_name_idx;
+                rp->values[2] = ap->get_function_pulse (fidx);
+                rp->values[3] = ap->get_function_sound (fidx);
+                rp->n_values  = 4;
+            }
+        }
+
+        rp = snap_add (FILEIO_SNAP_ADDON_LOCO, (const char *) NULL);
+        rp->values[0] = addon_loco_idx;
+        rp->n_values  = 1;
+
+        if (addon_loco_idx < n_locos)
+        {
+            for (fidx = 0; fidx < MAX_LOCO_FUNCTIONS; fidx++)
+            {
+                uint_fast8_t afidx = Locos::locos[addon_loco_idx].get_coupled_function (fidx);
+
+                if (afidx != 0xFF)
+                {
+                    rp = snap_add (FILEIO_SNAP_ADDON_COUPLE, (const char *) NULL);
+                    rp->values[0] = addon_loco_idx;
+                    rp->values[1] = fidx;
+                    rp->values[2] = afidx;
+                    rp->n_values  = 3;
+                }
+            }
+        }
+    }
+
+    for (idx = 0; idx < n_switches; idx++)
+    {
+        rp = snap_add (FILEIO_SNAP_SWITCH, Switches::switches[idx].get_name().c_str());
+        rp->values[0] = Switches::switches[idx].get_addr ();
+        rp->values[1] = Switches::switches[idx].get_flags ();
+        rp->values[2] = Switches::switches[idx].get_pulse ();
+        rp->values[3] = Switches::get_position (idx);
+        rp->n_values  = 4;
+    }
+
+    for (rrgidx = 0; rrgidx < n_rrgs; rrgidx++)
+    {
+        RailroadGroup * rrgp = &RailroadGroups::railroad_groups[rrgidx];
+        uint_fast8_t    n_railroads = rrgp->get_n_railroads ();
+
+        rp = snap_add (FILEIO_SNAP_RAILROAD_GROUP, rrgp->get_name().c_str());
+        rp->values[0] = RailroadGroups::get_position (rrgidx);
+        rp->n_values  = 1;
+
+        for (rridx = 0; rridx < n_railroads; rridx++)
+        {
+            Railroad *      rrp = &rrgp->railroads[rridx];
+            uint_fast8_t    n_rr_switches = rrp->get_n_switches ();
+
+            rp = snap_add (FILEIO_SNAP_RAILROAD, rrp->get_name().c_str());
+            rp->values[0] = rrp->get_link_loco ();
+            rp->values[1] = rrgp->get_position (rridx);
+            rp->n_values  = 2;
+
+            for (subidx = 0; subidx < n_rr_switches; subidx++)
+            {
+                rp = snap_add (FILEIO_SNAP_RAILROAD_SWITCH, (const char *) NULL);
+                rp->values[0] = rrp->get_switch_idx (subidx);
+                rp->values[1] = rrp->get_switch_state (subidx);
+                rp->n_values  = 2;
+            }
+        }
+    }
+
+    for (idx = 0; idx < n_signals; idx++)
+    {
+        rp = snap_add (FILEIO_SNAP_SIGNAL, Signals::signals[idx].get_name().c_str());
+        rp->values[0] = Signals::signals[idx].get_addr ();
+        rp->values[1] = Signals::get_position (idx);
+        rp->n_values  = 2;
+    }
+
+    for (idx = 0; idx < n_leds; idx++)
+    {
+        rp = snap_add (FILEIO_SNAP_LED, Leds::led_groups[idx].get_name().c_str());
+        rp->values[0] = Leds::led_groups[idx].get_addr ();
+        rp->values[1] = Leds::get_position (idx);
+        rp->n_values  = 2;
+    }
+
+    for (idx = 0; idx < n_contacts; idx++)
+    {
+        S88_Contact *   cp = &S88::contacts[idx];
+        uint_fast16_t   rrg_rr_idx = cp->get_link_railroad ();
+        CONTACT_ACTION  ca;
+
+        rp = snap_add (FILEIO_SNAP_CONTACT, cp->get_name().c_str());
+        rp->values[0] = rrg_rr_idx >> 8;
+        rp->values[1] = rrg_rr_idx & 0xFF;
+        rp->values[2] = S88::get_position (idx);
+        rp->n_values  = 3;
+
+        for (dir = 0; dir < 2; dir++)                                   // actions "in" first, then actions "out"
+        {
+            in = (dir == 0);
+            n_actions = cp->get_n_contact_actions (in);
+
+            for (aidx = 0; aidx < n_actions; aidx++)
+            {
+                if (cp->get_contact_action (in, aidx, &ca))
+                {
+                    uint16_t values[3] = { in, ca.action, ca.n_parameters };
+                    snap_add_action (FILEIO_SNAP_CONTACT_ACTION, values, 3, ca.parameters, ca.n_parameters);
+                }
+            }
+        }
+    }
+
+    for (idx = 0; idx < n_tracks; idx++)
+    {
+        RCL_Track *         tp = &RCL::tracks[idx];
+        RCL_TRACK_ACTION    ta;
+
+        rp = snap_add (FILEIO_SNAP_RCLTRACK, tp->get_name().c_str());
+        rp->values[0] = tp->get_flags () & RCL_TRACK_FLAG_BLOCK_PROTECTION;
+        rp->values[1] = RCL::get_position (idx);
+        rp->n_values  = 2;
+
+        for (dir = 0; dir < 2; dir++)                                   // actions "in" first, then actions "out"
+        {
+            in = (dir == 0);
+            n_actions = tp->get_n_track_actions (in);
+
+            for (aidx = 0; aidx < n_actions; aidx++)
+            {
+                if (tp->get_track_action (in, aidx, &ta))
+                {
+                    uint16_t values[5] = { in, ta.condition, ta.condition_destination, ta.action, ta.n_parameters };
+                    snap_add_action (FILEIO_SNAP_RCLTRACK_ACTION, values, 5, ta.parameters, ta.n_parameters);
+                }
+            }
+        }
+    }
+
+    records_size = snap_records.size() * sizeof (FILEIO_SNAP_RECORD);
+    len = sizeof (FILEIO_SNAP_HEADER) + records_size + snap_strings.length();
+    buf = (char *) malloc (len);
+
+    if (! buf)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "FileIO: out of memory\n");
+        return false;
+    }
+
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, FILEIO_SNAP_MAGIC, sizeof (header.magic));
+    header.version      = FILEIO_SNAP_VERSION;
+    header.n_records    = snap_records.size();
+    header.strings_size = snap_strings.length();                        // stamps and crc are set by write_job()
+
+    memcpy (buf, &header, sizeof (header));
+    memcpy (buf + sizeof (header), snap_records.data(), records_size);
+    memcpy (buf + sizeof (header) + records_size, snap_strings.data(), snap_strings.length());
+
+    snap_records.clear ();
+    snap_strings.clear ();
+
+    return queue_job (FILEIO_SNAP_FILE, (const char *) NULL, buf, len, true);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * snap_check () - check header, records and stamps of mapped snapshot
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+snap_check (const char * buf, size_t len)
+{
+    const FILEIO_SNAP_HEADER *  hp = (const FILEIO_SNAP_HEADER *) buf;
+    const FILEIO_SNAP_RECORD *  records;
+    const char *                strings;
+    FILEIO_SNAP_STAMP           stamps[FILEIO_SNAP_N_FILES];
+    uint32_t                    idx;
+
+    if (len < sizeof (FILEIO_SNAP_HEADER) || memcmp (hp->magic, FILEIO_SNAP_MAGIC, sizeof (hp->magic)) || hp->version != FILEIO_SNAP_VERSION)
+    {
+        Debug::printf (DEBUG_LEVEL_NORMAL, "%s: invalid header\n", FILEIO_SNAP_FILE);
+        return false;
+    }
+
+    if (len != sizeof (FILEIO_SNAP_HEADER) + (size_t) hp->n_records * sizeof (FILEIO_SNAP_RECORD) + hp->strings_size)
+    {
+        Debug::printf (DEBUG_LEVEL_NORMAL, "%s: invalid size\n", FILEIO_SNAP_FILE);
+        return false;
+    }
+
+    if (crc32 (0L, (const Bytef *) buf + sizeof (FILEIO_SNAP_HEADER), len - sizeof (FILEIO_SNAP_HEADER)) != hp->crc)
+    {
+        Debug::printf (DEBUG_LEVEL_NORMAL, "%s: checksum error\n", FILEIO_SNAP_FILE);
+        return false;
+    }
+
+    snap_get_stamps (stamps);
+
+    if (memcmp (stamps, hp->stamps, sizeof (stamps)))
+    {
+        Debug::printf (DEBUG_LEVEL_NORMAL, "%s: ini files have changed\n", FILEIO_SNAP_FILE);
+        return false;
+    }
+
+    records = (const FILEIO_SNAP_RECORD *) (buf + sizeof (FILEIO_SNAP_HEADER));
+    strings = (const char *) (records + hp->n_records);
+
+    if (hp->strings_size > 0 && strings[hp->strings_size - 1] != '\0')
+    {
+        Debug::printf (DEBUG_LEVEL_NORMAL, "%s: invalid string table\n", FILEIO_SNAP_FILE);
+        return false;
+    }
+
+    for (idx = 0; idx < hp->n_records; idx++)
+    {
+        const FILEIO_SNAP_RECORD *  rp              = records + idx;
+        uint_fast8_t                n_fixed         = 0;                // values before action parameters
+        uint_fast8_t                max_parameters  = 0;
+
+        switch (rp->type)
+        {
+            case FILEIO_SNAP_LOCO_MACRO:        n_fixed = 3; max_parameters = LOCO_MAX_ACTION_PARAMETERS;   break;
+            case FILEIO_SNAP_CONTACT_ACTION:    n_fixed = 3; max_parameters = S88_MAX_ACTION_PARAMETERS;    break;
+            case FILEIO_SNAP_RCLTRACK_ACTION:   n_fixed = 5; max_parameters = RCL_MAX_ACTION_PARAMETERS;    break;
+        }
+
+        if (rp->n_values > FILEIO_SNAP_MAX_VALUES ||
+            (rp->name != FILEIO_SNAP_NO_NAME && rp->name >= hp->strings_size) ||
+            (n_fixed && (rp->n_values < n_fixed || rp->values[n_fixed - 1] > max_parameters ||
+                         rp->values[n_fixed - 1] > rp->n_values - n_fixed)))
+        {
+            Debug::printf (DEBUG_LEVEL_NORMAL, "%s: invalid record %u\n", FILEIO_SNAP_FILE, idx);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * snap_apply () - create objects from records
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+snap_apply (const FILEIO_SNAP_RECORD * records, uint32_t n_records, const char * strings)
+{
+    uint_fast16_t   loco_idx    = 0xFFFF;
+    uint_fast16_t   addon_idx   = 0xFFFF;
+    uint_fast16_t   swidx       = 0xFFFF;
+    uint_fast8_t    rrgidx      = 0xFF;
+    uint_fast8_t    rridx       = 0xFF;
+    uint_fast16_t   sigidx      = 0xFFFF;
+    uint_fast16_t   ledidx      = 0xFFFF;
+    uint_fast16_t   coidx       = 0xFFFF;
+    uint_fast8_t    trackidx    = 0xFF;
+    uint32_t        n_type[FILEIO_SNAP_RCLTRACK_ACTION + 1] = { 0 };
+    uint32_t        ridx;
+    std::vector<uint16_t>   positions;                                  // display order of locos
+    std::vector<uint16_t>   switch_positions;
+    std::vector<uint16_t>   railroad_group_positions;
+    std::vector<uint16_t>   signal_positions;
+    std::vector<uint16_t>   led_positions;
+    std::vector<uint16_t>   contact_positions;
+    std::vector<uint16_t>   addon_positions;
+    std::vector<uint16_t>   track_positions;
+    std::vector<std::vector<uint16_t>>  railroad_positions;             // display order of railroads per group
+
+    for (ridx = 0; ridx < n_records; ridx++)                            // reserve vectors, no reallocation while adding objects
+    {
+        if (records[ridx].type <= FILEIO_SNAP_RCLTRACK_ACTION)
+        {
+            n_type[records[ridx].type]++;
+        }
+    }
+
+    Locos::locos.reserve (Locos::locos.size() + n_type[FILEIO_SNAP_LOCO]);
+    AddOns::addons.reserve (AddOns::addons.size() + n_type[FILEIO_SNAP_ADDON]);
+    Switches::switches.reserve (Switches::switches.size() + n_type[FILEIO_SNAP_SWITCH]);
+    RailroadGroups::railroad_groups.reserve (RailroadGroups::railroad_groups.size() + n_type[FILEIO_SNAP_RAILROAD_GROUP]);
+    Signals::signals.reserve (Signals::signals.size() + n_type[FILEIO_SNAP_SIGNAL]);
+    Leds::led_groups.reserve (Leds::led_groups.size() + n_type[FILEIO_SNAP_LED]);
+    S88::contacts.reserve (S88::contacts.size() + n_type[FILEIO_SNAP_CONTACT]);
+    RCL::tracks.reserve (RCL::tracks.size() + n_type[FILEIO_SNAP_RCLTRACK]);
+
+    for (ridx = 0; ridx < n_records; ridx++)
+    {
+        const FILEIO_SNAP_RECORD *  rp      = records + ridx;
+        const uint16_t *            v       = rp->values;
+        const char *                name    = (rp->name != FILEIO_SNAP_NO_NAME) ? strings + rp->name : "";
+
+        switch (rp->type)
+        {
+            case FILEIO_SNAP_FM22:
+            {
+                FM22::set_shortcut_value (v[0]);
+                FM22::set_compression_level (v[1]);
+                FM22::set_switch_power (v[2]);
+                break;
+            }
+
+            case FILEIO_SNAP_FUNCTION:
+            {
+                Functions::add (name);
+                break;
+            }
+
+            case FILEIO_SNAP_LOCO:
+            {
+                if ((loco_idx = Locos::add ({})) == 0xFFFF)
+                {
+                    Debug::printf (DEBUG_LEVEL_NONE, "%s: error: maximum number of locos reached.\n", FILEIO_SNAP_FILE);
+                    return;
+                }
+
+                Locos::locos[loco_idx].activate ();
+                Locos::locos[loco_idx].set_name (name);
+
+                if (! v[0])
+                {
+                    Locos::locos[loco_idx].deactivate ();
+                }
+
+                Locos::locos[loco_idx].set_addr (v[1]);
+                Locos::locos[loco_idx].set_speed_steps (v[2]);
+                positions.push_back (v[3]);
+                break;
+            }
+
+            case FILEIO_SNAP_LOCO_FUNCTION:
+            {
+                if (loco_idx != 0xFFFF)
+                {
+                    Locos::locos[loco_idx].set_function_type (v[0], v[1], v[2], v[3]);
+                }
+                break;
+            }
+
+            case FILEIO_SNAP_LOCO_MACRO:
+            {
+                if (loco_idx != 0xFFFF)
+                {
+                    LOCOACTION      la;
+                    uint_fast8_t    actionidx;
+
+                    la.action       = v[1];
+                    la.n_parameters = v[2];
+                    memcpy (la.parameters, v + 3, la.n_parameters * sizeof (uint16_t));
+
+                    actionidx = Locos::locos[loco_idx].add_macro_action (v[0]);
+
+                    if (actionidx == 0xFF)
+                    {
+                        Debug::printf (DEBUG_LEVEL_NONE, "%s: error: maximum number of loco macro actions reached.\n", FILEIO_SNAP_FILE);
+                        return;
+                    }
+
+                    Locos::locos[loco_idx].set_macro_action (v[0], actionidx, &la);
+                }
+                break;
+            }
+
+            case FILEIO_SNAP_ADDON:
+            {
+                if ((addon_idx = AddOns::add ({})) == 0xFFFF)
+                {
+                    Debug::printf (DEBUG_LEVEL_NONE, "%s: error: maximum number of addons reached.\n", FILEIO_SNAP_FILE);
+                    return;
+                }
+
+                AddOns::addons[addon_idx].activate ();
+                AddOns::addons[addon_idx].set_name (name);
+
+                if (! v[0])
+                {
+                    AddOns::addons[addon_idx].deactivate ();
+                }
+
+                AddOns::addons[addon_idx].set_addr (v[1]);
+                addon_positions.push_back (v[2]);
+                break;
+            }
+
+            case FILEIO_SNAP_ADDON_FUNCTION:
+            {
+                if (addon_idx != 0xFFFF)
+                {
+                    AddOns::addons[addon_idx].set_function_type (v[0], v[1], v[2], v[3]);
+                }
+                break;
+            }
+
+            case FILEIO_SNAP_ADDON_LOCO:
+            {
+                if (addon_idx != 0xFFFF && v[0] < Locos::get_n_locos ())
+                {
+                    Locos::locos[v[0]].set_addon (addon_idx);
+                    AddOns::addons[addon_idx].set_loco (v[0]);
+                }
+                break;
+            }
+
+            case FILEIO_SNAP_ADDON_COUPLE:
+            {
+                if (v[0] < Locos::get_n_locos ())
+                {
+                    Locos::locos[v[0]].set_coupled_function (v[1], v[2]);
+                }
+                break;
+            }
+
+            case FILEIO_SNAP_SWITCH:
+            {
+                if ((swidx = Switches::add ({})) == 0xFFFF)
+                {
+                    Debug::printf (DEBUG_LEVEL_NONE, "%s: error: maximum number of switches reached.\n", FILEIO_SNAP_FILE);
+                    return;
+                }
+
+                Switches::switches[swidx].set_state (DCC_SWITCH_STATE_UNDEFINED);
+                Switches::switches[swidx].set_name (name);
+                Switches::switches[swidx].set_addr (v[0]);
+                Switches::switches[swidx].set_flags (v[1]);
+                Switches::switches[swidx].set_pulse (v[2]);
+                switch_positions.push_back (v[3]);
+                break;
+            }
+
+            case FILEIO_SNAP_RAILROAD_GROUP:
+            {
+                if ((rrgidx = RailroadGroups::add ({})) == 0xFF)
+                {
+                    return;
+                }
+
+                RailroadGroups::railroad_groups[rrgidx].set_name (name);
+                railroad_group_positions.push_back (v[0]);
+                railroad_positions.push_back ({});
+                break;
+            }
+
+            case FILEIO_SNAP_RAILROAD:
+            {
+                if (rrgidx == 0xFF || (rridx = RailroadGroups::railroad_groups[rrgidx].add({})) == 0xFF)
+                {
+                    Debug::printf (DEBUG_LEVEL_NONE, "%s: error: maximum number of railroads reached.\n", FILEIO_SNAP_FILE);
+                    return;
+                }
+
+                RailroadGroups::railroad_groups[rrgidx].railroads[rridx].set_name (name);
+                RailroadGroups::railroad_groups[rrgidx].railroads[rridx].set_link_loco (v[0]);
+                railroad_positions.back().push_back (v[1]);
+                break;
+            }
+
+            case FILEIO_SNAP_RAILROAD_SWITCH:
+            {
+                uint_fast8_t    subidx;
+
+                if (rrgidx == 0xFF || rridx == 0xFF ||
+                    (subidx = RailroadGroups::railroad_groups[rrgidx].railroads[rridx].add_switch()) == 0xFF)
+                {
+                    Debug::printf (DEBUG_LEVEL_NONE, "%s: error: maximum number of railroad switches reached.\n", FILEIO_SNAP_FILE);
+                    return;
+                }
+
+                RailroadGroups::railroad_groups[rrgidx].railroads[rridx].set_switch_idx (subidx, v[0]);
+                RailroadGroups::railroad_groups[rrgidx].railroads[rridx].set_switch_state (subidx, v[1]);
+                break;
+            }
+
+            case FILEIO_SNAP_SIGNAL:
+            {
+                if ((sigidx = Signals::add ({})) == 0xFFFF)
+                {
+                    Debug::printf (DEBUG_LEVEL_NONE, "%s: error: maximum number of signals reached.\n", FILEIO_SNAP_FILE);
+                    return;
+                }
+
+                Signals::signals[sigidx].set_state (DCC_SWITCH_STATE_UNDEFINED);
+                Signals::signals[sigidx].set_name (name);
+                Signals::signals[sigidx].set_addr (v[0]);
+                signal_positions.push_back (v[1]);
+                break;
+            }
+
+            case FILEIO_SNAP_LED:
+            {
+                if ((ledidx = Leds::add ({})) == 0xFFFF)
+                {
+                    Debug::printf (DEBUG_LEVEL_NONE, "%s: error: maximum number of leds reached.\n", FILEIO_SNAP_FILE);
+                    return;
+                }
+
+                Leds::led_groups[ledidx].set_state (0x00);
+                Leds::led_groups[ledidx].set_name (name);
+                Leds::led_groups[ledidx].set_addr (v[0]);
+                led_positions.push_back (v[1]);
+                break;
+            }
+
+            case FILEIO_SNAP_CONTACT:
+            {
+                if ((coidx = S88::add ({})) == 0xFFFF)
+                {
+                    Debug::printf (DEBUG_LEVEL_NONE, "%s: error: maximum number of contacts reached.\n", FILEIO_SNAP_FILE);
+                    return;
+                }
+
+                S88::contacts[coidx].set_name (name);
+                S88::contacts[coidx].set_link_railroad (v[0], v[1]);
+                contact_positions.push_back (v[2]);
+                break;
+            }
+
+            case FILEIO_SNAP_CONTACT_ACTION:
+            {
+                if (coidx != 0xFFFF)
+                {
+                    CONTACT_ACTION  ca;
+                    uint_fast8_t    caidx;
+
+                    ca.action       = v[1];
+                    ca.n_parameters = v[2];
+                    memcpy (ca.parameters, v + 3, ca.n_parameters * sizeof (uint16_t));
+
+                    caidx = S88::contacts[coidx].add_contact_action (v[0]);
+
+                    if (caidx == 0xFF)
+                    {
+                        Debug::printf (DEBUG_LEVEL_NONE, "%s: error: maximum number of contact actions reached.\n", FILEIO_SNAP_FILE);
+                        return;
+                    }
+
+                    S88::contacts[coidx].set_contact_action (v[0], caidx, &ca);
+                }
+                break;
+            }
+
+            case FILEIO_SNAP_RCLTRACK:
+            {
+                if ((trackidx = RCL::add ({})) == 0xFF)
+                {
+                    Debug::printf (DEBUG_LEVEL_NONE, "%s: error: maximum number of tracks reached.\n", FILEIO_SNAP_FILE);
+                    return;
+                }
+
+                RCL::tracks[trackidx].set_name (name);
+
+                if (v[0] & RCL_TRACK_FLAG_BLOCK_PROTECTION)
+                {
+                    RCL::tracks[trackidx].set_flags (RCL_TRACK_FLAG_BLOCK_PROTECTION);
+                }
+
+                track_positions.push_back (v[1]);
+                break;
+            }
+
+            case FILEIO_SNAP_RCLTRACK_ACTION:
+            {
+                if (trackidx != 0xFF)
+                {
+                    RCL_TRACK_ACTION    ta;
+                    uint_fast8_t        taidx;
+
+                    ta.condition                = v[1];
+                    ta.condition_destination    = v[2];
+                    ta.action                   = v[3];
+                    ta.n_parameters             = v[4];
+                    memcpy (ta.parameters, v + 5, ta.n_parameters * sizeof (uint16_t));
+
+                    taidx = RCL::tracks[trackidx].add_track_action (v[0]);
+
+                    if (taidx == 0xFF)
+                    {
+                        Debug::printf (DEBUG_LEVEL_NONE, "%s: error: maximum number of track actions reached.\n", FILEIO_SNAP_FILE);
+                        return;
+                    }
+
+                    RCL::tracks[trackidx].set_track_action (v[0], taidx, &ta);
+                }
+                break;
+            }
+        }
+    }
+
+    Locos::set_order (positions);
+    AddOns::set_order (addon_positions);
+    Switches::set_order (switch_positions);
+    RailroadGroups::set_order (railroad_group_positions);
+
+    for (rrgidx = 0; rrgidx < railroad_positions.size (); rrgidx++)
+    {
+        RailroadGroups::railroad_groups[rrgidx].set_order (railroad_positions[rrgidx]);
+    }
+
+    Signals::set_order (signal_positions);
+    Leds::set_order (led_positions);
+    S88::set_order (contact_positions);
+    RCL::set_order (track_positions);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * FileIO::read_snapshot () - map binary snapshot into memory and create all objects, false: snapshot missing or stale
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+FileIO::read_snapshot (void)
+{
+    const FILEIO_SNAP_HEADER *  hp;
+    const FILEIO_SNAP_RECORD *  records;
+    struct stat                 st;
+    char *                      buf;
+    int                         fd;
+    bool                        rtc = false;
+
+    fd = open (FILEIO_SNAP_FILE, O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    if (fstat (fd, &st) < 0 || st.st_size == 0)
+    {
+        close (fd);
+        return false;
+    }
+
+    buf = (char *) mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+
+    if (buf == MAP_FAILED)
+    {
+        perror (FILEIO_SNAP_FILE);
+        return false;
+    }
+
+    if (snap_check (buf, st.st_size))
+    {
+        hp      = (const FILEIO_SNAP_HEADER *) buf;
+        records = (const FILEIO_SNAP_RECORD *) (buf + sizeof (FILEIO_SNAP_HEADER));
+
+        snap_apply (records, hp->n_records, (const char *) (records + hp->n_records));
+
+        FM22::data_changed              = false;
+        Locos::data_changed             = false;
+        AddOns::data_changed            = false;
+        Switches::data_changed          = false;
+        RailroadGroups::data_changed    = false;
+        Signals::data_changed           = false;
+        Leds::data_changed              = false;
+        S88::data_changed               = false;
+        RCL::data_changed               = false;
+
+        Debug::printf (DEBUG_LEVEL_VERBOSE, "%s: %u records read\n", FILEIO_SNAP_FILE, hp->n_records);
+        rtc = true;
+    }
+
+    munmap (buf, st.st_size);
+    return rtc;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * reload of changed ini files:
+ *
+ * FileIO::schedule() checks size and modification time of the ini files every FILEIO_RELOAD_CHECK msec. If an ini file was
+ * changed by someone else (editor, scp, git) and is stable for one period, all ini files are read again without restart.
+ * Objects are identified by address or name, their runtime state (speed, functions, switch states, locations ...) is
+ * carried over to the new index, references to removed objects are dropped. Track power and the STM32 are not touched.
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * reload_changed () - check if ini files were changed by someone else, not while own files are pending or being written
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+reload_changed (const FILEIO_SNAP_STAMP * stamps)
+{
+    bool            rtc = true;
+    uint_fast8_t    idx;
+
+    pthread_mutex_lock (&fileio_mutex);
+
+    if (fileio_writing)
+    {
+        rtc = false;
+    }
+
+    for (idx = 0; rtc && idx < FILEIO_MAX_JOBS; idx++)
+    {
+        if (jobs[idx].buf)
+        {
+            rtc = false;
+        }
+    }
+
+    if (rtc && ! memcmp (stamps, ini_stamps, sizeof (ini_stamps)))
+    {
+        rtc = false;
+    }
+
+    pthread_mutex_unlock (&fileio_mutex);
+    return rtc;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * reload_check () - called by FileIO::schedule (), reload ini files if they were changed and are stable for one period.
+ * Not while own changes are pending, they will overwrite the ini files anyway.
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+reload_check (bool local_changes)
+{
+    static FILEIO_SNAP_STAMP    last_stamps[FILEIO_SNAP_N_FILES];
+    static unsigned long        next_millis;
+    FILEIO_SNAP_STAMP           stamps[FILEIO_SNAP_N_FILES];
+    unsigned long               now = Millis::elapsed ();
+
+    if (FILEIO_RELOAD_CHECK == 0 || (long) (now - next_millis) < 0)
+    {
+        return;
+    }
+
+    next_millis = now + FILEIO_RELOAD_CHECK;
+    snap_get_stamps (stamps);
+
+    if (! memcmp (stamps, last_stamps, sizeof (stamps)) && ! local_changes && reload_changed (stamps))
+    {
+        (void) FileIO::reload_ini_files ();
+    }
+
+    memcpy (last_stamps, stamps, sizeof (stamps));
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * reload_map () - map old to new indexes by key, 0xFFFF: object removed. Same position is checked first.
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+reload_map (std::vector<std::string>& old_keys, std::vector<std::string>& new_keys, std::vector<uint16_t>& map)
+{
+    std::vector<bool>   used (new_keys.size (), false);
+    uint_fast16_t       old_idx;
+    uint_fast16_t       new_idx;
+
+    map.assign (old_keys.size (), 0xFFFF);
+
+    for (old_idx = 0; old_idx < old_keys.size (); old_idx++)
+    {
+        if (old_idx < new_keys.size () && ! used[old_idx] && old_keys[old_idx] == new_keys[old_idx])
+        {
+            map[old_idx] = old_idx;
+            used[old_idx] = true;
+            continue;
+        }
+
+        for (new_idx = 0; new_idx < new_keys.size (); new_idx++)
+        {
+            if (! used[new_idx] && old_keys[old_idx] == new_keys[new_idx])
+            {
+                map[old_idx] = new_idx;
+                used[new_idx] = true;
+                break;
+            }
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * reload_addr_key () - key of object with address, locos and addons without address are identified by name
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static std::string
+reload_addr_key (uint_fast16_t addr, std::string name)
+{
+    if (addr == 0)
+    {
+        return "N" + name;
+    }
+
+    return "A" + std::to_string (addr);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * reload_map_rrgrr () - map railroad group index << 8 | railroad index, 0xFFFF: none or removed
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static uint_fast16_t
+reload_map_rrgrr (uint_fast16_t rrgrridx, std::vector<RailroadGroup>& old_rrgs, std::vector<uint16_t>& map_rrg)
+{
+    uint_fast16_t   rrgidx  = rrgrridx >> 8;
+    uint_fast16_t   rridx   = rrgrridx & 0xFF;
+    uint_fast16_t   new_rrgidx;
+    uint_fast8_t    new_rridx;
+    std::string     name;
+
+    if (rrgrridx == 0xFFFF || rrgidx >= old_rrgs.size () || rridx >= old_rrgs[rrgidx].railroads.size () || map_rrg[rrgidx] == 0xFFFF)
+    {
+        return 0xFFFF;
+    }
+
+    new_rrgidx  = map_rrg[rrgidx];
+    name        = old_rrgs[rrgidx].railroads[rridx].get_name ();
+
+    for (new_rridx = 0; new_rridx < RailroadGroups::railroad_groups[new_rrgidx].get_n_railroads (); new_rridx++)
+    {
+        if (RailroadGroups::railroad_groups[new_rrgidx].railroads[new_rridx].get_name () == name)
+        {
+            return (new_rrgidx << 8) | new_rridx;
+        }
+    }
+
+    return 0xFFFF;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * reload_map_loco () - map loco index, 0xFFFF: none or removed
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static uint_fast16_t
+reload_map_loco (uint_fast16_t loco_idx, std::vector<uint16_t>& map_loco)
+{
+    if (loco_idx < map_loco.size ())
+    {
+        return map_loco[loco_idx];
+    }
+
+    return 0xFFFF;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * FileIO::reload_ini_files () - read all ini files again, keep runtime state of objects which still exist
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+FileIO::reload_ini_files (void)
+{
+    std::vector<Loco>           old_locos;
+    std::vector<AddOn>          old_addons;
+    std::vector<Switch>         old_switches;
+    std::vector<Signal>         old_signals;
+    std::vector<LedGroup>       old_led_groups;
+    std::vector<RailroadGroup>  old_rrgs;
+    std::vector<RCL_Track>      old_tracks;
+    std::vector<std::string>    old_loco_keys;
+    std::vector<std::string>    old_keys;
+    std::vector<std::string>    new_keys;
+    std::vector<uint16_t>       map_loco;
+    std::vector<uint16_t>       map_addon;
+    std::vector<uint16_t>       map_switch;
+    std::vector<uint16_t>       map_signal;
+    std::vector<uint16_t>       map_led_group;
+    std::vector<uint16_t>       map_rrg;
+    std::vector<uint16_t>       map_track;
+    std::vector<uint8_t>        map_track8;
+    LOCO_RUNTIME *              old_runtime;
+    uint_fast16_t               old_shortcut_value = FM22::get_shortcut_value ();
+    unsigned long               start = Millis::elapsed ();
+    uint_fast16_t               idx;
+    uint_fast8_t                fidx;
+
+    for (fidx = 0; fidx < FILEIO_SNAP_N_FILES; fidx++)
+    {
+        if (access (snap_ini_files[fidx], R_OK) != 0)
+        {
+            Debug::printf (DEBUG_LEVEL_NONE, "FileIO: cannot reload ini files, %s is not readable\n", snap_ini_files[fidx]);
+            snap_get_stamps (ini_stamps);                               // don't try again until next change
+            return false;
+        }
+    }
+
+    old_runtime = (LOCO_RUNTIME *) malloc (sizeof (LOCO_RUNTIME));    // runtime state of locos is overwritten by Locos::add()
+
+    if (! old_runtime)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "FileIO: cannot reload ini files, out of memory\n");
+        return false;
+    }
+
+    memcpy (old_runtime, &Locos::runtime, sizeof (LOCO_RUNTIME));
+
+    for (idx = 0; idx < Locos::locos.size (); idx++)
+    {
+        old_loco_keys.push_back (reload_addr_key (Locos::locos[idx].get_addr (), Locos::locos[idx].get_name ()));
+    }
+
+    old_locos.swap (Locos::locos);
+    old_addons.swap (AddOns::addons);
+    old_switches.swap (Switches::switches);
+    old_signals.swap (Signals::signals);
+    old_led_groups.swap (Leds::led_groups);
+    old_rrgs.swap (RailroadGroups::railroad_groups);
+    old_tracks.swap (RCL::tracks);
+
+    Functions::clear ();
+    Locos::clear ();
+    AddOns::clear ();
+    Switches::clear ();
+    Signals::clear ();
+    Leds::clear ();
+    RailroadGroups::clear ();
+    S88::clear ();
+    RCL::clear ();
+
+    (void) FileIO::read_fm22_ini ();
+    (void) FileIO::read_func_ini ();
+    (void) FileIO::read_loco_ini ();
+    (void) FileIO::read_switch_ini ();
+    (void) FileIO::read_signal_ini ();
+    (void) FileIO::read_led_ini ();
+    (void) FileIO::read_s88_ini ();
+    (void) FileIO::read_rcl_ini ();
+
+    /*---------------------------------------------------------------------------------------------------------------------------------------
+     * map old to new indexes
+     *---------------------------------------------------------------------------------------------------------------------------------------
+     */
+    for (idx = 0; idx < Locos::locos.size (); idx++)
+    {
+        new_keys.push_back (reload_addr_key (Locos::locos[idx].get_addr (), Locos::locos[idx].get_name ()));
+    }
+
+    reload_map (old_loco_keys, new_keys, map_loco);
+
+    old_keys.clear ();
+    new_keys.clear ();
+
+    for (idx = 0; idx < old_addons.size (); idx++)
+    {
+        old_keys.push_back (reload_addr_key (old_addons[idx].get_addr (), old_addons[idx].get_name ()));
+    }
+
+    for (idx = 0; idx < AddOns::addons.size (); idx++)
+    {
+        new_keys.push_back (reload_addr_key (AddOns::addons[idx].get_addr (), AddOns::addons[idx].get_name ()));
+    }
+
+    reload_map (old_keys, new_keys, map_addon);
+
+    old_keys.clear ();
+    new_keys.clear ();
+
+    for (idx = 0; idx < old_switches.size (); idx++)
+    {
+        old_keys.push_back (std::to_string (old_switches[idx].get_addr ()));
+    }
+
+    for (idx = 0; idx < Switches::switches.size (); idx++)
+    {
+        new_keys.push_back (std::to_string (Switches::switches[idx].get_addr ()));
+    }
+
+    reload_map (old_keys, new_keys, map_switch);
+
+    old_keys.clear ();
+    new_keys.clear ();
+
+    for (idx = 0; idx < old_signals.size (); idx++)
+    {
+        old_keys.push_back (std::to_string (old_signals[idx].get_addr ()));
+    }
+
+    for (idx = 0; idx < Signals::signals.size (); idx++)
+    {
+        new_keys.push_back (std::to_string (Signals::signals[idx].get_addr ()));
+    }
+
+    reload_map (old_keys, new_keys, map_signal);
+
+    old_keys.clear ();
+    new_keys.clear ();
+
+    for (idx = 0; idx < old_led_groups.size (); idx++)
+    {
+        old_keys.push_back (std::to_string (old_led_groups[idx].get_addr ()));
+    }
+
+    for (idx = 0; idx < Leds::led_groups.size (); idx++)
+    {
+        new_keys.push_back (std::to_string (Leds::led_groups[idx].get_addr ()));
+    }
+
+    reload_map (old_keys, new_keys, map_led_group);
+
+    old_keys.clear ();
+    new_keys.clear ();
+
+    for (idx = 0; idx < old_rrgs.size (); idx++)
+    {
+        old_keys.push_back (old_rrgs[idx].get_name ());
+    }
+
+    for (idx = 0; idx < RailroadGroups::railroad_groups.size (); idx++)
+    {
+        new_keys.push_back (RailroadGroups::railroad_groups[idx].get_name ());
+    }
+
+    reload_map (old_keys, new_keys, map_rrg);
+
+    old_keys.clear ();
+    new_keys.clear ();
+
+    for (idx = 0; idx < old_tracks.size (); idx++)
+    {
+        old_keys.push_back (old_tracks[idx].get_name ());
+    }
+
+    for (idx = 0; idx < RCL::tracks.size (); idx++)
+    {
+        new_keys.push_back (RCL::tracks[idx].get_name ());
+    }
+
+    reload_map (old_keys, new_keys, map_track);
+
+    for (idx = 0; idx < map_track.size (); idx++)
+    {
+        map_track8.push_back (map_track[idx] == 0xFFFF ? 0xFF : map_track[idx]);
+    }
+
+    /*---------------------------------------------------------------------------------------------------------------------------------------
+     * carry over runtime state
+     *---------------------------------------------------------------------------------------------------------------------------------------
+     */
+    for (idx = 0; idx < old_locos.size (); idx++)
+    {
+        if (map_loco[idx] != 0xFFFF)
+        {
+            Loco *          op      = &old_locos[idx];
+            Loco *          np      = &Locos::locos[map_loco[idx]];
+            uint_fast8_t    rcl_location = op->get_rcllocation ();
+            uint_fast8_t    destination = op->get_destination ();
+
+            np->restore_state (old_runtime->speed[idx], old_runtime->fwd[idx], old_runtime->functions[idx]);
+            np->set_online (old_runtime->flags[idx] & LOCO_FLAG_ONLINE);
+            np->set_rc2_rate (old_runtime->rc2_rate[idx]);
+
+            if (old_runtime->flags[idx] & LOCO_FLAG_HALT)
+            {
+                np->set_flag_halt ();
+            }
+
+            if (rcl_location < map_track8.size () && map_track8[rcl_location] != 0xFF)
+            {
+                np->set_rcllocation (map_track8[rcl_location]);
+            }
+
+            if (op->get_rrlocation () != 0xFFFF)
+            {
+                np->set_rrlocation (reload_map_rrgrr (op->get_rrlocation (), old_rrgs, map_rrg));
+            }
+
+            if (destination < map_rrg.size () && map_rrg[destination] != 0xFFFF)
+            {
+                np->set_destination (map_rrg[destination]);
+            }
+        }
+    }
+
+    for (idx = 0; idx < old_addons.size (); idx++)
+    {
+        if (map_addon[idx] != 0xFFFF)
+        {
+            AddOns::addons[map_addon[idx]].restore_state (old_addons[idx].get_functions ());
+        }
+    }
+
+    for (idx = 0; idx < old_switches.size (); idx++)
+    {
+        if (map_switch[idx] != 0xFFFF)
+        {
+            Switches::switches[map_switch[idx]].restore_state (old_switches[idx].get_state ());
+        }
+    }
+
+    for (idx = 0; idx < old_signals.size (); idx++)
+    {
+        if (map_signal[idx] != 0xFFFF)
+        {
+            Signals::signals[map_signal[idx]].restore_state (old_signals[idx].get_state ());
+        }
+    }
+
+    for (idx = 0; idx < old_led_groups.size (); idx++)
+    {
+        if (map_led_group[idx] != 0xFFFF)
+        {
+            Leds::led_groups[map_led_group[idx]].restore_state (old_led_groups[idx].get_state ());
+        }
+    }
+
+    for (idx = 0; idx < old_rrgs.size (); idx++)
+    {
+        uint_fast8_t    rridx = old_rrgs[idx].get_active_railroad ();
+
+        if (map_rrg[idx] != 0xFFFF && rridx != 0xFF)
+        {
+            uint_fast16_t   rrgrridx = reload_map_rrgrr ((idx << 8) | rridx, old_rrgs, map_rrg);
+
+            if (rrgrridx != 0xFFFF)
+            {
+                Railroad *  rrp = &old_rrgs[idx].railroads[rridx];
+
+                RailroadGroups::railroad_groups[map_rrg[idx]].restore_active_railroad (rrgrridx & 0xFF,
+                                                                                       reload_map_loco (rrp->get_active_loco (), map_loco),
+                                                                                       reload_map_loco (rrp->get_located_loco (), map_loco));
+            }
+        }
+    }
+
+    for (idx = 0; idx < old_tracks.size (); idx++)
+    {
+        if (map_track[idx] != 0xFFFF)
+        {
+            RCL::tracks[map_track[idx]].loco_idx        = reload_map_loco (old_tracks[idx].loco_idx, map_loco);
+            RCL::tracks[map_track[idx]].last_loco_idx   = reload_map_loco (old_tracks[idx].last_loco_idx, map_loco);
+        }
+    }
+
+    RCL::set_new_locations (map_loco.data (), old_locos.size (), map_track8.data (), map_track8.size ());
+    MSG::rc2_resync ();
+    Event::set_new_loco_ids (map_loco.data (), old_locos.size ());
+    Event::set_new_addon_ids (map_addon.data (), old_addons.size ());
+    Event::set_new_switch_ids (map_switch.data (), old_switches.size ());
+    Event::set_new_signal_ids (map_signal.data (), old_signals.size ());
+    Event::set_new_led_group_ids (map_led_group.data (), old_led_groups.size ());
+    Switches::set_new_event_ids (map_switch.data (), old_switches.size ());
+    Signals::set_new_event_ids (map_signal.data (), old_signals.size ());
+    UDP::set_new_loco_ids (map_loco.data (), old_locos.size ());
+    free (old_runtime);
+
+    FM22::data_changed = false;                                         // read_fm22_ini () uses FM22::set_shortcut_value ()
+
+    if (FM22::get_shortcut_value () != old_shortcut_value)
+    {
+        DCC::set_shortcut_value (FM22::get_shortcut_value ());
+    }
+
+    (void) FileIO::write_snapshot ();
+    FM22::state_changed ();                                             // names and numbers of objects may have changed
+
+    Debug::printf (DEBUG_LEVEL_NONE, "FileIO: ini files reloaded: %u locos, %u addons, %u switches, %u signals, %u led groups, %u railroad groups, %u rcl tracks, %lu msec\n",
+                   Locos::get_n_locos (), AddOns::get_n_addons (), Switches::get_n_switches (), Signals::get_n_signals (), Leds::get_n_led_groups (),
+                   RailroadGroups::get_n_railroad_groups (), RCL::get_n_tracks (), Millis::elapsed () - start);
+    return true;
+}
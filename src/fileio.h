@@ -20,12 +20,108 @@
 #ifndef FILEIO_H
 #define FILEIO_H
 
+#include <stdint.h>
+#include <stddef.h>
+
+#define FILEIO_AUTOSAVE_DELAY       2000                                // save changed ini files 2 sec after first change, 0: off
+#define FILEIO_N_BACKUPS            3                                   // backups per file: xxx.bak, xxx.bak.1, xxx.bak.2
+#define FILEIO_RETRY_DELAY          5                                   // retry failed write after 5 sec
+#define FILEIO_RELOAD_CHECK         1000                                // check ini files for external changes every sec, 0: off
+#define FILEIO_MAX_JOBS             9                                   // max. number of ini files + snapshot
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * binary snapshot of all ini files, see FileIO::read_snapshot(). Host byte order, it is only a cache of the ini files.
+ *
+ *   header (FILEIO_SNAP_HEADER)
+ *   n_records records (FILEIO_SNAP_RECORD), same order as sections and lines of the ini files
+ *   string table, NUL terminated strings, FILEIO_SNAP_RECORD.name is an offset into it
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#define FILEIO_SNAP_FILE            "fm22.snap"
+#define FILEIO_SNAP_MAGIC           "FM22SNAP"
+#define FILEIO_SNAP_VERSION         5                                   // increment if layout of records changes
+#define FILEIO_SNAP_MAX_VALUES      14
+#define FILEIO_SNAP_NO_NAME         0xFFFFFFFF
+#define FILEIO_SNAP_N_FILES         8                                   // number of ini files
+
+#define FILEIO_SNAP_FM22            1                                   // values: shortcut, compression
+#define FILEIO_SNAP_FUNCTION        2                                   // name
+#define FILEIO_SNAP_LOCO            3                                   // name, values: active, addr, steps, position
+#define FILEIO_SNAP_LOCO_FUNCTION   4                                   // values: fidx, function_name_idx, pulse, sound
+#define FILEIO_SNAP_LOCO_MACRO      5                                   // values: midx, action, n_parameters, parameters
+#define FILEIO_SNAP_ADDON           6                                   // name, values: active, addr, position
+#define FILEIO_SNAP_ADDON_FUNCTION  7                                   // values: fidx, function_name_idx, pulse, sound
+#define FILEIO_SNAP_ADDON_LOCO      8                                   // values: loco_idx
+#define FILEIO_SNAP_ADDON_COUPLE    9                                   // values: loco_idx, lfidx, afidx
+#define FILEIO_SNAP_SWITCH          10                                  // name, values: addr, flags, pulse, position
+#define FILEIO_SNAP_RAILROAD_GROUP  11                                  // name, values: position
+#define FILEIO_SNAP_RAILROAD        12                                  // name, values: loco_idx, position
+#define FILEIO_SNAP_RAILROAD_SWITCH 13                                  // values: swidx, state
+#define FILEIO_SNAP_SIGNAL          14                                  // name, values: addr, position
+#define FILEIO_SNAP_LED             15                                  // name, values: addr, position
+#define FILEIO_SNAP_CONTACT         16                                  // name, values: rrgidx, rridx, position
+#define FILEIO_SNAP_CONTACT_ACTION  17                                  // values: in, action, n_parameters, parameters
+#define FILEIO_SNAP_RCLTRACK        18                                  // name, values: flags, position
+#define FILEIO_SNAP_RCLTRACK_ACTION 19                                  // values: in, condition, condition_destination, action, n_parameters, parameters
+
+typedef struct
+{
+    int64_t         size;                                               // -1: file doesn't exist
+    int64_t         mtime_sec;
+    int64_t         mtime_nsec;
+} FILEIO_SNAP_STAMP;
+
+typedef struct
+{
+    char            magic[8];
+    uint32_t        version;
+    uint32_t        crc;                                                // CRC32 of records and string table
+    uint32_t        n_records;
+    uint32_t        strings_size;
+    FILEIO_SNAP_STAMP   stamps[FILEIO_SNAP_N_FILES];                    // ini files when snapshot was written
+} FILEIO_SNAP_HEADER;
+
+typedef struct
+{
+    uint8_t         type;                                               // FILEIO_SNAP_xxx
+    uint8_t         n_values;
+    uint16_t        reserved;
+    uint32_t        name;                                               // offset in string table or FILEIO_SNAP_NO_NAME
+    uint16_t        values[FILEIO_SNAP_MAX_VALUES];
+} FILEIO_SNAP_RECORD;
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * statistics of background writer, durations in usec
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+    uint32_t        n_queued;                                           // number of queued snapshots
+    uint32_t        n_coalesced;                                        // number of snapshots replaced by newer ones before writing
+    uint32_t        n_written;                                          // number of written files
+    uint32_t        n_failed;                                           // number of failed writes
+    uint32_t        n_pending;                                          // number of files waiting to be written
+    uint64_t        bytes_written;
+    uint32_t        last_duration;
+    uint32_t        max_duration;
+    uint64_t        total_duration;
+} FILEIO_STATS;
+
 class FileIO
 {
     public:
+        static void     init (void);
+        static void     deinit (void);
+        static void     schedule (void);
+        static void     get_stats (FILEIO_STATS * statsp);
         static void     read_all_ini_files (void);
         static bool     write_all_ini_files (void);
+        static bool     reload_ini_files (void);
     private:
+        static bool     data_changed (void);
+        static bool     queue_write (const char * fname, const char * fname_bak, char * buf, size_t len);
+        static bool     read_snapshot (void);
+        static bool     write_snapshot (void);
         static bool     read_fm22_ini (void);
         static bool     read_func_ini (void);
         static bool     read_loco_ini (void);
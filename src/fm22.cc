@@ -29,7 +29,10 @@
 #include "fm22.h"
 
 uint_fast16_t                   FM22::shortcut_value = FM22_SHORTCUT_DEFAULT;               // shortcut value, public
+uint_fast8_t                    FM22::compression_level = FM22_COMPRESSION_DEFAULT;         // compression level of http responses, public
+uint_fast8_t                    FM22::switch_power = FM22_SWITCH_POWER_DEFAULT;             // power budget for switch machines, public
 bool                            FM22::data_changed = false;                                 // flag: data changed, public
+uint32_t                        FM22::state_version = 0;                                    // version of runtime state, public
 
 /*------------------------------------------------------------------------------------------------------------------------
  * set_shortcut_value() - set shortcut value
@@ -51,3 +54,71 @@ FM22::get_shortcut_value (void)
 {
     return FM22::shortcut_value;
 }
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * set_compression_level() - set compression level of http responses: 0 = off, 1 = fastest ... 9 = best
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+FM22::set_compression_level (uint_fast8_t level)
+{
+    if (level > 9)
+    {
+        level = 9;
+    }
+
+    FM22::compression_level = level;
+    FM22::data_changed      = true;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_compression_level() - get compression level of http responses
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+FM22::get_compression_level (void)
+{
+    return FM22::compression_level;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * set_switch_power() - set number of switch machines which may be powered at the same time, a 3-way switch counts 2
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+FM22::set_switch_power (uint_fast8_t power)
+{
+    if (power < 1)
+    {
+        power = 1;
+    }
+    else if (power > FM22_SWITCH_POWER_MAX)
+    {
+        power = FM22_SWITCH_POWER_MAX;
+    }
+
+    FM22::switch_power      = power;
+    FM22::data_changed      = true;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_switch_power() - get number of switch machines which may be powered at the same time
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+FM22::get_switch_power (void)
+{
+    return FM22::switch_power;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * state_changed() - runtime state (speed, functions, s88, rcl, switches, ...) has changed
+ *
+ * Every change increments the state version, so the http server knows that cached action responses are outdated.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+FM22::state_changed (void)
+{
+    FM22::state_version++;
+}
@@ -24,14 +24,25 @@
 #include <string>
 
 #define FM22_SHORTCUT_DEFAULT           1000
+#define FM22_COMPRESSION_DEFAULT        1                                   // deflate level of http responses, 0 = off, 1 - 9
+#define FM22_SWITCH_POWER_DEFAULT       1                                   // number of switch machines powered at the same time
+#define FM22_SWITCH_POWER_MAX           16
 
 class FM22
 {
     public:
         static uint_fast16_t            shortcut_value;
+        static uint_fast8_t             compression_level;
+        static uint_fast8_t             switch_power;
         static bool                     data_changed;
+        static uint32_t                 state_version;
         static void                     set_shortcut_value (uint_fast16_t value);
         static uint_fast16_t            get_shortcut_value ();
+        static void                     set_compression_level (uint_fast8_t level);
+        static uint_fast8_t             get_compression_level ();
+        static void                     set_switch_power (uint_fast8_t power);
+        static uint_fast8_t             get_switch_power ();
+        static void                     state_changed ();
 
     private:
 };
@@ -93,6 +93,23 @@ Functions::get_n_entries (void)
     return entries;
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ *  clear () - remove all function names, see FileIO::reload_ini_files ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Functions::clear (void)
+{
+    uint_fast16_t   fidx;
+
+    for (fidx = 0; fidx < entries; fidx++)
+    {
+        names[fidx] = "";
+    }
+
+    entries = 0;
+}
+
 /*------------------------------------------------------------------------------------------------------------------------
  *  search () - search function name
  *------------------------------------------------------------------------------------------------------------------------
@@ -32,6 +32,7 @@ class Functions
         static void             set (uint_fast16_t fidx, std::string& name);
         static std::string&     get (uint_fast16_t fidx);
         static uint_fast16_t    get_n_entries (void);
+        static void             clear (void);
         static uint_fast16_t    search (const char * name);
         static uint_fast16_t    search (std::string& name);
     private:
@@ -136,14 +136,12 @@ HTTP_AddOn::handle_addon (void)
     {
         const char *    sname   = HTTP::parameter ("name");
         uint_fast16_t   aidx    = HTTP::parameter_number ("aidx");
-        uint_fast16_t   naidx   = HTTP::parameter_number ("naidx");
+        uint_fast16_t   npos    = HTTP::parameter_number ("npos");
         uint_fast16_t   addr    = HTTP::parameter_number ("addr");
         uint_fast16_t   lidx    = HTTP::parameter_number ("lidx");
+        uint_fast16_t   naidx;
 
-        if (aidx != naidx)
-        {
-            naidx = AddOns::set_new_id (aidx, naidx);
-        }
+        naidx = AddOns::set_position (aidx, npos);                      // addon keeps its index, only display order changes
 
         if (naidx != 0xFFFF)
         {
@@ -170,9 +168,9 @@ HTTP_AddOn::handle_addon (void)
     String          scolor_name;
     String          scolor_addr;
 
-    for (addon_idx = 0; addon_idx < n_addons; addon_idx++)
+    for (map_idx = 0; map_idx < n_addons; map_idx++)
     {
-        addon_map[addon_idx] = addon_idx;
+        addon_map[map_idx] = AddOns::get_addon_idx (map_idx);
     }
 
     if (nsort == ADDON_SORT_NAME)
@@ -234,7 +232,7 @@ HTTP_AddOn::handle_addon (void)
         if (HTTP_Common::edit_mode)
         {
             HTTP::response += (String) "<td><button onclick=\""
-                  + "changeaddon(" + std::to_string(addon_idx) + ",'"
+                  + "changeaddon(" + std::to_string(addon_idx) + "," + std::to_string(AddOns::get_position (addon_idx)) + ",'"
                   + AddOns::addons[addon_idx].get_name() + "',"
                   + std::to_string(AddOns::addons[addon_idx].get_addr()) + ","
                   + std::to_string(loco_idx) + ")\""
@@ -248,11 +246,11 @@ HTTP_AddOn::handle_addon (void)
     HTTP::response += (String)
         "</table>\r\n"
         "<script>\r\n"
-        "function changeaddon(aidx, name, addr, lidx)\r\n"
+        "function changeaddon(aidx, pos, name, addr, lidx)\r\n"
         "{\r\n"
         "  document.getElementById('action').value = 'changeaddon';\r\n"
         "  document.getElementById('aidx').value = aidx;\r\n"
-        "  document.getElementById('naidx').value = aidx;\r\n"
+        "  document.getElementById('npos').value = pos;\r\n"
         "  document.getElementById('name').value = name;\r\n"
         "  document.getElementById('addr').value = addr;\r\n"
         "  document.getElementById('lidx').value = lidx;\r\n"
@@ -289,7 +287,7 @@ HTTP_AddOn::handle_addon (void)
             "<table>\r\n"
             "<tr id='newid'>\r\n";
 
-        HTTP_Common::print_id_select_list ("naidx", n_addons);
+        HTTP_Common::print_position_select_list ("npos", n_addons);
 
         HTTP::response += (String)
             "</tr>\r\n"
@@ -345,3 +343,15 @@ HTTP_AddOn::action_getfa (void)
 
     HTTP::response = std::to_string(fn) + "\t" + std::to_string(pulse) + "\t" + std::to_string(sound);
 }
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_AddOn::init (void)
+{
+    HTTP::add_page   ("/addon",               HTTP_AddOn::handle_addon);
+    HTTP::add_action ("togglefunctionaddon",  HTTP_AddOn::action_togglefunctionaddon, 0);
+    HTTP::add_action ("getfa",                HTTP_AddOn::action_getfa,               HTTP_ACTION_FLAG_CACHEABLE);
+}
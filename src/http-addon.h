@@ -25,6 +25,7 @@
 class HTTP_AddOn
 {
     public:
+        static void     init (void);
         static void     handle_addon (void);
         static void     action_togglefunctionaddon (void);
         static void     action_getfa (void);
@@ -0,0 +1,721 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * http-api.cc - HTTP machine-readable state API
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ *
+ * URLs:
+ *
+ *   /api/v1                    JSON: API version, state version, collections with number of items and field names
+ *   /api/v1/state              JSON: items of collections
+ *   /api/v1/state.bin          same as /api/v1/state in compact binary encoding
+ *
+ * The field "path" of a loco lists the railroads (rrgidx << 8 | rridx) of the cheapest path from its railroad location
+ * to its destination, comma separated, see Topology::get_path(). It is empty if there is no path.
+ *
+ * The collection "loco_stats" contains the track refresh intervals and the RailCom quality of each loco in msec and
+ * percent, see locostats.h.
+ *
+ * Parameters of /api/v1/state and /api/v1/state.bin, all optional:
+ *
+ *   collections=locos,s88      comma separated list of collections, default: all
+ *   fields=name,speed          comma separated list of fields, default: all. The field "id" is always sent.
+ *   offset=100                 index of first item of each collection, default: 0
+ *   limit=50                   max. number of items of each collection, default: all
+ *
+ * JSON:
+ *
+ *   {"version":1,"state_version":4711,"locos":{"total":50,"offset":0,"items":[{"id":0,"name":"BR 218",...},...]},...}
+ *
+ * Binary, all numbers in network byte order:
+ *
+ *   version(1) state_version(4) n_collections(1)
+ *   per collection:
+ *     name_len(1) name total(2) offset(2) n_items(2) n_fields(1)
+ *     per field: name_len(1) name type(1), see HTTP_API_TYPE_xxx
+ *     per item: id(2), per field: value
+ *
+ * Values of 0xFF or 0xFFFF mean "none" as in the ini files. Names are stored in ISO-8859-1: JSON strings are converted
+ * to UTF-8, binary strings are sent unchanged.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <string>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "debug.h"
+#include "loco.h"
+#include "addon.h"
+#include "switch.h"
+#include "sig.h"
+#include "led.h"
+#include "railroad.h"
+#include "interlock.h"
+#include "topology.h"
+#include "locostats.h"
+#include "s88.h"
+#include "rcl.h"
+#include "fm22.h"
+#include "http.h"
+#include "http-api.h"
+
+#define HTTP_API_MAX_PATH_LEN       32                              // max. railroads of field "path", fits into 255 bytes
+
+typedef struct
+{
+    const char *        name;
+    uint_fast8_t        type;                                       // HTTP_API_TYPE_xxx
+    uint32_t            (* get_number) (uint_fast16_t idx);
+    std::string         (* get_string) (uint_fast16_t idx);
+} API_FIELD;
+
+typedef struct
+{
+    const char *        name;
+    uint_fast16_t       (* get_n_items) (void);
+    const API_FIELD *   fields;
+    uint_fast8_t        n_fields;
+} API_COLLECTION;
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * field getters
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static std::string      loco_name (uint_fast16_t idx)               { return Locos::locos[idx].get_name (); }
+static uint32_t         loco_addr (uint_fast16_t idx)               { return Locos::locos[idx].get_addr (); }
+static uint32_t         loco_speed_steps (uint_fast16_t idx)        { return Locos::locos[idx].get_speed_steps (); }
+static uint32_t         loco_speed (uint_fast16_t idx)              { return Locos::locos[idx].get_speed (); }
+static uint32_t         loco_fwd (uint_fast16_t idx)                { return Locos::locos[idx].get_fwd (); }
+static uint32_t         loco_functions (uint_fast16_t idx)          { return Locos::locos[idx].get_functions (); }
+static uint32_t         loco_online (uint_fast16_t idx)             { return Locos::locos[idx].is_online (); }
+static uint32_t         loco_flags (uint_fast16_t idx)              { return Locos::locos[idx].get_flags (); }
+static uint32_t         loco_addon (uint_fast16_t idx)              { return Locos::locos[idx].get_addon (); }
+static uint32_t         loco_destination (uint_fast16_t idx)        { return Locos::locos[idx].get_destination (); }
+static uint32_t         loco_rcl_location (uint_fast16_t idx)       { return Locos::locos[idx].get_rcllocation (); }
+static uint32_t         loco_rr_location (uint_fast16_t idx)        { return Locos::locos[idx].get_rrlocation (); }
+
+static uint32_t
+loco_distance (uint_fast16_t idx)
+{
+    uint_fast16_t   rrgrridx = Locos::locos[idx].get_rrlocation ();
+
+    if (rrgrridx == 0xFFFF)
+    {
+        return TOPOLOGY_UNREACHABLE;
+    }
+
+    return Topology::get_distance (rrgrridx >> 8, rrgrridx & 0xFF, Locos::locos[idx].get_destination ());
+}
+
+static std::string
+loco_path (uint_fast16_t idx)
+{
+    uint_fast16_t   rrgrridx = Locos::locos[idx].get_rrlocation ();
+    uint16_t        path[HTTP_API_MAX_PATH_LEN];
+    uint_fast16_t   len;
+    uint_fast16_t   pidx;
+    std::string     s;
+
+    if (rrgrridx == 0xFFFF)
+    {
+        return s;
+    }
+
+    len = Topology::get_path (rrgrridx >> 8, rrgrridx & 0xFF, Locos::locos[idx].get_destination (), path, HTTP_API_MAX_PATH_LEN);
+
+    for (pidx = 0; pidx < len; pidx++)
+    {
+        if (pidx > 0)
+        {
+            s += ",";
+        }
+
+        s += std::to_string (path[pidx]);
+    }
+
+    return s;
+}
+
+static uint32_t
+refresh_value (uint_fast16_t idx, uint_fast8_t group, uint_fast8_t value)   // value: 0 packets, 1 p50, 2 p99, 3 worst gap
+{
+    LOCOSTATS_REFRESH   refresh;
+
+    LocoStats::get_refresh (idx, group, &refresh);
+
+    switch (value)
+    {
+        case 0:     return refresh.n_packets;
+        case 1:     return refresh.p50;
+        case 2:     return refresh.p99;
+        default:    return refresh.worst_gap;
+    }
+}
+
+static uint32_t
+functions_worst (uint_fast16_t idx)
+{
+    uint32_t        worst = LOCOSTATS_NONE;
+    uint_fast8_t    group;
+
+    for (group = LOCOSTATS_GROUP_F05_F08; group < LOCOSTATS_GROUPS; group++)
+    {
+        uint32_t    gap = refresh_value (idx, group, 3);
+
+        if (gap != LOCOSTATS_NONE && (worst == LOCOSTATS_NONE || worst < gap))
+        {
+            worst = gap;
+        }
+    }
+
+    return worst;
+}
+
+static uint32_t         stats_speed_packets (uint_fast16_t idx)     { return refresh_value (idx, LOCOSTATS_GROUP_SPEED, 0); }
+static uint32_t         stats_speed_p50 (uint_fast16_t idx)         { return refresh_value (idx, LOCOSTATS_GROUP_SPEED, 1); }
+static uint32_t         stats_speed_p99 (uint_fast16_t idx)         { return refresh_value (idx, LOCOSTATS_GROUP_SPEED, 2); }
+static uint32_t         stats_speed_worst (uint_fast16_t idx)       { return refresh_value (idx, LOCOSTATS_GROUP_SPEED, 3); }
+static uint32_t         stats_f0_p50 (uint_fast16_t idx)            { return refresh_value (idx, LOCOSTATS_GROUP_F00_F04, 1); }
+static uint32_t         stats_f0_p99 (uint_fast16_t idx)            { return refresh_value (idx, LOCOSTATS_GROUP_F00_F04, 2); }
+static uint32_t         stats_f0_worst (uint_fast16_t idx)          { return refresh_value (idx, LOCOSTATS_GROUP_F00_F04, 3); }
+static uint32_t         stats_functions_worst (uint_fast16_t idx)   { return functions_worst (idx); }
+static uint32_t         stats_rc2_rate (uint_fast16_t idx)          { return LocoStats::get_stats (idx)->rc2_rate; }
+static uint32_t         stats_rc2_rate_min (uint_fast16_t idx)      { return LocoStats::get_stats (idx)->rc2_rate_min; }
+static uint32_t         stats_rc2_latency (uint_fast16_t idx)       { return LocoStats::get_stats (idx)->rc2_latency; }
+static uint32_t         stats_rc2_latency_max (uint_fast16_t idx)   { return LocoStats::get_stats (idx)->rc2_latency_max; }
+static uint32_t         stats_track_gap (uint_fast16_t idx)         { return LocoStats::get_stats (idx)->track_gap; }
+static uint32_t         stats_track_gap_max (uint_fast16_t idx)     { return LocoStats::get_stats (idx)->track_gap_max; }
+
+static std::string      addon_name (uint_fast16_t idx)              { return AddOns::addons[idx].get_name (); }
+static uint32_t         addon_addr (uint_fast16_t idx)              { return AddOns::addons[idx].get_addr (); }
+static uint32_t         addon_loco (uint_fast16_t idx)              { return AddOns::addons[idx].get_loco (); }
+static uint32_t         addon_functions (uint_fast16_t idx)         { return AddOns::addons[idx].get_functions (); }
+
+static std::string      switch_name (uint_fast16_t idx)             { return Switches::switches[idx].get_name (); }
+static uint32_t         switch_addr (uint_fast16_t idx)             { return Switches::switches[idx].get_addr (); }
+static uint32_t         switch_state (uint_fast16_t idx)            { return Switches::switches[idx].get_state (); }
+static uint32_t         switch_flags (uint_fast16_t idx)            { return Switches::switches[idx].get_flags (); }
+static uint32_t         switch_busy (uint_fast16_t idx)             { return Switches::is_busy (idx); }
+
+static std::string      signal_name (uint_fast16_t idx)             { return Signals::signals[idx].get_name (); }
+static uint32_t         signal_addr (uint_fast16_t idx)             { return Signals::signals[idx].get_addr (); }
+static uint32_t         signal_state (uint_fast16_t idx)            { return Signals::signals[idx].get_state (); }
+
+static std::string      led_name (uint_fast16_t idx)                { return Leds::led_groups[idx].get_name (); }
+static uint32_t         led_addr (uint_fast16_t idx)                { return Leds::led_groups[idx].get_addr (); }
+static uint32_t         led_state (uint_fast16_t idx)               { return Leds::led_groups[idx].get_state (); }
+
+static std::string      rrg_name (uint_fast16_t idx)                { return RailroadGroups::railroad_groups[idx].get_name (); }
+static uint32_t         rrg_n_railroads (uint_fast16_t idx)         { return RailroadGroups::railroad_groups[idx].get_n_railroads (); }
+static uint32_t         rrg_active_railroad (uint_fast16_t idx)     { return RailroadGroups::railroad_groups[idx].get_active_railroad (); }
+static uint32_t         rrg_switching (uint_fast16_t idx)           { return RailroadGroups::railroad_groups[idx].is_switching (); }
+static uint32_t         rrg_locked (uint_fast16_t idx)              { return Interlocking::is_locked (idx, RailroadGroups::railroad_groups[idx].get_active_railroad ()); }
+
+static std::string      s88_name (uint_fast16_t idx)                { return S88::contacts[idx].get_name (); }
+static uint32_t         s88_state (uint_fast16_t idx)               { return S88::get_state_bit (idx); }
+static uint32_t         s88_rrg (uint_fast16_t idx)                 { return S88::contacts[idx].rrgidx; }
+static uint32_t         s88_rr (uint_fast16_t idx)                  { return S88::contacts[idx].rridx; }
+
+static std::string      rcl_name (uint_fast16_t idx)                { return RCL::tracks[idx].get_name (); }
+static uint32_t         rcl_loco (uint_fast16_t idx)                { return RCL::tracks[idx].loco_idx; }
+static uint32_t         rcl_last_loco (uint_fast16_t idx)           { return RCL::tracks[idx].last_loco_idx; }
+static uint32_t         rcl_flags (uint_fast16_t idx)               { return RCL::tracks[idx].get_flags (); }
+
+static uint_fast16_t    n_railroad_groups (void)                    { return RailroadGroups::get_n_railroad_groups (); }
+static uint_fast16_t    n_rcl_tracks (void)                         { return RCL::get_n_tracks (); }
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * collections and their fields
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#define N_FIELDS(f)     (sizeof (f) / sizeof (API_FIELD))
+
+static const API_FIELD loco_fields[] =
+{
+    { "name",           HTTP_API_TYPE_STRING,   NULL,                   loco_name   },
+    { "addr",           HTTP_API_TYPE_NUMBER,   loco_addr,              NULL        },
+    { "speed_steps",    HTTP_API_TYPE_NUMBER,   loco_speed_steps,       NULL        },
+    { "speed",          HTTP_API_TYPE_NUMBER,   loco_speed,             NULL        },
+    { "fwd",            HTTP_API_TYPE_NUMBER,   loco_fwd,               NULL        },
+    { "functions",      HTTP_API_TYPE_NUMBER,   loco_functions,         NULL        },
+    { "online",         HTTP_API_TYPE_NUMBER,   loco_online,            NULL        },
+    { "flags",          HTTP_API_TYPE_NUMBER,   loco_flags,             NULL        },
+    { "addon",          HTTP_API_TYPE_NUMBER,   loco_addon,             NULL        },
+    { "destination",    HTTP_API_TYPE_NUMBER,   loco_destination,       NULL        },
+    { "rcl_location",   HTTP_API_TYPE_NUMBER,   loco_rcl_location,      NULL        },
+    { "rr_location",    HTTP_API_TYPE_NUMBER,   loco_rr_location,       NULL        },
+    { "distance",       HTTP_API_TYPE_NUMBER,   loco_distance,          NULL        },
+    { "path",           HTTP_API_TYPE_STRING,   NULL,                   loco_path   },
+};
+
+static const API_FIELD loco_stats_fields[] =
+{
+    { "name",           HTTP_API_TYPE_STRING,   NULL,                   loco_name   },
+    { "speed_packets",  HTTP_API_TYPE_NUMBER,   stats_speed_packets,    NULL        },
+    { "speed_p50",      HTTP_API_TYPE_NUMBER,   stats_speed_p50,        NULL        },
+    { "speed_p99",      HTTP_API_TYPE_NUMBER,   stats_speed_p99,        NULL        },
+    { "speed_worst",    HTTP_API_TYPE_NUMBER,   stats_speed_worst,      NULL        },
+    { "f0_p50",         HTTP_API_TYPE_NUMBER,   stats_f0_p50,           NULL        },
+    { "f0_p99",         HTTP_API_TYPE_NUMBER,   stats_f0_p99,           NULL        },
+    { "f0_worst",       HTTP_API_TYPE_NUMBER,   stats_f0_worst,         NULL        },
+    { "functions_worst",HTTP_API_TYPE_NUMBER,   stats_functions_worst,  NULL        },
+    { "rc2_rate",       HTTP_API_TYPE_NUMBER,   stats_rc2_rate,         NULL        },
+    { "rc2_rate_min",   HTTP_API_TYPE_NUMBER,   stats_rc2_rate_min,     NULL        },
+    { "rc2_latency",    HTTP_API_TYPE_NUMBER,   stats_rc2_latency,      NULL        },
+    { "rc2_latency_max",HTTP_API_TYPE_NUMBER,   stats_rc2_latency_max,  NULL        },
+    { "track_gap",      HTTP_API_TYPE_NUMBER,   stats_track_gap,        NULL        },
+    { "track_gap_max",  HTTP_API_TYPE_NUMBER,   stats_track_gap_max,    NULL        },
+};
+
+static const API_FIELD addon_fields[] =
+{
+    { "name",           HTTP_API_TYPE_STRING,   NULL,                   addon_name  },
+    { "addr",           HTTP_API_TYPE_NUMBER,   addon_addr,             NULL        },
+    { "loco",           HTTP_API_TYPE_NUMBER,   addon_loco,             NULL        },
+    { "functions",      HTTP_API_TYPE_NUMBER,   addon_functions,        NULL        },
+};
+
+static const API_FIELD switch_fields[] =
+{
+    { "name",           HTTP_API_TYPE_STRING,   NULL,                   switch_name },
+    { "addr",           HTTP_API_TYPE_NUMBER,   switch_addr,            NULL        },
+    { "state",          HTTP_API_TYPE_NUMBER,   switch_state,           NULL        },
+    { "flags",          HTTP_API_TYPE_NUMBER,   switch_flags,           NULL        },
+    { "busy",           HTTP_API_TYPE_NUMBER,   switch_busy,            NULL        },
+};
+
+static const API_FIELD signal_fields[] =
+{
+    { "name",           HTTP_API_TYPE_STRING,   NULL,                   signal_name },
+    { "addr",           HTTP_API_TYPE_NUMBER,   signal_addr,            NULL        },
+    { "state",          HTTP_API_TYPE_NUMBER,   signal_state,           NULL        },
+};
+
+static const API_FIELD led_fields[] =
+{
+    { "name",           HTTP_API_TYPE_STRING,   NULL,                   led_name    },
+    { "addr",           HTTP_API_TYPE_NUMBER,   led_addr,               NULL        },
+    { "state",          HTTP_API_TYPE_NUMBER,   led_state,              NULL        },
+};
+
+static const API_FIELD rrg_fields[] =
+{
+    { "name",           HTTP_API_TYPE_STRING,   NULL,                   rrg_name    },
+    { "n_railroads",    HTTP_API_TYPE_NUMBER,   rrg_n_railroads,        NULL        },
+    { "active_railroad",HTTP_API_TYPE_NUMBER,   rrg_active_railroad,    NULL        },
+    { "switching",      HTTP_API_TYPE_NUMBER,   rrg_switching,          NULL        },
+    { "locked",         HTTP_API_TYPE_NUMBER,   rrg_locked,             NULL        },
+};
+
+static const API_FIELD s88_fields[] =
+{
+    { "name",           HTTP_API_TYPE_STRING,   NULL,                   s88_name    },
+    { "state",          HTTP_API_TYPE_NUMBER,   s88_state,              NULL        },
+    { "rrg",            HTTP_API_TYPE_NUMBER,   s88_rrg,                NULL        },
+    { "rr",             HTTP_API_TYPE_NUMBER,   s88_rr,                 NULL        },
+};
+
+static const API_FIELD rcl_fields[] =
+{
+    { "name",           HTTP_API_TYPE_STRING,   NULL,                   rcl_name    },
+    { "loco",           HTTP_API_TYPE_NUMBER,   rcl_loco,               NULL        },
+    { "last_loco",      HTTP_API_TYPE_NUMBER,   rcl_last_loco,          NULL        },
+    { "flags",          HTTP_API_TYPE_NUMBER,   rcl_flags,              NULL        },
+};
+
+static const API_COLLECTION collections[] =
+{
+    { "locos",              Locos::get_n_locos,         loco_fields,    N_FIELDS (loco_fields)      },
+    { "loco_stats",         Locos::get_n_locos,         loco_stats_fields, N_FIELDS (loco_stats_fields) },
+    { "addons",             AddOns::get_n_addons,       addon_fields,   N_FIELDS (addon_fields)     },
+    { "switches",           Switches::get_n_switches,   switch_fields,  N_FIELDS (switch_fields)    },
+    { "signals",            Signals::get_n_signals,     signal_fields,  N_FIELDS (signal_fields)    },
+    { "led_groups",         Leds::get_n_led_groups,     led_fields,     N_FIELDS (led_fields)       },
+    { "railroad_groups",    n_railroad_groups,          rrg_fields,     N_FIELDS (rrg_fields)       },
+    { "s88",                S88::get_n_contacts,        s88_fields,     N_FIELDS (s88_fields)       },
+    { "rcl",                n_rcl_tracks,               rcl_fields,     N_FIELDS (rcl_fields)       },
+};
+
+#define N_COLLECTIONS   (sizeof (collections) / sizeof (API_COLLECTION))
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * list_contains () - check if comma separated list contains name, an empty list contains all names
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+list_contains (const char * list, const char * name)
+{
+    size_t  len = strlen (name);
+
+    if (! *list)
+    {
+        return true;
+    }
+
+    while (*list)
+    {
+        const char * p = strchr (list, ',');
+        size_t       item_len = p ? (size_t) (p - list) : strlen (list);
+
+        if (item_len == len && ! strncmp (list, name, len))
+        {
+            return true;
+        }
+
+        if (! p)
+        {
+            break;
+        }
+
+        list = p + 1;
+    }
+
+    return false;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * json_string () - append ISO-8859-1 string as JSON string in UTF-8
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+json_string (const std::string& s)
+{
+    size_t  len = s.length();
+    size_t  idx;
+
+    HTTP::response.append ('"');
+
+    for (idx = 0; idx < len; idx++)
+    {
+        unsigned char ch = s[idx];
+
+        if (ch == '"' || ch == '\\')
+        {
+            HTTP::response.append ('\\');
+            HTTP::response.append (ch);
+        }
+        else if (ch < 0x20)
+        {
+            char    buf[8];
+
+            sprintf (buf, "\\u%04x", ch);
+            HTTP::response.append (buf);
+        }
+        else if (ch >= 0x80)                                            // U+0080 - U+00FF: 2 bytes in UTF-8
+        {
+            HTTP::response.append (0xC0 | (ch >> 6));
+            HTTP::response.append (0x80 | (ch & 0x3F));
+        }
+        else
+        {
+            HTTP::response.append (ch);
+        }
+    }
+
+    HTTP::response.append ('"');
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * bin_number () - append number in network byte order, size: 1, 2 or 4 bytes
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+bin_number (uint32_t value, uint_fast8_t size)
+{
+    while (size > 0)
+    {
+        size--;
+        HTTP::response.append ((char) ((value >> (8 * size)) & 0xFF));
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * bin_string () - append string with length byte, max. 255 bytes
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+bin_string (const std::string& s)
+{
+    size_t  len = s.length();
+
+    if (len > 255)
+    {
+        len = 255;
+    }
+
+    bin_number (len, 1);
+    HTTP::response.append (s.data(), len);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_range () - get first and last+1 index of items of collection from parameters offset and limit
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+get_range (uint_fast16_t n_items, uint_fast16_t * startp, uint_fast16_t * endp)
+{
+    const char *    slimit  = HTTP::parameter ("limit");
+    long            offset  = HTTP::parameter_number ("offset");
+    long            limit   = *slimit ? atol (slimit) : (long) n_items;
+
+    if (offset < 0 || offset > (long) n_items)
+    {
+        offset = n_items;
+    }
+
+    if (limit < 0)
+    {
+        limit = 0;
+    }
+
+    *startp = offset;
+    *endp   = (offset + limit < (long) n_items) ? offset + limit : n_items;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * state_json () - append collection as JSON
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+state_json (const API_COLLECTION * cp, const char * fields)
+{
+    uint_fast16_t   n_items = (*cp->get_n_items) ();
+    uint_fast16_t   start;
+    uint_fast16_t   end;
+    uint_fast16_t   idx;
+    uint_fast8_t    fidx;
+
+    get_range (n_items, &start, &end);
+
+    HTTP::response += (String) ",\"" + cp->name + "\":{\"total\":";
+    HTTP::response.append_num (n_items);
+    HTTP::response += ",\"offset\":";
+    HTTP::response.append_num (start);
+    HTTP::response += ",\"items\":[";
+
+    for (idx = start; idx < end; idx++)
+    {
+        if (idx > start)
+        {
+            HTTP::response.append (',');
+        }
+
+        HTTP::response += "{\"id\":";
+        HTTP::response.append_num (idx);
+
+        for (fidx = 0; fidx < cp->n_fields; fidx++)
+        {
+            const API_FIELD * fp = cp->fields + fidx;
+
+            if (list_contains (fields, fp->name))
+            {
+                HTTP::response += (String) ",\"" + fp->name + "\":";
+
+                if (fp->type == HTTP_API_TYPE_STRING)
+                {
+                    json_string ((*fp->get_string) (idx));
+                }
+                else
+                {
+                    HTTP::response.append_num ((*fp->get_number) (idx));
+                }
+            }
+        }
+
+        HTTP::response.append ('}');
+    }
+
+    HTTP::response += "]}";
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * state_bin () - append collection in binary encoding
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+state_bin (const API_COLLECTION * cp, const char * fields)
+{
+    uint_fast16_t   n_items = (*cp->get_n_items) ();
+    uint_fast16_t   start;
+    uint_fast16_t   end;
+    uint_fast16_t   idx;
+    uint_fast8_t    fidx;
+    uint_fast8_t    n_fields = 0;
+
+    get_range (n_items, &start, &end);
+
+    for (fidx = 0; fidx < cp->n_fields; fidx++)
+    {
+        if (list_contains (fields, cp->fields[fidx].name))
+        {
+            n_fields++;
+        }
+    }
+
+    bin_string (cp->name);
+    bin_number (n_items, 2);
+    bin_number (start, 2);
+    bin_number (end - start, 2);
+    bin_number (n_fields, 1);
+
+    for (fidx = 0; fidx < cp->n_fields; fidx++)
+    {
+        if (list_contains (fields, cp->fields[fidx].name))
+        {
+            bin_string (cp->fields[fidx].name);
+            bin_number (cp->fields[fidx].type, 1);
+        }
+    }
+
+    for (idx = start; idx < end; idx++)
+    {
+        bin_number (idx, 2);
+
+        for (fidx = 0; fidx < cp->n_fields; fidx++)
+        {
+            const API_FIELD * fp = cp->fields + fidx;
+
+            if (list_contains (fields, fp->name))
+            {
+                if (fp->type == HTTP_API_TYPE_STRING)
+                {
+                    bin_string ((*fp->get_string) (idx));
+                }
+                else
+                {
+                    bin_number ((*fp->get_number) (idx), 4);
+                }
+            }
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * handle_api () - API version, state version, collections and their fields
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_API::handle_api (void)
+{
+    uint_fast8_t    cidx;
+    uint_fast8_t    fidx;
+
+    HTTP::response += "{\"version\":";
+    HTTP::response.append_num (HTTP_API_VERSION);
+    HTTP::response += ",\"state_version\":";
+    HTTP::response.append_num (FM22::state_version);
+    HTTP::response += ",\"collections\":{";
+
+    for (cidx = 0; cidx < N_COLLECTIONS; cidx++)
+    {
+        const API_COLLECTION * cp = collections + cidx;
+
+        if (cidx > 0)
+        {
+            HTTP::response.append (',');
+        }
+
+        HTTP::response += (String) "\"" + cp->name + "\":{\"total\":";
+        HTTP::response.append_num ((*cp->get_n_items) ());
+        HTTP::response += ",\"fields\":[\"id\"";
+
+        for (fidx = 0; fidx < cp->n_fields; fidx++)
+        {
+            HTTP::response += (String) ",\"" + cp->fields[fidx].name + "\"";
+        }
+
+        HTTP::response += "]}";
+    }
+
+    HTTP::response += "}}\n";
+    HTTP::flush ();
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * handle_state_json () - items of collections as JSON
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_API::handle_state_json (void)
+{
+    const char *    scollections    = HTTP::parameter ("collections");
+    const char *    fields          = HTTP::parameter ("fields");
+    uint_fast8_t    cidx;
+
+    HTTP::response += "{\"version\":";
+    HTTP::response.append_num (HTTP_API_VERSION);
+    HTTP::response += ",\"state_version\":";
+    HTTP::response.append_num (FM22::state_version);
+
+    for (cidx = 0; cidx < N_COLLECTIONS; cidx++)
+    {
+        if (list_contains (scollections, collections[cidx].name))
+        {
+            state_json (collections + cidx, fields);
+        }
+    }
+
+    HTTP::response += "}\n";
+    HTTP::flush ();
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * handle_state_bin () - items of collections in binary encoding
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_API::handle_state_bin (void)
+{
+    const char *    scollections    = HTTP::parameter ("collections");
+    const char *    fields          = HTTP::parameter ("fields");
+    uint_fast8_t    n_collections   = 0;
+    uint_fast8_t    cidx;
+
+    for (cidx = 0; cidx < N_COLLECTIONS; cidx++)
+    {
+        if (list_contains (scollections, collections[cidx].name))
+        {
+            n_collections++;
+        }
+    }
+
+    bin_number (HTTP_API_VERSION, 1);
+    bin_number (FM22::state_version, 4);
+    bin_number (n_collections, 1);
+
+    for (cidx = 0; cidx < N_COLLECTIONS; cidx++)
+    {
+        if (list_contains (scollections, collections[cidx].name))
+        {
+            state_bin (collections + cidx, fields);
+        }
+    }
+
+    HTTP::flush ();
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_API::init (void)
+{
+    HTTP::add_page ("/api/v1",              HTTP_API::handle_api,           "application/json",         HTTP_PAGE_FLAG_READONLY);
+    HTTP::add_page ("/api/v1/state",        HTTP_API::handle_state_json,    "application/json",         HTTP_PAGE_FLAG_READONLY);
+    HTTP::add_page ("/api/v1/state.bin",    HTTP_API::handle_state_bin,     "application/octet-stream", HTTP_PAGE_FLAG_READONLY);
+}
@@ -0,0 +1,39 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * http-api.h - HTTP machine-readable state API
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef HTTP_API_H
+#define HTTP_API_H
+
+#include <stdint.h>
+
+#define HTTP_API_VERSION            1
+
+#define HTTP_API_TYPE_NUMBER        1                               // binary: uint32_t, network byte order
+#define HTTP_API_TYPE_STRING        2                               // binary: length (1 byte) + UTF-8 bytes
+
+class HTTP_API
+{
+    public:
+        static void     init (void);
+        static void     handle_api (void);
+        static void     handle_state_json (void);
+        static void     handle_state_bin (void);
+};
+
+#endif
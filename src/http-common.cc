@@ -49,6 +49,120 @@ bool                    HTTP_Common::edit_mode  = false;
 std::string             HTTP_Common::alert_msg  = "";
 static uint_fast8_t     todo_speed_deadtime     = 50;
 
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * common style sheet, served as static resource /fm22.css, see HTTP::static_url()
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+const char * HTTP_Common::common_css =
+    "BODY { FONT-FAMILY: Helvetica,Arial; FONT-SIZE: 14px; }\r\n"
+    "A, U { text-decoration: none; }\r\n"
+    "button, input[type=button], input[type=submit], input[type=reset] { background-color: #EEEEEE; border: 1px solid #AAAAEE; }\r\n"
+    "button:hover, input[type=button]:hover, input[type=submit]:hover, input[type=reset] { background-color: #DDDDDD; }\r\n"
+    "select { background-color: #FFFFFF; border: 1px solid #AAAAEE; }\r\n"
+    "select:hover { background-color: #EEEEEE; }\r\n"
+    ".estop { width:100%; height:32px; color:red; }\r\n"
+    ".estop:hover { color:white; background-color:red; }\r\n"
+    "option.red {\r\n"
+    "  /* background-color: #cc0000;*/\r\n"
+    "  font-weight: bold;\r\n"
+    "  font-size: 12px;\r\n"
+    "  /* color: white; */\r\n"
+    "}\r\n"
+    "@media screen and (max-width: 650px) { .hide650 { display:none; }}\r\n"       // on screens that are 650px or less, make content invisible
+    "@media screen and (max-width: 600px) { .hide600 { display:none; }}\r\n"
+    "@media screen and (max-width: 1000px) { .hide1000 { display:none; }}\r\n"
+    "@media screen and (max-width: 1200px) { .hide1200 { display:none; }}\r\n"
+    "@media screen and (max-width: 1800px) { .hide1800 { display:none; }}\r\n";
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * common javascript, served as static resource /fm22.js, see HTTP::static_url()
+ *
+ * action_handler() parses the response of /action?action=...: entries are separated by TAB, fields by BACKSPACE, see add_action_content()
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+const char * HTTP_Common::common_js =
+    "function estop()\r\n"
+    "{\r\n"
+    "  var http = new XMLHttpRequest(); http.open ('GET', '/action?action=estop'); http.send (null);\r\n"
+    "  document.getElementById('estop').style.color = 'white';\r\n"
+    "  document.getElementById('estop').style.backgroundColor = 'red';\r\n"
+    "  setTimeout(function()\r\n"
+    "  {\r\n"
+    "    document.getElementById('estop').style.color = '';\r\n"
+    "    document.getElementById('estop').style.backgroundColor = '';\r\n"
+    "  }, 500);\r\n"
+    "}\r\n"
+    "window.onkeyup = function (event) { if (event.keyCode == 27) { estop(); }}\r\n"
+    "function on() { var http = new XMLHttpRequest(); http.open ('GET', '/action?action=on'); http.send (null);}\r\n"
+    "function off() { var http = new XMLHttpRequest(); http.open ('GET', '/action?action=off'); http.send (null);}\r\n"
+    "function rstalert() { var http = new XMLHttpRequest(); http.open ('GET', '/action?action=rstalert');"
+    "http.addEventListener('load',"
+    "function(event) { if (http.status >= 200 && http.status < 300) { ; }});"
+    "http.send (null);}\r\n"
+    "function isiFrame() { try { return window.self !== window.top; } catch (e) { return true; } }\r\n"
+    "function hide_in_iframe() {\r\n"
+    "  if (isiFrame()) {\r\n"
+    "    document.getElementById('estop').style.display = 'none';\r\n"
+    "    document.getElementById('iframe2').style.display = 'none';\r\n"
+    "    document.getElementById('iframe3').style.display = 'none';\r\n"
+    "    document.getElementById('iframe4').style.display = 'none';\r\n"
+    "    document.getElementById('iframe6').style.display = 'none';\r\n"
+    "  }\r\n"
+    "}\r\n"
+    "function action_handler(action, parameters) {\r\n"
+    "  var http = new XMLHttpRequest(); http.open ('GET', '/action?action=' + action + parameters);\r\n"
+    "  http.addEventListener('load',\r\n"
+    "    function(event) {\r\n"
+    "      var i; var j;\r\n"
+    "      var text = http.responseText;\r\n"
+    "      if (http.status >= 200 && http.status < 300) {\r\n"
+    "        const a = text.split('\\t');\r\n"
+    "        var l = a.length - 1;\r\n"
+    "        for (i = 0; i < l; i++) {\r\n"
+    "          const b = a[i].split('\\b');\r\n"
+    "          var oo = document.getElementById(b[0]);\r\n"
+    "          if (oo) {\r\n"
+    "            switch (b[1])\r\n"
+    "            {\r\n"
+    "              case 'display':\r\n"
+    "                oo.style.display = b[2];\r\n"
+    "                break;\r\n"
+    "              case 'value':\r\n"
+    "                oo.value = b[2];\r\n"
+    "                break;\r\n"
+    "              case 'text':\r\n"
+    "                oo.textContent = b[2];\r\n"
+    "                break;\r\n"
+    "              case 'width':\r\n"
+    "                oo.style.width = b[2];\r\n"
+    "                break;\r\n"
+    "              case 'html':\r\n"
+    "                oo.innerHTML = b[2];\r\n"
+    "                break;\r\n"
+    "              case 'checked':\r\n"
+    "                oo.checked = parseInt(b[2]);\r\n"
+    "                break;\r\n"
+    "              case 'color':\r\n"
+    "                oo.style.color = b[2];\r\n"
+    "                break;\r\n"
+    "              case 'bgcolor':\r\n"
+    "                oo.style.backgroundColor = b[2];\r\n"
+    "                break;\r\n"
+    "              default:\r\n"
+    "                console.log ('invalid type: ' + b[1]);\r\n"
+    "                break;\r\n"
+    "            }\r\n"
+    "          }\r\n"
+    "        }\r\n"
+    "      }\r\n"
+    "    }\r\n"
+    "  );\r\n"
+    "  http.send (null);\r\n"
+    "}\r\n"
+    "function add_action_handler(action, parameters, msec) {\r\n"
+    "  return window.setInterval(function(){ action_handler (action, parameters); }, msec);\r\n"
+    "}\r\n";
+
 /*----------------------------------------------------------------------------------------------------------------------------------------
  * global data:
  *----------------------------------------------------------------------------------------------------------------------------------------
@@ -324,6 +438,7 @@ HTTP_Common::html_header (String browsertitle, String title, String url, bool us
     String network_color        = "blue";
     String upload_color         = "blue";
     String flash_color          = "blue";
+    String locostats_color      = "blue";
     String info_color           = "blue";
 
     if (url.compare ("/") == 0 || url.compare ("/loco") == 0)
@@ -436,6 +551,11 @@ HTTP_Common::html_header (String browsertitle, String title, String url, bool us
         flash_color = "red";
         system_color = "red";
     }
+    else if (url.compare ("/locostats") == 0)
+    {
+        locostats_color = "red";
+        system_color = "red";
+    }
     else if (url.compare ("/info") == 0)
     {
         info_color = "red";
@@ -468,54 +588,10 @@ HTTP_Common::html_header (String browsertitle, String title, String url, bool us
     HTTP::response += (String)
         "<title>" + mainbrowsertitle + "</title>\r\n"
         "<meta name='viewport' content='width=device-width,initial-scale=1'/>\r\n"
-        "<style>\r\n"
-        "BODY { FONT-FAMILY: Helvetica,Arial; FONT-SIZE: 14px; }\r\n"
-        "A, U { text-decoration: none; }\r\n"
-        "button, input[type=button], input[type=submit], input[type=reset] { background-color: #EEEEEE; border: 1px solid #AAAAEE; }\r\n"
-        "button:hover, input[type=button]:hover, input[type=submit]:hover, input[type=reset] { background-color: #DDDDDD; }\r\n"
-        "select { background-color: #FFFFFF; border: 1px solid #AAAAEE; }\r\n"
-        "select:hover { background-color: #EEEEEE; }\r\n"
-        ".estop { width:100%; height:32px; color:red; }\r\n"
-        ".estop:hover { color:white; background-color:red; }\r\n";
-
-    HTTP::flush ();
-
-    HTTP::response += (String)
-        "option.red {\r\n"
-        "  /* background-color: #cc0000;*/\r\n"
-        "  font-weight: bold;\r\n"
-        "  font-size: 12px;\r\n"
-        "  /* color: white; */\r\n"
-        "}\r\n";
-
-    /* On screens that are 650px or less, make content invisible */
-    HTTP::response += (String)
-        "@media screen and (max-width: 650px) { .hide650 { display:none; }}\r\n"
-        "@media screen and (max-width: 600px) { .hide600 { display:none; }}\r\n"
-        "@media screen and (max-width: 1000px) { .hide1000 { display:none; }}\r\n"
-        "@media screen and (max-width: 1200px) { .hide1200 { display:none; }}\r\n"
-        "@media screen and (max-width: 1800px) { .hide1800 { display:none; }}\r\n";
-
-    HTTP::response += (String)
-        "</style>\r\n"
+        "<link rel='stylesheet' href='" + HTTP::static_url ("/fm22.css") + "'>\r\n"
+        "<script src='" + HTTP::static_url ("/fm22.js") + "'></script>\r\n"
         "</head>\r\n"
-        "<body>\r\n"
-        "<script>\r\n"
-        "function estop()"
-        "{"
-        "  var http = new XMLHttpRequest(); http.open ('GET', '/action?action=estop'); http.send (null);"
-        "  document.getElementById('estop').style.color = 'white';"
-        "  document.getElementById('estop').style.backgroundColor = 'red';"
-        "  setTimeout(function()"
-        "  {"
-        "    document.getElementById('estop').style.color = '';"
-        "    document.getElementById('estop').style.backgroundColor = '';"
-        "  }, 500);"
-        "}\r\n"
-        "window.onkeyup = function (event) { if (event.keyCode == 27) { estop(); }}\r\n"
-        "function on() { var http = new XMLHttpRequest(); http.open ('GET', '/action?action=on'); http.send (null);}\r\n"
-        "function off() { var http = new XMLHttpRequest(); http.open ('GET', '/action?action=off'); http.send (null);}\r\n"
-        "</script>\r\n";
+        "<body>\r\n";
 
     if (DCC::booster_is_on)
     {
@@ -595,6 +671,7 @@ HTTP_Common::html_header (String browsertitle, String title, String url, bool us
     }
 
     HTTP::response += (String)
+        "    <option style='color:" + locostats_color + "' value='/locostats'>Lok-Diagnose</option>\r\n"
         "    <option style='color:" + info_color + "' value='/info'>Info</option>\r\n"
         "  </select>\r\n"
         "</td>\r\n"
@@ -606,23 +683,7 @@ HTTP_Common::html_header (String browsertitle, String title, String url, bool us
         "</tr>\r\n"
         "</table>\r\n";
 
-    HTTP::flush ();
-
-    HTTP::response += (String)
-        "<script>"
-        "function isiFrame() { try { return window.self !== window.top; } catch (e) { return true; } }\r\n"
-        "if (isiFrame()) {\r\n"
-        "  document.getElementById('estop').style.display = 'none';\r\n"
-        "  document.getElementById('iframe2').style.display = 'none';\r\n"
-        "  document.getElementById('iframe3').style.display = 'none';\r\n"
-        "  document.getElementById('iframe4').style.display = 'none';\r\n"
-        "  document.getElementById('iframe6').style.display = 'none';\r\n"
-        "}\r\n"
-        "function rstalert() { var http = new XMLHttpRequest(); http.open ('GET', '/action?action=rstalert');"
-        "http.addEventListener('load',"
-        "function(event) { if (http.status >= 200 && http.status < 300) { ; }});"
-        "http.send (null);}\r\n"
-        "</script>\r\n";
+    HTTP::response += (String) "<script>hide_in_iframe();</script>\r\n";
 
     HTTP::flush ();
 
@@ -666,6 +727,33 @@ HTTP_Common::html_trailer (void)
     HTTP::flush ();
 }
 
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * HTTP_Common::html_escape () - escape text from client for output in html text or attribute values
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+String
+HTTP_Common::html_escape (const char * s)
+{
+    String  rtc;
+
+    while (*s)
+    {
+        switch (*s)
+        {
+            case '&':   rtc += "&amp;";     break;
+            case '<':   rtc += "&lt;";      break;
+            case '>':   rtc += "&gt;";      break;
+            case '"':   rtc += "&quot;";    break;
+            case '\'':  rtc += "&#39;";     break;
+            default:    rtc += *s;          break;
+        }
+
+        s++;
+    }
+
+    return rtc;
+}
+
 /*----------------------------------------------------------------------------------------------------------------------------------------
  * head_action ()
  *----------------------------------------------------------------------------------------------------------------------------------------
@@ -914,6 +1002,19 @@ HTTP_Common::handle_setup (void)
         HTTP::flush ();
     }
 
+    FILEIO_STATS    fstats;
+
+    FileIO::get_stats (&fstats);
+
+    HTTP::response += (String)
+        "<P><div style='padding:10px;width:400px;border:1px lightgray solid'>\r\n"
+        "  <B>Konfigurationsdateien:</B><P>"
+        "  Geschrieben: " + std::to_string (fstats.n_written) + " (" + std::to_string (fstats.bytes_written) + " Bytes)<BR>\r\n"
+        "  Zusammengefasst: " + std::to_string (fstats.n_coalesced) + ", ausstehend: " + std::to_string (fstats.n_pending) + "<BR>\r\n"
+        "  Fehler: " + std::to_string (fstats.n_failed) + "<BR>\r\n"
+        "  Schreibdauer: " + std::to_string (fstats.last_duration / 1000) + " msec, max. " + std::to_string (fstats.max_duration / 1000) + " msec\r\n"
+        "</div>\r\n";
+
     HTTP::response += (String) "</div>\r\n";
     HTTP_Common::html_trailer ();
 }
@@ -923,9 +1024,30 @@ HTTP_Common::handle_setup (void)
  *----------------------------------------------------------------------------------------------------------------------------------------
  */
 void
-HTTP_Common::add_action_content (String id, String type, String value)
+HTTP_Common::add_action_content (const String& id, const String& type, const String& value)
 {
-    HTTP::response += id + "\b" + type + "\b" + value + "\t";
+    HTTP::response.append (id);
+    HTTP::response.append ('\b');
+    HTTP::response.append (type);
+    HTTP::response.append ('\b');
+    HTTP::response.append (value);
+    HTTP::response.append ('\t');
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * add_action_content () - same as above, but id is built from prefix and index without temporary strings, e.g. "o" + "17"
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Common::add_action_content (const char * id_prefix, uint_fast16_t id_idx, const char * type, const char * value)
+{
+    HTTP::response.append (id_prefix);
+    HTTP::response.append_num (id_idx);
+    HTTP::response.append ('\b');
+    HTTP::response.append (type);
+    HTTP::response.append ('\b');
+    HTTP::response.append (value);
+    HTTP::response.append ('\t');
 }
 
 void
@@ -950,57 +1072,7 @@ HTTP_Common::add_action_handler (const char * action, const char * parameters, i
     }
 
     HTTP::response += (String)
-        "function action_handler_" + action + "() {\r\n"
-        "  var http = new XMLHttpRequest(); http.open ('GET', '/action?action=" + action + sparam + "');\r\n"
-        "  http.addEventListener('load',\r\n"
-        "    function(event) {\r\n"
-        "      var i; var j;\r\n"
-        "      var text = http.responseText;\r\n"
-        "      if (http.status >= 200 && http.status < 300) {\r\n"
-        "        const a = text.split('\t');\r\n"
-        "        var l = a.length - 1;\r\n"
-        "        for (i = 0; i < l; i++) {\r\n"
-        "          const b = a[i].split('\b');\r\n"
-        "          var oo = document.getElementById(b[0]);\r\n"
-        "          if (oo) {\r\n"
-        "            switch (b[1])\r\n"
-        "            {\r\n"
-        "              case 'display':\r\n"
-        "                oo.style.display = b[2];\r\n"
-        "                break;\r\n"
-        "              case 'value':\r\n"
-        "                oo.value = b[2];\r\n"
-        "                break;\r\n"
-        "              case 'text':\r\n"
-        "                oo.textContent = b[2];\r\n"
-        "                break;\r\n"
-        "              case 'width':\r\n"
-        "                oo.style.width = b[2];\r\n"
-        "                break;\r\n"
-        "              case 'html':\r\n"
-        "                oo.innerHTML = b[2];\r\n"
-        "                break;\r\n"
-        "              case 'checked':\r\n"
-        "                oo.checked = parseInt(b[2]);\r\n"
-        "                break;\r\n"
-        "              case 'color':\r\n"
-        "                oo.style.color = b[2];\r\n"
-        "                break;\r\n"
-        "              case 'bgcolor':\r\n"
-        "                oo.style.backgroundColor = b[2];\r\n"
-        "                break;\r\n"
-        "              default:\r\n"
-        "                console.log ('invalid type: ' + b[1]);\r\n"
-        "                break;\r\n"
-        "            }\r\n"
-        "          }\r\n"
-        "        }\r\n"
-        "      }\r\n"
-        "    }\r\n"
-        "  );\r\n"
-        "  http.send (null);\r\n"
-        "}\r\n"
-        "var intervalId" + action + " = window.setInterval(function(){ action_handler_" + action + " (); }, " + std::to_string(msec) + ");\r\n";
+        "var intervalId" + action + " = add_action_handler ('" + action + "', '" + sparam + "', " + std::to_string(msec) + ");\r\n";
 
     if (do_print_script_tag)
     {
@@ -1069,6 +1141,55 @@ HTTP_Common::print_id_select_list (String name, uint_fast16_t n_entries, uint_fa
         "</td>\r\n";
 }
 
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * print_position_select_list () - select new position in display order
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Common::print_position_select_list (String name, uint_fast16_t n_entries, uint_fast16_t selected_position)
+{
+    uint_fast16_t i;
+
+    HTTP::response += (String)
+        "<td>Position:</td><td>"
+        "<select id='" + name + "' name='" + name + "'>\r\n";
+
+    for (i = 0; i < n_entries; i++)
+    {
+        if (i == selected_position)
+        {
+            HTTP::response += (String) "<option value='" + std::to_string(i) + "' selected>" + std::to_string(i) + "</option>\r\n";
+        }
+        else
+        {
+            HTTP::response += (String) "<option value='" + std::to_string(i) + "'>" + std::to_string(i) + "</option>\r\n";
+        }
+    }
+
+    HTTP::response += (String)
+        "</select>\r\n"
+        "</td>\r\n";
+}
+
+void
+HTTP_Common::print_position_select_list (String name, uint_fast16_t n_entries)
+{
+    uint_fast16_t i;
+
+    HTTP::response += (String)
+        "<td>Neue Position:</td><td>"
+        "<select id='" + name + "' name='" + name + "'>\r\n";
+
+    for (i = 0; i < n_entries; i++)
+    {
+        HTTP::response += (String) "<option value='" + std::to_string(i) + "'>" + std::to_string(i) + "</option>\r\n";
+    }
+
+    HTTP::response += (String)
+        "</select>\r\n"
+        "</td>\r\n";
+}
+
 /*----------------------------------------------------------------------------------------------------------------------------------------
  * print_loco_select_list ()
  *----------------------------------------------------------------------------------------------------------------------------------------
@@ -1116,10 +1237,13 @@ HTTP_Common::print_loco_select_list (String name, uint_fast16_t selected_idx, ui
     if (show_mask & LOCO_LIST_SHOW_DETECTED_LOCO)
     {
         uint_fast8_t    n_tracks = RCL::get_n_tracks ();
+        uint_fast8_t    track_pos;
         uint_fast8_t    track_idx;
 
-        for (track_idx = 0; track_idx < n_tracks; track_idx++)
+        for (track_pos = 0; track_pos < n_tracks; track_pos++)
         {
+            track_idx = RCL::get_track_idx (track_pos);
+
             HTTP::response += (String) "<option value='" + std::to_string(S88_RCL_DETECTED_OFFSET + track_idx) + "'";
 
             if (selected_idx == S88_RCL_DETECTED_OFFSET + track_idx)
@@ -1136,11 +1260,12 @@ HTTP_Common::print_loco_select_list (String name, uint_fast16_t selected_idx, ui
     }
 
     uint_fast16_t   n_locos = Locos::get_n_locos ();
-    uint_fast16_t   lidx;
+    uint_fast16_t   pos;
 
-    for (lidx = 0; lidx < n_locos; lidx++)
+    for (pos = 0; pos < n_locos; pos++)
     {
-        std::string name = Locos::locos[lidx].get_name();
+        uint_fast16_t   lidx = Locos::get_loco_idx (pos);
+        std::string     name = Locos::locos[lidx].get_name();
 
         HTTP::response += (String) "<option value='" + std::to_string(lidx) + "'";
 
@@ -1609,6 +1734,7 @@ HTTP_Common::print_railroad_group_list (String name, uint_fast8_t rrgidx, bool d
 {
     String          style;
     uint_fast8_t    n_railroad_groups   = RailroadGroups::get_n_railroad_groups ();
+    uint_fast8_t    pos;
     uint_fast8_t    idx;
 
     if (! do_display)
@@ -1638,8 +1764,10 @@ HTTP_Common::print_railroad_group_list (String name, uint_fast8_t rrgidx, bool d
         HTTP::response += (String) "<option value='255' " + selected + ">---</option>\r\n";
     }
 
-    for (idx = 0; idx < n_railroad_groups; idx++)
+    for (pos = 0; pos < n_railroad_groups; pos++)
     {
+        idx = RailroadGroups::get_railroad_group_idx (pos);
+
         RailroadGroup * rrg = &RailroadGroups::railroad_groups[idx];
         String          selected;
 
@@ -1663,6 +1791,8 @@ HTTP_Common::print_railroad_list (String name, uint_fast16_t linkedrr, bool do_a
 {
     String          style;
     uint_fast8_t    n_railroad_groups   = RailroadGroups::get_n_railroad_groups ();
+    uint_fast8_t    pos;
+    uint_fast8_t    rrpos;
     uint_fast8_t    rrgidx;
     uint_fast8_t    rridx;
 
@@ -1682,13 +1812,17 @@ HTTP_Common::print_railroad_list (String name, uint_fast16_t linkedrr, bool do_a
         HTTP::response += (String) "<option value='65535'>--- Kein Gleis ---</option>\r\n";
     }
 
-    for (rrgidx = 0; rrgidx < n_railroad_groups; rrgidx++)
+    for (pos = 0; pos < n_railroad_groups; pos++)
     {
+        rrgidx = RailroadGroups::get_railroad_group_idx (pos);
+
         RailroadGroup * rrg         = &RailroadGroups::railroad_groups[rrgidx];
         uint_fast8_t    n_railroads = rrg->get_n_railroads();
 
-        for (rridx = 0; rridx < n_railroads; rridx++)
+        for (rrpos = 0; rrpos < n_railroads; rrpos++)
         {
+            rridx = rrg->get_railroad_idx (rrpos);
+
             String          selected;
             String          sloco_name;
             Railroad *      rr          = &(rrg->railroads[rridx]);
@@ -1726,6 +1860,7 @@ HTTP_Common::print_s88_list (String name, uint_fast16_t coidx, bool do_display)
 {
     String          style;
     uint_fast16_t   n_contacts  = S88::get_n_contacts ();
+    uint_fast16_t   pos;
     uint_fast16_t   idx;
 
     if (! do_display)
@@ -1739,10 +1874,12 @@ HTTP_Common::print_s88_list (String name, uint_fast16_t coidx, bool do_display)
 
     HTTP::response += (String) "<select " + style + " name='" + name + "' id='" + name + "'>\r\n";
 
-    for (idx = 0; idx < n_contacts; idx++)
+    for (pos = 0; pos < n_contacts; pos++)
     {
         String          selected;
 
+        idx = S88::get_contact_idx (pos);
+
         if (idx == coidx)
         {
             selected = "selected";
@@ -1763,6 +1900,7 @@ HTTP_Common::print_switch_list (String name, uint_fast16_t swidx, bool do_displa
 {
     String          style;
     uint_fast16_t   n_switches = Switches::get_n_switches ();
+    uint_fast16_t   pos;
     uint_fast16_t   idx;
 
     if (! do_display)
@@ -1776,10 +1914,12 @@ HTTP_Common::print_switch_list (String name, uint_fast16_t swidx, bool do_displa
 
     HTTP::response += (String) "<select " + style + " name='" + name + "' id='" + name + "'>\r\n";
 
-    for (idx = 0; idx < n_switches; idx++)
+    for (pos = 0; pos < n_switches; pos++)
     {
         String          selected;
 
+        idx = Switches::get_switch_idx (pos);
+
         if (idx == swidx)
         {
             selected = "selected";
@@ -1851,6 +1991,7 @@ HTTP_Common::print_signal_list (String name, uint_fast16_t swidx, bool do_displa
 {
     String          style;
     uint_fast16_t   n_signals = Signals::get_n_signals ();
+    uint_fast16_t   pos;
     uint_fast16_t   idx;
 
     if (! do_display)
@@ -1864,10 +2005,12 @@ HTTP_Common::print_signal_list (String name, uint_fast16_t swidx, bool do_displa
 
     HTTP::response += (String) "<select " + style + " name='" + name + "' id='" + name + "'>\r\n";
 
-    for (idx = 0; idx < n_signals; idx++)
+    for (pos = 0; pos < n_signals; pos++)
     {
         String          selected;
 
+        idx = Signals::get_signal_idx (pos);
+
         if (idx == swidx)
         {
             selected = "selected";
@@ -1928,6 +2071,7 @@ HTTP_Common::print_led_group_list (String name, uint_fast16_t swidx, bool do_dis
 {
     String          style;
     uint_fast16_t   n_led_groups = Leds::get_n_led_groups ();
+    uint_fast16_t   pos;
     uint_fast16_t   idx;
 
     if (! do_display)
@@ -1941,10 +2085,12 @@ HTTP_Common::print_led_group_list (String name, uint_fast16_t swidx, bool do_dis
 
     HTTP::response += (String) "<select " + style + " name='" + name + "' id='" + name + "'>\r\n";
 
-    for (idx = 0; idx < n_led_groups; idx++)
+    for (pos = 0; pos < n_led_groups; pos++)
     {
         String          selected;
 
+        idx = Leds::get_led_group_idx (pos);
+
         if (idx == swidx)
         {
             selected = "selected";
@@ -2560,3 +2706,32 @@ HTTP_Common::action_go (void)
     uint_fast16_t   loco_idx      = HTTP::parameter_number ("loco_idx");
     Event::delete_event_wait_s88 (loco_idx);
 }
+
+void
+HTTP_Common::action_estop (void)
+{
+    Locos::estop ();
+}
+
+void
+HTTP_Common::action_rstalert (void)
+{
+    HTTP::set_alert ("");
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Common::init (void)
+{
+    HTTP::add_page   ("/info",     HTTP_Common::handle_info);
+    HTTP::add_page   ("/setup",    HTTP_Common::handle_setup);
+    HTTP::add_action ("head",      HTTP_Common::head_action,     HTTP_ACTION_FLAG_CACHEABLE);
+    HTTP::add_action ("estop",     HTTP_Common::action_estop,    0);
+    HTTP::add_action ("on",        HTTP_Common::action_on,       0);
+    HTTP::add_action ("off",       HTTP_Common::action_off,      0);
+    HTTP::add_action ("rstalert",  HTTP_Common::action_rstalert, 0);
+    HTTP::add_action ("go",        HTTP_Common::action_go,       0);
+}
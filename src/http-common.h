@@ -38,17 +38,22 @@
 class HTTP_Common
 {
     public:
+        static void             init (void);
         static bool             edit_mode;
         static std::string      alert_msg;
         static const char *     manufacturers[256];
+        static const char *     common_css;
+        static const char *     common_js;
 
         static void             html_header (String browsertitle, String title, String url, bool use_utf8);
         static void             html_trailer (void);
+        static String           html_escape (const char * s);
         static void             head_action (void);
         static void             handle_info (void);
         static void             handle_setup (void);
 
-        static void             add_action_content (String id, String type, String value);
+        static void             add_action_content (const String& id, const String& type, const String& value);
+        static void             add_action_content (const char * id_prefix, uint_fast16_t id_idx, const char * type, const char * value);
         static void             print_start_list (String name, uint_fast16_t selected_start, bool do_display);
         static void             print_speed_list (String name, uint_fast16_t selected_speed, bool do_display);
         static void             print_tenths_list (String name, uint_fast16_t selected_tenths, bool do_display);
@@ -62,6 +67,8 @@ class HTTP_Common
         static void             print_addon_select_list (String name, uint_fast16_t selected_idx, uint_fast16_t show_mask);
         static void             print_id_select_list (String name, uint_fast16_t n_entries);
         static void             print_id_select_list (String name, uint_fast16_t n_entries, uint_fast16_t selected_idx);
+        static void             print_position_select_list (String name, uint_fast16_t n_entries);
+        static void             print_position_select_list (String name, uint_fast16_t n_entries, uint_fast16_t selected_position);
         static void             print_loco_macro_list (String name, uint_fast16_t selected_m, bool do_display);
         static void             print_railroad_group_list (String name, uint_fast8_t rrgidx, bool do_display_norrg, bool do_display);
         static void             print_railroad_list (String name, uint_fast16_t linkedrr, bool do_allow_none, bool do_display);
@@ -82,6 +89,8 @@ class HTTP_Common
         static void             action_on (void);
         static void             action_off (void);
         static void             action_go (void);
+        static void             action_estop (void);
+        static void             action_rstalert (void);
     private:
 };
 
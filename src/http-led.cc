@@ -46,6 +46,7 @@ HTTP_Led::handle_led (void)
     String          url       = "/led";
     const char *    action    = HTTP::parameter ("action");
     uint_fast16_t   led_group_idx  = 0;
+    uint_fast16_t   pos;
 
     HTTP_Common::html_header (title, title, url, true);
     HTTP::response += (String) "<div style='margin-left:20px;'>\r\n";
@@ -83,13 +84,11 @@ HTTP_Led::handle_led (void)
     {
         const char *    sname     = HTTP::parameter ("name");
         uint_fast16_t   led_group_idx     = HTTP::parameter_number ("led_group_idx");
-        uint_fast16_t   nled_group_idx    = HTTP::parameter_number ("nled_group_idx");
+        uint_fast16_t   npos      = HTTP::parameter_number ("npos");
         uint_fast16_t   addr      = HTTP::parameter_number ("addr");
+        uint_fast16_t   nled_group_idx;
 
-        if (led_group_idx != nled_group_idx)
-        {
-            nled_group_idx = Leds::set_new_id (led_group_idx, nled_group_idx);
-        }
+        nled_group_idx = Leds::set_position (led_group_idx, npos);      // led group keeps its index, only display order changes
 
         if (nled_group_idx != 0xFFFF)
         {
@@ -171,8 +170,10 @@ HTTP_Led::handle_led (void)
     String        checked;
     uint_fast16_t n_led_groups = Leds::get_n_led_groups ();
 
-    for (led_group_idx = 0; led_group_idx < n_led_groups; led_group_idx++)
+    for (pos = 0; pos < n_led_groups; pos++)
     {
+        led_group_idx = Leds::get_led_group_idx (pos);
+
         if (*bg)
         {
             bg = "";
@@ -219,7 +220,7 @@ HTTP_Led::handle_led (void)
         if (HTTP_Common::edit_mode)
         {
             HTTP::response += (String) "<td><button onclick=\"changeled("
-                  + lg + ",'" + name + "'," + std::to_string(addr)
+                  + lg + "," + std::to_string(pos) + ",'" + name + "'," + std::to_string(addr)
                   + ")\">Bearbeiten</button></td>";
 
             HTTP::response += (String) "<td><form method='get' action='" + url + "'>"
@@ -239,11 +240,11 @@ HTTP_Led::handle_led (void)
 
     HTTP::response += (String)
         "<script>\r\n"
-        "function changeled(led_group_idx, name, addr)\r\n"
+        "function changeled(led_group_idx, pos, name, addr)\r\n"
         "{\r\n"
         "  document.getElementById('action').value = 'changeled';\r\n"
         "  document.getElementById('led_group_idx').value = led_group_idx;\r\n"
-        "  document.getElementById('nled_group_idx').value = led_group_idx;\r\n"
+        "  document.getElementById('npos').value = pos;\r\n"
         "  document.getElementById('name').value = name;\r\n"
         "  document.getElementById('addr').value = addr;\r\n"
         "  document.getElementById('newid').style.display='';\r\n"
@@ -278,7 +279,7 @@ HTTP_Led::handle_led (void)
             "<table>\r\n"
             "<tr id='newid'>\r\n";
 
-        HTTP_Common::print_id_select_list ("nled_group_idx", n_led_groups);
+        HTTP_Common::print_position_select_list ("npos", n_led_groups);
 
         HTTP::response += (String)
             "</tr>\r\n"
@@ -337,3 +338,15 @@ HTTP_Led::action_led (void)
         }
     }
 }
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Led::init (void)
+{
+    HTTP::add_page   ("/led",    HTTP_Led::handle_led);
+    HTTP::add_action ("led",     HTTP_Led::action_led,    HTTP_ACTION_FLAG_CACHEABLE);
+    HTTP::add_action ("setled",  HTTP_Led::action_setled, 0);
+}
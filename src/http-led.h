@@ -25,6 +25,7 @@
 class HTTP_Led
 {
     public:
+        static void     init (void);
         static void     handle_led (void);
         static void     action_setled (void);
         static void     action_led (void);
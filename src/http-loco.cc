@@ -38,6 +38,7 @@
 #include "http.h"
 #include "http-common.h"
 #include "http-loco.h"
+#include "locostats.h"
 
 #define LOCO_SORT_IDX       0
 #define LOCO_SORT_ADDR      1
@@ -903,15 +904,13 @@ HTTP_Loco::handle_loco (void)
     {
         const char *    sname   = HTTP::parameter ("name");
         uint_fast16_t   lidx    = HTTP::parameter_number ("lidx");
-        uint_fast16_t   nlidx   = HTTP::parameter_number ("nlidx");
+        uint_fast16_t   npos    = HTTP::parameter_number ("npos");
         uint_fast16_t   addr    = HTTP::parameter_number ("addr");
         uint_fast8_t    steps   = HTTP::parameter_number ("steps");
         uint_fast8_t    active  = HTTP::parameter_number ("active");
+        uint_fast16_t   nlidx;
 
-        if (lidx != nlidx)
-        {
-            nlidx = Locos::set_new_id (lidx, nlidx);
-        }
+        nlidx = Locos::set_position (lidx, npos);                       // loco keeps its index, only display order changes
 
         if (nlidx != 0xFFFF)
         {
@@ -1464,9 +1463,9 @@ HTTP_Loco::handle_loco (void)
         String          scolor_name;
         String          scolor_addr;
 
-        for (loco_idx = 0; loco_idx < n_locos; loco_idx++)
+        for (map_idx = 0; map_idx < n_locos; map_idx++)
         {
-            loco_map[loco_idx] = loco_idx;
+            loco_map[map_idx] = Locos::get_loco_idx (map_idx);
         }
 
         if (nsort == LOCO_SORT_NAME)
@@ -1563,7 +1562,7 @@ HTTP_Loco::handle_loco (void)
             {
                 HTTP::response += (String) 
                     "<td><button onclick=\""
-                    "changeloco(" + sl + ",'" + lp->get_name() +
+                    "changeloco(" + sl + "," + std::to_string(Locos::get_position (loco_idx)) + ",'" + lp->get_name() +
                     "'," + std::to_string(lp->get_addr()) + "," + std::to_string(lp->get_speed_steps()) + "," + std::to_string(lp->is_active()) +
                     ")\">Bearbeiten</button></td>";
             }
@@ -1576,11 +1575,11 @@ HTTP_Loco::handle_loco (void)
 
         HTTP::response += (String)
             "<script>\r\n"
-            "function changeloco(lidx, name, addr, steps, act)"
+            "function changeloco(lidx, pos, name, addr, steps, act)"
             "{"
             "  document.getElementById('action').value = 'changeloco';"
             "  document.getElementById('lidx').value = lidx;"
-            "  document.getElementById('nlidx').value = lidx;"
+            "  document.getElementById('npos').value = pos;"
             "  document.getElementById('name').value = name;"
             "  document.getElementById('addr').value = addr;"
             "  document.getElementById('steps').value = steps;"
@@ -1619,7 +1618,7 @@ HTTP_Loco::handle_loco (void)
                 "<table>\r\n"
                 "<tr id='newid'>\r\n";
 
-            HTTP_Common::print_id_select_list ("nlidx", n_locos);
+            HTTP_Common::print_position_select_list ("npos", n_locos);
 
             HTTP::response += (String)
                 "</tr>\r\n"
@@ -1653,36 +1652,35 @@ HTTP_Loco::action_locos (void)
     for (loco_idx = 0; loco_idx < n_locos; loco_idx++)
     {
         auto&           Loco        = Locos::locos[loco_idx];
-        String          sl          = std::to_string(loco_idx);
         uint_fast8_t    is_online   = Loco.is_online ();
         bool            is_halt     = Loco.get_flag_halt ();
         uint_fast8_t    rc2_rate    = Loco.get_rc2_rate ();
-        String          id;
-
-        id = (String) "o" + sl;
 
         if (is_halt)
         {
-            HTTP_Common::add_action_content (id, "bgcolor", "red");
-            HTTP_Common::add_action_content (id, "color", "white");
+            HTTP_Common::add_action_content ("o", loco_idx, "bgcolor", "red");
+            HTTP_Common::add_action_content ("o", loco_idx, "color", "white");
         }
         else if (is_online)
         {
-            HTTP_Common::add_action_content (id, "bgcolor", "green");
-            HTTP_Common::add_action_content (id, "color", "white");
+            HTTP_Common::add_action_content ("o", loco_idx, "bgcolor", "green");
+            HTTP_Common::add_action_content ("o", loco_idx, "color", "white");
         }
         else
         {
-            HTTP_Common::add_action_content (id, "bgcolor", "");
-            HTTP_Common::add_action_content (id, "color", "");
+            HTTP_Common::add_action_content ("o", loco_idx, "bgcolor", "");
+            HTTP_Common::add_action_content ("o", loco_idx, "color", "");
         }
 
-        id = (String) "rc2r" + sl;
-        HTTP_Common::add_action_content (id, "text", std::to_string(rc2_rate) + "%");
+        HTTP::response.append ("rc2r");                                        // rc2 rate in percent
+        HTTP::response.append_num (loco_idx);
+        HTTP::response.append ("\btext\b");
+        HTTP::response.append_num (rc2_rate);
+        HTTP::response.append ("%\t");
 
         std::string slocation = HTTP_Common::get_location (loco_idx);
 
-        HTTP_Common::add_action_content ((String) "loc" + sl, "text", slocation);
+        HTTP_Common::add_action_content ("loc", loco_idx, "text", slocation.c_str());
     }
 }
 
@@ -1899,3 +1897,155 @@ HTTP_Loco::action_macro (void)
 
     Loco.execute_macro (macroidx);
 }
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * stats_cell () - table cell with value in msec or percent, LOCOSTATS_NONE or 0xFF is printed as "-"
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+stats_cell (uint32_t value, uint32_t none)
+{
+    HTTP::response += "<td align='right'>";
+
+    if (value == none)
+    {
+        HTTP::response += "-";
+    }
+    else
+    {
+        HTTP::response.append_num (value);
+    }
+
+    HTTP::response += "</td>";
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * handle_loco_stats () - track refresh and RailCom quality of active locos, sorted by p99 of speed refresh interval
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Loco::handle_loco_stats (void)
+{
+    String                      title       = "Lok-Diagnose";
+    String                      url         = "/locostats";
+    uint_fast16_t               n_locos     = Locos::get_n_locos ();
+    std::vector<uint16_t>       loco_map;
+    std::vector<uint16_t>       speed_p99 (n_locos);
+    const char *                bg          = "bgcolor='#e0e0e0'";
+    uint_fast16_t               loco_idx;
+    uint_fast16_t               map_idx;
+
+    for (loco_idx = 0; loco_idx < n_locos; loco_idx++)
+    {
+        LOCOSTATS_REFRESH   refresh;
+
+        LocoStats::get_refresh (loco_idx, LOCOSTATS_GROUP_SPEED, &refresh);
+        speed_p99[loco_idx] = refresh.p99;
+
+        if (Locos::locos[loco_idx].is_active ())
+        {
+            loco_map.push_back (loco_idx);
+        }
+    }
+
+    std::stable_sort (loco_map.begin(), loco_map.end(),
+                      [&speed_p99](uint16_t a, uint16_t b)
+                      {
+                          uint_fast16_t pa = (speed_p99[a] == LOCOSTATS_NONE) ? 0 : speed_p99[a];
+                          uint_fast16_t pb = (speed_p99[b] == LOCOSTATS_NONE) ? 0 : speed_p99[b];
+                          return pa > pb;
+                      });
+
+    HTTP_Common::html_header (title, title, url, true);
+    HTTP::response += (String) "<div style='margin-left:20px;'>\r\n";
+    HTTP_Common::add_action_handler ("head", "", 200, true);
+
+    HTTP::response += (String)
+        "Intervalle zwischen zwei Paketen an die Lok in msec (p50: Median, p99: 99%-Quantil der letzten " + std::to_string (LOCOSTATS_WINDOW) + " Pakete), "
+        "RC2: Anteil beantworteter Pakete in Prozent, Latenz: Zeit bis zur letzten RailCom-Antwort, "
+        "L&uuml;cke: l&auml;ngste Pause zwischen zwei Paketen auf dem Gleis laut STM32.<BR><BR>\r\n"
+        "<table style='border:1px lightgray solid;'>\r\n"
+        "<tr " + bg + ">"
+        "<th align='right'>ID</th><th>Bezeichnung</th><th>Pakete</th>"
+        "<th>FS p50</th><th>FS p99</th><th>FS max</th>"
+        "<th>F0 p50</th><th>F0 p99</th><th>F0 max</th><th>F5-F28 max</th>"
+        "<th>RC2</th><th>RC2 min</th><th>Latenz</th><th>Latenz max</th><th>L&uuml;cke</th><th>L&uuml;cke max</th>"
+        "</tr>\r\n";
+
+    for (map_idx = 0; map_idx < loco_map.size (); map_idx++)
+    {
+        const LOCOSTATS *   sp;
+        LOCOSTATS_REFRESH   speed;
+        LOCOSTATS_REFRESH   f0;
+        uint32_t            functions_worst = LOCOSTATS_NONE;
+        uint_fast8_t        group;
+
+        loco_idx = loco_map[map_idx];
+        sp = LocoStats::get_stats (loco_idx);
+        LocoStats::get_refresh (loco_idx, LOCOSTATS_GROUP_SPEED, &speed);
+        LocoStats::get_refresh (loco_idx, LOCOSTATS_GROUP_F00_F04, &f0);
+
+        for (group = LOCOSTATS_GROUP_F05_F08; group < LOCOSTATS_GROUPS; group++)
+        {
+            LOCOSTATS_REFRESH   fx;
+
+            LocoStats::get_refresh (loco_idx, group, &fx);
+
+            if (fx.worst_gap != LOCOSTATS_NONE && (functions_worst == LOCOSTATS_NONE || functions_worst < fx.worst_gap))
+            {
+                functions_worst = fx.worst_gap;
+            }
+        }
+
+        if (*bg)
+        {
+            bg = "";
+        }
+        else
+        {
+            bg = "bgcolor='#e0e0e0'";
+        }
+
+        HTTP::response += (String) "<tr " + bg + "><td align='right'>" + std::to_string (loco_idx) + "</td>"
+                          "<td style='width:200px;overflow:hidden' nowrap>" + Locos::locos[loco_idx].get_name () + "</td>";
+        stats_cell (speed.n_packets,    0xFFFFFFFF);
+        stats_cell (speed.p50,          LOCOSTATS_NONE);
+        stats_cell (speed.p99,          LOCOSTATS_NONE);
+        stats_cell (speed.worst_gap,    LOCOSTATS_NONE);
+        stats_cell (f0.p50,             LOCOSTATS_NONE);
+        stats_cell (f0.p99,             LOCOSTATS_NONE);
+        stats_cell (f0.worst_gap,       LOCOSTATS_NONE);
+        stats_cell (functions_worst,    LOCOSTATS_NONE);
+        stats_cell (sp->rc2_rate,       0xFF);
+        stats_cell (sp->rc2_rate_min,   0xFF);
+        stats_cell (sp->rc2_latency,    LOCOSTATS_NONE);
+        stats_cell (sp->rc2_latency_max, sp->n_rc2_reports ? LOCOSTATS_NONE : 0);
+        stats_cell (sp->track_gap,      LOCOSTATS_NONE);
+        stats_cell (sp->track_gap_max,  sp->n_rc2_reports ? LOCOSTATS_NONE : 0);
+        HTTP::response += "</tr>\r\n";
+        HTTP::flush ();
+    }
+
+    HTTP::response += (String) "</table>\r\n</div>\r\n";
+    HTTP_Common::html_trailer ();
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Loco::init (void)
+{
+    HTTP::add_page   ("/",               HTTP_Loco::handle_loco);
+    HTTP::add_page   ("/loco",           HTTP_Loco::handle_loco);
+    HTTP::add_page   ("/lmedit",         HTTP_Loco::handle_loco_macro_edit);
+    HTTP::add_page   ("/locostats",      HTTP_Loco::handle_loco_stats);
+    HTTP::add_action ("locos",           HTTP_Loco::action_locos,          HTTP_ACTION_FLAG_CACHEABLE);
+    HTTP::add_action ("loco",            HTTP_Loco::action_loco,           HTTP_ACTION_FLAG_CACHEABLE);
+    HTTP::add_action ("getf",            HTTP_Loco::action_getf,           HTTP_ACTION_FLAG_CACHEABLE);
+    HTTP::add_action ("macro",           HTTP_Loco::action_macro,          0);
+    HTTP::add_action ("setspeed",        HTTP_Loco::action_setspeed,       0);
+    HTTP::add_action ("togglefunction",  HTTP_Loco::action_togglefunction, 0);
+    HTTP::add_action ("setdestination",  HTTP_Loco::action_setdestination, 0);
+}
@@ -25,8 +25,10 @@
 class HTTP_Loco
 {
     public:
+        static void     init (void);
         static void     handle_loco (void);
         static void     handle_loco_macro_edit (void);
+        static void     handle_loco_stats (void);
         static void     action_locos (void);
         static void     action_loco (void);
         static void     action_getf (void);
@@ -0,0 +1,232 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * http-metrics.cc - HTTP metrics in Prometheus text format
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ * URL:
+ *
+ *   /metrics                   counters, gauges and histograms, see https://prometheus.io/docs/instrumenting/exposition_formats/
+ *
+ * Durations are exported in seconds. Rates, e.g. S88 edges per second, are computed by the server from the counters:
+ *
+ *   rate(fm22_s88_edges_total[1m])
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <string>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "debug.h"
+#include "dcc.h"
+#include "event.h"
+#include "switch.h"
+#include "metrics.h"
+#include "http.h"
+#include "http-metrics.h"
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * print_header () - print HELP and TYPE of a metric
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+print_header (const char * name, const char * type, const char * help)
+{
+    HTTP::response += (String) "# HELP " + name + " " + help + "\n";
+    HTTP::response += (String) "# TYPE " + name + " " + type + "\n";
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * print_value () - print metric without labels
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+print_value (const char * name, const char * type, const char * help, uint32_t value)
+{
+    print_header (name, type, help);
+    HTTP::response += (String) name + " ";
+    HTTP::response.append_num (value);
+    HTTP::response += "\n";
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * print_seconds () - print duration in usec as seconds
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+print_seconds (uint64_t usec)
+{
+    char    buf[32];
+
+    snprintf (buf, sizeof (buf), "%llu.%06u", (unsigned long long) (usec / 1000000), (unsigned int) (usec % 1000000));
+    HTTP::response += buf;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * print_histogram () - print histogram with cumulative buckets
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+print_histogram (const char * name, const char * help, uint_fast8_t hist)
+{
+    METRICS_HISTOGRAM_VALUES    values;
+    uint32_t                    cumulative = 0;
+    uint_fast8_t                bucket;
+
+    Metrics::get_histogram (hist, &values);
+    print_header (name, "histogram", help);
+
+    for (bucket = 0; bucket < METRICS_HIST_BUCKETS; bucket++)
+    {
+        cumulative += values.buckets[bucket];
+        HTTP::response += (String) name + "_bucket{le=\"";
+
+        if (bucket < METRICS_HIST_BUCKETS - 1)
+        {
+            print_seconds (1ULL << bucket);
+        }
+        else
+        {
+            HTTP::response += "+Inf";
+        }
+
+        HTTP::response += "\"} ";
+        HTTP::response.append_num (cumulative);
+        HTTP::response += "\n";
+    }
+
+    HTTP::response += (String) name + "_sum ";
+    print_seconds (values.sum);
+    HTTP::response += (String) "\n" + name + "_count ";
+    HTTP::response.append_num (values.count);
+    HTTP::response += "\n";
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * handle_metrics () - all metrics in Prometheus text format
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Metrics::handle_metrics (void)
+{
+    EVENT_STATS         event_stats;
+    DEBUG_TRACE_STATS   trace_stats;
+    uint_fast16_t       idx;
+
+    print_histogram ("fm22_loop_duration_seconds", "Duration of main loop passes.", METRICS_HIST_LOOP_TIME);
+    print_histogram ("fm22_loop_jitter_seconds", "Deviation of main loop period from nominal period.", METRICS_HIST_LOOP_JITTER);
+
+    print_header ("fm22_dcc_commands_total", "counter", "DCC commands sent to STM32 by type.");
+
+    for (idx = 0; idx < METRICS_DCC_COMMANDS; idx++)
+    {
+        uint32_t        n = Metrics::get_dcc_commands (idx);
+        const char *    cmd_name;
+
+        if (n > 0)
+        {
+            cmd_name = DCC::get_cmd_name (idx);
+
+            if (cmd_name)
+            {
+                HTTP::response += (String) "fm22_dcc_commands_total{cmd=\"" + cmd_name + "\"} ";
+            }
+            else
+            {
+                HTTP::response += "fm22_dcc_commands_total{cmd=\"";
+                HTTP::response.append_num (idx);
+                HTTP::response += "\"} ";
+            }
+
+            HTTP::response.append_num (n);
+            HTTP::response += "\n";
+        }
+    }
+
+    print_histogram ("fm22_dcc_stop_wait_seconds", "Wait time for CONTINUE after STOP of STM32.", METRICS_HIST_DCC_STOP_WAIT);
+    print_value ("fm22_dcc_stop_timeouts_total", "counter", "Missing CONTINUE after STOP of STM32.", Metrics::get_counter (METRICS_COUNTER_DCC_STOP_TIMEOUTS));
+
+    print_value ("fm22_uart_rx_bytes_total", "counter", "Bytes received from STM32.", Metrics::get_counter (METRICS_COUNTER_UART_RX_BYTES));
+    print_value ("fm22_uart_tx_bytes_total", "counter", "Bytes sent to STM32.", Metrics::get_counter (METRICS_COUNTER_UART_TX_BYTES));
+    print_value ("fm22_msg_frames_total", "counter", "Frames received from STM32.", Metrics::get_counter (METRICS_COUNTER_MSG_FRAMES));
+    print_value ("fm22_msg_errors_total", "counter", "Framing errors and invalid messages from STM32.", Metrics::get_counter (METRICS_COUNTER_MSG_ERRORS));
+
+    print_histogram ("fm22_pom_read_duration_seconds", "Duration of POM reads including retries.", METRICS_HIST_POM_READ);
+    print_value ("fm22_pom_reads_total", "counter", "POM reads.", Metrics::get_counter (METRICS_COUNTER_POM_READS));
+    print_value ("fm22_pom_read_retries_total", "counter", "POM read retries.", Metrics::get_counter (METRICS_COUNTER_POM_RETRIES));
+    print_value ("fm22_pom_read_failures_total", "counter", "POM reads failed after all retries.", Metrics::get_counter (METRICS_COUNTER_POM_FAILURES));
+    print_histogram ("fm22_pgm_read_duration_seconds", "Duration of PGM reads.", METRICS_HIST_PGM_READ);
+    print_value ("fm22_pgm_reads_total", "counter", "PGM reads.", Metrics::get_counter (METRICS_COUNTER_PGM_READS));
+    print_value ("fm22_pgm_read_failures_total", "counter", "PGM reads without answer.", Metrics::get_counter (METRICS_COUNTER_PGM_FAILURES));
+
+    print_histogram ("fm22_http_action_duration_seconds", "Duration of HTTP actions.", METRICS_HIST_HTTP_ACTION);
+    print_header ("fm22_http_action_requests_total", "counter", "HTTP action requests by action.");
+
+    for (idx = 0; idx < Metrics::get_n_http_actions (); idx++)
+    {
+        uint32_t        n;
+        uint64_t        sum;
+        const char *    action = Metrics::get_http_action (idx, &n, &sum);
+
+        if (n > 0)
+        {
+            HTTP::response += (String) "fm22_http_action_requests_total{action=\"" + action + "\"} ";
+            HTTP::response.append_num (n);
+            HTTP::response += "\n";
+        }
+    }
+
+    print_header ("fm22_http_action_seconds_total", "counter", "Time spent in HTTP actions by action.");
+
+    for (idx = 0; idx < Metrics::get_n_http_actions (); idx++)
+    {
+        uint32_t        n;
+        uint64_t        sum;
+        const char *    action = Metrics::get_http_action (idx, &n, &sum);
+
+        if (n > 0)
+        {
+            HTTP::response += (String) "fm22_http_action_seconds_total{action=\"" + action + "\"} ";
+            print_seconds (sum);
+            HTTP::response += "\n";
+        }
+    }
+
+    Event::get_stats (&event_stats);
+    print_value ("fm22_event_queue_depth", "gauge", "Pending events.", event_stats.n_pending);
+    print_value ("fm22_event_queue_depth_max", "gauge", "Max. number of pending events.", event_stats.max_pending);
+    print_value ("fm22_events_fired_total", "counter", "Executed events.", event_stats.n_fired);
+    print_value ("fm22_events_dropped_total", "counter", "Events dropped because the queue was full.", event_stats.n_dropped);
+
+    print_value ("fm22_s88_edges_total", "counter", "S88 contacts getting occupied or free.", Metrics::get_counter (METRICS_COUNTER_S88_EDGES));
+    print_value ("fm22_rcl_edges_total", "counter", "RailCom locations entered or left.", Metrics::get_counter (METRICS_COUNTER_RCL_EDGES));
+    print_value ("fm22_switches_busy", "gauge", "Switch machines currently powered.", Switches::get_n_busy ());
+
+    Debug::get_trace_stats (&trace_stats);
+    print_value ("fm22_trace_records_total", "counter", "Recorded trace messages.", trace_stats.n_records);
+    print_value ("fm22_trace_dropped_total", "counter", "Trace messages dropped because the ring buffer was full.", trace_stats.n_dropped);
+
+    HTTP::flush ();
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Metrics::init (void)
+{
+    HTTP::add_page ("/metrics",             HTTP_Metrics::handle_metrics,   "text/plain; version=0.0.4", HTTP_PAGE_FLAG_READONLY);
+}
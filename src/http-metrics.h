@@ -0,0 +1,30 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * http-metrics.h - HTTP metrics in Prometheus text format
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef HTTP_METRICS_H
+#define HTTP_METRICS_H
+
+class HTTP_Metrics
+{
+    public:
+        static void     init (void);
+        static void     handle_metrics (void);
+};
+
+#endif
@@ -452,3 +452,15 @@ HTTP_PGM::handle_pgmcv (void)
         "</div>\r\n";
     HTTP_Common::html_trailer ();
 }
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_PGM::init (void)
+{
+    HTTP::add_page   ("/pgminfo",  HTTP_PGM::handle_pgminfo);
+    HTTP::add_page   ("/pgmaddr",  HTTP_PGM::handle_pgmaddr);
+    HTTP::add_page   ("/pgmcv",    HTTP_PGM::handle_pgmcv);
+}
@@ -25,6 +25,7 @@
 class HTTP_PGM
 {
     public:
+        static void     init (void);
         static void     handle_pgminfo (void);
         static void     handle_pgmaddr (void);
         static void     handle_pgmcv (void);
@@ -902,3 +902,15 @@ HTTP_POM::handle_pomcv (void)
         "</div>\r\n";
     HTTP_Common::html_trailer ();
 }
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_POM::init (void)
+{
+    HTTP::add_page   ("/pominfo",  HTTP_POM::handle_pominfo);
+    HTTP::add_page   ("/pomaddr",  HTTP_POM::handle_pomaddr);
+    HTTP::add_page   ("/pomcv",    HTTP_POM::handle_pomcv);
+}
@@ -25,6 +25,7 @@
 class HTTP_POM
 {
     public:
+        static void     init (void);
         static void     handle_pominfo (void);
         static void     handle_pomaddr (void);
         static void     handle_pomcv (void);
@@ -1837,3 +1837,22 @@ HTTP_POMMAP::action_savemaptams (void)
         HTTP::response = std::to_string (tams_mapping_changes);
     }
 }
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_POMMAP::init (void)
+{
+    HTTP::add_page   ("/pommap",           HTTP_POMMAP::handle_pommap);
+    HTTP::add_action ("setcondmapesu",     HTTP_POMMAP::action_setcondmapesu,    0);
+    HTTP::add_action ("setoutputmapesu",   HTTP_POMMAP::action_setoutputmapesu,  0);
+    HTTP::add_action ("setoutputmaplenz",  HTTP_POMMAP::action_setoutputmaplenz, 0);
+    HTTP::add_action ("setoutputmapzimo",  HTTP_POMMAP::action_setoutputmapzimo, 0);
+    HTTP::add_action ("setoutputmaptams",  HTTP_POMMAP::action_setoutputmaptams, 0);
+    HTTP::add_action ("savemapesu",        HTTP_POMMAP::action_savemapesu,       0);
+    HTTP::add_action ("savemaplenz",       HTTP_POMMAP::action_savemaplenz,      0);
+    HTTP::add_action ("savemapzimo",       HTTP_POMMAP::action_savemapzimo,      0);
+    HTTP::add_action ("savemaptams",       HTTP_POMMAP::action_savemaptams,      0);
+}
@@ -25,6 +25,7 @@
 class HTTP_POMMAP
 {
     public:
+        static void     init (void);
         static void     handle_pommap (void);
         static void     action_setcondmapesu (void);
         static void     action_setoutputmapesu (void);
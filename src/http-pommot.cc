@@ -477,3 +477,13 @@ HTTP_POMMOT::handle_pommot (void)
     HTTP::response += (String) "</div>\r\n";
     HTTP_Common::html_trailer ();
 }
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_POMMOT::init (void)
+{
+    HTTP::add_page   ("/pommot",  HTTP_POMMOT::handle_pommot);
+}
@@ -25,6 +25,7 @@
 class HTTP_POMMOT
 {
     public:
+        static void     init (void);
         static void     handle_pommot (void);
     private:
 };
@@ -639,3 +639,15 @@ HTTP_POMOUT::action_saveoutputesu (void)
 
     HTTP::response = std::to_string (esu_output_changes);
 }
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_POMOUT::init (void)
+{
+    HTTP::add_page   ("/pomout",        HTTP_POMOUT::handle_pomout);
+    HTTP::add_action ("setoutputesu",   HTTP_POMOUT::action_setoutputesu,  0);
+    HTTP::add_action ("saveoutputesu",  HTTP_POMOUT::action_saveoutputesu, 0);
+}
@@ -25,6 +25,7 @@
 class HTTP_POMOUT
 {
     public:
+        static void     init (void);
         static void     handle_pomout (void);
         static void     action_setoutputesu (void);
         static void     action_saveoutputesu (void);
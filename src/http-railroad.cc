@@ -31,6 +31,8 @@
 #include "loco.h"
 #include "switch.h"
 #include "railroad.h"
+#include "interlock.h"
+#include "s88.h"
 #include "func.h"
 #include "base.h"
 #include "http.h"
@@ -155,12 +157,10 @@ HTTP_Railroad::handle_rr (void)
     {
         const char *    sname   = HTTP::parameter ("name");
         uint_fast8_t    rrgidx  = HTTP::parameter_number ("rrgidx");
-        uint_fast8_t    nrrgidx = HTTP::parameter_number ("nrrgidx");
+        uint_fast8_t    npos    = HTTP::parameter_number ("npos");
+        uint_fast8_t    nrrgidx;
 
-        if (rrgidx != nrrgidx)
-        {
-            nrrgidx = RailroadGroups::set_new_id (rrgidx, nrrgidx);
-        }
+        nrrgidx = RailroadGroups::set_position (rrgidx, npos);          // group keeps its index, only display order changes
 
         if (nrrgidx != 0xFF)
         {
@@ -189,7 +189,7 @@ HTTP_Railroad::handle_rr (void)
         const char *    sname           = HTTP::parameter ("name");
         uint_fast16_t   rrgidx          = HTTP::parameter_number ("rrgidx");
         uint_fast16_t   rridx           = HTTP::parameter_number ("rridx");
-        uint_fast16_t   nrridx          = HTTP::parameter_number ("nrridx");
+        uint_fast16_t   npos            = HTTP::parameter_number ("npos");
         uint_fast16_t   ll              = HTTP::parameter_number ("ll");
         Railroad *      rr              = &RailroadGroups::railroad_groups[rrgidx].railroads[rridx];
         uint_fast8_t    n_rr_switches   = rr->get_n_switches ();
@@ -197,12 +197,9 @@ HTTP_Railroad::handle_rr (void)
         Railroad *      nrr;
         uint_fast8_t    sub_idx;
 
-        if (rridx != nrridx)
-        {
-            nrridx = RailroadGroups::railroad_groups[rrgidx].set_new_id(rridx, nrridx);
-        }
+        RailroadGroups::railroad_groups[rrgidx].set_position (rridx, npos);    // railroad keeps its index, only display order changes
 
-        nrr = &RailroadGroups::railroad_groups[rrgidx].railroads[nrridx];
+        nrr = &RailroadGroups::railroad_groups[rrgidx].railroads[rridx];
 
         nrr->set_name (sname);
         nrr->set_link_loco (ll);
@@ -289,6 +286,8 @@ HTTP_Railroad::handle_rr (void)
 
     uint_fast8_t    rrgidx   = 0;
     uint_fast8_t    rridx    = 0;
+    uint_fast8_t    pos;
+    uint_fast8_t    rrpos;
     const char *    bg;
 
     HTTP::response += (String)
@@ -297,11 +296,13 @@ HTTP_Railroad::handle_rr (void)
         "http.addEventListener('load',"
         "function(event) { var text = http.responseText; if (http.status >= 200 && http.status < 300) { if (text !== '') alert (text); }});"
         "http.send (null);}\r\n"
-        "function changerrg(rrgidx, name)\r\n"
+        "function rrrelease(rrgidx, rridx) { var http = new XMLHttpRequest(); http.open ('GET', '/action?action=rrrelease&rrgidx=' + rrgidx + '&rridx=' + rridx);"
+        "http.send (null);}\r\n"
+        "function changerrg(rrgidx, pos, name)\r\n"
         "{\r\n"
         "  document.getElementById('action').value = 'changerrg';\r\n"
         "  document.getElementById('rrgidx').value = rrgidx;\r\n"
-        "  document.getElementById('nrrgidx').value = rrgidx;\r\n"
+        "  document.getElementById('npos').value = pos;\r\n"
         "  document.getElementById('name').value = name;\r\n"
         "  document.getElementById('newid').style.display='';\r\n"
         "  document.getElementById('formrrg').style.display='';\r\n"
@@ -325,8 +326,10 @@ HTTP_Railroad::handle_rr (void)
 
     uint_fast8_t    n_railroad_groups = RailroadGroups::get_n_railroad_groups ();
 
-    for (rrgidx = 0; rrgidx < n_railroad_groups; rrgidx++)
+    for (pos = 0; pos < n_railroad_groups; pos++)
     {
+        rrgidx = RailroadGroups::get_railroad_group_idx (pos);
+
         std::string rrg_name = RailroadGroups::railroad_groups[rrgidx].get_name();
 
         HTTP::response += (String)
@@ -339,7 +342,7 @@ HTTP_Railroad::handle_rr (void)
 
         if (HTTP_Common::edit_mode)
         {
-            HTTP::response += (String) "<th><button onclick=\"changerrg(" + std::to_string(rrgidx) + ",'" + String (rrg_name) + "')\">Bearbeiten</th>";
+            HTTP::response += (String) "<th><button onclick=\"changerrg(" + std::to_string(rrgidx) + "," + std::to_string(pos) + ",'" + String (rrg_name) + "')\">Bearbeiten</th>";
             HTTP::response += (String) "<th><button onclick=\"window.location.href='" + url + "?action=delrrg&rrgidx=" + std::to_string(rrgidx) + "'; \">L&ouml;schen</button></th>";
         }
 
@@ -347,8 +350,10 @@ HTTP_Railroad::handle_rr (void)
 
         uint_fast8_t    n_railroads             = RailroadGroups::railroad_groups[rrgidx].get_n_railroads();
 
-        for (rridx = 0; rridx < n_railroads; rridx++)
+        for (rrpos = 0; rrpos < n_railroads; rrpos++)
         {
+            rridx = RailroadGroups::railroad_groups[rrgidx].get_railroad_idx (rrpos);
+
             Railroad *      rr                  = &RailroadGroups::railroad_groups[rrgidx].railroads[rridx];
             uint_fast16_t   linked_loco_idx     = rr->get_link_loco();
             uint_fast16_t   located_loco_idx    = rr->get_located_loco();
@@ -385,7 +390,7 @@ HTTP_Railroad::handle_rr (void)
                 active_loco_name = "";
             }
 
-            if (rridx % 2)
+            if (rrpos % 2)
             {
                 bg = "bgcolor='#e0e0e0'";
             }
@@ -399,7 +404,9 @@ HTTP_Railroad::handle_rr (void)
                         + "<td style='width:170px;overflow:hidden' nowrap><a href='/loco?action=loco&lidx=" + std::to_string(linked_loco_idx) + "'>" + linked_loco_name + "</a></td>"
                         + "<td class='hide650' id='act_" + std::to_string(rrgidx) + "_" + std::to_string(rridx) + "' style='width:170px;overflow:hidden' nowrap><a href='/loco?action=loco&lidx=" + std::to_string(active_loco_idx) + "'>" + active_loco_name + "</a></td>"
                         + "<td class='hide650' id='loc_" + std::to_string(rrgidx) + "_" + std::to_string(rridx) + "' style='width:170px;overflow:hidden' nowrap><a href='/loco?action=loco&lidx=" + std::to_string(located_loco_idx) + "'>" + located_loco_name + "</a></td>"
-                        + "<td><button onclick=rrset(" + std::to_string(rrgidx) + "," + std::to_string(rridx) + ")>Setzen</button></td>";
+                        + "<td nowrap><button onclick=rrset(" + std::to_string(rrgidx) + "," + std::to_string(rridx) + ")>Setzen</button>"
+                        + " <button id='rel_" + std::to_string(rrgidx) + "_" + std::to_string(rridx) + "' style='display:" + (Interlocking::is_locked (rrgidx, rridx) ? "" : "none") + "'"
+                        + " onclick=rrrelease(" + std::to_string(rrgidx) + "," + std::to_string(rridx) + ")>Freigeben</button></td>";
 
             if (HTTP_Common::edit_mode)
             {
@@ -440,7 +447,7 @@ HTTP_Railroad::handle_rr (void)
             "<table>\r\n"
             "<tr id='newid'>\r\n";
 
-        HTTP_Common::print_id_select_list ("nrrgidx", n_railroad_groups);
+        HTTP_Common::print_position_select_list ("npos", n_railroad_groups);
 
         HTTP::response += (String)
             "</tr>\r\n"
@@ -494,7 +501,9 @@ HTTP_Railroad::handle_rr_edit (void)
     HTTP::response += (String) "<form method='get' action='" + url + "'>"
                 + "<table style='border:1px lightgray solid;'>\r\n";
 
-    HTTP_Common::print_id_select_list ("nrridx", n_railroads, rridx);
+    HTTP::response += (String) "<tr>";
+    HTTP_Common::print_position_select_list ("npos", n_railroads, rrg->get_position (rridx));
+    HTTP::response += (String) "</tr>\r\n";
 
     HTTP::response += (String) "<tr bgcolor='#e0e0e0'><td>Name:</td><td><input type='text' style='width:200px' name='name' value='"
                 + rr_name + "'></td></tr>\r\n";
@@ -627,6 +636,9 @@ HTTP_Railroad::action_rr (void)
 
             id = (String) "loc_" + std::to_string(rrgidx) + "_" + std::to_string(rridx);
             HTTP_Common::add_action_content (id, "text", located_loco_name);
+
+            id = (String) "rel_" + std::to_string(rrgidx) + "_" + std::to_string(rridx);
+            HTTP_Common::add_action_content (id, "display", Interlocking::is_locked (rrgidx, rridx) ? "" : "none");
         }
     }
 }
@@ -637,5 +649,49 @@ HTTP_Railroad::action_rrset (void)
     uint_fast16_t   rrgidx      = HTTP::parameter_number ("rrgidx");
     uint_fast16_t   rridx       = HTTP::parameter_number ("rridx");
 
-    RailroadGroups::railroad_groups[rrgidx].set_active_railroad(rridx);
+    if (! RailroadGroups::railroad_groups[rrgidx].set_active_railroad(rridx))                   // checks occupancy and conflicts
+    {
+        Railroad *  rr = &RailroadGroups::railroad_groups[rrgidx].railroads[rridx];
+
+        if (rr->get_located_loco () != 0xFFFF || S88::is_railroad_occupied (rrgidx, rridx))
+        {
+            HTTP::response = (String) "Fahrstraße abgelehnt: das Gleis ist besetzt.";
+        }
+        else
+        {
+            HTTP::response = (String) "Fahrstraße abgelehnt: eine kreuzende Fahrstraße ist durch einen Zug gesperrt.";
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * action_rrrelease () - release lock of railroad manually, e.g. if the contact of the target railroad did not trigger
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Railroad::action_rrrelease (void)
+{
+    uint_fast16_t   rrgidx      = HTTP::parameter_number ("rrgidx");
+    uint_fast16_t   rridx       = HTTP::parameter_number ("rridx");
+
+    if (rrgidx < RailroadGroups::get_n_railroad_groups () && rridx < RailroadGroups::railroad_groups[rrgidx].get_n_railroads ())
+    {
+        RailroadGroups::railroad_groups[rrgidx].railroads[rridx].set_active_loco (0xFFFF);    // else Interlocking::build () locks it again
+        Interlocking::release (rrgidx, rridx);
+        Debug::printf (DEBUG_LEVEL_NORMAL, "railroad %u/%u released manually\n", (unsigned int) rrgidx, (unsigned int) rridx);
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Railroad::init (void)
+{
+    HTTP::add_page   ("/rr",        HTTP_Railroad::handle_rr);
+    HTTP::add_page   ("/rredit",    HTTP_Railroad::handle_rr_edit);
+    HTTP::add_action ("rr",         HTTP_Railroad::action_rr,           HTTP_ACTION_FLAG_CACHEABLE);
+    HTTP::add_action ("rrset",      HTTP_Railroad::action_rrset,        0);
+    HTTP::add_action ("rrrelease",  HTTP_Railroad::action_rrrelease,    0);
 }
@@ -25,10 +25,12 @@
 class HTTP_Railroad
 {
     public:
+        static void     init (void);
         static void     handle_rr (void);
         static void     handle_rr_edit (void);
         static void     action_rr (void);
         static void     action_rrset (void);
+        static void     action_rrrelease (void);
     private:
 };
 
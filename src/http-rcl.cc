@@ -503,6 +503,11 @@ HTTP_RCL::handle_rcl_edit (void)
                 + "<table style='border:1px lightgray solid;'>\r\n"
                 + "<tr bgcolor='#e0e0e0'><td>ID:</td><td>" + std::to_string(trackidx) + "</td></tr>\r\n"
                 + "<tr><td>Name:</td><td><input type='text' style='width:200px' name='name' value='" + rcl_name + "'></td></tr>\r\n"
+                + "<tr>";
+
+    HTTP_Common::print_position_select_list ("npos", RCL::get_n_tracks (), RCL::get_position (trackidx));
+
+    HTTP::response += (String) "</tr>\r\n"
                 + "<tr><td>Blocksicherung:</td><td><select name='block'><option value='0' " + no_selected + ">Nein</option><option value='1' " + yes_selected + ">Ja</option></select></td></tr>\r\n";
 
     HTTP::flush ();
@@ -815,6 +820,11 @@ HTTP_RCL::handle_rcl (void)
 
         change_rcl_actions (trackidx, true);
         change_rcl_actions (trackidx, false);
+
+        if (*HTTP::parameter ("npos"))
+        {
+            RCL::set_position (trackidx, HTTP::parameter_number ("npos"));    // keeps its index and location id, only display order changes
+        }
     }
 
     const char *  bg;
@@ -835,14 +845,17 @@ HTTP_RCL::handle_rcl (void)
     HTTP::flush ();
 
     uint_fast16_t   n_tracks    = RCL::get_n_tracks ();
+    uint_fast16_t   pos;
 
-    for (trackidx = 0; trackidx < n_tracks; trackidx++)
+    for (pos = 0; pos < n_tracks; pos++)
     {
+        trackidx = RCL::get_track_idx (pos);
+
         String          strackidx = std::to_string(trackidx);
         std::string     loconame;
         uint_fast16_t   loco_idx;
 
-        if (trackidx % 2)
+        if (pos % 2)
         {
             bg = "bgcolor='#e0e0e0'";
         }
@@ -952,3 +965,15 @@ HTTP_RCL::action_rcl (void)
         HTTP_Common::add_action_content ( (String) "loc" + std::to_string(trackidx), "text", loconame);
     }
 }
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_RCL::init (void)
+{
+    HTTP::add_page   ("/rcl",      HTTP_RCL::handle_rcl);
+    HTTP::add_page   ("/rcledit",  HTTP_RCL::handle_rcl_edit);
+    HTTP::add_action ("rcl",       HTTP_RCL::action_rcl, HTTP_ACTION_FLAG_CACHEABLE);
+}
@@ -25,6 +25,7 @@
 class HTTP_RCL
 {
     public:
+        static void     init (void);
         static void     handle_rcl_edit (void);
         static void     handle_rcl (void);
         static void     action_rcl (void);
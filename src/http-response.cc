@@ -0,0 +1,228 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * http-response.cc - HTTP response buffer
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "http.h"
+#include "debug.h"
+#include "http-response.h"
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * HTTP_Response () - constructor
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+HTTP_Response::HTTP_Response ()
+{
+    this->autoflush         = true;
+    this->n_used_chunks     = 0;
+    this->last_chunk_len    = 0;
+    this->total_len         = 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * ~HTTP_Response () - destructor
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+HTTP_Response::~HTTP_Response ()
+{
+    size_t  idx;
+
+    for (idx = 0; idx < this->chunks.size(); idx++)
+    {
+        free (this->chunks[idx]);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * append () - append data
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Response::append (const char * s, size_t len)
+{
+    while (len > 0)
+    {
+        size_t  n;
+
+        if (this->n_used_chunks == 0 || this->last_chunk_len == HTTP_RESPONSE_CHUNK_SIZE)
+        {
+            if (this->n_used_chunks == this->chunks.size())
+            {
+                char * chunk = (char *) malloc (HTTP_RESPONSE_CHUNK_SIZE);
+
+                if (! chunk)
+                {
+                    Debug::printf (DEBUG_LEVEL_NONE, "HTTP_Response::append: out of memory\n");
+                    return;
+                }
+
+                this->chunks.push_back (chunk);
+            }
+
+            this->n_used_chunks++;
+            this->last_chunk_len = 0;
+        }
+
+        n = HTTP_RESPONSE_CHUNK_SIZE - this->last_chunk_len;
+
+        if (n > len)
+        {
+            n = len;
+        }
+
+        memcpy (this->chunks[this->n_used_chunks - 1] + this->last_chunk_len, s, n);
+        this->last_chunk_len    += n;
+        this->total_len         += n;
+        s                       += n;
+        len                     -= n;
+    }
+
+    if (this->autoflush && this->total_len >= HTTP_RESPONSE_AUTOFLUSH_SIZE)
+    {
+        HTTP::flush ();
+    }
+}
+
+void
+HTTP_Response::append (const char * s)
+{
+    this->append (s, strlen (s));
+}
+
+void
+HTTP_Response::append (const std::string& s)
+{
+    this->append (s.data(), s.length());
+}
+
+void
+HTTP_Response::append (char ch)
+{
+    this->append (&ch, 1);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * append_num () - append unsigned decimal number without temporary strings
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Response::append_num (uint32_t value)
+{
+    char    buf[10];
+    int     idx = sizeof (buf);
+
+    do
+    {
+        buf[--idx] = '0' + (value % 10);
+        value /= 10;
+    } while (value);
+
+    this->append (buf + idx, sizeof (buf) - idx);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * append_int () - append signed decimal number without temporary strings
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Response::append_int (int32_t value)
+{
+    if (value < 0)
+    {
+        this->append ('-');
+        this->append_num ((uint32_t) (-(int64_t) value));
+    }
+    else
+    {
+        this->append_num ((uint32_t) value);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * clear () - clear content, chunks are kept for next use
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Response::clear (void)
+{
+    this->n_used_chunks     = 0;
+    this->last_chunk_len    = 0;
+    this->total_len         = 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * length () - get length of content
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+size_t
+HTTP_Response::length (void)
+{
+    return this->total_len;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * empty () - check if content is empty
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+HTTP_Response::empty (void)
+{
+    return this->total_len == 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * str () - get copy of content as string
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+std::string
+HTTP_Response::str (void)
+{
+    std::string     s;
+    size_t          idx;
+
+    s.reserve (this->total_len);
+
+    for (idx = 0; idx < this->n_used_chunks; idx++)
+    {
+        size_t len = (idx == this->n_used_chunks - 1) ? this->last_chunk_len : HTTP_RESPONSE_CHUNK_SIZE;
+        s.append (this->chunks[idx], len);
+    }
+
+    return s;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_iovec () - fill iovec array with used chunks for writev(), returns number of entries
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+int
+HTTP_Response::get_iovec (struct iovec * iov, int max_iov)
+{
+    int     idx;
+
+    for (idx = 0; idx < (int) this->n_used_chunks && idx < max_iov; idx++)
+    {
+        iov[idx].iov_base   = this->chunks[idx];
+        iov[idx].iov_len    = (idx == (int) this->n_used_chunks - 1) ? this->last_chunk_len : HTTP_RESPONSE_CHUNK_SIZE;
+    }
+
+    return idx;
+}
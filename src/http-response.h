@@ -0,0 +1,75 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * http-response.h - HTTP response buffer
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef HTTP_RESPONSE_H
+#define HTTP_RESPONSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <sys/uio.h>
+
+#define HTTP_RESPONSE_CHUNK_SIZE        16384                               // size of one arena chunk
+#define HTTP_RESPONSE_AUTOFLUSH_SIZE    65536                               // flush huge pages progressively
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * HTTP_Response - response buffer, appends into a list of reusable chunks. The chunks are never freed, so after the
+ * first requests no more allocations are necessary. The operators += and = keep the handlers source compatible to
+ * the former std::string HTTP::response.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+class HTTP_Response
+{
+    public:
+        bool                    autoflush;                                  // call HTTP::flush() if buffer gets too large
+
+                                HTTP_Response ();
+                                ~HTTP_Response ();
+
+        void                    append (const char * s, size_t len);
+        void                    append (const char * s);
+        void                    append (const std::string& s);
+        void                    append (char ch);
+        void                    append_num (uint32_t value);
+        void                    append_int (int32_t value);
+
+        void                    clear (void);
+        size_t                  length (void);
+        bool                    empty (void);
+        std::string             str (void);
+        int                     get_iovec (struct iovec * iov, int max_iov);
+
+        HTTP_Response&          operator+= (const std::string& s)       { append (s); return *this; }
+        HTTP_Response&          operator+= (const char * s)             { append (s); return *this; }
+        HTTP_Response&          operator+= (char ch)                    { append (ch); return *this; }
+        HTTP_Response&          operator= (const std::string& s)        { clear (); append (s); return *this; }
+        HTTP_Response&          operator= (const char * s)              { clear (); append (s); return *this; }
+
+    private:
+        std::vector<char *>     chunks;                                     // allocated chunks
+        size_t                  n_used_chunks;                              // number of chunks in use
+        size_t                  last_chunk_len;                             // used bytes in last chunk in use
+        size_t                  total_len;                                  // total length of content
+
+                                HTTP_Response (const HTTP_Response&);
+        HTTP_Response&          operator= (const HTTP_Response&);
+};
+
+#endif
@@ -578,8 +578,11 @@ HTTP_S88::handle_s88_edit (void)
     HTTP::response += (String) "<form method='get' action='" + url + "'>"
                 + "<table style='border:1px lightgray solid;'>\r\n"
                 + "<tr bgcolor='#e0e0e0'><td>ID:</td><td>" + std::to_string(coidx) + "</td></tr>\r\n"
-                + "<tr><td>Name:</td><td><input type='text' style='width:200px' name='name' value='" + s88_name + "'></td></tr>\r\n";
+                + "<tr><td>Name:</td><td><input type='text' style='width:200px' name='name' value='" + s88_name + "'></td></tr>\r\n"
+                + "<tr>";
 
+    HTTP_Common::print_position_select_list ("npos", S88::get_n_contacts (), S88::get_position (coidx));
+    HTTP::response += (String) "</tr>\r\n";
     HTTP::flush ();
 
     HTTP::response += (String) "<tr><td>Gleis:</td><td>\r\n";
@@ -871,6 +874,11 @@ HTTP_S88::handle_s88 (void)
 
         change_s88_actions (coidx, true);
         change_s88_actions (coidx, false);
+
+        if (*HTTP::parameter ("npos"))
+        {
+            S88::set_position (coidx, HTTP::parameter_number ("npos"));       // keeps its index and S88 bit, only display order changes
+        }
     }
 
     HTTP_Common::add_action_handler ("s88", "", 200, true);
@@ -891,10 +899,13 @@ HTTP_S88::handle_s88 (void)
     HTTP::flush ();
 
     uint_fast16_t   n_contacts = S88::get_n_contacts ();
+    uint_fast16_t   pos;
 
-    for (coidx = 0; coidx < n_contacts; coidx++)
+    for (pos = 0; pos < n_contacts; pos++)
     {
-        if (coidx % 2)
+        coidx = S88::get_contact_idx (pos);
+
+        if (pos % 2)
         {
             bg = "bgcolor='#e0e0e0'";
         }
@@ -990,3 +1001,15 @@ HTTP_S88::action_s88 (void)
         }
     }
 }
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_S88::init (void)
+{
+    HTTP::add_page   ("/s88",      HTTP_S88::handle_s88);
+    HTTP::add_page   ("/s88edit",  HTTP_S88::handle_s88_edit);
+    HTTP::add_action ("s88",       HTTP_S88::action_s88, HTTP_ACTION_FLAG_CACHEABLE);
+}
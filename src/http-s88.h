@@ -25,6 +25,7 @@
 class HTTP_S88
 {
     public:
+        static void     init (void);
         static void     handle_s88_edit (void);
         static void     handle_s88 (void);
         static void     action_s88 (void);
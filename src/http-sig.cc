@@ -46,6 +46,7 @@ HTTP_Signal::handle_sig (void)
     String          url       = "/sig";
     const char *    action    = HTTP::parameter ("action");
     uint_fast16_t   sigidx  = 0;
+    uint_fast16_t   pos;
 
     HTTP_Common::html_header (title, title, url, true);
     HTTP::response += (String) "<div style='margin-left:20px;'>\r\n";
@@ -83,13 +84,11 @@ HTTP_Signal::handle_sig (void)
     {
         const char *    sname   = HTTP::parameter ("name");
         uint_fast16_t   sigidx  = HTTP::parameter_number ("sigidx");
-        uint_fast16_t   nsigidx = HTTP::parameter_number ("nsigidx");
+        uint_fast16_t   npos    = HTTP::parameter_number ("npos");
         uint_fast16_t   addr    = HTTP::parameter_number ("addr");
+        uint_fast16_t   nsigidx;
 
-        if (sigidx != nsigidx)
-        {
-            nsigidx = Signals::set_new_id (sigidx, nsigidx);
-        }
+        nsigidx = Signals::set_position (sigidx, npos);                 // signal keeps its index, only display order changes
 
         if (nsigidx != 0xFFFF)
         {
@@ -151,8 +150,10 @@ HTTP_Signal::handle_sig (void)
 
     uint_fast16_t n_signals = Signals::get_n_signals ();
 
-    for (sigidx = 0; sigidx < n_signals; sigidx++)
+    for (pos = 0; pos < n_signals; pos++)
     {
+        sigidx = Signals::get_signal_idx (pos);
+
         if (*bg)
         {
             bg = "";
@@ -200,7 +201,7 @@ HTTP_Signal::handle_sig (void)
         if (HTTP_Common::edit_mode)
         {
             HTTP::response += (String) "<td><button onclick=\"changesig("
-                  + ssigidx + ",'" + name + "'," + std::to_string(addr)
+                  + ssigidx + "," + std::to_string(pos) + ",'" + name + "'," + std::to_string(addr)
                   + ")\">Bearbeiten</td>";
 
             HTTP::response += (String) "<td><form method='get' action='" + url + "'>"
@@ -220,11 +221,11 @@ HTTP_Signal::handle_sig (void)
 
     HTTP::response += (String)
         "<script>\r\n"
-        "function changesig(sigidx, name, addr)\r\n"
+        "function changesig(sigidx, pos, name, addr)\r\n"
         "{\r\n"
         "  document.getElementById('action').value = 'changesig';\r\n"
         "  document.getElementById('sigidx').value = sigidx;\r\n"
-        "  document.getElementById('nsigidx').value = sigidx;\r\n"
+        "  document.getElementById('npos').value = pos;\r\n"
         "  document.getElementById('name').value = name;\r\n"
         "  document.getElementById('addr').value = addr;\r\n"
         "  document.getElementById('newid').style.display='';\r\n"
@@ -259,7 +260,7 @@ HTTP_Signal::handle_sig (void)
             "<table>\r\n"
             "<tr id='newid'>\r\n";
 
-        HTTP_Common::print_id_select_list ("nsigidx", n_signals);
+        HTTP_Common::print_position_select_list ("npos", n_signals);
 
         HTTP::response += (String)
             "</tr>\r\n"
@@ -327,3 +328,15 @@ HTTP_Signal::action_sig (void)
         }
     }
 }
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Signal::init (void)
+{
+    HTTP::add_page   ("/sig",    HTTP_Signal::handle_sig);
+    HTTP::add_action ("sig",     HTTP_Signal::action_sig,    HTTP_ACTION_FLAG_CACHEABLE);
+    HTTP::add_action ("setsig",  HTTP_Signal::action_setsig, 0);
+}
@@ -25,6 +25,7 @@
 class HTTP_Signal
 {
     public:
+        static void     init (void);
         static void     handle_sig (void);
         static void     action_setsig (void);
         static void     action_sig (void);
@@ -46,6 +46,7 @@ HTTP_Switch::handle_switch (void)
     String          url       = "/switch";
     const char *    action    = HTTP::parameter ("action");
     uint_fast16_t   sw_idx  = 0;
+    uint_fast16_t   pos;
 
     HTTP_Common::html_header (title, title, url, true);
     HTTP::response += (String) "<div style='margin-left:20px;'>\r\n";
@@ -92,15 +93,13 @@ HTTP_Switch::handle_switch (void)
     {
         const char *    sname     = HTTP::parameter ("name");
         uint_fast16_t   swidx     = HTTP::parameter_number ("swidx");
-        uint_fast16_t   nswidx    = HTTP::parameter_number ("nswidx");
+        uint_fast16_t   npos      = HTTP::parameter_number ("npos");
         uint_fast16_t   addr      = HTTP::parameter_number ("addr");
         uint_fast8_t    threeway  = HTTP::parameter_number ("threeway");
         uint_fast8_t    flags     = 0;
+        uint_fast16_t   nswidx;
 
-        if (swidx != nswidx)
-        {
-            nswidx = Switches::set_new_id (swidx, nswidx);
-        }
+        nswidx = Switches::set_position (swidx, npos);                  // switch keeps its index, only display order changes
 
         if (threeway)
         {
@@ -173,8 +172,10 @@ HTTP_Switch::handle_switch (void)
 
     uint_fast16_t n_switches = Switches::get_n_switches ();
 
-    for (sw_idx = 0; sw_idx < n_switches; sw_idx++)
+    for (pos = 0; pos < n_switches; pos++)
     {
+        sw_idx = Switches::get_switch_idx (pos);
+
         String ssw_idx = std::to_string (sw_idx);
 
         if (*bg)
@@ -234,7 +235,7 @@ HTTP_Switch::handle_switch (void)
         if (HTTP_Common::edit_mode)
         {
             HTTP::response += (String) "<td><button onclick=\"changeswitch("
-                  + ssw_idx + ",'" + name + "'," + std::to_string(addr) + ","
+                  + ssw_idx + "," + std::to_string(pos) + ",'" + name + "'," + std::to_string(addr) + ","
                   + std::to_string(flags & SWITCH_FLAG_3WAY)
                   + ")\">Bearbeiten</td>";
 
@@ -255,11 +256,11 @@ HTTP_Switch::handle_switch (void)
 
     HTTP::response += (String)
         "<script>\r\n"
-        "function changeswitch(swidx, name, addr, threeway)\r\n"
+        "function changeswitch(swidx, pos, name, addr, threeway)\r\n"
         "{\r\n"
         "  document.getElementById('action').value = 'changeswitch';\r\n"
         "  document.getElementById('swidx').value = swidx;\r\n"
-        "  document.getElementById('nswidx').value = swidx;\r\n"
+        "  document.getElementById('npos').value = pos;\r\n"
         "  document.getElementById('name').value = name;\r\n"
         "  document.getElementById('addr').value = addr;\r\n"
         "  if (threeway) { document.getElementById('threeway').checked = true; } else { document.getElementById('threeway').checked = false; }\r\n"
@@ -300,7 +301,7 @@ HTTP_Switch::handle_switch (void)
             "<table>\r\n"
             "<tr id='newid'>\r\n";
 
-        HTTP_Common::print_id_select_list ("nswidx", n_switches);
+        HTTP_Common::print_position_select_list ("npos", n_switches);
 
         HTTP::response += (String)
             "</tr>\r\n"
@@ -373,3 +374,15 @@ HTTP_Switch::action_switch (void)
         }
     }
 }
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Switch::init (void)
+{
+    HTTP::add_page   ("/switch",  HTTP_Switch::handle_switch);
+    HTTP::add_action ("switch",   HTTP_Switch::action_switch, HTTP_ACTION_FLAG_CACHEABLE);
+    HTTP::add_action ("setsw",    HTTP_Switch::action_setsw,  0);
+}
@@ -25,6 +25,7 @@
 class HTTP_Switch
 {
     public:
+        static void     init (void);
         static void     handle_switch (void);
         static void     action_setsw (void);
         static void     action_switch (void);
@@ -157,3 +157,13 @@ HTTP_Test::handle_test (void)
 
     HTTP_Common::html_trailer ();
 }
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * init () - register pages and actions
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Test::init (void)
+{
+    HTTP::add_page   ("/test",  HTTP_Test::handle_test);
+}
@@ -25,6 +25,7 @@
 class HTTP_Test
 {
     public:
+        static void     init (void);
         static void     handle_test (void);
     private:
 };
@@ -0,0 +1,563 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * http-upload.cc - streaming upload of files via multipart/form-data
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ *
+ * The content of an upload is not read at once. HTTP::server() calls HTTP_Upload::process() in every cycle of the main
+ * loop, which reads at most HTTP_UPLOAD_MAX_CHUNKS_PER_CALL chunks without blocking and passes them to the multipart
+ * parser. So the control loop keeps running while a large file is uploaded.
+ *
+ * The data of the file is written to <filename>.tmp. If the upload is complete and size and checksum are correct, the
+ * temporary file is renamed to <filename>. An existing file is never overwritten with incomplete data.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <zlib.h>
+
+#include "http-upload.h"
+#include "debug.h"
+
+#define STATE_PREAMBLE          0                                   // skip data until first delimiter
+#define STATE_DELIMITER         1                                   // delimiter found, followed by CRLF or "--"
+#define STATE_HEADERS           2                                   // part headers
+#define STATE_DATA              3                                   // part data
+#define STATE_END               4                                   // close delimiter found, skip epilogue
+
+bool                            HTTP_Upload::active                 = false;
+int                             HTTP_Upload::fd                     = -1;
+uint_fast8_t                    HTTP_Upload::status                 = HTTP_UPLOAD_STATUS_NONE;
+uint_fast8_t                    HTTP_Upload::reason                 = HTTP_UPLOAD_REASON_NONE;
+char                            HTTP_Upload::filename[HTTP_UPLOAD_MAX_FILENAME_LEN];
+uint32_t                        HTTP_Upload::size                   = 0;
+uint32_t                        HTTP_Upload::crc                    = 0;
+
+static char                     buf[HTTP_UPLOAD_CHUNK_SIZE + HTTP_UPLOAD_MAX_HEADER_LEN + 4];
+static size_t                   buf_len;
+static char                     delimiter[HTTP_UPLOAD_MAX_BOUNDARY_LEN + 5];    // CRLF + "--" + boundary
+static size_t                   delimiter_len;
+static uint_fast8_t             state;
+static uint32_t                 content_length;
+static uint32_t                 received;
+static time_t                   last_activity;
+static FILE *                   fp;
+static char                     tmpname[HTTP_UPLOAD_MAX_FILENAME_LEN + 4];
+static bool                     in_file_part;
+static bool                     file_seen;
+static bool                     has_expected_crc;
+static uint32_t                 expected_crc_value;
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * upload_fail () - stop writing, remove temporary file. The rest of the content is read and discarded.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+upload_fail (uint_fast8_t reason)
+{
+    if (fp)
+    {
+        fclose (fp);
+        fp = (FILE *) NULL;
+        unlink (tmpname);
+    }
+
+    HTTP_Upload::status = HTTP_UPLOAD_STATUS_ERROR;
+    HTTP_Upload::reason = reason;
+    Debug::printf (DEBUG_LEVEL_NORMAL, "HTTP_Upload: upload of '%s' failed, reason = %u\n", HTTP_Upload::filename, reason);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * upload_write () - write part data, if part is the file
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+upload_write (const char * data, size_t len)
+{
+    if (state == STATE_DATA && in_file_part && len > 0)
+    {
+        if (fwrite (data, 1, len, fp) != len)
+        {
+            upload_fail (HTTP_UPLOAD_REASON_WRITE_ERROR);
+            return;
+        }
+
+        HTTP_Upload::crc = crc32 (HTTP_Upload::crc, (const Bytef *) data, len);
+        HTTP_Upload::size += len;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * upload_header_param () - get value of parameter in header line, e.g. name="file"
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+upload_header_param (const char * line, const char * param, char * value, size_t size)
+{
+    const char *    p = strstr (line, param);
+    size_t          idx = 0;
+
+    if (! p)
+    {
+        return false;
+    }
+
+    p += strlen (param);
+
+    while (*p && *p != '"')
+    {
+        if (idx < size - 1)
+        {
+            value[idx++] = *p;
+        }
+        p++;
+    }
+
+    value[idx] = '\0';
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * upload_part_headers () - parse headers of part, open temporary file if part is the file
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+upload_part_headers (const char * data, size_t len)
+{
+    char            headers[HTTP_UPLOAD_MAX_HEADER_LEN + 1];
+    char            name[64];
+    char            fname[HTTP_UPLOAD_MAX_FILENAME_LEN];
+    const char *    base;
+    char *          line;
+    char *          p;
+
+    in_file_part = false;
+
+    if (len > HTTP_UPLOAD_MAX_HEADER_LEN)
+    {
+        len = HTTP_UPLOAD_MAX_HEADER_LEN;
+    }
+
+    memcpy (headers, data, len);
+    headers[len] = '\0';
+
+    line = strcasestr (headers, "Content-Disposition:");
+
+    if (! line)
+    {
+        return;
+    }
+
+    p = strchr (line, '\r');
+
+    if (p)
+    {
+        *p = '\0';
+    }
+
+    if (! upload_header_param (line, "; name=\"", name, sizeof (name)) || strcmp (name, "file") != 0)
+    {
+        return;                                                     // ignore other form fields
+    }
+
+    if (file_seen)
+    {
+        return;                                                     // only the first file is accepted
+    }
+
+    file_seen = true;
+
+    if (! upload_header_param (line, "; filename=\"", fname, sizeof (fname)))
+    {
+        fname[0] = '\0';
+    }
+
+    base = basename (fname);                                        // don't accept filenames with full path
+    strcpy (HTTP_Upload::filename, base);
+    len = strlen (base);
+
+    if (len <= 4 || strcasecmp (base + len - 4, ".hex") != 0)
+    {
+        upload_fail (HTTP_UPLOAD_REASON_INVALID_FILENAME);
+        return;
+    }
+
+    sprintf (tmpname, "%s.tmp", base);
+    fp = fopen (tmpname, "w");
+
+    if (! fp)
+    {
+        upload_fail (HTTP_UPLOAD_REASON_CANNOT_OPEN_FILE);
+        return;
+    }
+
+    in_file_part = true;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * upload_parse () - parse received data in buf
+ *
+ * A delimiter can be split across two chunks, so the last (delimiter_len - 1) bytes of a chunk are kept in the buffer
+ * until the next chunk has been received.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+upload_parse (void)
+{
+    size_t  pos     = 0;
+    bool    again   = true;
+
+    while (again && HTTP_Upload::status == HTTP_UPLOAD_STATUS_BUSY)
+    {
+        char *  p;
+
+        switch (state)
+        {
+            case STATE_PREAMBLE:
+            case STATE_DATA:
+            {
+                p = (char *) memmem (buf + pos, buf_len - pos, delimiter, delimiter_len);
+
+                if (p)
+                {
+                    upload_write (buf + pos, p - (buf + pos));
+                    pos = (p - buf) + delimiter_len;
+                    state = STATE_DELIMITER;
+                }
+                else
+                {
+                    size_t  keep = delimiter_len - 1;
+
+                    if (buf_len - pos > keep)
+                    {
+                        upload_write (buf + pos, buf_len - pos - keep);
+                        pos = buf_len - keep;
+                    }
+
+                    again = false;
+                }
+                break;
+            }
+
+            case STATE_DELIMITER:
+            {
+                if (buf_len - pos < 2)
+                {
+                    again = false;
+                }
+                else if (! memcmp (buf + pos, "--", 2))
+                {
+                    pos += 2;
+                    state = STATE_END;
+                }
+                else if (! memcmp (buf + pos, "\r\n", 2))
+                {
+                    state = STATE_HEADERS;                          // CRLF is kept, it is part of the search for the empty line
+                }
+                else
+                {
+                    upload_fail (HTTP_UPLOAD_REASON_INVALID_FORMAT);
+                }
+                break;
+            }
+
+            case STATE_HEADERS:
+            {
+                p = (char *) memmem (buf + pos, buf_len - pos, "\r\n\r\n", 4);
+
+                if (p)
+                {
+                    size_t  len = p - (buf + pos);
+
+                    if (len > HTTP_UPLOAD_MAX_HEADER_LEN + 2)         // headers without leading CRLF must fit into buffer
+                    {
+                        upload_fail (HTTP_UPLOAD_REASON_INVALID_FORMAT);
+                        break;
+                    }
+
+                    if (len >= 2)
+                    {
+                        upload_part_headers (buf + pos + 2, len - 2);
+                    }
+                    else
+                    {
+                        in_file_part = false;                       // part without headers
+                    }
+
+                    pos = (p - buf) + 4;
+                    state = STATE_DATA;
+                }
+                else if (buf_len - pos > HTTP_UPLOAD_MAX_HEADER_LEN)
+                {
+                    upload_fail (HTTP_UPLOAD_REASON_INVALID_FORMAT);
+                }
+                else
+                {
+                    again = false;
+                }
+                break;
+            }
+
+            default: // STATE_END
+            {
+                pos = buf_len;
+                again = false;
+                break;
+            }
+        }
+    }
+
+    if (HTTP_Upload::status == HTTP_UPLOAD_STATUS_BUSY)
+    {
+        memmove (buf, buf + pos, buf_len - pos);
+        buf_len -= pos;
+    }
+    else
+    {
+        buf_len = 0;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * upload_finish () - check size and checksum, rename temporary file
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+upload_finish (void)
+{
+    struct stat st;
+    bool        write_error;
+
+    if (state != STATE_END)
+    {
+        upload_fail (HTTP_UPLOAD_REASON_TRUNCATED);
+        return;
+    }
+
+    if (! fp)
+    {
+        HTTP_Upload::filename[0] = '\0';                            // no file in form data
+        upload_fail (HTTP_UPLOAD_REASON_INVALID_FILENAME);
+        return;
+    }
+
+    write_error = (fflush (fp) != 0 || ferror (fp) || fsync (fileno (fp)) != 0);
+
+    if (fclose (fp) != 0)
+    {
+        write_error = true;
+    }
+
+    fp = (FILE *) NULL;
+
+    if (! write_error && (stat (tmpname, &st) != 0 || st.st_size != (off_t) HTTP_Upload::size))
+    {
+        write_error = true;
+    }
+
+    if (write_error)
+    {
+        unlink (tmpname);
+        upload_fail (HTTP_UPLOAD_REASON_WRITE_ERROR);
+        return;
+    }
+
+    if (has_expected_crc && HTTP_Upload::crc != expected_crc_value)
+    {
+        unlink (tmpname);
+        upload_fail (HTTP_UPLOAD_REASON_CHECKSUM);
+        return;
+    }
+
+    if (rename (tmpname, HTTP_Upload::filename) != 0)
+    {
+        unlink (tmpname);
+        upload_fail (HTTP_UPLOAD_REASON_WRITE_ERROR);
+        return;
+    }
+
+    HTTP_Upload::status = HTTP_UPLOAD_STATUS_OK;
+    Debug::printf (DEBUG_LEVEL_NORMAL, "HTTP_Upload: '%s' uploaded, size = %u, crc = %08X\n", HTTP_Upload::filename, HTTP_Upload::size, HTTP_Upload::crc);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * start () - start upload on connection fd
+ *
+ * expected_crc: CRC32 as hex string, e.g. from request header X-Upload-CRC32, may be empty
+ * returns false, if another upload is in progress
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+HTTP_Upload::start (int upload_fd, const char * boundary, uint32_t len, const char * expected_crc)
+{
+    if (HTTP_Upload::active)
+    {
+        Debug::printf (DEBUG_LEVEL_NORMAL, "HTTP_Upload: another upload is in progress\n");
+        return false;
+    }
+
+    HTTP_Upload::reset ();
+
+    HTTP_Upload::active = true;
+    HTTP_Upload::fd     = upload_fd;
+    HTTP_Upload::status = HTTP_UPLOAD_STATUS_BUSY;
+    HTTP_Upload::crc    = crc32 (0L, Z_NULL, 0);
+
+    content_length      = len;
+    last_activity       = time ((time_t *) NULL);
+
+    strcpy (buf, "\r\n");                                           // first delimiter has no leading CRLF, insert one
+    buf_len = 2;
+
+    if (*expected_crc)
+    {
+        has_expected_crc    = true;
+        expected_crc_value  = strtoul (expected_crc, (char **) NULL, 16);
+    }
+
+    if (strlen (boundary) == 0 || strlen (boundary) > HTTP_UPLOAD_MAX_BOUNDARY_LEN)
+    {
+        upload_fail (HTTP_UPLOAD_REASON_INVALID_FORMAT);
+    }
+    else if (len > HTTP_UPLOAD_MAX_SIZE)
+    {
+        upload_fail (HTTP_UPLOAD_REASON_TOO_LARGE);
+        content_length = 0;                                         // don't read the content, answer immediately
+    }
+    else
+    {
+        delimiter_len = sprintf (delimiter, "\r\n--%s", boundary);
+    }
+
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * process () - receive and parse next chunks of upload without blocking
+ *
+ * returns true, if the upload is finished and the result can be sent, see status and reason
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+HTTP_Upload::process (void)
+{
+    uint_fast8_t    n_chunks;
+
+    for (n_chunks = 0; n_chunks < HTTP_UPLOAD_MAX_CHUNKS_PER_CALL && received < content_length; n_chunks++)
+    {
+        size_t  space = sizeof (buf) - buf_len;
+        ssize_t n;
+
+        if (space > HTTP_UPLOAD_CHUNK_SIZE)
+        {
+            space = HTTP_UPLOAD_CHUNK_SIZE;
+        }
+
+        if (space > content_length - received)
+        {
+            space = content_length - received;
+        }
+
+        n = recv (HTTP_Upload::fd, buf + buf_len, space, MSG_DONTWAIT);
+
+        if (n > 0)
+        {
+            received        += n;
+            buf_len         += n;
+            last_activity   = time ((time_t *) NULL);
+
+            if (HTTP_Upload::status == HTTP_UPLOAD_STATUS_BUSY)
+            {
+                upload_parse ();
+            }
+            else
+            {
+                buf_len = 0;                                        // upload failed, discard rest of content
+            }
+        }
+        else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            if (HTTP_Upload::status == HTTP_UPLOAD_STATUS_BUSY)     // connection closed by client
+            {
+                upload_finish ();
+            }
+            return true;
+        }
+        else                                                        // no more data available yet
+        {
+            if (time ((time_t *) NULL) - last_activity > HTTP_UPLOAD_TIMEOUT)
+            {
+                if (HTTP_Upload::status == HTTP_UPLOAD_STATUS_BUSY)
+                {
+                    upload_fail (HTTP_UPLOAD_REASON_TIMEOUT);
+                }
+                return true;
+            }
+            break;
+        }
+    }
+
+    if (received >= content_length)
+    {
+        if (HTTP_Upload::status == HTTP_UPLOAD_STATUS_BUSY)
+        {
+            upload_finish ();
+        }
+        return true;
+    }
+
+    return false;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * reset () - reset upload, the connection must be closed by the caller
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP_Upload::reset (void)
+{
+    if (fp)
+    {
+        fclose (fp);
+        fp = (FILE *) NULL;
+        unlink (tmpname);
+    }
+
+    HTTP_Upload::active         = false;
+    HTTP_Upload::fd             = -1;
+    HTTP_Upload::status         = HTTP_UPLOAD_STATUS_NONE;
+    HTTP_Upload::reason         = HTTP_UPLOAD_REASON_NONE;
+    HTTP_Upload::filename[0]    = '\0';
+    HTTP_Upload::size           = 0;
+    HTTP_Upload::crc            = 0;
+
+    buf_len                     = 0;
+    delimiter_len               = 0;
+    state                       = STATE_PREAMBLE;
+    content_length              = 0;
+    received                    = 0;
+    in_file_part                = false;
+    file_seen                   = false;
+    has_expected_crc            = false;
+    expected_crc_value          = 0;
+}
@@ -0,0 +1,64 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * http-upload.h - streaming upload of files via multipart/form-data
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef HTTP_UPLOAD_H
+#define HTTP_UPLOAD_H
+
+#include <stdint.h>
+
+#define HTTP_UPLOAD_CHUNK_SIZE              16384                   // max. bytes received per recv() call
+#define HTTP_UPLOAD_MAX_CHUNKS_PER_CALL     8                       // max. chunks received per call of HTTP_Upload::process()
+#define HTTP_UPLOAD_MAX_HEADER_LEN          1024                    // max. length of part headers
+#define HTTP_UPLOAD_MAX_BOUNDARY_LEN        70                      // see RFC 2046
+#define HTTP_UPLOAD_MAX_FILENAME_LEN        128
+#define HTTP_UPLOAD_MAX_SIZE                (16 * 1024 * 1024)      // max. content length of upload: 16 MB
+#define HTTP_UPLOAD_TIMEOUT                 10                      // abort upload if no data received for 10 seconds
+
+#define HTTP_UPLOAD_STATUS_NONE             0                       // no upload
+#define HTTP_UPLOAD_STATUS_BUSY             1                       // upload in progress
+#define HTTP_UPLOAD_STATUS_OK               2                       // upload successful
+#define HTTP_UPLOAD_STATUS_ERROR            3                       // upload failed, see reason
+
+#define HTTP_UPLOAD_REASON_NONE             0
+#define HTTP_UPLOAD_REASON_CANNOT_OPEN_FILE 1
+#define HTTP_UPLOAD_REASON_INVALID_FILENAME 2
+#define HTTP_UPLOAD_REASON_TOO_LARGE        3
+#define HTTP_UPLOAD_REASON_TRUNCATED        4
+#define HTTP_UPLOAD_REASON_TIMEOUT          5
+#define HTTP_UPLOAD_REASON_WRITE_ERROR      6
+#define HTTP_UPLOAD_REASON_CHECKSUM         7
+#define HTTP_UPLOAD_REASON_INVALID_FORMAT   8
+
+class HTTP_Upload
+{
+    public:
+        static bool             active;                             // upload connection is open
+        static int              fd;                                 // socket of upload connection
+        static uint_fast8_t     status;                             // HTTP_UPLOAD_STATUS_xxx
+        static uint_fast8_t     reason;                             // HTTP_UPLOAD_REASON_xxx
+        static char             filename[HTTP_UPLOAD_MAX_FILENAME_LEN];
+        static uint32_t         size;                               // size of uploaded file
+        static uint32_t         crc;                                // CRC32 of uploaded file
+
+        static bool             start (int fd, const char * boundary, uint32_t content_length, const char * expected_crc);
+        static bool             process (void);
+        static void             reset (void);
+};
+
+#endif
@@ -18,8 +18,10 @@
  *------------------------------------------------------------------------------------------------------------------------
  */
 #include <string>
+#include <vector>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <signal.h>
@@ -33,8 +35,11 @@
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <errno.h>
 #include <time.h>
 #include <sys/wait.h>
+#include <zlib.h>
 
 #include "http.h"
 #include "http-common.h"
@@ -52,12 +57,16 @@
 #include "http-pommot.h"
 #include "http-pommap.h"
 #include "http-pomout.h"
+#include "http-upload.h"
+#include "http-api.h"
+#include "http-metrics.h"
 #include "loco.h"
 #include "stm32.h"
+#include "fm22.h"
 #include "debug.h"
 #include "base.h"
-
-#define WRITE_CHUNK_SIZE        1024
+#include "metrics.h"
+#include "recorder.h"
 
 #define MAX_PARAMETERS          2048
 #define MAX_PARAMETER_NAME_LEN  64
@@ -71,12 +80,24 @@
 #define METHOD_POST             2
 #define METHOD_POST_MULTI       3
 
+#define MAX_ACTION_CACHE_ENTRIES    16                              // number of cached action responses
+
+#define ENCODING_NONE           0                                   // content encoding of response
+#define ENCODING_GZIP           1
+#define ENCODING_DEFLATE        2
+
+#define DEFLATE_BUF_SIZE        4096                                // output buffer of deflate stream
+
+#define MAX_IOVEC               64                                  // max. number of chunks per sendmsg() call
+
+#define HANDLER_TABLE_SIZE      128                                 // size of hash tables for pages and actions, must be power of 2
+
 static char *               boundary        = (char *) 0;
 
 static char                 request_buf[MAX_REQUEST_LEN];
 static char                 post_buf[MAX_POST_LEN];
 
-String                      HTTP::response;
+HTTP_Response               HTTP::response;
 
 static int                  sock_fd;
 static struct sockaddr_in   http_listen_addr;
@@ -88,6 +109,27 @@ static char *               request_parameter_name[MAX_PARAMETERS];
 static char *               request_parameter_value[MAX_PARAMETERS];
 static int                  n_parameters;
 
+typedef struct
+{
+    String                  key;                                    // action and parameters of request
+    String                  response;                               // rendered response
+    uint32_t                state_version;                          // state version at time of rendering
+    uint32_t                last_used;                              // for replacement of least recently used entry
+    bool                    valid;
+} ACTION_CACHE_ENTRY;
+
+static ACTION_CACHE_ENTRY   action_cache[MAX_ACTION_CACHE_ENTRIES];
+static uint32_t             action_cache_clock;
+static bool                 request_is_cacheable;
+
+static char                 if_none_match[64];                      // value of request header If-None-Match
+static uint_fast8_t         accept_encoding;                        // best encoding accepted by client, see ENCODING_xxx
+
+static z_stream             deflate_stream;                         // stream for compression of dynamic responses
+static bool                 deflate_active;
+
+static uint_fast8_t         upload_accept_encoding;                 // accept_encoding of running upload request
+
 extern uint16_t             limit;
 extern uint16_t             min_lower_value;
 extern uint16_t             max_lower_value;
@@ -278,33 +320,197 @@ http_post (int len)
 }
 
 /*----------------------------------------------------------------------------------------------------------------------------------------
- * http_write ()
+ * http_sendv () - send uncompressed iovec array with one sendmsg() call per MAX_IOVEC entries, handles partial writes
+ *
+ * flags: MSG_MORE if more data follows immediately, e.g. after the http header
  *----------------------------------------------------------------------------------------------------------------------------------------
  */
 static int
-http_write (const char * buf, int len)
+http_sendv (struct iovec * iov, int iovcnt, int flags)
 {
-    int rtc = 0;
+    struct msghdr   msg;
 
-    while (len >= WRITE_CHUNK_SIZE)
+    memset (&msg, 0, sizeof (msg));
+
+    while (iovcnt > 0)
     {
-        rtc = write (http_fd, buf, WRITE_CHUNK_SIZE);
+        ssize_t n;
+
+        msg.msg_iov     = iov;
+        msg.msg_iovlen  = (iovcnt > MAX_IOVEC) ? MAX_IOVEC : iovcnt;
 
-        if (rtc < 0)
+        n = sendmsg (http_fd, &msg, (iovcnt > MAX_IOVEC) ? (flags | MSG_MORE) : flags);
+
+        if (n < 0)
         {
-            break;
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return -1;
+        }
+
+        while (iovcnt > 0 && n >= (ssize_t) iov->iov_len)
+        {
+            n -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+
+        if (iovcnt > 0)
+        {
+            iov->iov_base = (char *) iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+
+    return 0;
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * http_send_raw () - send uncompressed buffer
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+http_send_raw (const char * buf, int len, int flags)
+{
+    struct iovec    iov;
+
+    iov.iov_base    = (void *) buf;
+    iov.iov_len     = len;
+
+    return http_sendv (&iov, 1, flags);
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * http_write_raw () - write uncompressed
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+http_write_raw (const char * buf, int len)
+{
+    return http_send_raw (buf, len, 0);
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * http_send_header () - send http header, the body follows, so let the kernel merge both into one TCP segment
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+http_send_header (const String& header)
+{
+    return http_send_raw (header.data(), header.length(), MSG_MORE);
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * http_deflate () - compress data and write output of deflate stream
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+http_deflate (const char * buf, int len, int flush)
+{
+    static unsigned char    outbuf[DEFLATE_BUF_SIZE];
+    int                     rtc = 0;
+
+    deflate_stream.next_in  = (Bytef *) buf;
+    deflate_stream.avail_in = len;
+
+    do
+    {
+        int n;
+
+        deflate_stream.next_out     = outbuf;
+        deflate_stream.avail_out    = DEFLATE_BUF_SIZE;
+
+        if (deflate (&deflate_stream, flush) == Z_STREAM_ERROR)
+        {
+            Debug::printf (DEBUG_LEVEL_NONE, "http_deflate: deflate failed\n");
+            return -1;
+        }
+
+        n = DEFLATE_BUF_SIZE - deflate_stream.avail_out;
+
+        if (n > 0)
+        {
+            rtc = http_write_raw ((char *) outbuf, n);
+
+            if (rtc < 0)
+            {
+                break;
+            }
         }
+    } while (deflate_stream.avail_out == 0);
 
-        len -= WRITE_CHUNK_SIZE;
-        buf += WRITE_CHUNK_SIZE;
+    return rtc;
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * http_deflate_start () - start compression of response, returns false if response is sent uncompressed
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+http_deflate_start (void)
+{
+    uint_fast8_t    level = FM22::get_compression_level ();
+    int             window_bits;
+
+    deflate_active = false;
+
+    if (level == 0 || accept_encoding == ENCODING_NONE)
+    {
+        return false;
     }
 
-    if (rtc >= 0 && len)
+    if (accept_encoding == ENCODING_GZIP)
+    {
+        window_bits = 15 + 16;                                      // gzip header and trailer
+    }
+    else
     {
-        rtc = write (http_fd, buf, len);
+        window_bits = 15;                                           // zlib format, see RFC 9110 "deflate"
     }
 
-    return rtc;
+    memset (&deflate_stream, 0, sizeof (deflate_stream));
+
+    if (deflateInit2 (&deflate_stream, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "http_deflate_start: deflateInit2 failed\n");
+        return false;
+    }
+
+    deflate_active = true;
+    return true;
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * http_deflate_end () - finish compression of response
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+http_deflate_end (void)
+{
+    if (deflate_active)
+    {
+        (void) http_deflate ("", 0, Z_FINISH);
+        deflateEnd (&deflate_stream);
+        deflate_active = false;
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * http_write ()
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+http_write (const char * buf, int len)
+{
+    if (deflate_active)
+    {
+        return http_deflate (buf, len, Z_NO_FLUSH);
+    }
+
+    return http_write_raw (buf, len);
 }
 
 /*-------------------------------------------------------------------------------------------------------------------------------------------
@@ -329,7 +535,7 @@ http_puts (const char * s)
  *-------------------------------------------------------------------------------------------------------------------------------------------
  */
 static int
-http_puts (String str)
+http_puts (const String& str)
 {
     const char *    s   = str.c_str();
     int             len = str.length();
@@ -349,9 +555,172 @@ http_puts (String str)
  *----------------------------------------------------------------------------------------------------------------------------------------
  */
 static void
-http_header (void)
+http_header (const char * content_type)
+{
+    String  header = (String) "HTTP/1.1 200 OK\r\nServer: FM/1.1.1 (Linux)\r\nConnection: close\r\nContent-Type: " + content_type + "\r\n";
+
+    if (http_deflate_start ())
+    {
+        if (accept_encoding == ENCODING_GZIP)
+        {
+            header += "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n";
+        }
+        else
+        {
+            header += "Content-Encoding: deflate\r\nVary: Accept-Encoding\r\n";
+        }
+    }
+
+    header += "\r\n";
+    http_send_header (header);
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * static resources: shared by all pages, cached by the browser. The etag is a hash of the content. It is also appended to the url,
+ * see HTTP::static_url(), so a changed resource gets a new url and the browser never uses an outdated copy.
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+    const char *        url;
+    const char *        content_type;
+    const char **       content;
+    char                etag[9];                                    // 8 hex digits + '\0'
+    String              gzip_content;                               // precompressed content, empty if compression failed
+} STATICENTRY;
+
+static STATICENTRY      staticentry[] =
+{
+    { "/fm22.css",      "text/css",                 &HTTP_Common::common_css,   "", ""  },
+    { "/fm22.js",       "application/javascript",   &HTTP_Common::common_js,    "", ""  },
+};
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * http_static_init () - calculate etags of static resources (FNV-1a hash)
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+http_static_init (void)
+{
+    uint_fast8_t    n_entries = sizeof (staticentry) / sizeof (STATICENTRY);
+    uint_fast8_t    idx;
+    z_stream        strm;
+    size_t          content_len;
+
+    for (idx = 0; idx < n_entries; idx++)
+    {
+        const char *    p       = *staticentry[idx].content;
+        uint32_t        hash    = 2166136261U;
+
+        while (*p)
+        {
+            hash ^= (uint8_t) *p++;
+            hash *= 16777619U;
+        }
+
+        sprintf (staticentry[idx].etag, "%08x", (unsigned int) hash);
+
+        staticentry[idx].gzip_content = "";
+
+        content_len = strlen (*staticentry[idx].content);
+        memset (&strm, 0, sizeof (strm));
+
+        if (deflateInit2 (&strm, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) == Z_OK)
+        {
+            String  gz (deflateBound (&strm, content_len), '\0');
+
+            strm.next_in    = (Bytef *) *staticentry[idx].content;
+            strm.avail_in   = content_len;
+            strm.next_out   = (Bytef *) &gz[0];
+            strm.avail_out  = gz.length ();
+
+            if (deflate (&strm, Z_FINISH) == Z_STREAM_END)
+            {
+                gz.resize (strm.total_out);
+                staticentry[idx].gzip_content = gz;
+            }
+
+            deflateEnd (&strm);
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * http_static () - send static resource, returns false if request_file is not a static resource
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+http_static (void)
+{
+    uint_fast8_t    n_entries = sizeof (staticentry) / sizeof (STATICENTRY);
+    uint_fast8_t    idx;
+
+    for (idx = 0; idx < n_entries; idx++)
+    {
+        if (! strcmp (request_file, staticentry[idx].url))
+        {
+            break;
+        }
+    }
+
+    if (idx == n_entries)
+    {
+        return false;
+    }
+
+    request_is_cacheable = true;
+
+    if (strstr (if_none_match, staticentry[idx].etag))
+    {
+        http_puts ((String) "HTTP/1.1 304 Not Modified\r\nServer: FM/1.1.1 (Linux)\r\nConnection: close\r\n"
+                   "ETag: \"" + staticentry[idx].etag + "\"\r\n\r\n");
+    }
+    else if (accept_encoding == ENCODING_GZIP && staticentry[idx].gzip_content.length () > 0)
+    {
+        http_send_header ((String) "HTTP/1.1 200 OK\r\nServer: FM/1.1.1 (Linux)\r\nConnection: close\r\n"
+                   "Content-Type: " + staticentry[idx].content_type + "\r\n"
+                   "Content-Encoding: gzip\r\n"
+                   "Content-Length: " + std::to_string (staticentry[idx].gzip_content.length ()) + "\r\n"
+                   "Cache-Control: public, max-age=31536000\r\n"
+                   "Vary: Accept-Encoding\r\n"
+                   "ETag: \"" + staticentry[idx].etag + "\"\r\n\r\n");
+        http_puts (staticentry[idx].gzip_content);
+    }
+    else
+    {
+        const char *    content = *staticentry[idx].content;
+
+        http_send_header ((String) "HTTP/1.1 200 OK\r\nServer: FM/1.1.1 (Linux)\r\nConnection: close\r\n"
+                   "Content-Type: " + staticentry[idx].content_type + "\r\n"
+                   "Content-Length: " + std::to_string (strlen (content)) + "\r\n"
+                   "Cache-Control: public, max-age=31536000\r\n"
+                   "Vary: Accept-Encoding\r\n"
+                   "ETag: \"" + staticentry[idx].etag + "\"\r\n\r\n");
+        http_puts (content);
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * HTTP::static_url () - get versioned url of a static resource
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+String
+HTTP::static_url (const char * url)
 {
-    http_puts ("HTTP/1.1 200 OK\r\nServer: FM/1.1.1 (Linux)\r\nConnection: close\r\nContent-Type: text/html\r\n\r\n");
+    uint_fast8_t    n_entries = sizeof (staticentry) / sizeof (STATICENTRY);
+    uint_fast8_t    idx;
+
+    for (idx = 0; idx < n_entries; idx++)
+    {
+        if (! strcmp (url, staticentry[idx].url))
+        {
+            return (String) url + "?v=" + staticentry[idx].etag;
+        }
+    }
+
+    return (String) url;
 }
 
 /*----------------------------------------------------------------------------------------------------------------------------------------
@@ -527,6 +896,7 @@ show_directory (const char * action, String url)
         {
             char *  filename = entry->d_name;
             size_t  len = strlen (filename);
+            String  efilename;
 
             if (len > 4 && ! strcasecmp (filename + len - 4, ".hex"))
             {
@@ -539,10 +909,11 @@ show_directory (const char * action, String url)
                     tmp = localtime (&st.st_mtime);
 
                     sprintf (stime, "%04d-%02d-%02d %02d:%02d", tmp->tm_year + 1900, tmp->tm_mon + 1, tmp->tm_mday, tmp->tm_hour, tmp->tm_min);
+                    efilename = HTTP_Common::html_escape (filename);
 
                     HTTP::response += (String)
                         "<tr>"
-                        "<td nowrap>" + filename +
+                        "<td nowrap>" + efilename +
                         "</td><td align='right'>" + std::to_string (st.st_size) +
                         "</td><td align='right' nowrap>" + stime +
                         "</td>"
@@ -550,7 +921,7 @@ show_directory (const char * action, String url)
                         "<form action='" + url +
                         "' method='GET'>\r\n"
                         "  <input type='hidden' name='action' value='delete'>\r\n"
-                        "  <input type='hidden' name='fname'  value='" + filename +
+                        "  <input type='hidden' name='fname'  value='" + efilename +
                         "'>\r\n"
                         "  <input type='submit' value='Delete'>\r\n"
                         "</form>\r\n"
@@ -559,7 +930,7 @@ show_directory (const char * action, String url)
                         "<form action='" + url +
                         "' method='GET'>\r\n"
                         "  <input type='hidden' name='action' value='check'>\r\n"
-                        "  <input type='hidden' name='fname'  value='" + filename +
+                        "  <input type='hidden' name='fname'  value='" + efilename +
                         "'>\r\n"
                         "  <input type='submit' value='Check'>\r\n"
                         "</form>\r\n"
@@ -567,7 +938,7 @@ show_directory (const char * action, String url)
                         "<td>\r\n"
                         "<form action='/flash' method='GET'>\r\n"
                         "  <input type='hidden' name='action' value='flash'>\r\n"
-                        "  <input type='hidden' name='fname'  value='" + filename +
+                        "  <input type='hidden' name='fname'  value='" + efilename +
                         "'>\r\n"
                         "  <input type='submit' value='Flash'>\r\n"
                         "</form>\r\n"
@@ -599,12 +970,8 @@ print_upload_form (void)
         "</form>\r\n";
 }
 
-#define REASON_NONE                 0
-#define REASON_CANNOT_OPEN_FILE     1
-#define REASON_INVALID_FILENAME     2
-
 /*----------------------------------------------------------------------------------------------------------------------------------------
- * handle_doupload ()
+ * handle_doupload () - show result of upload, see HTTP_Upload
  *----------------------------------------------------------------------------------------------------------------------------------------
  */
 static void
@@ -613,106 +980,37 @@ handle_doupload (void)
     String          title               = "Upload Hex";
     String          url                 = "/upl";
     const char *    action              = HTTP::parameter ("action");
-    uint_fast8_t    reason              = REASON_NONE;
-    char *          fname               = (char *) 0;
-    bool            upload_successful   = false;
+    const char *    fname               = HTTP_Upload::filename;
 
     HTTP_Common::html_header (title, title, url, true);
     HTTP::response += (String)
         "<P>\r\n"
         "<div style='margin-top:10px;margin-bottom:10px;margin-left:20px;padding:10px;border:1px lightgray solid;display:inline-block;'>\r\n";
 
-    if (n_parameters > 0 && boundary)
+    if (HTTP_Upload::active && HTTP_Upload::fd != http_fd)
     {
-        char    start_boundary[128];
-        char    end_boundary[128];
-        char *  par = request_parameter_name[0];
-        char *  p;
-
-        sprintf (start_boundary, "--%s\r\n", boundary);
-        sprintf (end_boundary, "\r\n--%s--", boundary);
-
-        if (! strncmp (par, start_boundary, strlen (start_boundary)))
-        {
-            p = strchr (par, '\n');
-
-            if (p)
-            {
-                p++;
-
-                if (! strncmp (p, "Content-Disposition: form-data; name=\"file\"; filename=\"", 55))
-                {
-                    fname = p + 55;
-                    p = strchr (p + 55, '"');
-
-                    if (p)
-                    {
-                        size_t  len;
-
-                        *p = '\0';
-                        fname = basename (fname);               // don't accept filenames with full path
-                        len = strlen (fname);
-
-                        if (len > 4 && ! strcasecmp (fname + len - 4, ".hex"))
-                        {
-                            FILE * fp = fopen (fname, "w");
-
-                            if (fp)
-                            {
-                                char * pp;
-
-                                p = request_parameter_value[0];
-                                pp = strstr (p, end_boundary);
-
-                                if (pp)
-                                {
-                                    *pp = '\0';
-
-                                    while (*p)
-                                    {
-                                        putc (*p, fp);
-                                        p++;
-                                    }
-                                }
-
-                                upload_successful = true;
-                                fclose (fp);
-                            }
-                            else
-                            {
-                                reason = REASON_CANNOT_OPEN_FILE;
-                            }
-                        }
-                        else
-                        {
-                            reason = REASON_INVALID_FILENAME;
-                        }
-                    }
-                    else
-                    {
-                        fname = (char *) 0;
-                    }
-                }
-            }
-        }
+        HTTP::response += (String) "<font color='red'>Upload fehlgeschlagen. Es l&auml;uft bereits ein anderer Upload.</font><BR>\r\n";
     }
-
-    if (upload_successful)
+    else if (HTTP_Upload::status == HTTP_UPLOAD_STATUS_OK)
     {
-        HTTP::response += (String) "<font color='darkgreen'>Upload erfolgreich.</font><BR>\r\n";
+        char    crc[9];
 
-        if (fname && *fname)
-        {
-            HTTP::response += (String) "<font color='darkgreen'>Dateiname: " + fname + "</font>\r\n";
-        }
+        sprintf (crc, "%08X", HTTP_Upload::crc);
+
+        HTTP::response += (String)
+            "<font color='darkgreen'>Upload erfolgreich.</font><BR>\r\n"
+            "<font color='darkgreen'>Dateiname: " + HTTP_Common::html_escape (fname) + "</font><BR>\r\n"
+            "<font color='darkgreen'>Gr&ouml;&szlig;e: " + std::to_string (HTTP_Upload::size) + " Bytes, CRC32: " + crc + "</font>\r\n";
     }
     else
     {
+        uint_fast8_t    reason = HTTP_Upload::reason;
+
         HTTP::response += (String) "<font color='red'>Upload fehlgeschlagen. ";
 
-        if (reason == REASON_INVALID_FILENAME)
+        if (reason == HTTP_UPLOAD_REASON_INVALID_FILENAME)
         {
-            if (fname && *fname)
+            if (*fname)
             {
                 HTTP::response += (String) "Ung&uuml;ltiger Dateiname.<BR>\r\n";
             }
@@ -721,16 +1019,40 @@ handle_doupload (void)
                 HTTP::response += (String) "Keine Datei angegeben.<BR>\r\n";
             }
         }
-        else if (reason == REASON_CANNOT_OPEN_FILE)
+        else if (reason == HTTP_UPLOAD_REASON_CANNOT_OPEN_FILE)
+        {
+            HTTP::response += (String) "Die Datei konnte nicht ge&ouml;ffnet werden.\r\n";
+        }
+        else if (reason == HTTP_UPLOAD_REASON_TOO_LARGE)
+        {
+            HTTP::response += (String) "Die Datei ist zu gro&szlig; (max. " + std::to_string (HTTP_UPLOAD_MAX_SIZE / (1024 * 1024)) + " MB).\r\n";
+        }
+        else if (reason == HTTP_UPLOAD_REASON_TRUNCATED)
+        {
+            HTTP::response += (String) "Die &Uuml;bertragung ist unvollst&auml;ndig.\r\n";
+        }
+        else if (reason == HTTP_UPLOAD_REASON_TIMEOUT)
+        {
+            HTTP::response += (String) "Zeit&uuml;berschreitung bei der &Uuml;bertragung.\r\n";
+        }
+        else if (reason == HTTP_UPLOAD_REASON_WRITE_ERROR)
+        {
+            HTTP::response += (String) "Die Datei konnte nicht geschrieben werden.\r\n";
+        }
+        else if (reason == HTTP_UPLOAD_REASON_CHECKSUM)
+        {
+            HTTP::response += (String) "Die Pr&uuml;fsumme ist falsch.\r\n";
+        }
+        else if (reason == HTTP_UPLOAD_REASON_INVALID_FORMAT)
         {
-            HTTP::response += (String) "Die Datei konnte nicht ge&oouml;ffnet werden.\r\n";
+            HTTP::response += (String) "Ung&uuml;ltiges Format.\r\n";
         }
 
         HTTP::response += (String) "</font><BR>\r\n";
 
-        if (fname && *fname)
+        if (*fname)
         {
-            HTTP::response += (String) "Dateiname: " + fname + "<BR>\r\n";
+            HTTP::response += (String) "Dateiname: " + HTTP_Common::html_escape (fname) + "<BR>\r\n";
         }
     }
 
@@ -859,161 +1181,239 @@ handle_flash (void)
 }
 
 /*----------------------------------------------------------------------------------------------------------------------------------------
- * handle_action ()
+ * action_cache_key () - build cache key from all request parameters
  *----------------------------------------------------------------------------------------------------------------------------------------
  */
-static void
-handle_action (void)
+static String
+action_cache_key (void)
 {
-    const char *    action = HTTP::parameter ("action");
-
-    Debug::printf (DEBUG_LEVEL_VERBOSE, "handle_action: action=%s\n", action);
-
-    HTTP::response = "";
+    String  key;
+    int     idx;
 
-    if (strcmp (action, "estop") == 0)
-    {
-        Locos::estop ();
-    }
-    else if (strcmp (action, "on") == 0)
-    {
-        HTTP_Common::action_on ();
-    }
-    else if (strcmp (action, "off") == 0)
+    for (idx = 0; idx < n_parameters; idx++)
     {
-        HTTP_Common::action_off ();
+        key += (String) request_parameter_name[idx] + "=" + request_parameter_value[idx] + "&";
     }
-    else if (strcmp (action, "rstalert") == 0)
-    {
-        HTTP::set_alert ("");
-    }
-    else if (strcmp (action, "head") == 0)
-    {
-        HTTP_Common::head_action ();
-    }
-    else if (strcmp (action, "locos") == 0)
-    {
-        HTTP_Loco::action_locos ();
-    }
-    else if (strcmp (action, "led") == 0)
-    {
-        HTTP_Led::action_led ();
-    }
-    else if (strcmp (action, "rr") == 0)
-    {
-        HTTP_Railroad::action_rr ();
-    }
-    else if (strcmp (action, "s88") == 0)
-    {
-        HTTP_S88::action_s88 ();
-    }
-    else if (strcmp (action, "rcl") == 0)
-    {
-        HTTP_RCL::action_rcl ();
-    }
-    else if (strcmp (action, "macro") == 0)
-    {
-        HTTP_Loco::action_macro ();
-    }
-    else if (strcmp (action, "setspeed") == 0)
-    {
-        HTTP_Loco::action_setspeed ();
-    }
-    else if (strcmp (action, "go") == 0)
-    {
-        HTTP_Common::action_go ();
-    }
-    else if (strcmp (action, "togglefunction") == 0)
-    {
-        HTTP_Loco::action_togglefunction ();
-    }
-    else if (strcmp (action, "togglefunctionaddon") == 0)
-    {
-        HTTP_AddOn::action_togglefunctionaddon ();
-    }
-    else if (strcmp (action, "setdestination") == 0)
-    {
-        HTTP_Loco::action_setdestination ();
-    }
-    else if (strcmp (action, "loco") == 0)
-    {
-        HTTP_Loco::action_loco ();
-    }
-    else if (strcmp (action, "getf") == 0)
-    {
-        HTTP_Loco::action_getf ();
-    }
-    else if (strcmp (action, "getfa") == 0)
-    {
-        HTTP_AddOn::action_getfa ();
-    }
-    else if (strcmp (action, "setled") == 0)
-    {
-        HTTP_Led::action_setled ();
-    }
-    else if (strcmp (action, "setsw") == 0)
-    {
-        HTTP_Switch::action_setsw ();
-    }
-    else if (strcmp (action, "switch") == 0)
-    {
-        HTTP_Switch::action_switch ();
-    }
-    else if (strcmp (action, "setsig") == 0)
-    {
-        HTTP_Signal::action_setsig ();
-    }
-    else if (strcmp (action, "sig") == 0)
-    {
-        HTTP_Signal::action_sig ();
-    }
-    else if (strcmp (action, "rrset") == 0)
-    {
-        HTTP_Railroad::action_rrset ();
-    }
-    else if (strcmp (action, "setcondmapesu") == 0)
-    {
-        HTTP_POMMAP::action_setcondmapesu ();
-    }
-    else if (strcmp (action, "setoutputmapesu") == 0)
-    {
-        HTTP_POMMAP::action_setoutputmapesu ();
-    }
-    else if (strcmp (action, "setoutputmaplenz") == 0)
-    {
-        HTTP_POMMAP::action_setoutputmaplenz ();
-    }
-    else if (strcmp (action, "setoutputmapzimo") == 0)
+
+    return key;
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * action_cache_lookup () - search valid response for key, returns index or -1
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+action_cache_lookup (const String& key)
+{
+    int     idx;
+
+    for (idx = 0; idx < MAX_ACTION_CACHE_ENTRIES; idx++)
     {
-        HTTP_POMMAP::action_setoutputmapzimo ();
+        if (action_cache[idx].valid && action_cache[idx].state_version == FM22::state_version && action_cache[idx].key == key)
+        {
+            action_cache[idx].last_used = ++action_cache_clock;
+            return idx;
+        }
     }
-    else if (strcmp (action, "setoutputmaptams") == 0)
+
+    return -1;
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * action_cache_store () - store response, replace outdated or least recently used entry
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+action_cache_store (const String& key, const String& response)
+{
+    int     slot = 0;
+    int     idx;
+
+    for (idx = 0; idx < MAX_ACTION_CACHE_ENTRIES; idx++)
     {
-        HTTP_POMMAP::action_setoutputmaptams ();
+        if (! action_cache[idx].valid || action_cache[idx].state_version != FM22::state_version || action_cache[idx].key == key)
+        {
+            slot = idx;
+            break;
+        }
+
+        if (action_cache[idx].last_used < action_cache[slot].last_used)
+        {
+            slot = idx;
+        }
     }
-    else if (strcmp (action, "savemapesu") == 0)
+
+    action_cache[slot].key              = key;
+    action_cache[slot].response         = response;
+    action_cache[slot].state_version    = FM22::state_version;
+    action_cache[slot].last_used        = ++action_cache_clock;
+    action_cache[slot].valid            = true;
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * handler tables: pages and actions are registered by the modules with HTTP::add_page() and HTTP::add_action(), see init() of
+ * each http-xxx.cc module. Lookup uses open addressing with a FNV-1a hash of the name.
+ * The tables are filled at runtime on purpose: a constexpr table would need one central list of all handlers in this file,
+ * which is exactly what the per-module registration avoids. They are filled once in HTTP::init() before the listen port
+ * is opened and are never changed afterwards, so the hot path only pays the hash and a short probe, as with a static table.
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+    const char *    name;
+    void            (* func) (void);
+    const char *    content_type;                                   // pages only
+    uint_fast8_t    flags;
+    uint_fast16_t   metrics_idx;                                    // actions only, see Metrics::add_http_action()
+} HANDLERENTRY;
+
+static HANDLERENTRY page_table[HANDLER_TABLE_SIZE];
+static HANDLERENTRY action_table[HANDLER_TABLE_SIZE];
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * handler_hash () - FNV-1a hash of name
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static uint32_t
+handler_hash (const char * name)
+{
+    uint32_t    hash = 2166136261U;
+
+    while (*name)
     {
-        HTTP_POMMAP::action_savemapesu ();
+        hash ^= (uint8_t) *name++;
+        hash *= 16777619U;
     }
-    else if (strcmp (action, "savemaplenz") == 0)
+
+    return hash;
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * handler_lookup () - find entry of name, returns NULL if not found
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static HANDLERENTRY *
+handler_lookup (HANDLERENTRY * table, const char * name)
+{
+    uint_fast16_t   idx = handler_hash (name) & (HANDLER_TABLE_SIZE - 1);
+    uint_fast16_t   n;
+
+    for (n = 0; n < HANDLER_TABLE_SIZE && table[idx].name; n++)
     {
-        HTTP_POMMAP::action_savemaplenz ();
+        if (! strcmp (table[idx].name, name))
+        {
+            return &table[idx];
+        }
+
+        idx = (idx + 1) & (HANDLER_TABLE_SIZE - 1);
     }
-    else if (strcmp (action, "savemapzimo") == 0)
+
+    return (HANDLERENTRY *) NULL;
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * handler_insert () - insert or replace entry, returns NULL if table is full
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static HANDLERENTRY *
+handler_insert (HANDLERENTRY * table, const char * name, void (* func) (void), const char * content_type, uint_fast8_t flags)
+{
+    uint_fast16_t   idx = handler_hash (name) & (HANDLER_TABLE_SIZE - 1);
+    uint_fast16_t   n;
+
+    for (n = 0; n < HANDLER_TABLE_SIZE; n++)
     {
-        HTTP_POMMAP::action_savemapzimo ();
+        if (! table[idx].name || ! strcmp (table[idx].name, name))
+        {
+            table[idx].name         = name;
+            table[idx].func         = func;
+            table[idx].content_type = content_type;
+            table[idx].flags        = flags;
+            table[idx].metrics_idx  = 0xFFFF;
+            return &table[idx];
+        }
+
+        idx = (idx + 1) & (HANDLER_TABLE_SIZE - 1);
     }
-    else if (strcmp (action, "savemaptams") == 0)
+
+    Debug::printf (DEBUG_LEVEL_NONE, "Internal error: handler table full, cannot register '%s'\n", name);
+    return (HANDLERENTRY *) NULL;
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * HTTP::add_page () - register HTML page
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP::add_page (const char * url, void (* func) (void))
+{
+    (void) handler_insert (page_table, url, func, "text/html", 0);
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * HTTP::add_page () - register page with other content type, flags: HTTP_PAGE_FLAG_xxx
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP::add_page (const char * url, void (* func) (void), const char * content_type, uint_fast8_t flags)
+{
+    (void) handler_insert (page_table, url, func, content_type, flags);
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * HTTP::add_action () - register action, flags: HTTP_ACTION_FLAG_xxx
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+HTTP::add_action (const char * action, void (* func) (void), uint_fast8_t flags)
+{
+    HANDLERENTRY *  entry = handler_insert (action_table, action, func, (const char *) NULL, flags);
+
+    if (entry)
     {
-        HTTP_POMMAP::action_savemaptams ();
+        entry->metrics_idx = Metrics::add_http_action (action);
     }
-    else if (strcmp (action, "setoutputesu") == 0)
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * handle_action ()
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+handle_action (void)
+{
+    const char *    action = HTTP::parameter ("action");
+    uint32_t        start = Metrics::micros ();
+    HANDLERENTRY *  entry;
+    String          key;
+
+    Debug::printf (DEBUG_LEVEL_VERBOSE, "handle_action: action=%s\n", action);
+
+    entry = handler_lookup (action_table, action);
+    request_is_cacheable = (entry && (entry->flags & HTTP_ACTION_FLAG_CACHEABLE));
+
+    if (request_is_cacheable)
     {
-        HTTP_POMOUT::action_setoutputesu ();
+        int cache_idx;
+
+        key         = action_cache_key ();
+        cache_idx   = action_cache_lookup (key);
+
+        if (cache_idx >= 0)
+        {
+            Debug::printf (DEBUG_LEVEL_VERBOSE, "handle_action: action=%s: cached response, state version %u\n", action, FM22::state_version);
+            http_puts (action_cache[cache_idx].response);
+            Metrics::http_action (entry->metrics_idx, Metrics::micros () - start);
+            return;
+        }
     }
-    else if (strcmp (action, "saveoutputesu") == 0)
+
+    HTTP::response = "";
+    HTTP::response.autoflush = false;                               // keep complete response for the cache
+
+    if (entry)
     {
-        HTTP_POMOUT::action_saveoutputesu ();
+        (*entry->func) ();
     }
     else
     {
@@ -1021,38 +1421,24 @@ handle_action (void)
         printf ("unknown action: %s\r\n", action);
     }
 
-    http_puts (HTTP::response);
-}
+    if (request_is_cacheable)
+    {
+        action_cache_store (key, HTTP::response.str());
+    }
 
-static void
-print_style_hide (void)
-{
-    HTTP::response += (String)
-        "button, input[type=button], input[type=submit], input[type=reset] { background-color: #EEEEEE; border: 1px solid #AAAAEE; }\r\n"
-        "button:hover, input[type=button]:hover, input[type=submit]:hover, input[type=reset] { background-color: #DDDDDD; }\r\n"
-        "@media screen and (max-width: 1000px) { .hide1000 { display:none; }}\r\n"
-        "@media screen and (max-width: 1200px) { .hide1200 { display:none; }}\r\n"
-        "@media screen and (max-width: 1800px) { .hide1800 { display:none; }}\r\n";
+    HTTP::flush ();
+    HTTP::response.autoflush = true;
+
+    if (entry)
+    {
+        Metrics::http_action (entry->metrics_idx, Metrics::micros () - start);
+    }
 }
 
 static void
 print_iframe_buttons (void)
 {
     HTTP::response += (String)
-        "<script>\r\n"
-        "function estop()"
-        "{"
-        "  var http = new XMLHttpRequest(); http.open ('GET', '/action?action=estop'); http.send (null);"
-        "  document.getElementById('estop').style.color = 'white';"
-        "  document.getElementById('estop').style.backgroundColor = 'red';"
-        "  setTimeout(function()"
-        "  {"
-        "    document.getElementById('estop').style.color = '';"
-        "    document.getElementById('estop').style.backgroundColor = '';"
-        "  }, 500);"
-        "}\r\n"
-        "window.onkeyup = function (event) { if (event.keyCode == 27) { estop(); }}\r\n"
-        "</script>\r\n"
         "<button class='estop' id='estop' onclick='estop()'>STOP</font></button><BR>\r\n"
         "<button onclick=\"window.location.href='/';\">1</button>\r\n"
         "<button class='hide1200' onclick=\"window.location.href='/2';\">2</button>\r\n"
@@ -1070,7 +1456,9 @@ print_iframe_x_header_pre (void)
         "<head>\r\n"
         "<meta charset='UTF-8'>"
         "<title>DCC FM22</title>\r\n"
-        "<meta name='viewport' content='width=device-width,initial-scale=1'/>\r\n";
+        "<meta name='viewport' content='width=device-width,initial-scale=1'/>\r\n"
+        "<link rel='stylesheet' href='" + HTTP::static_url ("/fm22.css") + "'>\r\n"
+        "<script src='" + HTTP::static_url ("/fm22.js") + "'></script>\r\n";
 }
 
 static void
@@ -1093,10 +1481,6 @@ handle_iframe2 (void)
         "div { height:100%; width:100%; }"
         "span { display:inline-block; width:50%; }"
         "iframe { height:96vh; width:100%; border: 1px dotted gray; }"
-        ".estop { width:100%; height:32px; color:red; }\r\n"
-        ".estop:hover { color:white; background-color:red; }\r\n";
-    print_style_hide ();
-    HTTP::response += (String)
         "</style>\r\n";
     print_iframe_x_header_post ();
     print_iframe_buttons ();
@@ -1121,10 +1505,6 @@ handle_iframe3 (void)
         "div { height:100%; width:100%; }"
         "span { display:inline-block; width:33%; }"
         "iframe { height:96vh; width:100%; border: 1px dotted gray; }"
-        ".estop { width:100%; height:32px; color:red; }\r\n"
-        ".estop:hover { color:white; background-color:red; }\r\n";
-    print_style_hide ();
-    HTTP::response += (String)
         "</style>\r\n";
     print_iframe_x_header_post ();
     print_iframe_buttons ();
@@ -1149,10 +1529,6 @@ handle_iframe4 (void)
         "div { height:50%; width:100%; }"
         "span { display:inline-block; width:50%; }"
         "iframe { height:48vh; width:100%; border: 1px dotted gray; }"
-        ".estop { width:100%; height:32px; color:red; }\r\n"
-        ".estop:hover { color:white; background-color:red; }\r\n";
-    print_style_hide ();
-    HTTP::response += (String)
         "</style>\r\n";
     print_iframe_x_header_post ();
     print_iframe_buttons ();
@@ -1178,10 +1554,6 @@ handle_iframe6 (void)
         "div { height:50%; width:100%; }"
         "span { display:inline-block; width:33%; }"
         "iframe { height:48vh; width:100%; border: 1px dotted gray; }"
-        ".estop { width:100%; height:32px; color:red; }\r\n"
-        ".estop:hover { color:white; background-color:red; }\r\n";
-    print_style_hide ();
-    HTTP::response += (String)
         "</style>\r\n";
     print_iframe_x_header_post ();
     print_iframe_buttons ();
@@ -1215,50 +1587,6 @@ handle_nothing (void)
     HTTP_Common::html_trailer ();
 }
 
-typedef struct
-{
-    const char *    url;
-    void            (* func) (void);
-} PAGEENTRY;
-
-static PAGEENTRY    pageentry[] =
-{
-    { "/",          HTTP_Loco::handle_loco              },
-    { "/loco",      HTTP_Loco::handle_loco              },
-    { "/addon",     HTTP_AddOn::handle_addon            },
-    { "/led",       HTTP_Led::handle_led                },
-    { "/switch",    HTTP_Switch::handle_switch          },
-    { "/rr",        HTTP_Railroad::handle_rr            },
-    { "/rredit",    HTTP_Railroad::handle_rr_edit       },
-    { "/sig",       HTTP_Signal::handle_sig             },
-    { "/s88",       HTTP_S88::handle_s88,               },
-    { "/s88edit",   HTTP_S88::handle_s88_edit           },
-    { "/lmedit",    HTTP_Loco::handle_loco_macro_edit   },
-    { "/rcl",       HTTP_RCL::handle_rcl                },
-    { "/rcledit",   HTTP_RCL::handle_rcl_edit           },
-    { "/test",      HTTP_Test::handle_test              },
-    { "/pgminfo",   HTTP_PGM::handle_pgminfo            },
-    { "/pgmaddr",   HTTP_PGM::handle_pgmaddr            },
-    { "/pgmcv",     HTTP_PGM::handle_pgmcv              },
-    { "/pominfo",   HTTP_POM::handle_pominfo            },
-    { "/pomaddr",   HTTP_POM::handle_pomaddr            },
-    { "/pomcv",     HTTP_POM::handle_pomcv              },
-    { "/pommot",    HTTP_POMMOT::handle_pommot          },
-    { "/pommap",    HTTP_POMMAP::handle_pommap          },
-    { "/pomout",    HTTP_POMOUT::handle_pomout          },
-    { "/info",      HTTP_Common::handle_info            },
-    { "/setup",     HTTP_Common::handle_setup           },
-    { "/net",       handle_net                          },
-    { "/upl",       handle_upl                          },
-    { "/flash",     handle_flash                        },
-    { "/doupload",  handle_doupload                     },
-    { "/action",    handle_action                       },
-    { "/2",         handle_iframe2                      },
-    { "/3",         handle_iframe3                      },
-    { "/4",         handle_iframe4                      },
-    { "/6",         handle_iframe6                      }
-};
-
 /*----------------------------------------------------------------------------------------------------------------------------------------
  * http_page ()
  *----------------------------------------------------------------------------------------------------------------------------------------
@@ -1266,24 +1594,117 @@ static PAGEENTRY    pageentry[] =
 static void
 http_page (void)
 {
-    uint_fast16_t   npages = sizeof (pageentry) / sizeof (PAGEENTRY);
-    uint_fast16_t   idx;
+    HANDLERENTRY *  entry = handler_lookup (page_table, request_file);
 
-    for (idx = 0; idx < npages; idx++)
+    if (entry)
     {
-        if (! strcmp (request_file, pageentry[idx].url))
+        if (entry->flags & HTTP_PAGE_FLAG_READONLY)
         {
-            (*pageentry[idx].func) ();
-            break;
+            request_is_cacheable = true;
         }
-    }
 
-    if (idx == npages)
+        http_header (entry->content_type);
+        (*entry->func) ();
+    }
+    else
     {
+        http_header ("text/html");
         handle_nothing ();
     }
 }
 
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * http_request_header () - copy value of request header, empty string if not found
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+http_request_header (const char * name, char * value, size_t size)
+{
+    char *  p = strcasestr (request_buf, name);
+    size_t  len = 0;
+
+    if (p)
+    {
+        p += strlen (name);
+
+        while (*p && *p != '\r' && *p != '\n' && len < size - 1)
+        {
+            value[len++] = *p++;
+        }
+    }
+
+    value[len] = '\0';
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * http_accepts_coding () - check if content coding is acceptable, list is the value of Accept-Encoding
+ *
+ * Example: "gzip;q=0, deflate" accepts deflate only. A coding with q=0 is refused, "*" matches all codings not listed.
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+http_accepts_coding (const char * list, const char * coding)
+{
+    size_t          coding_len  = strlen (coding);
+    int             wildcard    = -1;                                   // -1: no "*", 0: "*;q=0", 1: "*" accepted
+    const char *    p           = list;
+
+    while (*p)
+    {
+        const char *    name;
+        size_t          name_len;
+        bool            accepted = true;
+
+        while (*p == ' ' || *p == '\t' || *p == ',')
+        {
+            p++;
+        }
+
+        name = p;
+
+        while (*p && *p != ',' && *p != ';' && *p != ' ' && *p != '\t')
+        {
+            p++;
+        }
+
+        name_len = p - name;
+
+        while (*p && *p != ',')                                         // parameters, only q is interpreted
+        {
+            if (*p == ';')
+            {
+                p++;
+
+                while (*p == ' ' || *p == '\t')
+                {
+                    p++;
+                }
+
+                if ((*p == 'q' || *p == 'Q') && *(p + 1) == '=')
+                {
+                    accepted = (strtod (p + 2, (char **) NULL) > 0.0);
+                }
+            }
+            else
+            {
+                p++;
+            }
+        }
+
+        if (name_len == coding_len && ! strncasecmp (name, coding, coding_len))
+        {
+            return accepted;
+        }
+
+        if (name_len == 1 && *name == '*')
+        {
+            wildcard = accepted ? 1 : 0;
+        }
+    }
+
+    return (wildcard == 1);
+}
+
 /*----------------------------------------------------------------------------------------------------------------------------------------
  * http_exec ()
  *----------------------------------------------------------------------------------------------------------------------------------------
@@ -1295,6 +1716,9 @@ http_exec (void)
     int     in_par_value    = 0;
     int     par_idx         = -1;
     int     offset          = 0;
+    int     post_len        = 0;
+    int     post_n          = 0;
+    char    upload_crc[16];
     int     method;
     int     rtc;
 
@@ -1307,6 +1731,24 @@ http_exec (void)
 
     if (rtc > 0)
     {
+        char    encoding[128];
+
+        http_request_header ("If-None-Match: ", if_none_match, sizeof (if_none_match));
+        http_request_header ("Accept-Encoding: ", encoding, sizeof (encoding));
+
+        if (http_accepts_coding (encoding, "gzip"))
+        {
+            accept_encoding = ENCODING_GZIP;
+        }
+        else if (http_accepts_coding (encoding, "deflate"))
+        {
+            accept_encoding = ENCODING_DEFLATE;
+        }
+        else
+        {
+            accept_encoding = ENCODING_NONE;
+        }
+
         method = METHOD_NONE;
 
         if (! strncmp (request_buf, "GET ", 4))
@@ -1317,7 +1759,6 @@ http_exec (void)
         else if (! strncmp (request_buf, "POST ", 5))
         {
             char *  p;
-            int     len = 0;
 
             Debug::printf (DEBUG_LEVEL_VERBOSE, "http_exec: post: request_buf:\n%s\n", request_buf);
 
@@ -1325,9 +1766,11 @@ http_exec (void)
 
             if (p)
             {
-                len = atoi (p + 16);
+                post_len = atoi (p + 16);
             }
 
+            http_request_header ("X-Upload-CRC32: ", upload_crc, sizeof (upload_crc));   // optional checksum of upload
+
             boundary = strcasestr (request_buf, "Content-Type: multipart/form-data; boundary=");
 
             if (boundary)
@@ -1366,11 +1809,16 @@ http_exec (void)
 
             offset = 5;
 
-            http_post (len);
+            if (method == METHOD_POST)
+            {
+                post_n = http_post (post_len);
+            }
         }
 
         if (method == METHOD_GET || method == METHOD_POST)
         {
+            Recorder::http_request (request_buf, rtc, post_buf, post_n > 0 ? post_n : 0);      // request_buf is modified below
+
             char * p = request_buf + offset;
 
             request_file = p;
@@ -1473,9 +1921,8 @@ http_exec (void)
                 p++;
             }
         }
-        else if (method == METHOD_POST_MULTI)
+        else if (method == METHOD_POST_MULTI)                           // content is not read here, see HTTP_Upload
         {
-            Debug::printf (DEBUG_LEVEL_VERBOSE, "http_exec: post_buf:\n%s\n", post_buf);
             char * p = request_buf + offset;
             request_file = p;
             p = strchr (request_file, ' ');
@@ -1483,20 +1930,6 @@ http_exec (void)
             if (p)
             {
                 *p = '\0';
-
-                p = strstr (post_buf, "\r\n\r\n");
-
-                if (p)
-                {
-                    *p = '\0';
-                    p += 4;
-                    request_parameter_name[0] = post_buf;
-                    request_parameter_value[0] = p;
-                    par_idx = 0;
-
-                    Debug::printf (DEBUG_LEVEL_VERBOSE, "http_exec: request_parameter_name[0]:\n%s\n", request_parameter_name[0]);
-                    Debug::printf (DEBUG_LEVEL_VERBOSE, "http_exec: request_parameter_value[0]:\n%s\n", request_parameter_value[0]);
-                }
             }
             else
             {
@@ -1520,8 +1953,27 @@ http_exec (void)
                 }
             }
 
-            http_header ();
-            http_page ();
+            if (method == METHOD_POST_MULTI && ! strcmp (request_file, "/doupload"))
+            {
+                if (HTTP_Upload::start (http_fd, boundary, post_len, upload_crc))
+                {
+                    upload_accept_encoding = accept_encoding;
+                    return;                                                 // content is received in next calls of HTTP::server()
+                }
+            }
+
+            request_is_cacheable = false;
+
+            if (! http_static ())
+            {
+                http_page ();
+                http_deflate_end ();
+            }
+
+            if (! request_is_cacheable)                                     // request could have changed the state
+            {
+                FM22::state_changed ();
+            }
         }
         else
         {
@@ -1539,6 +1991,68 @@ void
 HTTP::set_alert (const char * msg)
 {
     HTTP_Common::alert_msg = msg;
+    FM22::state_changed ();
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * http_upload () - receive next chunk of running upload, send result page if upload is finished
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+http_upload (void)
+{
+    if (HTTP_Upload::process ())
+    {
+        http_fd         = HTTP_Upload::fd;
+        n_parameters    = 0;
+        accept_encoding = upload_accept_encoding;
+
+        http_header ("text/html");
+        handle_doupload ();
+        http_deflate_end ();
+
+        (void) close (http_fd);
+        http_fd = 0;
+        HTTP_Upload::reset ();
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------------------------------------
+ * http_replay () - execute next recorded request if it is due, the response is discarded
+ *----------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+http_replay (void)
+{
+    const char *    request;
+    uint32_t        len;
+    int             sv[2];
+
+    if (Recorder::replay_http (&request, &len))
+    {
+        if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv) == 0)
+        {
+            if (write (sv[0], request, len) == (ssize_t) len)
+            {
+                (void) close (sv[0]);                                       // request stays readable, sending fails with EPIPE
+                http_fd = sv[1];
+                http_exec ();
+                Recorder::http_done ();
+                http_fd = 0;
+            }
+            else
+            {
+                Debug::printf (DEBUG_LEVEL_NORMAL, "http_replay: request too long: %u bytes\n", len);
+                (void) close (sv[0]);
+            }
+
+            (void) close (sv[1]);
+        }
+        else
+        {
+            perror ("socketpair");
+        }
+    }
 }
 
 /*----------------------------------------------------------------------------------------------------------------------------------------
@@ -1548,14 +2062,31 @@ HTTP::set_alert (const char * msg)
 bool
 HTTP::server (bool edit)
 {
-    http_fd = accept_port (100);                    // real daemon: timeout = 100 usec = 1/10000 sec
-
     HTTP_Common::edit_mode = edit;
 
+    if (HTTP_Upload::active)
+    {
+        http_upload ();
+    }
+
+    if (Recorder::replaying)
+    {
+        http_replay ();
+        return HTTP_Common::edit_mode;
+    }
+
+    http_fd = accept_port (100);                    // real daemon: timeout = 100 usec = 1/10000 sec
+
     if (http_fd > 0)
     {
         http_exec ();
-        (void) close (http_fd);
+        Recorder::http_done ();
+
+        if (! HTTP_Upload::active || HTTP_Upload::fd != http_fd)    // connection of a started upload stays open
+        {
+            (void) close (http_fd);
+        }
+
         http_fd = 0;
     }
 
@@ -1569,7 +2100,7 @@ HTTP::server (bool edit)
 void
 HTTP::send (const char * str)
 {
-    HTTP::response += (String) str;
+    HTTP::response.append (str);
 }
 
 /*----------------------------------------------------------------------------------------------------------------------------------------
@@ -1579,8 +2110,33 @@ HTTP::send (const char * str)
 void
 HTTP::flush (void)
 {
-    http_puts (HTTP::response);
-    HTTP::response = "";
+    if (! HTTP::response.empty ())
+    {
+        std::vector<struct iovec>   iov (HTTP::response.length () / HTTP_RESPONSE_CHUNK_SIZE + 1);
+        int                         iovcnt;
+        int                         idx;
+
+        iovcnt = HTTP::response.get_iovec (iov.data(), iov.size());
+
+        if (deflate_active)
+        {
+            for (idx = 0; idx < iovcnt; idx++)
+            {
+                (void) http_deflate ((char *) iov[idx].iov_base, iov[idx].iov_len, Z_NO_FLUSH);
+            }
+        }
+        else
+        {
+            (void) http_sendv (iov.data(), iovcnt, 0);
+        }
+
+        HTTP::response.clear ();
+    }
+
+    if (deflate_active)                                             // send compressed data now, e.g. progress of STM32 flashing
+    {
+        (void) http_deflate ("", 0, Z_SYNC_FLUSH);
+    }
 }
 
 /*----------------------------------------------------------------------------------------------------------------------------------------
@@ -1593,6 +2149,35 @@ HTTP::init (void)
     int listen_port = 9999;
     
     signal (SIGPIPE, SIG_IGN);
+    http_static_init ();
+
+    HTTP::add_page ("/net",         handle_net);
+    HTTP::add_page ("/upl",         handle_upl);
+    HTTP::add_page ("/flash",       handle_flash);
+    HTTP::add_page ("/doupload",    handle_doupload);
+    HTTP::add_page ("/action",      handle_action);
+    HTTP::add_page ("/2",           handle_iframe2);
+    HTTP::add_page ("/3",           handle_iframe3);
+    HTTP::add_page ("/4",           handle_iframe4);
+    HTTP::add_page ("/6",           handle_iframe6);
+
+    HTTP_Common::init ();
+    HTTP_Loco::init ();
+    HTTP_AddOn::init ();
+    HTTP_Led::init ();
+    HTTP_Switch::init ();
+    HTTP_Railroad::init ();
+    HTTP_Signal::init ();
+    HTTP_S88::init ();
+    HTTP_RCL::init ();
+    HTTP_Test::init ();
+    HTTP_PGM::init ();
+    HTTP_POM::init ();
+    HTTP_POMMOT::init ();
+    HTTP_POMMAP::init ();
+    HTTP_POMOUT::init ();
+    HTTP_API::init ();
+    HTTP_Metrics::init ();
 
     if (bind_listen_port (listen_port) < 0)
     {
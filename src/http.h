@@ -21,13 +21,17 @@
 #define HTTP_H
 
 #include <string>
+#include "http-response.h"
 
 typedef std::string                         String;
 
+#define HTTP_ACTION_FLAG_CACHEABLE                  0x01            // read-only action, response may be cached, see FM22::state_version
+#define HTTP_PAGE_FLAG_READONLY                     0x01            // page doesn't change the state
+
 class HTTP
 {
     public:
-        static String           response;
+        static HTTP_Response    response;
 
         static const char *     parameter (const char * name);
         static const char *     parameter (String sname);
@@ -38,6 +42,10 @@ class HTTP
         static void             deinit (void);
         static void             send (const char * str);
         static void             flush (void);
+        static String           static_url (const char * url);
+        static void             add_page (const char * url, void (* func) (void));
+        static void             add_page (const char * url, void (* func) (void), const char * content_type, uint_fast8_t flags);
+        static void             add_action (const char * action, void (* func) (void), uint_fast8_t flags);
         static bool             server (bool);
 };
 
@@ -0,0 +1,362 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * interlock.cc - route interlocking
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+
+#include "interlock.h"
+#include "railroad.h"
+#include "switch.h"
+#include "s88.h"
+#include "debug.h"
+
+bool                    Interlocking::valid = false;                                // flag: conflict matrix is up to date
+uint_fast16_t           Interlocking::n_railroads;                                  // number of railroads of all groups
+uint_fast16_t           Interlocking::n_words;                                      // number of words of a bitset
+std::vector<uint16_t>   Interlocking::rr_base;                                      // rrgidx -> index of first railroad
+std::vector<uint8_t>    Interlocking::rr_group;                                     // railroad index -> rrgidx
+std::vector<uint64_t>   Interlocking::conflicts;                                    // conflict matrix, n_railroads rows of n_words
+std::vector<uint64_t>   Interlocking::active;                                       // bitset: active railroads
+std::vector<uint64_t>   Interlocking::locked;                                       // bitset: railroads locked by a train
+INTERLOCKING_STATS      Interlocking::stats;                                        // statistics
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * All railroads of all railroad groups are numbered consecutively. Two railroads conflict if they belong to the same
+ * railroad group or if they share a switch with different states. The conflict matrix holds one bitset per railroad,
+ * so a route request is checked by AND-ing its row with the bitset of locked railroads.
+ *
+ * A railroad is locked if it was activated for a loco and has a S88 contact which releases it when the loco arrives.
+ * Conflicting active railroads which are not locked are dropped when a route is granted. S88 contact actions request
+ * railroads for the loco located on or linked to the railroad of the contact, so their routes are locked as well.
+ * A request without loco is refused if the railroad is occupied by any train.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * set_bit () - set or reset bit in bitset
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Interlocking::set_bit (std::vector<uint64_t>& bits, uint_fast16_t idx, bool value)
+{
+    if (value)
+    {
+        bits[idx / 64] |= 1ULL << (idx % 64);
+    }
+    else
+    {
+        bits[idx / 64] &= ~(1ULL << (idx % 64));
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * build () - build conflict matrix and runtime bitsets
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Interlocking::build (void)
+{
+    uint_fast8_t                                n_railroad_groups   = RailroadGroups::get_n_railroad_groups ();
+    uint_fast16_t                               n_switches          = Switches::get_n_switches ();
+    std::vector<std::vector<uint32_t>>          switch_users (n_switches);
+    uint_fast8_t                                rrgidx;
+    uint_fast8_t                                rridx;
+    uint_fast16_t                               idx;
+    uint_fast16_t                               idx2;
+
+    Interlocking::rr_base.resize (n_railroad_groups);
+    Interlocking::rr_group.clear ();
+
+    for (rrgidx = 0; rrgidx < n_railroad_groups; rrgidx++)
+    {
+        Interlocking::rr_base[rrgidx] = Interlocking::rr_group.size ();
+        Interlocking::rr_group.insert (Interlocking::rr_group.end (), RailroadGroups::railroad_groups[rrgidx].get_n_railroads (), rrgidx);
+    }
+
+    Interlocking::n_railroads   = Interlocking::rr_group.size ();
+    Interlocking::n_words       = (Interlocking::n_railroads + 63) / 64;
+    Interlocking::conflicts.assign (Interlocking::n_railroads * Interlocking::n_words, 0);
+    Interlocking::active.assign (Interlocking::n_words, 0);
+    Interlocking::locked.assign (Interlocking::n_words, 0);
+
+    for (rrgidx = 0; rrgidx < n_railroad_groups; rrgidx++)
+    {
+        RailroadGroup * rrg         = &RailroadGroups::railroad_groups[rrgidx];
+        uint_fast8_t    n_railroads = rrg->get_n_railroads ();
+        uint_fast16_t   base        = Interlocking::rr_base[rrgidx];
+        uint_fast8_t    active_rridx;
+
+        for (rridx = 0; rridx < n_railroads; rridx++)
+        {
+            Railroad *      rr          = &(rrg->railroads[rridx]);
+            uint_fast8_t    n_sub       = rr->get_n_switches ();
+            uint_fast8_t    subidx;
+            uint_fast8_t    rridx2;
+
+            idx = base + rridx;
+
+            for (rridx2 = 0; rridx2 < n_railroads; rridx2++)                        // railroads of a group are alternatives
+            {
+                if (rridx2 != rridx)
+                {
+                    Interlocking::conflicts[idx * Interlocking::n_words + (base + rridx2) / 64] |= 1ULL << ((base + rridx2) % 64);
+                }
+            }
+
+            for (subidx = 0; subidx < n_sub; subidx++)
+            {
+                uint_fast16_t   swidx = rr->get_switch_idx (subidx);
+
+                if (swidx < n_switches)
+                {
+                    switch_users[swidx].push_back ((idx << 8) | rr->get_switch_state (subidx));
+                }
+            }
+        }
+
+        active_rridx = rrg->get_active_railroad ();
+
+        if (active_rridx < n_railroads)
+        {
+            uint_fast16_t   loco_idx = rrg->railroads[active_rridx].get_active_loco ();
+
+            Interlocking::set_bit (Interlocking::active, base + active_rridx, true);
+
+            if (loco_idx != 0xFFFF && S88::has_railroad_contact (rrgidx, active_rridx))
+            {
+                Interlocking::set_bit (Interlocking::locked, base + active_rridx, true);
+            }
+        }
+    }
+
+    for (const std::vector<uint32_t>& users : switch_users)                     // different states of same switch
+    {
+        uint_fast16_t   n_users = users.size ();
+        uint_fast16_t   uidx;
+        uint_fast16_t   uidx2;
+
+        for (uidx = 0; uidx < n_users; uidx++)
+        {
+            for (uidx2 = uidx + 1; uidx2 < n_users; uidx2++)
+            {
+                if ((users[uidx] & 0xFF) != (users[uidx2] & 0xFF))
+                {
+                    idx     = users[uidx] >> 8;
+                    idx2    = users[uidx2] >> 8;
+
+                    Interlocking::conflicts[idx * Interlocking::n_words + idx2 / 64] |= 1ULL << (idx2 % 64);
+                    Interlocking::conflicts[idx2 * Interlocking::n_words + idx / 64] |= 1ULL << (idx % 64);
+                }
+            }
+        }
+    }
+
+    Interlocking::stats.n_builds++;
+    Interlocking::valid = true;
+    Debug::printf (DEBUG_LEVEL_VERBOSE, "Interlocking::build: %u railroads\n", (unsigned int) Interlocking::n_railroads);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * invalidate () - configuration of railroads or switches changed, rebuild conflict matrix on next request
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Interlocking::invalidate (void)
+{
+    Interlocking::valid = false;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * request () - check if railroad may be activated for a loco
+ *
+ * Return values:
+ *   INTERLOCKING_GRANTED               railroad may be activated
+ *   INTERLOCKING_REFUSED_CONFLICT      a conflicting railroad is locked by a train
+ *   INTERLOCKING_REFUSED_OCCUPIED      railroad is occupied by another train, by any train if loco_idx is 0xFFFF
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+Interlocking::request (uint_fast8_t rrgidx, uint_fast8_t rridx, uint_fast16_t loco_idx)
+{
+    RailroadGroup *     rrg;
+    Railroad *          rr;
+    uint64_t *          row;
+    uint_fast16_t       idx;
+    uint_fast16_t       widx;
+    uint_fast16_t       located_loco_idx;
+
+    Interlocking::stats.n_requests++;
+
+    if (! Interlocking::valid)
+    {
+        Interlocking::build ();
+    }
+
+    if (rrgidx >= Interlocking::rr_base.size () || rridx >= RailroadGroups::railroad_groups[rrgidx].get_n_railroads ())
+    {
+        return INTERLOCKING_GRANTED;
+    }
+
+    rrg = &RailroadGroups::railroad_groups[rrgidx];
+    rr  = &(rrg->railroads[rridx]);
+    idx = Interlocking::rr_base[rrgidx] + rridx;
+    row = &Interlocking::conflicts[idx * Interlocking::n_words];
+
+    for (widx = 0; widx < Interlocking::n_words; widx++)
+    {
+        if (row[widx] & Interlocking::locked[widx])
+        {
+            Interlocking::stats.n_refused_conflict++;
+            return INTERLOCKING_REFUSED_CONFLICT;
+        }
+    }
+
+    if ((Interlocking::locked[idx / 64] & (1ULL << (idx % 64))) && rr->get_active_loco () != loco_idx)
+    {
+        Interlocking::stats.n_refused_conflict++;
+        return INTERLOCKING_REFUSED_CONFLICT;
+    }
+
+    located_loco_idx = rr->get_located_loco ();
+
+    if (loco_idx == 0xFFFF || located_loco_idx != loco_idx)                    // without loco every train is another one
+    {
+        if (located_loco_idx != 0xFFFF || S88::is_railroad_occupied (rrgidx, rridx))
+        {
+            Interlocking::stats.n_refused_occupied++;
+            return INTERLOCKING_REFUSED_OCCUPIED;
+        }
+    }
+
+    return INTERLOCKING_GRANTED;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * set_active () - railroad has been activated, drop conflicting railroads of other groups which are not locked
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Interlocking::set_active (uint_fast8_t rrgidx, uint_fast8_t rridx, uint_fast16_t loco_idx)
+{
+    uint_fast8_t    n_railroads;
+    uint_fast16_t   base;
+    uint_fast16_t   idx;
+    uint_fast16_t   widx;
+    uint_fast8_t    ridx;
+
+    if (! Interlocking::valid)
+    {
+        Interlocking::build ();                                                     // takes new state from railroad groups
+    }
+    else if (rrgidx < Interlocking::rr_base.size ())
+    {
+        n_railroads = RailroadGroups::railroad_groups[rrgidx].get_n_railroads ();
+        base        = Interlocking::rr_base[rrgidx];
+
+        for (ridx = 0; ridx < n_railroads; ridx++)
+        {
+            Interlocking::set_bit (Interlocking::active, base + ridx, false);
+            Interlocking::set_bit (Interlocking::locked, base + ridx, false);
+        }
+
+        if (rridx < n_railroads)
+        {
+            Interlocking::set_bit (Interlocking::active, base + rridx, true);
+
+            if (loco_idx != 0xFFFF && S88::has_railroad_contact (rrgidx, rridx))
+            {
+                Interlocking::set_bit (Interlocking::locked, base + rridx, true);
+            }
+        }
+    }
+
+    if (rrgidx >= Interlocking::rr_base.size () || rridx >= RailroadGroups::railroad_groups[rrgidx].get_n_railroads ())
+    {
+        return;
+    }
+
+    idx = Interlocking::rr_base[rrgidx] + rridx;
+
+    for (widx = 0; widx < Interlocking::n_words; widx++)
+    {
+        uint64_t    dropped = Interlocking::conflicts[idx * Interlocking::n_words + widx] & Interlocking::active[widx] & ~Interlocking::locked[widx];
+
+        while (dropped)
+        {
+            uint_fast16_t   idx2    = widx * 64 + __builtin_ctzll (dropped);
+            uint_fast8_t    rrgidx2 = Interlocking::rr_group[idx2];
+
+            dropped &= dropped - 1;
+
+            if (rrgidx2 != rrgidx)
+            {
+                Debug::printf (DEBUG_LEVEL_NORMAL, "Interlocking: railroad %u/%u dropped by railroad %u/%u\n",
+                               rrgidx2, (unsigned int) (idx2 - Interlocking::rr_base[rrgidx2]), rrgidx, rridx);
+                Interlocking::stats.n_released++;
+                RailroadGroups::railroad_groups[rrgidx2].set_active_railroad (0xFF);
+            }
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * release () - release lock of railroad, loco has arrived
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Interlocking::release (uint_fast8_t rrgidx, uint_fast8_t rridx)
+{
+    if (Interlocking::valid && rrgidx < Interlocking::rr_base.size () && rridx < RailroadGroups::railroad_groups[rrgidx].get_n_railroads ())
+    {
+        Interlocking::set_bit (Interlocking::locked, Interlocking::rr_base[rrgidx] + rridx, false);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * is_locked () - check if railroad is locked by a train
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+Interlocking::is_locked (uint_fast8_t rrgidx, uint_fast8_t rridx)
+{
+    uint_fast16_t   idx;
+
+    if (! Interlocking::valid)
+    {
+        Interlocking::build ();
+    }
+
+    if (rrgidx >= Interlocking::rr_base.size () || rridx >= RailroadGroups::railroad_groups[rrgidx].get_n_railroads ())
+    {
+        return false;
+    }
+
+    idx = Interlocking::rr_base[rrgidx] + rridx;
+    return (Interlocking::locked[idx / 64] & (1ULL << (idx % 64))) ? true : false;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_stats () - get statistics
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Interlocking::get_stats (INTERLOCKING_STATS * statsp)
+{
+    *statsp             = Interlocking::stats;
+    statsp->n_railroads = Interlocking::n_railroads;
+}
@@ -0,0 +1,65 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * interlock.h - route interlocking
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef INTERLOCK_H
+#define INTERLOCK_H
+
+#include <stdint.h>
+#include <vector>
+
+#define INTERLOCKING_GRANTED                0
+#define INTERLOCKING_REFUSED_CONFLICT       1                                   // conflicting route is locked by a train
+#define INTERLOCKING_REFUSED_OCCUPIED       2                                   // target railroad is occupied
+
+typedef struct
+{
+    uint32_t            n_requests;                                             // number of route requests
+    uint32_t            n_refused_conflict;                                     // refused: conflicting route locked
+    uint32_t            n_refused_occupied;                                     // refused: railroad occupied
+    uint32_t            n_released;                                             // unlocked routes dropped by a conflicting route
+    uint32_t            n_builds;                                               // number of builds of conflict matrix
+    uint32_t            n_railroads;                                            // number of railroads in conflict matrix
+} INTERLOCKING_STATS;
+
+class Interlocking
+{
+    public:
+        static void                     invalidate (void);
+        static uint_fast8_t             request (uint_fast8_t rrgidx, uint_fast8_t rridx, uint_fast16_t loco_idx);
+        static void                     set_active (uint_fast8_t rrgidx, uint_fast8_t rridx, uint_fast16_t loco_idx);
+        static void                     release (uint_fast8_t rrgidx, uint_fast8_t rridx);
+        static bool                     is_locked (uint_fast8_t rrgidx, uint_fast8_t rridx);
+        static void                     get_stats (INTERLOCKING_STATS * statsp);
+
+    private:
+        static bool                     valid;                                  // flag: conflict matrix is up to date
+        static uint_fast16_t            n_railroads;                            // number of railroads of all groups
+        static uint_fast16_t            n_words;                                // number of words of a bitset
+        static std::vector<uint16_t>    rr_base;                                // rrgidx -> index of first railroad
+        static std::vector<uint8_t>     rr_group;                               // railroad index -> rrgidx
+        static std::vector<uint64_t>    conflicts;                              // conflict matrix, n_railroads rows of n_words
+        static std::vector<uint64_t>    active;                                 // bitset: active railroads
+        static std::vector<uint64_t>    locked;                                 // bitset: railroads locked by a train
+        static INTERLOCKING_STATS       stats;                                  // statistics
+
+        static void                     build (void);
+        static void                     set_bit (std::vector<uint64_t>& bits, uint_fast16_t idx, bool value);
+};
+
+#endif
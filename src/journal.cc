@@ -0,0 +1,537 @@
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * journal.cc - runtime state journal for warm restart and crash recovery
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <vector>
+#include "dcc.h"
+#include "loco.h"
+#include "addon.h"
+#include "switch.h"
+#include "sig.h"
+#include "led.h"
+#include "railroad.h"
+#include "rcl.h"
+#include "event.h"
+#include "millis.h"
+#include "debug.h"
+#include "journal.h"
+
+#define JOURNAL_TMP_FILE            JOURNAL_FILE ".tmp"
+#define JOURNAL_MAX_ENTRIES         ((JOURNAL_SIZE - sizeof (JOURNAL_HEADER)) / sizeof (JOURNAL_ENTRY))
+
+static int                          journal_fd      = -1;
+static JOURNAL_HEADER *             journal_hdr;                        // NULL: journal not available
+static JOURNAL_ENTRY *              journal_entries;
+static uint32_t                     journal_pos;                        // index of next entry
+static bool                         journal_compacting;
+static std::vector<JOURNAL_ENTRY>   shadows[JOURNAL_N_TYPES];           // last journaled aux & value per type and idx
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * journal_map () - map journal file
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static JOURNAL_HEADER *
+journal_map (int fd)
+{
+    void *  p;
+
+    p = mmap (NULL, JOURNAL_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (p == MAP_FAILED)
+    {
+        return (JOURNAL_HEADER *) NULL;
+    }
+
+    return (JOURNAL_HEADER *) p;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * journal_unmap () - unmap and close journal file
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+journal_unmap (void)
+{
+    if (journal_hdr)
+    {
+        msync (journal_hdr, JOURNAL_SIZE, MS_ASYNC);
+        munmap (journal_hdr, JOURNAL_SIZE);
+        journal_hdr     = (JOURNAL_HEADER *) NULL;
+        journal_entries = (JOURNAL_ENTRY *) NULL;
+    }
+
+    if (journal_fd >= 0)
+    {
+        close (journal_fd);
+        journal_fd = -1;
+    }
+}
+
+static bool journal_compact (void);
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * journal_put () - append entry if aux or value changed since last call or if do_write_all is set
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+journal_put (uint_fast8_t type, uint_fast16_t idx, uint_fast8_t aux, uint32_t value, bool do_write_all)
+{
+    JOURNAL_ENTRY * sp;
+
+    if (! journal_entries)                                              // compaction failed, journal not available
+    {
+        return;
+    }
+
+    sp = &(shadows[type][idx]);
+
+    if (do_write_all || sp->aux != aux || sp->value != value)
+    {
+        if (journal_pos >= JOURNAL_MAX_ENTRIES)
+        {
+            if (! journal_compacting)
+            {
+                (void) journal_compact ();                              // compaction writes current state of all objects
+            }
+            return;
+        }
+
+        JOURNAL_ENTRY * ep = journal_entries + journal_pos;
+
+        ep->aux     = aux;
+        ep->idx     = idx;
+        ep->value   = value;
+        __atomic_store_n (&(ep->type), type, __ATOMIC_RELEASE);         // type != 0 marks a valid entry
+        journal_pos++;
+
+        sp->aux     = aux;
+        sp->value   = value;
+    }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * journal_record () - append changed runtime state, or the state of all objects if do_write_all is set
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+journal_record (bool do_write_all)
+{
+    uint_fast16_t   n_locos             = Locos::get_n_locos ();
+    uint_fast16_t   n_addons            = AddOns::get_n_addons ();
+    uint_fast16_t   n_switches          = Switches::get_n_switches ();
+    uint_fast16_t   n_signals           = Signals::get_n_signals ();
+    uint_fast16_t   n_led_groups        = Leds::get_n_led_groups ();
+    uint_fast8_t    n_railroad_groups   = RailroadGroups::get_n_railroad_groups ();
+    uint_fast16_t   idx;
+
+    if (n_locos != journal_hdr->n_locos || n_addons != journal_hdr->n_addons || n_switches != journal_hdr->n_switches ||
+        n_signals != journal_hdr->n_signals || n_led_groups != journal_hdr->n_led_groups ||
+        n_railroad_groups != journal_hdr->n_railroad_groups)
+    {
+        if (! journal_compacting)
+        {
+            (void) journal_compact ();                                  // configuration changed, indexes are not valid anymore
+        }
+        return;
+    }
+
+    for (idx = 0; idx < n_locos; idx++)
+    {
+        Loco *  lp = &(Locos::locos[idx]);
+        uint_fast8_t aux = lp->get_fwd () | (lp->is_active () ? 0x02 : 0x00);
+
+        journal_put (JOURNAL_TYPE_LOCO_SPEED, idx, aux, lp->get_speed (), do_write_all);
+        journal_put (JOURNAL_TYPE_LOCO_FUNCTIONS, idx, 0, lp->get_functions (), do_write_all);
+        journal_put (JOURNAL_TYPE_LOCO_LOCATION, idx, lp->get_rcllocation (), (lp->get_rrlocation () << 8) | lp->get_destination (), do_write_all);
+    }
+
+    for (idx = 0; idx < n_addons; idx++)
+    {
+        journal_put (JOURNAL_TYPE_ADDON, idx, AddOns::addons[idx].is_active () ? 1 : 0, AddOns::addons[idx].get_functions (), do_write_all);
+    }
+
+    for (idx = 0; idx < n_switches; idx++)
+    {
+        journal_put (JOURNAL_TYPE_SWITCH, idx, 0, Switches::switches[idx].get_state (), do_write_all);
+    }
+
+    for (idx = 0; idx < n_signals; idx++)
+    {
+        journal_put (JOURNAL_TYPE_SIGNAL, idx, 0, Signals::signals[idx].get_state (), do_write_all);
+    }
+
+    for (idx = 0; idx < n_led_groups; idx++)
+    {
+        journal_put (JOURNAL_TYPE_LED, idx, 0, Leds::led_groups[idx].get_state (), do_write_all);
+    }
+
+    for (idx = 0; idx < n_railroad_groups; idx++)
+    {
+        RailroadGroup * rrgp    = &(RailroadGroups::railroad_groups[idx]);
+        uint_fast8_t    rridx   = rrgp->get_active_railroad ();
+        uint32_t        value   = 0xFFFFFFFF;
+
+        if (rridx < rrgp->get_n_railroads ())
+        {
+            value = rrgp->railroads[rridx].get_active_loco () | (rrgp->railroads[rridx].get_located_loco () << 16);
+        }
+
+        journal_put (JOURNAL_TYPE_RAILROAD_GROUP, idx, rridx, value, do_write_all);
+    }
+
+    journal_put (JOURNAL_TYPE_BOOSTER, 0, 0, DCC::booster_is_on, do_write_all);
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * journal_compact () - write current state of all objects into a new journal file and replace the old one
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+journal_compact (void)
+{
+    JOURNAL_HEADER *    hdr;
+    int                 fd;
+    uint_fast8_t        type;
+
+    fd = open (JOURNAL_TMP_FILE, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "Journal: cannot create %s\n", JOURNAL_TMP_FILE);
+        journal_unmap ();
+        return false;
+    }
+
+    if (ftruncate (fd, JOURNAL_SIZE) != 0 || (hdr = journal_map (fd)) == (JOURNAL_HEADER *) NULL)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "Journal: cannot map %s\n", JOURNAL_TMP_FILE);
+        close (fd);
+        unlink (JOURNAL_TMP_FILE);
+        journal_unmap ();
+        return false;
+    }
+
+    journal_unmap ();
+
+    memcpy (hdr->magic, JOURNAL_MAGIC, sizeof (hdr->magic));
+    hdr->version            = JOURNAL_VERSION;
+    hdr->flags              = 0;
+    hdr->n_locos            = Locos::get_n_locos ();
+    hdr->n_addons           = AddOns::get_n_addons ();
+    hdr->n_switches         = Switches::get_n_switches ();
+    hdr->n_signals          = Signals::get_n_signals ();
+    hdr->n_led_groups       = Leds::get_n_led_groups ();
+    hdr->n_railroad_groups  = RailroadGroups::get_n_railroad_groups ();
+    hdr->n_events           = 0;
+
+    journal_fd      = fd;
+    journal_hdr     = hdr;
+    journal_entries = (JOURNAL_ENTRY *) (hdr + 1);
+    journal_pos     = 0;
+
+    shadows[JOURNAL_TYPE_LOCO_SPEED].resize (hdr->n_locos);
+    shadows[JOURNAL_TYPE_LOCO_FUNCTIONS].resize (hdr->n_locos);
+    shadows[JOURNAL_TYPE_LOCO_LOCATION].resize (hdr->n_locos);
+    shadows[JOURNAL_TYPE_ADDON].resize (hdr->n_addons);
+    shadows[JOURNAL_TYPE_SWITCH].resize (hdr->n_switches);
+    shadows[JOURNAL_TYPE_SIGNAL].resize (hdr->n_signals);
+    shadows[JOURNAL_TYPE_LED].resize (hdr->n_led_groups);
+    shadows[JOURNAL_TYPE_RAILROAD_GROUP].resize (hdr->n_railroad_groups);
+    shadows[JOURNAL_TYPE_BOOSTER].resize (1);
+
+    for (type = 0; type < JOURNAL_N_TYPES; type++)
+    {
+        shadows[type].shrink_to_fit ();
+    }
+
+    journal_compacting = true;
+    journal_record (true);
+    journal_compacting = false;
+
+    if (rename (JOURNAL_TMP_FILE, JOURNAL_FILE) != 0)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "Journal: cannot rename %s to %s\n", JOURNAL_TMP_FILE, JOURNAL_FILE);
+        journal_unmap ();
+        unlink (JOURNAL_TMP_FILE);
+        return false;
+    }
+
+    Debug::printf (DEBUG_LEVEL_VERBOSE, "Journal: compacted, %u entries\n", journal_pos);
+    return true;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * journal_replay () - apply entries of a journal to the objects, returns true if journal was written by a warm restart
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+journal_replay (JOURNAL_HEADER * hdr)
+{
+    JOURNAL_ENTRY *     ep          = (JOURNAL_ENTRY *) (hdr + 1);
+    uint32_t            n_entries   = 0;
+    bool                warm        = false;
+
+    if (memcmp (hdr->magic, JOURNAL_MAGIC, sizeof (hdr->magic)) != 0 || hdr->version != JOURNAL_VERSION)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "Journal: invalid journal file %s, ignored\n", JOURNAL_FILE);
+        return false;
+    }
+
+    if (hdr->n_locos != Locos::get_n_locos () || hdr->n_addons != AddOns::get_n_addons () ||
+        hdr->n_switches != Switches::get_n_switches () || hdr->n_signals != Signals::get_n_signals () ||
+        hdr->n_led_groups != Leds::get_n_led_groups () || hdr->n_railroad_groups != RailroadGroups::get_n_railroad_groups ())
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "Journal: configuration has changed, journal ignored\n");
+        return false;
+    }
+
+    if (hdr->flags & JOURNAL_FLAG_WARM_RESTART)
+    {
+        warm = true;
+    }
+
+    while (n_entries < JOURNAL_MAX_ENTRIES && ep->type != JOURNAL_TYPE_END)
+    {
+        uint_fast16_t   idx     = ep->idx;
+        uint_fast8_t    aux     = ep->aux;
+        uint32_t        value   = ep->value;
+
+        switch (ep->type)
+        {
+            case JOURNAL_TYPE_LOCO_SPEED:
+            {
+                if (idx < hdr->n_locos)
+                {
+                    Loco * lp = &(Locos::locos[idx]);
+
+                    lp->restore_state (value, aux & 0x01, lp->get_functions ());
+
+                    if (aux & 0x02)
+                    {
+                        lp->activate ();
+                    }
+                    else
+                    {
+                        lp->deactivate ();
+                    }
+                }
+                break;
+            }
+
+            case JOURNAL_TYPE_LOCO_FUNCTIONS:
+            {
+                if (idx < hdr->n_locos)
+                {
+                    Loco * lp = &(Locos::locos[idx]);
+                    lp->restore_state (lp->get_speed (), lp->get_fwd (), value);
+                }
+                break;
+            }
+
+            case JOURNAL_TYPE_LOCO_LOCATION:
+            {
+                if (idx < hdr->n_locos)
+                {
+                    Loco * lp = &(Locos::locos[idx]);
+
+                    if (lp->get_rcllocation () != aux)
+                    {
+                        lp->set_rcllocation (aux);
+
+                        if (lp->get_rcllocation () != 0xFF)             // occupation is rebuilt after replay
+                        {
+                            RCL::tracks[lp->get_rcllocation ()].last_loco_idx = idx;
+                        }
+                    }
+
+                    if (lp->get_rrlocation () != (value >> 8))
+                    {
+                        lp->set_rrlocation (value >> 8);
+                    }
+
+                    lp->set_destination (value & 0xFF);
+                }
+                break;
+            }
+
+            case JOURNAL_TYPE_ADDON:
+            {
+                if (idx < hdr->n_addons)
+                {
+                    AddOns::addons[idx].restore_state (value);
+
+                    if (aux)
+                    {
+                        AddOns::addons[idx].activate ();
+                    }
+                    else
+                    {
+                        AddOns::addons[idx].deactivate ();
+                    }
+                }
+                break;
+            }
+
+            case JOURNAL_TYPE_SWITCH:
+            {
+                if (idx < hdr->n_switches)
+                {
+                    Switches::switches[idx].restore_state (value);
+                }
+                break;
+            }
+
+            case JOURNAL_TYPE_SIGNAL:
+            {
+                if (idx < hdr->n_signals)
+                {
+                    Signals::signals[idx].restore_state (value);
+                }
+                break;
+            }
+
+            case JOURNAL_TYPE_LED:
+            {
+                if (idx < hdr->n_led_groups)
+                {
+                    Leds::led_groups[idx].restore_state (value);
+                }
+                break;
+            }
+
+            case JOURNAL_TYPE_RAILROAD_GROUP:
+            {
+                if (idx < hdr->n_railroad_groups)
+                {
+                    RailroadGroups::railroad_groups[idx].restore_active_railroad (aux, value & 0xFFFF, value >> 16);
+                }
+                break;
+            }
+
+            case JOURNAL_TYPE_BOOSTER:
+            {
+                if (warm)                                               // after cold start, STM32 has been resetted: booster is off
+                {
+                    DCC::booster_is_on = value;
+                }
+                break;
+            }
+
+            default:
+            {
+                Debug::printf (DEBUG_LEVEL_NONE, "Journal: invalid entry type %u at entry %u\n", ep->type, n_entries);
+                break;
+            }
+        }
+
+        ep++;
+        n_entries++;
+    }
+
+    RCL::restore_locations ();                                          // without executing track actions again
+
+    if (warm && hdr->n_events <= EVENT_MAX_LEN)
+    {
+        Event::restore_events (hdr->events, hdr->n_events);
+    }
+
+    Debug::printf (DEBUG_LEVEL_NORMAL, "Journal: %u entries, %u events replayed, %s restart\n", n_entries, warm ? hdr->n_events : 0, warm ? "warm" : "cold");
+    return warm;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * Journal::init () - replay journal and start a new one, returns true on warm restart: STM32 is still running
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+Journal::init (void)
+{
+    struct stat         st;
+    JOURNAL_HEADER *    hdr;
+    bool                warm = false;
+    int                 fd;
+
+    fd = open (JOURNAL_FILE, O_RDWR);
+
+    if (fd >= 0)
+    {
+        if (fstat (fd, &st) == 0 && st.st_size == JOURNAL_SIZE && (hdr = journal_map (fd)) != (JOURNAL_HEADER *) NULL)
+        {
+            warm = journal_replay (hdr);
+            munmap (hdr, JOURNAL_SIZE);
+        }
+        else
+        {
+            Debug::printf (DEBUG_LEVEL_NONE, "Journal: cannot map %s, ignored\n", JOURNAL_FILE);
+        }
+
+        close (fd);
+    }
+
+    (void) journal_compact ();
+    return warm;
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * Journal::schedule () - append changes of runtime state every JOURNAL_PERIOD msec
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Journal::schedule (void)
+{
+    static unsigned long    next_millis;
+
+    if (journal_hdr)
+    {
+        unsigned long   now = Millis::elapsed ();
+
+        if (now >= next_millis)
+        {
+            next_millis = now + JOURNAL_PERIOD;
+            journal_record (false);
+        }
+    }
+}
+
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * Journal::deinit () - append last changes and close journal. On warm restart, save pending events, too.
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Journal::deinit (bool warm_restart)
+{
+    if (journal_hdr)
+    {
+        journal_record (false);
+
+        if (journal_hdr && warm_restart)                                // journal_record() may have failed to compact
+        {
+            journal_hdr->n_events = Event::save_events (journal_hdr->events, EVENT_MAX_LEN);
+            __atomic_store_n (&(journal_hdr->flags), JOURNAL_FLAG_WARM_RESTART, __ATOMIC_RELEASE);
+        }
+
+        journal_unmap ();
+    }
+}
@@ -0,0 +1,87 @@
+/*-------------------------------------------------------------------------------------------------------------------------------------------
+ * journal.h - runtime state journal for warm restart and crash recovery
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ *
+ * The journal file is memory mapped with a fixed size. Host byte order, it is only valid for this binary and configuration.
+ *
+ *   header (JOURNAL_HEADER), including pending events saved on warm restart
+ *   entries (JOURNAL_ENTRY), appended on each change of runtime state, type 0 marks the end
+ *
+ * At startup the entries are replayed, later entries overwrite earlier ones. Then the journal is compacted: a new file
+ * containing one entry per object is written and renamed. The same happens if the journal is full.
+ *-------------------------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include "event.h"
+
+#define JOURNAL_FILE                "fm22.journal"
+#define JOURNAL_MAGIC               "FM22JRNL"
+#define JOURNAL_VERSION             2                                   // increment if layout of header or entries changes
+#define JOURNAL_ENTRIES_SIZE        (256 * 1024)                        // size of entries, must hold 4 times the entries of the maximum config
+#define JOURNAL_SIZE                (sizeof (JOURNAL_HEADER) + JOURNAL_ENTRIES_SIZE)    // size of file
+#define JOURNAL_PERIOD              100                                 // check runtime state for changes every 100 msec
+
+#define JOURNAL_FLAG_WARM_RESTART   0x01                                // written by Journal::deinit() before restart
+
+#define JOURNAL_TYPE_END            0
+#define JOURNAL_TYPE_LOCO_SPEED     1                                   // aux: fwd | active << 1, value: speed
+#define JOURNAL_TYPE_LOCO_FUNCTIONS 2                                   // value: functions
+#define JOURNAL_TYPE_LOCO_LOCATION  3                                   // aux: rcl_location, value: rr_location << 8 | destination
+#define JOURNAL_TYPE_ADDON          4                                   // aux: active, value: functions
+#define JOURNAL_TYPE_SWITCH         5                                   // value: state
+#define JOURNAL_TYPE_SIGNAL         6                                   // value: state
+#define JOURNAL_TYPE_LED            7                                   // value: led mask
+#define JOURNAL_TYPE_RAILROAD_GROUP 8                                   // aux: active rridx, value: active loco_idx | located loco_idx << 16
+#define JOURNAL_TYPE_BOOSTER        9                                   // value: booster on
+#define JOURNAL_N_TYPES             10
+
+typedef struct
+{
+    char            magic[8];
+    uint32_t        version;
+    uint32_t        flags;                                              // JOURNAL_FLAG_xxx
+    uint16_t        n_locos;                                            // number of objects when journal was compacted
+    uint16_t        n_addons;
+    uint16_t        n_switches;
+    uint16_t        n_signals;
+    uint16_t        n_led_groups;
+    uint16_t        n_railroad_groups;
+    uint32_t        n_events;                                           // pending events, only valid with JOURNAL_FLAG_WARM_RESTART
+    EVENTS          events[EVENT_MAX_LEN];                              // millis relative to restart, sorted by due time
+} JOURNAL_HEADER;
+
+typedef struct
+{
+    uint8_t         type;                                               // JOURNAL_TYPE_xxx, written last
+    uint8_t         aux;
+    uint16_t        idx;
+    uint32_t        value;
+} JOURNAL_ENTRY;
+
+class Journal
+{
+    public:
+        static bool     init (void);
+        static void     schedule (void);
+        static void     deinit (bool warm_restart);
+};
+
+#endif
@@ -23,10 +23,12 @@
 #include "dcc.h"
 #include "debug.h"
 #include "led.h"
+#include "automation.h"
 
 std::vector<LedGroup>           Leds::led_groups;                       // leds
 uint_fast16_t                   Leds::n_led_groups  = 0;                // number of leds
 bool                            Leds::data_changed = false;
+DisplayOrder                    Leds::order;                            // display order
 
 /*------------------------------------------------------------------------------------------------------------------------
  * LedGroup () - constructor
@@ -137,6 +139,16 @@ LedGroup::get_state ()
     return this->current_state_mask;
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ *  LedGroup::restore_state () - restore state without sending, see Journal::init ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+LedGroup::restore_state (uint_fast8_t led_mask)
+{
+    this->current_state_mask = led_mask;
+}
+
 /*------------------------------------------------------------------------------------------------------------------------
  *  Leds::add () - add a led
  *------------------------------------------------------------------------------------------------------------------------
@@ -148,7 +160,9 @@ Leds::add (const LedGroup& new_led_group)
     {
         led_groups.push_back(new_led_group);
         Leds::led_groups[n_led_groups].set_id(n_led_groups);
+        Leds::order.add ();
         Leds::n_led_groups++;
+        Automation::invalidate ();
         return led_groups.size() - 1;
     }
 
@@ -174,7 +188,11 @@ Leds::remove (uint_fast16_t led_group_idx)
             Leds::led_groups[idx] = Leds::led_groups[idx + 1];
         }
 
+        Leds::order.remove (led_group_idx);
+        Leds::renumber ();
+
         Leds::data_changed = true;
+        Automation::invalidate ();
         rtc = true;
     }
 
@@ -182,68 +200,55 @@ Leds::remove (uint_fast16_t led_group_idx)
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  set_new_id () - set new id
+ *  get_position () - get position of led group in display order
  *------------------------------------------------------------------------------------------------------------------------
  */
 uint_fast16_t
-Leds::set_new_id (uint_fast16_t led_group_idx, uint_fast16_t new_led_group_idx)
+Leds::get_position (uint_fast16_t led_group_idx)
 {
-    uint_fast16_t   rtc = 0xFFFF;
+    return Leds::order.get_position (led_group_idx);
+}
 
-    if (led_group_idx < Leds::n_led_groups && new_led_group_idx < Leds::n_led_groups)
+/*------------------------------------------------------------------------------------------------------------------------
+ *  get_led_group_idx () - get led group at position in display order
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Leds::get_led_group_idx (uint_fast16_t position)
+{
+    return Leds::order.get_idx (position);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_position () - move led group to new position in display order. The led group keeps its index, so no references in
+ *  contacts, tracks and events have to be corrected.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Leds::set_position (uint_fast16_t led_group_idx, uint_fast16_t new_position)
+{
+    if (Leds::order.get_position (led_group_idx) == new_position)
     {
-        if (led_group_idx != new_led_group_idx)
-        {
-            LedGroup        tmpled;
-            uint_fast16_t   sidx;
-
-            uint16_t *      map_new_led_idx = (uint16_t *) calloc (Leds::n_led_groups, sizeof (uint16_t));
-
-            for (sidx = 0; sidx < Leds::n_led_groups; sidx++)
-            {
-                map_new_led_idx[sidx] = sidx;
-            }
-
-            tmpled = Leds::led_groups[led_group_idx];
-
-            if (new_led_group_idx < led_group_idx)
-            {
-                for (sidx = led_group_idx; sidx > new_led_group_idx; sidx--)
-                {
-                    Leds::led_groups[sidx] = Leds::led_groups[sidx - 1];
-                    map_new_led_idx[sidx - 1] = sidx;
-                }
-            }
-            else // if (new_led_group_idx > led_group_idx)
-            {
-                for (sidx = led_group_idx; sidx < new_led_group_idx; sidx++)
-                {
-                    Leds::led_groups[sidx] = Leds::led_groups[sidx + 1];
-                    map_new_led_idx[sidx + 1] = sidx;
-                }
-            }
-
-            Leds::led_groups[sidx] = tmpled;
-            map_new_led_idx[led_group_idx] = sidx;
-
-            for (sidx = 0; sidx < Leds::n_led_groups; sidx++)
-            {
-                Debug::printf (DEBUG_LEVEL_VERBOSE, "%2d -> %2d\n", sidx, map_new_led_idx[sidx]);
-            }
-
-            free (map_new_led_idx);
-            Leds::data_changed = true;
-            rtc = new_led_group_idx;
-
-            Leds::renumber ();
-        }
-        else
-        {
-            rtc = led_group_idx;
-        }
+        return led_group_idx;
     }
 
-    return rtc;
+    if (Leds::order.set_position (led_group_idx, new_position))
+    {
+        Leds::data_changed = true;
+        return led_group_idx;
+    }
+
+    return 0xFFFF;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_order () - set display order after reading ini file, positions[led_group_idx] may contain gaps or duplicates
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Leds::set_order (std::vector<uint16_t>& new_positions)
+{
+    Leds::order.set_order (new_positions);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -256,6 +261,19 @@ Leds::get_n_led_groups (void)
     return Leds::n_led_groups;
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ *  Leds::clear () - remove all led groups, see FileIO::reload_ini_files ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Leds::clear (void)
+{
+    Leds::led_groups.clear ();
+    Leds::order.clear ();
+    Leds::n_led_groups = 0;
+    Automation::invalidate ();
+}
+
 /*------------------------------------------------------------------------------------------------------------------------
  *  renumber () - renumber ids
  *------------------------------------------------------------------------------------------------------------------------
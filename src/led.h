@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include "order.h"
 
 #define MAX_LED_GROUPS                  256
 #define MAX_LEDS_PER_GROUP              8
@@ -43,6 +44,7 @@ class LedGroup
         void                            set_state (uint_fast8_t led_mask);
         void                            set_state (uint_fast8_t led_mask, uint_fast8_t on);
         uint_fast8_t                    get_state ();
+        void                            restore_state (uint_fast8_t led_mask);
     private:
         uint16_t                        id;
         std::string                     name;
@@ -58,11 +60,16 @@ class Leds
         static uint_fast16_t            add (const LedGroup& new_led_group);
         static bool                     remove (uint_fast16_t led_group_idx);
         static uint_fast16_t            get_n_led_groups (void);
-        static uint_fast16_t            set_new_id (uint_fast16_t led_group_idx, uint_fast16_t new_led_group_idx);
+        static void                     clear (void);
+        static uint_fast16_t            get_position (uint_fast16_t led_group_idx);
+        static uint_fast16_t            get_led_group_idx (uint_fast16_t position);
+        static uint_fast16_t            set_position (uint_fast16_t led_group_idx, uint_fast16_t new_position);
+        static void                     set_order (std::vector<uint16_t>& new_positions);
         static uint_fast8_t             booster_on (void);
         static uint_fast8_t             booster_off (void);
     private:
         static uint_fast16_t            n_led_groups;                           // number of led groups
+        static DisplayOrder             order;                                  // display order, see set_position ()
         static void                     renumber();
 };
 
@@ -33,12 +33,17 @@
 #include "addon.h"
 #include "rcl.h"
 #include "s88.h"
+#include "automation.h"
+#include "locostats.h"
+#include "fm22.h"
 
 #define MAX_PACKET_SEQUENCES    10
 
 bool                    Locos::data_changed = false;                                // flag: data changed, public
 std::vector<Loco>       Locos::locos;                                               // locos array, public
+LOCO_RUNTIME            Locos::runtime;                                             // runtime state of locos, public
 uint_fast16_t           Locos::n_locos = 0;                                         // number of locos, private
+DisplayOrder            Locos::order;                                               // display order, private
 
 /*------------------------------------------------------------------------------------------------------------------------
  * sendspeed() - send speed
@@ -47,10 +52,10 @@ uint_fast16_t           Locos::n_locos = 0;
 void
 Loco::sendspeed ()
 {
-    uint16_t        addr            = this->addr;
-    uint_fast8_t    speed_steps     = this->speed_steps;
-    uint_fast8_t    fwd             = this->fwd;
-    uint_fast8_t    speed           = this->speed;
+    uint16_t        addr            = Locos::runtime.addr[this->id];
+    uint_fast8_t    speed_steps     = Locos::runtime.speed_steps[this->id];
+    uint_fast8_t    fwd             = Locos::runtime.fwd[this->id];
+    uint_fast8_t    speed           = Locos::runtime.speed[this->id];
 
     // TODO: speed_steps == 14
     if (speed_steps == 28)
@@ -67,12 +72,12 @@ Loco::sendspeed ()
         }
 
         DCC::loco_28 (this->id, addr, fwd, speed);
-        Debug::printf (DEBUG_LEVEL_VERBOSE, "Loco::sendspeed: loco_idx=%d send speed_28: %d\n", this->id, speed);
+        DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "Loco::sendspeed: loco_idx=%d send speed_28: %d\n", this->id, speed);
     }
     else // if (speed_steps == 128)
     {
         DCC::loco (this->id, addr, fwd, speed, 0, 0);
-        Debug::printf (DEBUG_LEVEL_VERBOSE, "Loco::sendspeed: loco_idx=%d send speed_128: %d\n", this->id, speed);
+        DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "Loco::sendspeed: loco_idx=%d send speed_128: %d\n", this->id, speed);
     }
 }
 
@@ -83,11 +88,11 @@ Loco::sendspeed ()
 void
 Loco::sendfunction (uint_fast8_t range)
 {
-    uint16_t    addr            = this->addr;
-    uint32_t    functions       = this->functions;
+    uint16_t    addr            = Locos::runtime.addr[this->id];
+    uint32_t    functions       = Locos::runtime.functions[this->id];
 
     DCC::loco_function (this->id, addr, functions, range);
-    Debug::printf (DEBUG_LEVEL_VERBOSE, "Loco::sendfunction: loco_idx=%d range %d\n", this->id, range);
+    DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "Loco::sendfunction: loco_idx=%d range %d\n", this->id, range);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -109,26 +114,27 @@ Loco::sendfunction (uint_fast8_t range)
 void
 Loco::sendcmd (uint_fast8_t packet_no)
 {
-    uint32_t        target_next_millis  = this->target_next_millis;
+    uint32_t        target_next_millis  = Locos::runtime.target_next_millis[this->id];
 
     if (target_next_millis > 0 && Millis::elapsed() >= target_next_millis)
     {
         uint32_t    millis = Millis::elapsed();
 
-        uint_fast8_t    speed           = this->speed;
-        uint_fast8_t    tspeed          = this->target_speed;
+        uint_fast8_t    speed           = Locos::runtime.speed[this->id];
+        uint_fast8_t    old_speed       = speed;
+        uint_fast8_t    tspeed          = Locos::runtime.target_speed[this->id];
 
         if (tspeed == speed)
         {
-            this->target_next_millis = 0;
+            Locos::runtime.target_next_millis[this->id] = 0;
         }
         else
         {
             if (tspeed > speed)
             {
-                while (this->target_next_millis < millis)
+                while (Locos::runtime.target_next_millis[this->id] < millis)
                 {
-                    this->target_next_millis += this->target_millis_step;
+                    Locos::runtime.target_next_millis[this->id] += Locos::runtime.target_millis_step[this->id];
 
                     speed++;
 
@@ -148,13 +154,13 @@ Loco::sendcmd (uint_fast8_t packet_no)
                     }
                 }
 
-                this->speed = speed;
+                Locos::runtime.speed[this->id] = speed;
             }
             else
             {
-                while (this->target_next_millis < millis)
+                while (Locos::runtime.target_next_millis[this->id] < millis)
                 {
-                    this->target_next_millis += this->target_millis_step;
+                    Locos::runtime.target_next_millis[this->id] += Locos::runtime.target_millis_step[this->id];
 
                     speed--;
 
@@ -175,7 +181,12 @@ Loco::sendcmd (uint_fast8_t packet_no)
 
                 }
 
-                this->speed = speed;
+                Locos::runtime.speed[this->id] = speed;
+            }
+
+            if (speed != old_speed)                                         // not every call reaches the next ramp step
+            {
+                FM22::state_changed ();
             }
         }
     }
@@ -184,28 +195,28 @@ Loco::sendcmd (uint_fast8_t packet_no)
 
 #define LOCO_SLEEP_CNT_MAX      256
 
-    if (this->target_next_millis == 0 && this->speed == 0)
+    if (Locos::runtime.target_next_millis[this->id] == 0 && Locos::runtime.speed[this->id] == 0)
     {
-        if (this->packet_sequence_idx == 0)
+        if (Locos::runtime.packet_sequence_idx[this->id] == 0)
         {
-            if (this->sleep_cnt < LOCO_SLEEP_CNT_MAX)
+            if (Locos::runtime.sleep_cnt[this->id] < LOCO_SLEEP_CNT_MAX)
             {
-                this->sleep_cnt++;
+                Locos::runtime.sleep_cnt[this->id]++;
             }
             else
             {
-                this->sleep_cnt = 0;
+                Locos::runtime.sleep_cnt[this->id] = 0;
             }
         }
     }
     else
     {
-        this->sleep_cnt = 0;
+        Locos::runtime.sleep_cnt[this->id] = 0;
     }
 
 #endif
 
-    if (this->sleep_cnt < 4 || (this->sleep_cnt % 4) == 0)
+    if (Locos::runtime.sleep_cnt[this->id] < 4 || (Locos::runtime.sleep_cnt[this->id] % 4) == 0)
     {
         if (packet_no & 0x01)           // odd packet number: send functions
         {
@@ -214,42 +225,47 @@ Loco::sendcmd (uint_fast8_t packet_no)
                 case 1:
                 {
                     this->sendfunction (DCC_F00_F04_RANGE);
-                    Debug::printf (DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F00_F04_RANGE)\n", this->id);
+                    LocoStats::packet_sent (this->id, LOCOSTATS_GROUP_F00_F04);
+                    DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F00_F04_RANGE)\n", this->id);
                     break;
                 }
                 case 3:
                 {
-                    if (this->locofunction.max >= 5)
+                    if (Locos::runtime.function_max[this->id] >= 5)
                     {
                         this->sendfunction (DCC_F05_F08_RANGE);
-                        Debug::printf (DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F05_F08_RANGE)\n", this->id);
+                        LocoStats::packet_sent (this->id, LOCOSTATS_GROUP_F05_F08);
+                        DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F05_F08_RANGE)\n", this->id);
                     }
                     break;
                 }
                 case 5:
                 {
-                    if (this->locofunction.max >= 9)
+                    if (Locos::runtime.function_max[this->id] >= 9)
                     {
                         this->sendfunction (DCC_F09_F12_RANGE);
-                        Debug::printf (DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F09_F12_RANGE)\n", this->id);
+                        LocoStats::packet_sent (this->id, LOCOSTATS_GROUP_F09_F12);
+                        DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F09_F12_RANGE)\n", this->id);
                     }
                     break;
                 }
                 case 7:
                 {
-                    if (this->locofunction.max >= 13)
+                    if (Locos::runtime.function_max[this->id] >= 13)
                     {
                         this->sendfunction (DCC_F13_F20_RANGE);
-                        Debug::printf (DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F13_F20_RANGE)\n", this->id);
+                        LocoStats::packet_sent (this->id, LOCOSTATS_GROUP_F13_F20);
+                        DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F13_F20_RANGE)\n", this->id);
                     }
                     break;
                 }
                 case 9:
                 {
-                    if (this->locofunction.max >= 21)
+                    if (Locos::runtime.function_max[this->id] >= 21)
                     {
                         this->sendfunction (DCC_F21_F28_RANGE);
-                        Debug::printf (DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F21_F28_RANGE)\n", this->id);
+                        LocoStats::packet_sent (this->id, LOCOSTATS_GROUP_F21_F28);
+                        DEBUG_TRACE (DEBUG_SUBSYSTEM_DCC, DEBUG_LEVEL_VERBOSE, "sendfunction (%d, DCC_F21_F28_RANGE)\n", this->id);
                     }
                     break;
                 }
@@ -258,6 +274,7 @@ Loco::sendcmd (uint_fast8_t packet_no)
         else                        // even packet number: send speed
         {
             this->sendspeed ();
+            LocoStats::packet_sent (this->id, LOCOSTATS_GROUP_SPEED);
         }
     }
 }
@@ -271,30 +288,15 @@ Loco::Loco ()
     uint_fast8_t    fidx;
     uint_fast8_t    midx;
 
+    this->id                        = 0xFFFF;                   // runtime state is initialized by Locos::add()
     this->name                      = "";
-    this->addr                      = 0;
     this->addon_idx                 = 0xFFFF;
-    this->target_next_millis        = 0;
-    this->speed_steps               = 0;
-    this->fwd                       = 1;
-    this->speed                     = 0;
-    this->target_speed              = 0;
-    this->target_millis_step        = 0;
-    this->target_next_millis        = 0;
-    this->functions                 = 0;
-    this->packet_sequence_idx       = 0;
     this->locofunction.pulse_mask   = 0;
     this->locofunction.sound_mask   = 0;
-    this->locofunction.max          = 0;
     this->rc_millis                 = 0;
-    this->rc2_rate                  = 0;
-    this->offline_cnt               = 0;
     this->rcl_location              = 0xFF;
     this->rr_location               = 0xFFFF;
-    this->sleep_cnt                 = 0;
     this->destination               = 0xFF;
-    this->flags                     = 0;
-    this->active                    = 0;
 
     for (fidx = 0; fidx < MAX_LOCO_FUNCTIONS; fidx++)
     {
@@ -349,6 +351,7 @@ Loco::set_addon (uint_fast16_t addon_idx)
                 }
 
                 Locos::data_changed = true;
+                Automation::invalidate ();
             }
         }
     }
@@ -363,6 +366,7 @@ Loco::set_addon (uint_fast16_t addon_idx)
         }
 
         Locos::data_changed = true;
+        Automation::invalidate ();
     }
 }
 
@@ -389,6 +393,7 @@ Loco::reset_addon ()
     {
         this->addon_idx = 0xFFFF;
         Locos::data_changed = true;
+        Automation::invalidate ();
     }
 }
 
@@ -455,9 +460,9 @@ Loco::get_name ()
 void
 Loco::set_addr (uint_fast16_t addr)
 {
-    if (this->addr != addr)
+    if (Locos::runtime.addr[this->id] != addr)
     {
-        this->addr = addr;
+        Locos::runtime.addr[this->id] = addr;
         Locos::data_changed = true;
     }
 }
@@ -469,7 +474,7 @@ Loco::set_addr (uint_fast16_t addr)
 uint_fast16_t
 Loco::get_addr ()
 {
-    return (this->addr);
+    return (Locos::runtime.addr[this->id]);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -479,9 +484,9 @@ Loco::get_addr ()
 void
 Loco::set_speed_steps (uint_fast8_t speed_steps)
 {
-    if (this->speed_steps != speed_steps)
+    if (Locos::runtime.speed_steps[this->id] != speed_steps)
     {
-        this->speed_steps = speed_steps;
+        Locos::runtime.speed_steps[this->id] = speed_steps;
         Locos::data_changed = true;
     }
 }
@@ -493,7 +498,7 @@ Loco::set_speed_steps (uint_fast8_t speed_steps)
 uint_fast8_t
 Loco::get_speed_steps ()
 {
-    return (this->speed_steps);
+    return (Locos::runtime.speed_steps[this->id]);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -503,7 +508,7 @@ Loco::get_speed_steps ()
 void
 Loco::set_flags (uint32_t flags)
 {
-    this->flags = flags;
+    Locos::runtime.flags[this->id] = flags;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -513,7 +518,7 @@ Loco::set_flags (uint32_t flags)
 uint32_t
 Loco::get_flags ()
 {
-    return this->flags;
+    return Locos::runtime.flags[this->id];
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -523,7 +528,7 @@ Loco::get_flags ()
 void
 Loco::set_flag_halt ()
 {
-    this->flags |= LOCO_FLAG_HALT;
+    Locos::runtime.flags[this->id] |= LOCO_FLAG_HALT;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -533,7 +538,7 @@ Loco::set_flag_halt ()
 void
 Loco::reset_flag_halt ()
 {
-    this->flags &= ~LOCO_FLAG_HALT;
+    Locos::runtime.flags[this->id] &= ~LOCO_FLAG_HALT;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -545,7 +550,7 @@ Loco::get_flag_halt ()
 {
     bool rtc = false;
 
-    if (this->flags & LOCO_FLAG_HALT)
+    if (Locos::runtime.flags[this->id] & LOCO_FLAG_HALT)
     {
         rtc = true;
     }
@@ -569,6 +574,7 @@ Loco::add_macro_action (uint_fast8_t macroidx)
         this->macros[macroidx].actions[actionidx].n_parameters  = 0;
         this->macros[macroidx].n_actions++;
         Locos::data_changed = true;
+        Automation::invalidate ();
     }
     else
     {
@@ -607,6 +613,7 @@ Loco::delete_macro_action (uint_fast8_t macroidx, uint_fast8_t actionidx)
 
         this->macros[macroidx].n_actions--;
         Locos::data_changed = true;
+        Automation::invalidate ();
     }
 }
 
@@ -644,6 +651,7 @@ Loco::set_macro_action (uint_fast8_t macroidx, uint_fast8_t actionidx, LOCOACTIO
         }
 
         Locos::data_changed = true;
+        Automation::invalidate ();
         rtc = true;
     }
 
@@ -683,201 +691,7 @@ Loco::get_macro_action (uint_fast8_t macroidx, uint_fast8_t actionidx, LOCOACTIO
 void
 Loco::execute_macro (uint_fast8_t macroidx)
 {
-    LOCOACTION *    lap;
-    uint_fast8_t    n_actions;
-    uint_fast8_t    actionidx;
-
-    n_actions = this->macros[macroidx].n_actions;
-    lap = this->macros[macroidx].actions;
-
-    for (actionidx = 0; actionidx < n_actions; actionidx++)
-    {
-        switch (lap[actionidx].action)
-        {
-            case LOCO_ACTION_SET_LOCO_SPEED:                                            // parameters: START, SPEED, TENTHS
-            {
-                uint_fast32_t   start       = lap[actionidx].parameters[0];
-                uint_fast8_t    speed       = lap[actionidx].parameters[1];
-                uint_fast16_t   tenths      = lap[actionidx].parameters[2];
-
-                if (start == 0)
-                {
-                    this->set_speed (speed, tenths);
-                }
-                else
-                {
-                    Event::add_event_loco_speed (start, this->id, EVENT_SET_LOCO_SPEED, speed, tenths);
-                }
-                break;
-            }
-
-            case LOCO_ACTION_SET_LOCO_MIN_SPEED:                                        // parameters: START, SPEED, TENTHS
-            {
-                uint_fast32_t   start       = lap[actionidx].parameters[0];
-                uint_fast8_t    speed       = lap[actionidx].parameters[1];
-                uint_fast16_t   tenths      = lap[actionidx].parameters[2];
-
-                if (start == 0)
-                {
-                    uint_fast8_t current_speed = this->get_speed ();
-
-                    if (current_speed < speed)
-                    {
-                        this->set_speed (speed, tenths);
-                    }
-                }
-                else
-                {
-                    Event::add_event_loco_speed (start, this->id, EVENT_SET_LOCO_MIN_SPEED, speed, tenths);
-                }
-                break;
-            }
-
-            case LOCO_ACTION_SET_LOCO_MAX_SPEED:                                        // parameters: START, SPEED, TENTHS
-            {
-                uint_fast32_t   start       = lap[actionidx].parameters[0];
-                uint_fast8_t    speed       = lap[actionidx].parameters[1];
-                uint_fast16_t   tenths      = lap[actionidx].parameters[2];
-
-                if (start == 0)
-                {
-                    uint_fast8_t current_speed = this->get_speed ();
-
-                    if (current_speed > speed)
-                    {
-                        this->set_speed (speed, tenths);
-                    }
-                }
-                else
-                {
-                    Event::add_event_loco_speed (start, this->id, EVENT_SET_LOCO_MAX_SPEED, speed, tenths);
-                }
-                break;
-            }
-
-            case LOCO_ACTION_SET_LOCO_FORWARD_DIRECTION:                                // parameters: START, FWD
-            {
-                uint_fast32_t   start       = lap[actionidx].parameters[0];
-                uint_fast8_t    fwd         = lap[actionidx].parameters[1];
-
-                if (start == 0)
-                {
-                    this->set_fwd (fwd);
-                }
-                else
-                {
-                    Event::add_event_loco_dir (start, this->id, fwd);
-                }
-                break;
-            }
-
-            case LOCO_ACTION_SET_LOCO_ALL_FUNCTIONS_OFF:                                // parameters: START
-            {
-                uint_fast32_t   start       = lap[actionidx].parameters[0];
-
-                if (start == 0)
-                {
-                    this->reset_functions ();
-                }
-                else
-                {
-                    Event::add_event_loco_function (start, this->id, 0xFF, false);
-                }
-                break;
-            }
-
-            case LOCO_ACTION_SET_LOCO_FUNCTION_OFF:                                     // parameters: START, FUNC_IDX
-            {
-                uint_fast32_t   start       = lap[actionidx].parameters[0];
-                uint_fast8_t    f           = lap[actionidx].parameters[1];
-
-                if (start == 0)
-                {
-                    this->set_function (f, false);
-                }
-                else
-                {
-                    Event::add_event_loco_function (start, this->id, f, false);
-                }
-                break;
-            }
-
-            case LOCO_ACTION_SET_LOCO_FUNCTION_ON:                                      // parameters: START, FUNC_IDX
-            {
-                uint_fast32_t   start       = lap[actionidx].parameters[0];
-                uint_fast8_t    f           = lap[actionidx].parameters[1];
-
-                if (start == 0)
-                {
-                    this->set_function (f, true);
-                }
-                else
-                {
-                    Event::add_event_loco_function (start, this->id, f, true);
-                }
-                break;
-            }
-
-            case LOCO_ACTION_SET_ADDON_ALL_FUNCTIONS_OFF:                               // parameters: START
-            {
-                uint_fast32_t   start       = lap[actionidx].parameters[0];
-                uint_fast16_t   addon_idx   = this->addon_idx;
-
-                if (addon_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        AddOns::addons[addon_idx].reset_functions ();
-                    }
-                    else
-                    {
-                        Event::add_event_addon_function (start, addon_idx, 0xFF, false);
-                    }
-                }
-                break;
-            }
-
-            case LOCO_ACTION_SET_ADDON_FUNCTION_OFF:                                        // parameters: START, FUNC_IDX
-            {
-                uint_fast32_t   start       = lap[actionidx].parameters[0];
-                uint_fast8_t    f           = lap[actionidx].parameters[1];
-                uint_fast16_t   addon_idx   = this->addon_idx;
-
-                if (addon_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        AddOns::addons[addon_idx].set_function (f, false);
-                    }
-                    else
-                    {
-                        Event::add_event_addon_function (start, addon_idx, f, false);
-                    }
-                }
-                break;
-            }
-
-            case LOCO_ACTION_SET_ADDON_FUNCTION_ON:                                         // parameters: START, FUNC_IDX
-            {
-                uint_fast32_t   start       = lap[actionidx].parameters[0];
-                uint_fast8_t    f           = lap[actionidx].parameters[1];
-                uint_fast16_t   addon_idx   = this->addon_idx;
-
-                if (addon_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        AddOns::addons[addon_idx].set_function (f, true);
-                    }
-                    else
-                    {
-                        Event::add_event_addon_function (start, addon_idx, f, true);
-                    }
-                }
-                break;
-            }
-        }
-    }
+    Automation::execute_macro (this->id, macroidx);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -929,9 +743,9 @@ Loco::set_function_type_sound (uint_fast8_t f, bool b)
 uint_fast8_t
 Loco::set_function_type (uint_fast8_t fidx, uint_fast16_t function_name_idx, bool pulse, bool sound)
 {
-    if (this->locofunction.max < fidx)
+    if (Locos::runtime.function_max[this->id] < fidx)
     {
-        this->locofunction.max = fidx;
+        Locos::runtime.function_max[this->id] = fidx;
     }
 
     this->locofunction.name_idx[fidx] = function_name_idx;
@@ -1023,9 +837,10 @@ Loco::get_function_sound_mask ()
 void
 Loco::activate ()
 {
-    if (! this->active)
+    if (! Locos::runtime.active[this->id])
     {
-        this->active = true;
+        Locos::runtime.active[this->id] = true;
+        LocoStats::restart (this->id);
     }
 }
 
@@ -1036,9 +851,9 @@ Loco::activate ()
 void
 Loco::deactivate ()
 {
-    if (this->active)
+    if (Locos::runtime.active[this->id])
     {
-        this->active = false;
+        Locos::runtime.active[this->id] = false;
     }
 }
 
@@ -1049,7 +864,7 @@ Loco::deactivate ()
 bool
 Loco::is_active ()
 {
-    if (this->active)
+    if (Locos::runtime.active[this->id])
     {
         return true;
     }
@@ -1066,19 +881,19 @@ Loco::set_online (bool value)
 {
     if (value)
     {
-        this->offline_cnt = 0;
-        this->flags |= LOCO_FLAG_ONLINE;
+        Locos::runtime.offline_cnt[this->id] = 0;
+        Locos::runtime.flags[this->id] |= LOCO_FLAG_ONLINE;
     }
     else
     {
-        if (this->offline_cnt < MAX_OFFLINE_COUNTER_VALUE)
+        if (Locos::runtime.offline_cnt[this->id] < MAX_OFFLINE_COUNTER_VALUE)
         {
-            this->offline_cnt++;
+            Locos::runtime.offline_cnt[this->id]++;
         }
 
-        if (this->offline_cnt == MAX_OFFLINE_COUNTER_VALUE)
+        if (Locos::runtime.offline_cnt[this->id] == MAX_OFFLINE_COUNTER_VALUE)
         {
-            this->flags &= ~LOCO_FLAG_ONLINE;
+            Locos::runtime.flags[this->id] &= ~LOCO_FLAG_ONLINE;
         }
     }
 }
@@ -1090,7 +905,7 @@ Loco::set_online (bool value)
 bool
 Loco::is_online ()
 {
-    if (this->flags & LOCO_FLAG_ONLINE)
+    if (Locos::runtime.flags[this->id] & LOCO_FLAG_ONLINE)
     {
         return true;
     }
@@ -1104,9 +919,9 @@ Loco::is_online ()
 void
 Loco::set_speed_value (uint_fast8_t tspeed)
 {
-    if (! (this->flags & LOCO_FLAG_HALT))
+    if (! (Locos::runtime.flags[this->id] & LOCO_FLAG_HALT))
     {
-        this->speed = tspeed;
+        Locos::runtime.speed[this->id] = tspeed;
     }
 }
 
@@ -1117,10 +932,10 @@ Loco::set_speed_value (uint_fast8_t tspeed)
 void
 Loco::set_speed (uint_fast8_t speed)
 {
-    if (! (this->flags & LOCO_FLAG_HALT))
+    if (! (Locos::runtime.flags[this->id] & LOCO_FLAG_HALT))
     {
-        this->speed                 = speed;
-        this->target_next_millis    = 0;
+        Locos::runtime.speed[this->id]                 = speed;
+        Locos::runtime.target_next_millis[this->id]    = 0;
         this->sendspeed ();
     }
 }
@@ -1146,23 +961,23 @@ Loco::set_speed (uint_fast8_t tspeed, uint_fast16_t tenths)
 {
     // printf ("loco_idx=%u tspeed=%u, tenths=%u\n", loco_idx, tspeed, tenths);
 
-    if (! (this->flags & LOCO_FLAG_HALT))
+    if (! (Locos::runtime.flags[this->id] & LOCO_FLAG_HALT))
     {
         if (tenths > 0)
         {
-            uint_fast8_t    cspeed = this->speed;       // current speed
+            uint_fast8_t    cspeed = Locos::runtime.speed[this->id];       // current speed
 
             if (tspeed > cspeed)
             {
-                this->target_speed          = tspeed;
-                this->target_millis_step    = (100 * tenths) / (tspeed - cspeed);
-                this->target_next_millis    = Millis::elapsed() + this->target_millis_step;
+                Locos::runtime.target_speed[this->id]          = tspeed;
+                Locos::runtime.target_millis_step[this->id]    = (100 * tenths) / (tspeed - cspeed);
+                Locos::runtime.target_next_millis[this->id]    = Millis::elapsed() + Locos::runtime.target_millis_step[this->id];
             }
             else if (tspeed < cspeed)
             {
-                this->target_speed          = tspeed;
-                this->target_millis_step    = (100 * tenths) / (cspeed - tspeed);
-                this->target_next_millis    = Millis::elapsed() + this->target_millis_step;
+                Locos::runtime.target_speed[this->id]          = tspeed;
+                Locos::runtime.target_millis_step[this->id]    = (100 * tenths) / (cspeed - tspeed);
+                Locos::runtime.target_next_millis[this->id]    = Millis::elapsed() + Locos::runtime.target_millis_step[this->id];
             }
             // if speeds are identical, do nothing
         }
@@ -1180,7 +995,7 @@ Loco::set_speed (uint_fast8_t tspeed, uint_fast16_t tenths)
 uint16_t
 Loco::get_speed ()
 {
-    return (this->speed);
+    return (Locos::runtime.speed[this->id]);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -1190,10 +1005,10 @@ Loco::get_speed ()
 void
 Loco::set_fwd (uint_fast8_t fwd)
 {
-    if (this->fwd != fwd)
+    if (Locos::runtime.fwd[this->id] != fwd)
     {
-        this->speed = 0;
-        this->fwd = fwd;
+        Locos::runtime.speed[this->id] = 0;
+        Locos::runtime.fwd[this->id] = fwd;
         this->sendspeed ();
     }
 }
@@ -1205,8 +1020,8 @@ Loco::set_fwd (uint_fast8_t fwd)
 void
 Loco::set_speed_fwd (uint_fast8_t speed, uint_fast8_t fwd)
 {
-    this->speed = speed;
-    this->fwd = fwd;
+    Locos::runtime.speed[this->id] = speed;
+    Locos::runtime.fwd[this->id] = fwd;
     this->sendspeed ();
 }
 
@@ -1217,7 +1032,7 @@ Loco::set_speed_fwd (uint_fast8_t speed, uint_fast8_t fwd)
 uint_fast8_t
 Loco::get_fwd ()
 {
-    return this->fwd;
+    return Locos::runtime.fwd[this->id];
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -1233,7 +1048,7 @@ Loco::set_function (uint_fast8_t f, bool b)
 
     if (b)
     {
-        this->functions |= fmask;
+        Locos::runtime.functions[this->id] |= fmask;
 
         if (fmask & this->locofunction.pulse_mask)          // function is of type pulse
         {
@@ -1242,7 +1057,7 @@ Loco::set_function (uint_fast8_t f, bool b)
     }
     else
     {
-        this->functions &= ~fmask;
+        Locos::runtime.functions[this->id] &= ~fmask;
     }
 
     if (addon_idx != 0xFFFF)
@@ -1291,7 +1106,7 @@ uint_fast8_t
 Loco::get_function (uint_fast8_t f)
 {
     uint32_t mask = 1 << f;
-    return (this->functions & mask) ? true : false;
+    return (Locos::runtime.functions[this->id] & mask) ? true : false;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -1301,7 +1116,7 @@ Loco::get_function (uint_fast8_t f)
 void
 Loco::reset_functions ()
 {
-    this->functions = 0;       // let scheduler turn off functions
+    Locos::runtime.functions[this->id] = 0;       // let scheduler turn off functions
 
     uint_fast16_t addon_idx = this->addon_idx;
 
@@ -1318,7 +1133,20 @@ Loco::reset_functions ()
 uint32_t
 Loco::get_functions ()
 {
-    return this->functions;
+    return Locos::runtime.functions[this->id];
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * restore_state () - restore speed, direction and functions without sending, see Journal::init ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Loco::restore_state (uint_fast8_t speed, uint_fast8_t fwd, uint32_t functions)
+{
+    Locos::runtime.speed[this->id]                 = speed;
+    Locos::runtime.fwd[this->id]                   = fwd;
+    Locos::runtime.functions[this->id]             = functions;
+    Locos::runtime.target_next_millis[this->id]    = 0;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -1412,7 +1240,7 @@ Loco::estop ()
 void
 Loco::get_ack ()
 {
-    DCC::get_ack (this->addr);
+    DCC::get_ack (Locos::runtime.addr[this->id]);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -1423,7 +1251,7 @@ void
 Loco::set_rc2_rate (uint_fast8_t rate)
 {
     Debug::printf (DEBUG_LEVEL_VERBOSE, "Loco::set_rc2_rate: loco_idx=%u rate=%u\n", (uint16_t) this->id, (uint16_t) rate);
-    this->rc2_rate = rate;
+    Locos::runtime.rc2_rate[this->id] = rate;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -1433,16 +1261,16 @@ Loco::set_rc2_rate (uint_fast8_t rate)
 uint_fast8_t
 Loco::get_rc2_rate ()
 {
-    Debug::printf (DEBUG_LEVEL_VERBOSE, "Loco::get_rc2_rate: loco_idx=%u rate=%u\n", (uint16_t) this->id, (uint16_t) this->rc2_rate);
-    return this->rc2_rate;
+    Debug::printf (DEBUG_LEVEL_VERBOSE, "Loco::get_rc2_rate: loco_idx=%u rate=%u\n", (uint16_t) this->id, (uint16_t) Locos::runtime.rc2_rate[this->id]);
+    return Locos::runtime.rc2_rate[this->id];
 }
 
 void
 Loco::sched ()
 {
-    if (this->active && this->addr != 0)
+    if (Locos::runtime.active[this->id] && Locos::runtime.addr[this->id] != 0)
     {
-        uint_fast8_t packet_sequence_idx = this->packet_sequence_idx;
+        uint_fast8_t packet_sequence_idx = Locos::runtime.packet_sequence_idx[this->id];
 
         this->sendcmd (packet_sequence_idx);
         packet_sequence_idx++;
@@ -1452,7 +1280,7 @@ Loco::sched ()
             packet_sequence_idx = 0;
         }
 
-        this->packet_sequence_idx = packet_sequence_idx;
+        Locos::runtime.packet_sequence_idx[this->id] = packet_sequence_idx;
     }
 }
 
@@ -1465,8 +1293,11 @@ Locos::add (const Loco& loco)
     {
         Locos::locos.push_back(loco);
         Locos::locos[n_locos].set_id(n_locos);
+        Locos::init_runtime (n_locos);
+        Locos::order.add ();
         Locos::n_locos++;
         Locos::data_changed = true;
+        Automation::invalidate ();
         rtc = locos.size() - 1;
     }
     return rtc;
@@ -1483,96 +1314,96 @@ Locos::get_n_locos (void)
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  set_new_id () - set new id
+ *  clear () - remove all locos, see FileIO::reload_ini_files ()
  *------------------------------------------------------------------------------------------------------------------------
  */
-uint_fast16_t
-Locos::set_new_id (uint_fast16_t loco_idx, uint_fast16_t new_loco_idx)
+void
+Locos::clear (void)
 {
-    uint_fast16_t   rtc = 0xFFFF;
-
-    if (loco_idx < Locos::n_locos && new_loco_idx < Locos::n_locos)
-    {
-        if (loco_idx != new_loco_idx)
-        {
-            Loco            tmploco;
-            uint_fast16_t   lidx;
-
-            uint16_t *      map_new_loco_idx = (uint16_t *) calloc (Locos::n_locos, sizeof (uint16_t));
-
-            for (lidx = 0; lidx < Locos::n_locos; lidx++)
-            {
-                map_new_loco_idx[lidx] = lidx;
-            }
+    Locos::locos.clear ();
+    Locos::order.clear ();
+    Locos::n_locos = 0;
+    Automation::invalidate ();
+}
 
-            tmploco = Locos::locos[loco_idx];
+/*------------------------------------------------------------------------------------------------------------------------
+ *  init_runtime () - initialize runtime state of new loco
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Locos::init_runtime (uint_fast16_t loco_idx)
+{
+    LOCO_RUNTIME *  rp = &Locos::runtime;
 
-            if (new_loco_idx < loco_idx)
-            {
-                // step 1: shift loco
-                for (lidx = loco_idx; lidx > new_loco_idx; lidx--)
-                {
-                    Locos::locos[lidx] = Locos::locos[lidx - 1];
-                    map_new_loco_idx[lidx - 1] = lidx;
-                }
-            }
-            else // if (new_loco_idx > loco_idx)
-            {
-                // step 1: shift loco
-                for (lidx = loco_idx; lidx < new_loco_idx; lidx++)
-                {
-                    Locos::locos[lidx] = Locos::locos[lidx + 1];
-                    map_new_loco_idx[lidx + 1] = lidx;
-                }
-            }
+    rp->addr[loco_idx]                  = 0;
+    rp->speed_steps[loco_idx]           = 0;
+    rp->fwd[loco_idx]                   = 1;
+    rp->speed[loco_idx]                 = 0;
+    rp->target_speed[loco_idx]          = 0;
+    rp->packet_sequence_idx[loco_idx]   = 0;
+    rp->function_max[loco_idx]          = 0;
+    rp->active[loco_idx]                = 0;
+    rp->rc2_rate[loco_idx]              = 0;
+    rp->offline_cnt[loco_idx]           = 0;
+    rp->sleep_cnt[loco_idx]             = 0;
+    rp->functions[loco_idx]             = 0;
+    rp->target_millis_step[loco_idx]    = 0;
+    rp->target_next_millis[loco_idx]    = 0;
+    rp->flags[loco_idx]                 = 0;
 
-            Locos::locos[lidx] = tmploco;
-            map_new_loco_idx[loco_idx] = lidx;
+    LocoStats::reset (loco_idx);
+}
 
-            for (lidx = 0; lidx < Locos::n_locos; lidx++)
-            {
-                Debug::printf (DEBUG_LEVEL_VERBOSE, "%2d -> %2d\n", lidx, map_new_loco_idx[lidx]);
-            }
+/*------------------------------------------------------------------------------------------------------------------------
+ *  get_position () - get position of loco in display order
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Locos::get_position (uint_fast16_t loco_idx)
+{
+    return Locos::order.get_position (loco_idx);
+}
 
-            // step 2: correct loco_idx in ADDON, RAILROAD, RCL, S88
-            AddOns::set_new_loco_ids (map_new_loco_idx, Locos::n_locos);
-            RailroadGroups::set_new_loco_ids (map_new_loco_idx, Locos::n_locos);
-            RCL::set_new_loco_ids (map_new_loco_idx, Locos::n_locos);
-            S88::set_new_loco_ids (map_new_loco_idx, Locos::n_locos);
+/*------------------------------------------------------------------------------------------------------------------------
+ *  get_loco_idx () - get loco at position in display order
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Locos::get_loco_idx (uint_fast16_t position)
+{
+    return Locos::order.get_idx (position);
+}
 
-            free (map_new_loco_idx);
-            Locos::data_changed = true;
-            rtc = new_loco_idx;
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_position () - move loco to new position in display order. The loco keeps its index, so no references in
+ *  add-ons, railroads, contacts, tracks, events and in the RailCom tables of the STM32 have to be corrected.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Locos::set_position (uint_fast16_t loco_idx, uint_fast16_t new_position)
+{
+    if (Locos::order.get_position (loco_idx) == new_position)
+    {
+        return loco_idx;
+    }
 
-            Locos::renumber ();
-        }
-        else
-        {
-            rtc = loco_idx;
-        }
+    if (Locos::order.set_position (loco_idx, new_position))
+    {
+        Locos::data_changed = true;
+        return loco_idx;
     }
 
-    return rtc;
+    return 0xFFFF;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  Loco::set_new_addon_ids ()
+ *  set_order () - set display order after reading ini file, positions[loco_idx] may contain gaps or duplicates
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-Locos::set_new_addon_ids (uint16_t * map_new_addon_idx, uint16_t n_addons)
+Locos::set_order (std::vector<uint16_t>& new_positions)
 {
-    uint_fast16_t     loco_idx;
-
-    for (loco_idx = 0; loco_idx < Locos::n_locos; loco_idx++)
-    {
-        uint_fast16_t     addon_idx = Locos::locos[loco_idx].get_addon();
-
-        if (addon_idx < n_addons)
-        {
-            Locos::locos[loco_idx].set_addon (map_new_addon_idx[addon_idx]);
-        }
-    }
+    Locos::order.set_order (new_positions);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -1618,21 +1449,6 @@ Locos::schedule (void)
     return rtc;
 }
 
-/*------------------------------------------------------------------------------------------------------------------------
- *  renumber () - renumber ids
- *------------------------------------------------------------------------------------------------------------------------
- */
-void
-Locos::renumber ()
-{
-    uint_fast16_t loco_idx;
-
-    for (loco_idx = 0; loco_idx < Locos::n_locos; loco_idx++)
-    {
-        Locos::locos[loco_idx].set_id (loco_idx);
-    }
-}
-
 /*------------------------------------------------------------------------------------------------------------------------
  *  estop (void)
  *------------------------------------------------------------------------------------------------------------------------
@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include "order.h"
 
 #define MAX_LOCOS               1024
 
@@ -74,7 +75,6 @@ typedef struct
     uint32_t            pulse_mask;
     uint32_t            sound_mask;
     uint16_t            name_idx[MAX_LOCO_FUNCTIONS];
-    uint8_t             max;                                // highest used function index
 } LOCOFUNCTION;
 
 #define LOCO_MAX_ACTION_PARAMETERS                  8
@@ -108,6 +108,31 @@ typedef struct
     uint8_t                             n_actions;
 } LOCOMACRO;
 
+/*------------------------------------------------------------------------------------------------------------------------
+ * runtime state of all locos, indexed by loco id. Kept apart from the configuration in class Loco, so that the
+ * scheduler, RCL and RC2 handling only touch a few cache lines per loco instead of the whole Loco object with its
+ * names, function types and macros. Only accessed through the methods of class Loco.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+    uint16_t                            addr[MAX_LOCOS];
+    uint8_t                             speed_steps[MAX_LOCOS];                                 // 14, 28, or 128
+    uint8_t                             fwd[MAX_LOCOS];
+    uint8_t                             speed[MAX_LOCOS];
+    uint8_t                             target_speed[MAX_LOCOS];                                // target speed
+    uint8_t                             packet_sequence_idx[MAX_LOCOS];
+    uint8_t                             function_max[MAX_LOCOS];                                // highest used function index
+    uint8_t                             active[MAX_LOCOS];
+    uint8_t                             rc2_rate[MAX_LOCOS];
+    uint8_t                             offline_cnt[MAX_LOCOS];
+    uint16_t                            sleep_cnt[MAX_LOCOS];
+    uint32_t                            functions[MAX_LOCOS];
+    uint32_t                            target_millis_step[MAX_LOCOS];                          // increment speed every millis_step
+    uint32_t                            target_next_millis[MAX_LOCOS];                          // next millis to step down/up
+    uint32_t                            flags[MAX_LOCOS];
+} LOCO_RUNTIME;
+
 class Loco
 {
     public:
@@ -174,6 +199,7 @@ class Loco
         uint_fast8_t                    get_function (uint_fast8_t f);
         void                            reset_functions (void);
         uint32_t                        get_functions (void);
+        void                            restore_state (uint_fast8_t speed, uint_fast8_t fwd, uint32_t functions);
 
         void                            set_destination (uint_fast8_t rrg);
         uint_fast8_t                    get_destination (void);
@@ -194,28 +220,14 @@ class Loco
     private:
         uint16_t                        id;
         std::string                     name;
-        uint16_t                        addr;
         uint16_t                        addon_idx;                                              // idx of add-on
         uint8_t                         coupled_functions[MAX_LOCO_FUNCTIONS];                  // coupled functions
         LOCOFUNCTION                    locofunction;
         LOCOMACRO                       macros[MAX_LOCO_MACROS_PER_LOCO];
-        uint8_t                         speed_steps;                                            // 14, 28, or 128
-        uint8_t                         fwd;
-        uint8_t                         speed;
-        uint8_t                         target_speed;                                           // target speed
-        uint32_t                        target_millis_step;                                     // increment speed every millis_step
-        uint32_t                        target_next_millis;                                     // next millis to step down/up
-        uint32_t                        functions;
-        uint8_t                         packet_sequence_idx;
         uint32_t                        rc_millis;
-        uint8_t                         rc2_rate;
-        uint8_t                         offline_cnt;
         uint8_t                         rcl_location;                                           // a loco can be in rcl & rr_location at the same time!
         uint16_t                        rr_location;    
-        uint16_t                        sleep_cnt;
-        uint32_t                        flags;
         uint8_t                         destination;                                            // id of railroad, FF = no destination
-        uint8_t                         active;
 
         void                            set_function_type_pulse (uint_fast8_t f, bool b);
         void                            set_function_type_sound (uint_fast8_t f, bool b);
@@ -229,19 +241,24 @@ class Locos
 {
     public:
         static std::vector<Loco>        locos;
+        static LOCO_RUNTIME             runtime;                                        // runtime state, see above
         static bool                     data_changed;
 
         static uint_fast16_t            add (const Loco& loco);
         static uint_fast16_t            get_n_locos (void);
-        static uint_fast16_t            set_new_id (uint_fast16_t loco_idx, uint_fast16_t new_loco_idx);
-        static void                     set_new_addon_ids (uint16_t * map_new_addon_idx, uint16_t n_addons);
+        static void                     clear (void);
+        static uint_fast16_t            get_position (uint_fast16_t loco_idx);
+        static uint_fast16_t            get_loco_idx (uint_fast16_t position);
+        static uint_fast16_t            set_position (uint_fast16_t loco_idx, uint_fast16_t new_position);
+        static void                     set_order (std::vector<uint16_t>& new_positions);
         static bool                     schedule (void);
         static void                     estop (void);
         static void                     booster_off (bool do_send_booster_cmd);
         static void                     booster_on (bool do_send_booster_cmd);
     private:
         static uint_fast16_t            n_locos;                                        // number of locos
-        static void                     renumber(void);
+        static DisplayOrder             order;                                          // display order, see set_position ()
+        static void                     init_runtime (uint_fast16_t loco_idx);
 };
 
 #endif
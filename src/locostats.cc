@@ -0,0 +1,242 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * locostats.cc - per-loco track refresh and RailCom quality statistics
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ * Loco::sendcmd() reports every packet sent to the STM32. The intervals of the last LOCOSTATS_WINDOW packets of
+ * each group give p50 and p99 of the refresh interval, so locos starving on a crowded layout stand out.
+ *
+ * The STM32 reports every 300 msec for one loco (round robin) the RC2 answer ratio of the last 50 packets, the
+ * latency of the last RailCom answer and the longest gap between two packets on the track since its last report.
+ * A decoder which answers rarely while its packets are sent regularly needs cleaning of wheels or pickups.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include "millis.h"
+#include "locostats.h"
+
+std::vector<LOCOSTATS>          LocoStats::stats;
+
+static const char *             group_names[LOCOSTATS_GROUPS] =
+{
+    "speed", "f00_f04", "f05_f08", "f09_f12", "f13_f20", "f21_f28"
+};
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get () - get statistics of loco, allocate if necessary
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+LOCOSTATS *
+LocoStats::get (uint_fast16_t loco_idx)
+{
+    while (LocoStats::stats.size () <= loco_idx)
+    {
+        LocoStats::stats.emplace_back ();
+        LocoStats::reset (LocoStats::stats.size () - 1);
+    }
+
+    return &LocoStats::stats[loco_idx];
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * reset () - reset statistics of loco, see Locos::init_runtime()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+LocoStats::reset (uint_fast16_t loco_idx)
+{
+    LOCOSTATS * sp;
+
+    if (loco_idx >= LocoStats::stats.size ())
+    {
+        (void) LocoStats::get (loco_idx);                                       // calls reset()
+        return;
+    }
+
+    sp = &LocoStats::stats[loco_idx];
+    memset (sp, 0, sizeof (LOCOSTATS));
+
+    sp->rc2_rate        = 0xFF;
+    sp->rc2_rate_min    = 0xFF;
+    sp->rc2_latency     = LOCOSTATS_NONE;
+    sp->rc2_latency_max = 0;
+    sp->track_gap       = LOCOSTATS_NONE;
+    sp->track_gap_max   = 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * restart () - loco has been activated: the time while it was inactive is no gap
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+LocoStats::restart (uint_fast16_t loco_idx)
+{
+    LOCOSTATS *     sp = LocoStats::get (loco_idx);
+    uint_fast8_t    group;
+
+    for (group = 0; group < LOCOSTATS_GROUPS; group++)
+    {
+        sp->groups[group].last_millis = 0;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * packet_sent () - packet of group has been sent to STM32 at time millis
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+LocoStats::packet_sent (uint_fast16_t loco_idx, uint_fast8_t group, uint32_t millis)
+{
+    LOCOSTATS_GROUP *   gp      = &LocoStats::get (loco_idx)->groups[group];
+
+    if (gp->last_millis)
+    {
+        uint32_t    interval = millis - gp->last_millis;
+
+        if (interval > 0xFFFE)
+        {
+            interval = 0xFFFE;
+        }
+
+        gp->samples[gp->sample_idx] = interval;
+        gp->sample_idx = (gp->sample_idx + 1) & (LOCOSTATS_WINDOW - 1);
+
+        if (gp->n_samples < LOCOSTATS_WINDOW)
+        {
+            gp->n_samples++;
+        }
+
+        if (gp->worst_gap < interval)
+        {
+            gp->worst_gap = interval;
+        }
+    }
+
+    gp->last_millis = millis ? millis : 1;
+    gp->n_packets++;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * packet_sent () - packet of group has been sent to STM32 now
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+LocoStats::packet_sent (uint_fast16_t loco_idx, uint_fast8_t group)
+{
+    LocoStats::packet_sent (loco_idx, group, Millis::elapsed ());
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * set_rc2 () - RC2 report of STM32, latency and track_gap are LOCOSTATS_NONE if unknown
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+LocoStats::set_rc2 (uint_fast16_t loco_idx, uint_fast8_t rate, uint_fast16_t latency, uint_fast16_t track_gap)
+{
+    LOCOSTATS * sp = LocoStats::get (loco_idx);
+
+    sp->n_rc2_reports++;
+    sp->rc2_rate    = rate;
+    sp->rc2_latency = latency;
+    sp->track_gap   = track_gap;
+
+    if (sp->rc2_rate_min == 0xFF || sp->rc2_rate_min > rate)
+    {
+        sp->rc2_rate_min = rate;
+    }
+
+    if (latency != LOCOSTATS_NONE && sp->rc2_latency_max < latency)
+    {
+        sp->rc2_latency_max = latency;
+    }
+
+    if (track_gap != LOCOSTATS_NONE && sp->track_gap_max < track_gap)
+    {
+        sp->track_gap_max = track_gap;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * percentile () - p-th percentile of n sorted values, interpolated linearly between the two nearest ranks
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint16_t
+LocoStats::percentile (const uint16_t * sorted, uint_fast8_t n, uint_fast8_t p)
+{
+    uint_fast32_t   pos     = p * (n - 1);                                      // position * 100
+    uint_fast8_t    idx     = pos / 100;
+    uint_fast8_t    frac    = pos % 100;
+
+    if (frac == 0)
+    {
+        return sorted[idx];
+    }
+
+    return sorted[idx] + ((sorted[idx + 1] - sorted[idx]) * frac) / 100;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_refresh () - get refresh intervals of packet group, values are LOCOSTATS_NONE if there are no samples
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+LocoStats::get_refresh (uint_fast16_t loco_idx, uint_fast8_t group, LOCOSTATS_REFRESH * refreshp)
+{
+    const LOCOSTATS_GROUP * gp = &LocoStats::get (loco_idx)->groups[group];
+    uint16_t                sorted[LOCOSTATS_WINDOW];
+    uint_fast8_t            n = gp->n_samples;
+
+    refreshp->n_packets = gp->n_packets;
+
+    if (n == 0)
+    {
+        refreshp->p50           = LOCOSTATS_NONE;
+        refreshp->p99           = LOCOSTATS_NONE;
+        refreshp->window_max    = LOCOSTATS_NONE;
+        refreshp->worst_gap     = LOCOSTATS_NONE;
+        return;
+    }
+
+    memcpy (sorted, gp->samples, n * sizeof (uint16_t));                        // samples 0 .. n - 1 are valid
+    std::sort (sorted, sorted + n);
+
+    refreshp->p50           = LocoStats::percentile (sorted, n, 50);
+    refreshp->p99           = LocoStats::percentile (sorted, n, 99);            // single outliers of the window don't count
+    refreshp->window_max    = sorted[n - 1];
+    refreshp->worst_gap     = gp->worst_gap;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_stats () - get statistics of loco
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+const LOCOSTATS *
+LocoStats::get_stats (uint_fast16_t loco_idx)
+{
+    return LocoStats::get (loco_idx);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_group_name () - get name of packet group
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+const char *
+LocoStats::get_group_name (uint_fast8_t group)
+{
+    return (group < LOCOSTATS_GROUPS) ? group_names[group] : "";
+}
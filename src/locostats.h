@@ -0,0 +1,86 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * locostats.h - per-loco track refresh and RailCom quality statistics
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef LOCOSTATS_H
+#define LOCOSTATS_H
+
+#include <stdint.h>
+#include <vector>
+
+#define LOCOSTATS_GROUP_SPEED               0                                   // speed packets
+#define LOCOSTATS_GROUP_F00_F04             1                                   // function groups
+#define LOCOSTATS_GROUP_F05_F08             2
+#define LOCOSTATS_GROUP_F09_F12             3
+#define LOCOSTATS_GROUP_F13_F20             4
+#define LOCOSTATS_GROUP_F21_F28             5
+#define LOCOSTATS_GROUPS                    6                                   // number of packet groups
+
+#define LOCOSTATS_WINDOW                    128                                 // number of intervals for p50/p99, power of 2, >= 100
+#define LOCOSTATS_NONE                      0xFFFF                              // no value
+
+typedef struct
+{
+    uint32_t            last_millis;                                            // time of last packet, 0: none
+    uint32_t            n_packets;                                              // number of packets since reset
+    uint16_t            worst_gap;                                              // max. interval since reset in msec
+    uint8_t             n_samples;                                              // number of valid samples
+    uint8_t             sample_idx;                                             // next sample to write
+    uint16_t            samples[LOCOSTATS_WINDOW];                              // last intervals in msec
+} LOCOSTATS_GROUP;
+
+typedef struct
+{
+    LOCOSTATS_GROUP     groups[LOCOSTATS_GROUPS];
+    uint32_t            n_rc2_reports;                                          // number of RC2 reports of STM32
+    uint8_t             rc2_rate;                                               // last RC2 answer ratio in percent
+    uint8_t             rc2_rate_min;                                           // min. RC2 answer ratio since reset
+    uint16_t            rc2_latency;                                            // msec from last packet to RC2 answer
+    uint16_t            rc2_latency_max;                                        // max. latency since reset
+    uint16_t            track_gap;                                              // max. gap between packets on track in last report
+    uint16_t            track_gap_max;                                          // max. gap on track since reset
+} LOCOSTATS;
+
+typedef struct
+{
+    uint32_t            n_packets;                                              // number of packets since reset
+    uint16_t            p50;                                                    // median of interval in msec
+    uint16_t            p99;                                                    // 99th percentile of interval in msec
+    uint16_t            window_max;                                             // max. interval in window
+    uint16_t            worst_gap;                                              // max. interval since reset
+} LOCOSTATS_REFRESH;
+
+class LocoStats
+{
+    public:
+        static void                     reset (uint_fast16_t loco_idx);
+        static void                     restart (uint_fast16_t loco_idx);
+        static void                     packet_sent (uint_fast16_t loco_idx, uint_fast8_t group);
+        static void                     packet_sent (uint_fast16_t loco_idx, uint_fast8_t group, uint32_t millis);
+        static void                     set_rc2 (uint_fast16_t loco_idx, uint_fast8_t rate, uint_fast16_t latency, uint_fast16_t track_gap);
+        static void                     get_refresh (uint_fast16_t loco_idx, uint_fast8_t group, LOCOSTATS_REFRESH * refreshp);
+        static const LOCOSTATS *        get_stats (uint_fast16_t loco_idx);
+        static const char *             get_group_name (uint_fast8_t group);
+
+    private:
+        static std::vector<LOCOSTATS>   stats;                                  // indexed by loco_idx
+        static LOCOSTATS *              get (uint_fast16_t loco_idx);
+        static uint16_t                 percentile (const uint16_t * sorted, uint_fast8_t n, uint_fast8_t p);
+};
+
+#endif
@@ -30,6 +30,7 @@
 #include "event.h"
 #include "loco.h"
 #include "http.h"
+#include "udp.h"
 #include "dcc.h"
 #include "switch.h"
 #include "led.h"
@@ -37,12 +38,15 @@
 #include "s88.h"
 #include "rcl.h"
 #include "fileio.h"
+#include "journal.h"
 #include "serial.h"
 #include "msg.h"
 #include "gpio.h"
 #include "stm32.h"
 #include "millis.h"
 #include "debug.h"
+#include "metrics.h"
+#include "recorder.h"
 
 #define SWITCH_FIRST_PERIOD     500
 #define SIGNAL_FIRST_PERIOD     700
@@ -52,13 +56,16 @@
 static void
 usage (char * pgm)
 {
-    fprintf (stderr, "usage: %s [-e] [-d level]\n", pgm);
+    fprintf (stderr, "usage: %s [-e] [-d level] [-d subsystem=level] [-r tracefile | -R tracefile [-x speed]]\n", pgm);
+    fprintf (stderr, "subsystems: general, dcc, msg, s88, rcl\n");
+    fprintf (stderr, "-r: record serial traffic and HTTP requests, -R: replay trace, -x: replay n times faster\n");
     exit (1);
 }
 
 #define MAX_ARGS                8
 #define SHUTDOWN_TIME           1000
 static uint32_t                 next_exit;
+static volatile sig_atomic_t    restart;                                    // set by SIGHUP, restart is done in main loop
 static char *                   pgm_argv[8];
 
 static void
@@ -74,10 +81,7 @@ myalarm (int sig)
     }
     else if (sig == SIGHUP)
     {
-        Debug::printf (DEBUG_LEVEL_NORMAL, "restarting\n");
-        HTTP::deinit ();
-        execv (pgm_argv[0], pgm_argv);
-        exit (0);
+        restart = 1;                                                        // deinit takes mutexes and joins threads
     }
 }
 
@@ -94,6 +98,10 @@ main (int argc, char ** argv)
     unsigned long   current_millis;
     uint_fast16_t   n_contacts;
     bool            edit_mode = false;
+    bool            warm_restart;
+    const char *    record_fname = (char *) NULL;
+    const char *    replay_fname = (char *) NULL;
+    uint_fast16_t   replay_speed = 1;
     int             i;
 
     char * pgm = argv[0];
@@ -115,8 +123,50 @@ main (int argc, char ** argv)
         }
         else if (argc > 2 && ! strcmp (argv[1], "-d"))
         {
-            uint_fast8_t    level = atoi (argv[2]);
-            Debug::set_level (level);
+            char *          eq = strchr (argv[2], '=');
+
+            if (eq)                                                         // subsystem=level, argv must not be modified, see execv ()
+            {
+                char    name[16];
+                size_t  len = eq - argv[2];
+
+                if (len >= sizeof (name))
+                {
+                    usage (pgm);
+                }
+
+                memcpy (name, argv[2], len);
+                name[len] = '\0';
+
+                if (! Debug::set_level (name, atoi (eq + 1)))
+                {
+                    usage (pgm);
+                }
+            }
+            else
+            {
+                uint_fast8_t    level = atoi (argv[2]);
+                Debug::set_level (level);
+            }
+
+            argc -= 2;
+            argv += 2;
+        }
+        else if (argc > 2 && ! strcmp (argv[1], "-r"))
+        {
+            record_fname = argv[2];
+            argc -= 2;
+            argv += 2;
+        }
+        else if (argc > 2 && ! strcmp (argv[1], "-R"))
+        {
+            replay_fname = argv[2];
+            argc -= 2;
+            argv += 2;
+        }
+        else if (argc > 2 && ! strcmp (argv[1], "-x"))
+        {
+            replay_speed = atoi (argv[2]);
             argc -= 2;
             argv += 2;
         }
@@ -126,24 +176,52 @@ main (int argc, char ** argv)
         }
     }
 
+    if ((record_fname && replay_fname) || replay_speed == 0)
+    {
+        usage (pgm);
+    }
+
     signal (SIGHUP, myalarm);
     signal (SIGINT, myalarm);
 
+    Debug::init ();
+
+    if (record_fname && ! Recorder::start_record (record_fname))
+    {
+        exit (1);
+    }
+
+    if (replay_fname && ! Recorder::start_replay (replay_fname, replay_speed))
+    {
+        exit (1);
+    }
+
     FileIO::read_all_ini_files ();
+    FileIO::init ();
 
     Serial::init ();
     HTTP::init ();
+    UDP::init ();
     Millis::init ();
     DCC::init ();
     S88::init ();
     RCL::init ();
     STM32::init ();
 
-    GPIO::activate_stm32_nrst ();                                           // reset STM32
-    usleep (1000);                                                          // wait 1msec
-    MSG::flush_msg ();                                                      // flush input
-    GPIO::deactivate_stm32_nrst ();                                         // boot STM32
-    usleep (200000);                                                        // wait 200msec for STM32 boot
+    warm_restart = Journal::init ();                                        // restore runtime state
+
+    if (warm_restart)                                                       // STM32 is still running, don't stop trains
+    {
+        MSG::flush_msg ();                                                  // flush input
+    }
+    else
+    {
+        GPIO::activate_stm32_nrst ();                                       // reset STM32
+        usleep (1000);                                                      // wait 1msec
+        MSG::flush_msg ();                                                  // flush input
+        GPIO::deactivate_stm32_nrst ();                                     // boot STM32
+        usleep (200000);                                                    // wait 200msec for STM32 boot
+    }
 
     current_millis  = Millis::elapsed ();
     switch_millis   = current_millis + SWITCH_FIRST_PERIOD;                 // 1st switch scheduling in 500 msec
@@ -160,8 +238,30 @@ main (int argc, char ** argv)
     {
         current_millis = Millis::elapsed ();
 
+        if (! next_exit && Recorder::replay_finished ())
+        {
+            next_exit = current_millis + 1;
+        }
+
         if (next_exit && current_millis >= next_exit)
         {
+            Journal::deinit (false);
+            FileIO::deinit ();
+            Recorder::deinit ();
+            Debug::deinit ();
+            exit (0);
+        }
+
+        if (restart)
+        {
+            Debug::printf (DEBUG_LEVEL_NORMAL, "restarting\n");
+            Journal::deinit (true);
+            HTTP::deinit ();
+            UDP::deinit ();
+            FileIO::deinit ();
+            Recorder::deinit ();
+            Debug::deinit ();
+            execv (pgm_argv[0], pgm_argv);
             exit (0);
         }
 
@@ -182,15 +282,21 @@ main (int argc, char ** argv)
             bool loco_sched_rtc;
 
             next_millis = current_millis + SCHEDULE_PERIOD;
+            Metrics::loop_period (SCHEDULE_PERIOD * 1000);
             Event::schedule ();
 
             do
             {
+                uint32_t pass_start = Metrics::micros ();
+
                 loco_sched_rtc = Locos::schedule ();
                 S88::schedule ();
                 RCL::schedule ();
                 MSG::read_msg ();
                 edit_mode = HTTP::server (edit_mode);
+                UDP::server ();
+                FileIO::schedule ();
+                Journal::schedule ();
 
                 if (S88::get_n_contacts_changed ())                         // STM32 could have been resetted and forgot number of cntacts
                 {
@@ -198,7 +304,9 @@ main (int argc, char ** argv)
                     DCC::set_s88_n_contacts (n_contacts);
                     Debug::printf (DEBUG_LEVEL_VERBOSE, "main: number of contacts changed, sending number of contacts: %d\n", n_contacts);
                 }
-            } while (loco_sched_rtc == 0);                                  // schedule all active locos
+
+                Metrics::observe (METRICS_HIST_LOOP_TIME, Metrics::micros () - pass_start);
+            } while (loco_sched_rtc == 0 && ! Recorder::replay_finished ());  // schedule all active locos
         }
     }
 
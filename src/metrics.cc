@@ -0,0 +1,190 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * metrics.cc - counters and latency histograms
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "metrics.h"
+#include "debug.h"
+
+std::atomic<uint32_t>           Metrics::counters[METRICS_COUNTERS];
+std::atomic<uint32_t>           Metrics::dcc_commands[METRICS_DCC_COMMANDS];
+METRICS_HISTOGRAM               Metrics::histograms[METRICS_HISTOGRAMS];
+METRICS_HTTP_ACTION             Metrics::http_actions[METRICS_MAX_HTTP_ACTIONS];
+uint_fast16_t                   Metrics::n_http_actions;
+uint32_t                        Metrics::last_loop_start;
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * micros () - monotonic time in microseconds, wraps after 71 minutes. Use only for differences.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint32_t
+Metrics::micros (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ts.tv_sec * 1000000U + (uint32_t) (ts.tv_nsec / 1000);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * observe () - add observation to histogram
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Metrics::observe (uint_fast8_t hist, uint32_t usec)
+{
+    METRICS_HISTOGRAM * h = &Metrics::histograms[hist];
+    uint_fast8_t        bucket;
+
+    bucket = (usec <= 1) ? 0 : 32 - __builtin_clz (usec - 1);                   // smallest n with usec <= 2^n
+
+    if (bucket > METRICS_HIST_BUCKETS - 1)
+    {
+        bucket = METRICS_HIST_BUCKETS - 1;
+    }
+
+    h->buckets[bucket].fetch_add (1, std::memory_order_relaxed);
+    h->count.fetch_add (1, std::memory_order_relaxed);
+    h->sum.fetch_add (usec, std::memory_order_relaxed);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * loop_period () - start of scheduling period of main loop, observes deviation from nominal period period_usec
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Metrics::loop_period (uint32_t period_usec)
+{
+    uint32_t    now = Metrics::micros ();
+
+    if (Metrics::last_loop_start)
+    {
+        uint32_t    period = now - Metrics::last_loop_start;
+
+        Metrics::observe (METRICS_HIST_LOOP_JITTER, period > period_usec ? period - period_usec : period_usec - period);
+    }
+
+    Metrics::last_loop_start = now;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * add_http_action () - register HTTP action, returns index or 0xFFFF if table is full
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Metrics::add_http_action (const char * name)
+{
+    uint_fast16_t   idx;
+
+    for (idx = 0; idx < Metrics::n_http_actions; idx++)
+    {
+        if (! strcmp (Metrics::http_actions[idx].name, name))
+        {
+            return idx;
+        }
+    }
+
+    if (Metrics::n_http_actions >= METRICS_MAX_HTTP_ACTIONS)
+    {
+        Debug::printf (DEBUG_LEVEL_NORMAL, "Metrics::add_http_action: table full, no metrics for action '%s'\n", name);
+        return 0xFFFF;
+    }
+
+    Metrics::http_actions[idx].name = name;
+    Metrics::n_http_actions++;
+    return idx;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * http_action () - count HTTP action and its duration
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Metrics::http_action (uint_fast16_t action_idx, uint32_t usec)
+{
+    if (action_idx < Metrics::n_http_actions)
+    {
+        Metrics::http_actions[action_idx].count.fetch_add (1, std::memory_order_relaxed);
+        Metrics::http_actions[action_idx].sum.fetch_add (usec, std::memory_order_relaxed);
+    }
+
+    Metrics::observe (METRICS_HIST_HTTP_ACTION, usec);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_counter () - get value of counter
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint32_t
+Metrics::get_counter (uint_fast8_t counter)
+{
+    return Metrics::counters[counter].load (std::memory_order_relaxed);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_dcc_commands () - get number of sent DCC commands of type cmd
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint32_t
+Metrics::get_dcc_commands (uint_fast8_t cmd)
+{
+    return Metrics::dcc_commands[cmd].load (std::memory_order_relaxed);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_histogram () - get snapshot of histogram
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Metrics::get_histogram (uint_fast8_t hist, METRICS_HISTOGRAM_VALUES * valuesp)
+{
+    METRICS_HISTOGRAM * h = &Metrics::histograms[hist];
+    uint_fast8_t        bucket;
+
+    for (bucket = 0; bucket < METRICS_HIST_BUCKETS; bucket++)
+    {
+        valuesp->buckets[bucket] = h->buckets[bucket].load (std::memory_order_relaxed);
+    }
+
+    valuesp->count  = h->count.load (std::memory_order_relaxed);
+    valuesp->sum    = h->sum.load (std::memory_order_relaxed);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_n_http_actions () - get number of registered HTTP actions
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Metrics::get_n_http_actions (void)
+{
+    return Metrics::n_http_actions;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_http_action () - get name, number of requests and sum of durations of HTTP action
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+const char *
+Metrics::get_http_action (uint_fast16_t action_idx, uint32_t * countp, uint64_t * sump)
+{
+    *countp = Metrics::http_actions[action_idx].count.load (std::memory_order_relaxed);
+    *sump   = Metrics::http_actions[action_idx].sum.load (std::memory_order_relaxed);
+    return Metrics::http_actions[action_idx].name;
+}
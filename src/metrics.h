@@ -0,0 +1,116 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * metrics.h - counters and latency histograms
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <atomic>
+
+#define METRICS_COUNTER_UART_RX_BYTES           0                               // bytes read from STM32
+#define METRICS_COUNTER_UART_TX_BYTES           1                               // bytes written to STM32
+#define METRICS_COUNTER_MSG_FRAMES              2                               // frames parsed by MSG::read_msg()
+#define METRICS_COUNTER_MSG_ERRORS              3                               // framing errors and invalid messages
+#define METRICS_COUNTER_DCC_STOP_TIMEOUTS       4                               // no CONTINUE after STOP within 100 msec
+#define METRICS_COUNTER_POM_READS               5                               // POM/XPOM reads
+#define METRICS_COUNTER_POM_RETRIES             6                               // POM/XPOM read retries
+#define METRICS_COUNTER_POM_FAILURES            7                               // POM/XPOM reads failed after all retries
+#define METRICS_COUNTER_PGM_READS               8                               // PGM reads
+#define METRICS_COUNTER_PGM_FAILURES            9                               // PGM reads without answer
+#define METRICS_COUNTER_S88_EDGES               10                              // S88 contact gets occupied or free
+#define METRICS_COUNTER_RCL_EDGES               11                              // RailCom location entered or left
+#define METRICS_COUNTERS                        12                              // number of counters
+
+#define METRICS_HIST_LOOP_TIME                  0                               // duration of one pass of main loop
+#define METRICS_HIST_LOOP_JITTER                1                               // deviation of main loop period
+#define METRICS_HIST_DCC_STOP_WAIT              2                               // wait for CONTINUE after STOP
+#define METRICS_HIST_POM_READ                   3                               // POM/XPOM read including retries
+#define METRICS_HIST_PGM_READ                   4                               // PGM read
+#define METRICS_HIST_HTTP_ACTION                5                               // HTTP action, all actions
+#define METRICS_HISTOGRAMS                      6                               // number of histograms
+
+#define METRICS_HIST_BUCKETS                    24                              // upper bounds 1, 2, 4 ... 2^22 usec, +Inf
+#define METRICS_DCC_COMMANDS                    256                             // indexed by command byte
+#define METRICS_MAX_HTTP_ACTIONS                256                             // max. number of registered actions
+
+typedef struct
+{
+    std::atomic<uint32_t>   buckets[METRICS_HIST_BUCKETS];                      // bucket n: usec <= 2^n, last bucket: +Inf
+    std::atomic<uint32_t>   count;                                              // number of observations
+    std::atomic<uint64_t>   sum;                                                // sum of observations in usec
+} METRICS_HISTOGRAM;
+
+typedef struct
+{
+    uint32_t                buckets[METRICS_HIST_BUCKETS];                      // not cumulative
+    uint32_t                count;
+    uint64_t                sum;
+} METRICS_HISTOGRAM_VALUES;
+
+typedef struct
+{
+    const char *            name;                                               // name of action
+    std::atomic<uint32_t>   count;                                              // number of requests
+    std::atomic<uint64_t>   sum;                                                // sum of durations in usec
+} METRICS_HTTP_ACTION;
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * All counters are updated with relaxed atomic operations: an update costs a few nanoseconds and the HTTP handler
+ * of /metrics may read them at any time without locking.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+class Metrics
+{
+    public:
+        static uint32_t                 micros (void);
+        static void                     observe (uint_fast8_t hist, uint32_t usec);
+        static void                     loop_period (uint32_t period_usec);
+        static uint_fast16_t            add_http_action (const char * name);
+        static void                     http_action (uint_fast16_t action_idx, uint32_t usec);
+        static uint32_t                 get_counter (uint_fast8_t counter);
+        static uint32_t                 get_dcc_commands (uint_fast8_t cmd);
+        static void                     get_histogram (uint_fast8_t hist, METRICS_HISTOGRAM_VALUES * valuesp);
+        static uint_fast16_t            get_n_http_actions (void);
+        static const char *             get_http_action (uint_fast16_t action_idx, uint32_t * countp, uint64_t * sump);
+
+        static void count (uint_fast8_t counter)
+        {
+            counters[counter].fetch_add (1, std::memory_order_relaxed);
+        }
+
+        static void add (uint_fast8_t counter, uint32_t n)
+        {
+            counters[counter].fetch_add (n, std::memory_order_relaxed);
+        }
+
+        static void dcc_command (uint_fast8_t cmd)
+        {
+            dcc_commands[cmd].fetch_add (1, std::memory_order_relaxed);
+        }
+
+    private:
+        static std::atomic<uint32_t>    counters[METRICS_COUNTERS];
+        static std::atomic<uint32_t>    dcc_commands[METRICS_DCC_COMMANDS];
+        static METRICS_HISTOGRAM        histograms[METRICS_HISTOGRAMS];
+        static METRICS_HTTP_ACTION      http_actions[METRICS_MAX_HTTP_ACTIONS];
+        static uint_fast16_t            n_http_actions;
+        static uint32_t                 last_loop_start;                        // start of previous period, 0: none
+};
+
+#endif
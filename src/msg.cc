@@ -19,15 +19,20 @@
  */
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <string>
 #include "userio.h"
 #include "loco.h"
+#include "rcl.h"
 #include "s88.h"
 #include "dcc.h"
 #include "serial.h"
 #include "msg.h"
 #include "debug.h"
 #include "http.h"
+#include "fm22.h"
+#include "metrics.h"
+#include "locostats.h"
 
 #define MSG_ALERT                           0x01
 #define MSG_ADC                             0x03    // todo: renumber: 0x02
@@ -42,6 +47,8 @@
 
 #define MSG_DEBUG_MESSAGE                   0x20
 
+#define MSG_RC2_UNKNOWN                     0xFFFF          // latency or gap unknown, see MSG::loco_rc2_rate()
+
 #define GET8(p,o)                           (*((p) + o))
 #define GET16(p,o)                          ((*((p) + o) << 8) + (*((p) + 1 + o)))
 
@@ -58,6 +65,11 @@
 #define MSG_STATE_WAIT_FOR_LEN              1
 #define MSG_STATE_WAIT_FOR_FRAME_END        2
 
+#define MSG_RC2_BYTES                       (MAX_LOCOS / 8)
+
+static uint8_t                              rc2_bits[MSG_RC2_BYTES];                // last received rc2 bitmap
+static std::vector<uint16_t>                rc2_going_offline;                      // locos missing in rc2 bitmap, but still online
+
 void
 MSG::alert (uint8_t * bufp, uint_fast8_t len)
 {
@@ -89,8 +101,14 @@ MSG::adc (uint8_t * bufp, uint_fast8_t len)
 {
     if (len == 4)
     {
-        bool    b_on = GET8(bufp, 1);
-        DCC::adc_value = GET16(bufp, 2);
+        bool            b_on        = GET8(bufp, 1);
+        uint_fast16_t   adc_value   = GET16(bufp, 2);
+
+        if (DCC::adc_value != adc_value)
+        {
+            DCC::adc_value = adc_value;
+            FM22::state_changed ();
+        }
 
         if (b_on)
         {
@@ -99,6 +117,7 @@ MSG::adc (uint8_t * bufp, uint_fast8_t len)
                 Debug::printf (DEBUG_LEVEL_VERBOSE, "msg_adc (): booster is already on\n");
                 UserIO::booster_on (false);
                 DCC::booster_is_on = 1;
+                FM22::state_changed ();
             }
         }
         else
@@ -108,6 +127,7 @@ MSG::adc (uint8_t * bufp, uint_fast8_t len)
                 Debug::printf (DEBUG_LEVEL_VERBOSE, "msg_adc (): perhaps shortcut or STM32 reset: adc=%u\n", DCC::adc_value);
                 UserIO::booster_off (false);
                 DCC::booster_is_on = 0;
+                FM22::state_changed ();
             }
         }
     }
@@ -118,53 +138,102 @@ MSG::rc1 (uint8_t * bufp, uint_fast8_t len)
 {
     if (len == 3)
     {
-        DCC::rc1_value = GET16(bufp, 1);
+        uint_fast16_t   rc1_value = GET16(bufp, 1);
+
+        if (DCC::rc1_value != rc1_value)
+        {
+            DCC::rc1_value = rc1_value;
+            FM22::state_changed ();
+        }
     }
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ *  MSG::rc2 () - handle bitmap of locos detected by global RAILCOM detector, sent every 100 msec
+ *
+ *  Only locos whose bit changed are updated. Locos which disappeared are kept in a list until they are
+ *  offline, because Loco::set_online () takes some missing bitmaps until a loco is offline.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
 void
 MSG::rc2 (uint8_t * bufp, uint_fast8_t len)
 {
     if (len >= 1)
     {
-        uint_fast8_t    nbytes = len - 1;
-        uint_fast8_t    bitpos;
-        uint_fast8_t    idx;
+        uint_fast16_t   nbytes  = len - 1;
         uint_fast16_t   n_locos = Locos::get_n_locos ();
-        uint_fast16_t   loco_idx = 0;
+        uint_fast16_t   idx;
 
-        for (idx = 0; idx < nbytes; idx++)
+        for (idx = 0; idx < MSG_RC2_BYTES && 8 * idx < n_locos; idx++)
         {
-            for (bitpos = 0; bitpos < 8; bitpos++)
+            uint_fast8_t    bits    = (idx < nbytes) ? bufp[1 + idx] : 0x00;
+            uint_fast8_t    changed = bits ^ rc2_bits[idx];
+
+            while (changed)
             {
-                loco_idx = 8 * idx + bitpos;
+                uint_fast8_t    bitpos      = __builtin_ctz (changed);
+                uint_fast16_t   loco_idx    = 8 * idx + bitpos;
+
+                changed &= changed - 1;
 
                 if (loco_idx < n_locos)
                 {
-                    if (bufp[1 + idx] & (1 << bitpos))
+                    if (bits & (1 << bitpos))
                     {
+                        if (! Locos::locos[loco_idx].is_online ())
+                        {
+                            FM22::state_changed ();
+                        }
+
                         Locos::locos[loco_idx].set_online (1);
                     }
                     else
                     {
-                        Locos::locos[loco_idx].set_online (0);
+                        rc2_going_offline.push_back (loco_idx);
                     }
                 }
-                else
-                {
-                    break;
-                }
             }
+
+            rc2_bits[idx] = bits;
         }
 
-        while (loco_idx < n_locos)
+        idx = 0;
+
+        while (idx < rc2_going_offline.size ())
         {
-            Locos::locos[loco_idx].set_online (0);
-            loco_idx++;
+            uint_fast16_t   loco_idx = rc2_going_offline[idx];
+
+            if (loco_idx < n_locos && ! (rc2_bits[loco_idx / 8] & (1 << (loco_idx % 8))) && Locos::locos[loco_idx].is_online ())
+            {
+                Locos::locos[loco_idx].set_online (0);
+
+                if (! Locos::locos[loco_idx].is_online ())
+                {
+                    FM22::state_changed ();
+                }
+
+                idx++;
+            }
+            else                                                                    // back again or offline now
+            {
+                rc2_going_offline[idx] = rc2_going_offline.back ();
+                rc2_going_offline.pop_back ();
+            }
         }
     }
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ *  MSG::rc2_resync () - treat all locos as present in last rc2 bitmap, next bitmap updates all missing locos
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+MSG::rc2_resync (void)
+{
+    memset (rc2_bits, 0xFF, sizeof (rc2_bits));
+    rc2_going_offline.clear ();
+}
+
 void
 MSG::rcl (uint8_t * bufp, uint_fast8_t len)
 {
@@ -183,9 +252,15 @@ MSG::rcl (uint8_t * bufp, uint_fast8_t len)
             loco_idx |= *bufp++;
             location = *bufp++;
 
-            Locos::locos[loco_idx].set_rcllocation (location);
+            if (loco_idx < Locos::get_n_locos ())
+            {
+                uint_fast8_t    old_location = Locos::locos[loco_idx].get_rcllocation ();
+
+                Locos::locos[loco_idx].set_rcllocation (location);
+                RCL::location_changed (loco_idx, old_location, Locos::locos[loco_idx].get_rcllocation ());
+            }
 
-            Debug::printf (DEBUG_LEVEL_VERBOSE, "MSG::rcl: loco=%d location=%d\n", loco_idx, location);
+            DEBUG_TRACE (DEBUG_SUBSYSTEM_MSG, DEBUG_LEVEL_VERBOSE, "MSG::rcl: loco=%d location=%d\n", (uint16_t) loco_idx, location);
 
             idx += 3;
         }
@@ -241,15 +316,51 @@ MSG::pgm_cv (uint8_t * bufp, uint_fast8_t len)
     }
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ *  MSG::loco_rc2_rate () - RC2 rate of a loco. Newer firmware also sends the latency of the last RC2 answer and the
+ *  max. gap between two packets on the track in msec, older firmware sends only 4 bytes. Both values are
+ *  MSG_RC2_UNKNOWN if the STM32 has no RC2 info of the loco or the last command has not been answered.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
 void
 MSG::loco_rc2_rate (uint8_t * bufp, uint_fast8_t len)
 {
-    if (len == 4)
+    if (len == 4 || len == 8)
     {
-        uint_fast16_t   loco_idx = GET16(bufp, 1);
-        uint_fast8_t    rc2_rate = GET8(bufp, 3);
+        uint_fast16_t   loco_idx    = GET16(bufp, 1);
+        uint_fast8_t    rc2_rate    = GET8(bufp, 3);
+        uint_fast16_t   latency     = LOCOSTATS_NONE;
+        uint_fast16_t   track_gap   = LOCOSTATS_NONE;
 
-        Locos::locos[loco_idx].set_rc2_rate (rc2_rate);
+        if (len == 8)
+        {
+            uint_fast16_t   value;
+
+            value = GET16(bufp, 4);
+
+            if (value != MSG_RC2_UNKNOWN)
+            {
+                latency = value;
+            }
+
+            value = GET16(bufp, 6);
+
+            if (value != MSG_RC2_UNKNOWN)
+            {
+                track_gap = value;
+            }
+        }
+
+        if (loco_idx < Locos::get_n_locos ())
+        {
+            if (Locos::locos[loco_idx].get_rc2_rate () != rc2_rate)
+            {
+                FM22::state_changed ();
+            }
+
+            Locos::locos[loco_idx].set_rc2_rate (rc2_rate);
+            LocoStats::set_rc2 (loco_idx, rc2_rate, latency, track_gap);
+        }
     }
 }
 
@@ -264,7 +375,7 @@ MSG::s88 (uint8_t * bufp, uint_fast8_t len)
         for (idx = 0; idx < n_bytes && idx < n_bytes; idx++)
         {
             uint_fast8_t   nstatus = GET8(bufp, idx + 2);
-            Debug::printf (DEBUG_LEVEL_VERBOSE, "MSG::s88: idx=%u nstatus=%u\n", idx, nstatus);
+            DEBUG_TRACE (DEBUG_SUBSYSTEM_MSG, DEBUG_LEVEL_VERBOSE, "MSG::s88: idx=%u nstatus=%u\n", idx, nstatus);
             S88::set_newstate_byte (idx, nstatus);
         }
     }
@@ -312,6 +423,7 @@ MSG::msg (uint8_t * buf, uint_fast8_t len)
 
         default:
             Debug::printf (DEBUG_LEVEL_NORMAL, "msg: invalid msg: 0x%02X\n", buf[0]);
+            Metrics::count (METRICS_COUNTER_MSG_ERRORS);
             break;
     }
 }
@@ -359,6 +471,7 @@ MSG::read_msg (void)
             else
             {
                 Debug::printf (DEBUG_LEVEL_NORMAL, "read_msg: error: ch=0x%02X\n", ch);
+                Metrics::count (METRICS_COUNTER_MSG_ERRORS);
             }
         }
         else if (msg_state == MSG_STATE_WAIT_FOR_LEN)
@@ -383,6 +496,7 @@ MSG::read_msg (void)
                 }
 
                 Debug::printf (DEBUG_LEVEL_NORMAL, "read_msg: expected length, got 0x%02X\n", ch);
+                Metrics::count (METRICS_COUNTER_MSG_ERRORS);
             }
         }
         else if (msg_state == MSG_STATE_WAIT_FOR_FRAME_END)
@@ -408,7 +522,8 @@ MSG::read_msg (void)
                 {
                     if (ch == MSG_FRAME_END)
                     {
-                        MSG::msg (buf, bufidx);
+                        Metrics::count (METRICS_COUNTER_MSG_FRAMES);
+                        MSG::msg (buf, bufidx);                 // handlers call FM22::state_changed () on changes only
                     }
                     else
                     {
@@ -421,6 +536,7 @@ MSG::read_msg (void)
                         }
 
                         Debug::printf (DEBUG_LEVEL_NORMAL, "read_msg: expected MSG_FRAME_END, got 0x%02X\n", ch);
+                        Metrics::count (METRICS_COUNTER_MSG_ERRORS);
                     }
 
                     msg_state = MSG_STATE_WAIT_FOR_FRAME_START;
@@ -25,6 +25,7 @@ class MSG
     public:
         static void         flush_msg (void);
         static void         read_msg (void);
+        static void         rc2_resync (void);
     private:
         static void         alert (uint8_t * bufp, uint_fast8_t len);
         static void         adc (uint8_t * bufp, uint_fast8_t len);
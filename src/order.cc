@@ -0,0 +1,177 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * order.cc - display order of objects with stable indexes
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <algorithm>
+#include "order.h"
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  add () - append next index at end of display order
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+DisplayOrder::add (void)
+{
+    uint16_t    idx = this->order.size ();
+
+    this->order.push_back (idx);
+    this->positions.push_back (idx);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  remove () - remove index, following indexes are decremented like the objects in their vector
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+DisplayOrder::remove (uint_fast16_t idx)
+{
+    uint_fast16_t   n = this->order.size ();
+    uint_fast16_t   pos;
+
+    if (idx < n)
+    {
+        this->order.erase (this->order.begin() + this->positions[idx]);
+        this->positions.pop_back ();
+        n--;
+
+        for (pos = 0; pos < n; pos++)
+        {
+            if (this->order[pos] > idx)
+            {
+                this->order[pos]--;
+            }
+
+            this->positions[this->order[pos]] = pos;
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  clear () - remove all indexes
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+DisplayOrder::clear (void)
+{
+    this->order.clear ();
+    this->positions.clear ();
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  get_position () - get position of index in display order, 0xFFFF if invalid
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+DisplayOrder::get_position (uint_fast16_t idx)
+{
+    if (idx < this->positions.size ())
+    {
+        return this->positions[idx];
+    }
+
+    return 0xFFFF;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  get_idx () - get index at position in display order, 0xFFFF if invalid
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+DisplayOrder::get_idx (uint_fast16_t position)
+{
+    if (position < this->order.size ())
+    {
+        return this->order[position];
+    }
+
+    return 0xFFFF;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_position () - move index to new position. Only the entries between old and new position are rotated, the
+ *  cost depends on the distance, not on the number of objects. Returns false if idx or new_position is invalid.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+DisplayOrder::set_position (uint_fast16_t idx, uint_fast16_t new_position)
+{
+    uint_fast16_t   n = this->order.size ();
+    uint_fast16_t   position;
+    uint_fast16_t   first;
+    uint_fast16_t   last;
+    uint_fast16_t   pos;
+
+    if (idx >= n || new_position >= n)
+    {
+        return false;
+    }
+
+    position = this->positions[idx];
+
+    if (position < new_position)
+    {
+        first   = position;
+        last    = new_position;
+        std::rotate (this->order.begin() + first, this->order.begin() + first + 1, this->order.begin() + last + 1);
+    }
+    else if (position > new_position)
+    {
+        first   = new_position;
+        last    = position;
+        std::rotate (this->order.begin() + first, this->order.begin() + last, this->order.begin() + last + 1);
+    }
+    else
+    {
+        return true;
+    }
+
+    for (pos = first; pos <= last; pos++)
+    {
+        this->positions[this->order[pos]] = pos;
+    }
+
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_order () - set display order after reading ini file, new_positions[idx] may contain gaps or duplicates
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+DisplayOrder::set_order (std::vector<uint16_t>& new_positions)
+{
+    uint_fast16_t   n = new_positions.size ();
+    uint_fast16_t   pos;
+
+    this->order.resize (n);
+    this->positions.resize (n);
+
+    for (pos = 0; pos < n; pos++)
+    {
+        this->order[pos] = pos;
+    }
+
+    std::stable_sort (this->order.begin(), this->order.end(),
+                      [&new_positions](uint16_t a, uint16_t b) { return new_positions[a] < new_positions[b]; });
+
+    for (pos = 0; pos < n; pos++)
+    {
+        this->positions[this->order[pos]] = pos;
+    }
+}
@@ -0,0 +1,49 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * order.h - display order of objects with stable indexes
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef ORDER_H
+#define ORDER_H
+
+#include <stdint.h>
+#include <vector>
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * DisplayOrder - order of objects in lists and select boxes
+ *
+ * Objects keep their index when they are moved in a list, so no references in other objects, events and actions have
+ * to be corrected. order[] contains the indexes in display order, positions[] the position of each index.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+class DisplayOrder
+{
+    public:
+        void                            add (void);
+        void                            remove (uint_fast16_t idx);
+        void                            clear (void);
+        uint_fast16_t                   get_position (uint_fast16_t idx);
+        uint_fast16_t                   get_idx (uint_fast16_t position);
+        bool                            set_position (uint_fast16_t idx, uint_fast16_t new_position);
+        void                            set_order (std::vector<uint16_t>& new_positions);
+
+    private:
+        std::vector<uint16_t>           order;                                  // indexes in display order
+        std::vector<uint16_t>           positions;                              // position of each index in display order
+};
+
+#endif
@@ -26,6 +26,7 @@
 
 #include "dcc.h"
 #include "pom.h"
+#include "metrics.h"
 
 #define POM_READ_MAX_TRIES      10
 #define XPOM_READ_MAX_TRIES     20
@@ -33,6 +34,23 @@
 uint32_t                        POM::sum_retries;
 uint32_t                        POM::sum_reads;
 
+/*------------------------------------------------------------------------------------------------------------------------
+ * count_read () - update metrics of a POM or XPOM read
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+POM::count_read (uint32_t start, uint_fast8_t tries, bool success)
+{
+    Metrics::observe (METRICS_HIST_POM_READ, Metrics::micros () - start);
+    Metrics::count (METRICS_COUNTER_POM_READS);
+    Metrics::add (METRICS_COUNTER_POM_RETRIES, tries);
+
+    if (! success)
+    {
+        Metrics::count (METRICS_COUNTER_POM_FAILURES);
+    }
+}
+
 /*------------------------------------------------------------------------------------------------------------------------
  * pom_read_cv () - read value of CV
  *------------------------------------------------------------------------------------------------------------------------
@@ -40,6 +58,7 @@ uint32_t                        POM::sum_reads;
 bool
 POM::pom_read_cv (uint_fast8_t * valuep, uint_fast16_t addr, uint16_t cv)
 {
+    uint32_t        start = Metrics::micros ();
     uint_fast8_t    tries;
     bool            rtc = false;
 
@@ -56,6 +75,7 @@ POM::pom_read_cv (uint_fast8_t * valuep, uint_fast16_t addr, uint16_t cv)
 
     sum_retries += tries;
     sum_reads++;
+    POM::count_read (start, tries, rtc);
 
     return rtc;
 }
@@ -70,6 +90,7 @@ POM::pom_read_cv (uint_fast8_t * valuep, uint_fast16_t addr, uint16_t cv)
 bool
 POM::xpom_read_cv (uint8_t * valuep, uint_fast8_t n, uint_fast16_t addr, uint_fast8_t cv31, uint_fast8_t cv32, uint_fast8_t cv)
 {
+    uint32_t        start = Metrics::micros ();
     uint_fast8_t    tries;
     bool            rtc = false;
 
@@ -83,6 +104,7 @@ POM::xpom_read_cv (uint8_t * valuep, uint_fast8_t n, uint_fast16_t addr, uint_fa
     }
     sum_retries += tries;
     sum_reads += 4 * n;
+    POM::count_read (start, tries, rtc);
 
     return rtc;
 }
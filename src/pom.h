@@ -40,6 +40,7 @@ class POM
     private:
         static uint32_t sum_retries;
         static uint32_t sum_reads;
+        static void     count_read (uint32_t start, uint_fast8_t tries, bool success);
 };
 
 #endif
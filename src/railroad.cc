@@ -25,11 +25,15 @@
 #include "s88.h"
 #include "rcl.h"
 #include "railroad.h"
+#include "interlock.h"
+#include "topology.h"
+#include "automation.h"
 #include "debug.h"
 
 bool                                RailroadGroups::data_changed = false;
 std::vector<RailroadGroup>          RailroadGroups::railroad_groups;
 uint_fast8_t                        RailroadGroups::n_railroad_groups = 0;
+DisplayOrder                        RailroadGroups::order;                  // display order
 
 /*------------------------------------------------------------------------------------------------------------------------
  *  Railroad::Railroad () - constructor
@@ -144,6 +148,7 @@ Railroad::add_switch ()
     {
         this->n_switches++;
         RailroadGroups::data_changed = true;
+        Interlocking::invalidate ();
     }
     else
     {
@@ -174,6 +179,7 @@ Railroad::set_switch_idx (uint_fast8_t subidx, uint_fast16_t swidx)
     {
         this->switches[subidx] = swidx;
         RailroadGroups::data_changed = true;
+        Interlocking::invalidate ();
     }
 }
 
@@ -195,6 +201,7 @@ void
 Railroad::set_switch_state (uint_fast8_t subidx, uint_fast8_t state)
 {
     this->states[subidx] = state;
+    Interlocking::invalidate ();
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -230,6 +237,7 @@ Railroad::del_switch (uint_fast8_t subidx)
 
         this->n_switches = n_rr_switches;
         RailroadGroups::data_changed = true;
+        Interlocking::invalidate ();
         rtc = 1;
     }
 
@@ -259,13 +267,23 @@ RailroadGroup::set_id (uint_fast8_t id)
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  set_active_railroad () - set active railroad
+ *  set_active_railroad () - set active railroad, returns 0 if refused by interlocking
  *------------------------------------------------------------------------------------------------------------------------
  */
-void
+uint_fast8_t
 RailroadGroup::set_active_railroad (uint_fast8_t rridx, uint_fast16_t loco_idx)
 {
     uint_fast8_t subidx;
+    uint_fast8_t rc;
+
+    rc = Interlocking::request (this->id, rridx, loco_idx);
+
+    if (rc != INTERLOCKING_GRANTED)
+    {
+        Debug::printf (DEBUG_LEVEL_NORMAL, "RailroadGroup::set_active_railroad: railroad %u/%u refused: %s\r\n", this->id, rridx,
+                       rc == INTERLOCKING_REFUSED_OCCUPIED ? "occupied" : "conflicting route locked");
+        return 0;
+    }
 
     if (rridx < this->n_railroads)
     {
@@ -287,6 +305,9 @@ RailroadGroup::set_active_railroad (uint_fast8_t rridx, uint_fast16_t loco_idx)
     {
         this->railroads[rridx].set_active_loco (loco_idx);
     }
+
+    Interlocking::set_active (this->id, rridx, loco_idx);
+    return 1;
 }
 
 
@@ -294,10 +315,10 @@ RailroadGroup::set_active_railroad (uint_fast8_t rridx, uint_fast16_t loco_idx)
  *  RailroadGroup::set_active_railroad () - set railroad
  *------------------------------------------------------------------------------------------------------------------------
  */
-void
+uint_fast8_t
 RailroadGroup::set_active_railroad (uint_fast8_t rridx)
 {
-    RailroadGroup::set_active_railroad (rridx, 0xFFFF);
+    return RailroadGroup::set_active_railroad (rridx, 0xFFFF);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -310,6 +331,53 @@ RailroadGroup::get_active_railroad ()
     return this->active_railroad_idx;   // may be 0xFF (undefined)
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ *  RailroadGroup::is_switching () - check if switches of active railroad are not set yet
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+RailroadGroup::is_switching ()
+{
+    if (this->active_railroad_idx < this->n_railroads)
+    {
+        Railroad *      rr          = &(this->railroads[this->active_railroad_idx]);
+        uint_fast8_t    n_switches  = rr->get_n_switches();
+        uint_fast8_t    subidx;
+
+        for (subidx = 0; subidx < n_switches; subidx++)
+        {
+            if (Switches::is_busy (rr->get_switch_idx(subidx)))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  RailroadGroup::restore_active_railroad () - restore active railroad without switching, see Journal::init ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+RailroadGroup::restore_active_railroad (uint_fast8_t rridx, uint_fast16_t active_loco_idx, uint_fast16_t located_loco_idx)
+{
+    if (rridx < this->n_railroads)
+    {
+        this->active_railroad_idx = rridx;
+        this->railroads[rridx].set_active_loco (active_loco_idx);
+        this->railroads[rridx].set_located_loco (located_loco_idx);
+    }
+    else
+    {
+        this->active_railroad_idx = 0xFF;
+    }
+
+    Interlocking::invalidate ();
+    Topology::occupancy_changed ();
+}
+
 /*------------------------------------------------------------------------------------------------------------------------
  *  set_name () - set name
  *------------------------------------------------------------------------------------------------------------------------
@@ -344,9 +412,13 @@ RailroadGroup::add (const Railroad& railroad)
         if (this->n_railroads < MAX_RAILROADS_PER_RAILROAD_GROUP)
         {
             this->railroads.push_back(railroad);
+            this->order.add ();
             rtc = this->n_railroads;
             this->n_railroads++;
             RailroadGroups::data_changed = true;
+            Interlocking::invalidate ();
+            Topology::invalidate ();
+            Automation::invalidate ();
         }
     }
 
@@ -354,70 +426,59 @@ RailroadGroup::add (const Railroad& railroad)
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  set_new_id () - set new id of railroad
+ *  RailroadGroup::get_position () - get position of railroad in display order
  *------------------------------------------------------------------------------------------------------------------------
  */
 uint_fast8_t
-RailroadGroup::set_new_id (uint_fast8_t rridx, uint_fast8_t new_rridx)
+RailroadGroup::get_position (uint_fast8_t rridx)
 {
-    uint_fast8_t    n_railroads = this->n_railroads;
-    uint_fast8_t    rtc = 0xFF;
-
-    if (rridx < n_railroads && new_rridx < n_railroads)
-    {
-        if (rridx != new_rridx)
-        {
-            Railroad        tmprailroad;
-            uint_fast8_t    ridx;
-
-            uint8_t *      map_new_rridx = (uint8_t *) calloc (n_railroads, sizeof (uint8_t));
-
-            for (ridx = 0; ridx < n_railroads; ridx++)
-            {
-                map_new_rridx[ridx] = ridx;
-            }
-
-            tmprailroad = this->railroads[rridx];
+    uint_fast16_t   position = this->order.get_position (rridx);
 
-            if (new_rridx < rridx)
-            {
-                for (ridx = rridx; ridx > new_rridx; ridx--)
-                {
-                    this->railroads[ridx] = this->railroads[ridx - 1];
-                    map_new_rridx[ridx - 1] = ridx;
-                }
-            }
-            else // if (new_rridx > rridx)
-            {
-                for (ridx = rridx; ridx < new_rridx; ridx++)
-                {
-                    this->railroads[ridx] = this->railroads[ridx + 1];
-                    map_new_rridx[ridx + 1] = ridx;
-                }
-            }
+    return position < 0xFF ? position : 0xFF;
+}
 
-            this->railroads[ridx] = tmprailroad;
-            map_new_rridx[rridx] = ridx;
+/*------------------------------------------------------------------------------------------------------------------------
+ *  RailroadGroup::get_railroad_idx () - get railroad at position in display order
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+RailroadGroup::get_railroad_idx (uint_fast8_t position)
+{
+    uint_fast16_t   rridx = this->order.get_idx (position);
 
-            for (ridx = 0; ridx < n_railroads; ridx++)
-            {
-                Debug::printf (DEBUG_LEVEL_VERBOSE, "%2d -> %2d\n", ridx, map_new_rridx[ridx]);
-            }
+    return rridx < 0xFF ? rridx : 0xFF;
+}
 
-            S88::set_new_railroad_ids (this->id, map_new_rridx, n_railroads);
-            RCL::set_new_railroad_ids (this->id, map_new_rridx, n_railroads);
+/*------------------------------------------------------------------------------------------------------------------------
+ *  RailroadGroup::set_position () - move railroad to new position in display order. The railroad keeps its index, so
+ *  no references in contacts, tracks, the interlocking and the topology have to be corrected.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+RailroadGroup::set_position (uint_fast8_t rridx, uint_fast8_t new_position)
+{
+    if (this->order.get_position (rridx) == new_position)
+    {
+        return rridx;
+    }
 
-            free (map_new_rridx);
-            RailroadGroups::data_changed = true;
-            rtc = new_rridx;
-        }
-        else
-        {
-            rtc = rridx;
-        }
+    if (this->order.set_position (rridx, new_position))
+    {
+        RailroadGroups::data_changed = true;
+        return rridx;
     }
 
-    return rtc;
+    return 0xFF;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  RailroadGroup::set_order () - set display order after reading ini file, positions[rridx] may contain gaps or duplicates
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+RailroadGroup::set_order (std::vector<uint16_t>& new_positions)
+{
+    this->order.set_order (new_positions);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -459,7 +520,16 @@ RailroadGroup::get_link_railroad (uint_fast16_t loco_idx)
 void
 RailroadGroup::del (uint_fast8_t rridx)
 {
-    this->railroads.erase(this->railroads.begin() + rridx);
+    if (rridx < this->n_railroads)
+    {
+        this->railroads.erase(this->railroads.begin() + rridx);
+        this->order.remove (rridx);
+        this->n_railroads--;
+        RailroadGroups::data_changed = true;
+        Interlocking::invalidate ();
+        Topology::invalidate ();
+        Automation::invalidate ();
+    }
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -477,51 +547,6 @@ RailroadGroups::renumber ()
     }
 }
 
-/*-------------------------------------------------------------------------------------------------------------------------------------------
- * RailroadGroups::set_new_loco_ids () - set new loco ids
- *-------------------------------------------------------------------------------------------------------------------------------------------
- */
-void
-RailroadGroups::set_new_loco_ids (uint16_t * map_new_loco_idx, uint_fast16_t n_locos)
-{
-    uint_fast8_t    n_railroad_groups   = RailroadGroups::n_railroad_groups;
-    uint_fast8_t    n_railroads;
-    uint_fast8_t    rrgidx;
-    uint_fast8_t    rridx;
-
-    for (rrgidx = 0; rrgidx < n_railroad_groups; rrgidx++)
-    {
-        RailroadGroup * rrg = &RailroadGroups::railroad_groups[rrgidx];
-        n_railroads         = rrg->get_n_railroads();
-
-        for (rridx = 0; rridx < n_railroads; rridx++)
-        {
-            Railroad * rr                   = &rrg->railroads[rridx];
-            uint_fast16_t linked_loco_idx   = rr->get_link_loco();
-            uint_fast16_t active_loco_idx   = rr->get_active_loco();
-            uint_fast16_t located_loco_idx  = rr->get_located_loco();
-
-            if (linked_loco_idx < n_locos && linked_loco_idx != map_new_loco_idx[linked_loco_idx])
-            {
-                rr->set_link_loco(map_new_loco_idx[linked_loco_idx]);
-                RailroadGroups::data_changed = true;
-            }
-
-            if (active_loco_idx < n_locos && active_loco_idx != map_new_loco_idx[active_loco_idx])
-            {
-                rr->set_active_loco(map_new_loco_idx[active_loco_idx]);
-                RailroadGroups::data_changed = true;
-            }
-
-            if (located_loco_idx < n_locos && located_loco_idx != map_new_loco_idx[located_loco_idx])
-            {
-                rr->set_located_loco(map_new_loco_idx[located_loco_idx]);
-                RailroadGroups::data_changed = true;
-            }
-        }
-    }
-}
-
 /*------------------------------------------------------------------------------------------------------------------------
  *  RailroadGroups::add () - add a railroad
  *------------------------------------------------------------------------------------------------------------------------
@@ -534,8 +559,13 @@ RailroadGroups::add (const RailroadGroup& railroad_group)
     if (rrgidx < MAX_RAILROAD_GROUPS)
     {
         RailroadGroups::railroad_groups.push_back(railroad_group);
+        RailroadGroups::railroad_groups[rrgidx].set_id (rrgidx);
+        RailroadGroups::order.add ();
         RailroadGroups::n_railroad_groups++;
         RailroadGroups::data_changed = true;
+        Interlocking::invalidate ();
+        Topology::invalidate ();
+        Automation::invalidate ();
     }
     else
     {
@@ -552,73 +582,73 @@ RailroadGroups::add (const RailroadGroup& railroad_group)
 void
 RailroadGroups::del (uint_fast8_t rrgidx)
 {
-    RailroadGroups::railroad_groups.erase(RailroadGroups::railroad_groups.begin() + rrgidx);
-    RailroadGroups::renumber();
+    if (rrgidx < RailroadGroups::n_railroad_groups)
+    {
+        RailroadGroups::railroad_groups.erase(RailroadGroups::railroad_groups.begin() + rrgidx);
+        RailroadGroups::order.remove (rrgidx);
+        RailroadGroups::n_railroad_groups--;
+        RailroadGroups::renumber();
+        RailroadGroups::data_changed = true;
+        Interlocking::invalidate ();
+        Topology::invalidate ();
+        Automation::invalidate ();
+    }
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  RailroadGroups::set_new_id () - set new group id
+ *  get_position () - get position of railroad group in display order
  *------------------------------------------------------------------------------------------------------------------------
  */
 uint_fast8_t
-RailroadGroups::set_new_id (uint_fast8_t rrgidx, uint_fast8_t new_rrgidx)
+RailroadGroups::get_position (uint_fast8_t rrgidx)
 {
-    uint_fast8_t   rtc                  = 0xFF;
-
-    if (rrgidx < RailroadGroups::n_railroad_groups && new_rrgidx < RailroadGroups::n_railroad_groups)
-    {
-        if (rrgidx != new_rrgidx)
-        {
-            RailroadGroup   tmprailroad_group;
-            uint_fast8_t    gidx;
-            uint8_t *       map_new_rrgidx = (uint8_t *) calloc (RailroadGroups::n_railroad_groups, sizeof (uint8_t));
-
-            for (gidx = 0; gidx < RailroadGroups::n_railroad_groups; gidx++)
-            {
-                map_new_rrgidx[gidx] = gidx;
-            }
+    uint_fast16_t   position = RailroadGroups::order.get_position (rrgidx);
 
-            tmprailroad_group = RailroadGroups::railroad_groups[rrgidx];
-
-            if (new_rrgidx < rrgidx)
-            {
-                for (gidx = rrgidx; gidx > new_rrgidx; gidx--)
-                {
-                    RailroadGroups::railroad_groups[gidx] = RailroadGroups::railroad_groups[gidx - 1];
-                    map_new_rrgidx[gidx - 1] = gidx;
-                }
-            }
-            else // if (new_rrgidx > rrgidx)
-            {
-                for (gidx = rrgidx; gidx < new_rrgidx; gidx++)
-                {
-                    RailroadGroups::railroad_groups[gidx] = RailroadGroups::railroad_groups[gidx + 1];
-                    map_new_rrgidx[gidx + 1] = gidx;
-                }
-            }
+    return position < 0xFF ? position : 0xFF;
+}
 
-            RailroadGroups::railroad_groups[gidx] = tmprailroad_group;
-            map_new_rrgidx[rrgidx] = gidx;
+/*------------------------------------------------------------------------------------------------------------------------
+ *  get_railroad_group_idx () - get railroad group at position in display order
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+RailroadGroups::get_railroad_group_idx (uint_fast8_t position)
+{
+    uint_fast16_t   rrgidx = RailroadGroups::order.get_idx (position);
 
-            for (gidx = 0; gidx < RailroadGroups::n_railroad_groups; gidx++)
-            {
-                Debug::printf (DEBUG_LEVEL_VERBOSE, "%2d -> %2d\n", gidx, map_new_rrgidx[gidx]);
-            }
+    return rrgidx < 0xFF ? rrgidx : 0xFF;
+}
 
-            S88::set_new_railroad_group_ids (map_new_rrgidx, n_railroad_groups);
-            RCL::set_new_railroad_group_ids (map_new_rrgidx, n_railroad_groups);
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_position () - move railroad group to new position in display order. The railroad group keeps its index, so no references in
+ *  contacts, tracks, the interlocking and the topology have to be corrected.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+RailroadGroups::set_position (uint_fast8_t rrgidx, uint_fast8_t new_position)
+{
+    if (RailroadGroups::order.get_position (rrgidx) == new_position)
+    {
+        return rrgidx;
+    }
 
-            free (map_new_rrgidx);
-            RailroadGroups::data_changed = true;
-            rtc = new_rrgidx;
-        }
-        else
-        {
-            rtc = rrgidx;
-        }
+    if (RailroadGroups::order.set_position (rrgidx, new_position))
+    {
+        RailroadGroups::data_changed = true;
+        return rrgidx;
     }
 
-    return rtc;
+    return 0xFF;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_order () - set display order after reading ini file, positions[rrgidx] may contain gaps or duplicates
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+RailroadGroups::set_order (std::vector<uint16_t>& new_positions)
+{
+    RailroadGroups::order.set_order (new_positions);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -631,46 +661,22 @@ RailroadGroups::get_n_railroad_groups (void)
     return RailroadGroups::n_railroad_groups;
 }
 
-
 /*------------------------------------------------------------------------------------------------------------------------
- *  RailroadGroups::set_new_switch_ids () - set new switch ids
+ *  clear () - remove all railroad groups, see FileIO::reload_ini_files ()
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-RailroadGroups::set_new_switch_ids (uint16_t * map_new_switch_idx, uint_fast16_t n_switches)
+RailroadGroups::clear (void)
 {
-    uint_fast8_t    n_railroad_groups   = RailroadGroups::n_railroad_groups;
-    uint_fast8_t    rrgidx;
-    uint_fast8_t    rridx;
-
-    for (rrgidx = 0; rrgidx < n_railroad_groups; rrgidx++)
-    {
-        RailroadGroup * rrg         = &RailroadGroups::railroad_groups[rrgidx];
-        uint_fast8_t    n_railroads = rrg->get_n_railroads();
-
-        for (rridx = 0; rridx < n_railroads; rridx++)
-        {
-            Railroad *      rr              = &(rrg->railroads[rridx]);
-            uint_fast16_t   n_sub_switches  = rr->get_n_switches();
-            uint_fast16_t   subidx;
-
-            for (subidx = 0; subidx < n_sub_switches; subidx++)
-            {
-                uint_fast16_t   switch_idx = rr->get_switch_idx(subidx);
-
-                if (switch_idx < n_switches)
-                {
-                    if (switch_idx != map_new_switch_idx[switch_idx])
-                    {
-                        rr->set_switch_idx(subidx, map_new_switch_idx[switch_idx]);
-                        RailroadGroups::data_changed = true;
-                    }
-                }
-            }
-        }
-    }
+    RailroadGroups::railroad_groups.clear ();
+    RailroadGroups::order.clear ();
+    RailroadGroups::n_railroad_groups = 0;
+    Interlocking::invalidate ();
+    Topology::invalidate ();
+    Automation::invalidate ();
 }
 
+
 /*-------------------------------------------------------------------------------------------------------------------------------------------
  * RailroadGroups::booster_on () - enable booster
  *-------------------------------------------------------------------------------------------------------------------------------------------
@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include "order.h"
 
 #define MAX_RAILROAD_GROUPS                     254
 #define MAX_RAILROADS_PER_RAILROAD_GROUP        32
@@ -80,11 +81,16 @@ class RailroadGroup
 
         uint_fast8_t                        get_link_railroad (uint_fast16_t loco_idx);
 
-        void                                set_active_railroad (uint_fast8_t rridx, uint_fast16_t loco_idx);
-        void                                set_active_railroad (uint_fast8_t rridx);
+        uint_fast8_t                        set_active_railroad (uint_fast8_t rridx, uint_fast16_t loco_idx);
+        uint_fast8_t                        set_active_railroad (uint_fast8_t rridx);
         uint_fast8_t                        get_active_railroad ();
+        bool                                is_switching ();
+        void                                restore_active_railroad (uint_fast8_t rridx, uint_fast16_t active_loco_idx, uint_fast16_t located_loco_idx);
 
-        uint_fast8_t                        set_new_id (uint_fast8_t rridx, uint_fast8_t new_rridx);
+        uint_fast8_t                        get_position (uint_fast8_t rridx);
+        uint_fast8_t                        get_railroad_idx (uint_fast8_t position);
+        uint_fast8_t                        set_position (uint_fast8_t rridx, uint_fast8_t new_position);
+        void                                set_order (std::vector<uint16_t>& new_positions);
         void                                del (uint_fast8_t rridx);
 
     private:
@@ -92,6 +98,7 @@ class RailroadGroup
         std::string                         name;                                           // configuration: name of railroad group
         uint_fast8_t                        n_railroads;                                    // configuration: number of railroads
         uint_fast8_t                        active_railroad_idx;                            // runtime: active railroad
+        DisplayOrder                        order;                                          // display order of railroads, see set_position ()
 };
 
 class RailroadGroups
@@ -104,14 +111,17 @@ class RailroadGroups
         static uint_fast8_t                 add (const RailroadGroup& railroad_group);
         static void                         del (uint_fast8_t rrgidx);
         static uint_fast8_t                 get_n_railroad_groups (void);
-        static uint_fast8_t                 set_new_id (uint_fast8_t rrgidx, uint_fast8_t new_rrgidx);
-        static void                         set_new_switch_ids (uint16_t * map_new_switch_idx, uint_fast16_t n_switches);
-        static void                         set_new_loco_ids (uint16_t * map_new_loco_idx, uint_fast16_t n_locos);
+        static void                         clear (void);
+        static uint_fast8_t                 get_position (uint_fast8_t rrgidx);
+        static uint_fast8_t                 get_railroad_group_idx (uint_fast8_t position);
+        static uint_fast8_t                 set_position (uint_fast8_t rrgidx, uint_fast8_t new_position);
+        static void                         set_order (std::vector<uint16_t>& new_positions);
         static void                         booster_on (void);
         static void                         booster_off (void);
 
     private:
         static uint8_t                      n_railroad_groups;
+        static DisplayOrder                 order;                                  // display order, see set_position ()
         static void                         renumber ();
 };
 
@@ -31,13 +31,18 @@
 #include "led.h"
 #include "railroad.h"
 #include "s88.h"
+#include "topology.h"
+#include "automation.h"
+#include "fm22.h"
 #include "debug.h"
+#include "metrics.h"
 #include "rcl.h"
 
-uint8_t                             RCL::locations[MAX_LOCOS];
+std::vector<RCL_TRANSITION>         RCL::transitions;
 std::vector<RCL_Track>              RCL::tracks;
 uint_fast8_t                        RCL::n_tracks = 0;                        // number of tracks
 bool                                RCL::data_changed = false;
+DisplayOrder                        RCL::order;                               // display order
 
 RCL_Track::RCL_Track ()
 {
@@ -122,6 +127,7 @@ RCL_Track::add_track_action (bool in)
             this->track_actions_in[track_action_idx].n_parameters           = 0;
             this->n_track_actions_in++;
             RCL::data_changed = true;
+            Automation::invalidate ();
         }
         else
         {
@@ -139,6 +145,7 @@ RCL_Track::add_track_action (bool in)
             this->track_actions_out[track_action_idx].n_parameters          = 0;
             this->n_track_actions_out++;
             RCL::data_changed = true;
+            Automation::invalidate ();
         }
         else
         {
@@ -183,6 +190,7 @@ RCL_Track::delete_track_action (bool in, uint_fast8_t track_action_idx)
 
             this->n_track_actions_in--;
             RCL::data_changed = true;
+            Automation::invalidate ();
         }
     }
     else
@@ -208,6 +216,7 @@ RCL_Track::delete_track_action (bool in, uint_fast8_t track_action_idx)
 
             this->n_track_actions_out--;
             RCL::data_changed = true;
+            Automation::invalidate ();
         }
     }
 }
@@ -252,6 +261,7 @@ RCL_Track::set_track_action (bool in, uint_fast8_t track_action_idx, RCL_TRACK_A
             }
 
             RCL::data_changed = true;
+            Automation::invalidate ();
             rtc = 1;
         }
     }
@@ -272,6 +282,7 @@ RCL_Track::set_track_action (bool in, uint_fast8_t track_action_idx, RCL_TRACK_A
             }
 
             RCL::data_changed = true;
+            Automation::invalidate ();
             rtc = 1;
         }
     }
@@ -328,1086 +339,283 @@ RCL_Track::get_track_action (bool in, uint_fast8_t track_action_idx, RCL_TRACK_A
     return rtc;
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ *  RCL::set_new_locations () - correct pending location changes after reload of configuration, see FileIO::reload_ini_files ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
 void
-RCL::reset_all_locations (void)
+RCL::set_new_locations (uint16_t * map_new_loco_idx, uint16_t n_locos, uint8_t * map_new_trackidx, uint_fast8_t n_rcl_tracks)
 {
-    uint_fast16_t   loco_idx;
-    uint_fast8_t    track_idx;
+    uint_fast16_t   tidx;
+    uint_fast16_t   n_transitions = 0;
 
-    for (loco_idx = 0; loco_idx < MAX_LOCOS; loco_idx++)
+    for (tidx = 0; tidx < RCL::transitions.size (); tidx++)
     {
-        RCL::locations[loco_idx] = 0xFF;
-    }
+        RCL_TRANSITION *    tp = &RCL::transitions[tidx];
 
-    for (track_idx = 0; track_idx < n_tracks; track_idx++)
-    {
-        RCL::tracks[track_idx].loco_idx         = 0xFFFF;
-        RCL::tracks[track_idx].last_loco_idx    = 0xFFFF;
+        if (tp->loco_idx < n_locos && map_new_loco_idx[tp->loco_idx] != 0xFFFF)
+        {
+            tp->loco_idx        = map_new_loco_idx[tp->loco_idx];
+            tp->old_location    = tp->old_location < n_rcl_tracks ? map_new_trackidx[tp->old_location] : 0xFF;     // may be 0xFF
+            tp->new_location    = tp->new_location < n_rcl_tracks ? map_new_trackidx[tp->new_location] : 0xFF;     // may be 0xFF
+
+            if (tp->old_location != tp->new_location)
+            {
+                RCL::transitions[n_transitions++] = *tp;
+            }
+        }
     }
-}
 
-/*------------------------------------------------------------------------------------------------------------------------
- *  RCL::booster_on ()
- *------------------------------------------------------------------------------------------------------------------------
- */
-uint_fast8_t
-RCL::booster_on (void)
-{
-    reset_all_locations ();
-    return 0;
+    RCL::transitions.resize (n_transitions);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  RCL::booster_off ()
+ *  RCL::location_changed () - queue change of location, called by receiver of RCL messages, see MSG::rcl ()
  *------------------------------------------------------------------------------------------------------------------------
  */
-uint_fast8_t
-RCL::booster_off (void)
+void
+RCL::location_changed (uint_fast16_t loco_idx, uint_fast8_t old_location, uint_fast8_t new_location)
 {
-    reset_all_locations ();
-    return 0;
+    if (old_location != new_location)
+    {
+        RCL::transitions.push_back ({ (uint16_t) loco_idx, (uint8_t) old_location, (uint8_t) new_location });
+    }
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  RCL::schedule ()
+ *  RCL::restore_locations () - set occupation of rcl tracks from the locations of the locos, see Journal::init ()
+ *
+ *  No transitions are queued and no track actions are executed: they have already been executed before the restart.
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-RCL::schedule (void)
+RCL::restore_locations (void)
 {
     uint_fast16_t   n_locos = Locos::get_n_locos ();
     uint_fast16_t   loco_idx;
+    uint_fast8_t    track_idx;
 
-    if (DCC::booster_is_on)
-    {
-        for (loco_idx = 0; loco_idx < n_locos; loco_idx++)
-        {
-            uint_fast8_t    location        = Locos::locos[loco_idx].get_rcllocation ();
-            uint_fast8_t    old_location    = locations[loco_idx];
-
-            if (old_location != location)
-            {
-                if (location != 0xFF)           // enter rcl track
-                {
-                    if (location < n_tracks)
-                    {
-                        if ((tracks[location].flags & RCL_TRACK_FLAG_BLOCK_PROTECTION) && tracks[location].loco_idx != 0xFFFF && tracks[location].loco_idx != loco_idx)
-                        {
-                            static char buf[80];
-
-                            Locos::locos[loco_idx].set_speed (0);
-                            Debug::printf (DEBUG_LEVEL_NONE, "rcl in: loco_idx=%u, but already loco_idx=%u: STOP\n", loco_idx, tracks[location].loco_idx);
-                            sprintf (buf, "Blocksicherung: Stop Lok %u", (unsigned int) loco_idx);
-                            HTTP::set_alert (buf);
-                        }
-
-                        Debug::printf (DEBUG_LEVEL_NORMAL, "executing actions 'in': loco_idx=%u, location=%u\n", loco_idx, location);
-                        tracks[location].loco_idx = loco_idx;
-                        tracks[location].last_loco_idx = loco_idx;
-                        RCL::execute_track_actions (true, loco_idx, location);
-                    }
-                    else
-                    {
-                        Debug::printf (DEBUG_LEVEL_VERBOSE, "RCL::schedule in: got location = %u, but n_tracks = %u\n", location, n_tracks);
-                    }
-                }
-                else                            // leave
-                {
-                    if (old_location < n_tracks)
-                    {
-                        Debug::printf (DEBUG_LEVEL_NORMAL, "executing actions 'out': loco_idx=%u, location=%u\n", loco_idx, old_location);
-                        tracks[old_location].loco_idx = 0xFFFF;
-                        RCL::execute_track_actions (false, loco_idx, old_location);
-                    }
-                    else
-                    {
-                        Debug::printf (DEBUG_LEVEL_VERBOSE, "RCL::schedule out: got location = %u, but n_tracks = %u\n", locations[loco_idx], n_tracks);
-                    }
-                }
-
-                locations[loco_idx] = location;
-            }
-        }
-    }
-}
-
-void
-RCL::set_new_loco_ids_for_track (bool in, uint_fast8_t trackidx, uint16_t * map_new_loco_idx, uint16_t n_locos)
-{
-    uint_fast8_t    track_action_idx;
+    RCL::transitions.clear ();
 
-    if (trackidx < n_tracks)
+    for (track_idx = 0; track_idx < n_tracks; track_idx++)
     {
-        uint_fast8_t    n_track_actions;
-
-        if (in)
-        {
-            n_track_actions = tracks[trackidx].n_track_actions_in;
-        }
-        else
-        {
-            n_track_actions = tracks[trackidx].n_track_actions_out;
-        }
-
-        for (track_action_idx = 0; track_action_idx < n_track_actions; track_action_idx++)
-        {
-            uint_fast8_t    action;
-            uint16_t *      param;
-
-            if (in)
-            {
-                action                  = tracks[trackidx].track_actions_in[track_action_idx].action;
-                param                   = tracks[trackidx].track_actions_in[track_action_idx].parameters;
-            }
-            else
-            {
-                action                  = tracks[trackidx].track_actions_out[track_action_idx].action;
-                param                   = tracks[trackidx].track_actions_out[track_action_idx].parameters;
-            }
-
-            switch (action)
-            {
-                case RCL_ACTION_SET_LOCO_SPEED:                                             // parameters: START, LOCO, SPEED, TENTHS
-                case RCL_ACTION_SET_LOCO_MIN_SPEED:                                         // parameters: START, LOCO, SPEED, TENTHS
-                case RCL_ACTION_SET_LOCO_MAX_SPEED:                                         // parameters: START, LOCO, SPEED, TENTHS
-                case RCL_ACTION_SET_LOCO_FORWARD_DIRECTION:                                 // parameters: START, LOCO, FWD
-                case RCL_ACTION_SET_LOCO_ALL_FUNCTIONS_OFF:                                 // parameters: START, LOCO
-                case RCL_ACTION_SET_LOCO_FUNCTION_OFF:                                      // parameters: START, LOCO, FUNC_IDX
-                case RCL_ACTION_SET_LOCO_FUNCTION_ON:                                       // parameters: START, LOCO, FUNC_IDX
-                case RCL_ACTION_EXECUTE_LOCO_MACRO:                                         // parameters: START, LOCO, MACRO_IDX
-                case RCL_ACTION_WAIT_FOR_FREE_S88_CONTACT:                                  // parameters: START, LOCO, COIDX, TENTHS
-                {
-                    uint_fast16_t   loco_idx    = param[1];
-
-                    if (loco_idx < n_locos && loco_idx != map_new_loco_idx[loco_idx])
-                    {
-                        if (in)
-                        {
-                            tracks[trackidx].track_actions_in[track_action_idx].parameters[1] = map_new_loco_idx[loco_idx];
-                        }
-                        else
-                        {
-                            tracks[trackidx].track_actions_out[track_action_idx].parameters[1] = map_new_loco_idx[loco_idx];
-                        }
-
-                        RCL::data_changed = true;
-                    }
-
-                    break;
-                }
-            }
-        }
+        RCL::tracks[track_idx].loco_idx = 0xFFFF;
     }
-}
-
-void
-RCL::set_new_addon_ids_for_track (bool in, uint_fast8_t trackidx, uint16_t * map_new_addon_idx, uint16_t n_addons)
-{
-    uint_fast8_t    track_action_idx;
 
-    if (trackidx < n_tracks)
+    for (loco_idx = 0; loco_idx < n_locos; loco_idx++)
     {
-        uint_fast8_t    n_track_actions;
+        uint_fast8_t    location = Locos::locos[loco_idx].get_rcllocation ();
 
-        if (in)
+        if (location < n_tracks)
         {
-            n_track_actions = tracks[trackidx].n_track_actions_in;
-        }
-        else
-        {
-            n_track_actions = tracks[trackidx].n_track_actions_out;
-        }
-
-        for (track_action_idx = 0; track_action_idx < n_track_actions; track_action_idx++)
-        {
-            uint_fast8_t    action;
-            uint16_t *      param;
-
-            if (in)
-            {
-                action  = tracks[trackidx].track_actions_in[track_action_idx].action;
-                param   = tracks[trackidx].track_actions_in[track_action_idx].parameters;
-            }
-            else
-            {
-                action  = tracks[trackidx].track_actions_out[track_action_idx].action;
-                param   = tracks[trackidx].track_actions_out[track_action_idx].parameters;
-            }
-
-            switch (action)
-            {
-                case RCL_ACTION_SET_ADDON_ALL_FUNCTIONS_OFF:                                // parameters: START, ADDON
-                case RCL_ACTION_SET_ADDON_FUNCTION_OFF:                                     // parameters: START, ADDON, FUNC_IDX
-                case RCL_ACTION_SET_ADDON_FUNCTION_ON:                                      // parameters: START, ADDON, FUNC_IDX
-                {
-                    uint_fast16_t   addon_idx    = param[1];
-
-                    if (addon_idx < n_addons && addon_idx != map_new_addon_idx[addon_idx])
-                    {
-                        if (in)
-                        {
-                            tracks[trackidx].track_actions_in[track_action_idx].parameters[1] = map_new_addon_idx[addon_idx];
-                        }
-                        else
-                        {
-                            tracks[trackidx].track_actions_out[track_action_idx].parameters[1] = map_new_addon_idx[addon_idx];
-                        }
-                        RCL::data_changed = true;
-                    }
-
-                    break;
-                }
-            }
+            RCL::tracks[location].loco_idx      = loco_idx;
+            RCL::tracks[location].last_loco_idx = loco_idx;
         }
     }
 }
 
 void
-RCL::set_new_switch_ids_for_track (bool in, uint_fast8_t trackidx, uint16_t * map_new_switch_idx, uint16_t n_switches)
+RCL::reset_all_locations (void)
 {
-    uint_fast8_t    track_action_idx;
-
-    if (trackidx < n_tracks)
-    {
-        uint_fast8_t    n_track_actions;
-
-        if (in)
-        {
-            n_track_actions = tracks[trackidx].n_track_actions_in;
-        }
-        else
-        {
-            n_track_actions = tracks[trackidx].n_track_actions_out;
-        }
+    uint_fast8_t    track_idx;
 
-        for (track_action_idx = 0; track_action_idx < n_track_actions; track_action_idx++)
-        {
-            uint_fast8_t    action;
-            uint16_t *      param;
+    RCL::transitions.clear ();
 
-            if (in)
-            {
-                action                  = tracks[trackidx].track_actions_in[track_action_idx].action;
-                param                   = tracks[trackidx].track_actions_in[track_action_idx].parameters;
-            }
-            else
-            {
-                action                  = tracks[trackidx].track_actions_out[track_action_idx].action;
-                param                   = tracks[trackidx].track_actions_out[track_action_idx].parameters;
-            }
-
-            switch (action)
-            {
-                case RCL_ACTION_SET_SWITCH:                                                 // parameters: SW_IDX, SW_STATE
-                {
-                    uint_fast16_t   switch_idx    = param[0];
-
-                    if (switch_idx < n_switches && switch_idx != map_new_switch_idx[switch_idx])
-                    {
-                        if (in)
-                        {
-                            tracks[trackidx].track_actions_in[track_action_idx].parameters[0] = map_new_switch_idx[switch_idx];
-                        }
-                        else
-                        {
-                            tracks[trackidx].track_actions_out[track_action_idx].parameters[0] = map_new_switch_idx[switch_idx];
-                        }
-
-                        RCL::data_changed = true;
-                    }
-
-                    break;
-                }
-            }
-        }
+    for (track_idx = 0; track_idx < n_tracks; track_idx++)
+    {
+        RCL::tracks[track_idx].loco_idx         = 0xFFFF;
+        RCL::tracks[track_idx].last_loco_idx    = 0xFFFF;
     }
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  RCL::set_new_loco_ids ()
+ *  RCL::booster_on ()
  *------------------------------------------------------------------------------------------------------------------------
  */
-void
-RCL::set_new_loco_ids (uint16_t * map_new_loco_idx, uint16_t n_locos)
+uint_fast8_t
+RCL::booster_on (void)
 {
-    uint_fast8_t     trackidx;
-
-    for (trackidx = 0; trackidx < RCL::n_tracks; trackidx++)
-    {
-        if (RCL::tracks[trackidx].loco_idx < n_locos)
-        {
-            RCL::tracks[trackidx].loco_idx = map_new_loco_idx[RCL::tracks[trackidx].loco_idx];
-        }
-
-        if (RCL::tracks[trackidx].last_loco_idx < n_locos)
-        {
-            RCL::tracks[trackidx].last_loco_idx = map_new_loco_idx[RCL::tracks[trackidx].last_loco_idx];
-        }
-
-        RCL::set_new_loco_ids_for_track (true, trackidx, map_new_loco_idx, n_locos);
-        RCL::set_new_loco_ids_for_track (false, trackidx, map_new_loco_idx, n_locos);
-    }
+    reset_all_locations ();
+    return 0;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  RCL::set_new_addon_ids ()
+ *  RCL::booster_off ()
  *------------------------------------------------------------------------------------------------------------------------
  */
-void
-RCL::set_new_addon_ids (uint16_t * map_new_addon_idx, uint16_t n_addons)
+uint_fast8_t
+RCL::booster_off (void)
 {
-    uint_fast8_t     trackidx;
-
-    for (trackidx = 0; trackidx < RCL::n_tracks; trackidx++)
-    {
-        RCL::set_new_addon_ids_for_track (true, trackidx, map_new_addon_idx, n_addons);
-        RCL::set_new_addon_ids_for_track (false, trackidx, map_new_addon_idx, n_addons);
-    }
+    reset_all_locations ();
+    return 0;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  RCL::set_new_switch_ids ()
+ *  RCL::schedule () - execute track actions for queued location changes
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-RCL::set_new_switch_ids (uint16_t * map_new_switch_idx, uint16_t n_switches)
+RCL::schedule (void)
 {
-    uint_fast8_t     trackidx;
+    uint_fast16_t   tidx;
 
-    for (trackidx = 0; trackidx < RCL::n_tracks; trackidx++)
+    if (RCL::transitions.size () == 0)
     {
-        RCL::set_new_switch_ids_for_track (true, trackidx, map_new_switch_idx, n_switches);
-        RCL::set_new_switch_ids_for_track (false, trackidx, map_new_switch_idx, n_switches);
+        return;
     }
-}
 
-void
-RCL::set_new_railroad_group_ids_for_track (bool in, uint_fast8_t trackidx, uint8_t * map_new_rrgidx, uint_fast8_t n_railroad_groups)
-{
-    if (trackidx < RCL::n_tracks)
+    if (! DCC::booster_is_on)
     {
-        uint_fast8_t    n_track_actions;
-        uint_fast8_t    track_action_idx;
+        RCL::transitions.clear ();                                      // locations are reset on booster on
+        return;
+    }
 
-        if (in)
-        {
-            n_track_actions = tracks[trackidx].n_track_actions_in;
-        }
-        else
-        {
-            n_track_actions = tracks[trackidx].n_track_actions_out;
-        }
+    for (tidx = 0; tidx < RCL::transitions.size (); tidx++)
+    {
+        uint_fast16_t   loco_idx        = RCL::transitions[tidx].loco_idx;
+        uint_fast8_t    location        = RCL::transitions[tidx].new_location;
+        uint_fast8_t    old_location    = RCL::transitions[tidx].old_location;
 
-        for (track_action_idx = 0; track_action_idx < n_track_actions; track_action_idx++)
+        if (location != 0xFF)           // enter rcl track
         {
-            uint_fast8_t    action;
-            uint16_t *      param;
-
-            if (in)
+            if (location < n_tracks)
             {
-                action  = tracks[trackidx].track_actions_in[track_action_idx].action;
-                param   = tracks[trackidx].track_actions_in[track_action_idx].parameters;
-            }
-            else
-            {
-                action  = tracks[trackidx].track_actions_out[track_action_idx].action;
-                param   = tracks[trackidx].track_actions_out[track_action_idx].parameters;
-            }
-
-            switch (action)
-            {
-                case RCL_ACTION_SET_LINKED_RAILROAD:                                        // parameters: RRG_IDX
-                case RCL_ACTION_SET_FREE_RAILROAD:                                          // parameters: RRG_IDX
+                if ((tracks[location].flags & RCL_TRACK_FLAG_BLOCK_PROTECTION) && tracks[location].loco_idx != 0xFFFF && tracks[location].loco_idx != loco_idx)
                 {
-                    uint_fast8_t    rrgidx  = param[0];
+                    static char buf[80];
 
-                    if (rrgidx < n_railroad_groups && rrgidx != map_new_rrgidx[rrgidx])
-                    {
-                        param[0] = map_new_rrgidx[rrgidx];
-                        RCL::data_changed = true;
-                    }
-
-                    break;
+                    Locos::locos[loco_idx].set_speed (0);
+                    Debug::printf (DEBUG_LEVEL_NONE, "rcl in: loco_idx=%u, but already loco_idx=%u: STOP\n", loco_idx, tracks[location].loco_idx);
+                    sprintf (buf, "Blocksicherung: Stop Lok %u", (unsigned int) loco_idx);
+                    HTTP::set_alert (buf);
                 }
 
-                case RCL_ACTION_SET_LOCO_DESTINATION:                                       // parameters: LOCO_IDX, RRG_IDX
-                {
-                    uint_fast8_t    rrgidx  = param[1];
-
-                    if (rrgidx < n_railroad_groups && rrgidx != map_new_rrgidx[rrgidx])
-                    {
-                        param[1] = map_new_rrgidx[rrgidx];
-                        RCL::data_changed = true;
-                    }
-
-                    break;
-                }
+                DEBUG_TRACE (DEBUG_SUBSYSTEM_RCL, DEBUG_LEVEL_NORMAL, "executing actions 'in': loco_idx=%u, location=%u\n", (uint16_t) loco_idx, location);
+                tracks[location].loco_idx = loco_idx;
+                tracks[location].last_loco_idx = loco_idx;
+                Metrics::count (METRICS_COUNTER_RCL_EDGES);
+                Automation::execute_track_actions (location, true, loco_idx);
+            }
+            else
+            {
+                DEBUG_TRACE (DEBUG_SUBSYSTEM_RCL, DEBUG_LEVEL_VERBOSE, "RCL::schedule in: got location = %u, but n_tracks = %u\n", location, n_tracks);
             }
         }
-    }
-}
-
-void
-RCL::set_new_railroad_ids_for_track (bool in, uint_fast8_t trackidx, uint_fast8_t current_rrgidx, uint8_t * map_new_rridx, uint_fast8_t n_railroads)
-{
-    if (trackidx < RCL::n_tracks)
-    {
-        uint_fast8_t    n_track_actions;
-        uint_fast8_t    track_action_idx;
-
-        if (in)
-        {
-            n_track_actions = tracks[trackidx].n_track_actions_in;
-        }
-        else
+        else                            // leave
         {
-            n_track_actions = tracks[trackidx].n_track_actions_out;
-        }
-
-        for (track_action_idx = 0; track_action_idx < n_track_actions; track_action_idx++)
-        {
-            uint_fast8_t    action;
-            uint16_t *      param;
-
-            if (in)
+            if (old_location < n_tracks)
             {
-                action  = tracks[trackidx].track_actions_in[track_action_idx].action;
-                param   = tracks[trackidx].track_actions_in[track_action_idx].parameters;
+                DEBUG_TRACE (DEBUG_SUBSYSTEM_RCL, DEBUG_LEVEL_NORMAL, "executing actions 'out': loco_idx=%u, location=%u\n", (uint16_t) loco_idx, old_location);
+                tracks[old_location].loco_idx = 0xFFFF;
+                Metrics::count (METRICS_COUNTER_RCL_EDGES);
+                Automation::execute_track_actions (old_location, false, loco_idx);
             }
             else
             {
-                action  = tracks[trackidx].track_actions_out[track_action_idx].action;
-                param   = tracks[trackidx].track_actions_out[track_action_idx].parameters;
-            }
-
-            switch (action)
-            {
-                case RCL_ACTION_SET_RAILROAD:                                               // parameters: RRG_IDX, RR_IDX
-                {
-                    uint_fast8_t    rrgidx  = param[0];
-                    uint_fast8_t    rridx   = param[1];
-
-                    if (current_rrgidx == rrgidx && rridx < n_railroads && rridx != map_new_rridx[rridx])
-                    {
-                        param[1] = map_new_rridx[rridx];
-                        RCL::data_changed = true;
-                    }
-
-                    break;
-                }
+                DEBUG_TRACE (DEBUG_SUBSYSTEM_RCL, DEBUG_LEVEL_VERBOSE, "RCL::schedule out: got location = %u, but n_tracks = %u\n", old_location, n_tracks);
             }
         }
     }
+
+    RCL::transitions.clear ();
+    FM22::state_changed ();
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  RCL::set_new_railroad_group_ids ()
+ *  RCL::add_track () - add a track
  *------------------------------------------------------------------------------------------------------------------------
  */
-void
-RCL::set_new_railroad_group_ids (uint8_t * map_new_rrgidx, uint_fast8_t n_railroad_groups)
+uint_fast8_t
+RCL::add (const RCL_Track& track)
 {
-    uint_fast8_t     trackidx;
-
-    for (trackidx = 0; trackidx < RCL::n_tracks; trackidx++)
+    if (RCL::n_tracks < RCL_MAX_RCL_TRACKS)
     {
-        RCL::set_new_railroad_group_ids_for_track (true, trackidx, map_new_rrgidx, n_railroad_groups);
-        RCL::set_new_railroad_group_ids_for_track (false, trackidx, map_new_rrgidx, n_railroad_groups);
+        tracks.push_back(track);
+        RCL::order.add ();
+        RCL::n_tracks++;
+        Automation::invalidate ();
+        return tracks.size() - 1;
     }
+    return 0xFF;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  RCL::set_new_railroad_ids ()
+ *  RCL::get_n_tracks () - get number of tracks
  *------------------------------------------------------------------------------------------------------------------------
  */
-void
-RCL::set_new_railroad_ids (uint_fast8_t rrgidx, uint8_t * map_new_rridx, uint_fast8_t n_railroads)
+uint_fast8_t
+RCL::get_n_tracks (void)
 {
-    uint_fast8_t     trackidx;
-
-    for (trackidx = 0; trackidx < RCL::n_tracks; trackidx++)
-    {
-        RCL::set_new_railroad_ids_for_track (true, trackidx, rrgidx, map_new_rridx, n_railroads);
-        RCL::set_new_railroad_ids_for_track (false, trackidx, rrgidx, map_new_rridx, n_railroads);
-    }
+    return n_tracks;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  RCL::get_parameter_loco () get detected loco
+ *  RCL::clear () - remove all tracks, see FileIO::reload_ini_files ()
  *------------------------------------------------------------------------------------------------------------------------
  */
-uint_fast16_t
-RCL::get_parameter_loco (uint_fast16_t loco_idx, uint_fast16_t detected_loco_idx)
+void
+RCL::clear (void)
 {
-    if (loco_idx == 0xFFFF)
-    {
-        loco_idx = detected_loco_idx;
-    }
-    else if (loco_idx >= S88_RCL_DETECTED_OFFSET)
-    {
-        uint_fast8_t    track_idx = loco_idx - S88_RCL_DETECTED_OFFSET;
-        uint_fast8_t    n_tracks = RCL::get_n_tracks ();
-
-        if (track_idx < n_tracks)
-        {
-            loco_idx = RCL::tracks[track_idx].last_loco_idx;
-        }
-        else
-        {
-            loco_idx = 0xFFFF;
-        }
-    }
-
-    return loco_idx;
+    RCL::tracks.clear ();
+    RCL::order.clear ();
+    RCL::n_tracks = 0;
+    Automation::invalidate ();
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  RCL::execute_track_actions () - execute track actions
+ *  RCL::get_position () - get position of track in display order
  *------------------------------------------------------------------------------------------------------------------------
  */
-void
-RCL::execute_track_actions (bool in, uint_fast16_t detected_loco_idx, uint_fast8_t trackidx)
+uint_fast8_t
+RCL::get_position (uint_fast8_t trackidx)
 {
-    uint_fast8_t    track_action_idx;
-
-    if (trackidx < n_tracks)
-    {
-        uint_fast8_t    n_track_actions;
+    uint_fast16_t   position = RCL::order.get_position (trackidx);
 
-        if (in)
-        {
-            n_track_actions = tracks[trackidx].n_track_actions_in;
-        }
-        else
-        {
-            n_track_actions = tracks[trackidx].n_track_actions_out;
-        }
-
-        for (track_action_idx = 0; track_action_idx < n_track_actions; track_action_idx++)
-        {
-            uint_fast8_t    destination;
-            uint_fast8_t    condition;
-            uint_fast8_t    condition_destination;
-            uint_fast8_t    action;
-            uint16_t *      param;
-
-            if (in)
-            {
-                condition               = tracks[trackidx].track_actions_in[track_action_idx].condition;
-                condition_destination   = tracks[trackidx].track_actions_in[track_action_idx].condition_destination;
-                action                  = tracks[trackidx].track_actions_in[track_action_idx].action;
-                param                   = tracks[trackidx].track_actions_in[track_action_idx].parameters;
-            }
-            else
-            {
-                condition               = tracks[trackidx].track_actions_out[track_action_idx].condition;
-                condition_destination   = tracks[trackidx].track_actions_out[track_action_idx].condition_destination;
-                action                  = tracks[trackidx].track_actions_out[track_action_idx].action;
-                param                   = tracks[trackidx].track_actions_out[track_action_idx].parameters;
-            }
-
-            destination = Locos::locos[detected_loco_idx].get_destination();
-
-            if ((condition == RCL_CONDITION_ALWAYS) ||
-                (condition == RCL_CONDITION_IF_DESTINATION && condition_destination == destination) ||
-                (condition == RCL_CONDITION_IF_NOT_DESTINATION && condition_destination != destination))
-            {
-                switch (action)
-                {
-                    case RCL_ACTION_SET_LOCO_SPEED:                                             // parameters: START, LOCO, SPEED, TENTHS
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   loco_idx    = RCL::get_parameter_loco (param[1], detected_loco_idx);
-                        uint_fast8_t    speed       = param[2];
-                        uint_fast16_t   tenths      = param[3];
-
-                        if (loco_idx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                Locos::locos[loco_idx].set_speed (speed, tenths);
-                            }
-                            else
-                            {
-                                Event::add_event_loco_speed (start, loco_idx, EVENT_SET_LOCO_SPEED, speed, tenths);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_LOCO_MIN_SPEED:                                         // parameters: START, LOCO, SPEED, TENTHS
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   loco_idx    = RCL::get_parameter_loco (param[1], detected_loco_idx);
-                        uint_fast8_t    speed       = param[2];
-                        uint_fast16_t   tenths      = param[3];
-
-                        if (loco_idx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                uint_fast8_t current_speed = Locos::locos[loco_idx].get_speed ();
-
-                                if (current_speed < speed)
-                                {
-                                    Locos::locos[loco_idx].set_speed (speed, tenths);
-                                }
-                            }
-                            else
-                            {
-                                Event::add_event_loco_speed (start, loco_idx, EVENT_SET_LOCO_MIN_SPEED, speed, tenths);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_LOCO_MAX_SPEED:                                         // parameters: START, LOCO, SPEED, TENTHS
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   loco_idx    = RCL::get_parameter_loco (param[1], detected_loco_idx);
-                        uint_fast8_t    speed       = param[2];
-                        uint_fast16_t   tenths      = param[3];
-
-                        if (loco_idx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                uint_fast8_t current_speed = Locos::locos[loco_idx].get_speed ();
-
-                                if (current_speed > speed)
-                                {
-                                    Locos::locos[loco_idx].set_speed (speed, tenths);
-                                }
-                            }
-                            else
-                            {
-                                Event::add_event_loco_speed (start, loco_idx, EVENT_SET_LOCO_MAX_SPEED, speed, tenths);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_LOCO_FORWARD_DIRECTION:                                 // parameters: START, LOCO, FWD
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   loco_idx    = RCL::get_parameter_loco (param[1], detected_loco_idx);
-                        uint_fast8_t    fwd         = param[2];
-
-                        if (loco_idx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                Locos::locos[loco_idx].set_fwd (fwd);
-                            }
-                            else
-                            {
-                                Event::add_event_loco_dir (start, loco_idx, fwd);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_LOCO_ALL_FUNCTIONS_OFF:                                      // parameters: START, LOCO
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   loco_idx    = RCL::get_parameter_loco (param[1], detected_loco_idx);
-
-                        if (loco_idx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                Locos::locos[loco_idx].reset_functions ();
-                            }
-                            else
-                            {
-                                Event::add_event_loco_function (start, loco_idx, 0xFF, false);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_LOCO_FUNCTION_OFF:                                           // parameters: START, LOCO, FUNC_IDX
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   loco_idx    = RCL::get_parameter_loco (param[1], detected_loco_idx);
-                        uint_fast8_t    f           = param[2];
-
-                        if (loco_idx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                Locos::locos[loco_idx].set_function (f, false);
-                            }
-                            else
-                            {
-                                Event::add_event_loco_function (start, loco_idx, f, false);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_LOCO_FUNCTION_ON:                                            // parameters: START, LOCO, FUNC_IDX
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   loco_idx    = RCL::get_parameter_loco (param[1], detected_loco_idx);
-                        uint_fast8_t    f           = param[2];
-
-                        if (loco_idx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                Locos::locos[loco_idx].set_function (f, true);
-                            }
-                            else
-                            {
-                                Event::add_event_loco_function (start, loco_idx, f, true);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_EXECUTE_LOCO_MACRO:                                                 // parameters: START, LOCO, MACRO_IDX
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   loco_idx    = RCL::get_parameter_loco (param[1], detected_loco_idx);
-                        uint_fast8_t    macro_idx   = param[2];
-
-                        if (loco_idx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                Locos::locos[loco_idx].execute_macro (macro_idx);
-                            }
-                            else
-                            {
-                                Event::add_event_execute_loco_macro (start, loco_idx, macro_idx);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_ADDON_ALL_FUNCTIONS_OFF:                                      // parameters: START, ADDON
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   addon_idx   = param[1];
-
-                        if (addon_idx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                AddOns::addons[addon_idx].reset_functions ();
-                            }
-                            else
-                            {
-                                Event::add_event_addon_function (start, addon_idx, 0xFF, false);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_ADDON_FUNCTION_OFF:                                           // parameters: START, ADDON, FUNC_IDX
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   addon_idx   = param[1];
-                        uint_fast8_t    f           = param[2];
-
-                        if (addon_idx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                AddOns::addons[addon_idx].set_function (f, false);
-                            }
-                            else
-                            {
-                                Event::add_event_addon_function (start, addon_idx, f, false);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_ADDON_FUNCTION_ON:                                            // parameters: START, ADDON, FUNC_IDX
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   addon_idx   = param[1];
-                        uint_fast8_t    f           = param[2];
-
-                        if (addon_idx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                AddOns::addons[addon_idx].set_function (f, true);
-                            }
-                            else
-                            {
-                                Event::add_event_addon_function (start, addon_idx, f, true);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_RAILROAD:                                               // parameters: RRG_IDX, RR_IDX
-                    {
-                        uint_fast8_t    rrgidx  = param[0];
-                        uint_fast8_t    rridx   = param[1];
-                        RailroadGroup * rrg     = &RailroadGroups::railroad_groups[rrgidx];
-
-                        rrg->set_active_railroad (rridx, detected_loco_idx);
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_FREE_RAILROAD:                                          // parameters: RRG_IDX
-                    {
-                        uint_fast8_t    rrgidx  = param[0];
-                        RailroadGroup * rrg     = &RailroadGroups::railroad_groups[rrgidx];
-                        uint_fast8_t    rridx;
-
-                        rridx = S88::get_free_railroad (rrgidx);
-
-                        if (rridx != 0xFF)
-                        {
-                            rrg->set_active_railroad (rridx, detected_loco_idx);
-                        }
-                        else
-                        {
-                            Debug::printf (DEBUG_LEVEL_VERBOSE, "Error: RCL::execute_track_actions: cannot find free railroad\n");
-
-                            if (detected_loco_idx != 0xFFFF)
-                            {
-                                Locos::locos[detected_loco_idx].set_speed (0);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_LINKED_RAILROAD:                                        // parameters: RRG_IDX
-                    {
-                        uint_fast8_t    rrgidx  = param[0];
-                        RailroadGroup * rrg     = &RailroadGroups::railroad_groups[rrgidx];
-                        uint_fast8_t    rridx;
-
-                        rridx = rrg->get_link_railroad (detected_loco_idx);
-
-                        if (rridx != 0xFF)
-                        {
-                            rrg->set_active_railroad (rridx, detected_loco_idx);
-                        }
-                        else
-                        {
-                            Debug::printf (DEBUG_LEVEL_VERBOSE, "Warning: RCL::execute_track_actions: cannot find linked railroad, searching for free railroad\n");
-
-                            rridx = S88::get_free_railroad (rrgidx);
-
-                            if (rridx != 0xFF)
-                            {
-                                Debug::printf (DEBUG_LEVEL_VERBOSE, "Info: free railroad found: rridx=%u\n", rridx);
-                                rrg->set_active_railroad (rridx, detected_loco_idx);
-                            }
-                            else
-                            {
-                                Debug::printf (DEBUG_LEVEL_VERBOSE, "Error: RCL::execute_track_actions: cannot find free railroad, stopping loco\n");
-
-                                if (detected_loco_idx != 0xFFFF)
-                                {
-                                    Locos::locos[detected_loco_idx].set_speed (0);
-                                }
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_WAIT_FOR_FREE_S88_CONTACT:                                  // parameters: START, LOCO, COIDX, TENTHS
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   loco_idx    = RCL::get_parameter_loco (param[1], detected_loco_idx);
-                        uint_fast16_t   coidx       = param[2];
-                        uint_fast16_t   tenths      = param[3];
-
-                        if (S88::get_state_bit (coidx) == S88_STATE_OCCUPIED)
-                        {
-                            if (loco_idx != 0xFFFF)
-                            {
-                                uint_fast8_t    current_speed = Locos::locos[loco_idx].get_speed ();
-
-                                if (start == 0)
-                                {
-                                    Locos::locos[loco_idx].set_speed (0, tenths);
-                                }
-                                else
-                                {
-                                    Event::add_event_loco_speed (start, loco_idx, EVENT_SET_LOCO_SPEED, 0, tenths);
-                                }
-
-                                Event::add_event_wait_s88 (start, coidx, loco_idx, current_speed, tenths);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_LOCO_DESTINATION:                                       // parameters: LOCO_IDX, RRG_IDX
-                    {
-                        uint_fast16_t   loco_idx    = RCL::get_parameter_loco (param[0], detected_loco_idx);
-                        uint_fast8_t    rrgidx      = param[1];
-
-                        if (loco_idx != 0xFFFF)
-                        {
-                            Locos::locos[loco_idx].set_destination (rrgidx);
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_LED:                                                    // parameters: START, LG_IDX, LED_MASK, LED_ON
-                    {
-                        uint_fast16_t   start           = param[0];
-                        uint_fast16_t   led_group_idx   = param[1];
-                        uint_fast8_t    led_mask        = param[2];
-                        uint_fast8_t    led_on          = param[3];
-
-                        if (led_group_idx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                Leds::led_groups[led_group_idx].set_state (led_mask, led_on);
-                            }
-                            else
-                            {
-                                Event::add_event_led_set_state (start, led_group_idx, led_mask, led_on);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_SWITCH:                                                 // parameters: START, SW_IDX, SW_STATE
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   swidx       = param[1];
-                        uint_fast8_t    swstate     = param[2];
-
-                        if (swidx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                Switches::switches[swidx].set_state (swstate);
-                            }
-                            else
-                            {
-                                Event::add_event_switch_set_state (start, swidx, swstate);
-                            }
-                        }
-                        break;
-                    }
-
-                    case RCL_ACTION_SET_SIGNAL:                                                 // parameters: START, SIG_IDX, SIG_STATE
-                    {
-                        uint_fast16_t   start       = param[0];
-                        uint_fast16_t   sigidx      = param[1];
-                        uint_fast8_t    sigstate    = param[2];
-
-                        if (sigidx != 0xFFFF)
-                        {
-                            if (start == 0)
-                            {
-                                Signals::signals[sigidx].set_state (sigstate);
-                            }
-                            else
-                            {
-                                Event::add_event_signal_set_state (start, sigidx, sigstate);
-                            }
-                        }
-                        break;
-                    }
-                }
-            }
-        }
-    }
+    return position < 0xFF ? position : 0xFF;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  set_new_id () - set new id
+ *  RCL::get_track_idx () - get track at position in display order
  *------------------------------------------------------------------------------------------------------------------------
  */
 uint_fast8_t
-RCL::set_new_id (uint_fast8_t track_idx, uint_fast8_t new_track_idx)
+RCL::get_track_idx (uint_fast8_t position)
 {
-    uint_fast8_t   rtc = 0xFF;
-
-    if (track_idx < RCL::n_tracks && new_track_idx < RCL::n_tracks)
-    {
-        if (track_idx != new_track_idx)
-        {
-            RCL_Track       tmptrack;
-            uint_fast8_t    tridx;
-
-            uint8_t *      map_new_track_idx = (uint8_t *) calloc (RCL::n_tracks, sizeof (uint8_t));
-
-            for (tridx = 0; tridx < RCL::n_tracks; tridx++)
-            {
-                map_new_track_idx[tridx] = tridx;
-            }
-
-            tmptrack = RCL::tracks[track_idx];
+    uint_fast16_t   trackidx = RCL::order.get_idx (position);
 
-            if (new_track_idx < track_idx)
-            {
-                for (tridx = track_idx; tridx > new_track_idx; tridx--)
-                {
-                    RCL::tracks[tridx] = RCL::tracks[tridx - 1];
-                    map_new_track_idx[tridx - 1] = tridx;
-                }
-            }
-            else // if (new_track_idx > track_idx)
-            {
-                for (tridx = track_idx; tridx < new_track_idx; tridx++)
-                {
-                    RCL::tracks[tridx], RCL::tracks[tridx + 1];
-                    map_new_track_idx[tridx + 1] = tridx;
-                }
-            }
-
-            RCL::tracks[tridx] = tmptrack;
-            map_new_track_idx[track_idx] = tridx;
-
-            for (tridx = 0; tridx < RCL::n_tracks; tridx++)
-            {
-                Debug::printf (DEBUG_LEVEL_VERBOSE, "%2d -> %2d\n", tridx, map_new_track_idx[tridx]);
-            }
-
-            free (map_new_track_idx);
-            RCL::data_changed = true;
-            rtc = new_track_idx;
-        }
-        else
-        {
-            rtc = track_idx;
-        }
-    }
-
-    return rtc;
+    return trackidx < 0xFF ? trackidx : 0xFF;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  RCL::add_track () - add a track
+ *  RCL::set_position () - move track to new position in display order. The track keeps its index, which is the
+ *  location reported by the RC detectors, so no locations, contacts and events have to be corrected.
  *------------------------------------------------------------------------------------------------------------------------
  */
 uint_fast8_t
-RCL::add (const RCL_Track& track)
+RCL::set_position (uint_fast8_t trackidx, uint_fast8_t new_position)
 {
-    if (RCL::n_tracks < RCL_MAX_RCL_TRACKS)
+    if (RCL::order.get_position (trackidx) == new_position)
     {
-        tracks.push_back(track);
-        RCL::n_tracks++;
-        return tracks.size() - 1;
+        return trackidx;
     }
+
+    if (RCL::order.set_position (trackidx, new_position))
+    {
+        RCL::data_changed = true;
+        return trackidx;
+    }
+
     return 0xFF;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  RCL::get_n_tracks () - get number of tracks
+ *  RCL::set_order () - set display order after reading ini file, positions[trackidx] may contain gaps or duplicates
  *------------------------------------------------------------------------------------------------------------------------
  */
-uint_fast8_t
-RCL::get_n_tracks (void)
+void
+RCL::set_order (std::vector<uint16_t>& new_positions)
 {
-    return n_tracks;
+    RCL::order.set_order (new_positions);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
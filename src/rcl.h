@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include "order.h"
 
 #define RCL_MAX_ACTION_PARAMETERS                   8
 #define RCL_STATE_FREE                              0
@@ -101,6 +102,13 @@ class RCL_Track
         std::string                     name;
 };
 
+typedef struct
+{
+    uint16_t                            loco_idx;
+    uint8_t                             old_location;                           // 0xFF: not on rcl track
+    uint8_t                             new_location;                           // 0xFF: not on rcl track
+} RCL_TRANSITION;
+
 class RCL
 {
     public:
@@ -109,12 +117,14 @@ class RCL
 
         static uint_fast8_t             add (const RCL_Track& track);
         static uint_fast8_t             get_n_tracks (void);
-        static uint_fast8_t             set_new_id (uint_fast8_t rcl_track_idx, uint_fast8_t new_rcl_track_idx);
-        static void                     set_new_loco_ids (uint16_t * map_new_loco_idx, uint16_t n_locos);
-        static void                     set_new_addon_ids (uint16_t * map_new_addon_idx, uint16_t n_addons);
-        static void                     set_new_switch_ids (uint16_t * map_new_switch_idx, uint16_t n_switches);
-        static void                     set_new_railroad_group_ids (uint8_t * map_new_rrgidx, uint_fast8_t n_railroad_groups);
-        static void                     set_new_railroad_ids (uint_fast8_t rrgidx, uint8_t * map_new_rridx, uint_fast8_t n_railroads);
+        static void                     clear (void);
+        static uint_fast8_t             get_position (uint_fast8_t trackidx);
+        static uint_fast8_t             get_track_idx (uint_fast8_t position);
+        static uint_fast8_t             set_position (uint_fast8_t trackidx, uint_fast8_t new_position);
+        static void                     set_order (std::vector<uint16_t>& new_positions);
+        static void                     set_new_locations (uint16_t * map_new_loco_idx, uint16_t n_locos, uint8_t * map_new_trackidx, uint_fast8_t n_rcl_tracks);
+        static void                     location_changed (uint_fast16_t loco_idx, uint_fast8_t old_location, uint_fast8_t new_location);
+        static void                     restore_locations (void);
         static uint_fast8_t             booster_on (void);
         static uint_fast8_t             booster_off (void);
         static void                     schedule (void);
@@ -122,15 +132,9 @@ class RCL
 
     private:
         static uint_fast8_t             n_tracks;                                   // number of tracks
-        static uint8_t                  locations[MAX_LOCOS];
-        static uint_fast16_t            get_parameter_loco (uint_fast16_t loco_idx, uint_fast16_t detected_loco_idx);
-        static void                     execute_track_actions (bool in, uint_fast16_t detected_loco_idx, uint_fast8_t trackidx);
+        static DisplayOrder             order;                                      // display order, see set_position ()
+        static std::vector<RCL_TRANSITION> transitions;                             // pending location changes, see location_changed ()
         static void                     reset_all_locations (void);
-        static void                     set_new_loco_ids_for_track (bool in, uint_fast8_t trackidx, uint16_t * map_new_loco_idx, uint16_t n_locos);
-        static void                     set_new_addon_ids_for_track (bool in, uint_fast8_t trackidx, uint16_t * map_new_addon_idx, uint16_t n_addons);
-        static void                     set_new_switch_ids_for_track (bool in, uint_fast8_t trackidx, uint16_t * map_new_switch_idx, uint16_t n_switches);
-        static void                     set_new_railroad_group_ids_for_track (bool in, uint_fast8_t trackidx, uint8_t * map_new_rrgidx, uint_fast8_t n_railroad_groups);
-        static void                     set_new_railroad_ids_for_track (bool in, uint_fast8_t trackidx, uint_fast8_t current_rrgidx, uint8_t * map_new_rridx, uint_fast8_t n_railroads);
 };
 
 #endif
@@ -0,0 +1,598 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * recorder.cc - record and replay of serial traffic and HTTP requests
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include "debug.h"
+#include "recorder.h"
+
+#define RECORDER_FLUSH_PERIOD           1000000                                 // flush trace file every second
+#define RECORDER_REPLAY_GRACE           1000000                                 // wait 1 sec after last record before finishing
+
+bool                            Recorder::recording;
+bool                            Recorder::replaying;
+FILE *                          Recorder::fp;
+uint64_t                        Recorder::start_usec;
+uint64_t                        Recorder::last_usec;
+uint64_t                        Recorder::last_flush_usec;
+uint_fast8_t                    Recorder::chunk_type;
+uint64_t                        Recorder::chunk_usec;
+uint64_t                        Recorder::chunk_last_usec;
+uint32_t                        Recorder::chunk_len;
+uint8_t                         Recorder::chunk[RECORDER_CHUNK_SIZE];
+bool                            Recorder::http_pending;
+
+std::vector<RECORDER_RECORD>    Recorder::records;
+std::vector<uint8_t>            Recorder::replay_data;
+uint_fast16_t                   Recorder::replay_speed = 1;
+uint32_t                        Recorder::rx_idx;
+uint32_t                        Recorder::rx_pos;
+uint32_t                        Recorder::tx_idx;
+uint32_t                        Recorder::tx_pos;
+uint32_t                        Recorder::http_idx;
+uint64_t                        Recorder::http_start_usec;
+uint64_t                        Recorder::http_recorded_usec;
+uint32_t                        Recorder::n_rx_bytes;
+uint32_t                        Recorder::n_tx_bytes;
+uint32_t                        Recorder::n_tx_mismatches;
+uint32_t                        Recorder::n_tx_extra;
+RECORDER_DIFF                   Recorder::rx_lag;
+RECORDER_DIFF                   Recorder::tx_lag;
+RECORDER_DIFF                   Recorder::http_lag;
+RECORDER_DIFF                   Recorder::http_slowdown;
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * now () - monotonic time in microseconds, does not wrap
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint64_t
+Recorder::now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000U + (uint64_t) (ts.tv_nsec / 1000);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * write_varint () - write unsigned value, 7 bits per byte
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Recorder::write_varint (uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        putc ((int) (value & 0x7F) | 0x80, Recorder::fp);
+        value >>= 7;
+    }
+
+    putc ((int) value, Recorder::fp);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * write_header () - write type, time delta and length of record, the payload follows
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Recorder::write_header (uint_fast8_t type, uint64_t usec, uint32_t len)
+{
+    uint64_t    delta = (usec > Recorder::last_usec) ? usec - Recorder::last_usec : 0;
+
+    putc (type, Recorder::fp);
+    Recorder::write_varint (delta);
+    Recorder::write_varint (len);
+    Recorder::last_usec += delta;
+
+    if (usec - Recorder::last_flush_usec >= RECORDER_FLUSH_PERIOD)              // keep trace usable after a crash
+    {
+        fflush (Recorder::fp);
+        Recorder::last_flush_usec = usec;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * flush_chunk () - write pending serial bytes
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Recorder::flush_chunk (void)
+{
+    if (Recorder::chunk_type)
+    {
+        Recorder::write_header (Recorder::chunk_type, Recorder::chunk_usec, Recorder::chunk_len);
+        fwrite (Recorder::chunk, 1, Recorder::chunk_len, Recorder::fp);
+        Recorder::chunk_type = 0;
+        Recorder::chunk_len = 0;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * serial_byte () - add serial byte to chunk, consecutive bytes of one direction are written as one record
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Recorder::serial_byte (uint_fast8_t type, uint_fast8_t ch)
+{
+    uint64_t    usec = Recorder::now () - Recorder::start_usec;
+
+    if (Recorder::chunk_type != type || Recorder::chunk_len == RECORDER_CHUNK_SIZE || usec - Recorder::chunk_last_usec > RECORDER_CHUNK_GAP)
+    {
+        Recorder::flush_chunk ();
+        Recorder::chunk_type = type;
+        Recorder::chunk_usec = usec;
+    }
+
+    Recorder::chunk[Recorder::chunk_len++] = ch;
+    Recorder::chunk_last_usec = usec;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * start_record () - start recording into file fname
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+Recorder::start_record (const char * fname)
+{
+    bool    rtc = false;
+
+    Recorder::fp = fopen (fname, "wb");
+
+    if (Recorder::fp)
+    {
+        fwrite (RECORDER_MAGIC, 1, 8, Recorder::fp);
+        Recorder::start_usec        = Recorder::now ();
+        Recorder::last_usec         = 0;
+        Recorder::last_flush_usec   = 0;
+        Recorder::recording         = true;
+        rtc = true;
+    }
+    else
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "Recorder: cannot open %s\n", fname);
+    }
+
+    return rtc;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * serial_rx () - record byte read from STM32
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Recorder::serial_rx (uint_fast8_t ch)
+{
+    Recorder::serial_byte (RECORDER_TYPE_SERIAL_RX, ch);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * serial_tx () - record byte written to STM32
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Recorder::serial_tx (uint_fast8_t ch)
+{
+    Recorder::serial_byte (RECORDER_TYPE_SERIAL_TX, ch);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * http_request () - record HTTP request before it is executed
+ *
+ * request: header lines separated by '\n', including the '\n' of the last line
+ * post:    body of POST request
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Recorder::http_request (const char * request, uint32_t request_len, const char * post, uint32_t post_len)
+{
+    if (Recorder::recording)
+    {
+        Recorder::flush_chunk ();
+        Recorder::write_header (RECORDER_TYPE_HTTP_REQUEST, Recorder::now () - Recorder::start_usec, request_len + 1 + post_len);
+        fwrite (request, 1, request_len, Recorder::fp);
+        putc ('\n', Recorder::fp);                                              // empty line: end of header
+        fwrite (post, 1, post_len, Recorder::fp);
+        Recorder::http_pending = true;
+    }
+    else if (Recorder::replaying)
+    {
+        Recorder::http_start_usec = Recorder::now ();
+        Recorder::http_pending = true;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * http_done () - HTTP request has been executed
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Recorder::http_done (void)
+{
+    if (Recorder::http_pending)
+    {
+        if (Recorder::recording)
+        {
+            Recorder::flush_chunk ();
+            Recorder::write_header (RECORDER_TYPE_HTTP_DONE, Recorder::now () - Recorder::start_usec, 0);
+        }
+        else
+        {
+            int64_t duration = Recorder::now () - Recorder::http_start_usec;
+            Recorder::add_diff (&Recorder::http_slowdown, duration - (int64_t) Recorder::http_recorded_usec);
+        }
+
+        Recorder::http_pending = false;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * next_record () - index of next record of type starting at idx, records.size() if none
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint32_t
+Recorder::next_record (uint32_t idx, uint_fast8_t type)
+{
+    while (idx < Recorder::records.size() && Recorder::records[idx].type != type)
+    {
+        idx++;
+    }
+
+    return idx;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * replay_now () - time since start of replay, scaled to time of trace
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint64_t
+Recorder::replay_now (void)
+{
+    return (Recorder::now () - Recorder::start_usec) * Recorder::replay_speed;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * add_diff () - add timing difference
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Recorder::add_diff (RECORDER_DIFF * diffp, int64_t usec)
+{
+    if (diffp->n == 0 || usec < diffp->min)
+    {
+        diffp->min = usec;
+    }
+
+    if (diffp->n == 0 || usec > diffp->max)
+    {
+        diffp->max = usec;
+    }
+
+    diffp->sum += usec;
+    diffp->n++;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * start_replay () - load trace file fname and start replay, speed 1: original speed, n: n times faster
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+Recorder::start_replay (const char * fname, uint_fast16_t speed)
+{
+    FILE *      replay_fp;
+    uint8_t     buf[4096];
+    size_t      n;
+    uint32_t    pos;
+    uint64_t    usec = 0;
+    bool        rtc = true;
+
+    replay_fp = fopen (fname, "rb");
+
+    if (! replay_fp)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "Recorder: cannot open %s\n", fname);
+        return false;
+    }
+
+    while ((n = fread (buf, 1, sizeof (buf), replay_fp)) > 0)
+    {
+        Recorder::replay_data.insert (Recorder::replay_data.end(), buf, buf + n);
+    }
+
+    fclose (replay_fp);
+
+    if (Recorder::replay_data.size() < 8 || memcmp (Recorder::replay_data.data(), RECORDER_MAGIC, 8) != 0)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "Recorder: %s is no trace file\n", fname);
+        return false;
+    }
+
+    pos = 8;
+
+    while (pos < Recorder::replay_data.size())
+    {
+        RECORDER_RECORD     rec;
+        uint64_t            value[2];
+        uint_fast8_t        i;
+
+        rec.type = Recorder::replay_data[pos++];
+
+        for (i = 0; i < 2; i++)                                                 // delta and len
+        {
+            uint_fast8_t    shift = 0;
+            uint8_t         ch;
+
+            value[i] = 0;
+
+            do
+            {
+                if (pos >= Recorder::replay_data.size() || shift > 56)
+                {
+                    rtc = false;
+                    break;
+                }
+
+                ch = Recorder::replay_data[pos++];
+                value[i] |= (uint64_t) (ch & 0x7F) << shift;
+                shift += 7;
+            } while (ch & 0x80);
+        }
+
+        if (! rtc || value[1] > Recorder::replay_data.size() - pos)
+        {
+            Debug::printf (DEBUG_LEVEL_NONE, "Recorder: %s is truncated, replaying %u records\n", fname, (unsigned int) Recorder::records.size());
+            rtc = true;
+            break;
+        }
+
+        usec += value[0];
+        rec.usec    = usec;
+        rec.offset  = pos;
+        rec.len     = value[1];
+        pos += rec.len;
+
+        Recorder::records.push_back (rec);
+    }
+
+    Recorder::replay_speed  = speed ? speed : 1;
+    Recorder::rx_idx        = Recorder::next_record (0, RECORDER_TYPE_SERIAL_RX);
+    Recorder::tx_idx        = Recorder::next_record (0, RECORDER_TYPE_SERIAL_TX);
+    Recorder::http_idx      = Recorder::next_record (0, RECORDER_TYPE_HTTP_REQUEST);
+    Recorder::start_usec    = Recorder::now ();
+    Recorder::replaying     = true;
+
+    Debug::printf (DEBUG_LEVEL_NONE, "Recorder: replaying %u records of %s, speed %u\n",
+                   (unsigned int) Recorder::records.size(), fname, (unsigned int) Recorder::replay_speed);
+    return rtc;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * replay_rx () - simulated STM32: next recorded byte if it is due
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+Recorder::replay_rx (uint_fast8_t * chp)
+{
+    RECORDER_RECORD *   rec;
+    uint64_t            usec;
+
+    if (Recorder::rx_idx >= Recorder::records.size())
+    {
+        return 0;
+    }
+
+    rec = &Recorder::records[Recorder::rx_idx];
+
+    if (Recorder::rx_pos == 0)
+    {
+        usec = Recorder::replay_now ();
+
+        if (usec < rec->usec)
+        {
+            return 0;
+        }
+
+        Recorder::add_diff (&Recorder::rx_lag, usec - rec->usec);
+    }
+
+    *chp = Recorder::replay_data[rec->offset + Recorder::rx_pos];
+    Recorder::rx_pos++;
+    Recorder::n_rx_bytes++;
+
+    if (Recorder::rx_pos >= rec->len)
+    {
+        Recorder::rx_idx = Recorder::next_record (Recorder::rx_idx + 1, RECORDER_TYPE_SERIAL_RX);
+        Recorder::rx_pos = 0;
+    }
+
+    return 1;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * replay_tx () - simulated STM32: compare sent byte with recorded byte
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Recorder::replay_tx (uint_fast8_t ch)
+{
+    RECORDER_RECORD *   rec;
+
+    Recorder::n_tx_bytes++;
+
+    if (Recorder::tx_idx >= Recorder::records.size())
+    {
+        Recorder::n_tx_extra++;
+        return;
+    }
+
+    rec = &Recorder::records[Recorder::tx_idx];
+
+    if (Recorder::tx_pos == 0)
+    {
+        Recorder::add_diff (&Recorder::tx_lag, (int64_t) Recorder::replay_now () - (int64_t) rec->usec);
+    }
+
+    if (Recorder::replay_data[rec->offset + Recorder::tx_pos] != ch)
+    {
+        Recorder::n_tx_mismatches++;
+    }
+
+    Recorder::tx_pos++;
+
+    if (Recorder::tx_pos >= rec->len)
+    {
+        Recorder::tx_idx = Recorder::next_record (Recorder::tx_idx + 1, RECORDER_TYPE_SERIAL_TX);
+        Recorder::tx_pos = 0;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * replay_http () - get next recorded HTTP request if it is due
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+Recorder::replay_http (const char ** requestp, uint32_t * lenp)
+{
+    RECORDER_RECORD *   rec;
+    uint32_t            done_idx;
+    uint64_t            usec;
+
+    if (Recorder::http_idx >= Recorder::records.size())
+    {
+        return false;
+    }
+
+    rec = &Recorder::records[Recorder::http_idx];
+    usec = Recorder::replay_now ();
+
+    if (usec < rec->usec)
+    {
+        return false;
+    }
+
+    Recorder::add_diff (&Recorder::http_lag, usec - rec->usec);
+
+    done_idx = Recorder::next_record (Recorder::http_idx + 1, RECORDER_TYPE_HTTP_DONE);
+
+    if (done_idx < Recorder::records.size())
+    {
+        Recorder::http_recorded_usec = Recorder::records[done_idx].usec - rec->usec;
+    }
+    else
+    {
+        Recorder::http_recorded_usec = 0;
+    }
+
+    *requestp   = (const char *) Recorder::replay_data.data() + rec->offset;
+    *lenp       = rec->len;
+
+    Recorder::http_idx = Recorder::next_record (Recorder::http_idx + 1, RECORDER_TYPE_HTTP_REQUEST);
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * replay_finished () - all recorded input has been replayed
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+Recorder::replay_finished (void)
+{
+    bool    rtc = false;
+
+    if (Recorder::replaying && Recorder::rx_idx >= Recorder::records.size() && Recorder::http_idx >= Recorder::records.size())
+    {
+        uint64_t    end_usec = Recorder::records.empty() ? 0 : Recorder::records.back().usec;
+
+        if (Recorder::tx_idx >= Recorder::records.size() || Recorder::replay_now () >= end_usec + RECORDER_REPLAY_GRACE)
+        {
+            rtc = true;
+        }
+    }
+
+    return rtc;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * print_diff () - print timing differences
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Recorder::print_diff (const char * name, const RECORDER_DIFF * diffp)
+{
+    if (diffp->n)
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "Recorder: %-14s n=%u avg=%lld min=%lld max=%lld usec\n", name, diffp->n,
+                       (long long) (diffp->sum / diffp->n), (long long) diffp->min, (long long) diffp->max);
+    }
+    else
+    {
+        Debug::printf (DEBUG_LEVEL_NONE, "Recorder: %-14s n=0\n", name);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * report () - print timing differences between trace and replay
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Recorder::report (void)
+{
+    uint64_t    end_usec    = Recorder::records.empty() ? 0 : Recorder::records.back().usec;
+    uint32_t    n_missing   = 0;
+    uint32_t    idx;
+
+    for (idx = Recorder::tx_idx; idx < Recorder::records.size(); idx = Recorder::next_record (idx + 1, RECORDER_TYPE_SERIAL_TX))
+    {
+        n_missing += Recorder::records[idx].len;
+    }
+
+    n_missing -= Recorder::tx_pos;
+
+    Debug::printf (DEBUG_LEVEL_NONE, "Recorder: speed %u, trace %llu msec, replay %llu msec (scaled)\n", (unsigned int) Recorder::replay_speed,
+                   (unsigned long long) (end_usec / 1000), (unsigned long long) (Recorder::replay_now () / 1000));
+    Debug::printf (DEBUG_LEVEL_NONE, "Recorder: serial rx %u bytes, tx %u bytes, %u mismatches, %u extra, %u missing\n",
+                   Recorder::n_rx_bytes, Recorder::n_tx_bytes, Recorder::n_tx_mismatches, Recorder::n_tx_extra, n_missing);
+    Recorder::print_diff ("rx lag", &Recorder::rx_lag);
+    Recorder::print_diff ("tx lag", &Recorder::tx_lag);
+    Recorder::print_diff ("http lag", &Recorder::http_lag);
+    Recorder::print_diff ("http slowdown", &Recorder::http_slowdown);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * deinit () - close trace file or report replay results
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Recorder::deinit (void)
+{
+    if (Recorder::recording)
+    {
+        Recorder::flush_chunk ();
+        fclose (Recorder::fp);
+        Recorder::fp = (FILE *) NULL;
+        Recorder::recording = false;
+    }
+    else if (Recorder::replaying)
+    {
+        Recorder::report ();
+        Recorder::replaying = false;
+    }
+}
@@ -0,0 +1,129 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * recorder.h - record and replay of serial traffic and HTTP requests
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+#define RECORDER_MAGIC                  "FM22REC1"                              // file header, 8 bytes
+
+#define RECORDER_TYPE_SERIAL_RX         1                                       // bytes read from STM32
+#define RECORDER_TYPE_SERIAL_TX         2                                       // bytes written to STM32
+#define RECORDER_TYPE_HTTP_REQUEST      3                                       // raw request: header lines, empty line, POST body
+#define RECORDER_TYPE_HTTP_DONE         4                                       // end of request handling, no payload
+
+#define RECORDER_CHUNK_SIZE             256                                     // max. serial bytes per record
+#define RECORDER_CHUNK_GAP              1000                                    // new serial record after 1000 usec silence
+
+typedef struct
+{
+    uint8_t             type;                                                   // RECORDER_TYPE_xxx
+    uint64_t            usec;                                                   // time since start of recording
+    uint32_t            offset;                                                 // offset of payload in replay_data
+    uint32_t            len;                                                    // length of payload
+} RECORDER_RECORD;
+
+typedef struct
+{
+    uint32_t            n;                                                      // number of measurements
+    int64_t             sum;                                                    // sum of differences in usec
+    int64_t             min;                                                    // min. difference in usec
+    int64_t             max;                                                    // max. difference in usec
+} RECORDER_DIFF;
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * Trace file: RECORDER_MAGIC, then records of
+ *
+ *      type        1 byte, RECORDER_TYPE_xxx
+ *      delta       varint, usec since previous record
+ *      len         varint, length of payload
+ *      payload     len bytes
+ *
+ * varint: 7 bits per byte, LSB first, bit 7 set if more bytes follow.
+ *
+ * Replay simulates the STM32: received bytes are delivered by Serial::poll() when they are due, bytes sent by
+ * Serial::send() are compared with the recorded ones. HTTP requests are executed again at their recorded time.
+ * Replay changes the runtime state (journal, ini files), so run it in a copy of the working directory.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+class Recorder
+{
+    public:
+        static bool                     recording;                              // flag: trace file is written
+        static bool                     replaying;                              // flag: trace file is replayed
+
+        static bool                     start_record (const char * fname);
+        static bool                     start_replay (const char * fname, uint_fast16_t speed);
+        static void                     serial_rx (uint_fast8_t ch);
+        static void                     serial_tx (uint_fast8_t ch);
+        static void                     http_request (const char * request, uint32_t request_len, const char * post, uint32_t post_len);
+        static void                     http_done (void);
+        static uint_fast8_t             replay_rx (uint_fast8_t * chp);
+        static void                     replay_tx (uint_fast8_t ch);
+        static bool                     replay_http (const char ** requestp, uint32_t * lenp);
+        static bool                     replay_finished (void);
+        static void                     report (void);
+        static void                     deinit (void);
+
+    private:
+        static FILE *                   fp;                                     // trace file while recording
+        static uint64_t                 start_usec;                             // start of recording or replay
+        static uint64_t                 last_usec;                              // time of last written record
+        static uint64_t                 last_flush_usec;                        // time of last fflush ()
+        static uint_fast8_t             chunk_type;                             // type of pending serial chunk, 0: none
+        static uint64_t                 chunk_usec;                             // time of first byte of chunk
+        static uint64_t                 chunk_last_usec;                        // time of last byte of chunk
+        static uint32_t                 chunk_len;
+        static uint8_t                  chunk[RECORDER_CHUNK_SIZE];
+        static bool                     http_pending;                           // flag: HTTP_DONE record is due
+
+        static std::vector<RECORDER_RECORD>  records;                           // records of replayed trace
+        static std::vector<uint8_t>     replay_data;                            // payloads of replayed trace
+        static uint_fast16_t            replay_speed;                           // 1: original speed, n: n times faster
+        static uint32_t                 rx_idx;                                 // next RX record
+        static uint32_t                 rx_pos;                                 // position in RX record
+        static uint32_t                 tx_idx;                                 // next expected TX record
+        static uint32_t                 tx_pos;                                 // position in TX record
+        static uint32_t                 http_idx;                               // next HTTP request
+        static uint64_t                 http_start_usec;                        // start of replayed request
+        static uint64_t                 http_recorded_usec;                     // recorded duration of request
+        static uint32_t                 n_rx_bytes;
+        static uint32_t                 n_tx_bytes;
+        static uint32_t                 n_tx_mismatches;                        // bytes differing from trace
+        static uint32_t                 n_tx_extra;                             // bytes sent after end of trace
+        static RECORDER_DIFF            rx_lag;                                 // delivery of RX chunk - recorded time
+        static RECORDER_DIFF            tx_lag;                                 // start of TX chunk - recorded time
+        static RECORDER_DIFF            http_lag;                               // start of request - recorded time
+        static RECORDER_DIFF            http_slowdown;                          // duration of request - recorded duration
+
+        static uint64_t                 now (void);
+        static void                     write_varint (uint64_t value);
+        static void                     write_header (uint_fast8_t type, uint64_t usec, uint32_t len);
+        static void                     flush_chunk (void);
+        static void                     serial_byte (uint_fast8_t type, uint_fast8_t ch);
+        static uint32_t                 next_record (uint32_t idx, uint_fast8_t type);
+        static uint64_t                 replay_now (void);
+        static void                     add_diff (RECORDER_DIFF * diffp, int64_t usec);
+        static void                     print_diff (const char * name, const RECORDER_DIFF * diffp);
+};
+
+#endif
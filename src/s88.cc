@@ -32,18 +32,26 @@
 #include "addon.h"
 #include "led.h"
 #include "railroad.h"
+#include "interlock.h"
+#include "topology.h"
+#include "automation.h"
 #include "rcl.h"
+#include "fm22.h"
 #include "debug.h"
+#include "metrics.h"
 #include "s88.h"
 
 #define S88_MAX_CONTACT_BYTES   (S88_MAX_CONTACTS / sizeof (uint8_t))
 
 bool                            S88::data_changed = false;
+bool                            S88::links_changed = true;                  // flag: rrg index must be rebuilt
 std::vector<S88_Contact>        S88::contacts;
-uint8_t                         S88::new_bits[S88_MAX_CONTACT_BYTES];
-uint8_t                         S88::current_bits[S88_MAX_CONTACT_BYTES];
+uint64_t                        S88::new_bits[S88_MAX_CONTACT_WORDS];       // contact coidx is bit coidx % 64 of word coidx / 64
+uint64_t                        S88::current_bits[S88_MAX_CONTACT_WORDS];
+uint64_t                        S88::rrg_contacts[MAX_RAILROAD_GROUPS][S88_MAX_CONTACT_WORDS];
 uint_fast16_t                   S88::n_contacts = 0;                        // number of contacts
 bool                            S88::n_contacts_changed = true;             // flag: number of contacts changed
+DisplayOrder                    S88::order;                                 // display order
 
 /*------------------------------------------------------------------------------------------------------------------------
  *  S88_Contact () - constructor
@@ -58,410 +66,6 @@ S88_Contact::S88_Contact ()
     this->n_contact_actions_out     = 0;
 }
 
-/*------------------------------------------------------------------------------------------------------------------------
- *  S88_Contact::get_link_loco () - get link to loco by linked railroad
- *------------------------------------------------------------------------------------------------------------------------
- */
-uint_fast16_t
-S88_Contact::get_link_loco (bool in, uint_fast8_t caidx, uint_fast8_t paidx)
-{
-    uint_fast16_t   loco_idx;
-
-    if (in)
-    {
-        loco_idx    = this->contact_actions_in[caidx].parameters[paidx];
-    }
-    else
-    {
-        loco_idx    = this->contact_actions_out[caidx].parameters[paidx];
-    }
-
-    if (loco_idx == 0xFFFF)
-    {
-        uint_fast8_t    rrgidx  = this->rrgidx;
-        uint_fast8_t    rridx   = this->rridx;
-        Railroad *      rr      = &RailroadGroups::railroad_groups[rrgidx].railroads[rridx];
-
-        loco_idx = rr->get_link_loco ();
-    }
-    else if (loco_idx >= S88_RCL_DETECTED_OFFSET)
-    {
-        uint_fast8_t    track_idx = loco_idx - S88_RCL_DETECTED_OFFSET;
-        uint_fast8_t    n_tracks = RCL::get_n_tracks ();
-
-        if (track_idx < n_tracks)
-        {
-            loco_idx = RCL::tracks[track_idx].last_loco_idx;
-        }
-        else
-        {
-            loco_idx = 0xFFFF;
-        }
-    }
-
-    return loco_idx;
-}
-
-/*------------------------------------------------------------------------------------------------------------------------
- *  S88_Contact::execute_contact_actions () - execute contact actions
- *------------------------------------------------------------------------------------------------------------------------
- */
-void
-S88_Contact::execute_contact_actions (bool in)
-{
-    CONTACT_ACTION  *   cap;
-    uint_fast8_t        n_contact_actions;
-    uint_fast8_t        caidx;
-
-    if (in)
-    {
-        n_contact_actions = this->n_contact_actions_in;
-        cap = this->contact_actions_in;
-    }
-    else
-    {
-        n_contact_actions = this->n_contact_actions_out;
-        cap = this->contact_actions_out;
-    }
-
-    for (caidx = 0; caidx < n_contact_actions; caidx++)
-    {
-        switch (cap[caidx].action)
-        {
-            case S88_ACTION_SET_LOCO_SPEED:                                             // parameters: START, LOCO_IDX, SPEED, TENTHS
-            {
-                uint_fast32_t   start       = cap[caidx].parameters[0];
-                uint_fast16_t   loco_idx    = this->get_link_loco (in, caidx, 1);
-                uint_fast8_t    speed       = cap[caidx].parameters[2];
-                uint_fast16_t   tenths      = cap[caidx].parameters[3];
-
-                if (loco_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        Locos::locos[loco_idx].set_speed (speed, tenths);
-                    }
-                    else
-                    {
-                        Event::add_event_loco_speed (start, loco_idx, EVENT_SET_LOCO_SPEED, speed, tenths);
-                    }
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_LOCO_MIN_SPEED:                                         // parameters: START, LOCO_IDX, SPEED, TENTHS
-            {
-                uint_fast32_t   start       = cap[caidx].parameters[0];
-                uint_fast16_t   loco_idx    = this->get_link_loco (in, caidx, 1);
-                uint_fast8_t    speed       = cap[caidx].parameters[2];
-                uint_fast16_t   tenths      = cap[caidx].parameters[3];
-
-                if (loco_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        uint_fast8_t current_speed = Locos::locos[loco_idx].get_speed ();
-
-                        if (current_speed < speed)
-                        {
-                            Locos::locos[loco_idx].set_speed (speed, tenths);
-                        }
-                    }
-                    else
-                    {
-                        Event::add_event_loco_speed (start, loco_idx, EVENT_SET_LOCO_MIN_SPEED, speed, tenths);
-                    }
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_LOCO_MAX_SPEED:                                         // parameters: START, LOCO_IDX, SPEED, TENTHS
-            {
-                uint_fast32_t   start       = cap[caidx].parameters[0];
-                uint_fast16_t   loco_idx    = this->get_link_loco (in, caidx, 1);
-                uint_fast8_t    speed       = cap[caidx].parameters[2];
-                uint_fast16_t   tenths      = cap[caidx].parameters[3];
-
-                if (loco_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        uint_fast8_t current_speed = Locos::locos[loco_idx].get_speed ();
-
-                        if (current_speed > speed)
-                        {
-                            Locos::locos[loco_idx].set_speed (speed, tenths);
-                        }
-                    }
-                    else
-                    {
-                        Event::add_event_loco_speed (start, loco_idx, EVENT_SET_LOCO_MAX_SPEED, speed, tenths);
-                    }
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_LOCO_FORWARD_DIRECTION:                                 // parameters: START, LOCO_IDX, FWD
-            {
-                uint_fast32_t   start       = cap[caidx].parameters[0];
-                uint_fast16_t   loco_idx    = this->get_link_loco (in, caidx, 1);
-                uint_fast8_t    fwd         = cap[caidx].parameters[2];
-
-                if (loco_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        Locos::locos[loco_idx].set_fwd (fwd);
-                    }
-                    else
-                    {
-                        Event::add_event_loco_dir (start, loco_idx, fwd);
-                    }
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_LOCO_ALL_FUNCTIONS_OFF:                                     // parameters: START, LOCO_IDX
-            {
-                uint_fast32_t   start       = cap[caidx].parameters[0];
-                uint_fast16_t   loco_idx    = this->get_link_loco (in, caidx, 1);
-
-                if (loco_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        Locos::locos[loco_idx].reset_functions ();
-                    }
-                    else
-                    {
-                        Event::add_event_loco_function (start, loco_idx, 0xFF, false);
-                    }
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_LOCO_FUNCTION_OFF:                                          // parameters: START, LOCO_IDX, FUNC_IDX
-            {
-                uint_fast32_t   start       = cap[caidx].parameters[0];
-                uint_fast16_t   loco_idx    = this->get_link_loco (in, caidx, 1);
-                uint_fast8_t    f           = cap[caidx].parameters[2];
-
-                if (loco_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        Locos::locos[loco_idx].set_function (f, false);
-                    }
-                    else
-                    {
-                        Event::add_event_loco_function (start, loco_idx, f, false);
-                    }
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_LOCO_FUNCTION_ON:                                           // parameters: START, LOCO_IDX, FUNC_IDX
-            {
-                uint_fast32_t   start       = cap[caidx].parameters[0];
-                uint_fast16_t   loco_idx    = this->get_link_loco (in, caidx, 1);
-                uint_fast8_t    f           = cap[caidx].parameters[2];
-
-                if (loco_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        Locos::locos[loco_idx].set_function (f, true);
-                    }
-                    else
-                    {
-                        Event::add_event_loco_function (start, loco_idx, f, true);
-                    }
-                }
-                break;
-            }
-
-            case S88_ACTION_EXECUTE_LOCO_MACRO:                                             // parameters: START, LOCO_IDX, MACRO_IDX
-            {
-                uint_fast32_t   start       = cap[caidx].parameters[0];
-                uint_fast16_t   loco_idx    = this->get_link_loco (in, caidx, 1);
-                uint_fast8_t    macro_idx   = cap[caidx].parameters[2];
-
-                if (loco_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        Locos::locos[loco_idx].execute_macro (macro_idx);
-                    }
-                    else
-                    {
-                        Event::add_event_execute_loco_macro (start, loco_idx, macro_idx);
-                    }
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_ADDON_ALL_FUNCTIONS_OFF:                                     // parameters: START, ADDON_IDX
-            {
-                uint_fast32_t   start       = cap[caidx].parameters[0];
-                uint_fast16_t   addon_idx   = cap[caidx].parameters[1];
-
-                if (addon_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        AddOns::addons[addon_idx].reset_functions ();
-                    }
-                    else
-                    {
-                        Event::add_event_addon_function (start, addon_idx, 0xFF, false);
-                    }
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_ADDON_FUNCTION_OFF:                                          // parameters: START, ADDON_IDX, FUNC_IDX
-            {
-                uint_fast32_t   start       = cap[caidx].parameters[0];
-                uint_fast16_t   addon_idx   = cap[caidx].parameters[1];
-                uint_fast8_t    f           = cap[caidx].parameters[2];
-
-                if (addon_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        AddOns::addons[addon_idx].set_function (f, false);
-                    }
-                    else
-                    {
-                        Event::add_event_addon_function (start, addon_idx, f, false);
-                    }
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_ADDON_FUNCTION_ON:                                          // parameters: START, ADDON_IDX, FUNC_IDX
-            {
-                uint_fast32_t   start       = cap[caidx].parameters[0];
-                uint_fast16_t   addon_idx   = cap[caidx].parameters[1];
-                uint_fast8_t    f           = cap[caidx].parameters[2];
-
-                if (addon_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        AddOns::addons[addon_idx].set_function (f, true);
-                    }
-                    else
-                    {
-                        Event::add_event_addon_function (start, addon_idx, f, true);
-                    }
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_RAILROAD:                                               // parameters: RRG_IDX, RR_IDX
-            {
-                uint_fast8_t    rrgidx  = cap[caidx].parameters[0];
-                uint_fast8_t    rridx   = cap[caidx].parameters[1];
-                RailroadGroup * rrg     = &RailroadGroups::railroad_groups[rrgidx];
-
-                rrg->set_active_railroad(rridx);
-                break;
-            }
-
-            case S88_ACTION_SET_FREE_RAILROAD:                                          // parameters: RRG_IDX
-            {
-                uint_fast8_t    rrgidx  = cap[caidx].parameters[0];
-                uint_fast8_t    rridx   = S88::get_free_railroad (rrgidx);
-                RailroadGroup * rrg     = &RailroadGroups::railroad_groups[rrgidx];
-
-                if (rridx != 0xFF)
-                {
-                    rrg->set_active_railroad(rridx);
-                }
-                else
-                {
-                    Debug::printf (DEBUG_LEVEL_VERBOSE, "S88::execute_contact_actions: cannot find free railroad\n");
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_LOCO_DESTINATION:                                       // parameters: LOCO_IDX, RRG_IDX
-            {
-                uint_fast16_t   loco_idx    = this->get_link_loco (in, caidx, 0);
-                uint_fast8_t    rrgidx      = cap[caidx].parameters[1];
-
-                if (loco_idx != 0xFFFF)
-                {
-                    Locos::locos[loco_idx].set_destination(rrgidx);
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_LED:                                                    // parameters: START, LG_IDX, LED_MASK, LED_ON
-            {
-                uint_fast16_t   start           = cap[caidx].parameters[0];
-                uint_fast16_t   led_group_idx   = cap[caidx].parameters[1];
-                uint_fast8_t    led_mask        = cap[caidx].parameters[2];
-                uint_fast8_t    led_on          = cap[caidx].parameters[3];
-
-                if (led_group_idx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        Leds::led_groups[led_group_idx].set_state (led_mask, led_on);
-                    }
-                    else
-                    {
-                        Event::add_event_led_set_state (start, led_group_idx, led_mask, led_on);
-                    }
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_SWITCH:                                                 // parameters: START, SW_IDX, SW_STATE
-            {
-                uint_fast16_t   start       = cap[caidx].parameters[0];
-                uint_fast16_t   swidx       = cap[caidx].parameters[1];
-                uint_fast8_t    swstate     = cap[caidx].parameters[2];
-
-                if (swidx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        Switches::switches[swidx].set_state (swstate);
-                    }
-                    else
-                    {
-                        Event::add_event_switch_set_state (start, swidx, swstate);
-                    }
-                }
-                break;
-            }
-
-            case S88_ACTION_SET_SIGNAL:                                                 // parameters: START, SIG_IDX, SIG_STATE
-            {
-                uint_fast16_t   start       = cap[caidx].parameters[0];
-                uint_fast16_t   sigidx      = cap[caidx].parameters[1];
-                uint_fast8_t    sigstate    = cap[caidx].parameters[2];
-
-                if (sigidx != 0xFFFF)
-                {
-                    if (start == 0)
-                    {
-                        Signals::signals[sigidx].set_state (sigstate);
-                    }
-                    else
-                    {
-                        Event::add_event_signal_set_state (start, sigidx, sigstate);
-                    }
-                }
-                break;
-            }
-        }
-    }
-}
-
 /*------------------------------------------------------------------------------------------------------------------------
  *  S88_Contact::set_name () - set name of contact
  *------------------------------------------------------------------------------------------------------------------------
@@ -493,6 +97,9 @@ S88_Contact::set_link_railroad (uint_fast8_t rrgidx, uint_fast8_t rridx)
     this->rrgidx  = rrgidx;
     this->rridx   = rridx;
     S88::data_changed = true;
+    Topology::invalidate ();
+    Automation::invalidate ();
+    S88::links_changed = true;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -524,6 +131,8 @@ S88_Contact::add_contact_action (bool in)
             this->contact_actions_in[caidx].n_parameters  = 0;
             this->n_contact_actions_in++;
             S88::data_changed = true;
+            Topology::invalidate ();
+            Automation::invalidate ();
         }
         else
         {
@@ -539,6 +148,8 @@ S88_Contact::add_contact_action (bool in)
             this->contact_actions_out[caidx].n_parameters = 0;
             this->n_contact_actions_out++;
             S88::data_changed = true;
+            Topology::invalidate ();
+            Automation::invalidate ();
         }
         else
         {
@@ -580,6 +191,8 @@ S88_Contact::delete_contact_action (bool in, uint_fast8_t caidx)
 
             this->n_contact_actions_in--;
             S88::data_changed = true;
+            Topology::invalidate ();
+            Automation::invalidate ();
         }
     }
     else
@@ -603,6 +216,8 @@ S88_Contact::delete_contact_action (bool in, uint_fast8_t caidx)
 
             this->n_contact_actions_out--;
             S88::data_changed = true;
+            Topology::invalidate ();
+            Automation::invalidate ();
         }
     }
 }
@@ -652,6 +267,8 @@ S88_Contact::set_contact_action (bool in, uint_fast8_t caidx, CONTACT_ACTION * c
             }
 
             S88::data_changed = true;
+            Topology::invalidate ();
+            Automation::invalidate ();
             rtc = 1;
         }
     }
@@ -670,6 +287,8 @@ S88_Contact::set_contact_action (bool in, uint_fast8_t caidx, CONTACT_ACTION * c
             }
 
             S88::data_changed = true;
+            Topology::invalidate ();
+            Automation::invalidate ();
             rtc = 1;
         }
     }
@@ -722,218 +341,6 @@ S88_Contact::get_contact_action (bool in, uint_fast8_t caidx, CONTACT_ACTION * c
     return rtc;
 }
 
-void
-S88_Contact::set_new_loco_ids_for_contact (bool in, uint16_t * map_new_loco_idx, uint16_t n_locos)
-{
-    CONTACT_ACTION  *   cap;
-    uint_fast8_t        n_contact_actions;
-    uint_fast8_t        caidx;
-
-    if (in)
-    {
-        n_contact_actions = this->n_contact_actions_in;
-        cap = this->contact_actions_in;
-    }
-    else
-    {
-        n_contact_actions = this->n_contact_actions_out;
-        cap = this->contact_actions_out;
-    }
-
-    for (caidx = 0; caidx < n_contact_actions; caidx++)
-    {
-        switch (cap[caidx].action)
-        {
-            case S88_ACTION_SET_LOCO_SPEED:                                             // parameters: START, LOCO_IDX, SPEED, TENTHS
-            case S88_ACTION_SET_LOCO_MIN_SPEED:                                         // parameters: START, LOCO_IDX, SPEED, TENTHS
-            case S88_ACTION_SET_LOCO_MAX_SPEED:                                         // parameters: START, LOCO_IDX, SPEED, TENTHS
-            case S88_ACTION_SET_LOCO_FORWARD_DIRECTION:                                 // parameters: START, LOCO_IDX, FWD
-            case S88_ACTION_SET_LOCO_ALL_FUNCTIONS_OFF:                                 // parameters: START, LOCO_IDX
-            case S88_ACTION_SET_LOCO_FUNCTION_OFF:                                      // parameters: START, LOCO_IDX, FUNC_IDX
-            case S88_ACTION_SET_LOCO_FUNCTION_ON:                                       // parameters: START, LOCO_IDX, FUNC_IDX
-            case S88_ACTION_EXECUTE_LOCO_MACRO:                                         // parameters: START, LOCO_IDX, MACRO_IDX
-            {
-                uint_fast16_t   loco_idx    = cap[caidx].parameters[1];
-
-                if (loco_idx < n_locos && loco_idx != map_new_loco_idx[loco_idx])
-                {
-                    if (in)
-                    {
-                        this->contact_actions_in[caidx].parameters[1] = map_new_loco_idx[loco_idx];
-                    }
-                    else
-                    {
-                        this->contact_actions_out[caidx].parameters[1] = map_new_loco_idx[loco_idx];
-                    }
-
-                    S88::data_changed = true;
-                }
-
-                break;
-            }
-        }
-    }
-}
-
-void
-S88_Contact::set_new_addon_ids_for_contact (bool in, uint16_t * map_new_addon_idx, uint16_t n_addons)
-{
-    CONTACT_ACTION  *   cap;
-    uint_fast8_t        n_contact_actions;
-    uint_fast8_t        caidx;
-
-    if (in)
-    {
-        n_contact_actions = this->n_contact_actions_in;
-        cap = this->contact_actions_in;
-    }
-    else
-    {
-        n_contact_actions = this->n_contact_actions_out;
-        cap = this->contact_actions_out;
-    }
-
-    for (caidx = 0; caidx < n_contact_actions; caidx++)
-    {
-        switch (cap[caidx].action)
-        {
-            case S88_ACTION_SET_ADDON_ALL_FUNCTIONS_OFF:                                 // parameters: START, ADDON_IDX
-            case S88_ACTION_SET_ADDON_FUNCTION_OFF:                                      // parameters: START, ADDON_IDX, FUNC_IDX
-            case S88_ACTION_SET_ADDON_FUNCTION_ON:                                       // parameters: START, ADDON_IDX, FUNC_IDX
-            {
-                uint_fast16_t   addon_idx    = cap[caidx].parameters[1];
-
-                if (addon_idx < n_addons && addon_idx != map_new_addon_idx[addon_idx])
-                {
-                    if (in)
-                    {
-                        this->contact_actions_in[caidx].parameters[1] = map_new_addon_idx[addon_idx];
-                    }
-                    else
-                    {
-                        this->contact_actions_out[caidx].parameters[1] = map_new_addon_idx[addon_idx];
-                    }
-
-                    S88::data_changed = true;
-                }
-
-                break;
-            }
-        }
-    }
-}
-
-void
-S88_Contact::set_new_railroad_group_ids_for_contact (bool in, uint8_t * map_new_rrgidx, uint_fast8_t n_railroad_groups)
-{
-    CONTACT_ACTION  *   cap;
-    uint_fast8_t        n_contact_actions;
-    uint_fast8_t        caidx;
-    int                 parameter_offset;
-
-    if (in)
-    {
-        n_contact_actions = this->n_contact_actions_in;
-        cap = this->contact_actions_in;
-    }
-    else
-    {
-        n_contact_actions = this->n_contact_actions_out;
-        cap = this->contact_actions_out;
-    }
-
-    for (caidx = 0; caidx < n_contact_actions; caidx++)
-    {
-        switch (cap[caidx].action)
-        {
-            case S88_ACTION_SET_RAILROAD:                                               // parameters: RRG_IDX, RR_IDX
-            case S88_ACTION_SET_FREE_RAILROAD:                                          // parameters: RRG_IDX
-            {
-                parameter_offset = 0;
-                break;
-            }
-
-            case S88_ACTION_SET_LOCO_DESTINATION:                                       // parameters: LOCO_IDX, RRG_IDX
-            {
-                parameter_offset = 1;
-                break;
-            }
-
-            default:
-            {
-                parameter_offset = -1;
-                break;
-            }
-        }
-
-        if (parameter_offset >= 0)
-        {
-            uint_fast16_t   rrgidx    = cap[caidx].parameters[parameter_offset];
-
-            if (rrgidx < n_railroad_groups && rrgidx != map_new_rrgidx[rrgidx])
-            {
-                if (in)
-                {
-                    this->contact_actions_in[caidx].parameters[parameter_offset] = map_new_rrgidx[rrgidx];
-                }
-                else
-                {
-                    this->contact_actions_out[caidx].parameters[parameter_offset] = map_new_rrgidx[rrgidx];
-                }
-
-                S88::data_changed = true;
-            }
-        }
-    }
-}
-
-void
-S88_Contact::set_new_railroad_ids_for_contact (bool in, uint_fast8_t current_rrgidx, uint8_t * map_new_rridx, uint_fast8_t n_railroads)
-{
-    CONTACT_ACTION  *   cap;
-    uint_fast8_t        n_contact_actions;
-    uint_fast8_t        caidx;
-
-    if (in)
-    {
-        n_contact_actions = this->n_contact_actions_in;
-        cap = this->contact_actions_in;
-    }
-    else
-    {
-        n_contact_actions = this->n_contact_actions_out;
-        cap = this->contact_actions_out;
-    }
-
-    for (caidx = 0; caidx < n_contact_actions; caidx++)
-    {
-        switch (cap[caidx].action)
-        {
-            case S88_ACTION_SET_RAILROAD:                                               // parameters: RRG_IDX, RR_IDX
-            {
-                uint_fast16_t   rrgidx   = cap[caidx].parameters[0];
-                uint_fast16_t   rridx    = cap[caidx].parameters[1];
-
-                if (current_rrgidx == rrgidx && rridx < n_railroads && rridx != map_new_rridx[rridx])
-                {
-                    if (in)
-                    {
-                        this->contact_actions_in[caidx].parameters[1] = map_new_rridx[rridx];
-                    }
-                    else
-                    {
-                        this->contact_actions_out[caidx].parameters[1] = map_new_rridx[rridx];
-                    }
-
-                    S88::data_changed = true;
-                }
-
-                break;
-            }
-        }
-    }
-}
-
 /*------------------------------------------------------------------------------------------------------------------------
  *  S88::number_of_status_bytes ()
  *------------------------------------------------------------------------------------------------------------------------
@@ -960,15 +367,9 @@ S88::number_of_status_bytes (void)
 uint_fast8_t
 S88::booster_on (void)
 {
-    uint_fast16_t idx;
-    uint_fast16_t nbytes = S88::number_of_status_bytes ();
-
-    for (idx = 0; idx < nbytes; idx++)
-    {
-        S88::current_bits[idx] = 0x00;
-        S88::n_contacts_changed = true;
-    }
-
+    memset (S88::current_bits, 0, sizeof (S88::current_bits));
+    S88::n_contacts_changed = true;
+    Topology::occupancy_changed ();
     return 0;
 }
 
@@ -979,104 +380,135 @@ S88::booster_on (void)
 uint_fast8_t
 S88::booster_off (void)
 {
-    uint_fast16_t idx;
-    uint_fast16_t nbytes = S88::number_of_status_bytes ();
+    memset (S88::current_bits, 0, sizeof (S88::current_bits));
+    S88::n_contacts_changed = true;
+    Topology::occupancy_changed ();
+    return 0;
+}
 
-    for (idx = 0; idx < nbytes; idx++)
+/*------------------------------------------------------------------------------------------------------------------------
+ *  S88::contact_gets_occupied ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+S88::contact_gets_occupied (uint_fast16_t coidx)
+{
+    uint_fast16_t   rrgrridx;
+    uint_fast8_t    rrgidx;
+    uint_fast8_t    rridx;
+    uint_fast16_t   active_loco_idx;
+
+    Metrics::count (METRICS_COUNTER_S88_EDGES);
+    S88::set_state_bit (coidx, S88_STATE_OCCUPIED);
+    Topology::occupancy_changed ();
+
+    rrgrridx        = S88::contacts[coidx].get_link_railroad ();
+    rrgidx          = rrgrridx >> 8;
+    rridx           = rrgrridx & 0xFF;
+    active_loco_idx = RailroadGroups::railroad_groups[rrgidx].railroads[rridx].get_active_loco ();
+
+    RailroadGroups::railroad_groups[rrgidx].railroads[rridx].set_located_loco (active_loco_idx);
+    RailroadGroups::railroad_groups[rrgidx].railroads[rridx].set_active_loco (0xFFFF);
+    Interlocking::release (rrgidx, rridx);
+
+    if (active_loco_idx != 0xFFFF)
     {
-        S88::current_bits[idx] = 0x00;
-        S88::n_contacts_changed = true;
+        Locos::locos[active_loco_idx].set_rrlocation (rrgrridx);
     }
 
-    return 0;
+    if (Millis::elapsed () - DCC::booster_is_on_time > 3000)
+    {
+        Automation::execute_contact_actions (coidx, true);
+        DEBUG_TRACE (DEBUG_SUBSYSTEM_S88, DEBUG_LEVEL_NORMAL, "contact=%u gets occupied\r\n", (uint16_t) coidx);
+    }
+    else
+    {
+        uint_fast16_t   rrgrridx    = S88::contacts[coidx].get_link_railroad ();
+        uint_fast8_t    rrgidx      = rrgrridx >> 8;
+        uint_fast8_t    rridx       = rrgrridx & 0xFF;
+        Railroad *      rr          = &RailroadGroups::railroad_groups[rrgidx].railroads[rridx];
+        uint_fast16_t   loco_idx    = rr->get_link_loco ();
+
+        if (loco_idx != 0xFFFF)
+        {
+            Locos::locos[loco_idx].set_rrlocation (rrgrridx);
+            DEBUG_TRACE (DEBUG_SUBSYSTEM_S88, DEBUG_LEVEL_NORMAL, "contact=%u: setting loco #%u\r\n", (uint16_t) coidx, (uint16_t) loco_idx);
+        }
+        else
+        {
+            DEBUG_TRACE (DEBUG_SUBSYSTEM_S88, DEBUG_LEVEL_NORMAL, "contact=%u gets occupied... ignored\r\n", (uint16_t) coidx);
+        }
+    }
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  S88::schedule ()
+ *  S88::contact_gets_free ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+S88::contact_gets_free (uint_fast16_t coidx)
+{
+    uint_fast16_t   rrgrridx;
+    uint_fast8_t    rrgidx;
+    uint_fast8_t    rridx;
+    uint_fast16_t   located_loco_idx;
+
+    rrgrridx            = S88::contacts[coidx].get_link_railroad ();
+    rrgidx              = rrgrridx >> 8;
+    rridx               = rrgrridx & 0xFF;
+    located_loco_idx    = RailroadGroups::railroad_groups[rrgidx].railroads[rridx].get_located_loco();
+
+    RailroadGroups::railroad_groups[rrgidx].railroads[rridx].set_located_loco (0xFFFF);
+
+    if (located_loco_idx != 0xFFFF)
+    {
+        Locos::locos[located_loco_idx].set_rrlocation (0xFFFF);
+    }
+
+    Metrics::count (METRICS_COUNTER_S88_EDGES);
+    S88::set_state_bit (coidx, S88_STATE_FREE);
+    Topology::occupancy_changed ();
+    Automation::execute_contact_actions (coidx, false);
+    DEBUG_TRACE (DEBUG_SUBSYSTEM_S88, DEBUG_LEVEL_VERBOSE, "contact=%u gets free\n", (uint16_t) coidx);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  S88::schedule () - handle changed contacts, only words with changed bits are examined bit by bit
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
 S88::schedule (void)
 {
-    uint_fast16_t   coidx;
+    uint_fast16_t   widx;
+    uint_fast16_t   nwords;
 
     if (DCC::booster_is_on)
     {
-        coidx = 0;
+        nwords = (S88::n_contacts + 63) / 64;
 
-        for (coidx = 0; coidx < n_contacts; coidx++)
+        for (widx = 0; widx < nwords; widx++)
         {
-            if (! S88::get_state_bit (coidx))
+            uint64_t    changed = S88::current_bits[widx] ^ S88::new_bits[widx];
+
+            if (widx == nwords - 1 && S88::n_contacts % 64)
             {
-                if (S88::get_newstate_bit (coidx))                                  // contact gets occupied
-                {
-                    uint_fast16_t   rrgrridx;
-                    uint_fast8_t    rrgidx;
-                    uint_fast8_t    rridx;
-                    uint_fast16_t   active_loco_idx;
-
-                    S88::set_state_bit (coidx, S88_STATE_OCCUPIED);
-
-                    rrgrridx        = S88::contacts[coidx].get_link_railroad ();
-                    rrgidx          = rrgrridx >> 8;
-                    rridx           = rrgrridx & 0xFF;
-                    active_loco_idx = RailroadGroups::railroad_groups[rrgidx].railroads[rridx].get_active_loco ();
-
-                    RailroadGroups::railroad_groups[rrgidx].railroads[rridx].set_located_loco (active_loco_idx);
-                    RailroadGroups::railroad_groups[rrgidx].railroads[rridx].set_active_loco (0xFFFF);
-
-                    if (active_loco_idx != 0xFFFF)
-                    {
-                        Locos::locos[active_loco_idx].set_rrlocation (rrgrridx);
-                    }
-
-                    if (Millis::elapsed () - DCC::booster_is_on_time > 3000)
-                    {
-                        S88::contacts[coidx].execute_contact_actions (true);
-                        Debug::printf (DEBUG_LEVEL_NORMAL, "contact=%u gets occupied\r\n", (uint16_t) coidx);
-                    }
-                    else
-                    {
-                        uint_fast16_t   rrgrridx    = S88::contacts[coidx].get_link_railroad ();
-                        uint_fast8_t    rrgidx      = rrgrridx >> 8;
-                        uint_fast8_t    rridx       = rrgrridx & 0xFF;
-                        Railroad *      rr          = &RailroadGroups::railroad_groups[rrgidx].railroads[rridx];
-                        uint_fast16_t   loco_idx    = rr->get_link_loco ();
-
-                        if (loco_idx != 0xFFFF)
-                        {
-                            Locos::locos[loco_idx].set_rrlocation (rrgrridx);
-                            Debug::printf (DEBUG_LEVEL_NORMAL, "contact=%u: setting loco #%u\r\n", (uint16_t) coidx, (uint16_t) loco_idx);
-                        }
-                        else
-                        {
-                            Debug::printf (DEBUG_LEVEL_NORMAL, "contact=%u gets occupied... ignored\r\n", (uint16_t) coidx);
-                        }
-                    }
-                }
+                changed &= (1ULL << (S88::n_contacts % 64)) - 1;                    // ignore bits of unused contacts
             }
-            else if (! get_newstate_bit (coidx))                                    // contact gets free
-            {
-                uint_fast16_t   rrgrridx;
-                uint_fast8_t    rrgidx;
-                uint_fast8_t    rridx;
-                uint_fast16_t   located_loco_idx;
 
-                rrgrridx            = S88::contacts[coidx].get_link_railroad ();
-                rrgidx              = rrgrridx >> 8;
-                rridx               = rrgrridx & 0xFF;
-                located_loco_idx    = RailroadGroups::railroad_groups[rrgidx].railroads[rridx].get_located_loco();
+            while (changed)
+            {
+                uint_fast16_t   coidx = widx * 64 + __builtin_ctzll (changed);
 
-                RailroadGroups::railroad_groups[rrgidx].railroads[rridx].set_located_loco (0xFFFF);
+                changed &= changed - 1;
 
-                if (located_loco_idx != 0xFFFF)
+                if (S88::new_bits[widx] & (1ULL << (coidx % 64)))
                 {
-                    Locos::locos[located_loco_idx].set_rrlocation (0xFFFF);
+                    S88::contact_gets_occupied (coidx);
+                }
+                else
+                {
+                    S88::contact_gets_free (coidx);
                 }
-
-                S88::set_state_bit (coidx, S88_STATE_FREE);
-                S88::contacts[coidx].execute_contact_actions (false);
-                Debug::printf (DEBUG_LEVEL_VERBOSE, "contact=%u gets free\n", (uint16_t) coidx);
             }
         }
     }
@@ -1089,10 +521,7 @@ S88::schedule (void)
 bool
 S88::get_state_bit (uint_fast16_t coidx)
 {
-    uint_fast8_t    byte_idx    = coidx / 8;
-    uint_fast8_t    pin_idx     = coidx % 8;
-
-    if (S88::current_bits[byte_idx] & (1 << pin_idx))
+    if (S88::current_bits[coidx / 64] & (1ULL << (coidx % 64)))
     {
         return S88_STATE_OCCUPIED;
     }
@@ -1106,7 +535,7 @@ S88::get_state_bit (uint_fast16_t coidx)
 uint_fast8_t
 S88::get_state_byte (uint_fast16_t byteidx)
 {
-    return S88::current_bits[byteidx];
+    return (S88::current_bits[byteidx / 8] >> (8 * (byteidx % 8))) & 0xFF;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -1116,16 +545,20 @@ S88::get_state_byte (uint_fast16_t byteidx)
 void
 S88::set_state_bit (uint_fast16_t coidx, bool value)
 {
-    uint_fast8_t    byte_idx    = coidx / 8;
-    uint_fast8_t    pin_idx     = coidx % 8;
+    uint64_t    old_bits = S88::current_bits[coidx / 64];
 
     if (value)
     {
-        S88::current_bits[byte_idx] |= S88_STATE_OCCUPIED << pin_idx;
+        S88::current_bits[coidx / 64] |= 1ULL << (coidx % 64);
     }
     else
     {
-        S88::current_bits[byte_idx] &= ~(S88_STATE_OCCUPIED << pin_idx);
+        S88::current_bits[coidx / 64] &= ~(1ULL << (coidx % 64));
+    }
+
+    if (S88::current_bits[coidx / 64] != old_bits)
+    {
+        FM22::state_changed ();
     }
 }
 
@@ -1136,7 +569,15 @@ S88::set_state_bit (uint_fast16_t coidx, bool value)
 void
 S88::set_state_byte (uint_fast8_t byte_idx, uint_fast8_t value)
 {
-    S88::current_bits[byte_idx] = value;
+    uint_fast8_t    shift       = 8 * (byte_idx % 8);
+    uint64_t        old_bits    = S88::current_bits[byte_idx / 8];
+
+    S88::current_bits[byte_idx / 8] = (old_bits & ~(0xFFULL << shift)) | ((uint64_t) value << shift);
+
+    if (S88::current_bits[byte_idx / 8] != old_bits)
+    {
+        FM22::state_changed ();
+    }
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -1146,10 +587,7 @@ S88::set_state_byte (uint_fast8_t byte_idx, uint_fast8_t value)
 uint_fast8_t
 S88::get_newstate_bit (uint_fast16_t coidx)
 {
-    uint_fast8_t    byte_idx    = coidx / 8;
-    uint_fast8_t    pin_idx     = coidx % 8;
-
-    if (S88::new_bits[byte_idx] & (1 << pin_idx))
+    if (S88::new_bits[coidx / 64] & (1ULL << (coidx % 64)))
     {
         return S88_STATE_OCCUPIED;
     }
@@ -1163,7 +601,7 @@ S88::get_newstate_bit (uint_fast16_t coidx)
 uint_fast8_t
 S88::get_newstate_byte (uint_fast16_t byteidx)
 {
-    return S88::new_bits[byteidx];
+    return (S88::new_bits[byteidx / 8] >> (8 * (byteidx % 8))) & 0xFF;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -1173,16 +611,13 @@ S88::get_newstate_byte (uint_fast16_t byteidx)
 void
 S88::set_newstate_bit (uint_fast16_t coidx, bool value)
 {
-    uint_fast8_t    byte_idx    = coidx / 8;
-    uint_fast8_t    pin_idx     = coidx % 8;
-
     if (value)
     {
-        S88::new_bits[byte_idx] |= S88_STATE_OCCUPIED << pin_idx;
+        S88::new_bits[coidx / 64] |= 1ULL << (coidx % 64);
     }
     else
     {
-        S88::new_bits[byte_idx] &= ~(S88_STATE_OCCUPIED << pin_idx);
+        S88::new_bits[coidx / 64] &= ~(1ULL << (coidx % 64));
     }
 }
 
@@ -1193,175 +628,148 @@ S88::set_newstate_bit (uint_fast16_t coidx, bool value)
 void
 S88::set_newstate_byte (uint_fast16_t byte_idx, uint_fast8_t value)
 {
-    S88::new_bits[byte_idx] = value;
-}
+    uint_fast8_t    shift = 8 * (byte_idx % 8);
 
-/*------------------------------------------------------------------------------------------------------------------------
- *  S88::set_new_loco_ids ()
- *------------------------------------------------------------------------------------------------------------------------
- */
-void
-S88::set_new_loco_ids (uint16_t * map_new_loco_idx, uint16_t n_locos)
-{
-    uint_fast16_t     coidx;
-
-    for (coidx = 0; coidx < S88::n_contacts; coidx++)
-    {
-        S88::contacts[coidx].set_new_loco_ids_for_contact (true, map_new_loco_idx, n_locos);
-        S88::contacts[coidx].set_new_loco_ids_for_contact (false, map_new_loco_idx, n_locos);
-    }
+    S88::new_bits[byte_idx / 8] = (S88::new_bits[byte_idx / 8] & ~(0xFFULL << shift)) | ((uint64_t) value << shift);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  S88::set_new_addon_ids ()
+ *  S88::rebuild_rrg_index () - rebuild bitmasks of contacts linked to each railroad group
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-S88::set_new_addon_ids (uint16_t * map_new_addon_idx, uint16_t n_addons)
+S88::rebuild_rrg_index (void)
 {
-    uint_fast16_t     coidx;
-
-    for (coidx = 0; coidx < S88::n_contacts; coidx++)
-    {
-        S88::contacts[coidx].set_new_addon_ids_for_contact (true, map_new_addon_idx, n_addons);
-        S88::contacts[coidx].set_new_addon_ids_for_contact (false, map_new_addon_idx, n_addons);
-    }
-}
+    uint_fast16_t   coidx;
 
-/*------------------------------------------------------------------------------------------------------------------------
- *  S88::set_new_railroad_group_ids ()
- *------------------------------------------------------------------------------------------------------------------------
- */
-void
-S88::set_new_railroad_group_ids (uint8_t * map_new_rrgidx, uint8_t n_railroad_groups)
-{
-    uint_fast16_t     coidx;
+    memset (S88::rrg_contacts, 0, sizeof (S88::rrg_contacts));
 
     for (coidx = 0; coidx < S88::n_contacts; coidx++)
     {
-        if (S88::contacts[coidx].rrgidx < n_railroad_groups)
+        uint_fast8_t    rrgidx = S88::contacts[coidx].rrgidx;
+
+        if (rrgidx < MAX_RAILROAD_GROUPS)
         {
-            if (S88::contacts[coidx].rrgidx != map_new_rrgidx[S88::contacts[coidx].rrgidx])
-            {
-                S88::contacts[coidx].rrgidx = map_new_rrgidx[S88::contacts[coidx].rrgidx];
-                S88::data_changed = true;
-            }
+            S88::rrg_contacts[rrgidx][coidx / 64] |= 1ULL << (coidx % 64);
         }
-
-        S88::contacts[coidx].set_new_railroad_group_ids_for_contact (true, map_new_rrgidx, n_railroad_groups);
-        S88::contacts[coidx].set_new_railroad_group_ids_for_contact (false, map_new_rrgidx, n_railroad_groups);
     }
+
+    S88::links_changed = false;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  S88::set_new_railroad_ids ()
+ *  S88::get_free_railroads () - get all free railroads of group in order of their first free contact
+ *
+ *  rridx_list must hold MAX_RAILROADS_PER_RAILROAD_GROUP entries. Returns number of free railroads.
  *------------------------------------------------------------------------------------------------------------------------
  */
-void
-S88::set_new_railroad_ids (uint_fast8_t rrgidx, uint8_t * map_new_rridx, uint_fast8_t n_railroads)
+uint_fast8_t
+S88::get_free_railroads (uint_fast8_t rrgidx, uint8_t * rridx_list)
 {
-    uint_fast16_t     coidx;
+    uint_fast16_t   widx;
+    uint_fast16_t   nwords  = (S88::n_contacts + 63) / 64;
+    uint32_t        found   = 0;
+    uint_fast8_t    n_free  = 0;
 
-    for (coidx = 0; coidx < S88::n_contacts; coidx++)
+    if (S88::links_changed)
+    {
+        S88::rebuild_rrg_index ();
+    }
+
+    if (rrgidx < MAX_RAILROAD_GROUPS)
     {
-        if (S88::contacts[coidx].rrgidx == rrgidx)
+        for (widx = 0; widx < nwords; widx++)
         {
-            if (S88::contacts[coidx].rridx < n_railroads)
+            uint64_t    free_contacts = S88::rrg_contacts[rrgidx][widx] & ~S88::current_bits[widx];
+
+            while (free_contacts)
             {
-                if (S88::contacts[coidx].rridx != map_new_rridx[S88::contacts[coidx].rridx])
+                uint_fast8_t    rridx = S88::contacts[widx * 64 + __builtin_ctzll (free_contacts)].rridx;
+
+                if (rridx < MAX_RAILROADS_PER_RAILROAD_GROUP && ! (found & (1UL << rridx)))
                 {
-                    S88::contacts[coidx].rridx = map_new_rridx[S88::contacts[coidx].rridx];
-                    S88::data_changed = true;
+                    found |= 1UL << rridx;
+                    rridx_list[n_free++] = rridx;
                 }
+
+                free_contacts &= free_contacts - 1;
             }
         }
-
-        S88::contacts[coidx].set_new_railroad_ids_for_contact (true, rrgidx, map_new_rridx, n_railroads);
     }
+
+    return n_free;
 }
 
-void
-S88_Contact::set_new_switch_ids_for_contact (bool in, uint16_t * map_new_swidx, uint_fast8_t n_switches)
+/*------------------------------------------------------------------------------------------------------------------------
+ *  S88::has_railroad_contact () - check if a contact is linked to railroad
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+S88::has_railroad_contact (uint_fast8_t rrgidx, uint_fast8_t rridx)
 {
-    CONTACT_ACTION  *   cap;
-    uint_fast8_t        n_contact_actions;
-    uint_fast8_t        caidx;
+    uint_fast16_t   widx;
+    uint_fast16_t   nwords  = (S88::n_contacts + 63) / 64;
 
-    if (in)
-    {
-        n_contact_actions = this->n_contact_actions_in;
-        cap = this->contact_actions_in;
-    }
-    else
+    if (S88::links_changed)
     {
-        n_contact_actions = this->n_contact_actions_out;
-        cap = this->contact_actions_out;
+        S88::rebuild_rrg_index ();
     }
 
-    for (caidx = 0; caidx < n_contact_actions; caidx++)
+    if (rrgidx < MAX_RAILROAD_GROUPS)
     {
-        switch (cap[caidx].action)
+        for (widx = 0; widx < nwords; widx++)
         {
-            case S88_ACTION_SET_SWITCH:                                                     // parameters: SW_IDX, SW_STATE
-            {
-                uint_fast16_t   swidx   = cap[caidx].parameters[0];
+            uint64_t    contacts = S88::rrg_contacts[rrgidx][widx];
 
-                if (swidx < n_switches && swidx != map_new_swidx[swidx])
+            while (contacts)
+            {
+                if (S88::contacts[widx * 64 + __builtin_ctzll (contacts)].rridx == rridx)
                 {
-                    if (in)
-                    {
-                        this->contact_actions_in[caidx].parameters[0] = map_new_swidx[swidx];
-                    }
-                    else
-                    {
-                        this->contact_actions_out[caidx].parameters[0] = map_new_swidx[swidx];
-                    }
-
-                    S88::data_changed = true;
+                    return true;
                 }
 
-                break;
+                contacts &= contacts - 1;
             }
         }
     }
+
+    return false;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  S88::set_new_switch_ids ()
+ *  S88::is_railroad_occupied () - check if a contact linked to railroad is occupied
  *------------------------------------------------------------------------------------------------------------------------
  */
-void
-S88::set_new_switch_ids (uint16_t * map_new_switch_idx, uint16_t n_switches)
+bool
+S88::is_railroad_occupied (uint_fast8_t rrgidx, uint_fast8_t rridx)
 {
-    uint_fast16_t     coidx;
+    uint_fast16_t   widx;
+    uint_fast16_t   nwords  = (S88::n_contacts + 63) / 64;
 
-    for (coidx = 0; coidx < S88::n_contacts; coidx++)
+    if (S88::links_changed)
     {
-        S88::contacts[coidx].set_new_switch_ids_for_contact (false, map_new_switch_idx, n_switches);
-        S88::contacts[coidx].set_new_switch_ids_for_contact (true, map_new_switch_idx, n_switches);
+        S88::rebuild_rrg_index ();
     }
-}
 
-/*------------------------------------------------------------------------------------------------------------------------
- *  S88::get_free_railroad () - get free railroad
- *------------------------------------------------------------------------------------------------------------------------
- */
-uint_fast16_t
-S88::get_free_railroad (uint_fast8_t rrgidx)
-{
-    uint_fast16_t   coidx;
-    uint_fast8_t    rridx = 0xFF;
-
-    for (coidx = 0; coidx < S88::n_contacts; coidx++)
+    if (rrgidx < MAX_RAILROAD_GROUPS)
     {
-        if (S88::contacts[coidx].rrgidx == rrgidx && S88::get_state_bit (coidx) == S88_STATE_FREE)
+        for (widx = 0; widx < nwords; widx++)
         {
-            rridx   = S88::contacts[coidx].rridx;
-            break;
+            uint64_t    occupied_contacts = S88::rrg_contacts[rrgidx][widx] & S88::current_bits[widx];
+
+            while (occupied_contacts)
+            {
+                if (S88::contacts[widx * 64 + __builtin_ctzll (occupied_contacts)].rridx == rridx)
+                {
+                    return true;
+                }
+
+                occupied_contacts &= occupied_contacts - 1;
+            }
         }
     }
 
-    return rridx;
+    return false;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -1374,9 +782,13 @@ S88::add (const S88_Contact& contact)
     if (S88::n_contacts < S88_MAX_CONTACTS)
     {
         S88::contacts.push_back(contact);
+        S88::order.add ();
         S88::n_contacts++;
         S88::n_contacts_changed = true;
         S88::data_changed = true;
+        Topology::invalidate ();
+        Automation::invalidate ();
+        S88::links_changed = true;
         return S88::contacts.size() - 1;
     }
     return 0xFFFF;
@@ -1392,6 +804,22 @@ S88::get_n_contacts (void)
     return n_contacts;
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ *  S88::clear () - remove all contacts, see FileIO::reload_ini_files ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+S88::clear (void)
+{
+    S88::contacts.clear ();
+    S88::order.clear ();
+    S88::n_contacts = 0;
+    S88::n_contacts_changed = true;
+    S88::links_changed = true;
+    Topology::invalidate ();
+    Automation::invalidate ();
+}
+
 /*------------------------------------------------------------------------------------------------------------------------
  *  S88::get_n_contacts_changed () - get flag:  number of contacts changed
  *------------------------------------------------------------------------------------------------------------------------
@@ -1405,66 +833,55 @@ S88::get_n_contacts_changed (void)
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  set_new_id () - set new id
+ *  get_position () - get position of contact in display order
  *------------------------------------------------------------------------------------------------------------------------
  */
 uint_fast16_t
-S88::set_new_id (uint_fast16_t coidx, uint_fast16_t new_coidx)
+S88::get_position (uint_fast16_t coidx)
 {
-    uint_fast16_t   rtc = 0xFFFF;
-
-    if (coidx < S88::n_contacts && new_coidx < S88::n_contacts)
-    {
-        if (coidx != new_coidx)
-        {
-            S88_Contact     tmpcontact;
-            uint_fast16_t   cidx;
-
-            uint16_t *      map_new_coidx = (uint16_t *) calloc (S88::n_contacts, sizeof (uint16_t));
-
-            for (cidx = 0; cidx < S88::n_contacts; cidx++)
-            {
-                map_new_coidx[cidx] = cidx;
-            }
-
-            tmpcontact = S88::contacts[coidx];
-
-            if (new_coidx < coidx)
-            {
-                for (cidx = coidx; cidx > new_coidx; cidx--)
-                {
-                    S88::contacts[cidx] = S88::contacts[cidx - 1];
-                    map_new_coidx[cidx - 1] = cidx;
-                }
-            }
-            else // if (new_coidx > coidx)
-            {
-                for (cidx = coidx; cidx < new_coidx; cidx++)
-                {
-                    S88::contacts[cidx] = S88::contacts[cidx + 1];
-                    map_new_coidx[cidx + 1] = cidx;
-                }
-            }
+    return S88::order.get_position (coidx);
+}
 
-            S88::contacts[cidx] = tmpcontact;
-            map_new_coidx[coidx] = cidx;
+/*------------------------------------------------------------------------------------------------------------------------
+ *  get_contact_idx () - get contact at position in display order
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+S88::get_contact_idx (uint_fast16_t position)
+{
+    return S88::order.get_idx (position);
+}
 
-            for (cidx = 0; cidx < S88::n_contacts; cidx++)
-            {
-                Debug::printf (DEBUG_LEVEL_VERBOSE, "%2d -> %2d\n", cidx, map_new_coidx[cidx]);
-            }
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_position () - move contact to new position in display order. The contact keeps its index, so no references in
+ *  the S88 bit of the contact, railroads and the topology have to be corrected.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+S88::set_position (uint_fast16_t coidx, uint_fast16_t new_position)
+{
+    if (S88::order.get_position (coidx) == new_position)
+    {
+        return coidx;
+    }
 
-            free (map_new_coidx);
-            S88::data_changed = true;
-            rtc = new_coidx;
-        }
-        else
-        {
-            rtc = coidx;
-        }
+    if (S88::order.set_position (coidx, new_position))
+    {
+        S88::data_changed = true;
+        return coidx;
     }
 
-    return rtc;
+    return 0xFFFF;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_order () - set display order after reading ini file, positions[coidx] may contain gaps or duplicates
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+S88::set_order (std::vector<uint16_t>& new_positions)
+{
+    S88::order.set_order (new_positions);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
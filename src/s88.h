@@ -24,6 +24,8 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include "order.h"
+#include "railroad.h"
 
 #define S88_MAX_ACTION_PARAMETERS                   8
 #define S88_STATE_FREE                              false
@@ -31,6 +33,7 @@
 
 #define S88_MAX_CONTACTS                            1024                        // should be a multiple of 16
 #define S88_MAX_CONTACT_BYTES                       (S88_MAX_CONTACTS / sizeof (uint8_t))
+#define S88_MAX_CONTACT_WORDS                       ((S88_MAX_CONTACTS + 63) / 64)      // 64 contacts per word
 
 #define S88_MAX_NAME_SIZE                           32
 #define S88_MAX_ACTIONS_PER_CONTACT                 8
@@ -86,13 +89,6 @@ class S88_Contact
         uint_fast8_t                    set_contact_action (bool in, uint_fast8_t caidx, CONTACT_ACTION * cap);
         uint_fast8_t                    get_contact_action (bool in, uint_fast8_t caidx, CONTACT_ACTION * cap);
 
-        uint_fast16_t                   get_link_loco (bool in, uint_fast8_t caidx, uint_fast8_t paidx);
-        void                            execute_contact_actions (bool in);
-        void                            set_new_loco_ids_for_contact (bool in, uint16_t * map_new_loco_idx, uint16_t n_locos);
-        void                            set_new_addon_ids_for_contact (bool in, uint16_t * map_new_addon_idx, uint16_t n_addons);
-        void                            set_new_railroad_group_ids_for_contact (bool in, uint8_t * map_new_rrgidx, uint_fast8_t n_railroad_groups);
-        void                            set_new_railroad_ids_for_contact (bool in, uint_fast8_t current_rrgidx, uint8_t * map_new_rridx, uint_fast8_t n_railroads);
-        void                            set_new_switch_ids_for_contact (bool in, uint16_t * map_new_swidx, uint_fast8_t n_switches);
     private:
 };
 
@@ -100,18 +96,15 @@ class S88
 {
     public:
         static bool                     data_changed;
+        static bool                     links_changed;                              // flag: rrg index must be rebuilt
         static std::vector<S88_Contact> contacts;
-        static uint8_t                  current_bits[S88_MAX_CONTACT_BYTES];
+        static uint64_t                 current_bits[S88_MAX_CONTACT_WORDS];
 
         static uint_fast16_t            add (const S88_Contact& contact);
         static uint_fast16_t            get_n_contacts (void);
+        static void                     clear (void);
         static bool                     get_n_contacts_changed (void);
 
-        static void                     set_new_loco_ids (uint16_t * map_new_loco_idx, uint16_t n_locos);
-        static void                     set_new_addon_ids (uint16_t * map_new_addon_idx, uint16_t n_addons);
-        static void                     set_new_railroad_group_ids (uint8_t * map_new_rrgidx, uint8_t n_railroad_groups);
-        static void                     set_new_railroad_ids (uint_fast8_t rrgidx, uint8_t * map_new_rridx, uint_fast8_t n_railroads);
-        static void                     set_new_switch_ids (uint16_t * map_new_switch_idx, uint16_t n_switches);
 
         static bool                     get_state_bit (uint_fast16_t coidx);
         static void                     set_state_bit (uint_fast16_t coidx, bool value);
@@ -124,8 +117,13 @@ class S88
         static void                     set_newstate_byte (uint_fast16_t byte_idx, uint_fast8_t value);
 
         static uint_fast16_t            number_of_status_bytes (void);
-        static uint_fast16_t            get_free_railroad (uint_fast8_t rrgidx);
-        static uint_fast16_t            set_new_id (uint_fast16_t coidx, uint_fast16_t new_coidx);
+        static uint_fast8_t             get_free_railroads (uint_fast8_t rrgidx, uint8_t * rridx_list);
+        static bool                     has_railroad_contact (uint_fast8_t rrgidx, uint_fast8_t rridx);
+        static bool                     is_railroad_occupied (uint_fast8_t rrgidx, uint_fast8_t rridx);
+        static uint_fast16_t            get_position (uint_fast16_t coidx);
+        static uint_fast16_t            get_contact_idx (uint_fast16_t position);
+        static uint_fast16_t            set_position (uint_fast16_t coidx, uint_fast16_t new_position);
+        static void                     set_order (std::vector<uint16_t>& new_positions);
         static uint_fast8_t             booster_on (void);
         static uint_fast8_t             booster_off (void);
         static void                     schedule (void);
@@ -133,8 +131,13 @@ class S88
         static void                     init (void);
     private:
         static uint_fast16_t            n_contacts;                                 // number of contacts
+        static DisplayOrder             order;                                      // display order, see set_position ()
         static bool                     n_contacts_changed;
-        static uint8_t                  new_bits[S88_MAX_CONTACT_BYTES];
+        static uint64_t                 new_bits[S88_MAX_CONTACT_WORDS];
+        static uint64_t                 rrg_contacts[MAX_RAILROAD_GROUPS][S88_MAX_CONTACT_WORDS];  // contacts linked to rrg
+        static void                     rebuild_rrg_index (void);
+        static void                     contact_gets_occupied (uint_fast16_t coidx);
+        static void                     contact_gets_free (uint_fast16_t coidx);
 };
 
 #endif
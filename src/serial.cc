@@ -28,6 +28,8 @@
 #include <sys/ioctl.h>
 
 #include "debug.h"
+#include "metrics.h"
+#include "recorder.h"
 #include "serial.h"
 
 #if 0
@@ -51,13 +53,24 @@ Serial::poll (uint_fast8_t * chp)
 {
     uint_fast8_t rtc = 0;
 
-    if (fd >= 0)
+    if (Recorder::replaying)                                                                // simulated STM32
+    {
+        rtc = Recorder::replay_rx (chp);
+    }
+    else if (fd >= 0)
     {
         uint8_t buf[1];
 
         if (read (fd, buf, 1) == 1)
         {
             *chp = buf[0];
+            Metrics::count (METRICS_COUNTER_UART_RX_BYTES);
+
+            if (Recorder::recording)
+            {
+                Recorder::serial_rx (buf[0]);
+            }
+
             rtc = 1;
         }
     }
@@ -74,12 +87,27 @@ Serial::send (uint_fast8_t ch)
 {
     int     rtc;
 
-    if (fd >= 0)
+    if (Recorder::replaying)                                                                // simulated STM32
+    {
+        Recorder::replay_tx (ch);
+        rtc = 1;
+    }
+    else if (fd >= 0)
     {
         uint8_t buf[1];
 
         buf[0] = ch;
         rtc = write (fd, buf, 1);
+
+        if (rtc == 1)
+        {
+            Metrics::count (METRICS_COUNTER_UART_TX_BYTES);
+
+            if (Recorder::recording)
+            {
+                Recorder::serial_tx (ch);
+            }
+        }
     }
     else
     {
@@ -149,6 +177,11 @@ Serial::init (void)
 {
     char    junk;
 
+    if (Recorder::replaying)                                                                // no device needed, see Recorder::replay_rx()
+    {
+        return 1;
+    }
+
     fd = open(DEVICE, O_RDWR);
 
     if (fd < 0)
@@ -23,12 +23,14 @@
 #include "dcc.h"
 #include "debug.h"
 #include "sig.h"
+#include "automation.h"
 
 #define SIG_SCHEDULE_DELAY      220                                         // schedule time for signals in msec
 
 std::vector<Signal>             Signals::signals;                         // signals
 uint_fast16_t                   Signals::n_signals  = 0;                  // number of signals
 bool                            Signals::data_changed = false;
+DisplayOrder                    Signals::order;                           // display order
 
 SIG_EVENTS                      Signals::events[SIG_EVENT_LEN];             // event ringbuffer
 uint_fast16_t                   Signals::event_size      = 0;              // current event size
@@ -127,6 +129,16 @@ Signal::get_state ()
     return this->current_state;
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ *  Signal::restore_state () - restore state without switching, see Journal::init ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Signal::restore_state (uint_fast8_t f)
+{
+    this->current_state = f;
+}
+
 /*------------------------------------------------------------------------------------------------------------------------
  * Signals::add_event() - add event
  *------------------------------------------------------------------------------------------------------------------------
@@ -199,7 +211,9 @@ Signals::add (const Signal& new_sig)
     {
         signals.push_back(new_sig);
         Signals::signals[n_signals].set_id(n_signals);
+        Signals::order.add ();
         Signals::n_signals++;
+        Automation::invalidate ();
         return signals.size() - 1;
     }
     return 0xFFFF;
@@ -224,7 +238,11 @@ Signals::remove (uint_fast16_t sigidx)
             Signals::signals[idx] = Signals::signals[idx + 1];
         }
 
+        Signals::order.remove (sigidx);
+        Signals::renumber ();
+
         Signals::data_changed = true;
+        Automation::invalidate ();
         rtc = true;
     }
 
@@ -232,68 +250,55 @@ Signals::remove (uint_fast16_t sigidx)
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  set_new_id () - set new id
+ *  get_position () - get position of signal in display order
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Signals::get_position (uint_fast16_t sigidx)
+{
+    return Signals::order.get_position (sigidx);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  get_signal_idx () - get signal at position in display order
  *------------------------------------------------------------------------------------------------------------------------
  */
 uint_fast16_t
-Signals::set_new_id (uint_fast16_t sigidx, uint_fast16_t new_sigidx)
+Signals::get_signal_idx (uint_fast16_t position)
 {
-    uint_fast16_t   rtc = 0xFFFF;
+    return Signals::order.get_idx (position);
+}
 
-    if (sigidx < Signals::n_signals && new_sigidx < Signals::n_signals)
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_position () - move signal to new position in display order. The signal keeps its index, so no references in
+ *  contacts, tracks and events have to be corrected.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Signals::set_position (uint_fast16_t sigidx, uint_fast16_t new_position)
+{
+    if (Signals::order.get_position (sigidx) == new_position)
     {
-        if (sigidx != new_sigidx)
-        {
-            Signal          tmpsig;
-            uint_fast16_t   sidx;
-
-            uint16_t *      map_new_sig_idx = (uint16_t *) calloc (Signals::n_signals, sizeof (uint16_t));
-
-            for (sidx = 0; sidx < Signals::n_signals; sidx++)
-            {
-                map_new_sig_idx[sidx] = sidx;
-            }
-
-            tmpsig = Signals::signals[sigidx];
-
-            if (new_sigidx < sigidx)
-            {
-                for (sidx = sigidx; sidx > new_sigidx; sidx--)
-                {
-                    Signals::signals[sidx] = Signals::signals[sidx - 1];
-                    map_new_sig_idx[sidx - 1] = sidx;
-                }
-            }
-            else // if (new_sigidx > sigidx)
-            {
-                for (sidx = sigidx; sidx < new_sigidx; sidx++)
-                {
-                    Signals::signals[sidx] = Signals::signals[sidx + 1];
-                    map_new_sig_idx[sidx + 1] = sidx;
-                }
-            }
-
-            Signals::signals[sidx] = tmpsig;
-            map_new_sig_idx[sigidx] = sidx;
-
-            for (sidx = 0; sidx < Signals::n_signals; sidx++)
-            {
-                Debug::printf (DEBUG_LEVEL_VERBOSE, "%2d -> %2d\n", sidx, map_new_sig_idx[sidx]);
-            }
-
-            free (map_new_sig_idx);
-            Signals::data_changed = true;
-            rtc = new_sigidx;
-
-            Signals::renumber ();
-        }
-        else
-        {
-            rtc = sigidx;
-        }
+        return sigidx;
     }
 
-    return rtc;
+    if (Signals::order.set_position (sigidx, new_position))
+    {
+        Signals::data_changed = true;
+        return sigidx;
+    }
+
+    return 0xFFFF;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_order () - set display order after reading ini file, positions[sigidx] may contain gaps or duplicates
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Signals::set_order (std::vector<uint16_t>& new_positions)
+{
+    Signals::order.set_order (new_positions);
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -306,6 +311,65 @@ Signals::get_n_signals (void)
     return Signals::n_signals;
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ *  Signals::clear () - remove all signals, see FileIO::reload_ini_files ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Signals::clear (void)
+{
+    Signals::signals.clear ();
+    Signals::order.clear ();
+    Signals::n_signals = 0;
+    Automation::invalidate ();
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  Signals::set_new_event_ids () - correct indexes of queued events, drop events of removed signals
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Signals::set_new_event_ids (uint16_t * map_new_signal_idx, uint_fast16_t n_signals)
+{
+    SIG_EVENTS      tmp_events[SIG_EVENT_LEN];
+    uint_fast16_t   n_events = 0;
+    uint_fast16_t   eidx     = event_start;
+    uint_fast16_t   idx;
+
+    for (idx = 0; idx < event_size; idx++)
+    {
+        uint_fast16_t   old_idx = Signals::events[eidx].sig_idx;
+
+        if (old_idx < n_signals && map_new_signal_idx[old_idx] != 0xFFFF)
+        {
+            tmp_events[n_events]         = Signals::events[eidx];
+            tmp_events[n_events].sig_idx = map_new_signal_idx[old_idx];
+            n_events++;
+        }
+
+        eidx++;
+
+        if (eidx == SIG_EVENT_LEN)
+        {
+            eidx = 0;
+        }
+    }
+
+    for (idx = 0; idx < n_events; idx++)
+    {
+        Signals::events[idx] = tmp_events[idx];
+    }
+
+    event_start = 0;
+    event_stop  = n_events;
+    event_size  = n_events;
+
+    if (event_stop == SIG_EVENT_LEN)
+    {
+        event_stop = 0;
+    }
+}
+
 /*------------------------------------------------------------------------------------------------------------------------
  *  renumber () - renumber ids
  *------------------------------------------------------------------------------------------------------------------------
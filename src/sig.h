@@ -24,6 +24,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include "order.h"
 
 #define MAX_SIGNALS             1024
 
@@ -51,6 +52,7 @@ class Signal
 
         void                            set_state (uint_fast8_t f);
         uint_fast8_t                    get_state ();
+        void                            restore_state (uint_fast8_t f);
     private:
         uint16_t                        id;
         std::string                     name;
@@ -66,13 +68,19 @@ class Signals
         static uint_fast16_t            add (const Signal& new_sig);
         static bool                     remove (uint_fast16_t swidx);
         static uint_fast16_t            get_n_signals (void);
-        static uint_fast16_t            set_new_id (uint_fast16_t swidx, uint_fast16_t new_swidx);
+        static void                     clear (void);
+        static uint_fast16_t            get_position (uint_fast16_t sigidx);
+        static uint_fast16_t            get_signal_idx (uint_fast16_t position);
+        static uint_fast16_t            set_position (uint_fast16_t sigidx, uint_fast16_t new_position);
+        static void                     set_order (std::vector<uint16_t>& new_positions);
         static uint_fast16_t            schedule (void);
         static void                     add_event (uint16_t sig_idx, uint_fast8_t mask);
+        static void                     set_new_event_ids (uint16_t * map_new_signal_idx, uint_fast16_t n_signals);
         static uint_fast8_t             booster_on (void);
         static uint_fast8_t             booster_off (void);
     private:
         static uint_fast16_t            n_signals;                                  // number of signals
+        static DisplayOrder             order;                                      // display order, see set_position ()
         static void                     renumber();
         static SIG_EVENTS               events[SIG_EVENT_LEN];                      // event ringbuffer
         static uint_fast16_t            event_size;                                 // current event size
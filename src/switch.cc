@@ -21,23 +21,27 @@
 #include <stdlib.h>
 #include <string.h>
 #include "dcc.h"
+#include "millis.h"
+#include "fm22.h"
 #include "debug.h"
 #include "railroad.h"
 #include "loco.h"
 #include "s88.h"
 #include "rcl.h"
 #include "switch.h"
+#include "automation.h"
 
-#define SWITCH_SCHEDULE_DELAY   220                                         // schedule time for switches in msec
+#define SWITCH_SCHEDULE_DELAY   20                                          // schedule time for switches in msec if idle
 
 std::vector<Switch>             Switches::switches;                         // switches
 uint_fast16_t                   Switches::n_switches  = 0;                  // number of switches
 bool                            Switches::data_changed = false;
+DisplayOrder                    Switches::order;                            // display order
 
-SWITCH_EVENTS                   Switches::events[SWITCH_EVENT_LEN];         // event ringbuffer
-uint_fast16_t                   Switches::event_size      = 0;              // current event size
-uint_fast16_t                   Switches::event_start     = 0;              // current event start index
-uint_fast16_t                   Switches::event_stop      = 0;              // current event stop index
+std::deque<SWITCH_JOB>          Switches::waiting;                          // switch jobs waiting for power
+std::vector<SWITCH_JOB>         Switches::powered;                          // switch machines currently powered
+uint_fast8_t                    Switches::power_used    = 0;                // sum of power of powered switch machines
+uint32_t                        Switches::busy_millis   = 0;                // start of current switching sequence
 
 /*------------------------------------------------------------------------------------------------------------------------
  * Switch () - constructor
@@ -49,6 +53,7 @@ Switch::Switch ()
     this->addr                  = 0;
     this->current_state         = DCC_SWITCH_STATE_UNDEFINED;
     this->flags                 = 0;
+    this->pulse                 = 0;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -118,8 +123,7 @@ Switch::set_state (uint_fast8_t f)
             (f == DCC_SWITCH_STATE_BRANCH2 && (this->flags & SWITCH_FLAG_3WAY)) ||
             f == DCC_SWITCH_STATE_STRAIGHT)
         {
-            Switches::add_event (this->id, f | SWITCH_ACTIVE_MASK);
-            Switches::add_event (this->id, f);
+            Switches::add_job (this->id, f);
         }
     }
 }
@@ -134,6 +138,16 @@ Switch::get_state ()
     return this->current_state;
 }
 
+/*------------------------------------------------------------------------------------------------------------------------
+ *  Switch::restore_state () - restore state without switching, see Journal::init ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Switch::restore_state (uint_fast8_t f)
+{
+    this->current_state = f;
+}
+
 /*------------------------------------------------------------------------------------------------------------------------
  *  Switch::set_flags () - set state
  *------------------------------------------------------------------------------------------------------------------------
@@ -156,30 +170,105 @@ Switch::get_flags ()
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- * Switches::add_event() - add event
+ *  Switch::set_pulse () - set time in msec the switch machine is powered, 0: default of DCC controller
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Switch::set_pulse (uint_fast16_t pulse)
+{
+    this->pulse = pulse;
+    Switches::data_changed = true;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  Switch::get_pulse ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Switch::get_pulse ()
+{
+    return this->pulse;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * Switches::add_job() - add switch job, a job still waiting for the same switch is updated instead
  *------------------------------------------------------------------------------------------------------------------------
  */
 void
-Switches::add_event (uint16_t switch_idx, uint_fast8_t mask)
+Switches::add_job (uint16_t switch_idx, uint_fast8_t state)
 {
-    if (event_size < SWITCH_EVENT_LEN)                                      // buffer full?
+    SWITCH_JOB      job;
+    uint_fast16_t   idx;
+
+    for (idx = 0; idx < Switches::waiting.size (); idx++)
+    {
+        if (Switches::waiting[idx].switch_idx == switch_idx)
+        {
+            Switches::waiting[idx].state = state;
+            return;
+        }
+    }
+
+    if (Switches::waiting.size () == 0 && Switches::powered.size () == 0)
     {
-        Switches::events[event_stop].switch_idx   = switch_idx;
-        Switches::events[event_stop].mask         = mask;
+        Switches::busy_millis = Millis::elapsed ();
+    }
 
-        event_stop++;
+    job.switch_idx  = switch_idx;
+    job.state       = state;
+    job.power       = (Switches::switches[switch_idx].get_flags () & SWITCH_FLAG_3WAY) ? 2 : 1;  // a 3-way switch powers on 2 switches
+    job.stop_millis = 0;
 
-        if (event_stop >= SWITCH_EVENT_LEN)                                 // at end of ringbuffer?
-        {                                                                   // yes
-            event_stop = 0;                                                 // reset to beginning
+    Switches::waiting.push_back (job);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * Switches::is_busy() - check if switch is waiting or powered
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+bool
+Switches::is_busy (uint_fast16_t swidx)
+{
+    uint_fast16_t   idx;
+
+    for (idx = 0; idx < Switches::powered.size (); idx++)
+    {
+        if (Switches::powered[idx].switch_idx == swidx)
+        {
+            return true;
         }
+    }
 
-        event_size++;                                                       // increment used size
+    for (idx = 0; idx < Switches::waiting.size (); idx++)
+    {
+        if (Switches::waiting[idx].switch_idx == swidx)
+        {
+            return true;
+        }
     }
+
+    return false;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * Switches::get_n_busy() - get number of switches waiting or powered
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Switches::get_n_busy (void)
+{
+    return Switches::waiting.size () + Switches::powered.size ();
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- * Switches::schedule () - schedule events
+ * Switches::schedule () - schedule switch jobs
+ *
+ * Switch machines are powered in the order of their jobs as long as the sum of their power fits into
+ * FM22::switch_power. A 3-way switch needs a power of 2 and keeps its power 1.5 times its pulse. A job which
+ * needs more power than available at all is started if no other switch is powered.
+ *
+ * The DCC controller switches off each switch after its pulse on its own, up to 16 switches at the same time.
+ * Without pulse it uses 200 msec and the power is kept SWITCH_PULSE_DEFAULT like before.
  *
  * Return value:
  *  time in msec when next call should be done
@@ -188,39 +277,94 @@ Switches::add_event (uint16_t switch_idx, uint_fast8_t mask)
 uint_fast16_t
 Switches::schedule (void)
 {
-    uint_fast16_t   rtc = SWITCH_SCHEDULE_DELAY;
+    uint32_t        current_millis  = Millis::elapsed ();
+    uint_fast8_t    max_power       = FM22::get_switch_power ();
+    uint_fast16_t   rtc             = SWITCH_SCHEDULE_DELAY;
+    uint_fast16_t   idx;
+
+    idx = 0;
 
-    if (event_size != 0)
+    while (idx < Switches::powered.size ())                                 // end of pulse reached?
     {
-        uint_fast8_t    active  = Switches::events[event_start].mask & SWITCH_ACTIVE_MASK;
-        uint_fast8_t    f       = Switches::events[event_start].mask & DCC_SWITCH_STATE_MASK;
-        uint16_t        swidx   = Switches::events[event_start].switch_idx;
-        uint_fast16_t   addr    = Switches::switches[swidx].get_addr();
-        uint_fast16_t   flags   = Switches::switches[swidx].get_flags();
+        if ((int32_t) (current_millis - Switches::powered[idx].stop_millis) >= 0)
+        {
+            Switches::power_used -= Switches::powered[idx].power;
+            Switches::powered[idx] = Switches::powered.back ();
+            Switches::powered.pop_back ();
+
+            if (Switches::powered.size () == 0 && Switches::waiting.size () == 0)
+            {
+                Debug::printf (DEBUG_LEVEL_VERBOSE, "Switches::schedule: all switches set in %u msec\r\n", (unsigned int) (current_millis - Switches::busy_millis));
+                FM22::state_changed ();
+            }
+        }
+        else
+        {
+            idx++;
+        }
+    }
 
-        Debug::printf (DEBUG_LEVEL_VERBOSE, "Switches::schedule: active=%u f=%u swidx=%u addr=%u\r\n", active, f, swidx, addr);
+    while (Switches::waiting.size () > 0)
+    {
+        SWITCH_JOB *    jp      = &Switches::waiting.front ();
+        uint16_t        swidx   = jp->switch_idx;
+        uint_fast16_t   addr;
+        uint_fast16_t   pulse;
 
-        if (active)         // activate switch
+        if (swidx >= Switches::n_switches)                                  // switch has been removed
         {
-            DCC::base_switch_set (addr, f);
+            Switches::waiting.pop_front ();
+            continue;
         }
-        else                // deactivate switch
+
+        addr    = Switches::switches[swidx].get_addr();
+        pulse   = Switches::switches[swidx].get_pulse();
+
+        if (Switches::power_used > 0 && Switches::power_used + jp->power > max_power)
         {
-            // DCC::base_switch_reset (addr, f);                            // not necessary anymore, see DCC controller software
+            break;
+        }
 
-            if (flags & SWITCH_FLAG_3WAY)                                   // a 3-way switch powers on 2 switches
+        for (idx = 0; idx < Switches::powered.size (); idx++)
+        {
+            if (Switches::powered[idx].switch_idx == swidx)                 // switch machine still powered, wait
             {
-                rtc = 2 * SWITCH_SCHEDULE_DELAY;
+                break;
             }
         }
 
-        event_start++;
+        if (idx < Switches::powered.size ())
+        {
+            break;
+        }
+
+        if (pulse == 0)
+        {
+            pulse = SWITCH_PULSE_DEFAULT;
+        }
+
+        if (jp->power > 1)
+        {
+            pulse += pulse / 2;
+        }
+
+        Debug::printf (DEBUG_LEVEL_VERBOSE, "Switches::schedule: f=%u swidx=%u addr=%u pulse=%u\r\n", jp->state, swidx, addr, pulse);
+        DCC::base_switch_set (addr, jp->state, Switches::switches[swidx].get_pulse());
 
-        if (event_start == SWITCH_EVENT_LEN)                                // at end of ringbuffer?
-        {                                                                   // yes
-            event_start = 0;                                                // reset to beginning
+        jp->stop_millis = current_millis + pulse;
+        Switches::power_used += jp->power;
+        Switches::powered.push_back (*jp);
+        Switches::waiting.pop_front ();
+    }
+
+    for (idx = 0; idx < Switches::powered.size (); idx++)                   // next call at next end of pulse
+    {
+        int32_t     diff = Switches::powered[idx].stop_millis - current_millis;
+
+        if (diff < (int32_t) rtc)
+        {
+            rtc = diff > 0 ? diff : 1;
         }
-        event_size--;
     }
 
     return rtc;
@@ -237,7 +381,9 @@ Switches::add (const Switch& new_switch)
     {
         switches.push_back(new_switch);
         Switches::switches[n_switches].set_id(n_switches);
+        Switches::order.add ();
         Switches::n_switches++;
+        Automation::invalidate ();
         return switches.size() - 1;
     }
     return 0xFFFF;
@@ -262,7 +408,11 @@ Switches::remove (uint_fast16_t swidx)
             Switches::switches[idx] = Switches::switches[idx + 1];
         }
 
+        Switches::order.remove (swidx);
+        Switches::renumber ();
+
         Switches::data_changed = true;
+        Automation::invalidate ();
         rtc = true;
     }
 
@@ -270,82 +420,116 @@ Switches::remove (uint_fast16_t swidx)
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
- *  set_new_id () - set new id
+ *  get_position () - get position of switch in display order
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Switches::get_position (uint_fast16_t swidx)
+{
+    return Switches::order.get_position (swidx);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ *  get_switch_idx () - get switch at position in display order
  *------------------------------------------------------------------------------------------------------------------------
  */
 uint_fast16_t
-Switches::set_new_id (uint_fast16_t swidx, uint_fast16_t new_swidx)
+Switches::get_switch_idx (uint_fast16_t position)
 {
-    uint_fast16_t   rtc = 0xFFFF;
+    return Switches::order.get_idx (position);
+}
 
-    if (swidx < Switches::n_switches && new_swidx < Switches::n_switches)
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_position () - move switch to new position in display order. The switch keeps its index, so no references in
+ *  railroads, contacts, tracks, events and switch jobs have to be corrected.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Switches::set_position (uint_fast16_t swidx, uint_fast16_t new_position)
+{
+    if (Switches::order.get_position (swidx) == new_position)
     {
-        if (swidx != new_swidx)
-        {
-            Switch          tmpswitch;
-            uint_fast16_t   sidx;
+        return swidx;
+    }
 
-            uint16_t *      map_new_switch_idx = (uint16_t *) calloc (Switches::n_switches, sizeof (uint16_t));
+    if (Switches::order.set_position (swidx, new_position))
+    {
+        Switches::data_changed = true;
+        return swidx;
+    }
 
-            for (sidx = 0; sidx < Switches::n_switches; sidx++)
-            {
-                map_new_switch_idx[sidx] = sidx;
-            }
+    return 0xFFFF;
+}
 
-            tmpswitch = Switches::switches[swidx];
+/*------------------------------------------------------------------------------------------------------------------------
+ *  set_order () - set display order after reading ini file, positions[swidx] may contain gaps or duplicates
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Switches::set_order (std::vector<uint16_t>& new_positions)
+{
+    Switches::order.set_order (new_positions);
+}
 
-            if (new_swidx < swidx)
-            {
-                for (sidx = swidx; sidx > new_swidx; sidx--)
-                {
-                    Switches::switches[sidx] = Switches::switches[sidx - 1];
-                    map_new_switch_idx[sidx - 1] = sidx;
-                }
-            }
-            else // if (new_swidx > swidx)
-            {
-                for (sidx = swidx; sidx < new_swidx; sidx++)
-                {
-                    Switches::switches[sidx] = Switches::switches[sidx + 1];
-                    map_new_switch_idx[sidx + 1] = sidx;
-                }
-            }
+/*------------------------------------------------------------------------------------------------------------------------
+ *  Switches::get_n_switches () - get number of switches
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Switches::get_n_switches (void)
+{
+    return Switches::n_switches;
+}
 
-            Switches::switches[sidx] = tmpswitch;
-            map_new_switch_idx[swidx] = sidx;
+/*------------------------------------------------------------------------------------------------------------------------
+ *  Switches::clear () - remove all switches, see FileIO::reload_ini_files ()
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Switches::clear (void)
+{
+    Switches::switches.clear ();
+    Switches::order.clear ();
+    Switches::n_switches = 0;
+    Automation::invalidate ();
+}
 
-            for (sidx = 0; sidx < Switches::n_switches; sidx++)
-            {
-                Debug::printf (DEBUG_LEVEL_VERBOSE, "%2d -> %2d\n", sidx, map_new_switch_idx[sidx]);
-            }
+/*------------------------------------------------------------------------------------------------------------------------
+ *  Switches::set_new_event_ids () - correct indexes of switch jobs, drop waiting jobs of removed switches
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Switches::set_new_event_ids (uint16_t * map_new_switch_idx, uint_fast16_t n_switches)
+{
+    std::deque<SWITCH_JOB>  new_waiting;
+    uint_fast16_t           idx;
 
-            RailroadGroups::set_new_switch_ids (map_new_switch_idx, Switches::n_switches);
-            RCL::set_new_switch_ids (map_new_switch_idx, Switches::n_switches);
-            S88::set_new_switch_ids (map_new_switch_idx, Switches::n_switches);
+    for (idx = 0; idx < Switches::waiting.size (); idx++)
+    {
+        uint_fast16_t   old_idx = Switches::waiting[idx].switch_idx;
+
+        if (old_idx < n_switches && map_new_switch_idx[old_idx] != 0xFFFF)
+        {
+            new_waiting.push_back (Switches::waiting[idx]);
+            new_waiting.back ().switch_idx = map_new_switch_idx[old_idx];
+        }
+    }
 
-            free (map_new_switch_idx);
-            Switches::data_changed = true;
-            rtc = new_swidx;
+    Switches::waiting.swap (new_waiting);
 
-            Switches::renumber ();
+    for (idx = 0; idx < Switches::powered.size (); idx++)                  // keep power of removed switches until end of pulse
+    {
+        uint_fast16_t   old_idx = Switches::powered[idx].switch_idx;
+
+        if (old_idx < n_switches && map_new_switch_idx[old_idx] != 0xFFFF)
+        {
+            Switches::powered[idx].switch_idx = map_new_switch_idx[old_idx];
         }
         else
         {
-            rtc = swidx;
+            Switches::powered[idx].switch_idx = 0xFFFF;
         }
     }
-
-    return rtc;
-}
-
-/*------------------------------------------------------------------------------------------------------------------------
- *  Switches::get_n_switches () - get number of switches
- *------------------------------------------------------------------------------------------------------------------------
- */
-uint_fast16_t
-Switches::get_n_switches (void)
-{
-    return Switches::n_switches;
 }
 
 /*------------------------------------------------------------------------------------------------------------------------
@@ -23,20 +23,23 @@
 #include <stdint.h>
 #include <string>
 #include <vector>
+#include <deque>
 #include <memory>
+#include "order.h"
 
 #define MAX_SWITCHES            1024
 
-#define SWITCH_ACTIVE_MASK      0x80                                        // flag: activate switch per DCC
 #define SWITCH_FLAG_3WAY        0x01
 
-#define SWITCH_EVENT_LEN        64
+#define SWITCH_PULSE_DEFAULT    440                                         // msec of power budget if no pulse set, DCC controller switches off after 200 msec
 
 typedef struct
 {
-    uint_fast16_t               switch_idx;                                 // index of switch machine
-    uint_fast8_t                mask;
-} SWITCH_EVENTS;
+    uint16_t                    switch_idx;                                 // index of switch machine
+    uint8_t                     state;                                      // DCC_SWITCH_STATE_xxx
+    uint8_t                     power;                                      // 1 or 2 (3-way switch)
+    uint32_t                    stop_millis;                                // end of pulse, only valid if powered
+} SWITCH_JOB;
 
 class Switch
 {
@@ -52,14 +55,18 @@ class Switch
 
         void                            set_state (uint_fast8_t f);
         uint_fast8_t                    get_state ();
+        void                            restore_state (uint_fast8_t f);
         void                            set_flags (uint_fast8_t f);
         uint_fast8_t                    get_flags ();
+        void                            set_pulse (uint_fast16_t pulse);
+        uint_fast16_t                   get_pulse ();
     private:
         uint16_t                        id;
         std::string                     name;
         uint16_t                        addr;
         uint8_t                         current_state;
         uint8_t                         flags;
+        uint16_t                        pulse;                                      // msec, 0: SWITCH_PULSE_DEFAULT
 };
 
 class Switches
@@ -70,18 +77,26 @@ class Switches
         static uint_fast16_t            add (const Switch& new_switch);
         static bool                     remove (uint_fast16_t swidx);
         static uint_fast16_t            get_n_switches (void);
-        static uint_fast16_t            set_new_id (uint_fast16_t swidx, uint_fast16_t new_swidx);
+        static void                     clear (void);
+        static uint_fast16_t            get_position (uint_fast16_t swidx);
+        static uint_fast16_t            get_switch_idx (uint_fast16_t position);
+        static uint_fast16_t            set_position (uint_fast16_t swidx, uint_fast16_t new_position);
+        static void                     set_order (std::vector<uint16_t>& new_positions);
         static uint_fast16_t            schedule (void);
-        static void                     add_event (uint16_t switch_idx, uint_fast8_t mask);
+        static void                     add_job (uint16_t switch_idx, uint_fast8_t state);
+        static bool                     is_busy (uint_fast16_t swidx);
+        static uint_fast16_t            get_n_busy (void);
+        static void                     set_new_event_ids (uint16_t * map_new_switch_idx, uint_fast16_t n_switches);
         static uint_fast8_t             booster_on (void);
         static uint_fast8_t             booster_off (void);
     private:
         static uint_fast16_t            n_switches;                                 // number of switches
+        static DisplayOrder             order;                                      // display order, see set_position ()
         static void                     renumber();
-        static SWITCH_EVENTS            events[SWITCH_EVENT_LEN];                   // event ringbuffer
-        static uint_fast16_t            event_size;                                 // current event size
-        static uint_fast16_t            event_start;                                // current event start index
-        static uint_fast16_t            event_stop;                                 // current event stop index
+        static std::deque<SWITCH_JOB>   waiting;                                    // switch jobs waiting for power
+        static std::vector<SWITCH_JOB>  powered;                                    // switch machines currently powered
+        static uint_fast8_t             power_used;                                 // sum of power of powered switch machines
+        static uint32_t                 busy_millis;                                // start of current switching sequence
 };
 
 #endif
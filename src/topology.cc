@@ -0,0 +1,420 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * topology.cc - layout graph and path-finding
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <algorithm>
+#include <queue>
+
+#include "topology.h"
+#include "railroad.h"
+#include "loco.h"
+#include "s88.h"
+#include "debug.h"
+
+bool                        Topology::valid = false;                                // flag: graph is up to date
+uint32_t                    Topology::generation = 1;                               // incremented on each change of occupancy
+uint32_t                    Topology::cost_generation;                              // occupancy generation of cost
+std::vector<uint8_t>        Topology::cost;                                         // cost of entering railroad
+std::vector<uint16_t>       Topology::rr_base;                                      // rrgidx -> index of first railroad
+std::vector<uint8_t>        Topology::rr_group;                                     // railroad index -> rrgidx
+std::vector<uint32_t>       Topology::succ_start;                                   // successors of railroad
+std::vector<uint16_t>       Topology::succ;
+std::vector<uint32_t>       Topology::pred_start;                                   // predecessors of railroad
+std::vector<uint16_t>       Topology::pred;
+std::vector<TOPOLOGY_CACHE> Topology::cache;                                        // per destination group
+TOPOLOGY_STATS              Topology::stats;                                        // statistics
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * The nodes of the layout graph are the railroads of all railroad groups. A S88 contact linked to railroad A with an
+ * 'in' action which sets railroad B or a free railroad of group G leads to the edges A -> B or A -> each railroad of G:
+ * a train which arrives on A continues on B or G.
+ *
+ * For each destination group the cost from every railroad to the destination is computed by Dijkstra on the reversed
+ * graph and cached. Entering an occupied railroad costs more, so a change of occupancy only increments the generation,
+ * the costs of a destination are recomputed when they are needed next time.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * build () - build graph from railroad groups and S88 contacts
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Topology::build (void)
+{
+    uint_fast8_t            n_railroad_groups   = RailroadGroups::get_n_railroad_groups ();
+    uint_fast16_t           n_contacts          = S88::get_n_contacts ();
+    std::vector<uint32_t>   edges;
+    uint_fast16_t           n_railroads;
+    uint_fast8_t            rrgidx;
+    uint_fast16_t           coidx;
+    uint_fast16_t           idx;
+
+    Topology::rr_base.resize (n_railroad_groups);
+    Topology::rr_group.clear ();
+
+    for (rrgidx = 0; rrgidx < n_railroad_groups; rrgidx++)
+    {
+        Topology::rr_base[rrgidx] = Topology::rr_group.size ();
+        Topology::rr_group.insert (Topology::rr_group.end (), RailroadGroups::railroad_groups[rrgidx].get_n_railroads (), rrgidx);
+    }
+
+    n_railroads = Topology::rr_group.size ();
+
+    for (coidx = 0; coidx < n_contacts; coidx++)
+    {
+        S88_Contact *   cp      = &S88::contacts[coidx];
+        uint_fast8_t    caidx;
+        uint_fast16_t   from;
+
+        if (cp->rrgidx >= n_railroad_groups || cp->rridx >= RailroadGroups::railroad_groups[cp->rrgidx].get_n_railroads ())
+        {
+            continue;
+        }
+
+        from = Topology::rr_base[cp->rrgidx] + cp->rridx;
+
+        for (caidx = 0; caidx < cp->n_contact_actions_in; caidx++)
+        {
+            CONTACT_ACTION *    cap         = &cp->contact_actions_in[caidx];
+            uint_fast16_t       to_rrgidx   = cap->parameters[0];
+
+            if (to_rrgidx >= n_railroad_groups)
+            {
+                continue;
+            }
+
+            if (cap->action == S88_ACTION_SET_RAILROAD)
+            {
+                if (cap->parameters[1] < RailroadGroups::railroad_groups[to_rrgidx].get_n_railroads ())
+                {
+                    edges.push_back ((from << 16) | (Topology::rr_base[to_rrgidx] + cap->parameters[1]));
+                }
+            }
+            else if (cap->action == S88_ACTION_SET_FREE_RAILROAD)
+            {
+                uint_fast8_t    n_to = RailroadGroups::railroad_groups[to_rrgidx].get_n_railroads ();
+                uint_fast8_t    rridx;
+
+                for (rridx = 0; rridx < n_to; rridx++)
+                {
+                    edges.push_back ((from << 16) | (Topology::rr_base[to_rrgidx] + rridx));
+                }
+            }
+        }
+    }
+
+    std::sort (edges.begin (), edges.end ());
+    edges.erase (std::unique (edges.begin (), edges.end ()), edges.end ());
+
+    Topology::succ_start.assign (n_railroads + 1, 0);
+    Topology::pred_start.assign (n_railroads + 1, 0);
+    Topology::succ.resize (edges.size ());
+    Topology::pred.resize (edges.size ());
+
+    for (uint32_t edge : edges)
+    {
+        Topology::succ_start[(edge >> 16) + 1]++;
+        Topology::pred_start[(edge & 0xFFFF) + 1]++;
+    }
+
+    for (idx = 0; idx < n_railroads; idx++)
+    {
+        Topology::succ_start[idx + 1] += Topology::succ_start[idx];
+        Topology::pred_start[idx + 1] += Topology::pred_start[idx];
+    }
+
+    std::vector<uint32_t>   succ_pos (Topology::succ_start.begin (), Topology::succ_start.end () - 1);
+    std::vector<uint32_t>   pred_pos (Topology::pred_start.begin (), Topology::pred_start.end () - 1);
+
+    for (uint32_t edge : edges)
+    {
+        Topology::succ[succ_pos[edge >> 16]++]      = edge & 0xFFFF;
+        Topology::pred[pred_pos[edge & 0xFFFF]++]   = edge >> 16;
+    }
+
+    Topology::cache.assign (n_railroad_groups, TOPOLOGY_CACHE ());
+    Topology::cost_generation   = 0;
+    Topology::stats.n_builds++;
+    Topology::stats.n_railroads = n_railroads;
+    Topology::stats.n_edges     = edges.size ();
+    Topology::valid             = true;
+    Debug::printf (DEBUG_LEVEL_VERBOSE, "Topology::build: %u railroads, %u edges\n", (unsigned int) n_railroads, (unsigned int) edges.size ());
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * update_cost () - update cost of entering each railroad from current occupancy
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Topology::update_cost (void)
+{
+    uint_fast16_t   n_railroads = Topology::rr_group.size ();
+    uint_fast16_t   idx;
+
+    Topology::cost.resize (n_railroads);
+
+    for (idx = 0; idx < n_railroads; idx++)
+    {
+        uint_fast8_t    rrgidx  = Topology::rr_group[idx];
+        uint_fast8_t    rridx   = idx - Topology::rr_base[rrgidx];
+        bool            occupied;
+
+        occupied            = RailroadGroups::railroad_groups[rrgidx].railroads[rridx].get_located_loco () != 0xFFFF || S88::is_railroad_occupied (rrgidx, rridx);
+        Topology::cost[idx] = occupied ? TOPOLOGY_COST_BLOCK + TOPOLOGY_COST_OCCUPIED : TOPOLOGY_COST_BLOCK;
+    }
+
+    Topology::cost_generation = Topology::generation;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * compute () - compute cost from each railroad to destination group
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Topology::compute (uint_fast8_t dest_rrgidx)
+{
+    typedef std::pair<uint32_t, uint16_t>                                                   NODE;
+    std::priority_queue<NODE, std::vector<NODE>, std::greater<NODE>>                        queue;
+    std::vector<uint16_t> *     distp           = &Topology::cache[dest_rrgidx].dist;
+    uint_fast16_t               n_railroads     = Topology::rr_group.size ();
+    uint_fast16_t               idx;
+    uint_fast8_t                rridx;
+
+    if (Topology::cost_generation != Topology::generation)
+    {
+        Topology::update_cost ();
+    }
+
+    distp->assign (n_railroads, TOPOLOGY_UNREACHABLE);
+
+    for (rridx = 0; rridx < RailroadGroups::railroad_groups[dest_rrgidx].get_n_railroads (); rridx++)
+    {
+        idx = Topology::rr_base[dest_rrgidx] + rridx;
+        (*distp)[idx] = 0;
+        queue.push (NODE (0, idx));
+    }
+
+    while (! queue.empty ())
+    {
+        NODE        node    = queue.top ();
+        uint32_t    pidx;
+
+        queue.pop ();
+
+        if (node.first != (*distp)[node.second])
+        {
+            continue;                                                               // outdated entry
+        }
+
+        for (pidx = Topology::pred_start[node.second]; pidx < Topology::pred_start[node.second + 1]; pidx++)
+        {
+            uint_fast16_t   from    = Topology::pred[pidx];
+            uint32_t        dist    = node.first + Topology::cost[node.second];
+
+            if (dist < (*distp)[from])
+            {
+                (*distp)[from] = dist;
+                queue.push (NODE (dist, from));
+            }
+        }
+    }
+
+    Topology::cache[dest_rrgidx].generation = Topology::generation;
+    Topology::stats.n_computes++;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_dist () - get cost from each railroad to destination group, compute if necessary
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+std::vector<uint16_t> *
+Topology::get_dist (uint_fast8_t dest_rrgidx)
+{
+    if (! Topology::valid)
+    {
+        Topology::build ();
+    }
+
+    if (dest_rrgidx >= Topology::cache.size ())
+    {
+        return (std::vector<uint16_t> *) NULL;
+    }
+
+    if (Topology::cache[dest_rrgidx].generation != Topology::generation)
+    {
+        Topology::compute (dest_rrgidx);
+    }
+
+    return &Topology::cache[dest_rrgidx].dist;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * invalidate () - configuration of railroads or S88 contacts changed, rebuild graph on next query
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Topology::invalidate (void)
+{
+    Topology::valid = false;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * occupancy_changed () - a railroad got occupied or free, recompute costs on next query
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Topology::occupancy_changed (void)
+{
+    Topology::generation++;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_distance () - get cost from railroad to destination group, TOPOLOGY_UNREACHABLE if there is no path
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Topology::get_distance (uint_fast8_t rrgidx, uint_fast8_t rridx, uint_fast8_t dest_rrgidx)
+{
+    std::vector<uint16_t> *     distp;
+
+    Topology::stats.n_queries++;
+    distp = Topology::get_dist (dest_rrgidx);
+
+    if (! distp || rrgidx >= Topology::rr_base.size () || rridx >= RailroadGroups::railroad_groups[rrgidx].get_n_railroads ())
+    {
+        return TOPOLOGY_UNREACHABLE;
+    }
+
+    return (*distp)[Topology::rr_base[rrgidx] + rridx];
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_free_railroads () - get free railroads of group, best route to destination of loco first
+ *
+ * Without destination or path the order is the order of S88::get_free_railroads (). Further entries are alternatives
+ * if the first railroad is refused by interlocking. Returns number of railroads.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast8_t
+Topology::get_free_railroads (uint_fast8_t rrgidx, uint_fast16_t loco_idx, uint8_t * rridx_list)
+{
+    uint_fast8_t                n_free  = S88::get_free_railroads (rrgidx, rridx_list);
+    uint_fast8_t                dest_rrgidx;
+    std::vector<uint16_t> *     distp;
+
+    if (n_free <= 1 || loco_idx >= Locos::get_n_locos ())
+    {
+        return n_free;
+    }
+
+    dest_rrgidx = Locos::locos[loco_idx].get_destination ();
+
+    if (dest_rrgidx == 0xFF)
+    {
+        return n_free;
+    }
+
+    Topology::stats.n_queries++;
+    distp = Topology::get_dist (dest_rrgidx);
+
+    if (distp && rrgidx < Topology::rr_base.size ())
+    {
+        uint_fast16_t   base = Topology::rr_base[rrgidx];
+
+        std::stable_sort (rridx_list, rridx_list + n_free,
+                          [distp, base](uint8_t a, uint8_t b) { return (*distp)[base + a] < (*distp)[base + b]; });
+    }
+
+    return n_free;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_path () - get cheapest path from railroad to destination group
+ *
+ * path gets the railroads as rrgidx << 8 | rridx, starting with the given railroad. Returns length of path, 0 if there
+ * is no path.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+uint_fast16_t
+Topology::get_path (uint_fast8_t rrgidx, uint_fast8_t rridx, uint_fast8_t dest_rrgidx, uint16_t * path, uint_fast16_t max_len)
+{
+    std::vector<uint16_t> *     distp;
+    uint_fast16_t               len = 0;
+    uint_fast16_t               idx;
+
+    Topology::stats.n_queries++;
+    distp = Topology::get_dist (dest_rrgidx);
+
+    if (! distp || rrgidx >= Topology::rr_base.size () || rridx >= RailroadGroups::railroad_groups[rrgidx].get_n_railroads ())
+    {
+        return 0;
+    }
+
+    idx = Topology::rr_base[rrgidx] + rridx;
+
+    if ((*distp)[idx] == TOPOLOGY_UNREACHABLE)
+    {
+        return 0;
+    }
+
+    while (len < max_len)
+    {
+        uint_fast8_t    group   = Topology::rr_group[idx];
+        uint_fast16_t   next    = 0xFFFF;
+        uint32_t        sidx;
+
+        path[len++] = (group << 8) | (idx - Topology::rr_base[group]);
+
+        if ((*distp)[idx] == 0)
+        {
+            break;                                                                  // destination reached
+        }
+
+        for (sidx = Topology::succ_start[idx]; sidx < Topology::succ_start[idx + 1]; sidx++)
+        {
+            uint_fast16_t   to = Topology::succ[sidx];
+
+            if ((*distp)[to] != TOPOLOGY_UNREACHABLE && (*distp)[to] + Topology::cost[to] == (*distp)[idx])
+            {
+                next = to;
+                break;
+            }
+        }
+
+        if (next == 0xFFFF)
+        {
+            break;
+        }
+
+        idx = next;
+    }
+
+    return len;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * get_stats () - get statistics
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+Topology::get_stats (TOPOLOGY_STATS * statsp)
+{
+    *statsp = Topology::stats;
+}
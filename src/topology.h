@@ -0,0 +1,76 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * topology.h - layout graph and path-finding
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stdint.h>
+#include <vector>
+#include "railroad.h"
+
+#define TOPOLOGY_COST_BLOCK                 1                                   // cost of entering a railroad
+#define TOPOLOGY_COST_OCCUPIED              16                                  // additional cost of entering an occupied railroad
+#define TOPOLOGY_UNREACHABLE                0xFFFF                              // no path to destination
+
+typedef struct
+{
+    uint32_t            n_queries;                                              // number of distance/route queries
+    uint32_t            n_computes;                                             // number of shortest path computations
+    uint32_t            n_builds;                                               // number of builds of graph
+    uint32_t            n_railroads;                                            // number of nodes
+    uint32_t            n_edges;                                                // number of edges
+} TOPOLOGY_STATS;
+
+typedef struct
+{
+    uint32_t                generation;                                         // occupancy generation of dist
+    std::vector<uint16_t>   dist;                                               // cost from railroad to destination group
+} TOPOLOGY_CACHE;
+
+class Topology
+{
+    public:
+        static void                     invalidate (void);
+        static void                     occupancy_changed (void);
+        static uint_fast16_t            get_distance (uint_fast8_t rrgidx, uint_fast8_t rridx, uint_fast8_t dest_rrgidx);
+        static uint_fast8_t             get_free_railroads (uint_fast8_t rrgidx, uint_fast16_t loco_idx, uint8_t * rridx_list);
+        static uint_fast16_t            get_path (uint_fast8_t rrgidx, uint_fast8_t rridx, uint_fast8_t dest_rrgidx, uint16_t * path, uint_fast16_t max_len);
+        static void                     get_stats (TOPOLOGY_STATS * statsp);
+
+    private:
+        static bool                     valid;                                  // flag: graph is up to date
+        static uint32_t                 generation;                             // incremented on each change of occupancy
+        static uint32_t                 cost_generation;                        // occupancy generation of cost
+        static std::vector<uint8_t>     cost;                                   // cost of entering railroad
+        static std::vector<uint16_t>    rr_base;                                // rrgidx -> index of first railroad
+        static std::vector<uint8_t>     rr_group;                               // railroad index -> rrgidx
+        static std::vector<uint32_t>    succ_start;                             // successors of railroad: succ[succ_start[idx]] ...
+        static std::vector<uint16_t>    succ;
+        static std::vector<uint32_t>    pred_start;                             // predecessors of railroad: pred[pred_start[idx]] ...
+        static std::vector<uint16_t>    pred;
+        static std::vector<TOPOLOGY_CACHE> cache;                               // per destination group
+        static TOPOLOGY_STATS           stats;                                  // statistics
+
+        static void                     build (void);
+        static void                     update_cost (void);
+        static void                     compute (uint_fast8_t dest_rrgidx);
+        static std::vector<uint16_t> *  get_dist (uint_fast8_t dest_rrgidx);
+};
+
+#endif
@@ -0,0 +1,530 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp-client.cc - test client and load generator for the binary UDP control protocol, build with "make udp-client"
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ *
+ * usage: udp-client [-h host] [-p port] [-l loco_idx] test
+ *        udp-client [-h host] [-p port] [-l loco_idx] [-n commands] [-c clients] load
+ *
+ * test:    checks the protocol against a running fm22, changes the speed and F1 of loco loco_idx and restores them.
+ * load:    clients send n commands in total, alternating LOCO_SET_SPEED and LOCO_GET, each client waits for the
+ *          answer before it sends the next command. Prints throughput and round trip times.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <vector>
+#include <algorithm>
+
+#include "dcc.h"
+#include "udp.h"
+
+#define CLIENT_TIMEOUT              500                                         // msec until a command is repeated
+#define CLIENT_MAX_RETRIES          4
+
+typedef struct
+{
+    int                 fd;
+    uint16_t            seq;                                                    // sequence number of last command
+} CLIENT;
+
+static struct sockaddr_in           server_addr;
+static uint_fast16_t                n_passed;
+static uint_fast16_t                n_failed;
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * usec () - monotonic time in microseconds
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static uint64_t
+usec (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000U + (uint64_t) (ts.tv_nsec / 1000);
+}
+
+static inline void
+put16 (uint8_t * p, uint_fast16_t value)
+{
+    p[0] = value >> 8;
+    p[1] = value & 0xFF;
+}
+
+static inline uint_fast16_t
+get16 (const uint8_t * p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+static inline uint32_t
+get32 (const uint8_t * p)
+{
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * client_open () - open socket of a client
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+client_open (CLIENT * cp)
+{
+    cp->fd  = socket (AF_INET, SOCK_DGRAM, 0);
+    cp->seq = (rand () & 0x7FFF) + 1;
+
+    if (cp->fd < 0)
+    {
+        perror ("socket");
+        return false;
+    }
+
+    return true;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * client_send () - send packet, version 0 means UDP_PROTOCOL_VERSION
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+client_send (CLIENT * cp, uint_fast8_t version, uint_fast8_t cmd, uint_fast16_t seq, const uint8_t * payload, int plen)
+{
+    uint8_t     buf[UDP_MAX_PACKET_SIZE];
+
+    buf[0] = version ? version : UDP_PROTOCOL_VERSION;
+    buf[1] = cmd;
+    put16 (buf + 2, seq);
+    memcpy (buf + UDP_HEADER_SIZE, payload, plen);
+
+    if (sendto (cp->fd, buf, UDP_HEADER_SIZE + plen, 0, (struct sockaddr *) &server_addr, sizeof (server_addr)) < 0)
+    {
+        perror ("sendto");
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * client_receive () - receive packet within timeout msec, returns length, 0 on timeout
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+client_receive (CLIENT * cp, uint8_t * buf, int timeout)
+{
+    struct pollfd   pfd;
+    int             len = 0;
+
+    pfd.fd      = cp->fd;
+    pfd.events  = POLLIN;
+
+    if (poll (&pfd, 1, timeout) > 0)
+    {
+        len = recv (cp->fd, buf, UDP_MAX_PACKET_SIZE, 0);
+
+        if (len < 0)
+        {
+            len = 0;
+        }
+    }
+
+    return len;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * client_command () - send command with next sequence number and wait for the answer, repeat command on timeout.
+ * Returns length of answer, 0 if there was no answer.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+client_command (CLIENT * cp, uint_fast8_t cmd, const uint8_t * payload, int plen, uint8_t * reply, uint_fast8_t * retriesp)
+{
+    uint_fast8_t    retries;
+    int             len;
+
+    cp->seq++;
+
+    for (retries = 0; retries < CLIENT_MAX_RETRIES; retries++)
+    {
+        uint64_t    deadline = usec () + CLIENT_TIMEOUT * 1000;
+
+        client_send (cp, 0, cmd, cp->seq, payload, plen);               // same sequence number: not executed twice
+
+        while (usec () < deadline)
+        {
+            len = client_receive (cp, reply, (deadline - usec ()) / 1000 + 1);
+
+            if (len >= UDP_HEADER_SIZE && get16 (reply + 2) == cp->seq && (reply[1] == UDP_MSG_ACK || reply[1] == UDP_MSG_LOCO_STATE ||
+                                                                           reply[1] == UDP_MSG_POWER_STATE))
+            {
+                if (retriesp)
+                {
+                    *retriesp = retries;
+                }
+
+                return len;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * check () - print result of a test
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+check (const char * name, bool ok)
+{
+    printf ("%-56s %s\n", name, ok ? "ok" : "FAILED");
+
+    if (ok)
+    {
+        n_passed++;
+    }
+    else
+    {
+        n_failed++;
+    }
+}
+
+static bool
+is_ack (const uint8_t * reply, int len, uint_fast8_t status)
+{
+    return len == UDP_HEADER_SIZE + 1 && reply[1] == UDP_MSG_ACK && reply[UDP_HEADER_SIZE] == status;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * wait_message () - wait for subscription message msg within timeout msec
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+wait_message (CLIENT * cp, uint_fast8_t msg, uint8_t * buf, int timeout)
+{
+    uint64_t    deadline = usec () + timeout * 1000;
+    int         len;
+
+    while (usec () < deadline)
+    {
+        len = client_receive (cp, buf, (deadline - usec ()) / 1000 + 1);
+
+        if (len >= UDP_HEADER_SIZE && buf[1] == msg)
+        {
+            return len;
+        }
+    }
+
+    return 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * test () - check protocol, returns exit code
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+test (uint_fast16_t loco_idx)
+{
+    CLIENT          a;
+    CLIENT          b;
+    uint8_t         payload[8];
+    uint8_t         reply[UDP_MAX_PACKET_SIZE];
+    uint_fast8_t    old_speed;
+    uint_fast8_t    fwd;
+    uint32_t        old_functions;
+    int             len;
+
+    if (! client_open (&a) || ! client_open (&b))
+    {
+        return 1;
+    }
+
+    len = client_command (&a, UDP_CMD_PING, payload, 0, reply, NULL);
+    check ("PING is acknowledged", is_ack (reply, len, UDP_STATUS_OK));
+
+    if (len == 0)
+    {
+        printf ("no answer from %s:%u\n", inet_ntoa (server_addr.sin_addr), ntohs (server_addr.sin_port));
+        return 1;
+    }
+
+    client_send (&a, UDP_PROTOCOL_VERSION + 1, UDP_CMD_PING, ++a.seq, payload, 0);
+    len = client_receive (&a, reply, CLIENT_TIMEOUT);
+    check ("wrong version is refused", is_ack (reply, len, UDP_STATUS_INVALID_VERSION));
+
+    len = client_command (&a, 0x7F, payload, 0, reply, NULL);
+    check ("unknown command is refused", is_ack (reply, len, UDP_STATUS_UNKNOWN_COMMAND));
+
+    len = client_command (&a, UDP_CMD_PING, payload, 1, reply, NULL);
+    check ("PING with payload is refused", is_ack (reply, len, UDP_STATUS_INVALID_LENGTH));
+
+    put16 (payload, 0xFFFF);
+    len = client_command (&a, UDP_CMD_LOCO_GET, payload, 2, reply, NULL);
+    check ("LOCO_GET of invalid loco is refused", is_ack (reply, len, UDP_STATUS_INVALID_INDEX));
+
+    put16 (payload, 0);
+    payload[2] = DCC_SWITCH_STATE_UNDEFINED;
+    len = client_command (&a, UDP_CMD_SWITCH_SET, payload, 3, reply, NULL);
+    check ("SWITCH_SET with invalid state is refused", is_ack (reply, len, UDP_STATUS_INVALID_VALUE));
+
+    put16 (payload, loco_idx);
+    len = client_command (&a, UDP_CMD_LOCO_GET, payload, 2, reply, NULL);
+    check ("LOCO_GET answers LOCO_STATE", len == UDP_HEADER_SIZE + 8 && reply[1] == UDP_MSG_LOCO_STATE && get16 (reply + 4) == loco_idx);
+
+    if (len != UDP_HEADER_SIZE + 8)
+    {
+        printf ("loco %u not available, use -l\n", (unsigned int) loco_idx);
+        return 1;
+    }
+
+    old_speed       = reply[6];
+    fwd             = reply[7];
+    old_functions   = get32 (reply + 8);
+
+    put16 (payload, loco_idx);
+    payload[2] = 10;
+    payload[3] = fwd;
+    len = client_command (&a, UDP_CMD_LOCO_SET_SPEED, payload, 4, reply, NULL);
+    check ("LOCO_SET_SPEED is acknowledged", is_ack (reply, len, UDP_STATUS_OK));
+
+    payload[2] = 20;                                                            // retransmission: same sequence number
+    client_send (&a, 0, UDP_CMD_LOCO_SET_SPEED, a.seq, payload, 4);
+    len = client_receive (&a, reply, CLIENT_TIMEOUT);
+    check ("retransmission is answered", is_ack (reply, len, UDP_STATUS_OK));
+
+    client_send (&a, 0, UDP_CMD_LOCO_SET_SPEED, a.seq - 5, payload, 4);
+    len = client_receive (&a, reply, CLIENT_TIMEOUT);
+    check ("older sequence number is refused as stale", is_ack (reply, len, UDP_STATUS_STALE));
+
+    len = client_command (&a, UDP_CMD_LOCO_GET, payload, 2, reply, NULL);
+    check ("retransmission and stale command are not executed", len == UDP_HEADER_SIZE + 8 && reply[6] == 10);
+
+    put16 (payload, loco_idx);
+    len = client_command (&b, UDP_CMD_LOCO_SUBSCRIBE, payload, 2, reply, NULL);
+    check ("LOCO_SUBSCRIBE answers LOCO_STATE", len == UDP_HEADER_SIZE + 8 && reply[1] == UDP_MSG_LOCO_STATE);
+
+    payload[2] = 1;
+    payload[3] = (old_functions & (1 << 1)) ? 0 : 1;
+    len = client_command (&a, UDP_CMD_LOCO_SET_FUNCTION, payload, 4, reply, NULL);
+    check ("LOCO_SET_FUNCTION is acknowledged", is_ack (reply, len, UDP_STATUS_OK));
+
+    len = wait_message (&b, UDP_MSG_LOCO_STATE, reply, 2000);
+    check ("subscriber gets LOCO_STATE after function change", len == UDP_HEADER_SIZE + 8 && get16 (reply + 4) == loco_idx &&
+                                                               get32 (reply + 8) == (old_functions ^ (1 << 1)));
+
+    payload[0] = UDP_FEEDBACK_POWER;                                            // current state is sent before ACK
+    client_send (&b, 0, UDP_CMD_FEEDBACK_SUBSCRIBE, ++b.seq, payload, 1);
+    len = wait_message (&b, UDP_MSG_POWER_STATE, reply, 2000);
+    check ("subscriber gets POWER_STATE", len == UDP_HEADER_SIZE + 1);
+
+    len = wait_message (&b, UDP_MSG_ACK, reply, 2000);
+    check ("FEEDBACK_SUBSCRIBE is acknowledged", is_ack (reply, len, UDP_STATUS_OK) && get16 (reply + 2) == b.seq);
+
+    put16 (payload, loco_idx);                                                  // restore state of loco
+    payload[2] = 1;
+    payload[3] = (old_functions & (1 << 1)) ? 1 : 0;
+    (void) client_command (&a, UDP_CMD_LOCO_SET_FUNCTION, payload, 4, reply, NULL);
+    payload[2] = old_speed;
+    payload[3] = fwd;
+    (void) client_command (&a, UDP_CMD_LOCO_SET_SPEED, payload, 4, reply, NULL);
+
+    len = client_command (&a, UDP_CMD_LOGOUT, payload, 0, reply, NULL);
+    check ("LOGOUT is acknowledged", is_ack (reply, len, UDP_STATUS_OK));
+    len = client_command (&b, UDP_CMD_LOGOUT, payload, 0, reply, NULL);
+    check ("LOGOUT of subscriber is acknowledged", is_ack (reply, len, UDP_STATUS_OK));
+
+    close (a.fd);
+    close (b.fd);
+
+    printf ("%u passed, %u failed\n", (unsigned int) n_passed, (unsigned int) n_failed);
+    return n_failed ? 1 : 0;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * load () - send n_commands with n_clients in parallel, returns exit code
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+load (uint_fast16_t loco_idx, uint32_t n_commands, uint_fast8_t n_clients)
+{
+    std::vector<CLIENT>     clients (n_clients);
+    std::vector<uint64_t>   sent (n_clients);                                   // time of command in flight, 0: none
+    std::vector<uint32_t>   rtts;                                               // round trip times in usec
+    std::vector<pollfd>     pfds (n_clients);
+    uint8_t                 payload[8];
+    uint8_t                 reply[UDP_MAX_PACKET_SIZE];
+    uint32_t                n_sent      = 0;
+    uint32_t                n_errors    = 0;
+    uint32_t                n_repeated  = 0;
+    uint64_t                start;
+    uint64_t                duration;
+    uint_fast8_t            cidx;
+
+    for (cidx = 0; cidx < n_clients; cidx++)
+    {
+        if (! client_open (&clients[cidx]))
+        {
+            return 1;
+        }
+
+        pfds[cidx].fd       = clients[cidx].fd;
+        pfds[cidx].events   = POLLIN;
+    }
+
+    rtts.reserve (n_commands);
+    start = usec ();
+
+    while (rtts.size () < n_commands)
+    {
+        uint64_t    now = usec ();
+
+        for (cidx = 0; cidx < n_clients; cidx++)
+        {
+            CLIENT *    cp = &clients[cidx];
+
+            if (sent[cidx] == 0 && n_sent < n_commands)
+            {
+                put16 (payload, loco_idx);
+                payload[2] = n_sent % 100;
+                payload[3] = 1;
+                cp->seq++;
+                client_send (cp, 0, (n_sent & 1) ? UDP_CMD_LOCO_GET : UDP_CMD_LOCO_SET_SPEED, cp->seq, payload, (n_sent & 1) ? 2 : 4);
+                sent[cidx] = now;
+                n_sent++;
+            }
+            else if (sent[cidx] && now - sent[cidx] > CLIENT_TIMEOUT * 1000)  // lost, repeat with same sequence number
+            {
+                put16 (payload, loco_idx);
+                client_send (cp, 0, UDP_CMD_LOCO_GET, cp->seq, payload, 2);
+                n_repeated++;
+                sent[cidx] = now;
+            }
+        }
+
+        if (poll (pfds.data(), n_clients, 10) > 0)
+        {
+            now = usec ();
+
+            for (cidx = 0; cidx < n_clients; cidx++)
+            {
+                if (pfds[cidx].revents & POLLIN)
+                {
+                    int len = recv (clients[cidx].fd, reply, sizeof (reply), 0);
+
+                    if (len >= UDP_HEADER_SIZE && sent[cidx] && get16 (reply + 2) == clients[cidx].seq)
+                    {
+                        if (reply[1] == UDP_MSG_ACK && reply[UDP_HEADER_SIZE] != UDP_STATUS_OK)
+                        {
+                            n_errors++;
+                        }
+
+                        rtts.push_back (now - sent[cidx]);
+                        sent[cidx] = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    duration = usec () - start;
+
+    for (cidx = 0; cidx < n_clients; cidx++)
+    {
+        (void) client_command (&clients[cidx], UDP_CMD_LOGOUT, payload, 0, reply, NULL);
+        close (clients[cidx].fd);
+    }
+
+    std::sort (rtts.begin (), rtts.end ());
+
+    printf ("%u commands, %u clients, %.3f sec, %.0f commands/sec\n", n_commands, (unsigned int) n_clients, duration / 1e6,
+            duration ? 1e6 * n_commands / duration : 0.0);
+    printf ("round trip: p50 %u usec, p99 %u usec, max %u usec\n", rtts[rtts.size () / 2], rtts[(rtts.size () * 99) / 100], rtts.back ());
+    printf ("%u errors, %u repeated commands\n", n_errors, n_repeated);
+    return n_errors ? 1 : 0;
+}
+
+static void
+usage (const char * pgm)
+{
+    fprintf (stderr, "usage: %s [-h host] [-p port] [-l loco_idx] test\n", pgm);
+    fprintf (stderr, "       %s [-h host] [-p port] [-l loco_idx] [-n commands] [-c clients] load\n", pgm);
+    exit (1);
+}
+
+int
+main (int argc, char ** argv)
+{
+    const char *        host        = "127.0.0.1";
+    uint_fast16_t       port        = UDP_PORT;
+    uint_fast16_t       loco_idx    = 0;
+    uint32_t            n_commands  = 10000;
+    uint_fast8_t        n_clients   = 4;
+    struct hostent *    hp;
+    int                 opt;
+
+    while ((opt = getopt (argc, argv, "h:p:l:n:c:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'h':   host        = optarg;           break;
+            case 'p':   port        = atoi (optarg);    break;
+            case 'l':   loco_idx    = atoi (optarg);    break;
+            case 'n':   n_commands  = atoi (optarg);    break;
+            case 'c':   n_clients   = atoi (optarg);    break;
+            default:    usage (argv[0]);
+        }
+    }
+
+    if (optind != argc - 1 || n_commands == 0 || n_clients == 0 || n_clients > UDP_MAX_CLIENTS)
+    {
+        usage (argv[0]);
+    }
+
+    hp = gethostbyname (host);
+
+    if (! hp)
+    {
+        fprintf (stderr, "%s: unknown host\n", host);
+        return 1;
+    }
+
+    memset (&server_addr, 0, sizeof (server_addr));
+    server_addr.sin_family  = AF_INET;
+    server_addr.sin_port    = htons (port);
+    memcpy (&server_addr.sin_addr, hp->h_addr_list[0], sizeof (server_addr.sin_addr));
+
+    srand (time ((time_t *) NULL) ^ getpid ());
+
+    if (! strcmp (argv[optind], "test"))
+    {
+        return test (loco_idx);
+    }
+    else if (! strcmp (argv[optind], "load"))
+    {
+        return load (loco_idx, n_commands, n_clients);
+    }
+
+    usage (argv[0]);
+    return 1;
+}
@@ -0,0 +1,849 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp.cc - binary UDP control protocol for throttles and apps
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <vector>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "udp.h"
+#include "loco.h"
+#include "switch.h"
+#include "s88.h"
+#include "dcc.h"
+#include "userio.h"
+#include "millis.h"
+#include "fm22.h"
+#include "debug.h"
+
+#define UDP_MAX_REPLY_SIZE      16                                  // max. size of a stored answer for retransmissions
+
+typedef struct
+{
+    struct sockaddr_in          addr;                               // address of client
+    unsigned long               last_millis;                        // time of last command
+    uint16_t                    last_seq;                           // sequence number of last command
+    uint16_t                    tx_seq;                             // sequence number of last subscription message
+    uint8_t                     reply[UDP_MAX_REPLY_SIZE];          // answer to last command
+    uint8_t                     reply_len;
+    uint8_t                     valid;
+    uint8_t                     feedback_mask;                      // UDP_FEEDBACK_xxx
+    uint8_t                     n_locos;                            // number of subscribed locos
+    uint16_t                    loco_idx[UDP_MAX_LOCO_SUBSCRIPTIONS];
+    uint8_t                     loco_speed[UDP_MAX_LOCO_SUBSCRIPTIONS];         // last sent state of subscribed locos
+    uint8_t                     loco_fwd[UDP_MAX_LOCO_SUBSCRIPTIONS];
+    uint32_t                    loco_functions[UDP_MAX_LOCO_SUBSCRIPTIONS];
+} UDP_CLIENT;
+
+static int                      udp_fd = -1;
+static UDP_CLIENT               clients[UDP_MAX_CLIENTS];
+static uint_fast8_t             n_clients;
+
+static uint32_t                 last_state_version;                 // FM22::state_version at last check for changes
+static uint8_t                  last_power;                         // last sent state of booster
+static uint8_t                  last_s88[S88_MAX_CONTACT_BYTES];    // last sent state of S88 contacts
+static uint_fast16_t            last_n_s88_bytes;
+static std::vector<uint8_t>     last_rcl;                           // last sent RCL locations of locos
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * put16 (), put32 (), get16 () - store/read values in network byte order
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static inline void
+put16 (uint8_t * p, uint_fast16_t value)
+{
+    p[0] = value >> 8;
+    p[1] = value & 0xFF;
+}
+
+static inline void
+put32 (uint8_t * p, uint32_t value)
+{
+    p[0] = value >> 24;
+    p[1] = (value >> 16) & 0xFF;
+    p[2] = (value >> 8) & 0xFF;
+    p[3] = value & 0xFF;
+}
+
+static inline uint_fast16_t
+get16 (const uint8_t * p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp_send () - send packet to client
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+udp_send (const struct sockaddr_in * addr, const uint8_t * buf, int len)
+{
+    if (sendto (udp_fd, buf, len, MSG_DONTWAIT, (const struct sockaddr *) addr, sizeof (struct sockaddr_in)) != len)
+    {
+        Debug::printf (DEBUG_LEVEL_VERBOSE, "udp_send: sendto to %s failed\n", inet_ntoa (addr->sin_addr));
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp_header () - fill header of packet, returns header size
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+udp_header (uint8_t * buf, uint_fast8_t msg, uint_fast16_t seq)
+{
+    buf[0] = UDP_PROTOCOL_VERSION;
+    buf[1] = msg;
+    put16 (buf + 2, seq);
+    return UDP_HEADER_SIZE;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp_loco_state () - fill LOCO_STATE message, returns length
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+udp_loco_state (uint8_t * buf, uint_fast16_t seq, uint_fast16_t loco_idx)
+{
+    int     len = udp_header (buf, UDP_MSG_LOCO_STATE, seq);
+
+    put16 (buf + len, loco_idx);
+    buf[len + 2] = Locos::locos[loco_idx].get_speed ();
+    buf[len + 3] = Locos::locos[loco_idx].get_fwd ();
+    put32 (buf + len + 4, Locos::locos[loco_idx].get_functions ());
+    return len + 8;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp_send_s88 () - send S88 state to client
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+udp_send_s88 (UDP_CLIENT * cp)
+{
+    uint8_t         buf[UDP_MAX_PACKET_SIZE];
+    uint_fast16_t   n_bytes = last_n_s88_bytes;
+    int             len;
+
+    if (n_bytes > UDP_MAX_PACKET_SIZE - UDP_HEADER_SIZE - 2)
+    {
+        n_bytes = UDP_MAX_PACKET_SIZE - UDP_HEADER_SIZE - 2;
+    }
+
+    len = udp_header (buf, UDP_MSG_S88_STATE, ++cp->tx_seq);
+    put16 (buf + len, n_bytes);
+    len += 2;
+    memcpy (buf + len, last_s88, n_bytes);
+    len += n_bytes;
+    udp_send (&cp->addr, buf, len);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp_send_rcl () - send RCL locations of locos to client
+ *
+ * changed: if not NULL, send only locations of locos with changed[loco_idx] != 0
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+udp_send_rcl (UDP_CLIENT * cp, const std::vector<uint8_t> * changed)
+{
+    uint8_t         buf[UDP_MAX_PACKET_SIZE];
+    uint_fast16_t   n_locos = last_rcl.size();
+    uint_fast16_t   loco_idx;
+    uint_fast16_t   n = 0;
+    int             len = UDP_HEADER_SIZE + 2;
+
+    for (loco_idx = 0; loco_idx < n_locos; loco_idx++)
+    {
+        if (! changed || (*changed)[loco_idx])
+        {
+            put16 (buf + len, loco_idx);
+            buf[len + 2] = last_rcl[loco_idx];
+            len += 3;
+            n++;
+
+            if (len + 3 > UDP_MAX_PACKET_SIZE)                      // packet full
+            {
+                udp_header (buf, UDP_MSG_RCL_STATE, ++cp->tx_seq);
+                put16 (buf + UDP_HEADER_SIZE, n);
+                udp_send (&cp->addr, buf, len);
+                len = UDP_HEADER_SIZE + 2;
+                n = 0;
+            }
+        }
+    }
+
+    if (n > 0)
+    {
+        udp_header (buf, UDP_MSG_RCL_STATE, ++cp->tx_seq);
+        put16 (buf + UDP_HEADER_SIZE, n);
+        udp_send (&cp->addr, buf, len);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp_send_power () - send state of booster to client
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+udp_send_power (UDP_CLIENT * cp)
+{
+    uint8_t     buf[UDP_HEADER_SIZE + 1];
+    int         len = udp_header (buf, UDP_MSG_POWER_STATE, ++cp->tx_seq);
+
+    buf[len++] = last_power;
+    udp_send (&cp->addr, buf, len);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp_update_feedback () - read current S88, RCL and booster state, returns true if something changed
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static bool
+udp_update_feedback (bool * s88_changed, std::vector<uint8_t>& rcl_changed, bool * rcl_any_changed, bool * power_changed)
+{
+    uint_fast16_t   n_bytes = S88::number_of_status_bytes ();
+    uint_fast16_t   n_locos = Locos::get_n_locos ();
+    uint_fast16_t   idx;
+
+    *s88_changed        = false;
+    *rcl_any_changed    = false;
+    *power_changed      = false;
+
+    if (n_bytes > S88_MAX_CONTACT_BYTES)
+    {
+        n_bytes = S88_MAX_CONTACT_BYTES;
+    }
+
+    if (n_bytes != last_n_s88_bytes)
+    {
+        last_n_s88_bytes = n_bytes;
+        *s88_changed = true;
+    }
+
+    for (idx = 0; idx < n_bytes; idx++)
+    {
+        uint8_t value = S88::get_state_byte (idx);
+
+        if (last_s88[idx] != value)
+        {
+            last_s88[idx] = value;
+            *s88_changed = true;
+        }
+    }
+
+    if (last_rcl.size() != n_locos)
+    {
+        last_rcl.resize (n_locos, 0xFF);
+    }
+
+    rcl_changed.assign (n_locos, 0);
+
+    for (idx = 0; idx < n_locos; idx++)
+    {
+        uint8_t location = Locos::locos[idx].get_rcllocation ();
+
+        if (last_rcl[idx] != location)
+        {
+            last_rcl[idx] = location;
+            rcl_changed[idx] = 1;
+            *rcl_any_changed = true;
+        }
+    }
+
+    if (last_power != (DCC::booster_is_on ? 1 : 0))
+    {
+        last_power = DCC::booster_is_on ? 1 : 0;
+        *power_changed = true;
+    }
+
+    return *s88_changed || *rcl_any_changed || *power_changed;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp_notify () - send changed states to subscribed clients
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+udp_notify (void)
+{
+    static std::vector<uint8_t> rcl_changed;
+    bool                        s88_changed;
+    bool                        rcl_any_changed;
+    bool                        power_changed;
+    bool                        feedback_changed;
+    uint_fast8_t                cidx;
+
+    feedback_changed = udp_update_feedback (&s88_changed, rcl_changed, &rcl_any_changed, &power_changed);
+
+    for (cidx = 0; cidx < UDP_MAX_CLIENTS; cidx++)
+    {
+        UDP_CLIENT *    cp = clients + cidx;
+        uint_fast8_t    sidx;
+
+        if (! cp->valid)
+        {
+            continue;
+        }
+
+        if (feedback_changed)
+        {
+            if (s88_changed && (cp->feedback_mask & UDP_FEEDBACK_S88))
+            {
+                udp_send_s88 (cp);
+            }
+
+            if (rcl_any_changed && (cp->feedback_mask & UDP_FEEDBACK_RCL))
+            {
+                udp_send_rcl (cp, &rcl_changed);
+            }
+
+            if (power_changed && (cp->feedback_mask & UDP_FEEDBACK_POWER))
+            {
+                udp_send_power (cp);
+            }
+        }
+
+        for (sidx = 0; sidx < cp->n_locos; sidx++)
+        {
+            uint_fast16_t   loco_idx = cp->loco_idx[sidx];
+
+            if (loco_idx < Locos::get_n_locos ())
+            {
+                Loco&       loco        = Locos::locos[loco_idx];
+                uint8_t     speed       = loco.get_speed ();
+                uint8_t     fwd         = loco.get_fwd ();
+                uint32_t    functions   = loco.get_functions ();
+
+                if (cp->loco_speed[sidx] != speed || cp->loco_fwd[sidx] != fwd || cp->loco_functions[sidx] != functions)
+                {
+                    uint8_t     buf[UDP_HEADER_SIZE + 8];
+                    int         len;
+
+                    cp->loco_speed[sidx]        = speed;
+                    cp->loco_fwd[sidx]          = fwd;
+                    cp->loco_functions[sidx]    = functions;
+
+                    len = udp_loco_state (buf, ++cp->tx_seq, loco_idx);
+                    udp_send (&cp->addr, buf, len);
+                }
+            }
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp_find_client () - find client by address, register new client if not found
+ *
+ * returns NULL if there is no free slot
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static UDP_CLIENT *
+udp_find_client (const struct sockaddr_in * addr, bool * is_new)
+{
+    UDP_CLIENT *    free_cp = (UDP_CLIENT *) NULL;
+    uint_fast8_t    cidx;
+
+    *is_new = false;
+
+    for (cidx = 0; cidx < UDP_MAX_CLIENTS; cidx++)
+    {
+        UDP_CLIENT * cp = clients + cidx;
+
+        if (cp->valid)
+        {
+            if (cp->addr.sin_addr.s_addr == addr->sin_addr.s_addr && cp->addr.sin_port == addr->sin_port)
+            {
+                return cp;
+            }
+        }
+        else if (! free_cp)
+        {
+            free_cp = cp;
+        }
+    }
+
+    if (free_cp)
+    {
+        memset (free_cp, 0, sizeof (UDP_CLIENT));
+        free_cp->addr   = *addr;
+        free_cp->valid  = 1;
+        n_clients++;
+        *is_new = true;
+        Debug::printf (DEBUG_LEVEL_NORMAL, "UDP: new client %s:%u\n", inet_ntoa (addr->sin_addr), ntohs (addr->sin_port));
+    }
+
+    return free_cp;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp_remove_client () - remove client and its subscriptions
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+udp_remove_client (UDP_CLIENT * cp)
+{
+    Debug::printf (DEBUG_LEVEL_NORMAL, "UDP: client %s:%u removed\n", inet_ntoa (cp->addr.sin_addr), ntohs (cp->addr.sin_port));
+    cp->valid = 0;
+    n_clients--;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp_expire_clients () - remove clients without commands within UDP_CLIENT_TIMEOUT
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+udp_expire_clients (void)
+{
+    unsigned long   now = Millis::elapsed ();
+    uint_fast8_t    cidx;
+
+    for (cidx = 0; cidx < UDP_MAX_CLIENTS; cidx++)
+    {
+        if (clients[cidx].valid && now - clients[cidx].last_millis > UDP_CLIENT_TIMEOUT)
+        {
+            udp_remove_client (clients + cidx);
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp_command () - execute command, fill answer into reply, returns length of answer
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static int
+udp_command (UDP_CLIENT * cp, uint_fast8_t cmd, uint_fast16_t seq, const uint8_t * payload, int plen, uint8_t * reply)
+{
+    uint_fast8_t    status  = UDP_STATUS_OK;
+    uint_fast16_t   idx     = 0;
+    int             len;
+
+    switch (cmd)                                                    // check length of payload and index
+    {
+        case UDP_CMD_PING:
+        case UDP_CMD_POWER_GET:
+        case UDP_CMD_LOGOUT:
+        {
+            if (plen != 0)
+            {
+                status = UDP_STATUS_INVALID_LENGTH;
+            }
+            break;
+        }
+
+        case UDP_CMD_POWER_SET:
+        case UDP_CMD_FEEDBACK_SUBSCRIBE:
+        {
+            if (plen != 1)
+            {
+                status = UDP_STATUS_INVALID_LENGTH;
+            }
+            break;
+        }
+
+        case UDP_CMD_LOCO_GET:
+        case UDP_CMD_LOCO_SUBSCRIBE:
+        case UDP_CMD_LOCO_UNSUBSCRIBE:
+        case UDP_CMD_LOCO_SET_SPEED:
+        case UDP_CMD_LOCO_SET_FUNCTION:
+        {
+            int     expected_len = (cmd == UDP_CMD_LOCO_SET_SPEED || cmd == UDP_CMD_LOCO_SET_FUNCTION) ? 4 : 2;
+
+            if (plen != expected_len)
+            {
+                status = UDP_STATUS_INVALID_LENGTH;
+            }
+            else
+            {
+                idx = get16 (payload);
+
+                if (idx >= Locos::get_n_locos ())
+                {
+                    status = UDP_STATUS_INVALID_INDEX;
+                }
+                else if (cmd == UDP_CMD_LOCO_SET_FUNCTION && payload[2] >= MAX_LOCO_FUNCTIONS)
+                {
+                    status = UDP_STATUS_INVALID_INDEX;
+                }
+            }
+            break;
+        }
+
+        case UDP_CMD_SWITCH_SET:
+        {
+            if (plen != 3)
+            {
+                status = UDP_STATUS_INVALID_LENGTH;
+            }
+            else
+            {
+                idx = get16 (payload);
+
+                if (idx >= Switches::get_n_switches ())
+                {
+                    status = UDP_STATUS_INVALID_INDEX;
+                }
+                else if (payload[2] != DCC_SWITCH_STATE_BRANCH && payload[2] != DCC_SWITCH_STATE_STRAIGHT &&
+                         (payload[2] != DCC_SWITCH_STATE_BRANCH2 || ! (Switches::switches[idx].get_flags () & SWITCH_FLAG_3WAY)))
+                {
+                    status = UDP_STATUS_INVALID_VALUE;
+                }
+            }
+            break;
+        }
+
+        default:
+        {
+            status = UDP_STATUS_UNKNOWN_COMMAND;
+            break;
+        }
+    }
+
+    if (status == UDP_STATUS_OK)
+    {
+        switch (cmd)
+        {
+            case UDP_CMD_LOCO_SET_SPEED:                            // speed and direction in one DCC command
+            {
+                Locos::locos[idx].set_speed_fwd (payload[2] & 0x7F, payload[3] ? 1 : 0);
+                FM22::state_changed ();
+                break;
+            }
+
+            case UDP_CMD_LOCO_SET_FUNCTION:
+            {
+                Locos::locos[idx].set_function (payload[2], payload[3] ? true : false);
+                FM22::state_changed ();
+                break;
+            }
+
+            case UDP_CMD_LOCO_GET:
+            {
+                return udp_loco_state (reply, seq, idx);
+            }
+
+            case UDP_CMD_LOCO_SUBSCRIBE:
+            {
+                uint_fast8_t    sidx;
+
+                for (sidx = 0; sidx < cp->n_locos; sidx++)
+                {
+                    if (cp->loco_idx[sidx] == idx)
+                    {
+                        break;
+                    }
+                }
+
+                if (sidx == cp->n_locos)
+                {
+                    if (cp->n_locos == UDP_MAX_LOCO_SUBSCRIPTIONS)
+                    {
+                        status = UDP_STATUS_NO_RESOURCES;
+                        break;
+                    }
+
+                    cp->n_locos++;
+                }
+
+                cp->loco_idx[sidx]          = idx;
+                cp->loco_speed[sidx]        = Locos::locos[idx].get_speed ();
+                cp->loco_fwd[sidx]          = Locos::locos[idx].get_fwd ();
+                cp->loco_functions[sidx]    = Locos::locos[idx].get_functions ();
+                return udp_loco_state (reply, seq, idx);
+            }
+
+            case UDP_CMD_LOCO_UNSUBSCRIBE:
+            {
+                uint_fast8_t    sidx;
+
+                for (sidx = 0; sidx < cp->n_locos; sidx++)
+                {
+                    if (cp->loco_idx[sidx] == idx)
+                    {
+                        cp->n_locos--;
+                        cp->loco_idx[sidx]          = cp->loco_idx[cp->n_locos];
+                        cp->loco_speed[sidx]        = cp->loco_speed[cp->n_locos];
+                        cp->loco_fwd[sidx]          = cp->loco_fwd[cp->n_locos];
+                        cp->loco_functions[sidx]    = cp->loco_functions[cp->n_locos];
+                        break;
+                    }
+                }
+                break;
+            }
+
+            case UDP_CMD_SWITCH_SET:
+            {
+                Switches::switches[idx].set_state (payload[2]);
+                FM22::state_changed ();
+                break;
+            }
+
+            case UDP_CMD_POWER_SET:
+            {
+                if (payload[0])
+                {
+                    UserIO::booster_on (true);
+                }
+                else
+                {
+                    UserIO::booster_off (true);
+                }
+                FM22::state_changed ();
+                break;
+            }
+
+            case UDP_CMD_POWER_GET:
+            {
+                len = udp_header (reply, UDP_MSG_POWER_STATE, seq);
+                reply[len++] = DCC::booster_is_on ? 1 : 0;
+                return len;
+            }
+
+            case UDP_CMD_FEEDBACK_SUBSCRIBE:
+            {
+                udp_notify ();                                      // update last sent state, other clients must not miss a change
+                cp->feedback_mask = payload[0];
+
+                if (cp->feedback_mask)                              // send current state as start point
+                {
+                    if (cp->feedback_mask & UDP_FEEDBACK_S88)
+                    {
+                        udp_send_s88 (cp);
+                    }
+
+                    if (cp->feedback_mask & UDP_FEEDBACK_RCL)
+                    {
+                        udp_send_rcl (cp, (std::vector<uint8_t> *) NULL);
+                    }
+
+                    if (cp->feedback_mask & UDP_FEEDBACK_POWER)
+                    {
+                        udp_send_power (cp);
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    len = udp_header (reply, UDP_MSG_ACK, seq);
+    reply[len++] = status;
+    return len;
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp_packet () - handle received packet
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+static void
+udp_packet (const uint8_t * buf, int len, const struct sockaddr_in * addr)
+{
+    UDP_CLIENT *    cp;
+    uint8_t         reply[UDP_MAX_REPLY_SIZE];
+    uint_fast8_t    cmd;
+    uint_fast16_t   seq;
+    bool            is_new;
+    int             reply_len;
+
+    if (len < UDP_HEADER_SIZE)
+    {
+        return;                                                     // can't even answer
+    }
+
+    cmd = buf[1];
+    seq = get16 (buf + 2);
+
+    if (buf[0] != UDP_PROTOCOL_VERSION)
+    {
+        reply_len = udp_header (reply, UDP_MSG_ACK, seq);
+        reply[reply_len++] = UDP_STATUS_INVALID_VERSION;
+        udp_send (addr, reply, reply_len);
+        return;
+    }
+
+    cp = udp_find_client (addr, &is_new);
+
+    if (! cp)
+    {
+        reply_len = udp_header (reply, UDP_MSG_ACK, seq);
+        reply[reply_len++] = UDP_STATUS_NO_RESOURCES;
+        udp_send (addr, reply, reply_len);
+        return;
+    }
+
+    cp->last_millis = Millis::elapsed ();
+
+    if (! is_new)
+    {
+        int16_t diff = (int16_t) (seq - cp->last_seq);
+
+        if (diff == 0)                                              // retransmission, don't execute twice
+        {
+            udp_send (addr, cp->reply, cp->reply_len);
+            return;
+        }
+        else if (diff < 0)                                          // delayed command, newer one already executed
+        {
+            reply_len = udp_header (reply, UDP_MSG_ACK, seq);
+            reply[reply_len++] = UDP_STATUS_STALE;
+            udp_send (addr, reply, reply_len);
+            return;
+        }
+    }
+
+    cp->last_seq    = seq;
+    reply_len       = udp_command (cp, cmd, seq, buf + UDP_HEADER_SIZE, len - UDP_HEADER_SIZE, reply);
+
+    memcpy (cp->reply, reply, reply_len);
+    cp->reply_len = reply_len;
+    udp_send (addr, reply, reply_len);
+
+    if (cmd == UDP_CMD_LOGOUT)
+    {
+        udp_remove_client (cp);
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * init () - open UDP socket
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+UDP::init (void)
+{
+    struct sockaddr_in  addr;
+
+    udp_fd = socket (AF_INET, SOCK_DGRAM, 0);
+
+    if (udp_fd < 0)
+    {
+        perror ("UDP: socket");
+        return;
+    }
+
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_ANY);
+    addr.sin_port        = htons (UDP_PORT);
+
+    if (bind (udp_fd, (struct sockaddr *) &addr, sizeof (addr)) < 0)
+    {
+        perror ("UDP: bind");
+        close (udp_fd);
+        udp_fd = -1;
+        return;
+    }
+
+    fcntl (udp_fd, F_SETFL, fcntl (udp_fd, F_GETFL) | O_NONBLOCK);
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * deinit () - close UDP socket
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+UDP::deinit (void)
+{
+    if (udp_fd >= 0)
+    {
+        close (udp_fd);
+        udp_fd = -1;
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * set_new_loco_ids () - correct loco indexes of subscriptions, drop subscriptions of removed locos
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+UDP::set_new_loco_ids (uint16_t * map_new_loco_idx, uint_fast16_t n_locos)
+{
+    uint_fast8_t    cidx;
+
+    for (cidx = 0; cidx < UDP_MAX_CLIENTS; cidx++)
+    {
+        UDP_CLIENT *    cp      = clients + cidx;
+        uint_fast8_t    sidx    = 0;
+
+        while (cp->valid && sidx < cp->n_locos)
+        {
+            uint_fast16_t   loco_idx = cp->loco_idx[sidx];
+
+            if (loco_idx < n_locos && map_new_loco_idx[loco_idx] != 0xFFFF)
+            {
+                cp->loco_idx[sidx] = map_new_loco_idx[loco_idx];
+                sidx++;
+            }
+            else
+            {
+                cp->n_locos--;
+                cp->loco_idx[sidx]          = cp->loco_idx[cp->n_locos];
+                cp->loco_speed[sidx]        = cp->loco_speed[cp->n_locos];
+                cp->loco_fwd[sidx]          = cp->loco_fwd[cp->n_locos];
+                cp->loco_functions[sidx]    = cp->loco_functions[cp->n_locos];
+            }
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------------------------------------------------
+ * server () - handle received commands, send changes to subscribed clients. Never blocks.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+void
+UDP::server (void)
+{
+    uint8_t             buf[UDP_MAX_PACKET_SIZE];
+    struct sockaddr_in  addr;
+    socklen_t           addr_len;
+    uint_fast8_t        n_packets;
+    int                 len;
+
+    if (udp_fd < 0)
+    {
+        return;
+    }
+
+    for (n_packets = 0; n_packets < UDP_MAX_PACKETS_PER_CALL; n_packets++)
+    {
+        addr_len = sizeof (addr);
+        len = recvfrom (udp_fd, buf, sizeof (buf), 0, (struct sockaddr *) &addr, &addr_len);
+
+        if (len < 0)
+        {
+            break;                                                  // no more packets
+        }
+
+        udp_packet (buf, len, &addr);
+    }
+
+    if (n_clients > 0)
+    {
+        udp_expire_clients ();
+
+        if (last_state_version != FM22::state_version)             // check for changes only if something happened
+        {
+            last_state_version = FM22::state_version;
+            udp_notify ();
+        }
+    }
+}
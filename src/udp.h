@@ -0,0 +1,115 @@
+/*------------------------------------------------------------------------------------------------------------------------
+ * udp.h - binary UDP control protocol for throttles and apps
+ *------------------------------------------------------------------------------------------------------------------------
+ * Copyright (c) 2022-2024 Frank Meyer - frank(at)uclock.de
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *------------------------------------------------------------------------------------------------------------------------
+ *
+ * Packet format, all 16/32 bit values in network byte order (big endian):
+ *
+ *   byte 0     version     UDP_PROTOCOL_VERSION
+ *   byte 1     command     UDP_CMD_xxx or UDP_MSG_xxx
+ *   byte 2-3   sequence    command: incremented by client with each command, answer: sequence number of command,
+ *                          subscription message: incremented by server with each message to the client
+ *   byte 4-    payload
+ *
+ * Every command is answered with UDP_MSG_ACK (payload: status) or a state message. All commands set absolute values,
+ * so a repeated command does no harm. A command with the same sequence number as the last one of the client is a
+ * retransmission: it is answered, but not executed again. A command with an older sequence number is dropped with
+ * UDP_STATUS_STALE, so a delayed speed command can't overwrite a newer one.
+ *
+ * A client is registered with its first command. It must send a command, e.g. UDP_CMD_PING, at least every
+ * UDP_CLIENT_TIMEOUT msec, otherwise it is removed with all its subscriptions.
+ *
+ *   command                    payload                                 answer
+ *   UDP_CMD_PING               -                                       ACK
+ *   UDP_CMD_LOCO_SET_SPEED     loco_idx(2) speed(1) fwd(1)             ACK
+ *   UDP_CMD_LOCO_SET_FUNCTION  loco_idx(2) f(1) value(1)               ACK
+ *   UDP_CMD_LOCO_GET           loco_idx(2)                             LOCO_STATE
+ *   UDP_CMD_LOCO_SUBSCRIBE     loco_idx(2)                             LOCO_STATE, later LOCO_STATE on each change
+ *   UDP_CMD_LOCO_UNSUBSCRIBE   loco_idx(2)                             ACK
+ *   UDP_CMD_SWITCH_SET         sw_idx(2) state(1): DCC_SWITCH_STATE_xxx ACK, BRANCH2 only for 3-way switches
+ *   UDP_CMD_POWER_SET          on(1)                                   ACK
+ *   UDP_CMD_POWER_GET          -                                       POWER_STATE
+ *   UDP_CMD_FEEDBACK_SUBSCRIBE mask(1): UDP_FEEDBACK_xxx               ACK, later S88_STATE, RCL_STATE, POWER_STATE
+ *   UDP_CMD_LOGOUT             -                                       ACK, client is removed
+ *
+ *   message                    payload
+ *   UDP_MSG_ACK                status(1)
+ *   UDP_MSG_LOCO_STATE         loco_idx(2) speed(1) fwd(1) functions(4)
+ *   UDP_MSG_POWER_STATE        on(1)
+ *   UDP_MSG_S88_STATE          n_bytes(2) state bytes(n_bytes)
+ *   UDP_MSG_RCL_STATE          n(2) n times: loco_idx(2) rcl_location(1), only changed locations
+ *
+ * Messages sent because of a subscription carry the next server sequence number of the client, so the client can
+ * detect lost messages and request the current state with UDP_CMD_LOCO_GET or UDP_CMD_POWER_GET.
+ *------------------------------------------------------------------------------------------------------------------------
+ */
+#ifndef UDP_H
+#define UDP_H
+
+#include <stdint.h>
+
+#define UDP_PORT                        9999
+#define UDP_PROTOCOL_VERSION            1
+#define UDP_HEADER_SIZE                 4
+#define UDP_MAX_PACKET_SIZE             1472                        // fits into one ethernet frame
+
+#define UDP_MAX_CLIENTS                 16
+#define UDP_MAX_LOCO_SUBSCRIPTIONS      8                           // per client
+#define UDP_CLIENT_TIMEOUT              60000                       // remove client after 60 sec of silence
+#define UDP_MAX_PACKETS_PER_CALL        16                          // max. received packets per call of UDP::server()
+
+#define UDP_CMD_PING                    0x01
+#define UDP_CMD_LOCO_SET_SPEED          0x10
+#define UDP_CMD_LOCO_SET_FUNCTION       0x11
+#define UDP_CMD_LOCO_GET                0x12
+#define UDP_CMD_LOCO_SUBSCRIBE          0x13
+#define UDP_CMD_LOCO_UNSUBSCRIBE        0x14
+#define UDP_CMD_SWITCH_SET              0x20
+#define UDP_CMD_POWER_SET               0x30
+#define UDP_CMD_POWER_GET               0x31
+#define UDP_CMD_FEEDBACK_SUBSCRIBE      0x40
+#define UDP_CMD_LOGOUT                  0x41
+
+#define UDP_MSG_ACK                     0x80
+#define UDP_MSG_LOCO_STATE              0x81
+#define UDP_MSG_POWER_STATE             0x82
+#define UDP_MSG_S88_STATE               0x83
+#define UDP_MSG_RCL_STATE               0x84
+
+#define UDP_STATUS_OK                   0x00
+#define UDP_STATUS_UNKNOWN_COMMAND      0x01
+#define UDP_STATUS_INVALID_LENGTH       0x02
+#define UDP_STATUS_INVALID_INDEX        0x03
+#define UDP_STATUS_STALE                0x04                        // sequence number older than last one
+#define UDP_STATUS_NO_RESOURCES         0x05                        // too many clients or subscriptions
+#define UDP_STATUS_INVALID_VERSION      0x06
+#define UDP_STATUS_INVALID_VALUE        0x07                        // e.g. switch state out of range
+
+#define UDP_FEEDBACK_S88                0x01
+#define UDP_FEEDBACK_RCL                0x02
+#define UDP_FEEDBACK_POWER              0x04
+
+class UDP
+{
+    public:
+        static void             init (void);
+        static void             deinit (void);
+        static void             server (void);
+        static void             set_new_loco_ids (uint16_t * map_new_loco_idx, uint_fast16_t n_locos);
+};
+
+#endif